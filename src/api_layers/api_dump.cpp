@@ -20,7 +20,11 @@
 // Author: Dave Houlton <daveh@lunarg.com>
 //
 
+#include "api_dump_format.h"
 #include "hex_and_handles.h"
+#include "layer_config_message.h"
+#include "layer_record_file.h"
+#include "platform_trace.hpp"
 #include "platform_utils.hpp"
 #include "xr_generated_api_dump.hpp"
 #include "xr_generated_dispatch_table.h"
@@ -29,14 +33,23 @@
 #include <openxr/openxr_loader_negotiation.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
@@ -56,12 +69,16 @@
 #define LAYER_EXPORT
 #endif
 
+XR_TRACE_DEFINE_PROVIDER();
+
 enum ApiDumpRecordType {
     RECORD_NONE = 0,
     RECORD_TEXT_COUT,
     RECORD_TEXT_FILE,
     RECORD_HTML_FILE,
     RECORD_CODE_FILE,
+    RECORD_BINARY_FILE,
+    RECORD_SUMMARY,
 };
 
 struct ApiDumpRecordInfo {
@@ -72,6 +89,224 @@ struct ApiDumpRecordInfo {
 
 static ApiDumpRecordInfo g_record_info = {};
 static std::mutex g_record_mutex = {};
+static LayerRecordFile g_record_file;
+static ApiDumpBinaryWriter g_binary_writer;
+
+// One call, as recorded by the thread that made it, or in a binary capture the outputs of the thread's last call.
+struct ApiDumpRecord {
+    ApiDumpCallStamp stamp;
+    ApiDumpContents contents;
+    bool outputs = false;
+};
+
+// Flight recorder mode: with XR_API_DUMP_RING_SIZE set, calls are kept in memory, and only the last ring size of them
+// are written out, when a command fails, when the flight recorder is signaled, or when the application submits a debug
+// utils message whose messageId is XR_API_DUMP_RING_TRIGGER.  Guarded by g_record_mutex.
+class ApiDumpFlightRecorder {
+   public:
+    void SetCapacity(size_t capacity) {
+        slots_.clear();
+        slots_.resize(capacity);
+        next_ = 0;
+        size_ = 0;
+    }
+
+    bool Enabled() const { return !slots_.empty(); }
+
+    void Push(ApiDumpRecord &&record) {
+        slots_[next_] = std::move(record);
+        next_ = (next_ + 1) % slots_.size();
+        size_ = std::min(size_ + 1, slots_.size());
+    }
+
+    // Hands the recorded calls, oldest first, to write, and empties the ring.
+    template <typename Write>
+    void Drain(Write &&write) {
+        size_t slot = (next_ + slots_.size() - size_) % slots_.size();
+        for (; size_ > 0; --size_) {
+            write(slots_[slot]);
+            slots_[slot].contents.clear();
+            slot = (slot + 1) % slots_.size();
+        }
+    }
+
+    std::string trigger_message_id;
+
+   private:
+    std::vector<ApiDumpRecord> slots_;
+    size_t next_ = 0;
+    size_t size_ = 0;
+};
+
+static ApiDumpFlightRecorder g_flight_recorder;
+
+// Summary mode: with XR_API_DUMP_EXPORT_TYPE=summary, calls are counted instead of written, and a table of the counts
+// is written every XR_API_DUMP_SUMMARY_INTERVAL frames and when an instance is destroyed.  Besides calls per frame, the
+// table counts calls made with the same parameters as the previous call of their command, and the capacity queries
+// of two-call enumerations: made every frame, both are usually redundant.  Guarded by g_record_mutex.
+class ApiDumpSummary {
+   public:
+    // Frames, counted by xrEndFrame calls, between summaries; 0 for a summary only when an instance is destroyed.
+    uint32_t interval = 0;
+
+    // Count a call.  Returns true if a summary is due.
+    bool Record(const ApiDumpContents &contents) {
+        if (contents.empty()) {
+            return false;
+        }
+        const std::string &command = std::get<1>(contents[0]);
+        CommandCounts &counts = commands_[command];
+        if (0 == counts.calls && !counts.has_previous) {
+            counts.samples_state = SamplesState(command);
+        }
+        ++counts.calls;
+        const size_t parameters_hash = HashParameters(contents);
+        if (!counts.samples_state && counts.has_previous && counts.previous_parameters_hash == parameters_hash) {
+            ++counts.repeated;
+        }
+        counts.previous_parameters_hash = parameters_hash;
+        counts.has_previous = true;
+        if (IsCapacityQuery(contents)) {
+            ++counts.capacity_queries;
+        }
+        if (command == "xrEndFrame") {
+            ++frames_;
+            return interval != 0 && frames_ >= interval;
+        }
+        return false;
+    }
+
+    // Write the counts since the last summary, the most called commands first, and start counting again.
+    void Write(std::ostream &out, const std::string &reason) {
+        if (std::none_of(commands_.begin(), commands_.end(),
+                         [](const std::pair<const std::string, CommandCounts> &command) { return command.second.calls > 0; })) {
+            return;
+        }
+        std::vector<std::pair<std::string, CommandCounts>> sorted(commands_.begin(), commands_.end());
+        std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, CommandCounts> &a,
+                                                   const std::pair<std::string, CommandCounts> &b) {
+            return a.second.calls != b.second.calls ? a.second.calls > b.second.calls : a.first < b.first;
+        });
+        out << "api_dump summary at " << reason;
+        if (frames_ > 0) {
+            out << ", frames " << first_frame_ + 1 << "-" << first_frame_ + frames_;
+        }
+        out << "\n";
+        out << std::left << std::setw(48) << "command" << std::right << std::setw(10) << "calls" << std::setw(12)
+            << "per frame" << std::setw(12) << "repeated" << std::setw(18) << "capacity queries"
+            << "\n";
+        for (const auto &command : sorted) {
+            if (0 == command.second.calls) {
+                continue;
+            }
+            out << std::left << std::setw(48) << command.first << std::right << std::setw(10) << command.second.calls;
+            if (frames_ > 0) {
+                out << std::setw(12) << std::fixed << std::setprecision(2)
+                    << static_cast<double>(command.second.calls) / static_cast<double>(frames_);
+            } else {
+                out << std::setw(12) << "-";
+            }
+            if (command.second.samples_state) {
+                out << std::setw(12) << "-";
+            } else {
+                out << std::setw(12) << command.second.repeated;
+            }
+            out << std::setw(18) << command.second.capacity_queries << "\n";
+        }
+        first_frame_ += frames_;
+        frames_ = 0;
+        // Keep each command's previous parameters, so a call repeated across the boundary still counts.
+        for (auto &command : commands_) {
+            command.second.calls = 0;
+            command.second.repeated = 0;
+            command.second.capacity_queries = 0;
+        }
+    }
+
+   private:
+    struct CommandCounts {
+        uint64_t calls = 0;
+        uint64_t repeated = 0;
+        uint64_t capacity_queries = 0;
+        size_t previous_parameters_hash = 0;
+        bool has_previous = false;
+        bool samples_state = false;
+    };
+
+    // Commands that are meant to be called with the same parameters every frame, so repeats are not counted.
+    static bool SamplesState(const std::string &command) {
+        static const char *const prefixes[] = {
+            "xrWaitFrame",   "xrBeginFrame",     "xrEndFrame", "xrPollEvent",          "xrAcquireSwapchainImage",
+            "xrSyncActions", "xrGetActionState", "xrLocate",   "xrWaitSwapchainImage", "xrReleaseSwapchainImage"};
+        for (const char *prefix : prefixes) {
+            if (command.compare(0, strlen(prefix), prefix) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static size_t HashParameters(const ApiDumpContents &contents) {
+        std::hash<std::string> hash_string;
+        size_t hash = 0;
+        for (size_t index = 1; index < contents.size(); ++index) {
+            hash ^= hash_string(std::get<1>(contents[index])) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            hash ^= hash_string(std::get<2>(contents[index])) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+
+    // The first call of the two-call idiom, which passes a capacity of 0 to get the count.
+    static bool IsCapacityQuery(const ApiDumpContents &contents) {
+        static const std::string suffix = "CapacityInput";
+        for (const auto &content : contents) {
+            const std::string &name = std::get<1>(content);
+            const std::string &value = std::get<2>(content);
+            if (name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                return value == "0x0" || value == "0";
+            }
+        }
+        return false;
+    }
+
+    std::unordered_map<std::string, CommandCounts> commands_;
+    uint64_t frames_ = 0;
+    uint64_t first_frame_ = 0;
+};
+
+static ApiDumpSummary g_summary;
+
+// SIGUSR1 only sets a flag: writing out is not async-signal-safe, so it happens on the next call the layer sees.
+static std::atomic<bool> g_flight_recorder_signaled{false};
+
+#if !defined(_WIN32)
+class ApiDumpFlightRecorderSignal {
+   public:
+    ~ApiDumpFlightRecorderSignal() {
+        // The handler lives in the layer library, so it has to be removed before the library is unloaded.
+        if (installed_) {
+            sigaction(SIGUSR1, &previous_, nullptr);
+        }
+    }
+
+    void Install() {
+        if (installed_) {
+            return;
+        }
+        installed_ = true;
+        struct sigaction action = {};
+        action.sa_handler = [](int) { g_flight_recorder_signaled.store(true); };
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGUSR1, &action, &previous_);
+    }
+
+   private:
+    bool installed_ = false;
+    struct sigaction previous_ = {};
+};
+
+static ApiDumpFlightRecorderSignal g_flight_recorder_signal;
+#endif
 
 // For routing platform_utils.hpp messages.
 void LogPlatformUtilsError(const std::string &message) {
@@ -91,106 +326,7 @@ void LogPlatformUtilsError(const std::string &message) {
 bool ApiDumpLayerWriteHtmlHeader() {
     try {
         std::unique_lock<std::mutex> mlock(g_record_mutex);
-        std::ofstream html_file;
-        html_file.open(g_record_info.file_name, std::ios::out);
-        html_file << "<!doctype html>\n"
-                     "<html>\n"
-                     "    <head>\n"
-                     "        <title>OpenXR API Dump</title>\n"
-                     "        <style type='text/css'>\n"
-                     "        html {\n"
-                     "            background-color: #0b1e48;\n"
-                     "            background-image: url('https://vulkan.lunarg.com/img/bg-starfield.jpg');\n"
-                     "            background-position: center;\n"
-                     "            -webkit-background-size: cover;\n"
-                     "            -moz-background-size: cover;\n"
-                     "            -o-background-size: cover;\n"
-                     "            background-size: cover;\n"
-                     "            background-attachment: fixed;\n"
-                     "            background-repeat: no-repeat;\n"
-                     "            height: 100%;\n"
-                     "        }\n"
-                     "        #header {\n"
-                     "            z-index: -1;\n"
-                     "        }\n"
-                     "        #header>img {\n"
-                     "            position: absolute;\n"
-                     "            width: 160px;\n"
-                     "            margin-left: -280px;\n"
-                     "            top: -10px;\n"
-                     "            left: 50%;\n"
-                     "        }\n"
-                     "        #header>h1 {\n"
-                     "            font-family: Arial, 'Helvetica Neue', Helvetica, sans-serif;\n"
-                     "            font-size: 44px;\n"
-                     "            font-weight: 200;\n"
-                     "            text-shadow: 4px 4px 5px #000;\n"
-                     "            color: #eee;\n"
-                     "            position: absolute;\n"
-                     "            width: 400px;\n"
-                     "            margin-left: -80px;\n"
-                     "            top: 8px;\n"
-                     "            left: 50%;\n"
-                     "        }\n"
-                     "        body {\n"
-                     "            font-family: Consolas, monaco, monospace;\n"
-                     "            font-size: 14px;\n"
-                     "            line-height: 20px;\n"
-                     "            color: #eee;\n"
-                     "            height: 100%;\n"
-                     "            margin: 0;\n"
-                     "            overflow: hidden;\n"
-                     "        }\n"
-                     "        #wrapper {\n"
-                     "            background-color: rgba(0, 0, 0, 0.7);\n"
-                     "            border: 1px solid #446;\n"
-                     "            box-shadow: 0px 0px 10px #000;\n"
-                     "            padding: 8px 12px;\n"
-                     "            display: inline-block;\n"
-                     "            position: absolute;\n"
-                     "            top: 80px;\n"
-                     "            bottom: 25px;\n"
-                     "            left: 50px;\n"
-                     "            right: 50px;\n"
-                     "            overflow: auto;\n"
-                     "        }\n"
-                     "        details>*:not(summary) {\n"
-                     "            margin-left: 22px;\n"
-                     "        }\n"
-                     "        summary:only-child {\n"
-                     "            display: block;\n"
-                     "            padding-left: 15px;\n"
-                     "        }\n"
-                     "        details>summary:only-child::-webkit-details-marker {\n"
-                     "            display: none;\n"
-                     "            padding-left: 15px;\n"
-                     "        }\n"
-                     "        .headervar, .headertype, .headerval {\n"
-                     "            display: inline;\n"
-                     "            margin: 0 9px;\n"
-                     "        }\n"
-                     "        .var, .type, .val {\n"
-                     "            display: inline;\n"
-                     "            margin: 0 6px;\n"
-                     "        }\n"
-                     "        .headertype, .type {\n"
-                     "            color: #acf;\n"
-                     "        }\n"
-                     "        .headerval, .val {\n"
-                     "            color: #afa;\n"
-                     "            text-align: right;\n"
-                     "        }\n"
-                     "        .thd {\n"
-                     "            color: #888;\n"
-                     "        }\n"
-                     "        </style>\n"
-                     "    </head>\n"
-                     "    <body>\n"
-                     "        <div id='header'>\n"
-                     "            <img src='https://lunarg.com/wp-content/uploads/2016/02/LunarG-wReg-150.png' />\n"
-                     "            <h1>OpenXR API Dump</h1>\n"
-                     "        </div>\n"
-                     "        <div id='wrapper'>\n";
+        ApiDumpFormatHtmlHeader(g_record_file.Truncate(g_record_info.file_name));
         return true;
     } catch (...) {
         return false;
@@ -200,11 +336,8 @@ bool ApiDumpLayerWriteHtmlHeader() {
 bool ApiDumpLayerWriteHtmlFooter() {
     try {
         std::unique_lock<std::mutex> mlock(g_record_mutex);
-        std::ofstream html_file;
-        html_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
-        html_file << "        </div>\n"
-                     "    </body>\n"
-                     "</html>";
+        ApiDumpFormatHtmlFooter(g_record_file.Stream(g_record_info.file_name));
+        g_record_file.Close();
 
         // Writing the footer means we're done.
         if (g_record_info.initialized) {
@@ -218,218 +351,503 @@ bool ApiDumpLayerWriteHtmlFooter() {
     }
 }
 
-// Api Dump Utility function to return an instance based on the generated dispatch table
-// pointer.
-XrInstance FindInstanceFromDispatchTable(XrGeneratedDispatchTable *dispatch_table) {
-    std::unique_lock<std::mutex> mlock(g_instance_dispatch_mutex);
-    XrInstance instance = XR_NULL_HANDLE;
-    for (auto it = g_instance_dispatch_map.begin(); it != g_instance_dispatch_map.end();) {
-        if (it->second == dispatch_table) {
-            instance = it->first;
+// Binary capture utilities
+bool ApiDumpLayerWriteBinaryHeader() {
+    try {
+        std::unique_lock<std::mutex> mlock(g_record_mutex);
+        g_binary_writer.WriteHeader(g_record_file.Truncate(g_record_info.file_name));
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+// Command filter utilities
+//
+// XR_API_DUMP_INCLUDE and XR_API_DUMP_EXCLUDE hold comma-separated glob patterns, like "xrLocate*,xrGetActionState*",
+// where '*' matches any run of characters and '?' any one character.  A command is dumped if it matches an include
+// pattern (or there are none) and no exclude pattern.
+struct ApiDumpCommandFilter {
+    std::vector<std::string> include;
+    std::vector<std::string> exclude;
+};
+
+static std::vector<std::string> ApiDumpSplitPatterns(const std::string &patterns) {
+    std::vector<std::string> split;
+    std::istringstream stream(patterns);
+    std::string pattern;
+    while (std::getline(stream, pattern, ',')) {
+        pattern.erase(0, pattern.find_first_not_of(" \t"));
+        pattern.erase(pattern.find_last_not_of(" \t") + 1);
+        if (!pattern.empty()) {
+            split.push_back(pattern);
+        }
+    }
+    return split;
+}
+
+static bool ApiDumpGlobMatch(const char *pattern, const char *name) {
+    // Iterative matcher: on a mismatch, let the most recent '*' absorb one more character and retry.
+    const char *star = nullptr;
+    const char *star_name = nullptr;
+    while (*name != '\0') {
+        if (*pattern == '*') {
+            star = pattern++;
+            star_name = name;
+        } else if (*pattern == '?' || *pattern == *name) {
+            ++pattern;
+            ++name;
+        } else if (star != nullptr) {
+            pattern = star + 1;
+            name = ++star_name;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') {
+        ++pattern;
+    }
+    return *pattern == '\0';
+}
+
+static const ApiDumpCommandFilter &ApiDumpGetCommandFilter() {
+    static const ApiDumpCommandFilter filter = [] {
+        ApiDumpCommandFilter loaded;
+#if !defined(ANDROID)
+        loaded.include = ApiDumpSplitPatterns(PlatformUtilsGetEnv("XR_API_DUMP_INCLUDE"));
+        loaded.exclude = ApiDumpSplitPatterns(PlatformUtilsGetEnv("XR_API_DUMP_EXCLUDE"));
+#else
+        loaded.include = ApiDumpSplitPatterns(PlatformUtilsGetAndroidSystemProperty("debug.api_dump_include"));
+        loaded.exclude = ApiDumpSplitPatterns(PlatformUtilsGetAndroidSystemProperty("debug.api_dump_exclude"));
+#endif
+        return loaded;
+    }();
+    return filter;
+}
+
+static bool ApiDumpCommandFiltered(const ApiDumpCommandFilter &filter, const char *name) {
+    if (filter.include.empty() && filter.exclude.empty()) {
+        return false;
+    }
+    bool included = filter.include.empty();
+    for (const auto &pattern : filter.include) {
+        if (ApiDumpGlobMatch(pattern.c_str(), name)) {
+            included = true;
             break;
         }
     }
-    return instance;
+    if (!included) {
+        return true;
+    }
+    for (const auto &pattern : filter.exclude) {
+        if (ApiDumpGlobMatch(pattern.c_str(), name)) {
+            return true;
+        }
+    }
+    return false;
 }
 
-// Function to record all the API dump information
-bool ApiDumpLayerRecordContent(std::vector<std::tuple<std::string, std::string, std::string>> contents) {
+static bool ApiDumpCommandFiltered(const char *name) { return ApiDumpCommandFiltered(ApiDumpGetCommandFilter(), name); }
+
+// Runtime configuration: a debug utils message whose messageId is "api_dump_config" changes what is dumped.  Its
+// settings (see layer_config_message.h) are "enabled=0" or "enabled=1", to pause and resume the output, and "include"
+// and "exclude", to replace the patterns of the output filter.  The layer does not intercept commands filtered out when
+// the instance was created, so only commands that passed that filter can be included again.  Guarded by g_record_mutex.
+struct ApiDumpRuntimeConfig {
+    bool paused = false;
+    ApiDumpCommandFilter filter = ApiDumpGetCommandFilter();
+};
+
+static ApiDumpRuntimeConfig &ApiDumpGetRuntimeConfig() {
+    static ApiDumpRuntimeConfig config;
+    return config;
+}
+
+// Commands the layer has to intercept even when filtered, because they keep its handle to dispatch table maps up to
+// date.  Only their output is dropped.
+static bool ApiDumpCommandTracksHandles(const std::string &name) {
+    return name == "xrGetInstanceProcAddr" || name.find("Create") != std::string::npos ||
+           name.find("Destroy") != std::string::npos || name.find("Connect") != std::string::npos;
+}
+
+// Api Dump Utility function to return an instance based on the generated dispatch table
+// pointer.
+XrInstance FindInstanceFromDispatchTable(XrGeneratedDispatchTable *dispatch_table) {
+    return g_instance_dispatch_map.FindHandle(dispatch_table);
+}
+
+// Write one call in the current record type, with its stamp if it has one.  Call with g_record_mutex held.
+static bool ApiDumpLayerWriteContents(const ApiDumpContents &contents, const ApiDumpCallStamp *stamp = nullptr) {
     bool success = false;
-    if (g_record_info.initialized) {
-        std::unique_lock<std::mutex> mlock(g_record_mutex);
-        uint32_t count = 0;
-        switch (g_record_info.type) {
-            case RECORD_TEXT_COUT: {
+    uint32_t count = 0;
+    switch (g_record_info.type) {
+        case RECORD_TEXT_COUT: {
 #if defined(ANDROID)
 #define ALOGI(...)       \
-    printf(__VA_ARGS__); \
-    __android_log_print(ANDROID_LOG_INFO, "api_dump", __VA_ARGS__)
+printf(__VA_ARGS__); \
+__android_log_print(ANDROID_LOG_INFO, "api_dump", __VA_ARGS__)
 #else
 #define ALOGI(...) printf(__VA_ARGS__)
 #endif
-                for (const auto &content : contents) {
-                    std::string content_type;
-                    std::string content_name;
-                    std::string content_value;
-                    std::tie(content_type, content_name, content_value) = content;
-
-                    const char *indent = (count++ != 0) ? "    " : "";
-
-                    if (!content_value.empty()) {
-                        ALOGI("%s%s %s = %s", indent, content_type.c_str(), content_name.c_str(), content_value.c_str());
-                    } else {
-                        ALOGI("%s%s %s", indent, content_type.c_str(), content_name.c_str());
-                    }
-                }
-                success = true;
-                break;
-#undef ALOGI
-            }
-            case RECORD_TEXT_FILE: {
-                std::ofstream text_file;
-                text_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
-                for (const auto &content : contents) {
-                    std::string content_type;
-                    std::string content_name;
-                    std::string content_value;
-                    std::tie(content_type, content_name, content_value) = content;
-                    if (count++ != 0) {
-                        text_file << "    ";
-                    }
-                    if (!content_value.empty()) {
-                        text_file << content_type << " " << content_name << " = " << content_value << "\n";
-                    } else {
-                        text_file << content_type << " " << content_name << "\n";
-                    }
-                }
-                text_file.close();
-                success = true;
-                break;
-            }
-            case RECORD_HTML_FILE: {
-                std::ofstream text_file;
-                text_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
-                text_file << "<details class='data'>\n";
-                std::vector<std::string> prefixes;
-                uint32_t last_deref_count = 0;
-                for (uint32_t content_index = 0; content_index < contents.size(); ++content_index) {
-                    std::string content_type;
-                    std::string content_name;
-                    std::string content_value;
-                    std::tie(content_type, content_name, content_value) = contents[content_index];
-                    if (content_index == 0) {
-                        text_file << "   <summary>\n"
-                                  << "      <div class='headertype'>" << content_type << "</div>\n"
-                                  << "      <div class='headervar'>" << content_name << "</div>\n"
-                                  << "   </summary>\n";
-                    } else {
-                        uint32_t cur_deref_count = 0;
-                        uint32_t next_deref_count = 0;
-
-                        // Count number of structure and pointer dereferences for the current line
-                        cur_deref_count = static_cast<uint32_t>(std::count(content_name.begin(), content_name.end(), '.'));
-                        std::string::size_type start = 0;
-                        while ((start = content_name.find("->", start)) != std::string::npos) {
-                            ++cur_deref_count;
-                            start += 2;
-                        }
-                        // Now look for array dereferences
-                        start = 0;
-                        while ((start = content_name.find('[', start)) != std::string::npos) {
-                            ++cur_deref_count;
-                            start++;
-                        }
-
-                        // If there's something after this, see if it's a sub-component of this.
-                        if (content_index < contents.size() - 1) {
-                            std::string next_content_type;
-                            std::string next_content_name;
-                            std::string next_content_value;
-                            std::tie(next_content_type, next_content_name, next_content_value) = contents[content_index + 1];
-
-                            // Count number of structure and pointer dereferences for the next line
-                            next_deref_count =
-                                static_cast<uint32_t>(std::count(next_content_name.begin(), next_content_name.end(), '.'));
-                            start = 0;
-                            while ((start = next_content_name.find("->", start)) != std::string::npos) {
-                                ++next_deref_count;
-                                start += 2;
-                            }
-                            // Now look for array dereferences
-                            start = 0;
-                            while ((start = next_content_name.find('[', start)) != std::string::npos) {
-                                ++next_deref_count;
-                                start++;
-                            }
-                        }
-
-                        // If we've reduced the number of dereferences in the name from last time, we need
-                        // to close up those detail sections.
-                        if (cur_deref_count < last_deref_count) {
-                            uint32_t diff_count = last_deref_count - cur_deref_count;
-                            while ((diff_count--) != 0u) {
-                                text_file << "   </details>\n";
-                                prefixes.pop_back();
-                            }
-                        }
-
-                        // Look through any prefixes we've saved (going backwards through the list)
-                        // and find the one that matches our beginning.
-                        std::string short_name = content_name;
-                        if (cur_deref_count > 0) {
-                            for (auto it = prefixes.rbegin(); it != prefixes.rend(); ++it) {
-                                if (content_name.find(*it) == 0) {
-                                    std::string::size_type additional_offset = it->size() + 1;
-                                    if (content_name[additional_offset - 1] == '-') {
-                                        additional_offset++;
-                                    } else if (content_name[additional_offset - 1] == '[') {
-                                        additional_offset--;
-                                    }
-                                    short_name = content_name.substr(additional_offset);
-                                    break;
-                                }
-                            }
-                        }
-
-                        bool writing_summary = false;
-
-                        // If the next item contains this item as a prefix, start the summary.  Otherwise,
-                        // start a <div> marker so that each component lands on its own line.
-                        if (cur_deref_count < next_deref_count) {
-                            text_file << "   <details class='data'>\n"
-                                      << "      <summary>\n";
-                            writing_summary = true;
-                            prefixes.push_back(content_name);
-                        } else {
-                            text_file << "      <div class='data'>\n";
-                        }
-
-                        // Write out the content
-                        text_file << "         <div class='type'>" << content_type << "</div>\n"
-                                  << "         <div class='var'>" << short_name << "</div>\n";
-                        bool value_needs_printing = true;
-                        if (content_type.find("char") != std::string::npos) {
-                            uint64_t star_count = std::count(content_type.begin(), content_type.end(), '*');
-                            uint64_t bracket_count = std::count(content_type.begin(), content_type.end(), '[');
-                            if (star_count + bracket_count < 2) {
-                                text_file << "         <div class='val'>\"" << content_value << "\"</div>";
-                                value_needs_printing = false;
-                            }
-                        }
-                        if (!content_value.empty() && value_needs_printing) {
-                            text_file << "         <div class='val'>" << content_value << "</div>";
-                        }
-                        text_file << "\n";
-
-                        // Wrap up any summary we may have started.  Otherwise, just wrap up the
-                        // <div> marker wrapping this entry.
-                        if (writing_summary) {
-                            text_file << "      </summary>\n";
-                        } else {
-                            text_file << "      </div>\n";
-                        }
-
-                        last_deref_count = cur_deref_count;
-                    }
-                }
+            for (const auto &content : contents) {
+                std::string content_type;
+                std::string content_name;
+                std::string content_value;
+                std::tie(content_type, content_name, content_value) = content;
 
-                // Wrap up any remaining items
-                if (last_deref_count != 0u) {
-                    while ((last_deref_count--) != 0u) {
-                        text_file << "   </details>\n";
-                        prefixes.pop_back();
-                    }
+                const char *indent = (count++ != 0) ? "    " : "";
+                const std::string stamp_suffix = (count == 1 && nullptr != stamp) ? " [" + ApiDumpFormatStamp(*stamp) + "]" : "";
+
+                if (!content_value.empty()) {
+                    ALOGI("%s%s %s = %s%s", indent, content_type.c_str(), content_name.c_str(), content_value.c_str(),
+                          stamp_suffix.c_str());
+                } else {
+                    ALOGI("%s%s %s%s", indent, content_type.c_str(), content_name.c_str(), stamp_suffix.c_str());
                 }
-                text_file << "</details>\n";
-                break;
             }
-            default:
-                break;
+            success = true;
+            break;
+#undef ALOGI
         }
+        case RECORD_TEXT_FILE: {
+            ApiDumpFormatText(g_record_file.Stream(g_record_info.file_name), contents, stamp);
+            g_record_file.RecordWritten();
+            success = true;
+            break;
+        }
+        case RECORD_HTML_FILE: {
+            ApiDumpFormatHtml(g_record_file.Stream(g_record_info.file_name), contents, stamp);
+            g_record_file.RecordWritten();
+            break;
+        }
+        case RECORD_BINARY_FILE: {
+            g_binary_writer.WriteCall(g_record_file.Stream(g_record_info.file_name), contents, stamp);
+            g_record_file.RecordWritten();
+            success = true;
+            break;
+        }
+        default:
+            break;
     }
     return success;
 }
 
+// Write one recorded call, or outputs, which are only recorded for binary captures.  Call with g_record_mutex held.
+static void ApiDumpLayerWriteRecord(const ApiDumpRecord &record) {
+    if (record.outputs) {
+        g_binary_writer.WriteOutputs(g_record_file.Stream(g_record_info.file_name), record.contents, record.stamp);
+        g_record_file.RecordWritten();
+        return;
+    }
+    ApiDumpLayerWriteContents(record.contents, &record.stamp);
+}
+
+// Write out the flight recorder's calls after a marker saying why.  Call with g_record_mutex held.
+static void ApiDumpLayerWriteFlightRecorder(const std::string &reason) {
+    ApiDumpLayerWriteContents({std::make_tuple("api_dump", "flight_recorder", reason)});
+    g_flight_recorder.Drain([](const ApiDumpRecord &record) { ApiDumpLayerWriteRecord(record); });
+    g_record_file.Flush();
+}
+
+// Write out the summary of the calls counted so far.  Call with g_record_mutex held.
+static void ApiDumpLayerWriteSummary(const std::string &reason) {
+    if (!g_record_info.file_name.empty()) {
+        g_summary.Write(g_record_file.Stream(g_record_info.file_name), reason);
+        g_record_file.Flush();
+        return;
+    }
+    std::ostringstream oss;
+    g_summary.Write(oss, reason);
+    std::istringstream lines(oss.str());
+    std::string line;
+    while (std::getline(lines, line)) {
+#if defined(ANDROID)
+        __android_log_print(ANDROID_LOG_INFO, "api_dump", "%s", line.c_str());
+#endif
+        printf("%s\n", line.c_str());
+    }
+}
+
+// Write out or count one call, as its record type and the runtime configuration say.  Call with g_record_mutex held.
+static void ApiDumpLayerProcessRecord(ApiDumpRecord &record) {
+    // Commands filtered out at instance creation only reach here if they track handles; the layer does not intercept the
+    // others.
+    const ApiDumpRuntimeConfig &config = ApiDumpGetRuntimeConfig();
+    if (config.paused ||
+        (!record.contents.empty() && ApiDumpCommandFiltered(config.filter, std::get<1>(record.contents[0]).c_str()))) {
+        return;
+    }
+    if (g_record_info.type == RECORD_SUMMARY) {
+        if (g_summary.Record(record.contents)) {
+            ApiDumpLayerWriteSummary("frame interval");
+        }
+        return;
+    }
+    if (g_flight_recorder.Enabled()) {
+        g_flight_recorder.Push(std::move(record));
+        return;
+    }
+    ApiDumpLayerWriteRecord(record);
+}
+
+// Records calls in a buffer of the calling thread, and writes them out on a background thread, so that threads making
+// calls neither wait on the output nor on each other.  A thread's buffer is only shared with the writer, which takes
+// the calls of all buffers every kWriteInterval, or when flushed, and writes them in the order of their stamps.
+//
+// A call is stamped while its buffer is locked, so once the writer has locked every buffer after reading the clock,
+// it has every call stamped before then: it writes those, and keeps later ones for its next round.
+class ApiDumpRecordWriter {
+   public:
+    // The writer is stopped when the layer is unloaded, and the configuration its last round uses has to outlive it.
+    ApiDumpRecordWriter() { ApiDumpGetRuntimeConfig(); }
+    ~ApiDumpRecordWriter() { Stop(); }
+
+    // Record a call of the calling thread, or the outputs of its last call.
+    void Push(ApiDumpContents &&contents, bool outputs = false);
+
+    // A stamp for the calling thread, now.
+    ApiDumpCallStamp Stamp();
+
+    // Wait until every call pushed so far has been written, e.g. before output that has to follow them.
+    void Flush();
+
+    // Write every call pushed so far, and end the writer thread.
+    void Stop();
+
+   private:
+    static constexpr std::chrono::milliseconds kWriteInterval{10};
+    // A thread with this many calls buffered waits for the writer, which bounds memory when the output falls behind.
+    static constexpr size_t kMaxBufferedCalls = 16384;
+
+    struct ThreadBuffer {
+        uint32_t thread = 0;
+        std::mutex mutex;
+        std::vector<ApiDumpRecord> records;
+    };
+
+    ThreadBuffer *GetThreadBuffer();
+    uint64_t Now() const;
+    void Run();
+    uint64_t WriteRound(bool all);
+
+    const std::chrono::steady_clock::time_point epoch_ = std::chrono::steady_clock::now();
+
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable written_cv_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    bool stopping_ = false;
+    bool flush_requested_ = false;
+    // Every call stamped before this has been written.
+    uint64_t written_before_ = 0;
+    // Buffers of every thread that ever called into the layer, kept after their threads exit.
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+    // Only used by the writer thread: calls taken from the buffers, stamped too late for the last round.
+    std::vector<ApiDumpRecord> pending_;
+};
+
+constexpr std::chrono::milliseconds ApiDumpRecordWriter::kWriteInterval;
+constexpr size_t ApiDumpRecordWriter::kMaxBufferedCalls;
+
+uint64_t ApiDumpRecordWriter::Now() const {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count());
+}
+
+ApiDumpRecordWriter::ThreadBuffer *ApiDumpRecordWriter::GetThreadBuffer() {
+    static thread_local ThreadBuffer *thread_buffer = nullptr;
+    if (nullptr == thread_buffer) {
+        std::unique_ptr<ThreadBuffer> created(new ThreadBuffer);
+        std::unique_lock<std::mutex> lock(mutex_);
+        created->thread = static_cast<uint32_t>(buffers_.size());
+        thread_buffer = created.get();
+        buffers_.push_back(std::move(created));
+    }
+    return thread_buffer;
+}
+
+ApiDumpCallStamp ApiDumpRecordWriter::Stamp() {
+    ApiDumpCallStamp stamp;
+    stamp.thread = GetThreadBuffer()->thread;
+    stamp.time_ns = Now();
+    return stamp;
+}
+
+void ApiDumpRecordWriter::Push(ApiDumpContents &&contents, bool outputs) {
+    ThreadBuffer *buffer = GetThreadBuffer();
+    size_t buffered = 0;
+    {
+        std::unique_lock<std::mutex> lock(buffer->mutex);
+        buffer->records.emplace_back();
+        ApiDumpRecord &record = buffer->records.back();
+        record.stamp.thread = buffer->thread;
+        record.stamp.time_ns = Now();
+        record.contents = std::move(contents);
+        record.outputs = outputs;
+        buffered = buffer->records.size();
+    }
+    if (!running_.load(std::memory_order_acquire)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&ApiDumpRecordWriter::Run, this);
+        }
+        running_.store(true, std::memory_order_release);
+    }
+    if (buffered >= kMaxBufferedCalls) {
+        Flush();
+    }
+}
+
+void ApiDumpRecordWriter::Flush() {
+    const uint64_t target = Now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!thread_.joinable()) {
+        return;
+    }
+    flush_requested_ = true;
+    wake_cv_.notify_one();
+    written_cv_.wait(lock, [&] { return written_before_ > target || !thread_.joinable(); });
+}
+
+void ApiDumpRecordWriter::Stop() {
+    std::thread thread;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+        wake_cv_.notify_one();
+        thread = std::move(thread_);
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    stopping_ = false;
+    running_.store(false, std::memory_order_release);
+    written_cv_.notify_all();
+}
+
+void ApiDumpRecordWriter::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        const bool stopping = stopping_;
+        flush_requested_ = false;
+        lock.unlock();
+        const uint64_t written_before = WriteRound(stopping);
+        lock.lock();
+        written_before_ = written_before;
+        written_cv_.notify_all();
+        if (stopping) {
+            break;
+        }
+        wake_cv_.wait_for(lock, kWriteInterval, [&] { return stopping_ || flush_requested_; });
+    }
+}
+
+// Write the calls stamped before now, or all of them.  Returns the time every call stamped before was written.
+uint64_t ApiDumpRecordWriter::WriteRound(bool all) {
+    const uint64_t cutoff = Now();
+    std::vector<ThreadBuffer *> buffers;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        buffers.reserve(buffers_.size());
+        for (const auto &buffer : buffers_) {
+            buffers.push_back(buffer.get());
+        }
+    }
+    for (ThreadBuffer *buffer : buffers) {
+        std::unique_lock<std::mutex> lock(buffer->mutex);
+        std::move(buffer->records.begin(), buffer->records.end(), std::back_inserter(pending_));
+        buffer->records.clear();
+    }
+
+    std::stable_sort(pending_.begin(), pending_.end(), [](const ApiDumpRecord &a, const ApiDumpRecord &b) {
+        return a.stamp.time_ns < b.stamp.time_ns;
+    });
+    auto end = all ? pending_.end()
+                   : std::partition_point(pending_.begin(), pending_.end(),
+                                          [cutoff](const ApiDumpRecord &record) { return record.stamp.time_ns < cutoff; });
+    {
+        std::unique_lock<std::mutex> mlock(g_record_mutex);
+        for (auto record = pending_.begin(); record != end; ++record) {
+            ApiDumpLayerProcessRecord(*record);
+        }
+        if (g_flight_recorder.Enabled() && g_flight_recorder_signaled.exchange(false)) {
+            ApiDumpLayerWriteFlightRecorder("signal");
+        }
+        g_record_file.RecordWritten();
+    }
+    pending_.erase(pending_.begin(), end);
+    return all ? Now() : cutoff;
+}
+
+static ApiDumpRecordWriter g_record_writer;
+
+// Function to record all the API dump information
+bool ApiDumpLayerRecordContent(std::vector<std::tuple<std::string, std::string, std::string>> contents) {
+    if (!g_record_info.initialized) {
+        return false;
+    }
+    g_record_writer.Push(std::move(contents));
+    return true;
+}
+
+// Binary captures also record what calls return that later calls refer to, for openxr_replay to map its own to.
+void ApiDumpLayerRecordOutputs(std::vector<std::tuple<std::string, std::string, std::string>> contents) {
+    if (!g_record_info.initialized || g_record_info.type != RECORD_BINARY_FILE) {
+        return;
+    }
+    g_record_writer.Push(std::move(contents), true);
+}
+
+void ApiDumpLayerRecordFailure(const char *command_name, XrResult result) {
+    if (!g_record_info.initialized) {
+        return;
+    }
+    // The calls before the failure have to be in the flight recorder first.
+    g_record_writer.Flush();
+    std::unique_lock<std::mutex> mlock(g_record_mutex);
+    if (g_flight_recorder.Enabled()) {
+        const std::string result_string = ApiDumpEnumToString(result);
+        g_flight_recorder.Push({g_record_writer.Stamp(), {std::make_tuple("XrResult", command_name, result_string)}});
+        ApiDumpLayerWriteFlightRecorder(result_string + " from " + command_name);
+    }
+}
+
+// Apply the settings of a runtime configuration message.  Call with g_record_mutex held.
+static void ApiDumpLayerApplyConfig(const char *message) {
+    ApiDumpRuntimeConfig &config = ApiDumpGetRuntimeConfig();
+    for (const auto &setting : LayerParseConfigMessage(message)) {
+        if (setting.first == "enabled") {
+            config.paused = setting.second == "0";
+        } else if (setting.first == "include") {
+            config.filter.include = ApiDumpSplitPatterns(setting.second);
+        } else if (setting.first == "exclude") {
+            config.filter.exclude = ApiDumpSplitPatterns(setting.second);
+        } else {
+            LogPlatformUtilsError("API Dump layer ignoring unknown configuration setting " + setting.first);
+        }
+    }
+}
+
+void ApiDumpLayerRecordTrigger(const char *message_id, const char *message) {
+    if (!g_record_info.initialized || nullptr == message_id) {
+        return;
+    }
+    // Settings apply from this message on, and the flight recorder has to hold the calls before it.
+    g_record_writer.Flush();
+    std::unique_lock<std::mutex> mlock(g_record_mutex);
+    if (strcmp(message_id, "api_dump_config") == 0) {
+        ApiDumpLayerApplyConfig(message);
+        return;
+    }
+    if (g_flight_recorder.Enabled() && !g_flight_recorder.trigger_message_id.empty() &&
+        g_flight_recorder.trigger_message_id == message_id) {
+        ApiDumpLayerWriteFlightRecorder(std::string("trigger ") + message_id);
+    }
+}
+
 XRAPI_ATTR XrResult XRAPI_CALL ApiDumpLayerXrCreateInstance(const XrInstanceCreateInfo * /*info*/, XrInstance * /*instance*/) {
     if (!g_record_info.initialized) {
         g_record_info.initialized = true;
@@ -449,7 +867,12 @@ XRAPI_ATTR XrResult XRAPI_CALL ApiDumpLayerXrGetInstanceProcAddr(XrInstance inst
         contents.emplace_back("PFN_xrVoidFunction*", "function", PointerToHexString(reinterpret_cast<const void *>(function)));
         ApiDumpLayerRecordContent(contents);
 
-        *function = ApiDumpLayerInnerGetInstanceProcAddr(name);
+        // Filtered commands go straight to the next layer or runtime, so they cost nothing.
+        if (ApiDumpCommandFiltered(name) && !ApiDumpCommandTracksHandles(name)) {
+            *function = nullptr;
+        } else {
+            *function = ApiDumpLayerInnerGetInstanceProcAddr(name);
+        }
 
         // If we setup the function, just return
         if (*function != nullptr) {
@@ -457,16 +880,7 @@ XRAPI_ATTR XrResult XRAPI_CALL ApiDumpLayerXrGetInstanceProcAddr(XrInstance inst
         }
 
         // We have not found it, so pass it down to the next layer/runtime
-        XrGeneratedDispatchTable *gen_dispatch_table = nullptr;
-        {
-            std::unique_lock<std::mutex> mlock(g_instance_dispatch_mutex);
-            auto map_iter = g_instance_dispatch_map.find(instance);
-            if (map_iter == g_instance_dispatch_map.end()) {
-                return XR_ERROR_HANDLE_INVALID;
-            }
-            gen_dispatch_table = map_iter->second;
-        }
-
+        XrGeneratedDispatchTable *gen_dispatch_table = g_instance_dispatch_map.Find(instance);
         if (nullptr == gen_dispatch_table) {
             return XR_ERROR_HANDLE_INVALID;
         }
@@ -494,12 +908,18 @@ XRAPI_ATTR XrResult XRAPI_CALL ApiDumpLayerXrCreateApiLayerInstance(const XrInst
 #if !defined(ANDROID)
         std::string export_type = PlatformUtilsGetEnv("XR_API_DUMP_EXPORT_TYPE");
         std::string file_name = PlatformUtilsGetEnv("XR_API_DUMP_FILE_NAME");
+        std::string ring_size = PlatformUtilsGetEnv("XR_API_DUMP_RING_SIZE");
+        std::string ring_trigger = PlatformUtilsGetEnv("XR_API_DUMP_RING_TRIGGER");
+        std::string summary_interval = PlatformUtilsGetEnv("XR_API_DUMP_SUMMARY_INTERVAL");
 #else
         // We match the pattern used by the Vulkan api_dump layer here
         // (we replace the `XR_` prefix with `debug.` and make it lowercase.)
         // adb shell "setprop debug.api_dump_file_name '/sdcard/xr_apidump.txt'"
         std::string export_type = PlatformUtilsGetAndroidSystemProperty("debug.api_dump_export_type");
         std::string file_name = PlatformUtilsGetAndroidSystemProperty("debug.api_dump_file_name");
+        std::string ring_size = PlatformUtilsGetAndroidSystemProperty("debug.api_dump_ring_size");
+        std::string ring_trigger = PlatformUtilsGetAndroidSystemProperty("debug.api_dump_ring_trigger");
+        std::string summary_interval = PlatformUtilsGetAndroidSystemProperty("debug.api_dump_summary_interval");
 #endif
 
         if (!file_name.empty()) {
@@ -523,9 +943,29 @@ XRAPI_ATTR XrResult XRAPI_CALL ApiDumpLayerXrCreateApiLayerInstance(const XrInst
                 if (!ApiDumpLayerWriteHtmlHeader()) {
                     return XR_ERROR_INITIALIZATION_FAILED;
                 }
+            } else if (export_type_lower == "summary" && first_time) {
+                g_record_info.type = RECORD_SUMMARY;
+                std::unique_lock<std::mutex> mlock(g_record_mutex);
+                g_summary.interval = static_cast<uint32_t>(std::strtoul(summary_interval.c_str(), nullptr, 10));
             } else if (export_type_lower == "code") {
                 g_record_info.type = RECORD_CODE_FILE;
+            } else if (export_type_lower == "binary" && first_time && !g_record_info.file_name.empty()) {
+                g_record_info.type = RECORD_BINARY_FILE;
+                if (!ApiDumpLayerWriteBinaryHeader()) {
+                    return XR_ERROR_INITIALIZATION_FAILED;
+                }
+            }
+        }
+
+        if (first_time && !ring_size.empty()) {
+            std::unique_lock<std::mutex> mlock(g_record_mutex);
+            g_flight_recorder.SetCapacity(static_cast<size_t>(std::strtoul(ring_size.c_str(), nullptr, 10)));
+            g_flight_recorder.trigger_message_id = ring_trigger;
+#if !defined(_WIN32)
+            if (g_flight_recorder.Enabled()) {
+                g_flight_recorder_signal.Install();
             }
+#endif
         }
 
         // Validate the API layer info and next API layer info structures before we try to use them
@@ -547,7 +987,7 @@ XRAPI_ATTR XrResult XRAPI_CALL ApiDumpLayerXrCreateApiLayerInstance(const XrInst
         contents.emplace_back("const XrInstanceCreateInfo*", "info", PointerToHexString(info));
         if (nullptr != info) {
             std::string info_prefix = "info->";
-            contents.emplace_back("XrStructureType", "info->type", std::to_string(info->type));
+            contents.emplace_back("XrStructureType", "info->type", ApiDumpEnumToString(info->type));
             std::string next_prefix = info_prefix;
             next_prefix += "next";
             // Decode the next chain if it exists
@@ -556,7 +996,7 @@ XRAPI_ATTR XrResult XRAPI_CALL ApiDumpLayerXrCreateApiLayerInstance(const XrInst
             }
             std::string flags_prefix = info_prefix;
             flags_prefix += "createFlags";
-            contents.emplace_back("XrInstanceCreateFlags", flags_prefix, std::to_string(info->createFlags));
+            contents.emplace_back("XrInstanceCreateFlags", flags_prefix, ApiDumpXrInstanceCreateFlagsToString(info->createFlags));
             std::string applicationinfo_prefix = info_prefix;
             applicationinfo_prefix += "applicationInfo";
             if (!ApiDumpOutputXrStruct(nullptr, &info->applicationInfo, applicationinfo_prefix, "XrApplicationInfo", true,
@@ -609,13 +1049,16 @@ XRAPI_ATTR XrResult XRAPI_CALL ApiDumpLayerXrCreateApiLayerInstance(const XrInst
         XrInstance returned_instance = *instance;
         XrResult result = next_create_api_layer_instance(info, &new_api_layer_info, &returned_instance);
         *instance = returned_instance;
+        if (XR_SUCCEEDED(result)) {
+            ApiDumpLayerRecordOutputs({std::make_tuple("XrResult", "xrCreateInstance", ""),
+                                       std::make_tuple("XrInstance", "*instance", HandleToHexString(returned_instance))});
+        }
 
         // Create the dispatch table to the next levels
         auto *next_dispatch = new XrGeneratedDispatchTable();
         GeneratedXrPopulateDispatchTable(next_dispatch, returned_instance, next_get_instance_proc_addr);
 
-        std::unique_lock<std::mutex> mlock(g_instance_dispatch_mutex);
-        g_instance_dispatch_map[returned_instance] = next_dispatch;
+        g_instance_dispatch_map.Insert(returned_instance, next_dispatch);
 
         return result;
     } catch (...) {
@@ -630,15 +1073,7 @@ XRAPI_ATTR XrResult XRAPI_CALL ApiDumpLayerXrDestroyInstance(XrInstance instance
     contents.emplace_back("XrInstance", "instance", HandleToHexString(instance));
     ApiDumpLayerRecordContent(contents);
 
-    XrGeneratedDispatchTable *next_dispatch = nullptr;
-    {
-        std::unique_lock<std::mutex> mlock(g_instance_dispatch_mutex);
-        auto map_iter = g_instance_dispatch_map.find(instance);
-        if (map_iter != g_instance_dispatch_map.end()) {
-            next_dispatch = map_iter->second;
-        }
-    }
-
+    XrGeneratedDispatchTable *next_dispatch = g_instance_dispatch_map.Find(instance);
     if (nullptr == next_dispatch) {
         return XR_ERROR_HANDLE_INVALID;
     }
@@ -646,9 +1081,22 @@ XRAPI_ATTR XrResult XRAPI_CALL ApiDumpLayerXrDestroyInstance(XrInstance instance
     next_dispatch->DestroyInstance(instance);
     ApiDumpCleanUpMapsForTable(next_dispatch);
 
+    // Calls must be written out before the footer, and the writer thread must end before the layer is unloaded.
+    if (g_instance_dispatch_map.Empty()) {
+        g_record_writer.Stop();
+    } else {
+        g_record_writer.Flush();
+    }
+
     // Write out the HTML footer if we destroy the last instance
-    if (g_instance_dispatch_map.empty() && g_record_info.type == RECORD_HTML_FILE) {
+    if (g_instance_dispatch_map.Empty() && g_record_info.type == RECORD_HTML_FILE) {
         ApiDumpLayerWriteHtmlFooter();
+    } else if (g_record_info.type == RECORD_SUMMARY) {
+        std::unique_lock<std::mutex> mlock(g_record_mutex);
+        ApiDumpLayerWriteSummary("xrDestroyInstance");
+    } else {
+        std::unique_lock<std::mutex> mlock(g_record_mutex);
+        g_record_file.Flush();
     }
     return XR_SUCCESS;
 }
@@ -0,0 +1,107 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Turns a binary capture of the api_dump layer (XR_API_DUMP_EXPORT_TYPE=binary) into the layer's text or HTML output.
+
+#include "api_dump_format.h"
+
+#if defined(XR_LAYER_RECORD_GZIP)
+#include "layer_record_gzip.h"
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static int Usage() {
+    std::cerr << "usage: api_dump_decode [--html] <capture file> [output file]\n";
+    return 2;
+}
+
+int main(int argc, char *argv[]) {
+    bool html = false;
+    const char *capture_name = nullptr;
+    const char *output_name = nullptr;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (0 == strcmp(argv[arg], "--html")) {
+            html = true;
+        } else if (nullptr == capture_name) {
+            capture_name = argv[arg];
+        } else if (nullptr == output_name) {
+            output_name = argv[arg];
+        } else {
+            return Usage();
+        }
+    }
+    if (nullptr == capture_name) {
+        return Usage();
+    }
+
+#if defined(XR_LAYER_RECORD_GZIP)
+    // Reads captures written to a .gz file name, and ones that are not compressed.
+    LayerGzipReadBuf capture_buf;
+    if (!capture_buf.Open(capture_name)) {
+        std::cerr << "api_dump_decode: cannot open " << capture_name << "\n";
+        return 1;
+    }
+    std::istream capture(&capture_buf);
+#else
+    std::ifstream capture(capture_name, std::ios::in | std::ios::binary);
+    if (!capture.is_open()) {
+        std::cerr << "api_dump_decode: cannot open " << capture_name << "\n";
+        return 1;
+    }
+#endif
+    std::ofstream output_file;
+    if (nullptr != output_name) {
+        output_file.open(output_name, std::ios::out | std::ios::trunc);
+        if (!output_file.is_open()) {
+            std::cerr << "api_dump_decode: cannot open " << output_name << "\n";
+            return 1;
+        }
+    }
+    std::ostream &out = (nullptr != output_name) ? output_file : std::cout;
+
+    ApiDumpBinaryReader reader(capture);
+    if (!reader.ReadHeader()) {
+        std::cerr << "api_dump_decode: " << capture_name << ": " << reader.Error() << "\n";
+        return 1;
+    }
+    if (html) {
+        ApiDumpFormatHtmlHeader(out);
+    }
+    ApiDumpContents contents;
+    ApiDumpCallStamp stamp;
+    bool stamped = false;
+    while (reader.ReadCall(contents, stamp, stamped)) {
+        if (html) {
+            ApiDumpFormatHtml(out, contents, stamped ? &stamp : nullptr);
+        } else {
+            ApiDumpFormatText(out, contents, stamped ? &stamp : nullptr);
+        }
+    }
+    if (html) {
+        ApiDumpFormatHtmlFooter(out);
+    }
+    // A capture cut short, e.g. by a crash, still decodes up to the last complete call.
+    if (!reader.Error().empty()) {
+        std::cerr << "api_dump_decode: " << capture_name << ": " << reader.Error() << "\n";
+        return 1;
+    }
+    return 0;
+}
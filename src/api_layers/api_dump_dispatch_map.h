@@ -0,0 +1,53 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef API_DUMP_DISPATCH_MAP_H_
+#define API_DUMP_DISPATCH_MAP_H_ 1
+
+#include "layer_handle_registry.h"
+
+struct XrGeneratedDispatchTable;
+
+/// The dispatch table to call down with for each live handle of one type, kept in a LayerHandleRegistry so lookups
+/// take no lock.
+template <typename HandleType>
+class ApiDumpDispatchMap {
+   public:
+    XrGeneratedDispatchTable *Find(HandleType handle) const { return registry_.Find(handle); }
+
+    /// The handle using table, or XR_NULL_HANDLE if there is none.
+    HandleType FindHandle(XrGeneratedDispatchTable *table) const {
+        return registry_.FindIf([table](HandleType, XrGeneratedDispatchTable *value, uint64_t) { return value == table; });
+    }
+
+    /// Add handle, unless it is already there.
+    void Insert(HandleType handle, XrGeneratedDispatchTable *table) { registry_.Insert(handle, table); }
+
+    void Erase(HandleType handle) { registry_.Erase(handle); }
+
+    /// Erase every handle using table, e.g. when its instance is destroyed.
+    void EraseTable(XrGeneratedDispatchTable *table) {
+        registry_.EraseIf([table](HandleType, XrGeneratedDispatchTable *value, uint64_t) { return value == table; });
+    }
+
+    bool Empty() const { return registry_.Empty(); }
+
+   private:
+    LayerHandleRegistry<HandleType, XrGeneratedDispatchTable> registry_;
+};
+
+#endif  // API_DUMP_DISPATCH_MAP_H_
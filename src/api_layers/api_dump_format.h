@@ -0,0 +1,528 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Output formats of the api_dump layer, shared by the layer and the api_dump_decode and openxr_replay tools.
+
+#ifndef API_DUMP_FORMAT_H_
+#define API_DUMP_FORMAT_H_ 1
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// One API call: the command as the first entry, followed by each parameter and member as (type, name, value).
+typedef std::vector<std::tuple<std::string, std::string, std::string>> ApiDumpContents;
+
+// When and on which thread a call was made: nanoseconds of a monotonic clock since the layer was loaded, and the
+// number of the thread, counting threads in the order they first called into the layer.
+struct ApiDumpCallStamp {
+    uint64_t time_ns = 0;
+    uint32_t thread = 0;
+};
+
+// "thread 2, 12.345678901 s", as shown after the command.
+inline std::string ApiDumpFormatStamp(const ApiDumpCallStamp &stamp) {
+    char formatted[64];
+    snprintf(formatted, sizeof(formatted), "thread %u, %llu.%09llu s", stamp.thread,
+             static_cast<unsigned long long>(stamp.time_ns / 1000000000),
+             static_cast<unsigned long long>(stamp.time_ns % 1000000000));
+    return formatted;
+}
+
+inline void ApiDumpFormatText(std::ostream &out, const ApiDumpContents &contents, const ApiDumpCallStamp *stamp = nullptr) {
+    uint32_t count = 0;
+    for (const auto &content : contents) {
+        std::string content_type;
+        std::string content_name;
+        std::string content_value;
+        std::tie(content_type, content_name, content_value) = content;
+        if (count++ != 0) {
+            out << "    ";
+        }
+        if (!content_value.empty()) {
+            out << content_type << " " << content_name << " = " << content_value;
+        } else {
+            out << content_type << " " << content_name;
+        }
+        if (count == 1 && nullptr != stamp) {
+            out << " [" << ApiDumpFormatStamp(*stamp) << "]";
+        }
+        out << "\n";
+    }
+}
+
+inline void ApiDumpFormatHtmlHeader(std::ostream &out) {
+    out << "<!doctype html>\n"
+           "<html>\n"
+           "    <head>\n"
+           "        <title>OpenXR API Dump</title>\n"
+           "        <style type='text/css'>\n"
+           "        html {\n"
+           "            background-color: #0b1e48;\n"
+           "            background-image: url('https://vulkan.lunarg.com/img/bg-starfield.jpg');\n"
+           "            background-position: center;\n"
+           "            -webkit-background-size: cover;\n"
+           "            -moz-background-size: cover;\n"
+           "            -o-background-size: cover;\n"
+           "            background-size: cover;\n"
+           "            background-attachment: fixed;\n"
+           "            background-repeat: no-repeat;\n"
+           "            height: 100%;\n"
+           "        }\n"
+           "        #header {\n"
+           "            z-index: -1;\n"
+           "        }\n"
+           "        #header>img {\n"
+           "            position: absolute;\n"
+           "            width: 160px;\n"
+           "            margin-left: -280px;\n"
+           "            top: -10px;\n"
+           "            left: 50%;\n"
+           "        }\n"
+           "        #header>h1 {\n"
+           "            font-family: Arial, 'Helvetica Neue', Helvetica, sans-serif;\n"
+           "            font-size: 44px;\n"
+           "            font-weight: 200;\n"
+           "            text-shadow: 4px 4px 5px #000;\n"
+           "            color: #eee;\n"
+           "            position: absolute;\n"
+           "            width: 400px;\n"
+           "            margin-left: -80px;\n"
+           "            top: 8px;\n"
+           "            left: 50%;\n"
+           "        }\n"
+           "        body {\n"
+           "            font-family: Consolas, monaco, monospace;\n"
+           "            font-size: 14px;\n"
+           "            line-height: 20px;\n"
+           "            color: #eee;\n"
+           "            height: 100%;\n"
+           "            margin: 0;\n"
+           "            overflow: hidden;\n"
+           "        }\n"
+           "        #wrapper {\n"
+           "            background-color: rgba(0, 0, 0, 0.7);\n"
+           "            border: 1px solid #446;\n"
+           "            box-shadow: 0px 0px 10px #000;\n"
+           "            padding: 8px 12px;\n"
+           "            display: inline-block;\n"
+           "            position: absolute;\n"
+           "            top: 80px;\n"
+           "            bottom: 25px;\n"
+           "            left: 50px;\n"
+           "            right: 50px;\n"
+           "            overflow: auto;\n"
+           "        }\n"
+           "        details>*:not(summary) {\n"
+           "            margin-left: 22px;\n"
+           "        }\n"
+           "        summary:only-child {\n"
+           "            display: block;\n"
+           "            padding-left: 15px;\n"
+           "        }\n"
+           "        details>summary:only-child::-webkit-details-marker {\n"
+           "            display: none;\n"
+           "            padding-left: 15px;\n"
+           "        }\n"
+           "        .headervar, .headertype, .headerval {\n"
+           "            display: inline;\n"
+           "            margin: 0 9px;\n"
+           "        }\n"
+           "        .var, .type, .val {\n"
+           "            display: inline;\n"
+           "            margin: 0 6px;\n"
+           "        }\n"
+           "        .headertype, .type {\n"
+           "            color: #acf;\n"
+           "        }\n"
+           "        .headerval, .val {\n"
+           "            color: #afa;\n"
+           "            text-align: right;\n"
+           "        }\n"
+           "        .thd {\n"
+           "            color: #888;\n"
+           "        }\n"
+           "        </style>\n"
+           "    </head>\n"
+           "    <body>\n"
+           "        <div id='header'>\n"
+           "            <img src='https://lunarg.com/wp-content/uploads/2016/02/LunarG-wReg-150.png' />\n"
+           "            <h1>OpenXR API Dump</h1>\n"
+           "        </div>\n"
+           "        <div id='wrapper'>\n";
+}
+
+inline void ApiDumpFormatHtmlFooter(std::ostream &out) {
+    out << "        </div>\n"
+           "    </body>\n"
+           "</html>";
+}
+
+inline void ApiDumpFormatHtml(std::ostream &out, const ApiDumpContents &contents, const ApiDumpCallStamp *stamp = nullptr) {
+    out << "<details class='data'>\n";
+    std::vector<std::string> prefixes;
+    uint32_t last_deref_count = 0;
+    for (uint32_t content_index = 0; content_index < contents.size(); ++content_index) {
+        std::string content_type;
+        std::string content_name;
+        std::string content_value;
+        std::tie(content_type, content_name, content_value) = contents[content_index];
+        if (content_index == 0) {
+            out << "   <summary>\n"
+                << "      <div class='headertype'>" << content_type << "</div>\n"
+                << "      <div class='headervar'>" << content_name << "</div>\n";
+            if (nullptr != stamp) {
+                out << "      <div class='headerval thd'>" << ApiDumpFormatStamp(*stamp) << "</div>\n";
+            }
+            out << "   </summary>\n";
+        } else {
+            uint32_t cur_deref_count = 0;
+            uint32_t next_deref_count = 0;
+
+            // Count number of structure and pointer dereferences for the current line
+            cur_deref_count = static_cast<uint32_t>(std::count(content_name.begin(), content_name.end(), '.'));
+            std::string::size_type start = 0;
+            while ((start = content_name.find("->", start)) != std::string::npos) {
+                ++cur_deref_count;
+                start += 2;
+            }
+            // Now look for array dereferences
+            start = 0;
+            while ((start = content_name.find('[', start)) != std::string::npos) {
+                ++cur_deref_count;
+                start++;
+            }
+
+            // If there's something after this, see if it's a sub-component of this.
+            if (content_index < contents.size() - 1) {
+                std::string next_content_type;
+                std::string next_content_name;
+                std::string next_content_value;
+                std::tie(next_content_type, next_content_name, next_content_value) = contents[content_index + 1];
+
+                // Count number of structure and pointer dereferences for the next line
+                next_deref_count =
+                    static_cast<uint32_t>(std::count(next_content_name.begin(), next_content_name.end(), '.'));
+                start = 0;
+                while ((start = next_content_name.find("->", start)) != std::string::npos) {
+                    ++next_deref_count;
+                    start += 2;
+                }
+                // Now look for array dereferences
+                start = 0;
+                while ((start = next_content_name.find('[', start)) != std::string::npos) {
+                    ++next_deref_count;
+                    start++;
+                }
+            }
+
+            // If we've reduced the number of dereferences in the name from last time, we need
+            // to close up those detail sections.
+            if (cur_deref_count < last_deref_count) {
+                uint32_t diff_count = last_deref_count - cur_deref_count;
+                while ((diff_count--) != 0u) {
+                    out << "   </details>\n";
+                    prefixes.pop_back();
+                }
+            }
+
+            // Look through any prefixes we've saved (going backwards through the list)
+            // and find the one that matches our beginning.
+            std::string short_name = content_name;
+            if (cur_deref_count > 0) {
+                for (auto it = prefixes.rbegin(); it != prefixes.rend(); ++it) {
+                    if (content_name.find(*it) == 0) {
+                        std::string::size_type additional_offset = it->size() + 1;
+                        if (content_name[additional_offset - 1] == '-') {
+                            additional_offset++;
+                        } else if (content_name[additional_offset - 1] == '[') {
+                            additional_offset--;
+                        }
+                        short_name = content_name.substr(additional_offset);
+                        break;
+                    }
+                }
+            }
+
+            bool writing_summary = false;
+
+            // If the next item contains this item as a prefix, start the summary.  Otherwise,
+            // start a <div> marker so that each component lands on its own line.
+            if (cur_deref_count < next_deref_count) {
+                out << "   <details class='data'>\n"
+                    << "      <summary>\n";
+                writing_summary = true;
+                prefixes.push_back(content_name);
+            } else {
+                out << "      <div class='data'>\n";
+            }
+
+            // Write out the content
+            out << "         <div class='type'>" << content_type << "</div>\n"
+                << "         <div class='var'>" << short_name << "</div>\n";
+            bool value_needs_printing = true;
+            if (content_type.find("char") != std::string::npos) {
+                uint64_t star_count = std::count(content_type.begin(), content_type.end(), '*');
+                uint64_t bracket_count = std::count(content_type.begin(), content_type.end(), '[');
+                if (star_count + bracket_count < 2) {
+                    out << "         <div class='val'>\"" << content_value << "\"</div>";
+                    value_needs_printing = false;
+                }
+            }
+            if (!content_value.empty() && value_needs_printing) {
+                out << "         <div class='val'>" << content_value << "</div>";
+            }
+            out << "\n";
+
+            // Wrap up any summary we may have started.  Otherwise, just wrap up the
+            // <div> marker wrapping this entry.
+            if (writing_summary) {
+                out << "      </summary>\n";
+            } else {
+                out << "      </div>\n";
+            }
+
+            last_deref_count = cur_deref_count;
+        }
+    }
+
+    // Wrap up any remaining items
+    if (last_deref_count != 0u) {
+        while ((last_deref_count--) != 0u) {
+            out << "   </details>\n";
+            prefixes.pop_back();
+        }
+    }
+    out << "</details>\n";
+}
+
+// Binary capture format: written with ApiDumpBinaryWriter by the layer, turned back into text or HTML by
+// api_dump_decode, and replayed by openxr_replay.  All integers are little-endian.
+//
+//   header:      u32 magic ("XRAD"), u32 version
+//   tag 1:       string definition: u32 id, u32 length, bytes
+//   tag 2:       call: u32 entry count, then per entry u32 type string id, u32 name string id, u32 value length,
+//                value bytes
+//   tag 3:       stamped call: u64 nanoseconds and u32 thread of its ApiDumpCallStamp, then a call as in tag 2
+//   tag 4:       outputs of the last call of a thread, as in tag 3: the command as the first entry, followed by the
+//                handles, atoms and times it returned, like ("XrSession", "*session", "0x..."), for openxr_replay
+//
+// Types and names repeat from call to call, so they are written once as strings and referenced by id after that.
+static const uint32_t kApiDumpBinaryMagic = 0x44415258;
+static const uint32_t kApiDumpBinaryVersion = 3;
+
+class ApiDumpBinaryWriter {
+   public:
+    void WriteHeader(std::ostream &out) {
+        string_ids_.clear();
+        buffer_.clear();
+        PutU32(kApiDumpBinaryMagic);
+        PutU32(kApiDumpBinaryVersion);
+        Emit(out);
+    }
+
+    void WriteCall(std::ostream &out, const ApiDumpContents &contents, const ApiDumpCallStamp *stamp = nullptr) {
+        WriteRecord(out, nullptr != stamp ? kTagStampedCall : kTagCall, contents, stamp);
+    }
+
+    void WriteOutputs(std::ostream &out, const ApiDumpContents &contents, const ApiDumpCallStamp &stamp) {
+        WriteRecord(out, kTagOutputs, contents, &stamp);
+    }
+
+   private:
+    static const char kTagString = 1;
+    static const char kTagCall = 2;
+    static const char kTagStampedCall = 3;
+    static const char kTagOutputs = 4;
+
+    void WriteRecord(std::ostream &out, char tag, const ApiDumpContents &contents, const ApiDumpCallStamp *stamp) {
+        buffer_.clear();
+        // String definitions have to come before the call that uses them, so look them up first.
+        std::vector<uint32_t> ids;
+        ids.reserve(contents.size() * 2);
+        for (const auto &content : contents) {
+            ids.push_back(StringId(std::get<0>(content)));
+            ids.push_back(StringId(std::get<1>(content)));
+        }
+        buffer_.push_back(tag);
+        if (nullptr != stamp) {
+            PutU32(static_cast<uint32_t>(stamp->time_ns & 0xFFFFFFFF));
+            PutU32(static_cast<uint32_t>(stamp->time_ns >> 32));
+            PutU32(stamp->thread);
+        }
+        PutU32(static_cast<uint32_t>(contents.size()));
+        for (size_t entry = 0; entry < contents.size(); ++entry) {
+            const std::string &value = std::get<2>(contents[entry]);
+            PutU32(ids[entry * 2]);
+            PutU32(ids[entry * 2 + 1]);
+            PutU32(static_cast<uint32_t>(value.size()));
+            buffer_.append(value);
+        }
+        Emit(out);
+    }
+
+    uint32_t StringId(const std::string &value) {
+        auto found = string_ids_.find(value);
+        if (found != string_ids_.end()) {
+            return found->second;
+        }
+        const uint32_t id = static_cast<uint32_t>(string_ids_.size());
+        string_ids_.emplace(value, id);
+        buffer_.push_back(kTagString);
+        PutU32(id);
+        PutU32(static_cast<uint32_t>(value.size()));
+        buffer_.append(value);
+        return id;
+    }
+
+    void PutU32(uint32_t value) {
+        for (int byte = 0; byte < 4; ++byte) {
+            buffer_.push_back(static_cast<char>((value >> (8 * byte)) & 0xFF));
+        }
+    }
+
+    void Emit(std::ostream &out) { out.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size())); }
+
+    std::unordered_map<std::string, uint32_t> string_ids_;
+    std::string buffer_;
+};
+
+class ApiDumpBinaryReader {
+   public:
+    explicit ApiDumpBinaryReader(std::istream &in) : in_(in) {}
+
+    bool ReadHeader() {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        if (!GetU32(magic) || !GetU32(version) || magic != kApiDumpBinaryMagic) {
+            error_ = "not an api_dump binary capture";
+            return false;
+        }
+        // Version 1 captures are the same, without stamped calls, and version 2 ones without outputs.
+        if (version < 1 || version > kApiDumpBinaryVersion) {
+            error_ = "unsupported capture version " + std::to_string(version);
+            return false;
+        }
+        return true;
+    }
+
+    /// Read the next call, and whether it has a stamp.  Returns false at the end of the capture, or on an error, in which
+    /// case Error() says why.  Outputs records are skipped, unless outputs is given: then they are read like calls, with
+    /// *outputs set for them.
+    bool ReadCall(ApiDumpContents &contents, ApiDumpCallStamp &stamp, bool &stamped, bool *outputs = nullptr) {
+        contents.clear();
+        stamped = false;
+        if (nullptr != outputs) {
+            *outputs = false;
+        }
+        char tag = 0;
+        while (in_.get(tag)) {
+            if (tag == kTagString) {
+                uint32_t id = 0;
+                std::string value;
+                if (!GetU32(id) || !GetString(value) || id != strings_.size()) {
+                    return Fail("bad string definition");
+                }
+                strings_.push_back(std::move(value));
+            } else if (tag == kTagCall || tag == kTagStampedCall || tag == kTagOutputs) {
+                if (tag == kTagStampedCall || tag == kTagOutputs) {
+                    uint32_t time_low = 0;
+                    uint32_t time_high = 0;
+                    if (!GetU32(time_low) || !GetU32(time_high) || !GetU32(stamp.thread)) {
+                        return Fail("truncated call");
+                    }
+                    stamp.time_ns = (static_cast<uint64_t>(time_high) << 32) | time_low;
+                    stamped = true;
+                }
+                uint32_t count = 0;
+                if (!GetU32(count)) {
+                    return Fail("truncated call");
+                }
+                for (uint32_t entry = 0; entry < count; ++entry) {
+                    uint32_t type_id = 0;
+                    uint32_t name_id = 0;
+                    std::string value;
+                    if (!GetU32(type_id) || !GetU32(name_id) || !GetString(value)) {
+                        return Fail("truncated call");
+                    }
+                    if (type_id >= strings_.size() || name_id >= strings_.size()) {
+                        return Fail("call refers to an undefined string");
+                    }
+                    contents.emplace_back(strings_[type_id], strings_[name_id], std::move(value));
+                }
+                if (tag == kTagOutputs) {
+                    if (nullptr == outputs) {
+                        contents.clear();
+                        stamped = false;
+                        continue;
+                    }
+                    *outputs = true;
+                }
+                return true;
+            } else {
+                return Fail("unknown record tag " + std::to_string(static_cast<int>(tag)));
+            }
+        }
+        return false;
+    }
+
+    const std::string &Error() const { return error_; }
+
+   private:
+    static const char kTagString = 1;
+    static const char kTagCall = 2;
+    static const char kTagStampedCall = 3;
+    static const char kTagOutputs = 4;
+
+    bool Fail(const std::string &error) {
+        error_ = error;
+        return false;
+    }
+
+    bool GetU32(uint32_t &value) {
+        unsigned char bytes[4];
+        if (!in_.read(reinterpret_cast<char *>(bytes), sizeof(bytes))) {
+            return false;
+        }
+        value = static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+                (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+        return true;
+    }
+
+    bool GetString(std::string &value) {
+        uint32_t length = 0;
+        if (!GetU32(length)) {
+            return false;
+        }
+        value.resize(length);
+        return length == 0 || static_cast<bool>(in_.read(&value[0], length));
+    }
+
+    std::istream &in_;
+    std::vector<std::string> strings_;
+    std::string error_;
+};
+
+#endif  // API_DUMP_FORMAT_H_
@@ -5,9 +5,11 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include "frame_timing.h"
 #include "layer_utils.h"
 
 #include "hex_and_handles.h"
+#include "layer_handle_registry.h"
 #include "platform_utils.hpp"
 #include "xr_generated_dispatch_table.h"
 
@@ -15,7 +17,9 @@
 #include <openxr/openxr_loader_negotiation.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <fstream>
@@ -29,7 +33,6 @@
 #include <unordered_map>
 #include <utility>
 #include <vector>
-#include <deque>
 
 #ifdef __ANDROID__
 #include "android/log.h"
@@ -59,6 +62,9 @@ void LogPlatformUtilsError(const std::string &message) {
 #endif
 }
 
+// Views of a frame kept to check xrEndFrame projection layers against.
+static const uint32_t kMaxFrameViews = 2;
+
 struct FrameState {
     bool waitFrameCalled;
     XrResult waitFrameResult;
@@ -70,43 +76,198 @@ struct FrameState {
     XrTime predictedDisplayTime;
     XrTime predictedDisplayPeriod;
     uint32_t frameIndex;
-    XrView views[2];
+    XrView views[kMaxFrameViews];
+    // CPU timestamps for frame timing.
+    std::chrono::steady_clock::time_point waitFrameCallTime;
+    std::chrono::steady_clock::time_point waitFrameReturnTime;
+    std::chrono::steady_clock::time_point beginFrameCallTime;
+    // When views were last located for this frame, to check how old their poses are at xrEndFrame.
+    bool viewsLocated;
+    std::chrono::steady_clock::time_point locateViewsReturnTime;
 };
 
-static LockedDispatchTable g_nextDispatch{};
-static std::deque<FrameState> g_framesInFlight;
-static std::mutex g_frameMutex;
-static uint32_t g_frameIndex;
-static XrTime g_lastEndFramePDT;
+// The frames in flight of one session, oldest first.  Runtimes pipeline only a few frames, so a fixed ring is enough; an
+// application that keeps calling xrWaitFrame without finishing frames pushes the oldest out.
+class FrameRing {
+   public:
+    static constexpr uint32_t kCapacity = 8;
+
+    bool empty() const { return m_count == 0; }
+    uint32_t size() const { return m_count; }
+    FrameState &front() { return m_frames[m_head]; }
+    FrameState &back() { return m_frames[(m_head + m_count - 1) % kCapacity]; }
+
+    void push_back(const FrameState &frame) {
+        if (m_count == kCapacity) {
+            pop_front();
+        }
+        m_frames[(m_head + m_count) % kCapacity] = frame;
+        ++m_count;
+    }
 
-std::unordered_map<std::string, int> BPLogger::errorCounts;
+    void pop_front() {
+        m_head = (m_head + 1) % kCapacity;
+        --m_count;
+    }
+
+    template <typename Pred>
+    void remove_if(Pred &&pred) {
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < m_count; ++i) {
+            const FrameState &frame = m_frames[(m_head + i) % kCapacity];
+            if (!pred(frame)) {
+                m_frames[(m_head + kept++) % kCapacity] = frame;
+            }
+        }
+        m_count = kept;
+    }
+
+   private:
+    FrameState m_frames[kCapacity] = {};
+    uint32_t m_head = 0;
+    uint32_t m_count = 0;
+};
+
+// Frame loop state of one session.  The mutex is only taken by the frame loop calls of that session, which an application
+// makes from one thread at a time, so it does not make threads wait on each other.
+struct SessionFrameState {
+    std::mutex mutex;
+    FrameRing framesInFlight;
+    uint32_t frameIndex = 0;
+    XrTime lastEndFramePDT = 0;
+    // Whether the oldest frame in flight has been through xrWaitFrame, mirrored in g_sessionsWaited for xrLocateSpace.
+    bool frontWaited = false;
+    // Frame timing since the last summary, and since the session was created.
+    FrameTimingStats timingInterval;
+    FrameTimingStats timingTotal;
+    XrTime lastTimedPDT = 0;
+};
+
+static LockedDispatchTable g_nextDispatch{};
+// The states are owned by the map, which only session creation and destruction lock, and looked up through the registry.
+static std::unordered_map<XrSession, std::unique_ptr<SessionFrameState>> g_sessionFrameStates;
+static std::mutex g_sessionFrameStatesMutex;
+static LayerHandleRegistry<XrSession, SessionFrameState> g_sessionFrameStateRegistry;
+// Number of sessions whose oldest frame in flight has been through xrWaitFrame.  xrLocateSpace has no session to look up,
+// and may be called from many threads, so it only reads this.
+static std::atomic<uint32_t> g_sessionsWaited{0};
+// For frame timing: whether the application enabled an extension to convert the system clock to XrTime.
+static std::atomic<XrInstance> g_instance{XR_NULL_HANDLE};
+static std::atomic<bool> g_canConvertTime{false};
+
+constexpr uint32_t BPLogger::kWrittenOccurrences;
+constexpr uint32_t BPLogger::kNoteInterval;
+std::atomic<uint32_t> BPLogger::occurrenceCounts[static_cast<uint32_t>(BPMessageId::Count)] = {};
 
 PFN_xrVoidFunction BestPracticesLayerInnerGetInstanceProcAddr(const char *name);
 
+static SessionFrameState &GetSessionFrameState(XrSession session) {
+    SessionFrameState *found = g_sessionFrameStateRegistry.Find(session);
+    if (nullptr != found) {
+        return *found;
+    }
+    std::unique_lock<std::mutex> lock(g_sessionFrameStatesMutex);
+    std::unique_ptr<SessionFrameState> &state = g_sessionFrameStates[session];
+    if (!state) {
+        state = std::make_unique<SessionFrameState>();
+        g_sessionFrameStateRegistry.Insert(session, state.get());
+    }
+    return *state;
+}
+
+// Call with state.mutex held, after changing which frame is the oldest in flight.
+static void UpdateFrontWaited(SessionFrameState &state) {
+    const bool frontWaited = !state.framesInFlight.empty() && state.framesInFlight.front().waitFrameCalled;
+    if (frontWaited != state.frontWaited) {
+        state.frontWaited = frontWaited;
+        if (frontWaited) {
+            g_sessionsWaited.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            g_sessionsWaited.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+static int64_t Nanoseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+// The current XrTime, if the application enabled a time conversion extension for the platform clock.
+static bool GetCurrentXrTime(XrTime *time) {
+    if (!g_canConvertTime.load(std::memory_order_relaxed)) {
+        return false;
+    }
+#if defined(XR_USE_PLATFORM_WIN32)
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return XR_SUCCEEDED(g_nextDispatch.Get<PFN_xrConvertWin32PerformanceCounterToTimeKHR>(
+        &XrGeneratedDispatchTable::ConvertWin32PerformanceCounterToTimeKHR)(g_instance.load(), &counter, time));
+#elif defined(XR_USE_TIMESPEC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return XR_SUCCEEDED(g_nextDispatch.Get<PFN_xrConvertTimespecTimeToTimeKHR>(
+        &XrGeneratedDispatchTable::ConvertTimespecTimeToTimeKHR)(g_instance.load(), &now, time));
+#else
+    (void)time;
+    return false;
+#endif
+}
+
+// Call with state.mutex held, for a frame xrEndFrame just finished.
+static void RecordFrameTiming(XrSession session, SessionFrameState &state, const FrameState &frame,
+                              std::chrono::steady_clock::time_point endFrameCallTime, bool hasEndFrameXrTime,
+                              XrTime endFrameXrTime) {
+    FrameTimingSample sample;
+    sample.frameIndex = frame.frameIndex;
+    sample.predictedDisplayTime = frame.predictedDisplayTime;
+    sample.predictedDisplayPeriod = frame.predictedDisplayPeriod;
+    sample.waitBlocked = Nanoseconds(frame.waitFrameReturnTime - frame.waitFrameCallTime);
+    sample.appCpu = Nanoseconds(endFrameCallTime - frame.waitFrameReturnTime);
+    sample.beginToEnd = Nanoseconds(endFrameCallTime - frame.beginFrameCallTime);
+    sample.hasDisplayLead = hasEndFrameXrTime;
+    sample.displayLead = hasEndFrameXrTime ? frame.predictedDisplayTime - endFrameXrTime : 0;
+    // Display periods skipped since the last frame, rounding to the nearest period to allow for jitter.
+    if (state.lastTimedPDT != 0 && frame.predictedDisplayPeriod > 0 && frame.predictedDisplayTime > state.lastTimedPDT) {
+        const XrDuration periods =
+            (frame.predictedDisplayTime - state.lastTimedPDT + frame.predictedDisplayPeriod / 2) / frame.predictedDisplayPeriod;
+        sample.missedFrames = periods > 1 ? static_cast<uint32_t>(periods - 1) : 0;
+    }
+    state.lastTimedPDT = frame.predictedDisplayTime;
+
+    state.timingInterval.Add(sample);
+    state.timingTotal.Add(sample);
+    FrameTimingExportFrame(session, sample);
+
+    const uint32_t summaryInterval = GetFrameTimingSettings().summaryInterval;
+    if (summaryInterval != 0 && state.timingInterval.FrameCount() >= summaryInterval) {
+        BPLogger::LogInfo("Frame timing for session " + HandleToHexString(session) + ": " + state.timingInterval.Summary());
+        state.timingInterval.Reset();
+    }
+}
+
 XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrWaitFrame(XrSession session, const XrFrameWaitInfo *frameWaitInfo,
                                                              XrFrameState *frameState) {
     XrResult result = XR_SUCCESS;
+    SessionFrameState &state = GetSessionFrameState(session);
     {
-        std::unique_lock<std::mutex> frameLock(g_frameMutex);
+        std::unique_lock<std::mutex> frameLock(state.mutex);
+        FrameRing &framesInFlight = state.framesInFlight;
 
         // Remove any invalid frames that were created just because xrWaitFrame failed and the application tried again immediately.
-        for (auto it = g_framesInFlight.begin(); it != g_framesInFlight.end();) {
-            if (it->waitFrameCalled && it->waitFrameResult != XR_SUCCESS && !it->beginFrameCalled) {
-                it = g_framesInFlight.erase(it);
-            } else {
-                ++it;
-            }
-        }
+        framesInFlight.remove_if([](const FrameState &frame) {
+            return frame.waitFrameCalled && frame.waitFrameResult != XR_SUCCESS && !frame.beginFrameCalled;
+        });
 
-        if (g_framesInFlight.size() > 0) {
-            FrameState &frontFrame = g_framesInFlight.front();
+        if (framesInFlight.size() > 0) {
+            FrameState &frontFrame = framesInFlight.front();
             // If the frame in front failed xrBeginFrame, we can assume it's on it's way to be an invalid frame. Reset
             // beginFrameCalled so it can be easily cleaned up in the next xrBeginFrame call.
             if (frontFrame.beginFrameCalled && frontFrame.beginFrameResult != XR_SUCCESS) {
                 frontFrame.beginFrameCalled = false;
             } else if (!frontFrame.beginFrameCalled) {
-                BPLogger::LogMessage(
-                    "xrWaitFrame was called twice in a row, the last xrWaitFrame was not followed by a xrBeginFrame.");
+                BPLogger::LogMessage(BPMessageId::WaitFrameCalledTwice,
+                                     "xrWaitFrame was called twice in a row, the last xrWaitFrame was not followed by a "
+                                     "xrBeginFrame.");
             }
         }
 
@@ -120,20 +281,26 @@ XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrWaitFrame(XrSession session,
         newFrameState.beginFrameResult = XR_SUCCESS;
         newFrameState.endFrameResult = XR_SUCCESS;
 
-        newFrameState.frameIndex = ++g_frameIndex;
+        newFrameState.frameIndex = ++state.frameIndex;
 
-        g_framesInFlight.push_back(newFrameState);
+        framesInFlight.push_back(newFrameState);
+        UpdateFrontWaited(state);
     }
 
+    const auto waitFrameCallTime = std::chrono::steady_clock::now();
     result = g_nextDispatch.Get<PFN_xrWaitFrame>(&XrGeneratedDispatchTable::WaitFrame)(session, frameWaitInfo, frameState);
+    const auto waitFrameReturnTime = std::chrono::steady_clock::now();
     {
-        std::unique_lock<std::mutex> frameLock(g_frameMutex);
+        std::unique_lock<std::mutex> frameLock(state.mutex);
 
-        FrameState &currentFrameState = g_framesInFlight.back();
+        FrameState &currentFrameState = state.framesInFlight.back();
         currentFrameState.waitFrameCalled = true;
         currentFrameState.waitFrameResult = result;
         currentFrameState.predictedDisplayTime = frameState->predictedDisplayTime;
         currentFrameState.predictedDisplayPeriod = frameState->predictedDisplayPeriod;
+        currentFrameState.waitFrameCallTime = waitFrameCallTime;
+        currentFrameState.waitFrameReturnTime = waitFrameReturnTime;
+        UpdateFrontWaited(state);
     }
 
     return result;
@@ -141,47 +308,58 @@ XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrWaitFrame(XrSession session,
 
 XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrBeginFrame(XrSession session, const XrFrameBeginInfo *frameBeginInfo) {
     XrResult result = XR_SUCCESS;
+    SessionFrameState &state = GetSessionFrameState(session);
     {
-        std::unique_lock<std::mutex> frameLock(g_frameMutex);
+        std::unique_lock<std::mutex> frameLock(state.mutex);
+        FrameRing &framesInFlight = state.framesInFlight;
 
-        if (g_framesInFlight.empty()) {
-            BPLogger::LogMessage("There are no frames in queue. XrWaitFrame has not been called");
+        if (framesInFlight.empty()) {
+            BPLogger::LogMessage(BPMessageId::BeginFrameWithoutFramesInFlight,
+                                 "There are no frames in queue. XrWaitFrame has not been called");
+            return g_nextDispatch.Get<PFN_xrBeginFrame>(&XrGeneratedDispatchTable::BeginFrame)(session, frameBeginInfo);
         }
 
-        FrameState &currentFrameState = g_framesInFlight.front();
+        FrameState *currentFrameState = &framesInFlight.front();
 
-        if (currentFrameState.beginFrameCalled) {
-            if (currentFrameState.beginFrameResult >= XR_SUCCESS) {
+        if (currentFrameState->beginFrameCalled) {
+            if (currentFrameState->beginFrameResult >= XR_SUCCESS) {
                 // Failure case where xrEndFrame from the last frame was not successful, but everything else was.
-                if (!currentFrameState.endFrameCalled || currentFrameState.endFrameResult != XR_SUCCESS) {
-                    BPLogger::LogMessage(
-                        "xrEndFrame was not successful for the previous frame. This xrBeginFrame is for a new frame.");
-                    g_framesInFlight.pop_front();
-                    if (g_framesInFlight.size() > 0) currentFrameState = g_framesInFlight.front();
+                if (!currentFrameState->endFrameCalled || currentFrameState->endFrameResult != XR_SUCCESS) {
+                    BPLogger::LogMessage(BPMessageId::BeginFrameAfterFailedEndFrame,
+                                         "xrEndFrame was not successful for the previous frame. This xrBeginFrame is for a new "
+                                         "frame.");
+                    if (framesInFlight.size() > 1) {
+                        framesInFlight.pop_front();
+                        currentFrameState = &framesInFlight.front();
+                    }
                 }
             } else {
                 // Application is retrying xrBeginFrame and frame state may still be valid if this call succeeds.
-                BPLogger::LogMessage(
-                    "Application is retrying xrBeginFrame after a previous failure. Consider calling xrWaitFrame to start a new "
-                    "frame instead");
+                BPLogger::LogMessage(BPMessageId::BeginFrameRetried,
+                                     "Application is retrying xrBeginFrame after a previous failure. Consider calling "
+                                     "xrWaitFrame to start a new frame instead");
             }
         } else {
             // beginFrameCalled being false but having a failure result means this frame was reset in xrWaitFrame for being invalid,
             // remove it here.
-            if (currentFrameState.beginFrameResult != XR_SUCCESS) {
-                g_framesInFlight.pop_front();
-                if (g_framesInFlight.size() > 0) currentFrameState = g_framesInFlight.front();
+            if (currentFrameState->beginFrameResult != XR_SUCCESS && framesInFlight.size() > 1) {
+                framesInFlight.pop_front();
+                currentFrameState = &framesInFlight.front();
             }
         }
+        UpdateFrontWaited(state);
 
-        if (!currentFrameState.waitFrameCalled || currentFrameState.waitFrameResult != XR_SUCCESS) {
-            BPLogger::LogMessage("XrWaitFrame was not called or failed for frame " + std::to_string(currentFrameState.frameIndex));
+        if (!currentFrameState->waitFrameCalled || currentFrameState->waitFrameResult != XR_SUCCESS) {
+            BPLogger::LogFormattedMessage(BPMessageId::BeginFrameWithoutWaitFrame, [&] {
+                return "XrWaitFrame was not called or failed for frame " + std::to_string(currentFrameState->frameIndex);
+            });
         }
 
+        currentFrameState->beginFrameCallTime = std::chrono::steady_clock::now();
         result = g_nextDispatch.Get<PFN_xrBeginFrame>(&XrGeneratedDispatchTable::BeginFrame)(session, frameBeginInfo);
 
-        currentFrameState.beginFrameResult = result;
-        currentFrameState.beginFrameCalled = true;
+        currentFrameState->beginFrameResult = result;
+        currentFrameState->beginFrameCalled = true;
     }
 
     return result;
@@ -198,81 +376,131 @@ XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrEndFrame(XrSession session, c
             }
         }
         if (!sourceAlphaSet) {
-            BPLogger::LogMessage(
-                "Environment Blend Mode was set to XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND but no layer has "
-                "XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT set. Either add "
-                "XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT or do not use XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND.");
+            BPLogger::LogMessage(BPMessageId::AlphaBlendWithoutAlphaLayer,
+                                 "Environment Blend Mode was set to XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND but no layer has "
+                                 "XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT set. Either add "
+                                 "XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT or do not use "
+                                 "XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND.");
         }
     }
 
+    SessionFrameState &state = GetSessionFrameState(session);
     {
-        std::unique_lock<std::mutex> frameLock(g_frameMutex);
-        FrameState &currentFrameState = g_framesInFlight.front();
+        std::unique_lock<std::mutex> frameLock(state.mutex);
+        if (state.framesInFlight.empty()) {
+            BPLogger::LogMessage(BPMessageId::EndFrameWithoutFramesInFlight,
+                                 "xrEndFrame was called with no frames in flight. XrWaitFrame has not been called");
+            return g_nextDispatch.Get<PFN_xrEndFrame>(&XrGeneratedDispatchTable::EndFrame)(session, frameEndInfo);
+        }
+        FrameState &currentFrameState = state.framesInFlight.front();
 
         if (!currentFrameState.waitFrameCalled || currentFrameState.waitFrameResult != XR_SUCCESS) {
-            BPLogger::LogMessage("xrWaitFrame was not called or failed before calling XrEndFrame for frame " +
-                                 std::to_string(currentFrameState.frameIndex));
+            BPLogger::LogFormattedMessage(BPMessageId::EndFrameWithoutWaitFrame, [&] {
+                return "xrWaitFrame was not called or failed before calling XrEndFrame for frame " +
+                       std::to_string(currentFrameState.frameIndex);
+            });
         }
 
         if (!currentFrameState.beginFrameCalled || currentFrameState.beginFrameResult != XR_SUCCESS) {
-            BPLogger::LogMessage("xrBeginFrame was not called or failed before calling XrEndFrame for frame " +
-                                 std::to_string(currentFrameState.frameIndex));
+            BPLogger::LogFormattedMessage(BPMessageId::EndFrameWithoutBeginFrame, [&] {
+                return "xrBeginFrame was not called or failed before calling XrEndFrame for frame " +
+                       std::to_string(currentFrameState.frameIndex);
+            });
         }
 
         if (currentFrameState.predictedDisplayTime != 0 && frameEndInfo->displayTime != currentFrameState.predictedDisplayTime) {
-            BPLogger::LogMessage("xrEndFrame was called with a different displayTime than what was obtained from xrWaitFrame.");
+            BPLogger::LogMessage(BPMessageId::EndFrameDisplayTimeMismatch,
+                                 "xrEndFrame was called with a different displayTime than what was obtained from xrWaitFrame.");
         }
 
+        // Whether a projection layer uses the poses from xrLocateViews.
+        bool projectionUsesLocatedPoses = false;
         for (uint32_t i = 0; i < frameEndInfo->layerCount; i++) {
             const XrCompositionLayerBaseHeader *layer = frameEndInfo->layers[i];
             if (layer->type == XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
                 const XrCompositionLayerProjection *projLayer = reinterpret_cast<const XrCompositionLayerProjection *>(layer);
-                for (uint32_t view = 0; view < projLayer->viewCount; view++) {
+                const uint32_t viewCount = std::min(projLayer->viewCount, kMaxFrameViews);
+                bool posesLocated = viewCount > 0;
+                for (uint32_t view = 0; view < viewCount; view++) {
                     if (projLayer->views[view].fov.angleLeft != currentFrameState.views[view].fov.angleLeft ||
                         projLayer->views[view].fov.angleRight != currentFrameState.views[view].fov.angleRight ||
                         projLayer->views[view].fov.angleDown != currentFrameState.views[view].fov.angleDown ||
                         projLayer->views[view].fov.angleUp != currentFrameState.views[view].fov.angleUp) {
-                        BPLogger::LogMessage(
-                            "xrEndFrame Projection Layer has a different FOV from what was acquired in xrLocateViews");
+                        BPLogger::LogMessage(BPMessageId::ProjectionFovMismatch,
+                                             "xrEndFrame Projection Layer has a different FOV from what was acquired in "
+                                             "xrLocateViews");
                     }
 
                     if (projLayer->views[view].fov.angleLeft == 0.0f && projLayer->views[view].fov.angleRight == 0.0f &&
                         projLayer->views[view].fov.angleDown == 0.0f && projLayer->views[view].fov.angleUp == 0.0f) {
-                        BPLogger::LogMessage("xrEndFrame Projection Layer needs to have a non-zero FOV");
+                        BPLogger::LogMessage(BPMessageId::ProjectionFovZero,
+                                             "xrEndFrame Projection Layer needs to have a non-zero FOV");
                     }
 
                     if (projLayer->views[view].pose.position.x != currentFrameState.views[view].pose.position.x ||
                         projLayer->views[view].pose.position.y != currentFrameState.views[view].pose.position.y ||
                         projLayer->views[view].pose.position.z != currentFrameState.views[view].pose.position.z) {
-                        BPLogger::LogMessage(
-                            "xrEndFrame Projection Layer has a different positional pose from what was acquired in xrLocateViews");
+                        BPLogger::LogMessage(BPMessageId::ProjectionPositionMismatch,
+                                             "xrEndFrame Projection Layer has a different positional pose from what was acquired "
+                                             "in xrLocateViews");
+                        posesLocated = false;
                     }
 
                     if (projLayer->views[view].pose.orientation.x != currentFrameState.views[view].pose.orientation.x ||
                         projLayer->views[view].pose.orientation.y != currentFrameState.views[view].pose.orientation.y ||
                         projLayer->views[view].pose.orientation.z != currentFrameState.views[view].pose.orientation.z ||
                         projLayer->views[view].pose.orientation.w != currentFrameState.views[view].pose.orientation.w) {
-                        BPLogger::LogMessage(
-                            "xrEndFrame Projection Layer has a different rotational pose from what was acquired in xrLocateViews");
+                        BPLogger::LogMessage(BPMessageId::ProjectionOrientationMismatch,
+                                             "xrEndFrame Projection Layer has a different rotational pose from what was acquired "
+                                             "in xrLocateViews");
+                        posesLocated = false;
                     }
                 }
+                projectionUsesLocatedPoses = projectionUsesLocatedPoses || posesLocated;
+            }
+        }
+
+        const auto endFrameCallTime = std::chrono::steady_clock::now();
+
+        // Head motion between xrLocateViews and xrEndFrame is latency the runtime has to reproject away.  Views located more
+        // than a display period before submitting the frame were most likely located before the frame's CPU work rather
+        // than just before rendering.
+        if (projectionUsesLocatedPoses && currentFrameState.viewsLocated) {
+            const int64_t poseAge = Nanoseconds(endFrameCallTime - currentFrameState.locateViewsReturnTime);
+            const XrDuration period = currentFrameState.predictedDisplayPeriod;
+            if (period > 0 && poseAge > period) {
+                BPLogger::LogFormattedMessage(BPMessageId::ProjectionPosesLocatedEarly, [&] {
+                    return "xrEndFrame Projection Layer uses views located " + std::to_string(poseAge / 1000000) +
+                           " ms before xrEndFrame, wasting about " + std::to_string((poseAge - period) / 1000000) +
+                           " ms of motion-to-photon budget. Consider calling xrLocateViews after the frame's CPU work, just "
+                           "before rendering.";
+                });
             }
         }
 
+        const bool timing = GetFrameTimingSettings().enabled;
+        XrTime endFrameXrTime = 0;
+        const bool hasEndFrameXrTime = timing && GetCurrentXrTime(&endFrameXrTime);
+
         result = g_nextDispatch.Get<PFN_xrEndFrame>(&XrGeneratedDispatchTable::EndFrame)(session, frameEndInfo);
 
         // If we get to this point, xrWaitFrame, xrBeginFrame, and xrEndFrame were all successful so we can retire this frame data.
         if (result >= XR_SUCCESS) {
-            g_framesInFlight.pop_front();
+            if (timing && currentFrameState.waitFrameCalled && currentFrameState.beginFrameCalled) {
+                RecordFrameTiming(session, state, currentFrameState, endFrameCallTime, hasEndFrameXrTime, endFrameXrTime);
+            }
+            state.framesInFlight.pop_front();
+            UpdateFrontWaited(state);
         } else {
             currentFrameState.endFrameResult = result;
-            g_lastEndFramePDT = frameEndInfo->displayTime;
+            state.lastEndFramePDT = frameEndInfo->displayTime;
         }
 
         // This is Scenario B in the xrEndFrame failure flow, if the app is retrying we warn that the frame should be discarded
         // instead.
-        if (frameEndInfo->displayTime == g_lastEndFramePDT) {
-            BPLogger::LogMessage("xrEndFrame was retried with the same display time, consider discarding the frame instead.");
+        if (frameEndInfo->displayTime == state.lastEndFramePDT) {
+            BPLogger::LogMessage(BPMessageId::EndFrameRetried,
+                                 "xrEndFrame was retried with the same display time, consider discarding the frame instead.");
         }
     }
 
@@ -281,16 +509,17 @@ XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrEndFrame(XrSession session, c
 
 XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrSyncActions(XrSession session, const XrActionsSyncInfo *syncInfo) {
     XrResult result = XR_SUCCESS;
+    SessionFrameState &state = GetSessionFrameState(session);
     {
         bool syncCalledBeforeWait = false;
-        std::unique_lock<std::mutex> frameLock(g_frameMutex);
+        std::unique_lock<std::mutex> frameLock(state.mutex);
 
-        if (g_framesInFlight.empty()) {
+        if (state.framesInFlight.empty()) {
             // If there are no frames in flight, xrSyncActions was called outside the frame loop which is probably before
             // xrWaitFrame.
             syncCalledBeforeWait = true;
         } else {
-            FrameState &currentFrameState = g_framesInFlight.front();
+            FrameState &currentFrameState = state.framesInFlight.front();
             // In a pipelined system, if we begin frame N but get a call to XrSyncActions after the fact, it's probably for frame
             // N+1 which hasn't even had xrWaitFrame called which is too early.
             if (currentFrameState.waitFrameCalled && currentFrameState.waitFrameResult >= XR_SUCCESS &&
@@ -299,24 +528,26 @@ XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrSyncActions(XrSession session
             }
 
             if (currentFrameState.syncActionsSucceeded) {
-                BPLogger::LogMessage(
-                    "xrSyncActions was called multiple times in the frame. It's best practice to avoid unnecessary extra calls.");
+                BPLogger::LogMessage(BPMessageId::SyncActionsCalledTwice,
+                                     "xrSyncActions was called multiple times in the frame. It's best practice to avoid "
+                                     "unnecessary extra calls.");
             }
         }
 
         if (syncCalledBeforeWait) {
-            BPLogger::LogMessage(
-                "xrSyncActions was called between xrBeginFrame and xrEndFrame. If this is before next frame's xrWaitFrame, "
-                "consider doing it after.");
+            BPLogger::LogMessage(BPMessageId::SyncActionsInFrame,
+                                 "xrSyncActions was called between xrBeginFrame and xrEndFrame. If this is before next frame's "
+                                 "xrWaitFrame, consider doing it after.");
         }
     }
 
     result = g_nextDispatch.Get<PFN_xrSyncActions>(&XrGeneratedDispatchTable::SyncActions)(session, syncInfo);
 
-    if (result == XR_SUCCESS && !g_framesInFlight.empty()) {
-        std::unique_lock<std::mutex> frameLock(g_frameMutex);
-        FrameState &currentFrameState = g_framesInFlight.front();
-        currentFrameState.syncActionsSucceeded = true;
+    if (result == XR_SUCCESS) {
+        std::unique_lock<std::mutex> frameLock(state.mutex);
+        if (!state.framesInFlight.empty()) {
+            state.framesInFlight.front().syncActionsSucceeded = true;
+        }
     }
     return result;
 }
@@ -324,26 +555,11 @@ XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrSyncActions(XrSession session
 XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time,
                                                                XrSpaceLocation *location) {
     XrResult result = XR_SUCCESS;
-    {
-        bool locateCalledBeforeWait = false;
-        std::unique_lock<std::mutex> frameLock(g_frameMutex);
-
-        if (g_framesInFlight.empty()) {
-            // If there are no frames in flight, xrSyncActions was called outside the frame loop which is probably before
-            // xrWaitFrame.
-            locateCalledBeforeWait = true;
-        } else {
-            FrameState &currentFrameState = g_framesInFlight.front();
-            if (!currentFrameState.waitFrameCalled) {
-                locateCalledBeforeWait = true;
-            }
-        }
-
-        if (locateCalledBeforeWait) {
-            BPLogger::LogMessage(
-                "xrLocateSpace was called before xrWaitFrame. It's best practice to call xrLocateSpace after xrWaitFrame to have "
-                "more accurate tracking data.");
-        }
+    // No session has a frame in flight that has been through xrWaitFrame.
+    if (g_sessionsWaited.load(std::memory_order_relaxed) == 0) {
+        BPLogger::LogMessage(BPMessageId::LocateSpaceBeforeWaitFrame,
+                             "xrLocateSpace was called before xrWaitFrame. It's best practice to call xrLocateSpace after "
+                             "xrWaitFrame to have more accurate tracking data.");
     }
 
     result = g_nextDispatch.Get<PFN_xrLocateSpace>(&XrGeneratedDispatchTable::LocateSpace)(space, baseSpace, time, location);
@@ -355,29 +571,59 @@ XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrLocateViews(XrSession session
                                                                XrViewState *viewState, uint32_t viewCapacityInput,
                                                                uint32_t *viewCountOutput, XrView *views) {
     XrResult result = XR_SUCCESS;
-    if (!g_framesInFlight.empty()) {
-        std::unique_lock<std::mutex> frameLock(g_frameMutex);
-        FrameState &currentFrameState = g_framesInFlight.front();
-        if (currentFrameState.predictedDisplayTime != 0 && viewLocateInfo->displayTime != currentFrameState.predictedDisplayTime) {
-            BPLogger::LogMessage("xrLocateViews was called with a different displayTime than what was obtained from xrWaitFrame.");
+    SessionFrameState &state = GetSessionFrameState(session);
+    {
+        std::unique_lock<std::mutex> frameLock(state.mutex);
+        if (!state.framesInFlight.empty()) {
+            FrameState &currentFrameState = state.framesInFlight.front();
+            if (currentFrameState.predictedDisplayTime != 0 &&
+                viewLocateInfo->displayTime != currentFrameState.predictedDisplayTime) {
+                BPLogger::LogMessage(BPMessageId::LocateViewsDisplayTimeMismatch,
+                                     "xrLocateViews was called with a different displayTime than what was obtained from "
+                                     "xrWaitFrame.");
+            }
         }
     }
 
     result = g_nextDispatch.Get<PFN_xrLocateViews>(&XrGeneratedDispatchTable::LocateViews)(
         session, viewLocateInfo, viewState, viewCapacityInput, viewCountOutput, views);
 
-    if (!g_framesInFlight.empty()) {
-        if (viewCapacityInput != 0) {
-            std::unique_lock<std::mutex> frameLock(g_frameMutex);
-            FrameState &currentFrameState = g_framesInFlight.front();
-            for (uint32_t i = 0; i < viewCapacityInput; i++) {
+    std::unique_lock<std::mutex> frameLock(state.mutex);
+    if (!state.framesInFlight.empty()) {
+        if (viewCapacityInput != 0 && XR_SUCCEEDED(result)) {
+            FrameState &currentFrameState = state.framesInFlight.front();
+            const uint32_t viewCount = std::min({viewCapacityInput, *viewCountOutput, kMaxFrameViews});
+            for (uint32_t i = 0; i < viewCount; i++) {
                 currentFrameState.views[i] = views[i];
             }
+            currentFrameState.viewsLocated = true;
+            currentFrameState.locateViewsReturnTime = std::chrono::steady_clock::now();
         }
     } else {
-        BPLogger::LogMessage(
-            "xrLocateViews was called before xrWaitFrame with no frames in flight. Consider making the call between xrBeginFrame "
-            "and xrEndFrame.");
+        BPLogger::LogMessage(BPMessageId::LocateViewsBeforeWaitFrame,
+                             "xrLocateViews was called before xrWaitFrame with no frames in flight. Consider making the call "
+                             "between xrBeginFrame and xrEndFrame.");
+    }
+    return result;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL BestPracticesLayerXrDestroySession(XrSession session) {
+    XrResult result = g_nextDispatch.Get<PFN_xrDestroySession>(&XrGeneratedDispatchTable::DestroySession)(session);
+    if (XR_SUCCEEDED(result)) {
+        std::unique_lock<std::mutex> lock(g_sessionFrameStatesMutex);
+        auto it = g_sessionFrameStates.find(session);
+        if (it != g_sessionFrameStates.end()) {
+            if (it->second->frontWaited) {
+                g_sessionsWaited.fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (GetFrameTimingSettings().enabled) {
+                const FrameTimingStats &total = it->second->timingTotal;
+                BPLogger::LogInfo("Frame timing for destroyed session " + HandleToHexString(session) + ": " + total.Summary());
+                FrameTimingExportSession(session, total);
+            }
+            g_sessionFrameStateRegistry.Erase(session);
+            g_sessionFrameStates.erase(it);
+        }
     }
     return result;
 }
@@ -442,8 +688,28 @@ XRAPI_ATTR XrResult XRAPI_CALL BestPracticesXrCreateApiLayerInstance(const XrIns
 
         g_nextDispatch.Reset(std::move(next_dispatch));
 
-        g_frameIndex = 0;
-        g_lastEndFramePDT = 0;
+        bool canConvertTime = false;
+        for (uint32_t i = 0; i < info->enabledExtensionCount; ++i) {
+#if defined(XR_USE_PLATFORM_WIN32)
+            const char *const convertTimeExtension = XR_KHR_WIN32_CONVERT_PERFORMANCE_COUNTER_TIME_EXTENSION_NAME;
+#elif defined(XR_USE_TIMESPEC)
+            const char *const convertTimeExtension = XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME;
+#else
+            const char *const convertTimeExtension = "";
+#endif
+            if (0 == strcmp(info->enabledExtensionNames[i], convertTimeExtension)) {
+                canConvertTime = true;
+            }
+        }
+        g_instance.store(returned_instance);
+        g_canConvertTime.store(XR_SUCCEEDED(next_result) && canConvertTime);
+
+        {
+            std::unique_lock<std::mutex> lock(g_sessionFrameStatesMutex);
+            g_sessionFrameStateRegistry.EraseIf([](XrSession, SessionFrameState *, uint64_t) { return true; });
+            g_sessionFrameStates.clear();
+            g_sessionsWaited.store(0);
+        }
 
         return next_result;
 
@@ -513,5 +779,8 @@ PFN_xrVoidFunction BestPracticesLayerInnerGetInstanceProcAddr(const char *name)
     if (func_name == "xrLocateViews") {
         return reinterpret_cast<PFN_xrVoidFunction>(BestPracticesLayerXrLocateViews);
     }
+    if (func_name == "xrDestroySession") {
+        return reinterpret_cast<PFN_xrVoidFunction>(BestPracticesLayerXrDestroySession);
+    }
     return nullptr;
 }
@@ -0,0 +1,229 @@
+// Copyright (c) 2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "frame_timing.h"
+
+#include "hex_and_handles.h"
+#include "platform_utils.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+static std::string GetFrameTimingSetting(const char *envName, const char *androidProperty) {
+#if !defined(XR_OS_ANDROID)
+    (void)androidProperty;
+    return PlatformUtilsGetEnv(envName);
+#else
+    (void)envName;
+    return PlatformUtilsGetAndroidSystemProperty(androidProperty);
+#endif
+}
+
+const FrameTimingSettings &GetFrameTimingSettings() {
+    static const FrameTimingSettings settings = [] {
+        FrameTimingSettings loaded;
+        const std::string enabled =
+            GetFrameTimingSetting("XR_BEST_PRACTICES_FRAME_TIMING", "debug.best_practices_frame_timing");
+        loaded.enabled = !enabled.empty() && enabled != "0";
+        const std::string interval =
+            GetFrameTimingSetting("XR_BEST_PRACTICES_FRAME_TIMING_INTERVAL", "debug.best_practices_frame_timing_interval");
+        if (!interval.empty()) {
+            loaded.summaryInterval = static_cast<uint32_t>(std::strtoul(interval.c_str(), nullptr, 10));
+        }
+        loaded.exportFile =
+            GetFrameTimingSetting("XR_BEST_PRACTICES_FRAME_TIMING_FILE", "debug.best_practices_frame_timing_file");
+        return loaded;
+    }();
+    return settings;
+}
+
+static std::string Milliseconds(int64_t nanoseconds) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2) << static_cast<double>(nanoseconds) / 1000000.0;
+    return oss.str();
+}
+
+int FrameTimingStats::HistogramBucket(int64_t displayLead) {
+    if (displayLead < HistogramMin()) {
+        return 0;
+    }
+    const int64_t bucket = 1 + (displayLead - HistogramMin()) / HistogramBucketWidth();
+    return static_cast<int>(std::min<int64_t>(bucket, kHistogramBucketCount - 1));
+}
+
+void FrameTimingStats::Add(const FrameTimingSample &sample) {
+    ++m_frameCount;
+    m_appCpuTotal += sample.appCpu;
+    m_appCpuMax = std::max(m_appCpuMax, sample.appCpu);
+    m_waitBlockedTotal += sample.waitBlocked;
+    m_waitBlockedMax = std::max(m_waitBlockedMax, sample.waitBlocked);
+    m_missedFrames += sample.missedFrames;
+    if (sample.hasDisplayLead) {
+        ++m_displayLeadCount;
+        if (sample.displayLead < 0) {
+            ++m_lateFrames;
+        }
+        ++m_histogram[HistogramBucket(sample.displayLead)];
+    }
+}
+
+std::string FrameTimingStats::Summary() const {
+    if (m_frameCount == 0) {
+        return "no frames";
+    }
+    std::ostringstream oss;
+    oss << m_frameCount << " frames, app CPU avg " << Milliseconds(m_appCpuTotal / m_frameCount) << " ms max "
+        << Milliseconds(m_appCpuMax) << " ms, xrWaitFrame blocked avg " << Milliseconds(m_waitBlockedTotal / m_frameCount)
+        << " ms max " << Milliseconds(m_waitBlockedMax) << " ms, " << m_missedFrames << " missed frames";
+    if (m_displayLeadCount == 0) {
+        oss << ", xrEndFrame time vs predictedDisplayTime unknown (no time conversion extension enabled)";
+        return oss.str();
+    }
+    oss << ", " << m_lateFrames << " frames ended after their predictedDisplayTime, xrEndFrame ms before display:";
+    for (int bucket = 0; bucket < kHistogramBucketCount; ++bucket) {
+        if (m_histogram[bucket] == 0) {
+            continue;
+        }
+        if (bucket == 0) {
+            oss << " <" << Milliseconds(HistogramMin());
+        } else {
+            oss << " " << Milliseconds(HistogramMin() + (bucket - 1) * HistogramBucketWidth());
+            oss << (bucket == kHistogramBucketCount - 1 ? "+" : "");
+        }
+        oss << ":" << m_histogram[bucket];
+    }
+    return oss.str();
+}
+
+std::string FrameTimingStats::Json() const {
+    std::ostringstream oss;
+    oss << "{\"frames\":" << m_frameCount << ",\"app_cpu_total_ns\":" << m_appCpuTotal << ",\"app_cpu_max_ns\":" << m_appCpuMax
+        << ",\"wait_blocked_total_ns\":" << m_waitBlockedTotal << ",\"wait_blocked_max_ns\":" << m_waitBlockedMax
+        << ",\"missed_frames\":" << m_missedFrames << ",\"display_lead_frames\":" << m_displayLeadCount
+        << ",\"late_frames\":" << m_lateFrames << ",\"display_lead_histogram\":{\"min_ns\":" << HistogramMin()
+        << ",\"bucket_width_ns\":" << HistogramBucketWidth() << ",\"counts\":[";
+    for (int bucket = 0; bucket < kHistogramBucketCount; ++bucket) {
+        oss << (bucket == 0 ? "" : ",") << m_histogram[bucket];
+    }
+    oss << "]}}";
+    return oss.str();
+}
+
+namespace {
+
+// The export file, shared by all sessions.  Only used when an export file is set, so the lock is not taken otherwise.
+class FrameTimingExporter {
+   public:
+    ~FrameTimingExporter() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_file.is_open() && m_json) {
+            m_file << "\n],\"sessions\":[";
+            for (size_t index = 0; index < m_sessions.size(); ++index) {
+                m_file << (index == 0 ? "\n" : ",\n") << m_sessions[index];
+            }
+            m_file << "\n]}\n";
+        }
+    }
+
+    void Frame(XrSession session, const FrameTimingSample &sample) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!Open()) {
+            return;
+        }
+        if (m_json) {
+            m_file << (m_frameWritten ? ",\n" : "\n") << "{\"session\":\"" << ToHexChars(session).text
+                   << "\",\"frame\":" << sample.frameIndex << ",\"predicted_display_time\":" << sample.predictedDisplayTime
+                   << ",\"predicted_display_period_ns\":" << sample.predictedDisplayPeriod
+                   << ",\"wait_blocked_ns\":" << sample.waitBlocked << ",\"app_cpu_ns\":" << sample.appCpu
+                   << ",\"begin_to_end_ns\":" << sample.beginToEnd << ",\"display_lead_ns\":";
+            if (sample.hasDisplayLead) {
+                m_file << sample.displayLead;
+            } else {
+                m_file << "null";
+            }
+            m_file << ",\"missed_frames\":" << sample.missedFrames << "}";
+        } else {
+            m_file << ToHexChars(session).text << "," << sample.frameIndex << "," << sample.predictedDisplayTime << ","
+                   << sample.predictedDisplayPeriod << "," << sample.waitBlocked << "," << sample.appCpu << ","
+                   << sample.beginToEnd << ",";
+            if (sample.hasDisplayLead) {
+                m_file << sample.displayLead;
+            }
+            m_file << "," << sample.missedFrames << "\n";
+        }
+        m_frameWritten = true;
+    }
+
+    void Session(XrSession session, const FrameTimingStats &total) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!Open()) {
+            return;
+        }
+        if (m_json) {
+            m_sessions.push_back("{\"session\":\"" + HandleToHexString(session) + "\",\"total\":" + total.Json() + "}");
+        }
+        m_file.flush();
+    }
+
+   private:
+    // Call with m_mutex held.
+    bool Open() {
+        if (m_file.is_open()) {
+            return true;
+        }
+        const std::string &fileName = GetFrameTimingSettings().exportFile;
+        if (fileName.empty() || m_openFailed) {
+            return false;
+        }
+        m_file.open(fileName, std::ios::out | std::ios::trunc);
+        if (!m_file.is_open()) {
+            m_openFailed = true;
+            LogPlatformUtilsError("Best practices layer could not open frame timing file " + fileName);
+            return false;
+        }
+        const std::string jsonSuffix = ".json";
+        m_json = fileName.size() >= jsonSuffix.size() &&
+                 fileName.compare(fileName.size() - jsonSuffix.size(), jsonSuffix.size(), jsonSuffix) == 0;
+        if (m_json) {
+            m_file << "{\"frames\":[";
+        } else {
+            m_file << "session,frame,predicted_display_time,predicted_display_period_ns,wait_blocked_ns,app_cpu_ns,"
+                      "begin_to_end_ns,display_lead_ns,missed_frames\n";
+        }
+        return true;
+    }
+
+    std::mutex m_mutex;
+    std::ofstream m_file;
+    bool m_openFailed = false;
+    bool m_json = false;
+    bool m_frameWritten = false;
+    std::vector<std::string> m_sessions;
+};
+
+FrameTimingExporter &GetFrameTimingExporter() {
+    static FrameTimingExporter exporter;
+    return exporter;
+}
+
+}  // namespace
+
+void FrameTimingExportFrame(XrSession session, const FrameTimingSample &sample) {
+    if (GetFrameTimingSettings().exportFile.empty()) {
+        return;
+    }
+    GetFrameTimingExporter().Frame(session, sample);
+}
+
+void FrameTimingExportSession(XrSession session, const FrameTimingStats &total) {
+    if (GetFrameTimingSettings().exportFile.empty()) {
+        return;
+    }
+    GetFrameTimingExporter().Session(session, total);
+}
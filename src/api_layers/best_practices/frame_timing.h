@@ -0,0 +1,76 @@
+// Copyright (c) 2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <cstdint>
+#include <string>
+
+// Frame pacing statistics, collected by the best practices layer when XR_BEST_PRACTICES_FRAME_TIMING is set.
+struct FrameTimingSettings {
+    bool enabled = false;
+    // Frames between the summaries logged for each session, 0 for a summary only when the session is destroyed.
+    uint32_t summaryInterval = 500;
+    // Per frame records are written here, as JSON if the name ends in ".json" and as CSV otherwise.
+    std::string exportFile;
+};
+
+const FrameTimingSettings &GetFrameTimingSettings();
+
+// Timing of one frame, from its xrWaitFrame call to its xrEndFrame call.  Durations are in nanoseconds.
+struct FrameTimingSample {
+    uint32_t frameIndex = 0;
+    XrTime predictedDisplayTime = 0;
+    XrDuration predictedDisplayPeriod = 0;
+    // Time spent in xrWaitFrame.
+    int64_t waitBlocked = 0;
+    // Time from xrWaitFrame returning to xrEndFrame being called: the CPU time the application took for the frame.
+    int64_t appCpu = 0;
+    // Time from xrBeginFrame being called to xrEndFrame being called.
+    int64_t beginToEnd = 0;
+    // predictedDisplayTime minus the time xrEndFrame was called, negative for a frame submitted too late.  Only known
+    // when the application enabled an extension to convert the time of the system clock to XrTime.
+    bool hasDisplayLead = false;
+    int64_t displayLead = 0;
+    // Display periods skipped between the previous frame's predictedDisplayTime and this one.
+    uint32_t missedFrames = 0;
+};
+
+class FrameTimingStats {
+   public:
+    // The histogram of display leads has 2 ms buckets from -8 ms to 40 ms, plus one bucket on either side.
+    static int64_t HistogramBucketWidth() { return 2000000; }
+    static int64_t HistogramMin() { return -8000000; }
+    static const int kHistogramBucketCount = 26;
+
+    void Add(const FrameTimingSample &sample);
+    void Reset() { *this = FrameTimingStats{}; }
+    uint32_t FrameCount() const { return m_frameCount; }
+
+    // One line summary, e.g. for the log.
+    std::string Summary() const;
+    // The same summary as a JSON object.
+    std::string Json() const;
+
+   private:
+    static int HistogramBucket(int64_t displayLead);
+
+    uint32_t m_frameCount = 0;
+    int64_t m_appCpuTotal = 0;
+    int64_t m_appCpuMax = 0;
+    int64_t m_waitBlockedTotal = 0;
+    int64_t m_waitBlockedMax = 0;
+    uint32_t m_missedFrames = 0;
+    uint32_t m_displayLeadCount = 0;
+    uint32_t m_lateFrames = 0;
+    uint32_t m_histogram[kHistogramBucketCount] = {};
+};
+
+// Append a frame to the export file, if there is one.
+void FrameTimingExportFrame(XrSession session, const FrameTimingSample &sample);
+
+// Record the totals of a destroyed session; in the JSON export they are written after the frames.
+void FrameTimingExportSession(XrSession session, const FrameTimingStats &total);
@@ -7,5 +7,8 @@
 
 void LockedDispatchTable::Reset(std::unique_ptr<XrGeneratedDispatchTable> &&newTable) {
     std::unique_lock<std::mutex> lock{m_mutex};
-    m_dispatch = std::move(newTable);
+    m_current.store(newTable.get(), std::memory_order_release);
+    if (newTable) {
+        m_tables.push_back(std::move(newTable));
+    }
 }
@@ -7,16 +7,21 @@
 
 #include <xr_generated_dispatch_table.h>
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <iostream>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 #ifdef __ANDROID__
 #include "android/log.h"
 #endif
 
+// The next dispatch table of the layer's instance.  Calls read it without a lock, as the layers' handle registries
+// do for their per-handle tables: a replaced table is kept until the layer is unloaded, so a call that read it just
+// before the replacement can still use it.
 class LockedDispatchTable {
    public:
     LockedDispatchTable() = default;
@@ -27,49 +32,98 @@ class LockedDispatchTable {
 
     template <typename PFN>
     PFN Get(PFN(XrGeneratedDispatchTable::*p)) {
-        std::unique_lock<std::mutex> lock{m_mutex};
-        return m_dispatch.get()->*p;
+        return m_current.load(std::memory_order_acquire)->*p;
     }
 
-    bool isValid() { return m_dispatch.get() != nullptr; }
+    bool isValid() { return m_current.load(std::memory_order_acquire) != nullptr; }
 
    private:
-    std::unique_ptr<XrGeneratedDispatchTable> m_dispatch{};
+    std::atomic<XrGeneratedDispatchTable*> m_current{nullptr};
     std::mutex m_mutex;
+    std::vector<std::unique_ptr<XrGeneratedDispatchTable>> m_tables{};  // Every table set, guarded by m_mutex
+};
+
+// One id per best practice check, so that a check firing every frame is counted without hashing or building its message.
+enum class BPMessageId : uint32_t {
+    WaitFrameCalledTwice,
+    BeginFrameWithoutFramesInFlight,
+    BeginFrameAfterFailedEndFrame,
+    BeginFrameRetried,
+    BeginFrameWithoutWaitFrame,
+    AlphaBlendWithoutAlphaLayer,
+    EndFrameWithoutFramesInFlight,
+    EndFrameWithoutWaitFrame,
+    EndFrameWithoutBeginFrame,
+    EndFrameDisplayTimeMismatch,
+    ProjectionFovMismatch,
+    ProjectionFovZero,
+    ProjectionPositionMismatch,
+    ProjectionOrientationMismatch,
+    ProjectionPosesLocatedEarly,
+    EndFrameRetried,
+    SyncActionsCalledTwice,
+    SyncActionsInFrame,
+    LocateSpaceBeforeWaitFrame,
+    LocateViewsDisplayTimeMismatch,
+    LocateViewsBeforeWaitFrame,
+    Count,
 };
 
 class BPLogger {
    public:
-    static void LogMessage(const std::string& message) {
-        bool printError = false;
-        if (errorCounts.find(message) != errorCounts.end()) {
-            if (errorCounts[message] < 10) {
-                printError = true;
-            } else if (errorCounts[message] % 1000 == 0) {
+    // The first kWrittenOccurrences of each check are written, then one note every kNoteInterval occurrences.
+    static constexpr uint32_t kWrittenOccurrences = 10;
+    static constexpr uint32_t kNoteInterval = 1000;
+
+    static void LogMessage(BPMessageId id, const char* message) {
+        const uint32_t occurrence = Count(id);
+        if (occurrence < kWrittenOccurrences) {
+            Write(message);
+        } else if (occurrence % kNoteInterval == 0) {
+            WriteLimited(message, occurrence);
+        }
+    }
+
+    // For messages with values in them: makeMessage() returns the message, and is only called if it is written.
+    template <typename MakeMessage>
+    static void LogFormattedMessage(BPMessageId id, MakeMessage&& makeMessage) {
+        const uint32_t occurrence = Count(id);
+        if (occurrence < kWrittenOccurrences) {
+            Write(makeMessage());
+        } else if (occurrence % kNoteInterval == 0) {
+            WriteLimited(makeMessage(), occurrence);
+        }
+    }
+
+    // For reports the user asked for, such as frame timing summaries: always written, to stderr as well.
+    static void LogInfo(const std::string& message) {
+        std::cerr << message << std::endl;
 #if defined(XR_OS_WINDOWS)
-                OutputDebugStringA(
-                    (message + " (Limiting further occurrences [" + std::to_string(errorCounts[message]) + "])\n").c_str());
+        OutputDebugStringA((message + "\n").c_str());
 #elif defined(XR_OS_ANDROID)
-                __android_log_write(
-                    ANDROID_LOG_ERROR, "OpenXR-BestPractices",
-                    (message + " (Limiting further occurrences [" + std::to_string(errorCounts[message]) + "])").c_str());
+        __android_log_write(ANDROID_LOG_INFO, "OpenXR-BestPractices", message.c_str());
 #endif
-            }
-            errorCounts[message]++;
-        } else {
-            errorCounts[message] = 1;
-            printError = true;
-        }
+    }
+
+   private:
+    // The number of earlier occurrences of the check.
+    static uint32_t Count(BPMessageId id) {
+        return occurrenceCounts[static_cast<uint32_t>(id)].fetch_add(1, std::memory_order_relaxed);
+    }
 
-        if (printError) {
+    static void Write(const std::string& message) {
 #if defined(XR_OS_WINDOWS)
-            OutputDebugStringA((message + "\n").c_str());
+        OutputDebugStringA((message + "\n").c_str());
 #elif defined(XR_OS_ANDROID)
-            __android_log_write(ANDROID_LOG_ERROR, "OpenXR-BestPractices", message.c_str());
+        __android_log_write(ANDROID_LOG_ERROR, "OpenXR-BestPractices", message.c_str());
+#else
+        (void)message;
 #endif
-        }
     }
 
-   private:
-    static std::unordered_map<std::string, int> errorCounts;
+    static void WriteLimited(const std::string& message, uint32_t occurrence) {
+        Write(message + " (Limiting further occurrences [" + std::to_string(occurrence) + "])");
+    }
+
+    static std::atomic<uint32_t> occurrenceCounts[static_cast<uint32_t>(BPMessageId::Count)];
 };
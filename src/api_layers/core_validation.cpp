@@ -22,6 +22,9 @@
 #include "api_layer_platform_defines.h"
 #include "extra_algorithms.h"
 #include "hex_and_handles.h"
+#include "layer_config_message.h"
+#include "layer_record_file.h"
+#include "platform_trace.hpp"
 #include "platform_utils.hpp"
 #include "validation_utils.h"
 #include "xr_generated_core_validation.hpp"
@@ -31,10 +34,16 @@
 #include <openxr/openxr_loader_negotiation.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <inttypes.h>
@@ -43,6 +52,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -61,12 +71,15 @@
 #define LAYER_EXPORT
 #endif
 
+XR_TRACE_DEFINE_PROVIDER();
+
 // Log recording information
 enum CoreValidationRecordType {
     RECORD_NONE = 0,
     RECORD_TEXT_COUT,
     RECORD_TEXT_FILE,
     RECORD_HTML_FILE,
+    RECORD_JSON_LINES,
 };
 
 struct CoreValidationRecordInfo {
@@ -77,13 +90,223 @@ struct CoreValidationRecordInfo {
 
 static CoreValidationRecordInfo g_record_info = {};
 static std::mutex g_record_mutex = {};
+static LayerRecordFile g_record_file;
+// Whether a messenger's callback may be called by several threads at once.
+static std::atomic<bool> g_concurrent_callbacks{false};
+
+// Full parameter validation of the sampled per-frame commands runs on one call in this many.
+static std::atomic<uint32_t> g_sample_rate{1};
+
+bool CoreValidationSampleCall(std::atomic<uint32_t> &call_count) {
+    const uint32_t sample_rate = g_sample_rate.load(std::memory_order_relaxed);
+    if (sample_rate <= 1) {
+        return true;
+    }
+    return call_count.fetch_add(1, std::memory_order_relaxed) % sample_rate == 0;
+}
+
+static void CoreValidationSetSampleRate(const std::string &sample_rate) {
+    unsigned long rate = std::strtoul(sample_rate.c_str(), nullptr, 10);
+    g_sample_rate.store(rate == 0 || rate > UINT32_MAX ? 1 : static_cast<uint32_t>(rate));
+}
+
+// An xrEndFrame call that is structurally the same as the last one fully validated in its session is fully validated
+// again only after this many frames.  0 or 1 validates every frame.
+static std::atomic<uint32_t> g_frame_cache_interval{0};
+
+static void CoreValidationSetFrameCache(const std::string &frame_cache) {
+    unsigned long interval = std::strtoul(frame_cache.c_str(), nullptr, 10);
+    g_frame_cache_interval.store(interval > UINT32_MAX ? 0 : static_cast<uint32_t>(interval));
+}
+
+// What the parameter validation of an xrEndFrame call depends on, besides whether its handles are still valid:
+// structure types, counts, flags, enums, handles and the types in every next chain.  Poses, fields of view, image
+// rects and times are not validated, so they are left out and may change freely between frames.
+struct FrameEndShape {
+    std::vector<uint64_t> words;
+    std::vector<XrSpace> spaces;
+    std::vector<XrSwapchain> swapchains;
+
+    void Clear() {
+        words.clear();
+        spaces.clear();
+        swapchains.clear();
+    }
+
+    void AddSpace(XrSpace space) {
+        words.push_back(MakeHandleGeneric(space));
+        spaces.push_back(space);
+    }
+
+    void AddSwapchain(XrSwapchain swapchain) {
+        words.push_back(MakeHandleGeneric(swapchain));
+        swapchains.push_back(swapchain);
+    }
+
+    // False if the chain holds a structure whose members this does not know, so the call must be fully validated.
+    bool AddNextChain(const void *next) {
+        for (auto *in = static_cast<const XrBaseInStructure *>(next); in != nullptr; in = in->next) {
+            words.push_back(in->type);
+            switch (in->type) {
+                case XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR:
+                    AddSwapchain(reinterpret_cast<const XrCompositionLayerDepthInfoKHR *>(in)->subImage.swapchain);
+                    break;
+                case XR_TYPE_COMPOSITION_LAYER_COLOR_SCALE_BIAS_KHR:
+                    break;
+                case XR_TYPE_COMPOSITION_LAYER_SETTINGS_FB:
+                    words.push_back(reinterpret_cast<const XrCompositionLayerSettingsFB *>(in)->layerFlags);
+                    break;
+                case XR_TYPE_COMPOSITION_LAYER_ALPHA_BLEND_FB: {
+                    auto *blend = reinterpret_cast<const XrCompositionLayerAlphaBlendFB *>(in);
+                    words.push_back(blend->srcFactorColor);
+                    words.push_back(blend->dstFactorColor);
+                    words.push_back(blend->srcFactorAlpha);
+                    words.push_back(blend->dstFactorAlpha);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // False if the call has a layer or structure this does not describe; such calls are always fully validated.
+    bool Build(const XrFrameEndInfo *info) {
+        if (info->next != nullptr || (info->layerCount != 0 && info->layers == nullptr)) {
+            return false;
+        }
+        words.push_back(info->environmentBlendMode);
+        words.push_back(info->layerCount);
+        for (uint32_t layer_index = 0; layer_index < info->layerCount; ++layer_index) {
+            const XrCompositionLayerBaseHeader *layer = info->layers[layer_index];
+            if (layer == nullptr) {
+                return false;
+            }
+            words.push_back(layer->type);
+            words.push_back(layer->layerFlags);
+            AddSpace(layer->space);
+            if (!AddNextChain(layer->next)) {
+                return false;
+            }
+            switch (layer->type) {
+                case XR_TYPE_COMPOSITION_LAYER_PROJECTION: {
+                    auto *projection = reinterpret_cast<const XrCompositionLayerProjection *>(layer);
+                    if (projection->views == nullptr) {
+                        return false;
+                    }
+                    words.push_back(projection->viewCount);
+                    for (uint32_t view_index = 0; view_index < projection->viewCount; ++view_index) {
+                        const XrCompositionLayerProjectionView &view = projection->views[view_index];
+                        words.push_back(view.type);
+                        AddSwapchain(view.subImage.swapchain);
+                        if (!AddNextChain(view.next)) {
+                            return false;
+                        }
+                    }
+                    break;
+                }
+                case XR_TYPE_COMPOSITION_LAYER_QUAD:
+                    AddMonoLayer(reinterpret_cast<const XrCompositionLayerQuad *>(layer));
+                    break;
+                case XR_TYPE_COMPOSITION_LAYER_CYLINDER_KHR:
+                    AddMonoLayer(reinterpret_cast<const XrCompositionLayerCylinderKHR *>(layer));
+                    break;
+                case XR_TYPE_COMPOSITION_LAYER_EQUIRECT_KHR:
+                    AddMonoLayer(reinterpret_cast<const XrCompositionLayerEquirectKHR *>(layer));
+                    break;
+                case XR_TYPE_COMPOSITION_LAYER_EQUIRECT2_KHR:
+                    AddMonoLayer(reinterpret_cast<const XrCompositionLayerEquirect2KHR *>(layer));
+                    break;
+                case XR_TYPE_COMPOSITION_LAYER_CUBE_KHR: {
+                    auto *cube = reinterpret_cast<const XrCompositionLayerCubeKHR *>(layer);
+                    words.push_back(cube->eyeVisibility);
+                    AddSwapchain(cube->swapchain);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // Layers with one image and an eye visibility.
+    template <typename Layer>
+    void AddMonoLayer(const Layer *layer) {
+        words.push_back(layer->eyeVisibility);
+        AddSwapchain(layer->subImage.swapchain);
+    }
+
+    bool HandlesValid() {
+        for (XrSpace &space : spaces) {
+            if (VALIDATE_XR_HANDLE_SUCCESS != g_space_info.verifyHandle(&space)) {
+                return false;
+            }
+        }
+        for (XrSwapchain &swapchain : swapchains) {
+            if (VALIDATE_XR_HANDLE_SUCCESS != g_swapchain_info.verifyHandle(&swapchain)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+struct FrameEndCacheEntry {
+    FrameEndShape shape;
+    bool describable{false};
+    bool validated{false};
+    uint32_t frames_since_full{0};
+};
+
+static std::mutex g_frame_end_cache_mutex;
+static std::unordered_map<XrSession, FrameEndCacheEntry> g_frame_end_cache;
+
+bool CoreValidationFrameEndUnchanged(XrSession session, const XrFrameEndInfo *frame_end_info) {
+    const uint32_t interval = g_frame_cache_interval.load(std::memory_order_relaxed);
+    if (interval <= 1 || frame_end_info == nullptr || VALIDATE_XR_HANDLE_SUCCESS != g_session_info.verifyHandle(&session)) {
+        return false;
+    }
+    // Reused across calls, so building the shape of a frame does not allocate once the vectors have grown.
+    thread_local FrameEndShape shape;
+    shape.Clear();
+    const bool describable = shape.Build(frame_end_info);
+
+    std::unique_lock<std::mutex> lock(g_frame_end_cache_mutex);
+    FrameEndCacheEntry &entry = g_frame_end_cache[session];
+    if (describable && entry.validated && entry.frames_since_full + 1 < interval && entry.shape.words == shape.words &&
+        entry.shape.HandlesValid()) {
+        ++entry.frames_since_full;
+        return true;
+    }
+    // Fully validated by the caller, which marks the shape validated if it passes.
+    std::swap(entry.shape, shape);
+    entry.describable = describable;
+    entry.validated = false;
+    entry.frames_since_full = 0;
+    return false;
+}
+
+void CoreValidationFrameEndValidated(XrSession session) {
+    std::unique_lock<std::mutex> lock(g_frame_end_cache_mutex);
+    auto it = g_frame_end_cache.find(session);
+    if (it != g_frame_end_cache.end()) {
+        it->second.validated = it->second.describable;
+    }
+}
+
+// Called during xrDestroySession.
+void CoreValidationDeleteSessionFrameCache(XrSession session) {
+    std::unique_lock<std::mutex> lock(g_frame_end_cache_mutex);
+    g_frame_end_cache.erase(session);
+}
 
 // HTML utilities
 bool CoreValidationWriteHtmlHeader() {
     try {
         std::unique_lock<std::mutex> mlock(g_record_mutex);
-        std::ofstream html_file;
-        html_file.open(g_record_info.file_name, std::ios::out);
+        std::ostream &html_file = g_record_file.Truncate(g_record_info.file_name);
         html_file << "<!doctype html>\n"
                      "<html>\n"
                      "    <head>\n"
@@ -204,11 +427,11 @@ bool CoreValidationWriteHtmlHeader() {
 bool CoreValidationWriteHtmlFooter() {
     try {
         std::unique_lock<std::mutex> mlock(g_record_mutex);
-        std::ofstream html_file;
-        html_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
+        std::ostream &html_file = g_record_file.Stream(g_record_info.file_name);
         html_file << "        </div>\n"
                      "    </body>\n"
                      "</html>";
+        g_record_file.Close();
 
         // Writing the footer means we're done.
         if (g_record_info.initialized) {
@@ -235,217 +458,547 @@ void LogPlatformUtilsError(const std::string &message) {
 #endif
 }
 
-// Get the current time as a string
-std::string GenerateTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    std::time_t now_c = std::chrono::system_clock::to_time_t(now);
-    std::tm local_tm = *std::localtime(&now_c);
+// Get the given time as a string
+std::string GenerateTimestamp(std::chrono::system_clock::time_point time) {
+    std::time_t time_c = std::chrono::system_clock::to_time_t(time);
+    std::tm local_tm = *std::localtime(&time_c);
     std::ostringstream oss;
     oss << std::put_time(&local_tm, "%Y-%m-%d %H:%M:%S");
     return oss.str();
 }
 
+// A validation message waiting to be written by the record writer thread.
+struct CoreValidationRecord {
+    CoreValidationRecord *next = nullptr;
+    std::chrono::system_clock::time_point time;
+    std::thread::id thread;
+    GenValidUsageDebugSeverity severity = VALID_USAGE_DEBUG_SEVERITY_DEBUG;
+    std::string message_id;
+    std::string command_name;
+    std::string message;
+    std::vector<GenValidUsageXrObjectInfo> objects;
+    std::vector<std::string> labels;
+};
+
+static void CoreValidationAppendJsonString(std::string &line, const std::string &text) {
+    static const char hex_digits[] = "0123456789abcdef";
+    line += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            line += '\\';
+            line += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            line += "\\u00";
+            line += hex_digits[(c >> 4) & 0xf];
+            line += hex_digits[c & 0xf];
+        } else {
+            line += c;
+        }
+    }
+    line += '"';
+}
+
+// One record as a single-line JSON object, for tools to read as a stream: no header, and no formatting beyond
+// escaping the strings.  Object types are XrObjectType values.
+static void CoreValidationWriteJsonLine(const CoreValidationRecord &record) {
+    const char *severity = "debug";
+    switch (record.severity) {
+        case VALID_USAGE_DEBUG_SEVERITY_INFO:
+            severity = "info";
+            break;
+        case VALID_USAGE_DEBUG_SEVERITY_WARNING:
+            severity = "warning";
+            break;
+        case VALID_USAGE_DEBUG_SEVERITY_ERROR:
+            severity = "error";
+            break;
+        default:
+            break;
+    }
+
+    std::string line;
+    line.reserve(192 + record.message.size());
+    line += "{\"time_ns\":";
+    line += std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(record.time.time_since_epoch()).count());
+    line += ",\"thread\":";
+    line += std::to_string(static_cast<uint64_t>(std::hash<std::thread::id>()(record.thread)));
+    line += ",\"severity\":\"";
+    line += severity;
+    line += "\",\"vuid\":";
+    CoreValidationAppendJsonString(line, record.message_id);
+    line += ",\"command\":";
+    CoreValidationAppendJsonString(line, record.command_name);
+    line += ",\"message\":";
+    CoreValidationAppendJsonString(line, record.message);
+    line += ",\"objects\":[";
+    for (size_t i = 0; i < record.objects.size(); ++i) {
+        line += i == 0 ? "{\"type\":" : ",{\"type\":";
+        line += std::to_string(static_cast<int32_t>(record.objects[i].type));
+        line += ",\"handle\":\"";
+        line += ToHexChars(record.objects[i].handle).text;
+        line += "\"}";
+    }
+    line += "],\"labels\":[";
+    for (size_t i = 0; i < record.labels.size(); ++i) {
+        if (i != 0) {
+            line += ',';
+        }
+        CoreValidationAppendJsonString(line, record.labels[i]);
+    }
+    line += "]}\n";
+
+    if (g_record_info.file_name.empty()) {
+        std::fwrite(line.data(), 1, line.size(), stdout);
+    } else {
+        g_record_file.Stream(g_record_info.file_name).write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+}
+
+// Write one record to stdout or the output file, in the format selected by g_record_info.
+static void CoreValidationWriteRecord(const CoreValidationRecord &record) {
+    if (g_record_info.type == RECORD_JSON_LINES) {
+        CoreValidationWriteJsonLine(record);
+        return;
+    }
+
+    std::string timestamp = GenerateTimestamp(record.time);
+    const std::string &message_id = record.message_id;
+    const std::string &command_name = record.command_name;
+    const std::string &message = record.message;
+    const std::vector<GenValidUsageXrObjectInfo> &objects_info = record.objects;
+
+    std::string severity_string;
+    switch (record.severity) {
+        case VALID_USAGE_DEBUG_SEVERITY_DEBUG:
+            severity_string = "VALID_DEBUG";
+            break;
+        case VALID_USAGE_DEBUG_SEVERITY_INFO:
+            severity_string = "VALID_INFO";
+            break;
+        case VALID_USAGE_DEBUG_SEVERITY_WARNING:
+            severity_string = "VALID_WARNING";
+            break;
+        case VALID_USAGE_DEBUG_SEVERITY_ERROR:
+            severity_string = "VALID_ERROR";
+            break;
+        default:
+            severity_string = "VALID_UNKNOWN";
+            break;
+    }
+
+    switch (g_record_info.type) {
+        case RECORD_TEXT_COUT: {
+#if defined(ANDROID)
+#define ALOGI(...)       \
+    printf(__VA_ARGS__); \
+    __android_log_print(ANDROID_LOG_INFO, "core_validation", __VA_ARGS__)
+#else
+#define ALOGI(...) printf(__VA_ARGS__)
+#endif
+            ALOGI("[%s][%s|%s|%s]: %s \n", timestamp.c_str(), severity_string.c_str(), message_id.c_str(), command_name.c_str(),
+                  message.c_str());
+            if (!objects_info.empty()) {
+                ALOGI("  Objects:\n");
+                uint32_t count = 0;
+                for (const auto &object_info : objects_info) {
+                    std::string object_type = GenValidUsageXrObjectTypeToString(object_info.type);
+                    std::string hexString = Uint64ToHexString(object_info.handle);
+                    ALOGI("   [%" PRIu32 "] - %s (%s)\n", count++, object_type.c_str(), hexString.c_str());
+                }
+            }
+            if (!record.labels.empty()) {
+                ALOGI("  Session Labels:\n");
+                uint32_t count = 0;
+                for (const auto &session_label : record.labels) {
+                    ALOGI("   [%" PRIu32 "] - %s\n", count++, session_label.c_str());
+#undef ALOGI
+                }
+            }
+            break;
+        }
+        case RECORD_TEXT_FILE: {
+            std::ostream &text_file = g_record_file.Stream(g_record_info.file_name);
+            text_file << "[" << timestamp << "]"  // force code wrap
+                      << "[" << severity_string << " | " << message_id << " | " << command_name << "] : " << message << "\n";
+
+            if (!objects_info.empty()) {
+                text_file << "  Objects:\n";
+                uint32_t count = 0;
+                for (const auto &object_info : objects_info) {
+                    std::string object_type = GenValidUsageXrObjectTypeToString(object_info.type);
+                    text_file << "   [" << std::to_string(count++) << "] - " << object_type << " ("
+                              << ToHexChars(object_info.handle).text << ")\n";
+                }
+            }
+            if (!record.labels.empty()) {
+                text_file << "  Session Labels:\n";
+                uint32_t count = 0;
+                for (const auto &session_label : record.labels) {
+                    text_file << "   [" << std::to_string(count++) << "] - " << session_label << "\n";
+                }
+            }
+            break;
+        }
+        case RECORD_HTML_FILE: {
+            std::ostream &text_file = g_record_file.Stream(g_record_info.file_name);
+            text_file << "<details class='data'>\n";
+            std::string header_type = "generalheadertype";
+            switch (record.severity) {
+                case VALID_USAGE_DEBUG_SEVERITY_DEBUG:
+                    header_type = "debugheadertype";
+                    severity_string = "Debug Message";
+                    break;
+                case VALID_USAGE_DEBUG_SEVERITY_INFO:
+                    severity_string = "Info Message";
+                    break;
+                case VALID_USAGE_DEBUG_SEVERITY_WARNING:
+                    header_type = "warningheadertype";
+                    severity_string = "Warning Message";
+                    break;
+                case VALID_USAGE_DEBUG_SEVERITY_ERROR:
+                    header_type = "errorheadertype";
+                    severity_string = "Error Message";
+                    break;
+                default:
+                    severity_string = "Unknown Message";
+                    break;
+            }
+            text_file << "   <summary>\n"
+                      << "      <div class='timestampval'>[" << timestamp << "]</div>\n"
+                      << "      <div class='" << header_type << "'>" << severity_string << "</div>\n"
+                      << "      <div class='headerval'>" << command_name << "</div>\n"
+                      << "      <div class='headervar'>" << message_id << "</div>\n"
+                      << "   </summary>\n";
+            text_file << "   <div class='data'>\n";
+            text_file << "      <div class='val'>" << message << "</div>\n";
+            if (!objects_info.empty()) {
+                text_file << "      <details class='data'>\n";
+                text_file << "         <summary>\n";
+                text_file << "            <div class='type'>Relevant OpenXR Objects</div>\n";
+                text_file << "         </summary>\n";
+                uint32_t count = 0;
+                for (const auto &object_info : objects_info) {
+                    std::string object_type = GenValidUsageXrObjectTypeToString(object_info.type);
+                    text_file << "         <div class='data'>\n";
+                    text_file << "             <div class='var'>[" << count++ << "]</div>\n";
+                    text_file << "             <div class='type'>" << object_type << "</div>\n";
+                    text_file << "             <div class='val'>" << ToHexChars(object_info.handle).text << "</div>\n";
+                    text_file << "         </div>\n";
+                }
+                text_file << "      </details>\n";
+            }
+            if (!record.labels.empty()) {
+                text_file << "      <details class='data'>\n";
+                text_file << "         <summary>\n";
+                text_file << "            <div class='type'>Relevant Session Labels</div>\n";
+                text_file << "         </summary>\n";
+                uint32_t count = 0;
+                for (const auto &session_label : record.labels) {
+                    text_file << "         <div class='data'>\n";
+                    text_file << "             <div class='var'>[" << count++ << "]</div>\n";
+                    text_file << "             <div class='type'>" << session_label << "</div>\n";
+                    text_file << "         </div>\n";
+                }
+                text_file << "      </details>\n";
+            }
+            text_file << "   </div>\n";
+            text_file << "</details>\n";
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Writes validation messages on a background thread, so that threads reporting a burst of messages only pay for
+// queueing them.  Producers push onto a lock-free list; the writer takes the whole list at once and writes it in
+// order.  With XR_CORE_VALIDATION_REPEAT_LIMIT set, messages with the same VUID, command and objects past that
+// many are counted instead of written, and a summary of the counts is written when the writer stops.
+class CoreValidationRecordWriter {
+   public:
+    ~CoreValidationRecordWriter() { Stop(); }
+
+    void SetRepeatLimit(const std::string &repeat_limit) {
+        unsigned long limit = std::strtoul(repeat_limit.c_str(), nullptr, 10);
+        repeat_limit_.store(limit > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(limit));
+    }
+
+    void Push(std::unique_ptr<CoreValidationRecord> record);
+
+    // Wait until everything pushed so far has been written.
+    void Flush();
+
+    // Write everything pushed so far, along with the repeat summary, and end the writer thread.
+    void Stop();
+
+   private:
+    struct Suppressed {
+        std::unique_ptr<CoreValidationRecord> first;
+        uint64_t count = 0;
+    };
+
+    void Run();
+    void WriteBatch(CoreValidationRecord *newest);
+    bool ShouldWrite(const CoreValidationRecord &record);
+    void WriteRepeatSummary();
+
+    std::atomic<CoreValidationRecord *> head_{nullptr};
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint32_t> repeat_limit_{0};
+
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable written_cv_;
+    std::thread thread_;
+    bool stopping_ = false;
+    uint64_t written_ = 0;
+
+    // Only used by the writer thread.
+    std::unordered_map<std::string, Suppressed> repeats_;
+};
+
+void CoreValidationRecordWriter::Push(std::unique_ptr<CoreValidationRecord> record) {
+    CoreValidationRecord *node = record.release();
+    CoreValidationRecord *old_head = head_.load(std::memory_order_relaxed);
+    do {
+        node->next = old_head;
+    } while (!head_.compare_exchange_weak(old_head, node, std::memory_order_release, std::memory_order_relaxed));
+    pushed_.fetch_add(1, std::memory_order_relaxed);
+
+    // Only the push that makes the list non-empty has to wake the writer, or start it.
+    if (nullptr == old_head) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&CoreValidationRecordWriter::Run, this);
+        }
+        wake_cv_.notify_one();
+    }
+}
+
+void CoreValidationRecordWriter::Flush() {
+    const uint64_t target = pushed_.load();
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!thread_.joinable()) {
+        return;
+    }
+    written_cv_.wait(lock, [&] { return written_ >= target; });
+}
+
+void CoreValidationRecordWriter::Stop() {
+    std::thread thread;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+        wake_cv_.notify_one();
+        thread = std::move(thread_);
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+    {
+        std::unique_lock<std::mutex> mlock(g_record_mutex);
+        g_record_file.Close();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    stopping_ = false;
+}
+
+void CoreValidationRecordWriter::Run() {
+    while (true) {
+        CoreValidationRecord *newest = head_.exchange(nullptr, std::memory_order_acquire);
+        if (nullptr != newest) {
+            WriteBatch(newest);
+            continue;
+        }
+        {
+            // Nothing is queued, so this is a good time to get what was written out to the file.
+            std::unique_lock<std::mutex> mlock(g_record_mutex);
+            g_record_file.Flush();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stopping_ && nullptr == head_.load()) {
+            break;
+        }
+        wake_cv_.wait(lock, [&] { return stopping_ || nullptr != head_.load(); });
+    }
+    WriteRepeatSummary();
+}
+
+void CoreValidationRecordWriter::WriteBatch(CoreValidationRecord *newest) {
+    // The list is newest first: reverse it to write in the order the messages were reported.
+    CoreValidationRecord *oldest = nullptr;
+    uint64_t count = 0;
+    while (nullptr != newest) {
+        CoreValidationRecord *next = newest->next;
+        newest->next = oldest;
+        oldest = newest;
+        newest = next;
+        ++count;
+    }
+
+    {
+        std::unique_lock<std::mutex> mlock(g_record_mutex);
+        bool wrote_error = false;
+        while (nullptr != oldest) {
+            std::unique_ptr<CoreValidationRecord> record(oldest);
+            oldest = oldest->next;
+            if (ShouldWrite(*record)) {
+                CoreValidationWriteRecord(*record);
+                wrote_error = wrote_error || record->severity == VALID_USAGE_DEBUG_SEVERITY_ERROR;
+            }
+        }
+        // Errors are often followed by a crash, so do not leave them in the buffer.
+        if (wrote_error) {
+            g_record_file.Flush();
+        } else {
+            g_record_file.RecordWritten();
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    written_ += count;
+    written_cv_.notify_all();
+}
+
+bool CoreValidationRecordWriter::ShouldWrite(const CoreValidationRecord &record) {
+    const uint32_t repeat_limit = repeat_limit_.load(std::memory_order_relaxed);
+    if (0 == repeat_limit) {
+        return true;
+    }
+    std::string key = record.message_id + "|" + record.command_name;
+    for (const auto &object_info : record.objects) {
+        key += '|';
+        append_hex(key, object_info.handle);
+    }
+    Suppressed &repeat = repeats_[key];
+    if (++repeat.count <= repeat_limit) {
+        return true;
+    }
+    if (!repeat.first) {
+        repeat.first.reset(new CoreValidationRecord(record));
+    }
+    return false;
+}
+
+void CoreValidationRecordWriter::WriteRepeatSummary() {
+    std::unique_lock<std::mutex> mlock(g_record_mutex);
+    const uint32_t repeat_limit = repeat_limit_.load(std::memory_order_relaxed);
+    for (auto &repeat : repeats_) {
+        if (!repeat.second.first) {
+            continue;
+        }
+        CoreValidationRecord &record = *repeat.second.first;
+        record.message = std::to_string(repeat.second.count - repeat_limit) + " more identical messages were suppressed: " +
+                         record.message;
+        CoreValidationWriteRecord(record);
+    }
+    repeats_.clear();
+    g_record_file.Flush();
+}
+
+static CoreValidationRecordWriter g_record_writer;
+
 // Function to record all the core validation information
 void CoreValidLogMessage(GenValidUsageXrInstanceInfo *instance_info, const std::string &message_id,
                          GenValidUsageDebugSeverity message_severity, const std::string &command_name,
                          std::vector<GenValidUsageXrObjectInfo> objects_info, const std::string &message) {
     if (g_record_info.initialized) {
-        std::unique_lock<std::mutex> mlock(g_record_mutex);
-
-        // Generate a timestamp
-        std::string timestamp = GenerateTimestamp();
+        std::unique_ptr<CoreValidationRecord> record(new CoreValidationRecord);
+        record->time = std::chrono::system_clock::now();
+        record->thread = std::this_thread::get_id();
 
         // Debug Utils items (in case we need them)
         XrDebugUtilsMessageSeverityFlagsEXT debug_utils_severity = 0;
-
-        std::string severity_string;
         switch (message_severity) {
             case VALID_USAGE_DEBUG_SEVERITY_DEBUG:
-                severity_string = "VALID_DEBUG";
                 debug_utils_severity = XR_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
                 break;
             case VALID_USAGE_DEBUG_SEVERITY_INFO:
-                severity_string = "VALID_INFO";
                 debug_utils_severity = XR_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
                 break;
             case VALID_USAGE_DEBUG_SEVERITY_WARNING:
-                severity_string = "VALID_WARNING";
                 debug_utils_severity = XR_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
                 break;
             case VALID_USAGE_DEBUG_SEVERITY_ERROR:
-                severity_string = "VALID_ERROR";
                 debug_utils_severity = XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
                 break;
             default:
-                severity_string = "VALID_UNKNOWN";
                 break;
         }
-        NamesAndLabels names_and_labels;
         // If we have instance information, see if we need to log this information out to a debug messenger
-        // callback.
+        // callback.  Callbacks are called synchronously on a snapshot of the messengers, without holding any lock
+        // other threads' validation needs.  Unless set to be concurrent, each messenger gets one message at a time.
+        std::shared_ptr<const CoreValidationMessengerList> debug_messengers;
         if (nullptr != instance_info) {
-            if (!instance_info->debug_messengers.empty()) {
-                std::vector<XrSdkLogObjectInfo> objects;
-                objects.reserve(objects_info.size());
-                std::transform(objects_info.begin(), objects_info.end(), std::back_inserter(objects),
-                               [](GenValidUsageXrObjectInfo const &info) {
-                                   return XrSdkLogObjectInfo{info.handle, info.type};  // force code wrap
-                               });
-
-                // Setup our callback data once
-                XrDebugUtilsMessengerCallbackDataEXT callback_data = {XR_TYPE_DEBUG_UTILS_MESSENGER_CALLBACK_DATA_EXT};
-                callback_data.messageId = message_id.c_str();
-                callback_data.functionName = command_name.c_str();
-                callback_data.message = message.c_str();
+            debug_messengers = instance_info->GetDebugMessengers();
+        }
+        if (debug_messengers && !debug_messengers->empty()) {
+            std::vector<XrSdkLogObjectInfo> objects;
+            objects.reserve(objects_info.size());
+            std::transform(objects_info.begin(), objects_info.end(), std::back_inserter(objects),
+                           [](GenValidUsageXrObjectInfo const &info) {
+                               return XrSdkLogObjectInfo{info.handle, info.type};  // force code wrap
+                           });
+
+            // Setup our callback data once
+            XrDebugUtilsMessengerCallbackDataEXT callback_data = {XR_TYPE_DEBUG_UTILS_MESSENGER_CALLBACK_DATA_EXT};
+            callback_data.messageId = message_id.c_str();
+            callback_data.functionName = command_name.c_str();
+            callback_data.message = message.c_str();
+            NamesAndLabels names_and_labels;
+            bool has_names_and_labels = false;
+            std::vector<XrDebugUtilsLabelEXT> labels;
+            {
+                std::unique_lock<std::mutex> debug_data_lock(instance_info->debug_data_mutex);
                 if (!instance_info->debug_data.Empty()) {
                     names_and_labels = instance_info->debug_data.PopulateNamesAndLabels(std::move(objects));
-                    names_and_labels.PopulateCallbackData(callback_data);
+                    has_names_and_labels = true;
                 }
-
-                // Loop through all active messengers and give each a chance to output information
-                for (const auto &debug_messenger : instance_info->debug_messengers) {
-                    CoreValidationMessengerInfo *validation_messenger_info = debug_messenger.get();
-                    XrDebugUtilsMessengerCreateInfoEXT *messenger_create_info = validation_messenger_info->create_info;
-                    // If a callback exists, and the message is of a type this callback cares about, call it.
-                    if (nullptr != messenger_create_info->userCallback &&
-                        0 != (messenger_create_info->messageSeverities & debug_utils_severity) &&
-                        0 != (messenger_create_info->messageTypes & XR_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT)) {
-                        XrBool32 ret_val = messenger_create_info->userCallback(debug_utils_severity,
-                                                                               XR_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT,
-                                                                               &callback_data, messenger_create_info->userData);
-                    }
+                // The label stacks may change once the lock is released, and the record outlives them anyway,
+                // so the record keeps copies of the label names for the callbacks to point at.
+                const XrDebugUtilsLabelEXT *session_labels = names_and_labels.LabelData();
+                labels.assign(session_labels, session_labels + names_and_labels.LabelCount());
+                for (const auto &label : labels) {
+                    record->labels.emplace_back(label.labelName);
                 }
             }
-        }
-
-        switch (g_record_info.type) {
-            case RECORD_TEXT_COUT: {
-#if defined(ANDROID)
-#define ALOGI(...)       \
-    printf(__VA_ARGS__); \
-    __android_log_print(ANDROID_LOG_INFO, "core_validation", __VA_ARGS__)
-#else
-#define ALOGI(...) printf(__VA_ARGS__)
-#endif
-                ALOGI("[%s][%s|%s|%s]: %s \n", timestamp.c_str(), severity_string.c_str(), message_id.c_str(), command_name.c_str(),
-                      message.c_str());
-                if (!objects_info.empty()) {
-                    ALOGI("  Objects:\n");
-                    uint32_t count = 0;
-                    for (const auto &object_info : objects_info) {
-                        std::string object_type = GenValidUsageXrObjectTypeToString(object_info.type);
-                        std::string hexString = Uint64ToHexString(object_info.handle);
-                        ALOGI("   [%" PRIu32 "] - %s (%s)\n", count++, object_type.c_str(), hexString.c_str());
-                    }
-                }
-                if (!names_and_labels.labels.empty()) {
-                    ALOGI("  Session Labels:\n");
-                    uint32_t count = 0;
-                    for (const auto &session_label : names_and_labels.labels) {
-                        ALOGI("   [%" PRIu32 "] - %s\n", count++, session_label.labelName);
-#undef ALOGI
-                    }
-                }
-                break;
+            for (size_t label = 0; label < labels.size(); ++label) {
+                labels[label].labelName = record->labels[label].c_str();
             }
-            case RECORD_TEXT_FILE: {
-                std::ofstream text_file;
-                text_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
-                text_file << "[" << timestamp << "]"  // force code wrap
-                          << "[" << severity_string << " | " << message_id << " | " << command_name << "] : " << message
-                          << std::endl;
-
-                if (!objects_info.empty()) {
-                    text_file << "  Objects:" << std::endl;
-                    uint32_t count = 0;
-                    for (const auto &object_info : objects_info) {
-                        std::string object_type = GenValidUsageXrObjectTypeToString(object_info.type);
-                        text_file << "   [" << std::to_string(count++) << "] - " << object_type << " ("
-                                  << Uint64ToHexString(object_info.handle) << ")";
-                        text_file << std::endl;
-                    }
-                }
-                if (!names_and_labels.labels.empty()) {
-                    text_file << "  Session Labels:" << std::endl;
-                    uint32_t count = 0;
-                    for (const auto &session_label : names_and_labels.labels) {
-                        text_file << "   [" << std::to_string(count++) << "] - " << session_label.labelName << std::endl;
-                    }
-                }
-                text_file << std::flush;
-                text_file.close();
-                break;
+            names_and_labels.borrowed_labels = nullptr;
+            names_and_labels.borrowed_label_count = 0;
+            names_and_labels.labels = std::move(labels);
+            if (has_names_and_labels) {
+                names_and_labels.PopulateCallbackData(callback_data);
             }
-            case RECORD_HTML_FILE: {
-                std::ofstream text_file;
-                text_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
-                text_file << "<details class='data'>\n";
-                std::string header_type = "generalheadertype";
-                switch (message_severity) {
-                    case VALID_USAGE_DEBUG_SEVERITY_DEBUG:
-                        header_type = "debugheadertype";
-                        severity_string = "Debug Message";
-                        break;
-                    case VALID_USAGE_DEBUG_SEVERITY_INFO:
-                        severity_string = "Info Message";
-                        break;
-                    case VALID_USAGE_DEBUG_SEVERITY_WARNING:
-                        header_type = "warningheadertype";
-                        severity_string = "Warning Message";
-                        break;
-                    case VALID_USAGE_DEBUG_SEVERITY_ERROR:
-                        header_type = "errorheadertype";
-                        severity_string = "Error Message";
-                        break;
-                    default:
-                        severity_string = "Unknown Message";
-                        break;
-                }
-                text_file << "   <summary>\n"
-                          << "      <div class='timestampval'>[" << timestamp << "]</div>\n"
-                          << "      <div class='" << header_type << "'>" << severity_string << "</div>\n"
-                          << "      <div class='headerval'>" << command_name << "</div>\n"
-                          << "      <div class='headervar'>" << message_id << "</div>\n"
-                          << "   </summary>\n";
-                text_file << "   <div class='data'>\n";
-                text_file << "      <div class='val'>" << message << "</div>\n";
-                if (!objects_info.empty()) {
-                    text_file << "      <details class='data'>\n";
-                    text_file << "         <summary>\n";
-                    text_file << "            <div class='type'>Relevant OpenXR Objects</div>\n";
-                    text_file << "         </summary>\n";
-                    uint32_t count = 0;
-                    for (const auto &object_info : objects_info) {
-                        std::string object_type = GenValidUsageXrObjectTypeToString(object_info.type);
-                        text_file << "         <div class='data'>\n";
-                        text_file << "             <div class='var'>[" << count++ << "]</div>\n";
-                        text_file << "             <div class='type'>" << object_type << "</div>\n";
-                        text_file << "             <div class='val'>" << Uint64ToHexString(object_info.handle) << "</div>\n";
-                        text_file << "         </div>\n";
-                    }
-                    text_file << "      </details>\n";
-                    text_file << std::flush;
-                }
-                if (!names_and_labels.labels.empty()) {
-                    text_file << "      <details class='data'>\n";
-                    text_file << "         <summary>\n";
-                    text_file << "            <div class='type'>Relevant Session Labels</div>\n";
-                    text_file << "         </summary>\n";
-                    uint32_t count = 0;
-                    for (const auto &session_label : names_and_labels.labels) {
-                        text_file << "         <div class='data'>\n";
-                        text_file << "             <div class='var'>[" << count++ << "]</div>\n";
-                        text_file << "             <div class='type'>" << session_label.labelName << "</div>\n";
-                        text_file << "         </div>\n";
+
+            // Loop through all active messengers and give each a chance to output information
+            const bool concurrent_callbacks = g_concurrent_callbacks.load(std::memory_order_relaxed);
+            for (const auto &debug_messenger : *debug_messengers) {
+                CoreValidationMessengerInfo *validation_messenger_info = debug_messenger.get();
+                XrDebugUtilsMessengerCreateInfoEXT *messenger_create_info = validation_messenger_info->create_info;
+                // If a callback exists, and the message is of a type this callback cares about, call it.
+                if (nullptr != messenger_create_info->userCallback &&
+                    0 != (messenger_create_info->messageSeverities & debug_utils_severity) &&
+                    0 != (messenger_create_info->messageTypes & XR_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT)) {
+                    std::unique_lock<std::mutex> callback_lock(validation_messenger_info->callback_mutex, std::defer_lock);
+                    if (!concurrent_callbacks) {
+                        callback_lock.lock();
                     }
-                    text_file << "      </details>\n";
+                    XrBool32 ret_val = messenger_create_info->userCallback(debug_utils_severity,
+                                                                           XR_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT,
+                                                                           &callback_data, messenger_create_info->userData);
                 }
-                text_file << "   </div>\n";
-                text_file << "</details>\n";
-                break;
             }
-            default:
-                break;
+        }
+
+        if (g_record_info.type != RECORD_NONE) {
+            record->severity = message_severity;
+            record->message_id = message_id;
+            record->command_name = command_name;
+            record->message = message;
+            record->objects = std::move(objects_info);
+            g_record_writer.Push(std::move(record));
         }
     }
 }
@@ -456,13 +1009,13 @@ void reportInternalError(std::string const &message) {
 }
 
 void InvalidStructureType(GenValidUsageXrInstanceInfo *instance_info, const std::string &command_name,
-                          std::vector<GenValidUsageXrObjectInfo> &objects_info, const char *structure_name, XrStructureType type,
+                          GenValidUsageXrObjectInfoList &objects_info, const char *structure_name, XrStructureType type,
                           const char *vuid, XrStructureType expected, const char *expected_name) {
     std::ostringstream oss_type;
     oss_type << structure_name << " has an invalid XrStructureType ";
-    oss_type << Uint32ToHexString(static_cast<uint32_t>(type));
+    oss_type << ToHexChars(static_cast<uint32_t>(type)).text;
     if (expected != 0) {
-        oss_type << ", expected " << Uint32ToHexString(static_cast<uint32_t>(expected));
+        oss_type << ", expected " << ToHexChars(static_cast<uint32_t>(expected)).text;
         oss_type << " (" << expected_name << ")";
     }
     if (vuid != nullptr) {
@@ -473,7 +1026,7 @@ void InvalidStructureType(GenValidUsageXrInstanceInfo *instance_info, const std:
     }
 }
 
-std::string StructTypesToString(GenValidUsageXrInstanceInfo *instance_info, const std::unordered_set<XrStructureType> &structs) {
+std::string StructTypesToString(GenValidUsageXrInstanceInfo *instance_info, const StructTypeSpan &structs) {
     char struct_type_buffer[XR_MAX_STRUCTURE_NAME_SIZE];
     std::string error_message;
     if (nullptr == instance_info) {
@@ -481,8 +1034,9 @@ std::string StructTypesToString(GenValidUsageXrInstanceInfo *instance_info, cons
         return error_message;
     }
     bool wrote_struct = false;
-    for (auto &s : structs)
-        if (XR_SUCCESS == instance_info->dispatch_table->StructureTypeToString(instance_info->instance, s, struct_type_buffer)) {
+    for (size_t i = 0; i < structs.count; ++i)
+        if (XR_SUCCESS ==
+            instance_info->dispatch_table->StructureTypeToString(instance_info->instance, structs.types[i], struct_type_buffer)) {
             if (wrote_struct) {
                 error_message += ", ";
             }
@@ -515,6 +1069,37 @@ GenValidUsageXrInstanceInfo::GenValidUsageXrInstanceInfo(XrInstance inst, PFN_xr
 
 GenValidUsageXrInstanceInfo::~GenValidUsageXrInstanceInfo() { delete dispatch_table; }
 
+std::shared_ptr<const CoreValidationMessengerList> GenValidUsageXrInstanceInfo::GetDebugMessengers() {
+    std::unique_lock<std::mutex> lock(debug_messengers_mutex_);
+    return debug_messengers_;
+}
+
+void GenValidUsageXrInstanceInfo::AddDebugMessenger(UniqueCoreValidationMessengerInfo messenger_info) {
+    std::unique_lock<std::mutex> lock(debug_messengers_mutex_);
+    std::shared_ptr<CoreValidationMessengerList> messengers =
+        debug_messengers_ ? std::make_shared<CoreValidationMessengerList>(*debug_messengers_)
+                          : std::make_shared<CoreValidationMessengerList>();
+    messengers->emplace_back(messenger_info.release(), CoreValidationMessengerInfoDeleter());
+    debug_messengers_ = std::move(messengers);
+}
+
+void GenValidUsageXrInstanceInfo::RemoveDebugMessenger(XrDebugUtilsMessengerEXT messenger) {
+    std::unique_lock<std::mutex> lock(debug_messengers_mutex_);
+    if (!debug_messengers_) {
+        return;
+    }
+    std::shared_ptr<CoreValidationMessengerList> messengers = std::make_shared<CoreValidationMessengerList>(*debug_messengers_);
+    vector_remove_if_and_erase(*messengers, [=](std::shared_ptr<CoreValidationMessengerInfo> const &messenger_info) {
+        return messenger_info->messenger == messenger;
+    });
+    debug_messengers_ = std::move(messengers);
+}
+
+void GenValidUsageXrInstanceInfo::ClearDebugMessengers() {
+    std::unique_lock<std::mutex> lock(debug_messengers_mutex_);
+    debug_messengers_.reset();
+}
+
 // See if there is a debug utils create structure in the "next" chain
 
 XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrCreateApiLayerInstance(const XrInstanceCreateInfo *info,
@@ -534,13 +1119,31 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrCreateApiLayerInstance(const XrIn
 #if !defined(ANDROID)
         std::string export_type = PlatformUtilsGetEnv("XR_CORE_VALIDATION_EXPORT_TYPE");
         std::string file_name = PlatformUtilsGetEnv("XR_CORE_VALIDATION_FILE_NAME");
+        std::string sample_rate = PlatformUtilsGetEnv("XR_CORE_VALIDATION_SAMPLE_RATE");
+        std::string repeat_limit = PlatformUtilsGetEnv("XR_CORE_VALIDATION_REPEAT_LIMIT");
+        std::string messenger_callbacks = PlatformUtilsGetEnv("XR_CORE_VALIDATION_MESSENGER_CALLBACKS");
+        std::string frame_cache = PlatformUtilsGetEnv("XR_CORE_VALIDATION_FRAME_CACHE");
 #else
         // We match the pattern used by the Vulkan api_dump layer here
         // (we replace the `XR_` prefix with `debug.` and make it lowercase.)
         // adb shell "setprop debug.api_dump_file_name '/sdcard/xr_apidump.txt'"
         std::string export_type = PlatformUtilsGetAndroidSystemProperty("debug.core_validation_export_type");
         std::string file_name = PlatformUtilsGetAndroidSystemProperty("debug.core_validation_file_name");
+        std::string sample_rate = PlatformUtilsGetAndroidSystemProperty("debug.core_validation_sample_rate");
+        std::string repeat_limit = PlatformUtilsGetAndroidSystemProperty("debug.core_validation_repeat_limit");
+        std::string messenger_callbacks = PlatformUtilsGetAndroidSystemProperty("debug.core_validation_messenger_callbacks");
+        std::string frame_cache = PlatformUtilsGetAndroidSystemProperty("debug.core_validation_frame_cache");
 #endif
+        g_concurrent_callbacks.store(messenger_callbacks == "concurrent");
+        if (!repeat_limit.empty()) {
+            g_record_writer.SetRepeatLimit(repeat_limit);
+        }
+        if (!sample_rate.empty()) {
+            CoreValidationSetSampleRate(sample_rate);
+        }
+        if (!frame_cache.empty()) {
+            CoreValidationSetFrameCache(frame_cache);
+        }
         if (!file_name.empty()) {
             g_record_info.file_name = file_name;
             g_record_info.type = RECORD_TEXT_FILE;
@@ -557,6 +1160,8 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrCreateApiLayerInstance(const XrIn
                 if (!CoreValidationWriteHtmlHeader()) {
                     return XR_ERROR_INITIALIZATION_FAILED;
                 }
+            } else if (export_type_lower == "json") {
+                g_record_info.type = RECORD_JSON_LINES;
             } else if (export_type_lower == "none") {
                 g_record_info.type = RECORD_NONE;
             }
@@ -630,10 +1235,7 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrCreateApiLayerInstance(const XrIn
 
 void EraseAllInstanceTableMapElements(GenValidUsageXrInstanceInfo *search_value) {
     typedef typename InstanceHandleInfo::value_t value_t;
-    auto map_with_lock = g_instance_info.lockMap();
-    auto &map = map_with_lock.second;
-
-    map_erase_if(map, [=](value_t const &data) { return data.second.get() == search_value; });
+    g_instance_info.eraseIf([=](value_t const &data) { return data.second.get() == search_value; });
 }
 
 XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrDestroyInstance(XrInstance instance) {
@@ -642,7 +1244,7 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrDestroyInstance(XrInstance instan
         auto info_with_lock = g_instance_info.getWithLock(instance);
         GenValidUsageXrInstanceInfo *gen_instance_info = info_with_lock.second;
         if (nullptr != gen_instance_info) {
-            gen_instance_info->debug_messengers.clear();
+            gen_instance_info->ClearDebugMessengers();
         }
     }
 
@@ -650,7 +1252,13 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrDestroyInstance(XrInstance instan
                         std::vector<GenValidUsageXrObjectInfo>(), "Core Validation Layer will be destroyed");
 
     XrResult result = GenValidUsageNextXrDestroyInstance(instance);
-    if (!g_instance_info.empty() && g_record_info.type == RECORD_HTML_FILE) {
+    // Messages must be written out before the footer, and the writer thread must end before the layer is unloaded.
+    if (g_instance_info.empty()) {
+        g_record_writer.Stop();
+    } else {
+        g_record_writer.Flush();
+    }
+    if (g_instance_info.empty() && g_record_info.type == RECORD_HTML_FILE) {
         CoreValidationWriteHtmlFooter();
     }
     return result;
@@ -739,6 +1347,7 @@ void CoreValidationDeleteSessionLabels(XrSession session) {
     }
     GenValidUsageXrInstanceInfo *gen_instance_info = info_with_lock.second->instance_info;
     if (nullptr != gen_instance_info) {
+        std::unique_lock<std::mutex> debug_data_lock(gen_instance_info->debug_data_mutex);
         gen_instance_info->debug_data.DeleteSessionLabels(session);
     }
 }
@@ -758,6 +1367,7 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrSetDebugUtilsObjectNameEXT(XrInst
         auto info_with_lock = g_instance_info.getWithLock(instance);
         GenValidUsageXrInstanceInfo *gen_instance_info = info_with_lock.second;
         if (nullptr != gen_instance_info) {
+            std::unique_lock<std::mutex> debug_data_lock(gen_instance_info->debug_data_mutex);
             gen_instance_info->debug_data.AddObjectName(nameInfo->objectHandle, nameInfo->objectType, nameInfo->objectName);
         }
         return result;
@@ -786,7 +1396,7 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrCreateDebugUtilsMessengerEXT(XrIn
             UniqueCoreValidationMessengerInfo new_messenger_info(new CoreValidationMessengerInfo);
             new_messenger_info->messenger = *messenger;
             new_messenger_info->create_info = new_create_info;
-            gen_instance_info->debug_messengers.push_back(std::move(new_messenger_info));
+            gen_instance_info->AddDebugMessenger(std::move(new_messenger_info));
         }
         return result;
     } catch (...) {
@@ -811,9 +1421,7 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrDestroyDebugUtilsMessengerEXT(XrD
         if (info_with_lock.second != nullptr) {
             GenValidUsageXrHandleInfo *gen_handle_info = info_with_lock.second;
             if (nullptr != gen_handle_info) {
-                auto &debug_messengers = gen_handle_info->instance_info->debug_messengers;
-                vector_remove_if_and_erase(
-                    debug_messengers, [=](UniqueCoreValidationMessengerInfo const &msg) { return msg->messenger == messenger; });
+                gen_handle_info->instance_info->RemoveDebugMessenger(messenger);
             }
         }
         return result;
@@ -833,6 +1441,7 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrSessionBeginDebugUtilsLabelRegion
         if (info_with_lock.second != nullptr) {
             GenValidUsageXrInstanceInfo *gen_instance_info = info_with_lock.second->instance_info;
             if (nullptr != gen_instance_info) {
+                std::unique_lock<std::mutex> debug_data_lock(gen_instance_info->debug_data_mutex);
                 gen_instance_info->debug_data.BeginLabelRegion(session, *labelInfo);
             }
         }
@@ -850,6 +1459,7 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrSessionEndDebugUtilsLabelRegionEX
         if (info_with_lock.second != nullptr) {
             GenValidUsageXrInstanceInfo *gen_instance_info = info_with_lock.second->instance_info;
             if (nullptr != gen_instance_info) {
+                std::unique_lock<std::mutex> debug_data_lock(gen_instance_info->debug_data_mutex);
                 gen_instance_info->debug_data.EndLabelRegion(session);
             }
         }
@@ -868,6 +1478,7 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrSessionInsertDebugUtilsLabelEXT(X
         if (info_with_lock.second != nullptr) {
             GenValidUsageXrInstanceInfo *gen_instance_info = info_with_lock.second->instance_info;
             if (nullptr != gen_instance_info) {
+                std::unique_lock<std::mutex> debug_data_lock(gen_instance_info->debug_data_mutex);
                 gen_instance_info->debug_data.InsertLabel(session, *labelInfo);
             }
         }
@@ -875,6 +1486,36 @@ XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrSessionInsertDebugUtilsLabelEXT(X
     return GenValidUsageNextXrSessionInsertDebugUtilsLabelEXT(session, labelInfo);
 }
 
+// Runtime configuration: a debug utils message whose messageId is "core_validation_config" changes the layer's
+// settings, without recreating the instance.  Its settings (see layer_config_message.h) are "sample_rate",
+// "frame_cache", "repeat_limit" and "messenger_callbacks", with the values of the matching XR_CORE_VALIDATION_* settings.
+XRAPI_ATTR XrResult XRAPI_CALL CoreValidationXrSubmitDebugUtilsMessageEXT(
+    XrInstance instance, XrDebugUtilsMessageSeverityFlagsEXT messageSeverity, XrDebugUtilsMessageTypeFlagsEXT messageTypes,
+    const XrDebugUtilsMessengerCallbackDataEXT *callbackData) {
+    XrResult test_result =
+        GenValidUsageInputsXrSubmitDebugUtilsMessageEXT(instance, messageSeverity, messageTypes, callbackData);
+    if (XR_SUCCESS != test_result) {
+        return test_result;
+    }
+    if (nullptr != callbackData && nullptr != callbackData->messageId &&
+        strcmp(callbackData->messageId, "core_validation_config") == 0) {
+        for (const auto &setting : LayerParseConfigMessage(callbackData->message)) {
+            if (setting.first == "sample_rate") {
+                CoreValidationSetSampleRate(setting.second);
+            } else if (setting.first == "frame_cache") {
+                CoreValidationSetFrameCache(setting.second);
+            } else if (setting.first == "repeat_limit") {
+                g_record_writer.SetRepeatLimit(setting.second);
+            } else if (setting.first == "messenger_callbacks") {
+                g_concurrent_callbacks.store(setting.second == "concurrent");
+            } else {
+                LogPlatformUtilsError("Core Validation layer ignoring unknown configuration setting " + setting.first);
+            }
+        }
+    }
+    return GenValidUsageNextXrSubmitDebugUtilsMessageEXT(instance, messageSeverity, messageTypes, callbackData);
+}
+
 // ############################################################
 // NOTE: Add new validation checking above this comment block
 // ############################################################
@@ -0,0 +1,61 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef LAYER_CONFIG_MESSAGE_H_
+#define LAYER_CONFIG_MESSAGE_H_ 1
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/// The settings of a configuration message: a debug utils message an application submits with
+/// xrSubmitDebugUtilsMessageEXT to change an API layer's settings while it runs.  The message holds "key=value"
+/// settings separated by ';', like "enabled=1;include=xrLocate*,xrSync*".  Spaces around keys and values are ignored,
+/// and so are settings without a '='.
+typedef std::vector<std::pair<std::string, std::string>> LayerConfigSettings;
+
+inline LayerConfigSettings LayerParseConfigMessage(const char *message) {
+    LayerConfigSettings settings;
+    if (nullptr == message) {
+        return settings;
+    }
+    const auto trim = [](std::string text) {
+        text.erase(0, text.find_first_not_of(" \t"));
+        text.erase(text.find_last_not_of(" \t") + 1);
+        return text;
+    };
+    const std::string text(message);
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(';', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        const std::string setting = text.substr(start, end - start);
+        const size_t equals = setting.find('=');
+        if (equals != std::string::npos) {
+            std::string key = trim(setting.substr(0, equals));
+            if (!key.empty()) {
+                settings.emplace_back(std::move(key), trim(setting.substr(equals + 1)));
+            }
+        }
+        start = end + 1;
+    }
+    return settings;
+}
+
+#endif  // LAYER_CONFIG_MESSAGE_H_
@@ -0,0 +1,268 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef LAYER_HANDLE_REGISTRY_H_
+#define LAYER_HANDLE_REGISTRY_H_ 1
+
+#include "hex_and_handles.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// The live handles of one type, each with a value and the handle of its parent, shared by the API layers.  The
+/// layers' generators declare one per handle type of the registry.
+///
+/// The handles are kept in a linear-probing open-addressing table.  Lookups, done on every call, take no lock: they
+/// probe optimistically and retry if a writer changed the table meanwhile, which a sequence number tells them.
+/// Inserts and erases, done only when handles are created and destroyed, are serialized by a mutex.  Erasing shifts
+/// the following entries back instead of leaving a tombstone, so the table only grows with the number of live
+/// handles.  A table that is outgrown is kept until the registry is destroyed, since a lookup may still be probing it.
+///
+/// The registry does not own the values.  A lookup concurrent with the erase of the same handle may find either.
+template <typename HandleType, typename ValueType>
+class LayerHandleRegistry {
+   public:
+    LayerHandleRegistry() {
+        tables_.emplace_back(new Table(kInitialCapacity));
+        current_.store(tables_.back().get(), std::memory_order_release);
+    }
+    LayerHandleRegistry(const LayerHandleRegistry &) = delete;
+    LayerHandleRegistry &operator=(const LayerHandleRegistry &) = delete;
+
+    /// The value of a handle, or nullptr if it is not there.  The parent given on insert is written to parent.
+    ValueType *Find(HandleType handle, uint64_t *parent = nullptr) const {
+        const uint64_t key = MakeHandleGeneric(handle);
+        if (key == 0) {
+            return nullptr;
+        }
+        for (;;) {
+            const uint32_t sequence = sequence_.load(std::memory_order_acquire);
+            if ((sequence & 1) != 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            const Table *table = current_.load(std::memory_order_acquire);
+            ValueType *value = nullptr;
+            uint64_t found_parent = 0;
+            for (size_t i = Hash(key) & table->mask;; i = (i + 1) & table->mask) {
+                const uint64_t slot_key = table->slots[i].key.load(std::memory_order_relaxed);
+                if (slot_key == key) {
+                    value = table->slots[i].value.load(std::memory_order_relaxed);
+                    found_parent = table->slots[i].parent.load(std::memory_order_relaxed);
+                    break;
+                }
+                if (slot_key == 0) {
+                    break;
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == sequence) {
+                if (nullptr != parent) {
+                    *parent = found_parent;
+                }
+                return value;
+            }
+        }
+    }
+
+    /// Add a handle.  False if it is null or already there.
+    bool Insert(HandleType handle, ValueType *value, uint64_t parent = 0) {
+        const uint64_t key = MakeHandleGeneric(handle);
+        if (key == 0) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        Table *table = current_.load(std::memory_order_relaxed);
+        if (IndexOf(*table, key) != kNotFound) {
+            return false;
+        }
+        BeginWrite();
+        if ((count_ + 1) * 2 > table->capacity) {
+            table = Grow(*table);
+        }
+        Place(*table, key, value, parent);
+        ++count_;
+        EndWrite();
+        return true;
+    }
+
+    /// Remove a handle, returning its value, or nullptr if it was not there.
+    ValueType *Erase(HandleType handle) {
+        const uint64_t key = MakeHandleGeneric(handle);
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        Table &table = *current_.load(std::memory_order_relaxed);
+        const size_t index = key == 0 ? kNotFound : IndexOf(table, key);
+        if (index == kNotFound) {
+            return nullptr;
+        }
+        ValueType *value = table.slots[index].value.load(std::memory_order_relaxed);
+        BeginWrite();
+        RemoveAt(table, index);
+        --count_;
+        EndWrite();
+        return value;
+    }
+
+    /// Remove every handle for which pred(handle, value, parent) returns true, e.g. those of a destroyed instance.
+    template <typename Pred>
+    void EraseIf(Pred &&pred) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        Table &table = *current_.load(std::memory_order_relaxed);
+        std::vector<uint64_t> keys;
+        for (size_t i = 0; i < table.capacity; ++i) {
+            const uint64_t key = table.slots[i].key.load(std::memory_order_relaxed);
+            if (key != 0 && pred(TreatIntegerAsHandle<HandleType>(key), table.slots[i].value.load(std::memory_order_relaxed),
+                                 table.slots[i].parent.load(std::memory_order_relaxed))) {
+                keys.push_back(key);
+            }
+        }
+        if (keys.empty()) {
+            return;
+        }
+        BeginWrite();
+        for (const uint64_t key : keys) {
+            RemoveAt(table, IndexOf(table, key));
+            --count_;
+        }
+        EndWrite();
+    }
+
+    /// The first handle found for which pred(handle, value, parent) returns true, or XR_NULL_HANDLE.  Takes the write
+    /// lock, so it is for the rare reverse lookup, not for every call.
+    template <typename Pred>
+    HandleType FindIf(Pred &&pred) const {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        const Table &table = *current_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < table.capacity; ++i) {
+            const uint64_t key = table.slots[i].key.load(std::memory_order_relaxed);
+            if (key != 0 && pred(TreatIntegerAsHandle<HandleType>(key), table.slots[i].value.load(std::memory_order_relaxed),
+                                 table.slots[i].parent.load(std::memory_order_relaxed))) {
+                return TreatIntegerAsHandle<HandleType>(key);
+            }
+        }
+        return XR_NULL_HANDLE;
+    }
+
+    bool Empty() const {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        return count_ == 0;
+    }
+
+   private:
+    static constexpr size_t kInitialCapacity = 64;
+    static constexpr size_t kNotFound = ~size_t(0);
+
+    struct Slot {
+        std::atomic<uint64_t> key{0};  // 0 for an empty slot
+        std::atomic<ValueType *> value{nullptr};
+        std::atomic<uint64_t> parent{0};
+    };
+
+    struct Table {
+        explicit Table(size_t slot_count) : capacity(slot_count), mask(slot_count - 1), slots(new Slot[slot_count]) {}
+        const size_t capacity;  // A power of two
+        const size_t mask;
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    // Handles that are pointers have their low bits clear, so mix every bit into the ones the mask keeps.
+    static size_t Hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+
+    // The rest of these are called with write_mutex_ held.
+
+    static size_t IndexOf(const Table &table, uint64_t key) {
+        for (size_t i = Hash(key) & table.mask;; i = (i + 1) & table.mask) {
+            const uint64_t slot_key = table.slots[i].key.load(std::memory_order_relaxed);
+            if (slot_key == key) {
+                return i;
+            }
+            if (slot_key == 0) {
+                return kNotFound;
+            }
+        }
+    }
+
+    static void Place(Table &table, uint64_t key, ValueType *value, uint64_t parent) {
+        size_t i = Hash(key) & table.mask;
+        while (table.slots[i].key.load(std::memory_order_relaxed) != 0) {
+            i = (i + 1) & table.mask;
+        }
+        table.slots[i].value.store(value, std::memory_order_relaxed);
+        table.slots[i].parent.store(parent, std::memory_order_relaxed);
+        table.slots[i].key.store(key, std::memory_order_relaxed);
+    }
+
+    // Empty a slot, then move back each following entry that the hole would otherwise cut off from its home slot.
+    static void RemoveAt(Table &table, size_t hole) {
+        for (size_t i = (hole + 1) & table.mask;; i = (i + 1) & table.mask) {
+            const uint64_t key = table.slots[i].key.load(std::memory_order_relaxed);
+            if (key == 0) {
+                break;
+            }
+            const size_t home = Hash(key) & table.mask;
+            if (((i - home) & table.mask) >= ((i - hole) & table.mask)) {
+                table.slots[hole].value.store(table.slots[i].value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                table.slots[hole].parent.store(table.slots[i].parent.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                table.slots[hole].key.store(key, std::memory_order_relaxed);
+                hole = i;
+            }
+        }
+        table.slots[hole].key.store(0, std::memory_order_relaxed);
+        table.slots[hole].value.store(nullptr, std::memory_order_relaxed);
+        table.slots[hole].parent.store(0, std::memory_order_relaxed);
+    }
+
+    Table *Grow(const Table &table) {
+        tables_.emplace_back(new Table(table.capacity * 2));
+        Table *grown = tables_.back().get();
+        for (size_t i = 0; i < table.capacity; ++i) {
+            const uint64_t key = table.slots[i].key.load(std::memory_order_relaxed);
+            if (key != 0) {
+                Place(*grown, key, table.slots[i].value.load(std::memory_order_relaxed),
+                      table.slots[i].parent.load(std::memory_order_relaxed));
+            }
+        }
+        current_.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    // The sequence is odd while a writer changes the table.
+    void BeginWrite() {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void EndWrite() { sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    std::atomic<uint32_t> sequence_{0};
+    std::atomic<Table *> current_{nullptr};
+    mutable std::mutex write_mutex_;
+    std::vector<std::unique_ptr<Table>> tables_;  // Every table, the current one last
+    size_t count_ = 0;
+};
+
+#endif  // LAYER_HANDLE_REGISTRY_H_
@@ -0,0 +1,212 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef LAYER_RECORD_FILE_H_
+#define LAYER_RECORD_FILE_H_ 1
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <ostream>
+#include <string>
+
+#if !defined(_WIN32)
+#include <csignal>
+#endif
+
+#if defined(XR_LAYER_RECORD_GZIP)
+#include "layer_record_gzip.h"
+#endif
+
+/// The output file of an API layer's file record types, kept open from one record to the next.
+///
+/// Output is buffered, and written to the file when kBufferSize bytes have accumulated, when a record is written
+/// more than FlushInterval() after the last flush, on Flush() and Close(), and when the layer is unloaded.  On
+/// POSIX platforms the file is also flushed, as a best effort, when the process receives a fatal signal.
+///
+/// In layers built with BUILD_API_LAYERS_WITH_ZLIB, a file name ending in ".gz" is written gzip-compressed, on a
+/// thread of its own (see layer_record_gzip.h).  Its flushes make what was written so far readable, but it is not
+/// flushed on a fatal signal.
+///
+/// Not thread safe: callers serialize access with their record mutex.
+class LayerRecordFile {
+   public:
+    static constexpr size_t kBufferSize = 64 * 1024;
+
+    LayerRecordFile() = default;
+    LayerRecordFile(const LayerRecordFile &) = delete;
+    LayerRecordFile &operator=(const LayerRecordFile &) = delete;
+    ~LayerRecordFile() {
+        Close();
+        UninstallCrashFlush();
+    }
+
+    /// Open file_name, truncating it, e.g. to start it with a header.
+    std::ostream &Truncate(const std::string &file_name) {
+        Open(file_name, std::ios::out | std::ios::trunc);
+        return Out();
+    }
+
+    /// The stream appending to file_name, opened the first time it is needed.
+    std::ostream &Stream(const std::string &file_name) {
+        if (!IsOpen() || file_name != file_name_) {
+            Open(file_name, std::ios::out | std::ios::app);
+        }
+        return Out();
+    }
+
+    /// Call after writing each record: flushes if the last flush was too long ago.
+    void RecordWritten() {
+        if (std::chrono::steady_clock::now() - last_flush_ >= FlushInterval()) {
+            Flush();
+        }
+    }
+
+    void Flush() {
+        if (IsOpen()) {
+            Out().flush();
+        }
+        last_flush_ = std::chrono::steady_clock::now();
+    }
+
+    void Close() {
+        if (file_.is_open()) {
+            file_.close();
+        }
+#if defined(XR_LAYER_RECORD_GZIP)
+        gzip_buf_.Close();
+        gzip_stream_.clear();
+#endif
+        file_name_.clear();
+    }
+
+   private:
+    static std::chrono::milliseconds FlushInterval() { return std::chrono::milliseconds(100); }
+
+#if defined(XR_LAYER_RECORD_GZIP)
+    static bool IsGzipName(const std::string &file_name) {
+        return file_name.size() > 3 && 0 == file_name.compare(file_name.size() - 3, 3, ".gz");
+    }
+
+    bool IsOpen() const { return file_.is_open() || gzip_buf_.IsOpen(); }
+    std::ostream &Out() { return gzip_buf_.IsOpen() ? gzip_stream_ : static_cast<std::ostream &>(file_); }
+#else
+    bool IsOpen() const { return file_.is_open(); }
+    std::ostream &Out() { return file_; }
+#endif
+
+    void Open(const std::string &file_name, std::ios::openmode mode) {
+        Close();
+#if defined(XR_LAYER_RECORD_GZIP)
+        if (IsGzipName(file_name)) {
+            if (!gzip_buf_.Open(file_name, (mode & std::ios::app) != 0)) {
+                gzip_stream_.setstate(std::ios::badbit);
+            }
+            file_name_ = file_name;
+            last_flush_ = std::chrono::steady_clock::now();
+            return;
+        }
+#endif
+        // The buffer has to be set before opening to take effect.
+        file_.rdbuf()->pubsetbuf(buffer_, sizeof(buffer_));
+        file_.open(file_name, mode);
+        file_name_ = file_name;
+        last_flush_ = std::chrono::steady_clock::now();
+        InstallCrashFlush();
+    }
+
+    static std::atomic<LayerRecordFile *> &CrashFlushTarget() {
+        static std::atomic<LayerRecordFile *> target{nullptr};
+        return target;
+    }
+
+#if !defined(_WIN32)
+    static constexpr int kFatalSignalCount = 5;
+
+    static const int *FatalSignals() {
+        static const int signals[kFatalSignalCount] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+        return signals;
+    }
+
+    static struct sigaction *PreviousActions() {
+        static struct sigaction previous[kFatalSignalCount];
+        return previous;
+    }
+
+    static void OnFatalSignal(int signal_number) {
+        LayerRecordFile *target = CrashFlushTarget().exchange(nullptr);
+        if (nullptr != target) {
+            target->file_.flush();
+        }
+        // Put back whatever handled the signal before, and let it (or the default action) take over.
+        for (int index = 0; index < kFatalSignalCount; ++index) {
+            if (FatalSignals()[index] == signal_number) {
+                sigaction(signal_number, &PreviousActions()[index], nullptr);
+            }
+        }
+        raise(signal_number);
+    }
+
+    void InstallCrashFlush() {
+        CrashFlushTarget().store(this);
+        if (crash_flush_installed_) {
+            return;
+        }
+        crash_flush_installed_ = true;
+        struct sigaction action = {};
+        action.sa_handler = &LayerRecordFile::OnFatalSignal;
+        sigemptyset(&action.sa_mask);
+        for (int index = 0; index < kFatalSignalCount; ++index) {
+            sigaction(FatalSignals()[index], &action, &PreviousActions()[index]);
+        }
+    }
+
+    // The handler lives in the layer library, so it has to be removed before the library is unloaded.
+    void UninstallCrashFlush() {
+        CrashFlushTarget().store(nullptr);
+        if (!crash_flush_installed_) {
+            return;
+        }
+        crash_flush_installed_ = false;
+        for (int index = 0; index < kFatalSignalCount; ++index) {
+            struct sigaction current = {};
+            sigaction(FatalSignals()[index], nullptr, &current);
+            // Leave alone handlers installed after ours.
+            if (current.sa_handler == &LayerRecordFile::OnFatalSignal) {
+                sigaction(FatalSignals()[index], &PreviousActions()[index], nullptr);
+            }
+        }
+    }
+
+    bool crash_flush_installed_ = false;
+#else
+    void InstallCrashFlush() { CrashFlushTarget().store(this); }
+    void UninstallCrashFlush() { CrashFlushTarget().store(nullptr); }
+#endif
+
+    std::ofstream file_;
+#if defined(XR_LAYER_RECORD_GZIP)
+    LayerGzipWriteBuf gzip_buf_;
+    std::ostream gzip_stream_{&gzip_buf_};
+#endif
+    std::string file_name_;
+    std::chrono::steady_clock::time_point last_flush_;
+    char buffer_[kBufferSize];
+};
+
+#endif  // LAYER_RECORD_FILE_H_
@@ -0,0 +1,214 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef LAYER_RECORD_GZIP_H_
+#define LAYER_RECORD_GZIP_H_ 1
+
+// gzip streams for the API layers' output files, built with BUILD_API_LAYERS_WITH_ZLIB.
+
+#include <zlib.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// A stream buffer writing a gzip file, compressed on a thread of its own so the writer only copies into a chunk.
+///
+/// Full chunks are queued for the compression thread, which holds at most kMaxQueuedChunks of them before the
+/// writer waits.  sync() queues the partial chunk and has the thread flush the compressor, so that everything
+/// written so far can be decompressed even if the file is never closed.
+class LayerGzipWriteBuf : public std::streambuf {
+   public:
+    static constexpr size_t kChunkSize = 64 * 1024;
+    static constexpr size_t kMaxQueuedChunks = 16;
+
+    LayerGzipWriteBuf() = default;
+    LayerGzipWriteBuf(const LayerGzipWriteBuf &) = delete;
+    LayerGzipWriteBuf &operator=(const LayerGzipWriteBuf &) = delete;
+    ~LayerGzipWriteBuf() override { Close(); }
+
+    /// Open file_name, appending a new gzip member to it or replacing it.  Fast compression: the output is mostly
+    /// repeated names and values, which compress well even so.
+    bool Open(const std::string &file_name, bool append) {
+        Close();
+        file_ = gzopen(file_name.c_str(), append ? "ab1" : "wb1");
+        if (nullptr == file_) {
+            return false;
+        }
+        gzbuffer(file_, static_cast<unsigned>(kChunkSize));
+        chunk_.resize(kChunkSize);
+        setp(chunk_.data(), chunk_.data() + chunk_.size());
+        stopping_ = false;
+        thread_ = std::thread(&LayerGzipWriteBuf::Run, this);
+        return true;
+    }
+
+    bool IsOpen() const { return nullptr != file_; }
+
+    /// Compress everything written, finish the file and close it.
+    void Close() {
+        if (nullptr == file_) {
+            return;
+        }
+        Queue(false);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        queued_cv_.notify_one();
+        thread_.join();
+        gzclose(file_);
+        file_ = nullptr;
+        setp(nullptr, nullptr);
+    }
+
+   protected:
+    int_type overflow(int_type ch) override {
+        if (nullptr == file_) {
+            return traits_type::eof();
+        }
+        Queue(false);
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char *data, std::streamsize count) override {
+        std::streamsize written = 0;
+        while (written < count) {
+            if (pptr() == epptr() && traits_type::eq_int_type(overflow(traits_type::eof()), traits_type::eof())) {
+                break;
+            }
+            const std::streamsize room = epptr() - pptr();
+            const std::streamsize part = (count - written) < room ? (count - written) : room;
+            traits_type::copy(pptr(), data + written, static_cast<size_t>(part));
+            pbump(static_cast<int>(part));
+            written += part;
+        }
+        return written;
+    }
+
+    int sync() override {
+        if (nullptr == file_) {
+            return 0;
+        }
+        Queue(true);
+        return 0;
+    }
+
+   private:
+    // Hand the filled part of the current chunk to the compression thread, and continue in a spare chunk.
+    void Queue(bool flush) {
+        const size_t used = static_cast<size_t>(pptr() - pbase());
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            drained_cv_.wait(lock, [&] { return queue_.size() < kMaxQueuedChunks; });
+            if (used == 0 && !flush) {
+                return;
+            }
+            chunk_.resize(used);
+            queue_.emplace_back(std::move(chunk_), flush);
+            if (spare_.empty()) {
+                chunk_.clear();
+            } else {
+                chunk_ = std::move(spare_.back());
+                spare_.pop_back();
+            }
+        }
+        queued_cv_.notify_one();
+        chunk_.resize(kChunkSize);
+        setp(chunk_.data(), chunk_.data() + chunk_.size());
+    }
+
+    void Run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            queued_cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                break;
+            }
+            std::pair<std::vector<char>, bool> chunk = std::move(queue_.front());
+            queue_.erase(queue_.begin());
+            lock.unlock();
+            if (!chunk.first.empty()) {
+                gzwrite(file_, chunk.first.data(), static_cast<unsigned>(chunk.first.size()));
+            }
+            if (chunk.second) {
+                gzflush(file_, Z_SYNC_FLUSH);
+            }
+            lock.lock();
+            spare_.push_back(std::move(chunk.first));
+            drained_cv_.notify_one();
+        }
+    }
+
+    gzFile file_ = nullptr;
+    std::vector<char> chunk_;
+
+    std::mutex mutex_;
+    std::condition_variable queued_cv_;
+    std::condition_variable drained_cv_;
+    // Chunks waiting to be compressed, in order, each with whether to flush the compressor after it.
+    std::vector<std::pair<std::vector<char>, bool>> queue_;
+    std::vector<std::vector<char>> spare_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+/// A stream buffer reading a gzip file, or a file that is not compressed, as it is.
+class LayerGzipReadBuf : public std::streambuf {
+   public:
+    LayerGzipReadBuf() = default;
+    LayerGzipReadBuf(const LayerGzipReadBuf &) = delete;
+    LayerGzipReadBuf &operator=(const LayerGzipReadBuf &) = delete;
+    ~LayerGzipReadBuf() override {
+        if (nullptr != file_) {
+            gzclose(file_);
+        }
+    }
+
+    bool Open(const std::string &file_name) {
+        file_ = gzopen(file_name.c_str(), "rb");
+        return nullptr != file_;
+    }
+
+   protected:
+    int_type underflow() override {
+        if (nullptr == file_) {
+            return traits_type::eof();
+        }
+        const int count = gzread(file_, buffer_, sizeof(buffer_));
+        if (count <= 0) {
+            return traits_type::eof();
+        }
+        setg(buffer_, buffer_, buffer_ + count);
+        return traits_type::to_int_type(buffer_[0]);
+    }
+
+   private:
+    gzFile file_ = nullptr;
+    char buffer_[64 * 1024];
+};
+
+#endif  // LAYER_RECORD_GZIP_H_
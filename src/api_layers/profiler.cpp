@@ -0,0 +1,808 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "profiler.h"
+
+#include "object_info.h"
+#include "platform_utils.hpp"
+#include "xr_generated_dispatch_table.h"
+#include "xr_generated_profiler.hpp"
+
+#include <openxr/openxr.h>
+#include <openxr/openxr_loader_negotiation.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__ANDROID__)
+#include "android/log.h"
+#endif
+
+#if defined(XR_OS_LINUX) || defined(XR_OS_ANDROID)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && __GNUC__ >= 4
+#define LAYER_EXPORT __attribute__((visibility("default")))
+#elif defined(__SUNPRO_C) && (__SUNPRO_C >= 0x590)
+#define LAYER_EXPORT __attribute__((visibility("default")))
+#elif defined(_WIN32)
+#define LAYER_EXPORT __declspec(dllexport)
+#else
+#define LAYER_EXPORT
+#endif
+
+// For routing platform_utils.hpp messages.
+void LogPlatformUtilsError(const std::string &message) {
+#if defined(__ANDROID__)
+    __android_log_write(ANDROID_LOG_ERROR, "XrApiLayer_profiler", message.c_str());
+#else
+    std::cerr << message << std::endl;
+#endif
+}
+
+namespace {
+
+// Call times are kept in a histogram with a bucket for each of 0 to 3 ns, then four buckets per power of two, up to
+// 2^40 ns (about 18 minutes).  That bounds the error of the percentiles to a quarter of their value.
+const int kProfilerHistogramBucketCount = 160;
+
+int ProfilerHistogramBucket(uint64_t nanoseconds) {
+    if (nanoseconds < 4) {
+        return static_cast<int>(nanoseconds);
+    }
+    int exponent = 0;
+    for (uint64_t value = nanoseconds; value > 1; value >>= 1) {
+        ++exponent;
+    }
+    const int bucket = 4 * (exponent - 1) + static_cast<int>((nanoseconds >> (exponent - 2)) & 3);
+    return std::min(bucket, kProfilerHistogramBucketCount - 1);
+}
+
+// The smallest time that falls into a bucket.
+uint64_t ProfilerHistogramBucketStart(int bucket) {
+    if (bucket < 4) {
+        return static_cast<uint64_t>(bucket);
+    }
+    const int exponent = bucket / 4 + 1;
+    return static_cast<uint64_t>(4 + bucket % 4) << (exponent - 2);
+}
+
+// The calls of one command made by one thread.  Only that thread writes, so the counters are updated with plain loads
+// and stores; they are atomic so that an export from another thread can read them at any time.
+struct ProfilerCommandStats {
+    ProfilerCommandStats() {
+        for (auto &bucket : histogram) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void Add(uint64_t nanoseconds) {
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+        if (nanoseconds < min.load(std::memory_order_relaxed)) {
+            min.store(nanoseconds, std::memory_order_relaxed);
+        }
+        if (nanoseconds > max.load(std::memory_order_relaxed)) {
+            max.store(nanoseconds, std::memory_order_relaxed);
+        }
+        std::atomic<uint32_t> &bucket = histogram[ProfilerHistogramBucket(nanoseconds)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> min{UINT64_MAX};
+    std::atomic<uint64_t> max{0};
+    std::atomic<uint32_t> histogram[kProfilerHistogramBucketCount];
+};
+
+// The statistics of one thread, allocated for each command on its first call from the thread.
+struct ProfilerThreadStats {
+    ProfilerThreadStats() {
+        for (auto &command : commands) {
+            command.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+    ~ProfilerThreadStats() {
+        for (auto &command : commands) {
+            delete command.load(std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t index = 0;
+    std::string id;
+    std::atomic<ProfilerCommandStats *> commands[PROFILER_COMMAND_COUNT];
+
+    // Trace events not yet written to the trace file.  The mutex is only contended while the trace is flushed.
+    uint64_t os_thread_id = 0;
+    std::mutex trace_mutex;
+    std::string trace_events;
+};
+
+uint64_t ProfilerOsProcessId() {
+#if defined(XR_OS_WINDOWS)
+    return static_cast<uint64_t>(GetCurrentProcessId());
+#elif defined(XR_OS_LINUX) || defined(XR_OS_ANDROID)
+    return static_cast<uint64_t>(getpid());
+#else
+    return 0;
+#endif
+}
+
+// The ID the OS, and so other tracing tools, use for the calling thread.
+uint64_t ProfilerOsThreadId(uint32_t thread_index) {
+#if defined(XR_OS_WINDOWS)
+    (void)thread_index;
+    return static_cast<uint64_t>(GetCurrentThreadId());
+#elif defined(XR_OS_LINUX) || defined(XR_OS_ANDROID)
+    (void)thread_index;
+    return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+    return thread_index;
+#endif
+}
+
+// Every thread that ever called into the layer.  Statistics of threads that have exited are kept for the export.
+struct ProfilerThreads {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ProfilerThreadStats>> threads;
+};
+
+ProfilerThreads &GetProfilerThreads() {
+    static ProfilerThreads threads;
+    return threads;
+}
+
+ProfilerThreadStats *GetProfilerThreadStats() {
+    static thread_local ProfilerThreadStats *thread_stats = nullptr;
+    if (nullptr == thread_stats) {
+        std::unique_ptr<ProfilerThreadStats> created(new (std::nothrow) ProfilerThreadStats());
+        if (!created) {
+            return nullptr;
+        }
+        std::ostringstream oss;
+        oss << std::this_thread::get_id();
+        created->id = oss.str();
+        ProfilerThreads &threads = GetProfilerThreads();
+        std::unique_lock<std::mutex> lock(threads.mutex);
+        created->index = static_cast<uint32_t>(threads.threads.size());
+        created->os_thread_id = ProfilerOsThreadId(created->index);
+        thread_stats = created.get();
+        threads.threads.push_back(std::move(created));
+    }
+    return thread_stats;
+}
+
+// The statistics of one command, summed over threads when exporting.
+struct ProfilerSummary {
+    void Add(const ProfilerCommandStats &stats) {
+        count += stats.count.load(std::memory_order_relaxed);
+        total += stats.total.load(std::memory_order_relaxed);
+        min = std::min(min, stats.min.load(std::memory_order_relaxed));
+        max = std::max(max, stats.max.load(std::memory_order_relaxed));
+        for (int bucket = 0; bucket < kProfilerHistogramBucketCount; ++bucket) {
+            histogram[bucket] += stats.histogram[bucket].load(std::memory_order_relaxed);
+        }
+    }
+
+    // The start of the bucket holding the given fraction of the calls, clamped to the exact extremes.
+    uint64_t Percentile(double fraction) const {
+        const uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(count));
+        uint64_t seen = 0;
+        for (int bucket = 0; bucket < kProfilerHistogramBucketCount; ++bucket) {
+            seen += histogram[bucket];
+            if (seen > rank) {
+                return std::max(min, std::min(max, ProfilerHistogramBucketStart(bucket)));
+            }
+        }
+        return max;
+    }
+
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+    uint64_t histogram[kProfilerHistogramBucketCount] = {};
+};
+
+struct ProfilerThreadSummary {
+    uint32_t index;
+    std::string id;
+    ProfilerSummary summary;
+};
+
+struct ProfilerCommandSummary {
+    const char *name;
+    ProfilerSummary summary;
+    std::vector<ProfilerThreadSummary> threads;
+};
+
+// The commands that have been called, most total time first.
+std::vector<ProfilerCommandSummary> ProfilerSnapshot() {
+    std::vector<ProfilerCommandSummary> commands;
+    ProfilerThreads &threads = GetProfilerThreads();
+    std::unique_lock<std::mutex> lock(threads.mutex);
+    for (int command = 0; command < PROFILER_COMMAND_COUNT; ++command) {
+        ProfilerCommandSummary command_summary{kProfilerCommandNames[command], {}, {}};
+        for (const auto &thread : threads.threads) {
+            const ProfilerCommandStats *stats = thread->commands[command].load(std::memory_order_acquire);
+            if (nullptr == stats || 0 == stats->count.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            ProfilerThreadSummary thread_summary{thread->index, thread->id, {}};
+            thread_summary.summary.Add(*stats);
+            command_summary.summary.Add(*stats);
+            command_summary.threads.push_back(std::move(thread_summary));
+        }
+        if (0 != command_summary.summary.count) {
+            commands.push_back(std::move(command_summary));
+        }
+    }
+    std::stable_sort(commands.begin(), commands.end(), [](const ProfilerCommandSummary &a, const ProfilerCommandSummary &b) {
+        return a.summary.total > b.summary.total;
+    });
+    return commands;
+}
+
+void ProfilerWriteTextRow(std::ostream &out, const std::string &name, const std::string &thread, const ProfilerSummary &summary) {
+    out << std::left << std::setw(48) << name << std::setw(8) << thread << std::right << std::setw(12) << summary.count
+        << std::setw(16) << summary.total << std::setw(12) << summary.min << std::setw(12) << summary.max << std::setw(12)
+        << summary.Percentile(0.5) << std::setw(12) << summary.Percentile(0.99) << "\n";
+}
+
+void ProfilerWriteText(std::ostream &out, const std::vector<ProfilerCommandSummary> &commands, const std::string &reason) {
+    out << "OpenXR profiler statistics at " << reason << ", wall time per call in ns\n";
+    out << std::left << std::setw(48) << "command" << std::setw(8) << "thread" << std::right << std::setw(12) << "count"
+        << std::setw(16) << "total" << std::setw(12) << "min" << std::setw(12) << "max" << std::setw(12) << "p50"
+        << std::setw(12) << "p99"
+        << "\n";
+    for (const auto &command : commands) {
+        ProfilerWriteTextRow(out, command.name, "all", command.summary);
+        for (const auto &thread : command.threads) {
+            ProfilerWriteTextRow(out, "", std::to_string(thread.index), thread.summary);
+        }
+    }
+}
+
+void ProfilerWriteJsonStats(std::ostream &out, const ProfilerSummary &summary) {
+    out << "\"count\":" << summary.count << ",\"total_ns\":" << summary.total << ",\"min_ns\":" << summary.min
+        << ",\"max_ns\":" << summary.max << ",\"p50_ns\":" << summary.Percentile(0.5)
+        << ",\"p99_ns\":" << summary.Percentile(0.99);
+}
+
+void ProfilerWriteJson(std::ostream &out, const std::vector<ProfilerCommandSummary> &commands, const std::string &reason) {
+    out << "{\"reason\":\"" << reason << "\",\"commands\":[";
+    for (size_t command = 0; command < commands.size(); ++command) {
+        out << (command == 0 ? "\n" : ",\n") << "{\"name\":\"" << commands[command].name << "\",";
+        ProfilerWriteJsonStats(out, commands[command].summary);
+        out << ",\"threads\":[";
+        for (size_t thread = 0; thread < commands[command].threads.size(); ++thread) {
+            const ProfilerThreadSummary &thread_summary = commands[command].threads[thread];
+            out << (thread == 0 ? "" : ",") << "{\"thread\":" << thread_summary.index << ",\"id\":\"" << thread_summary.id
+                << "\",";
+            ProfilerWriteJsonStats(out, thread_summary.summary);
+            out << "}";
+        }
+        out << "]}";
+    }
+    out << "\n]}\n";
+}
+
+struct ProfilerSettings {
+    std::string file_name;
+    std::string trigger_message_id;
+    std::string trace_file_name;
+};
+
+const ProfilerSettings &GetProfilerSettings() {
+    static const ProfilerSettings settings = [] {
+        ProfilerSettings loaded;
+#if !defined(__ANDROID__)
+        loaded.file_name = PlatformUtilsGetEnv("XR_PROFILER_FILE_NAME");
+        loaded.trigger_message_id = PlatformUtilsGetEnv("XR_PROFILER_TRIGGER");
+        loaded.trace_file_name = PlatformUtilsGetEnv("XR_PROFILER_TRACE_FILE_NAME");
+#else
+        loaded.file_name = PlatformUtilsGetAndroidSystemProperty("debug.profiler_file_name");
+        loaded.trigger_message_id = PlatformUtilsGetAndroidSystemProperty("debug.profiler_trigger");
+        loaded.trace_file_name = PlatformUtilsGetAndroidSystemProperty("debug.profiler_trace_file_name");
+#endif
+        if (loaded.trigger_message_id.empty()) {
+            loaded.trigger_message_id = "profiler_export";
+        }
+        return loaded;
+    }();
+    return settings;
+}
+
+bool ProfilerTracing() { return !GetProfilerSettings().trace_file_name.empty(); }
+
+std::string ProfilerJsonEscape(const char *text) {
+    std::string escaped;
+    for (const char *c = text; nullptr != c && '\0' != *c; ++c) {
+        if ('"' == *c || '\\' == *c) {
+            escaped += '\\';
+            escaped += *c;
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            std::ostringstream oss;
+            oss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(*c);
+            escaped += oss.str();
+        } else {
+            escaped += *c;
+        }
+    }
+    return escaped;
+}
+
+// Trace timestamps are steady_clock (CLOCK_MONOTONIC on Linux and Android) in microseconds.
+std::string ProfilerTraceTimestamp(std::chrono::steady_clock::time_point time) {
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    std::ostringstream oss;
+    oss << nanoseconds / 1000 << "." << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+    return oss.str();
+}
+
+// The Chrome JSON trace file.  Events are buffered per thread and written here in blocks.
+void ProfilerTraceFlush();
+
+class ProfilerTraceFile {
+   public:
+    // Constructed on the first event, after the thread registry, so it can still flush the threads when the layer is
+    // unloaded.
+    ~ProfilerTraceFile() {
+        ProfilerTraceFlush();
+        Close();
+    }
+
+    void Write(const std::string &events) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!Open()) {
+            return;
+        }
+        file_ << events;
+    }
+
+    void Flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (file_.is_open()) {
+            file_.flush();
+        }
+    }
+
+   private:
+    // Call with mutex_ held.
+    bool Open() {
+        if (file_.is_open()) {
+            return true;
+        }
+        if (open_failed_) {
+            return false;
+        }
+        const std::string &file_name = GetProfilerSettings().trace_file_name;
+        file_.open(file_name, std::ios::out | std::ios::trunc);
+        if (!file_.is_open()) {
+            open_failed_ = true;
+            LogPlatformUtilsError("XrApiLayer_profiler could not open " + file_name);
+            return false;
+        }
+        // Every event is followed by a comma, so the file ends with an event without one; a file cut short by a crash
+        // still loads in the trace viewers.
+        file_ << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        return true;
+    }
+
+    void Close() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (file_.is_open()) {
+            file_ << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << ProfilerOsProcessId()
+                  << ",\"args\":{\"name\":\"OpenXR\"}}\n]}\n";
+            file_.close();
+        }
+    }
+
+    std::mutex mutex_;
+    std::ofstream file_;
+    bool open_failed_ = false;
+};
+
+ProfilerTraceFile &GetProfilerTraceFile() {
+    static ProfilerTraceFile trace_file;
+    return trace_file;
+}
+
+const size_t kProfilerTraceBufferSize = 64 * 1024;
+
+// Add an event, without its trailing comma, to the calling thread's buffer.
+void ProfilerTraceEvent(ProfilerThreadStats &thread_stats, const std::string &event) {
+    ProfilerTraceFile &trace_file = GetProfilerTraceFile();
+    std::string full_buffer;
+    {
+        std::unique_lock<std::mutex> lock(thread_stats.trace_mutex);
+        thread_stats.trace_events += event;
+        thread_stats.trace_events += ",\n";
+        if (thread_stats.trace_events.size() >= kProfilerTraceBufferSize) {
+            full_buffer.swap(thread_stats.trace_events);
+        }
+    }
+    if (!full_buffer.empty()) {
+        trace_file.Write(full_buffer);
+    }
+}
+
+// Write out the buffered events of every thread.
+void ProfilerTraceFlush() {
+    ProfilerThreads &threads = GetProfilerThreads();
+    std::unique_lock<std::mutex> lock(threads.mutex);
+    for (const auto &thread : threads.threads) {
+        std::string events;
+        {
+            std::unique_lock<std::mutex> thread_lock(thread->trace_mutex);
+            events.swap(thread->trace_events);
+        }
+        if (!events.empty()) {
+            GetProfilerTraceFile().Write(events);
+        }
+    }
+    GetProfilerTraceFile().Flush();
+}
+
+// Frame counters and debug utils labels of each session, for the trace.
+struct ProfilerTraceSessions {
+    std::mutex mutex;
+    std::unordered_map<XrSession, uint64_t> frame_indices;
+    DebugUtilsData debug_utils;
+};
+
+ProfilerTraceSessions &GetProfilerTraceSessions() {
+    static ProfilerTraceSessions sessions;
+    return sessions;
+}
+
+// Label regions are async slices with the session as their ID, so they nest however the application spreads them over
+// threads.
+void ProfilerTraceLabelEvent(const char *phase, XrSession session, const char *label_name) {
+    ProfilerThreadStats *thread_stats = GetProfilerThreadStats();
+    if (nullptr == thread_stats) {
+        return;
+    }
+    std::ostringstream oss;
+    oss << "{\"ph\":\"" << phase << "\",\"cat\":\"debug_utils\",\"name\":\"" << ProfilerJsonEscape(label_name)
+        << "\",\"id\":\"" << ToHexChars(session).text << "\",\"ts\":" << ProfilerTraceTimestamp(std::chrono::steady_clock::now())
+        << ",\"pid\":" << ProfilerOsProcessId() << ",\"tid\":" << thread_stats->os_thread_id << "}";
+    ProfilerTraceEvent(*thread_stats, oss.str());
+}
+
+// Write out the statistics gathered so far, replacing any earlier export.
+void ProfilerExport(const std::string &reason) {
+    static std::mutex export_mutex;
+    std::unique_lock<std::mutex> lock(export_mutex);
+    if (ProfilerTracing()) {
+        ProfilerTraceFlush();
+    }
+    const std::vector<ProfilerCommandSummary> commands = ProfilerSnapshot();
+    const std::string &file_name = GetProfilerSettings().file_name;
+    if (file_name.empty()) {
+        std::ostringstream oss;
+        ProfilerWriteText(oss, commands, reason);
+#if defined(__ANDROID__)
+        std::istringstream lines(oss.str());
+        for (std::string line; std::getline(lines, line);) {
+            __android_log_write(ANDROID_LOG_INFO, "XrApiLayer_profiler", line.c_str());
+        }
+#else
+        std::cout << oss.str() << std::flush;
+#endif
+        return;
+    }
+    std::ofstream file(file_name, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        LogPlatformUtilsError("XrApiLayer_profiler could not open " + file_name);
+        return;
+    }
+    const std::string json_suffix = ".json";
+    if (file_name.size() >= json_suffix.size() &&
+        0 == file_name.compare(file_name.size() - json_suffix.size(), json_suffix.size(), json_suffix)) {
+        ProfilerWriteJson(file, commands, reason);
+    } else {
+        ProfilerWriteText(file, commands, reason);
+    }
+}
+
+// The dispatch tables of the live instances.  Commands go through the one of the most recently created instance.
+std::mutex g_instance_mutex;
+std::unordered_map<XrInstance, std::unique_ptr<XrGeneratedDispatchTable>> g_instance_dispatch;
+
+}  // namespace
+
+std::atomic<XrGeneratedDispatchTable *> &ProfilerNextDispatchPointer() {
+    static std::atomic<XrGeneratedDispatchTable *> next_dispatch{nullptr};
+    return next_dispatch;
+}
+
+void ProfilerRecordCall(ProfilerCommand command, std::chrono::steady_clock::time_point start, uint64_t nanoseconds) noexcept {
+    ProfilerThreadStats *thread_stats = GetProfilerThreadStats();
+    if (nullptr == thread_stats) {
+        return;
+    }
+    if (ProfilerTracing()) {
+        try {
+            std::ostringstream oss;
+            oss << "{\"ph\":\"X\",\"cat\":\"openxr\",\"name\":\"" << kProfilerCommandNames[command]
+                << "\",\"ts\":" << ProfilerTraceTimestamp(start) << ",\"dur\":" << nanoseconds / 1000 << "." << std::setw(3)
+                << std::setfill('0') << nanoseconds % 1000 << ",\"pid\":" << ProfilerOsProcessId()
+                << ",\"tid\":" << thread_stats->os_thread_id << "}";
+            ProfilerTraceEvent(*thread_stats, oss.str());
+        } catch (...) {
+            // Drop the event rather than fail the call.
+        }
+    }
+    ProfilerCommandStats *stats = thread_stats->commands[command].load(std::memory_order_relaxed);
+    if (nullptr == stats) {
+        stats = new (std::nothrow) ProfilerCommandStats();
+        if (nullptr == stats) {
+            return;
+        }
+        thread_stats->commands[command].store(stats, std::memory_order_release);
+    }
+    stats->Add(nanoseconds);
+}
+
+void ProfilerLayerTraceWaitFrame(XrSession session, const XrFrameState *frame_state) {
+    if (!ProfilerTracing() || nullptr == frame_state) {
+        return;
+    }
+    ProfilerThreadStats *thread_stats = GetProfilerThreadStats();
+    if (nullptr == thread_stats) {
+        return;
+    }
+    uint64_t frame_index;
+    {
+        ProfilerTraceSessions &sessions = GetProfilerTraceSessions();
+        std::unique_lock<std::mutex> lock(sessions.mutex);
+        frame_index = ++sessions.frame_indices[session];
+    }
+    // Counter tracks, one per session.  The predicted display time is in ms to keep it readable.
+    std::ostringstream oss;
+    oss << "{\"ph\":\"C\",\"cat\":\"openxr\",\"name\":\"xrWaitFrame " << ToHexChars(session).text
+        << "\",\"ts\":" << ProfilerTraceTimestamp(std::chrono::steady_clock::now()) << ",\"pid\":" << ProfilerOsProcessId()
+        << ",\"tid\":" << thread_stats->os_thread_id << ",\"args\":{\"frame_index\":" << frame_index
+        << ",\"predicted_display_time_ms\":" << std::fixed << std::setprecision(3)
+        << static_cast<double>(frame_state->predictedDisplayTime) / 1000000.0 << "}}";
+    ProfilerTraceEvent(*thread_stats, oss.str());
+}
+
+void ProfilerLayerTraceDestroySession(XrSession session) {
+    if (!ProfilerTracing()) {
+        return;
+    }
+    ProfilerTraceSessions &sessions = GetProfilerTraceSessions();
+    std::unique_lock<std::mutex> lock(sessions.mutex);
+    sessions.frame_indices.erase(session);
+    sessions.debug_utils.DeleteSessionLabels(session);
+}
+
+void ProfilerLayerTraceBeginLabelRegion(XrSession session, const XrDebugUtilsLabelEXT *label_info) {
+    if (!ProfilerTracing() || nullptr == label_info) {
+        return;
+    }
+    {
+        ProfilerTraceSessions &sessions = GetProfilerTraceSessions();
+        std::unique_lock<std::mutex> lock(sessions.mutex);
+        sessions.debug_utils.BeginLabelRegion(session, *label_info);
+    }
+    ProfilerTraceLabelEvent("b", session, label_info->labelName);
+}
+
+void ProfilerLayerTraceEndLabelRegion(XrSession session) {
+    if (!ProfilerTracing()) {
+        return;
+    }
+    std::string label_name;
+    {
+        ProfilerTraceSessions &sessions = GetProfilerTraceSessions();
+        std::unique_lock<std::mutex> lock(sessions.mutex);
+        const char *region_name = sessions.debug_utils.GetInnermostLabelRegionName(session);
+        if (nullptr == region_name) {
+            return;
+        }
+        label_name = region_name;
+        sessions.debug_utils.EndLabelRegion(session);
+    }
+    ProfilerTraceLabelEvent("e", session, label_name.c_str());
+}
+
+void ProfilerLayerTraceInsertLabel(XrSession session, const XrDebugUtilsLabelEXT *label_info) {
+    if (!ProfilerTracing() || nullptr == label_info) {
+        return;
+    }
+    {
+        ProfilerTraceSessions &sessions = GetProfilerTraceSessions();
+        std::unique_lock<std::mutex> lock(sessions.mutex);
+        sessions.debug_utils.InsertLabel(session, *label_info);
+    }
+    ProfilerTraceLabelEvent("n", session, label_info->labelName);
+}
+
+void ProfilerLayerExportTrigger(const char *message_id) {
+    if (nullptr != message_id && GetProfilerSettings().trigger_message_id == message_id) {
+        ProfilerExport("xrSubmitDebugUtilsMessageEXT");
+    }
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL ProfilerLayerXrGetInstanceProcAddr(XrInstance instance, const char *name,
+                                                                  PFN_xrVoidFunction *function) {
+    try {
+        ProfilerCallTimer timer(PROFILER_COMMAND_xrGetInstanceProcAddr);
+        XrGeneratedDispatchTable *gen_dispatch_table = ProfilerNextDispatch();
+        if (nullptr == gen_dispatch_table) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+
+        // Only hand out our wrapper for commands the next layer or runtime provides, so that commands of extensions
+        // that were not enabled keep failing the same way.
+        XrResult result = gen_dispatch_table->GetInstanceProcAddr(instance, name, function);
+        if (XR_SUCCEEDED(result) && nullptr != *function) {
+            PFN_xrVoidFunction layer_function = ProfilerLayerInnerGetInstanceProcAddr(name);
+            if (nullptr != layer_function) {
+                *function = layer_function;
+            }
+        }
+        return result;
+    } catch (...) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL ProfilerLayerXrCreateApiLayerInstance(const XrInstanceCreateInfo *info,
+                                                                     const struct XrApiLayerCreateInfo *apiLayerInfo,
+                                                                     XrInstance *instance) {
+    try {
+        // Validate the API layer info and next API layer info structures before we try to use them
+        if (nullptr == apiLayerInfo || XR_LOADER_INTERFACE_STRUCT_API_LAYER_CREATE_INFO != apiLayerInfo->structType ||
+            XR_API_LAYER_CREATE_INFO_STRUCT_VERSION > apiLayerInfo->structVersion ||
+            sizeof(XrApiLayerCreateInfo) > apiLayerInfo->structSize || nullptr == apiLayerInfo->nextInfo ||
+            XR_LOADER_INTERFACE_STRUCT_API_LAYER_NEXT_INFO != apiLayerInfo->nextInfo->structType ||
+            XR_API_LAYER_NEXT_INFO_STRUCT_VERSION > apiLayerInfo->nextInfo->structVersion ||
+            sizeof(XrApiLayerNextInfo) > apiLayerInfo->nextInfo->structSize ||
+            0 != strcmp("XR_APILAYER_KHRONOS_profiler", apiLayerInfo->nextInfo->layerName) ||
+            nullptr == apiLayerInfo->nextInfo->nextGetInstanceProcAddr ||
+            nullptr == apiLayerInfo->nextInfo->nextCreateApiLayerInstance) {
+            return XR_ERROR_INITIALIZATION_FAILED;
+        }
+
+        // Copy the contents of the layer info struct, but then move the next info up by
+        // one slot so that the next layer gets information.
+        XrApiLayerCreateInfo new_api_layer_info = {};
+        memcpy(&new_api_layer_info, apiLayerInfo, sizeof(XrApiLayerCreateInfo));
+        new_api_layer_info.nextInfo = apiLayerInfo->nextInfo->next;
+
+        // Get the function pointers we need
+        PFN_xrGetInstanceProcAddr next_get_instance_proc_addr = apiLayerInfo->nextInfo->nextGetInstanceProcAddr;
+        PFN_xrCreateApiLayerInstance next_create_api_layer_instance = apiLayerInfo->nextInfo->nextCreateApiLayerInstance;
+
+        // Create the instance, timed as xrCreateInstance
+        XrInstance returned_instance = *instance;
+        XrResult result;
+        {
+            ProfilerCallTimer timer(PROFILER_COMMAND_xrCreateInstance);
+            result = next_create_api_layer_instance(info, &new_api_layer_info, &returned_instance);
+        }
+        *instance = returned_instance;
+        if (XR_FAILED(result)) {
+            return result;
+        }
+
+        // Create the dispatch table to the next levels
+        auto next_dispatch = std::make_unique<XrGeneratedDispatchTable>();
+        GeneratedXrPopulateDispatchTable(next_dispatch.get(), returned_instance, next_get_instance_proc_addr);
+
+        std::unique_lock<std::mutex> lock(g_instance_mutex);
+        if (!g_instance_dispatch.empty()) {
+            LogPlatformUtilsError(
+                "XrApiLayer_profiler supports one instance at a time, calls are now dispatched through the newest one");
+        }
+        ProfilerNextDispatchPointer().store(next_dispatch.get(), std::memory_order_release);
+        g_instance_dispatch[returned_instance] = std::move(next_dispatch);
+
+        return result;
+    } catch (...) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL ProfilerLayerXrDestroyInstance(XrInstance instance) {
+    try {
+        std::unique_ptr<XrGeneratedDispatchTable> next_dispatch;
+        {
+            std::unique_lock<std::mutex> lock(g_instance_mutex);
+            auto it = g_instance_dispatch.find(instance);
+            if (it == g_instance_dispatch.end()) {
+                return XR_ERROR_HANDLE_INVALID;
+            }
+            next_dispatch = std::move(it->second);
+            g_instance_dispatch.erase(it);
+        }
+
+        XrResult result;
+        {
+            ProfilerCallTimer timer(PROFILER_COMMAND_xrDestroyInstance);
+            result = next_dispatch->DestroyInstance(instance);
+        }
+        ProfilerExport("xrDestroyInstance");
+
+        std::unique_lock<std::mutex> lock(g_instance_mutex);
+        XrGeneratedDispatchTable *expected = next_dispatch.get();
+        if (ProfilerNextDispatchPointer().compare_exchange_strong(expected, nullptr)) {
+            // Fall back to another live instance, if there is one.
+            if (!g_instance_dispatch.empty()) {
+                ProfilerNextDispatchPointer().store(g_instance_dispatch.begin()->second.get(), std::memory_order_release);
+            }
+        }
+        return result;
+    } catch (...) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+}
+
+// Function used to negotiate an interface betewen the loader and an API layer.  Each library exposing one or
+// more API layers needs to expose at least this function.
+extern "C" LAYER_EXPORT XRAPI_ATTR XrResult XRAPI_CALL xrNegotiateLoaderApiLayerInterface(
+    const XrNegotiateLoaderInfo *loaderInfo, const char * /*apiLayerName*/, XrNegotiateApiLayerRequest *apiLayerRequest) {
+    if (loaderInfo == nullptr || loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO ||
+        loaderInfo->structVersion != XR_LOADER_INFO_STRUCT_VERSION || loaderInfo->structSize != sizeof(XrNegotiateLoaderInfo)) {
+        LogPlatformUtilsError("loaderInfo struct is not valid");
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_API_LAYER_VERSION ||
+        loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_API_LAYER_VERSION) {
+        LogPlatformUtilsError("loader interface version is not in the range [minInterfaceVersion, maxInterfaceVersion]");
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (loaderInfo->minApiVersion > XR_CURRENT_API_VERSION || loaderInfo->maxApiVersion < XR_CURRENT_API_VERSION) {
+        LogPlatformUtilsError("loader api version is not in the range [minApiVersion, maxApiVersion]");
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (apiLayerRequest == nullptr || apiLayerRequest->structType != XR_LOADER_INTERFACE_STRUCT_API_LAYER_REQUEST ||
+        apiLayerRequest->structVersion != XR_API_LAYER_INFO_STRUCT_VERSION ||
+        apiLayerRequest->structSize != sizeof(XrNegotiateApiLayerRequest)) {
+        LogPlatformUtilsError("apiLayerRequest is not valid");
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+
+    apiLayerRequest->layerInterfaceVersion = XR_CURRENT_LOADER_API_LAYER_VERSION;
+    apiLayerRequest->layerApiVersion = XR_CURRENT_API_VERSION;
+    apiLayerRequest->getInstanceProcAddr = ProfilerLayerXrGetInstanceProcAddr;
+    apiLayerRequest->createApiLayerInstance = ProfilerLayerXrCreateApiLayerInstance;
+
+    return XR_SUCCESS;
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PROFILER_H_
+#define PROFILER_H_ 1
+
+#include "xr_generated_profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+struct XrGeneratedDispatchTable;
+
+// The dispatch table of the one instance the profiler supports at a time, or nullptr without one.
+std::atomic<XrGeneratedDispatchTable *> &ProfilerNextDispatchPointer();
+inline XrGeneratedDispatchTable *ProfilerNextDispatch() { return ProfilerNextDispatchPointer().load(std::memory_order_acquire); }
+
+// Add a call to the statistics of the calling thread, and to the trace if there is one.  Each thread only writes its own
+// counters and trace buffer, so this does not wait for other threads.
+void ProfilerRecordCall(ProfilerCommand command, std::chrono::steady_clock::time_point start, uint64_t nanoseconds) noexcept;
+
+// Times the rest of the scope as one call of a command.
+class ProfilerCallTimer {
+   public:
+    explicit ProfilerCallTimer(ProfilerCommand command) : command_(command), start_(std::chrono::steady_clock::now()) {}
+    ProfilerCallTimer(const ProfilerCallTimer &) = delete;
+    ProfilerCallTimer &operator=(const ProfilerCallTimer &) = delete;
+    ~ProfilerCallTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        ProfilerRecordCall(command_, start_,
+                           static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+   private:
+    ProfilerCommand command_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif  // PROFILER_H_
@@ -26,18 +26,23 @@
 
 #include "api_layer_platform_defines.h"
 #include "hex_and_handles.h"
+#include "layer_handle_registry.h"
 #include "extra_algorithms.h"
 #include "object_info.h"
 
 #include <openxr/openxr.h>
 #include <openxr/openxr_platform.h>
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
 #include <string>
 #include <mutex>
 #include <memory>
+#include <shared_mutex>
+#include <functional>
 
 /// Prints a message to stderr then throws an exception.
 ///
@@ -51,6 +56,8 @@
 struct CoreValidationMessengerInfo {
     XrDebugUtilsMessengerEXT messenger;
     XrDebugUtilsMessengerCreateInfoEXT *create_info;
+    // Held while the callback runs, unless callbacks are set to be concurrent.
+    std::mutex callback_mutex;
 };
 
 struct XrGeneratedDispatchTable;
@@ -73,6 +80,9 @@ typedef std::unique_ptr<XrDebugUtilsObjectNameInfoEXT, XrDebugUtilsObjectNameInf
 
 typedef std::unique_ptr<CoreValidationMessengerInfo, CoreValidationMessengerInfoDeleter> UniqueCoreValidationMessengerInfo;
 
+// Messengers are shared with the snapshots of the list that messages are being sent to.
+typedef std::vector<std::shared_ptr<CoreValidationMessengerInfo>> CoreValidationMessengerList;
+
 // Define the instance struct used for passing information around.
 // This information includes things like the dispatch table as well as the
 // enabled extensions.
@@ -82,8 +92,19 @@ struct GenValidUsageXrInstanceInfo {
     XrInstance const instance;
     XrGeneratedDispatchTable *dispatch_table;
     std::vector<std::string> enabled_extensions;
-    std::vector<UniqueCoreValidationMessengerInfo> debug_messengers;
     DebugUtilsData debug_data;
+    // Guards debug_data, which is read for every message sent to a messenger.
+    std::mutex debug_data_mutex;
+
+    /// The current messengers.  The list is copied on write, so a snapshot can be used without holding a lock.
+    std::shared_ptr<const CoreValidationMessengerList> GetDebugMessengers();
+    void AddDebugMessenger(UniqueCoreValidationMessengerInfo messenger_info);
+    void RemoveDebugMessenger(XrDebugUtilsMessengerEXT messenger);
+    void ClearDebugMessengers();
+
+   private:
+    std::mutex debug_messengers_mutex_;
+    std::shared_ptr<const CoreValidationMessengerList> debug_messengers_;
 };
 
 // Structure used for storing information for other handles
@@ -93,13 +114,6 @@ struct GenValidUsageXrHandleInfo {
     uint64_t direct_parent_handle;
 };
 
-// Structure used for storing session label information
-struct GenValidUsageXrInternalSessionLabel {
-    XrDebugUtilsLabelEXT debug_utils_label;
-    std::string label_name;
-    bool is_individual_label;
-};
-
 // Enum used for indicating handle validation status.
 enum ValidateXrHandleResult {
     VALIDATE_XR_HANDLE_NULL,
@@ -107,11 +121,10 @@ enum ValidateXrHandleResult {
     VALIDATE_XR_HANDLE_SUCCESS,
 };
 
-// Unordered Map associating pointer to a vector of session label information to a session's handle
-extern std::unordered_map<XrSession, std::vector<GenValidUsageXrInternalSessionLabel *> *> g_xr_session_labels;
-
-// This function is used to delete session labels when a session is destroyed
+// This function is used to delete session labels when a session is destroyed.  The labels themselves are kept by
+// the instance's DebugUtilsData.
 extern void CoreValidationDeleteSessionLabels(XrSession session);
+extern void CoreValidationDeleteSessionFrameCache(XrSession session);
 
 // Object information used for logging.
 struct GenValidUsageXrObjectInfo {
@@ -122,6 +135,31 @@ struct GenValidUsageXrObjectInfo {
     GenValidUsageXrObjectInfo(T h, XrObjectType t) : handle(MakeHandleGeneric(h)), type(t) {}
 };
 
+/// Fixed-capacity list of the objects a validated call refers to, the handles it was passed, kept on the stack.  Calls
+/// that validate without a message, nearly all of them, so do not allocate for it: a message copies the objects out.
+/// Objects beyond the capacity are not recorded; no command comes close to it.
+class GenValidUsageXrObjectInfoList {
+   public:
+    static constexpr size_t kCapacity = 4;
+
+    template <typename T>
+    void emplace_back(T handle, XrObjectType type) {
+        if (count_ < kCapacity) {
+            objects_[count_++] = GenValidUsageXrObjectInfo(handle, type);
+        }
+    }
+    bool empty() const { return count_ == 0; }
+    size_t size() const { return count_; }
+    const GenValidUsageXrObjectInfo *begin() const { return objects_; }
+    const GenValidUsageXrObjectInfo *end() const { return objects_ + count_; }
+
+    operator std::vector<GenValidUsageXrObjectInfo>() const { return std::vector<GenValidUsageXrObjectInfo>(begin(), end()); }
+
+   private:
+    GenValidUsageXrObjectInfo objects_[kCapacity];
+    size_t count_ = 0;
+};
+
 // Debug message severity levels for logging.
 enum GenValidUsageDebugSeverity {
     VALID_USAGE_DEBUG_SEVERITY_DEBUG = 0,
@@ -133,7 +171,25 @@ enum GenValidUsageDebugSeverity {
 // in core_validation.cpp
 void EraseAllInstanceTableMapElements(GenValidUsageXrInstanceInfo *search_value);
 
-typedef std::unique_lock<std::mutex> UniqueLock;
+// in core_validation.cpp
+// Whether this call of a sampled per-frame command gets full parameter validation, given that command's call counter.
+// Every call is validated unless XR_CORE_VALIDATION_SAMPLE_RATE is set above 1.
+bool CoreValidationSampleCall(std::atomic<uint32_t> &call_count);
+
+// Whether this xrEndFrame call is structurally the same as the last one fully validated in its session, with all its
+// handles still valid, so it need not be fully validated again.  Always false unless XR_CORE_VALIDATION_FRAME_CACHE is
+// set above 1.  When false, the caller fully validates the call and reports success with CoreValidationFrameEndValidated.
+bool CoreValidationFrameEndUnchanged(XrSession session, const XrFrameEndInfo *frame_end_info);
+void CoreValidationFrameEndValidated(XrSession session);
+
+typedef std::unique_lock<std::shared_timed_mutex> UniqueLock;
+typedef std::shared_lock<std::shared_timed_mutex> SharedLock;
+
+/// Handle to info map.  The infos are owned by a map that only creating and destroying handles lock, and looked up
+/// through a LayerHandleRegistry, so lookups, which are done on every validated call, take no lock at all.
+///
+/// Callers that modify an info hold one of a set of striped locks, picked by the handle, which erasing the handle
+/// also takes: the info is not destroyed under them.
 template <typename HandleType, typename InfoType>
 class HandleInfoBase {
    public:
@@ -151,10 +207,10 @@ class HandleInfoBase {
     /// Throws if not found.
     InfoType *get(HandleType handle);
 
-    /// Lookup a handle, returning a pointer (if found) as well as a lock for this object's dispatch mutex.
+    /// Lookup a handle, returning a pointer (if found) as well as an exclusive lock for modifying it.
     std::pair<UniqueLock, InfoType *> getWithLock(HandleType handle);
 
-    bool empty() const { return info_map_.empty(); }
+    bool empty() const;
 
     /// Insert an info for the supplied handle.
     /// Throws if it's already there.
@@ -164,15 +220,32 @@ class HandleInfoBase {
     /// Throws if not found.
     void erase(HandleType handle);
 
-    /// Get a constant reference to the whole map as well as a lock for this object's dispatch mutex.
-    std::pair<UniqueLock, map_t const &> lockMapConst();
-
-    /// Get a  reference to the whole map as well as a lock for this object's dispatch mutex.
-    std::pair<UniqueLock, map_t &> lockMap();
+    /// Remove every entry for which the predicate returns true.
+    template <typename Pred>
+    void eraseIf(Pred &&pred);
 
    protected:
-    map_t info_map_;
-    std::mutex dispatch_mutex_;
+    static constexpr size_t kLockCount = 16;
+
+    // Each lock sits on its own cache line so modifiers of one handle do not bounce the lock of another.
+    struct alignas(64) InfoLock {
+        std::shared_timed_mutex mutex;
+    };
+
+    std::shared_timed_mutex &lockFor(HandleType handle) {
+        // Handles that are pointers have their low bits clear, so fold higher bits in before picking a lock.
+        size_t bits = std::hash<HandleType>()(handle);
+        bits ^= (bits >> 7) ^ (bits >> 17);
+        return info_locks_[bits % kLockCount].mutex;
+    }
+
+    /// Remove a handle and destroy its info, if it is there.  False if it was not.
+    bool eraseIfPresent(HandleType handle);
+
+    LayerHandleRegistry<HandleType, InfoType> registry_;
+    InfoLock info_locks_[kLockCount];
+    mutable std::mutex owned_mutex_;
+    map_t owned_;
 };
 
 /// Subclass used exclusively for instances.
@@ -205,47 +278,77 @@ void CoreValidLogMessage(GenValidUsageXrInstanceInfo *instance_info, const std::
                          std::vector<GenValidUsageXrObjectInfo> objects_info, const std::string &message);
 
 void InvalidStructureType(GenValidUsageXrInstanceInfo *instance_info, const std::string &command_name,
-                          std::vector<GenValidUsageXrObjectInfo> &objects_info, const char *structure_name, XrStructureType type,
+                          GenValidUsageXrObjectInfoList &objects_info, const char *structure_name, XrStructureType type,
                           const char *vuid = nullptr, XrStructureType expected = XrStructureType(0),
                           const char *expected_name = "");
 
-std::string StructTypesToString(GenValidUsageXrInstanceInfo *instance_info, const std::unordered_set<XrStructureType> &structs);
+/// Non-owning list of structure types, such as the types permitted in a next chain.
+struct StructTypeSpan {
+    const XrStructureType *types;
+    size_t count;
+
+    bool contains(XrStructureType type) const { return std::find(types, types + count, type) != types + count; }
+};
+
+/// Fixed-capacity set of structure types kept on the stack, used while walking a next chain so that validation does
+/// not allocate.  Types beyond the capacity are not recorded; no real chain comes close to it.
+class StructTypeSet {
+   public:
+    static constexpr size_t kCapacity = 32;
+
+    bool contains(XrStructureType type) const { return span().contains(type); }
+    void insert(XrStructureType type) {
+        if (count_ < kCapacity && !contains(type)) {
+            types_[count_++] = type;
+        }
+    }
+    bool empty() const { return count_ == 0; }
+    StructTypeSpan span() const { return {types_, count_}; }
+
+   private:
+    XrStructureType types_[kCapacity];
+    size_t count_ = 0;
+};
+
+std::string StructTypesToString(GenValidUsageXrInstanceInfo *instance_info, const StructTypeSpan &structs);
 
 // -- Only implementations of templates follow --//
 
-template <typename HT, typename IT>
-inline std::pair<UniqueLock, typename HandleInfoBase<HT, IT>::map_t const &> HandleInfoBase<HT, IT>::lockMapConst() {
-    return {UniqueLock(dispatch_mutex_), info_map_};
+template <typename HandleType, typename InfoType>
+inline bool HandleInfoBase<HandleType, InfoType>::empty() const {
+    std::unique_lock<std::mutex> lock(owned_mutex_);
+    return owned_.empty();
 }
 
-template <typename HT, typename IT>
-inline std::pair<UniqueLock, typename HandleInfoBase<HT, IT>::map_t &> HandleInfoBase<HT, IT>::lockMap() {
-    return {UniqueLock(dispatch_mutex_), info_map_};
+template <typename HandleType, typename InfoType>
+template <typename Pred>
+inline void HandleInfoBase<HandleType, InfoType>::eraseIf(Pred &&pred) {
+    // Pick the handles first: erasing takes the info lock of each before the owning map's.
+    std::vector<HandleType> handles;
+    {
+        std::unique_lock<std::mutex> lock(owned_mutex_);
+        for (const value_t &entry : owned_) {
+            if (pred(entry)) {
+                handles.push_back(entry.first);
+            }
+        }
+    }
+    for (HandleType handle : handles) {
+        eraseIfPresent(handle);
+    }
 }
 
 template <typename HandleType, typename InfoType>
 inline ValidateXrHandleResult HandleInfoBase<HandleType, InfoType>::verifyHandle(HandleType const *handle_to_check) {
-    try {
-        if (nullptr == handle_to_check) {
-            return VALIDATE_XR_HANDLE_INVALID;
-        }
-        // XR_NULL_HANDLE is valid in some cases, so we want to return that we found that value
-        // and let the calling function decide what to do with it.
-        if (*handle_to_check == XR_NULL_HANDLE) {
-            return VALIDATE_XR_HANDLE_NULL;
-        }
-
-        // Try to find the handle in the appropriate map
-        UniqueLock lock(dispatch_mutex_);
-        auto entry_returned = info_map_.find(*handle_to_check);
-        // If it is not a valid handle, it should return the end of the map.
-        if (info_map_.end() == entry_returned) {
-            return VALIDATE_XR_HANDLE_INVALID;
-        }
-        return VALIDATE_XR_HANDLE_SUCCESS;
-    } catch (...) {
+    if (nullptr == handle_to_check) {
         return VALIDATE_XR_HANDLE_INVALID;
     }
+    // XR_NULL_HANDLE is valid in some cases, so we want to return that we found that value
+    // and let the calling function decide what to do with it.
+    if (*handle_to_check == XR_NULL_HANDLE) {
+        return VALIDATE_XR_HANDLE_NULL;
+    }
+    return nullptr == registry_.Find(*handle_to_check) ? VALIDATE_XR_HANDLE_INVALID : VALIDATE_XR_HANDLE_SUCCESS;
 }
 
 template <typename HandleType, typename InfoType>
@@ -253,13 +356,11 @@ inline InfoType *HandleInfoBase<HandleType, InfoType>::get(HandleType handle) {
     if (handle == XR_NULL_HANDLE) {
         reportInternalError("Null handle passed to HandleInfoBase::get()");
     }
-    // Try to find the handle in the appropriate map
-    UniqueLock lock(dispatch_mutex_);
-    auto entry_returned = info_map_.find(handle);
-    if (entry_returned == info_map_.end()) {
+    InfoType *info = registry_.Find(handle);
+    if (nullptr == info) {
         reportInternalError("Handle passed to HandleInfoBase::insert() not inserted");
     }
-    return entry_returned->second.get();
+    return info;
 }
 
 template <typename HandleType, typename InfoType>
@@ -267,14 +368,9 @@ inline std::pair<UniqueLock, InfoType *> HandleInfoBase<HandleType, InfoType>::g
     if (handle == XR_NULL_HANDLE) {
         reportInternalError("Null handle passed to HandleInfoBase::getWithLock()");
     }
-    // Try to find the handle in the appropriate map
-    UniqueLock lock(dispatch_mutex_);
-    auto it = info_map_.find(handle);
-    // If it is not a valid handle, it should return the end of the map.
-    if (info_map_.end() == it) {
-        return {std::move(lock), nullptr};
-    }
-    return {std::move(lock), it->second.get()};
+    // Callers modify the info, so this lock is exclusive.
+    UniqueLock lock(lockFor(handle));
+    return {std::move(lock), registry_.Find(handle)};
 }
 
 template <typename HandleType, typename InfoType>
@@ -282,12 +378,11 @@ inline void HandleInfoBase<HandleType, InfoType>::insert(HandleType handle, std:
     if (handle == XR_NULL_HANDLE) {
         reportInternalError("Null handle passed to HandleInfoBase::insert()");
     }
-    UniqueLock lock(dispatch_mutex_);
-    auto entry_returned = info_map_.find(handle);
-    if (entry_returned != info_map_.end()) {
+    std::unique_lock<std::mutex> lock(owned_mutex_);
+    if (!registry_.Insert(handle, info.get())) {
         reportInternalError("Handle passed to HandleInfoBase::insert() already inserted");
     }
-    info_map_[handle] = std::move(info);
+    owned_[handle] = std::move(info);
 }
 
 template <typename HandleType, typename InfoType>
@@ -295,12 +390,27 @@ inline void HandleInfoBase<HandleType, InfoType>::erase(HandleType handle) {
     if (handle == XR_NULL_HANDLE) {
         reportInternalError("Null handle passed to HandleInfoBase::erase()");
     }
-    UniqueLock lock(dispatch_mutex_);
-    auto entry_returned = info_map_.find(handle);
-    if (entry_returned == info_map_.end()) {
+    if (!eraseIfPresent(handle)) {
         reportInternalError("Handle passed to HandleInfoBase::insert() not inserted");
     }
-    info_map_.erase(handle);
+}
+
+template <typename HandleType, typename InfoType>
+inline bool HandleInfoBase<HandleType, InfoType>::eraseIfPresent(HandleType handle) {
+    UniqueLock info_lock(lockFor(handle));
+    std::unique_ptr<InfoType> info;
+    {
+        std::unique_lock<std::mutex> lock(owned_mutex_);
+        auto entry = owned_.find(handle);
+        if (entry == owned_.end()) {
+            return false;
+        }
+        registry_.Erase(handle);
+        info = std::move(entry->second);
+        owned_.erase(entry);
+    }
+    // The info is destroyed here, under its info lock but not the owning map's.
+    return true;
 }
 
 template <typename HandleType>
@@ -309,22 +419,17 @@ inline std::pair<GenValidUsageXrHandleInfo *, GenValidUsageXrInstanceInfo *> Han
     if (handle == XR_NULL_HANDLE) {
         reportInternalError("Null handle passed to HandleInfoBase::getWithInstanceInfo()");
     }
-    // Try to find the handle in the appropriate map
-    UniqueLock lock(this->dispatch_mutex_);
-    auto entry_returned = this->info_map_.find(handle);
-    if (entry_returned == this->info_map_.end()) {
+    GenValidUsageXrHandleInfo *info = this->registry_.Find(handle);
+    if (nullptr == info) {
         reportInternalError("Handle passed to HandleInfoBase::getWithInstanceInfo() not inserted");
     }
-    GenValidUsageXrHandleInfo *info = entry_returned->second.get();
-    GenValidUsageXrInstanceInfo *instance_info = info->instance_info;
-    return {info, instance_info};
+    return {info, info->instance_info};
 }
 
 template <typename HandleType>
 inline void HandleInfo<HandleType>::removeHandlesForInstance(GenValidUsageXrInstanceInfo *search_value) {
     typedef typename base_t::value_t value_t;
-    UniqueLock lock(this->dispatch_mutex_);
-    map_erase_if(this->info_map_, [=](value_t const &data) { return data.second && data.second->instance_info == search_value; });
+    this->eraseIf([=](value_t const &data) { return data.second && data.second->instance_info == search_value; });
 }
 
 #endif  // VALIDATION_UTILS_H_
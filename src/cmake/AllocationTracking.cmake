@@ -0,0 +1,19 @@
+# Copyright (c) 2017-2025 The Khronos Group Inc.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+# Per-command heap allocation counts in the loader and API layers, from the BUILD_WITH_ALLOCATION_TRACKING option.
+# See src/common/allocation_tracker.hpp.
+
+# Build the allocation tracker into a loader or API layer target.
+function(openxr_add_allocation_tracking TARGET_NAME)
+    if(BUILD_WITH_ALLOCATION_TRACKING)
+        target_sources(${TARGET_NAME} PRIVATE "${PROJECT_SOURCE_DIR}/src/common/allocation_tracker.cpp")
+        # _GLIBCXX_ASSERTIONS stops libstdc++ from declaring std::string's members as instantiated in its own library,
+        # so the string allocations of the target are made by its code, and counted.
+        target_compile_definitions(
+            ${TARGET_NAME} PRIVATE XR_USE_ALLOCATION_TRACKING XR_ALLOCATION_TRACKING_MODULE="${TARGET_NAME}"
+                                   _GLIBCXX_ASSERTIONS
+        )
+    endif()
+endfunction()
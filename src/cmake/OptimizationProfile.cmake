@@ -0,0 +1,64 @@
+# Copyright (c) 2017-2025 The Khronos Group Inc.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+# Link-time and profile-guided optimization of the loader and API layers, from the BUILD_WITH_LTO and OPENXR_PGO options.
+#
+# Profile-guided optimization takes two builds in the same build tree:
+#   1. Configure with OPENXR_PGO=GENERATE, build, then build the openxr_pgo_training target, which runs loader_bench
+#      against the test runtime and writes the profile to OPENXR_PGO_PROFILE_DIR.
+#   2. Reconfigure with OPENXR_PGO=USE and build again.
+# Only GCC and Clang are supported; with Clang, the training target also merges the raw profiles with llvm-profdata.
+
+set(_OPENXR_PGO_VALUES "" GENERATE USE)
+set_property(CACHE OPENXR_PGO PROPERTY STRINGS ${_OPENXR_PGO_VALUES})
+if(NOT OPENXR_PGO IN_LIST _OPENXR_PGO_VALUES)
+    message(FATAL_ERROR "OPENXR_PGO must be empty, GENERATE or USE, not \"${OPENXR_PGO}\"")
+endif()
+
+if(BUILD_WITH_LTO)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT OPENXR_LTO_SUPPORTED OUTPUT _lto_output)
+    if(NOT OPENXR_LTO_SUPPORTED)
+        message(WARNING "BUILD_WITH_LTO is set, but the toolchain does not support it: ${_lto_output}")
+    endif()
+endif()
+
+set(OPENXR_PGO_MERGE_COMMAND)
+if(OPENXR_PGO)
+    if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+        set(_OPENXR_PGO_GENERATE_FLAGS "-fprofile-generate=${OPENXR_PGO_PROFILE_DIR}" -fprofile-update=atomic)
+        # The training run covers the hot paths only, so code it never ran is optimized as usual rather than for size.
+        set(_OPENXR_PGO_USE_FLAGS "-fprofile-use=${OPENXR_PGO_PROFILE_DIR}" -fprofile-partial-training
+                                  -Wno-missing-profile
+        )
+    elseif(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        set(_OPENXR_PGO_PROFDATA "${OPENXR_PGO_PROFILE_DIR}/openxr.profdata")
+        set(_OPENXR_PGO_GENERATE_FLAGS "-fprofile-generate=${OPENXR_PGO_PROFILE_DIR}")
+        set(_OPENXR_PGO_USE_FLAGS "-fprofile-use=${_OPENXR_PGO_PROFDATA}" -Wno-profile-instr-unprofiled)
+        find_program(LLVM_PROFDATA_EXECUTABLE NAMES llvm-profdata)
+        if(NOT LLVM_PROFDATA_EXECUTABLE)
+            message(FATAL_ERROR "OPENXR_PGO with Clang needs llvm-profdata to merge the training profiles")
+        endif()
+        set(OPENXR_PGO_MERGE_COMMAND
+            "${CMAKE_COMMAND}" -D "LLVM_PROFDATA=${LLVM_PROFDATA_EXECUTABLE}" -D "PROFILE_DIR=${OPENXR_PGO_PROFILE_DIR}" -D
+            "OUTPUT=${_OPENXR_PGO_PROFDATA}" -P "${CMAKE_CURRENT_LIST_DIR}/merge_profiles.cmake"
+        )
+    else()
+        message(FATAL_ERROR "OPENXR_PGO is only supported with GCC and Clang")
+    endif()
+endif()
+
+# Apply the optimization profile to a loader or API layer target.
+function(openxr_add_optimization_profile TARGET_NAME)
+    if(BUILD_WITH_LTO AND OPENXR_LTO_SUPPORTED)
+        set_property(TARGET ${TARGET_NAME} PROPERTY INTERPROCEDURAL_OPTIMIZATION TRUE)
+    endif()
+    if(OPENXR_PGO STREQUAL "GENERATE")
+        target_compile_options(${TARGET_NAME} PRIVATE ${_OPENXR_PGO_GENERATE_FLAGS})
+        target_link_options(${TARGET_NAME} PRIVATE ${_OPENXR_PGO_GENERATE_FLAGS})
+    elseif(OPENXR_PGO STREQUAL "USE")
+        target_compile_options(${TARGET_NAME} PRIVATE ${_OPENXR_PGO_USE_FLAGS})
+        target_link_options(${TARGET_NAME} PRIVATE ${_OPENXR_PGO_USE_FLAGS})
+    endif()
+endfunction()
@@ -0,0 +1,34 @@
+# Copyright (c) 2017-2025 The Khronos Group Inc.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+# Platform tracepoints in the loader and API layers, from the BUILD_WITH_PLATFORM_TRACE option: ATrace on Android,
+# TraceLogging (ETW) on Windows and USDT probes on Linux.  See src/common/platform_trace.hpp.
+
+set(OPENXR_PLATFORM_TRACE_SUPPORTED FALSE)
+if(BUILD_WITH_PLATFORM_TRACE)
+    if(ANDROID OR WIN32)
+        set(OPENXR_PLATFORM_TRACE_SUPPORTED TRUE)
+    elseif(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+        include(CheckIncludeFileCXX)
+        check_include_file_cxx(sys/sdt.h HAVE_SYS_SDT_H)
+        if(HAVE_SYS_SDT_H)
+            set(OPENXR_PLATFORM_TRACE_SUPPORTED TRUE)
+        else()
+            message(WARNING "BUILD_WITH_PLATFORM_TRACE is set, but sys/sdt.h (systemtap-sdt-dev) was not found")
+        endif()
+    else()
+        message(WARNING "BUILD_WITH_PLATFORM_TRACE is set, but there are no platform tracepoints for ${CMAKE_SYSTEM_NAME}")
+    endif()
+endif()
+
+# Build the platform tracepoints into a loader or API layer target.
+function(openxr_add_platform_trace TARGET_NAME)
+    if(OPENXR_PLATFORM_TRACE_SUPPORTED)
+        target_compile_definitions(${TARGET_NAME} PRIVATE XR_USE_PLATFORM_TRACE)
+        if(ANDROID)
+            # ATrace_beginSection and ATrace_isEnabled are in libandroid, from API level 23.
+            target_link_libraries(${TARGET_NAME} PRIVATE ${ANDROID_LIBRARY})
+        endif()
+    endif()
+endfunction()
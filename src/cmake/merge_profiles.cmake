@@ -0,0 +1,18 @@
+# Copyright (c) 2017-2025 The Khronos Group Inc.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+# Merge the raw profiles of a Clang training run, for OPENXR_PGO=USE. Run in script mode, with
+#   cmake -D LLVM_PROFDATA=<llvm-profdata> -D PROFILE_DIR=<dir> -D OUTPUT=<profdata> -P merge_profiles.cmake
+
+file(GLOB _raw_profiles "${PROFILE_DIR}/*.profraw")
+if(NOT _raw_profiles)
+    message(FATAL_ERROR "No raw profiles in ${PROFILE_DIR}: run the training with an OPENXR_PGO=GENERATE build first")
+endif()
+execute_process(
+    COMMAND "${LLVM_PROFDATA}" merge -output=${OUTPUT} ${_raw_profiles}
+    RESULT_VARIABLE _result
+)
+if(NOT _result EQUAL 0)
+    message(FATAL_ERROR "llvm-profdata failed to merge the profiles in ${PROFILE_DIR}")
+endif()
@@ -0,0 +1,64 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "allocation_counter.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+// Plain integers, so reading or writing them never allocates.
+thread_local uint64_t g_allocationCount = 0;
+thread_local uint32_t g_untrackedDepth = 0;
+}  // namespace
+
+namespace AllocationCounter {
+
+uint64_t Count() { return g_allocationCount; }
+
+Untracked::Untracked() { g_untrackedDepth++; }
+
+Untracked::~Untracked() { g_untrackedDepth--; }
+
+}  // namespace AllocationCounter
+
+#if ALLOCATION_COUNTER_ENABLED
+
+// The other forms of operator new and delete, including the nothrow and array ones, are specified to call these.
+void* operator new(std::size_t size) {
+    if (g_untrackedDepth == 0) {
+        g_allocationCount++;
+    }
+    for (;;) {
+        void* p = std::malloc(size == 0 ? 1 : size);
+        if (p != nullptr) {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+#endif  // ALLOCATION_COUNTER_ENABLED
@@ -0,0 +1,55 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*!
+ * @file
+ *
+ * A count of the heap allocations made by the calling thread, for checking that code which runs every frame allocates
+ * nothing once it has warmed up.  Linking allocation_counter.cpp into an executable replaces the global operator new
+ * with one that counts, when ALLOCATION_COUNTER_ENABLED is 1, which it is by default in builds without NDEBUG.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#if !defined(ALLOCATION_COUNTER_ENABLED)
+#if defined(NDEBUG)
+#define ALLOCATION_COUNTER_ENABLED 0
+#else
+#define ALLOCATION_COUNTER_ENABLED 1
+#endif
+#endif
+
+namespace AllocationCounter {
+
+constexpr bool Enabled() { return ALLOCATION_COUNTER_ENABLED != 0; }
+
+// The number of operator new calls the calling thread has made outside of Untracked scopes; always 0 when not Enabled().
+uint64_t Count();
+
+// Allocations made by the calling thread while one of these exists are not counted.  For calls into code that
+// allocates as it pleases and is not the caller's to fix, like the OpenXR runtime or a graphics driver.
+class Untracked {
+   public:
+    Untracked();
+    ~Untracked();
+    Untracked(const Untracked&) = delete;
+    Untracked& operator=(const Untracked&) = delete;
+};
+
+}  // namespace AllocationCounter
@@ -0,0 +1,294 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+// The replacement operator new and delete, and the report, of the allocation tracking described in
+// allocation_tracker.hpp.  Added to a module by openxr_add_allocation_tracking in src/cmake/AllocationTracking.cmake.
+
+#include "allocation_tracker.hpp"
+
+#include "platform_utils.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(__ANDROID__)
+#include <android/log.h>
+#endif
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// Set by CMake: the name of the module in its report.
+#ifndef XR_ALLOCATION_TRACKING_MODULE
+#error "XR_ALLOCATION_TRACKING_MODULE must be defined"
+#endif
+
+namespace {
+
+thread_local AllocationScope* t_current_scope = nullptr;
+// Set while the tracker allocates for itself, so those allocations are not counted.
+thread_local bool t_suspended = false;
+
+// The head of the list of every AllocationStats of the module.
+std::atomic<AllocationStats*> g_stats_head{nullptr};
+
+class SuspendTracking {
+   public:
+    SuspendTracking() noexcept : _was_suspended(t_suspended) { t_suspended = true; }
+    ~SuspendTracking() { t_suspended = _was_suspended; }
+
+    SuspendTracking(const SuspendTracking&) = delete;
+    SuspendTracking& operator=(const SuspendTracking&) = delete;
+
+   private:
+    bool _was_suspended;
+};
+
+std::string GetSetting(const char* env_name, const char* property_name) {
+#if defined(__ANDROID__)
+    (void)env_name;
+    return PlatformUtilsGetAndroidSystemProperty(property_name);
+#else
+    (void)property_name;
+    return PlatformUtilsGetEnv(env_name);
+#endif
+}
+
+// Writes the report when the module is unloaded.  Created by the first AllocationStats, so it is destroyed after them.
+class AllocationReport {
+   public:
+    AllocationReport() {
+        SuspendTracking suspend;
+        _file_name = GetSetting("XR_ALLOCATION_REPORT", "debug.xr_allocation_report");
+        const std::string forbid = GetSetting("XR_ALLOCATION_FORBID", "debug.xr_allocation_forbid");
+        for (size_t begin = 0; begin < forbid.size();) {
+            size_t end = std::min(forbid.find(',', begin), forbid.size());
+            if (end > begin) {
+                _forbidden.push_back(forbid.substr(begin, end - begin));
+            }
+            begin = end + 1;
+        }
+    }
+
+    ~AllocationReport() {
+        SuspendTracking suspend;
+        std::vector<const AllocationStats*> stats;
+        for (const AllocationStats* entry = g_stats_head.load(); entry != nullptr; entry = entry->next) {
+            if (entry->calls.load() != 0) {
+                stats.push_back(entry);
+            }
+        }
+        std::sort(stats.begin(), stats.end(),
+                  [](const AllocationStats* a, const AllocationStats* b) { return std::strcmp(a->name, b->name) < 0; });
+
+        std::string report = "# " XR_ALLOCATION_TRACKING_MODULE " heap allocations per command\n";
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-56s %12s %12s %12s %14s\n", "command", "calls", "alloc_calls", "allocations",
+                      "bytes");
+        report += line;
+        for (const AllocationStats* entry : stats) {
+            std::snprintf(line, sizeof(line), "%-56s %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %14" PRIu64 "\n", entry->name,
+                          entry->calls.load(), entry->allocating_calls.load(), entry->allocations.load(), entry->bytes.load());
+            report += line;
+        }
+
+        FILE* file = _file_name.empty() ? nullptr : std::fopen(_file_name.c_str(), "a");
+        if (file != nullptr) {
+            std::fputs(report.c_str(), file);
+            std::fclose(file);
+        } else {
+#if defined(__ANDROID__)
+            __android_log_write(ANDROID_LOG_INFO, "OpenXR", report.c_str());
+#else
+            std::fputs(report.c_str(), stderr);
+#endif
+        }
+    }
+
+    AllocationReport(const AllocationReport&) = delete;
+    AllocationReport& operator=(const AllocationReport&) = delete;
+
+    // Whether XR_ALLOCATION_FORBID names the command of a scope, the last word of its name.
+    bool IsForbidden(const char* name) const {
+        const char* command = std::strrchr(name, ' ');
+        command = command == nullptr ? name : command + 1;
+        return std::find(_forbidden.begin(), _forbidden.end(), command) != _forbidden.end();
+    }
+
+    static AllocationReport& Instance() {
+        static AllocationReport report;
+        return report;
+    }
+
+   private:
+    std::string _file_name;
+    std::vector<std::string> _forbidden;
+};
+
+[[noreturn]] void ReportForbiddenAllocation(const char* name, std::size_t size) {
+    t_suspended = true;
+    char message[256];
+    std::snprintf(message, sizeof(message), "%s: %s allocated %zu bytes after its %" PRIu64 " warm-up calls\n",
+                  XR_ALLOCATION_TRACKING_MODULE, name, size, kAllocationWarmUpCalls);
+#if defined(__ANDROID__)
+    __android_log_write(ANDROID_LOG_FATAL, "OpenXR", message);
+#endif
+    std::fputs(message, stderr);
+    std::abort();
+}
+
+void* Allocate(std::size_t size, std::size_t alignment) noexcept {
+    AllocationScope::Count(size);
+    if (size == 0) {
+        size = 1;
+    }
+    for (;;) {
+        void* memory = nullptr;
+        if (alignment <= alignof(std::max_align_t)) {
+            memory = std::malloc(size);
+        } else {
+#if defined(_WIN32)
+            memory = _aligned_malloc(size, alignment);
+#else
+            if (posix_memalign(&memory, alignment, size) != 0) {
+                memory = nullptr;
+            }
+#endif
+        }
+        if (memory != nullptr) {
+            return memory;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            return nullptr;
+        }
+        handler();
+    }
+}
+
+void* AllocateOrThrow(std::size_t size, std::size_t alignment) {
+    void* memory = Allocate(size, alignment);
+    if (memory == nullptr) {
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+    return memory;
+}
+
+void Free(void* memory, std::size_t alignment) noexcept {
+#if defined(_WIN32)
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(memory);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(memory);
+}
+
+}  // namespace
+
+AllocationStats::AllocationStats(const char* stats_name) noexcept : name(stats_name) {
+    const AllocationReport& report = AllocationReport::Instance();
+    {
+        SuspendTracking suspend;
+        forbidden = report.IsForbidden(name);
+    }
+    next = g_stats_head.load();
+    while (!g_stats_head.compare_exchange_weak(next, this)) {
+    }
+}
+
+AllocationScope::AllocationScope(AllocationStats& stats) noexcept : _stats(stats), _parent(t_current_scope) {
+    const uint64_t call_index = _stats.calls.fetch_add(1, std::memory_order_relaxed);
+    _forbid = (_stats.forbidden && call_index >= kAllocationWarmUpCalls) || (_parent != nullptr && _parent->_forbid);
+    t_current_scope = this;
+}
+
+AllocationScope::~AllocationScope() {
+    t_current_scope = _parent;
+    if (_allocations == 0) {
+        return;
+    }
+    _stats.allocating_calls.fetch_add(1, std::memory_order_relaxed);
+    _stats.allocations.fetch_add(_allocations, std::memory_order_relaxed);
+    _stats.bytes.fetch_add(_bytes, std::memory_order_relaxed);
+    if (_parent != nullptr) {
+        _parent->_allocations += _allocations;
+        _parent->_bytes += _bytes;
+    }
+}
+
+void AllocationScope::Count(std::size_t size) noexcept {
+    AllocationScope* scope = t_current_scope;
+    if (scope == nullptr || t_suspended) {
+        return;
+    }
+    if (scope->_forbid) {
+        ReportForbiddenAllocation(scope->_stats.name, size);
+    }
+    ++scope->_allocations;
+    scope->_bytes += size;
+}
+
+// The replaceable allocation functions.  They stay local to the module, which only exports its entry points (see its
+// version script, export list or DLL), so only the module's own allocations come here.  They allocate with malloc like
+// the standard library's, so memory allocated on one side of the module boundary can still be freed on the other.
+void* operator new(std::size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new[](std::size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return Allocate(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return Allocate(size, 0); }
+#if defined(__cpp_aligned_new)
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return AllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return AllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return Allocate(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return Allocate(size, static_cast<std::size_t>(alignment));
+}
+#endif  // defined(__cpp_aligned_new)
+
+void operator delete(void* memory) noexcept { Free(memory, 0); }
+void operator delete[](void* memory) noexcept { Free(memory, 0); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { Free(memory, 0); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { Free(memory, 0); }
+void operator delete(void* memory, std::size_t) noexcept { Free(memory, 0); }
+void operator delete[](void* memory, std::size_t) noexcept { Free(memory, 0); }
+#if defined(__cpp_aligned_new)
+void operator delete(void* memory, std::align_val_t alignment) noexcept {
+    Free(memory, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* memory, std::align_val_t alignment) noexcept {
+    Free(memory, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept {
+    Free(memory, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* memory, std::size_t, std::align_val_t alignment) noexcept {
+    Free(memory, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    Free(memory, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    Free(memory, static_cast<std::size_t>(alignment));
+}
+#endif  // defined(__cpp_aligned_new)
@@ -0,0 +1,81 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+#pragma once
+
+// Per-command heap allocation counts for the loader and API layers.  They are only built in when
+// XR_USE_ALLOCATION_TRACKING is defined, by the BUILD_WITH_ALLOCATION_TRACKING CMake option, which also adds
+// allocation_tracker.cpp to the module.  Otherwise XR_ALLOCATION_SCOPE expands to nothing.
+//
+// A module built with it replaces operator new and delete with versions that count, on the calling thread, into the
+// innermost open XR_ALLOCATION_SCOPE.  XR_TRACE_SCOPE opens one, so every generated entry point of the loader, api_dump
+// and core_validation is counted.  The replacements are local to the module, so each module only counts its own
+// allocations: a call through the loader and a layer is reported once by each.  Memory the runtime or the application
+// allocates is not counted, nor is memory from malloc.
+//
+// When the module is unloaded it writes, for each command, how many calls there were, how many of them allocated, and
+// how many allocations and bytes they made, to stderr, or appended to the file named by XR_ALLOCATION_REPORT.
+// XR_ALLOCATION_FORBID names commands, like "xrWaitFrame,xrLocateSpace,xrEndFrame", that must not allocate once warmed
+// up: an allocation in one of them after its first kAllocationWarmUpCalls calls aborts the process, with the
+// allocation on the stack.  On Android, the equivalents are the debug.xr_allocation_report and
+// debug.xr_allocation_forbid system properties.
+
+#if defined(XR_USE_ALLOCATION_TRACKING)
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Calls of a forbidden command that may still allocate, filling caches and growing buffers to their steady size.
+constexpr uint64_t kAllocationWarmUpCalls = 16;
+
+// The counts of one command, shared by all threads.  Trivially destructible, so the report written as the module is
+// unloaded can still read it.
+struct AllocationStats {
+    explicit AllocationStats(const char* name) noexcept;
+
+    const char* const name;
+    // Whether XR_ALLOCATION_FORBID names this command.
+    bool forbidden{false};
+    // The next of the module's stats, for the report.
+    AllocationStats* next{nullptr};
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> allocating_calls{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+// Counts the allocations made on this thread until it is destroyed, including those of the scopes opened inside it.
+class AllocationScope {
+   public:
+    explicit AllocationScope(AllocationStats& stats) noexcept;
+    ~AllocationScope();
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    // Called by the replacement operator new for each allocation.
+    static void Count(std::size_t size) noexcept;
+
+   private:
+    AllocationStats& _stats;
+    AllocationScope* _parent;
+    // Set when this call, or the call it is made from, must not allocate.
+    bool _forbid;
+    uint64_t _allocations{0};
+    uint64_t _bytes{0};
+};
+
+#define XR_ALLOCATION_CONCAT_INNER(a, b) a##b
+#define XR_ALLOCATION_CONCAT(a, b) XR_ALLOCATION_CONCAT_INNER(a, b)
+#define XR_ALLOCATION_SCOPE(name)                                                         \
+    static AllocationStats XR_ALLOCATION_CONCAT(xr_allocation_stats_, __LINE__)(name); \
+    AllocationScope XR_ALLOCATION_CONCAT(xr_allocation_scope_, __LINE__)(XR_ALLOCATION_CONCAT(xr_allocation_stats_, __LINE__))
+
+#else  // !defined(XR_USE_ALLOCATION_TRACKING)
+
+#define XR_ALLOCATION_SCOPE(name) ((void)0)
+
+#endif  // defined(XR_USE_ALLOCATION_TRACKING)
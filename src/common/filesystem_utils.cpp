@@ -14,6 +14,8 @@
 
 #include <cstring>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 #if defined DISABLE_STD_FILESYSTEM
 #define USE_EXPERIMENTAL_FS 0
@@ -58,7 +60,7 @@ bool FileSysUtilsIsRegularFile(const std::string& path) { return FS_PREFIX::is_r
 
 bool FileSysUtilsIsDirectory(const std::string& path) { return FS_PREFIX::is_directory(path); }
 
-bool FileSysUtilsPathExists(const std::string& path) { return FS_PREFIX::exists(path); }
+static bool PathExistsUncached(const std::string& path) { return FS_PREFIX::exists(path); }
 
 bool FileSysUtilsIsAbsolutePath(const std::string& path) {
     FS_PREFIX::path file_path(path);
@@ -82,14 +84,19 @@ bool FileSysUtilsGetAbsolutePath(const std::string& path, std::string& absolute)
     return true;
 }
 
-bool FileSysUtilsGetCanonicalPath(const std::string& path, std::string& canonical) {
+static bool GetCanonicalPathUncached(const std::string& path, std::string& canonical) {
 #if defined(XR_USE_PLATFORM_WIN32)
     // std::filesystem::canonical fails on UWP and must be avoided. Further, PathCchCanonicalize is not available on Windows 7 and
     // PathCanonicalizeW is not available on UWP. However, symbolic links are not important on Windows since the loader uses the
     // registry for indirection instead, and so this function can be a no-op on Windows.
     canonical = path;
 #else
-    canonical = FS_PREFIX::canonical(path).string();
+    // Report a missing file or dangling link as a failure, like the POSIX fallback, rather than throwing.
+    std::error_code ec;
+    canonical = FS_PREFIX::canonical(path, ec).string();
+    if (ec) {
+        return false;
+    }
 #endif
     return true;
 }
@@ -114,13 +121,28 @@ bool FileSysUtilsParsePathList(std::string& path_list, std::vector<std::string>&
     return true;
 }
 
-bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::string>& files) {
+static bool FindFilesInPathUncached(const std::string& path, std::vector<std::string>& files) {
     for (auto& dir_iter : FS_PREFIX::directory_iterator(path)) {
         files.push_back(dir_iter.path().filename().string());
     }
     return true;
 }
 
+bool FileSysUtilsGetFileStamp(const std::string& path, uint64_t& modified_time, uint64_t& file_size) {
+    std::error_code ec;
+    auto write_time = FS_PREFIX::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    auto size = FS_PREFIX::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    modified_time = static_cast<uint64_t>(write_time.time_since_epoch().count());
+    file_size = static_cast<uint64_t>(size);
+    return true;
+}
+
 #elif defined(XR_OS_WINDOWS)
 
 // For pre C++17 compiler that doesn't support experimental filesystem
@@ -135,7 +157,7 @@ bool FileSysUtilsIsDirectory(const std::string& path) {
     return attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
 }
 
-bool FileSysUtilsPathExists(const std::string& path) {
+static bool PathExistsUncached(const std::string& path) {
     return (GetFileAttributesW(utf8_to_wide(path).c_str()) != INVALID_FILE_ATTRIBUTES);
 }
 
@@ -176,7 +198,7 @@ bool FileSysUtilsGetAbsolutePath(const std::string& path, std::string& absolute)
     return false;
 }
 
-bool FileSysUtilsGetCanonicalPath(const std::string& path, std::string& absolute) {
+static bool GetCanonicalPathUncached(const std::string& path, std::string& absolute) {
     // PathCchCanonicalize is not available on Windows 7 and PathCanonicalizeW is not available on UWP. However, symbolic links are
     // not important on Windows since the loader uses the registry for indirection instead, and so this function can be a no-op on
     // Windows.
@@ -210,7 +232,7 @@ bool FileSysUtilsParsePathList(std::string& path_list, std::vector<std::string>&
     return true;
 }
 
-bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::string>& files) {
+static bool FindFilesInPathUncached(const std::string& path, std::vector<std::string>& files) {
     std::string searchPath;
     FileSysUtilsCombinePaths(path, "*", searchPath);
 
@@ -227,6 +249,16 @@ bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::strin
     return false;
 }
 
+bool FileSysUtilsGetFileStamp(const std::string& path, uint64_t& modified_time, uint64_t& file_size) {
+    WIN32_FILE_ATTRIBUTE_DATA file_data;
+    if (!GetFileAttributesExW(utf8_to_wide(path).c_str(), GetFileExInfoStandard, &file_data)) {
+        return false;
+    }
+    modified_time = (static_cast<uint64_t>(file_data.ftLastWriteTime.dwHighDateTime) << 32) | file_data.ftLastWriteTime.dwLowDateTime;
+    file_size = (static_cast<uint64_t>(file_data.nFileSizeHigh) << 32) | file_data.nFileSizeLow;
+    return true;
+}
+
 #else  // XR_OS_LINUX/XR_OS_APPLE fallback
 
 // simple POSIX-compatible implementation of the <filesystem> pieces used by OpenXR
@@ -243,7 +275,7 @@ bool FileSysUtilsIsDirectory(const std::string& path) {
     return S_ISDIR(path_stat.st_mode);
 }
 
-bool FileSysUtilsPathExists(const std::string& path) { return (access(path.c_str(), F_OK) != -1); }
+static bool PathExistsUncached(const std::string& path) { return (access(path.c_str(), F_OK) != -1); }
 
 bool FileSysUtilsIsAbsolutePath(const std::string& path) { return (path[0] == DIRECTORY_SYMBOL); }
 
@@ -271,7 +303,7 @@ bool FileSysUtilsGetAbsolutePath(const std::string& path, std::string& absolute)
     return FileSysUtilsGetCanonicalPath(path, absolute);
 }
 
-bool FileSysUtilsGetCanonicalPath(const std::string& path, std::string& canonical) {
+static bool GetCanonicalPathUncached(const std::string& path, std::string& canonical) {
     char buf[PATH_MAX];
     if (nullptr != realpath(path.c_str(), buf)) {
         canonical = buf;
@@ -306,7 +338,7 @@ bool FileSysUtilsParsePathList(std::string& path_list, std::vector<std::string>&
     return true;
 }
 
-bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::string>& files) {
+static bool FindFilesInPathUncached(const std::string& path, std::vector<std::string>& files) {
     DIR* dir = opendir(path.c_str());
     if (dir == nullptr) {
         return false;
@@ -319,4 +351,78 @@ bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::strin
     return true;
 }
 
+bool FileSysUtilsGetFileStamp(const std::string& path, uint64_t& modified_time, uint64_t& file_size) {
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) != 0) {
+        return false;
+    }
+    modified_time = static_cast<uint64_t>(path_stat.st_mtime);
+    file_size = static_cast<uint64_t>(path_stat.st_size);
+    return true;
+}
+
 #endif
+
+struct FileSysUtilsCacheData {
+    std::unordered_map<std::string, bool> path_exists;
+    std::unordered_map<std::string, std::pair<bool, std::string>> canonical_paths;
+    std::unordered_map<std::string, std::pair<bool, std::vector<std::string>>> directory_listings;
+};
+
+// The cache of the outermost FileSysUtilsScopedCache alive on this thread, if any.
+static thread_local FileSysUtilsCacheData* g_active_cache = nullptr;
+
+FileSysUtilsScopedCache::FileSysUtilsScopedCache() {
+    // Nested scopes share the outer cache.
+    if (g_active_cache == nullptr) {
+        _data.reset(new FileSysUtilsCacheData);
+        g_active_cache = _data.get();
+    }
+}
+
+FileSysUtilsScopedCache::~FileSysUtilsScopedCache() {
+    if (_data) {
+        g_active_cache = nullptr;
+    }
+}
+
+bool FileSysUtilsPathExists(const std::string& path) {
+    if (g_active_cache == nullptr) {
+        return PathExistsUncached(path);
+    }
+    auto it = g_active_cache->path_exists.find(path);
+    if (it == g_active_cache->path_exists.end()) {
+        it = g_active_cache->path_exists.emplace(path, PathExistsUncached(path)).first;
+    }
+    return it->second;
+}
+
+bool FileSysUtilsGetCanonicalPath(const std::string& path, std::string& canonical) {
+    if (g_active_cache == nullptr) {
+        return GetCanonicalPathUncached(path, canonical);
+    }
+    auto it = g_active_cache->canonical_paths.find(path);
+    if (it == g_active_cache->canonical_paths.end()) {
+        std::string result;
+        bool success = GetCanonicalPathUncached(path, result);
+        it = g_active_cache->canonical_paths.emplace(path, std::make_pair(success, std::move(result))).first;
+    }
+    if (it->second.first) {
+        canonical = it->second.second;
+    }
+    return it->second.first;
+}
+
+bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::string>& files) {
+    if (g_active_cache == nullptr) {
+        return FindFilesInPathUncached(path, files);
+    }
+    auto it = g_active_cache->directory_listings.find(path);
+    if (it == g_active_cache->directory_listings.end()) {
+        std::vector<std::string> listing;
+        bool success = FindFilesInPathUncached(path, listing);
+        it = g_active_cache->directory_listings.emplace(path, std::make_pair(success, std::move(listing))).first;
+    }
+    files.insert(files.end(), it->second.second.begin(), it->second.second.end());
+    return it->second.first;
+}
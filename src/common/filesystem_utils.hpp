@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -44,3 +46,25 @@ bool FileSysUtilsParsePathList(std::string& path_list, std::vector<std::string>&
 
 // Record all the filenames for files found in the provided path.
 bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::string>& files);
+
+// Get the last modification time and size of a file, used to detect when a file has changed on disk.
+// The modification time is only meaningful when compared against another value from this function.
+bool FileSysUtilsGetFileStamp(const std::string& path, uint64_t& modified_time, uint64_t& file_size);
+
+struct FileSysUtilsCacheData;
+
+// While an instance is alive, FileSysUtilsPathExists, FileSysUtilsGetCanonicalPath and FileSysUtilsFindFilesInPath
+// calls made on the same thread are answered from a cache, so a path that appears in several search variables is
+// only read from disk once.  Meant to cover a single loader operation; results may go stale if kept longer.
+class FileSysUtilsScopedCache {
+   public:
+    FileSysUtilsScopedCache();
+    ~FileSysUtilsScopedCache();
+
+    FileSysUtilsScopedCache(const FileSysUtilsScopedCache&) = delete;
+    FileSysUtilsScopedCache& operator=(const FileSysUtilsScopedCache&) = delete;
+
+   private:
+    // Null when an outer instance on this thread already owns the cache.
+    std::unique_ptr<FileSysUtilsCacheData> _data;
+};
@@ -19,19 +19,28 @@
 #include <openxr/openxr.h>
 
 #include <string>
+#include <stddef.h>
 #include <stdint.h>
 
-inline std::string to_hex(const uint8_t* const data, size_t bytes) {
-    std::string out(2 + bytes * 2, '?');
+/// Room for the hex text of a value of up to 8 bytes, such as a handle, pointer or uint64_t, and its terminator.
+static const size_t kHexStringBufferSize = 19;
+
+/// Write "0x" and the 2 * bytes hex digits of data, most significant first, without a terminator.
+inline void write_hex_digits(const uint8_t* const data, size_t bytes, char* out) {
     out[0] = '0';
     out[1] = 'x';
     static const char* hex = "0123456789abcdef";
-    auto ch = out.end();
+    char* ch = out + 2 + bytes * 2;
     for (size_t i = 0; i < bytes; ++i) {
         auto b = data[i];
         *--ch = hex[(b >> 0) & 0xf];
         *--ch = hex[(b >> 4) & 0xf];
     }
+}
+
+inline std::string to_hex(const uint8_t* const data, size_t bytes) {
+    std::string out(2 + bytes * 2, '?');
+    write_hex_digits(data, bytes, &out[0]);
     return out;
 }
 
@@ -45,6 +54,37 @@ inline std::string to_hex(T* const data) {
     return to_hex(reinterpret_cast<const uint8_t* const>(&data), sizeof(T*));
 }
 
+/// Write the hex text of data, as the overloads above return it, into a caller's buffer instead of a std::string.
+/// Returns out.
+template <typename T>
+inline const char* to_hex(const T& data, char (&out)[kHexStringBufferSize]) {
+    static_assert(sizeof(T) <= 8, "Only values of up to 8 bytes fit the buffer");
+    write_hex_digits(reinterpret_cast<const uint8_t* const>(&data), sizeof(T), out);
+    out[2 + sizeof(T) * 2] = '\0';
+    return out;
+}
+
+/// Append the hex text of data to out, which only allocates if out has to grow.
+template <typename T>
+inline void append_hex(std::string& out, const T& data) {
+    const size_t offset = out.size();
+    out.resize(offset + 2 + sizeof(T) * 2);
+    write_hex_digits(reinterpret_cast<const uint8_t* const>(&data), sizeof(T), &out[offset]);
+}
+
+/// The hex text of a value of up to 8 bytes held by value, for formatting into a stream without a std::string:
+/// oss << ToHexChars(handle).text
+struct HexChars {
+    char text[kHexStringBufferSize];
+};
+
+template <typename T>
+inline HexChars ToHexChars(const T& data) {
+    HexChars chars;
+    to_hex(data, chars.text);
+    return chars;
+}
+
 #if XR_PTR_SIZE == 8
 /// Convert a handle into a same-sized integer.
 template <typename T>
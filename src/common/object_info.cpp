@@ -12,7 +12,6 @@
 
 #include "object_info.h"
 
-#include "extra_algorithms.h"
 #include "hex_and_handles.h"
 
 #include <openxr/openxr.h>
@@ -28,7 +27,7 @@
 
 std::string XrSdkLogObjectInfo::ToString() const {
     std::ostringstream oss;
-    oss << Uint64ToHexString(handle);
+    oss << ToHexChars(handle).text;
     if (!name.empty()) {
         oss << " (" << name << ")";
     }
@@ -43,39 +42,28 @@ void ObjectInfoCollection::AddObjectName(uint64_t object_handle, XrObjectType ob
     }
 
     // Otherwise, add it or update the name
-    XrSdkLogObjectInfo new_obj = {object_handle, object_type};
-
-    // If it already exists, update the name
-    auto lookup_info = LookUpStoredObjectInfo(new_obj);
-    if (lookup_info != nullptr) {
-        lookup_info->name = object_name;
-        return;
-    }
-
-    // It doesn't exist, so add a new info block
-    new_obj.name = object_name;
-    object_info_.push_back(new_obj);
+    auto& stored = object_info_[ObjectKey{object_handle, object_type}];
+    stored.handle = object_handle;
+    stored.type = object_type;
+    stored.name = object_name;
 }
 
 void ObjectInfoCollection::RemoveObject(uint64_t object_handle, XrObjectType object_type) {
-    vector_remove_if_and_erase(
-        object_info_, [=](XrSdkLogObjectInfo const& info) { return info.handle == object_handle && info.type == object_type; });
+    object_info_.erase(ObjectKey{object_handle, object_type});
 }
 
 XrSdkLogObjectInfo const* ObjectInfoCollection::LookUpStoredObjectInfo(XrSdkLogObjectInfo const& info) const {
-    auto e = object_info_.end();
-    auto it = std::find_if(object_info_.begin(), e, [&](XrSdkLogObjectInfo const& stored) { return Equivalent(stored, info); });
-    if (it != e) {
-        return &(*it);
+    auto it = object_info_.find(ObjectKey{info.handle, info.type});
+    if (it != object_info_.end()) {
+        return &it->second;
     }
     return nullptr;
 }
 
 XrSdkLogObjectInfo* ObjectInfoCollection::LookUpStoredObjectInfo(XrSdkLogObjectInfo const& info) {
-    auto e = object_info_.end();
-    auto it = std::find_if(object_info_.begin(), e, [&](XrSdkLogObjectInfo const& stored) { return Equivalent(stored, info); });
-    if (it != e) {
-        return &(*it);
+    auto it = object_info_.find(ObjectKey{info.handle, info.type});
+    if (it != object_info_.end()) {
+        return &it->second;
     }
     return nullptr;
 }
@@ -109,129 +97,172 @@ static std::vector<XrDebugUtilsObjectNameInfoEXT> PopulateObjectNameInfo(std::ve
 }
 
 NamesAndLabels::NamesAndLabels(std::vector<XrSdkLogObjectInfo> obj, std::vector<XrDebugUtilsLabelEXT> lab)
-    : sdk_objects(std::move(obj)), objects(PopulateObjectNameInfo(sdk_objects)), labels(std::move(lab)) {}
+    : sdk_objects(std::move(obj)), labels(std::move(lab)) {}
 
-void NamesAndLabels::PopulateCallbackData(XrDebugUtilsMessengerCallbackDataEXT& callback_data) const {
-    callback_data.objects = objects.empty() ? nullptr : const_cast<XrDebugUtilsObjectNameInfoEXT*>(objects.data());
+const XrDebugUtilsLabelEXT* NamesAndLabels::LabelData() const {
+    if (borrowed_labels != nullptr) {
+        return borrowed_labels;
+    }
+    return labels.empty() ? nullptr : labels.data();
+}
+
+uint32_t NamesAndLabels::LabelCount() const {
+    if (borrowed_labels != nullptr) {
+        return borrowed_label_count;
+    }
+    return static_cast<uint32_t>(labels.size());
+}
+
+void NamesAndLabels::PopulateCallbackData(XrDebugUtilsMessengerCallbackDataEXT& callback_data) {
+    if (objects.size() != sdk_objects.size()) {
+        objects = PopulateObjectNameInfo(sdk_objects);
+    }
+    callback_data.objects = objects.empty() ? nullptr : objects.data();
     callback_data.objectCount = static_cast<uint32_t>(objects.size());
-    callback_data.sessionLabels = labels.empty() ? nullptr : const_cast<XrDebugUtilsLabelEXT*>(labels.data());
-    callback_data.sessionLabelCount = static_cast<uint32_t>(labels.size());
+    callback_data.sessionLabels = const_cast<XrDebugUtilsLabelEXT*>(LabelData());
+    callback_data.sessionLabelCount = LabelCount();
 }
 
 void DebugUtilsData::LookUpSessionLabels(XrSession session, std::vector<XrDebugUtilsLabelEXT>& labels) const {
-    auto session_label_iterator = session_labels_.find(session);
-    if (session_label_iterator != session_labels_.end()) {
-        auto& XrSdkSessionLabels = *session_label_iterator->second;
-        // Copy the debug utils labels in reverse order in the the labels vector.
-        std::transform(XrSdkSessionLabels.rbegin(), XrSdkSessionLabels.rend(), std::back_inserter(labels),
-                       [](XrSdkSessionLabelPtr const& label) { return label->debug_utils_label; });
+    uint32_t label_count = 0;
+    const XrDebugUtilsLabelEXT* session_labels = GetSessionLabels(session, label_count);
+    if (session_labels != nullptr) {
+        // The stack is already stored most recent first.
+        labels.insert(labels.end(), session_labels, session_labels + label_count);
     }
 }
 
-XrSdkSessionLabel::XrSdkSessionLabel(const XrDebugUtilsLabelEXT& label_info, bool individual)
-    : label_name(label_info.labelName), debug_utils_label(label_info), is_individual_label(individual) {
-    // Update the c string pointer to the one we hold.
-    debug_utils_label.labelName = label_name.c_str();
-    // Zero out the next pointer to avoid a dangling pointer
-    debug_utils_label.next = nullptr;
+const XrDebugUtilsLabelEXT* DebugUtilsData::GetSessionLabels(XrSession session, uint32_t& label_count) const {
+    label_count = 0;
+    auto session_label_iterator = session_labels_.find(session);
+    if (session_label_iterator == session_labels_.end() || session_label_iterator->second.labels.empty()) {
+        return nullptr;
+    }
+    label_count = static_cast<uint32_t>(session_label_iterator->second.labels.size());
+    return session_label_iterator->second.labels.data();
 }
 
-XrSdkSessionLabelPtr XrSdkSessionLabel::make(const XrDebugUtilsLabelEXT& label_info, bool individual) {
-    XrSdkSessionLabelPtr ret(new XrSdkSessionLabel(label_info, individual));
-    return ret;
+const char* DebugUtilsData::GetInnermostLabelRegionName(XrSession session) const {
+    auto session_label_iterator = session_labels_.find(session);
+    if (session_label_iterator == session_labels_.end()) {
+        return nullptr;
+    }
+    const XrSdkSessionLabelStack& label_stack = session_label_iterator->second;
+    // Skip the individual label, which is always the most recent one.
+    const size_t region_index = label_stack.has_individual_label ? 1 : 0;
+    if (label_stack.labels.size() <= region_index) {
+        return nullptr;
+    }
+    return label_stack.labels[region_index].labelName;
 }
+
 void DebugUtilsData::AddObjectName(uint64_t object_handle, XrObjectType object_type, const std::string& object_name) {
     object_info_.AddObjectName(object_handle, object_type, object_name);
 }
 
+const char* DebugUtilsData::InternLabelName(const char* label_name) {
+    label_name_lookup_.assign(label_name == nullptr ? "" : label_name);
+    auto name_iterator = label_names_.find(label_name_lookup_);
+    if (name_iterator == label_names_.end()) {
+        name_iterator = label_names_.insert(label_name_lookup_).first;
+    }
+    return name_iterator->c_str();
+}
+
 // We always want to remove the old individual label before we do anything else.
 // So, do that in its own method
-void DebugUtilsData::RemoveIndividualLabel(XrSdkSessionLabelList& label_vec) {
-    if (!label_vec.empty() && label_vec.back()->is_individual_label) {
-        label_vec.pop_back();
+void DebugUtilsData::RemoveIndividualLabel(XrSdkSessionLabelStack& label_stack) {
+    if (label_stack.has_individual_label) {
+        label_stack.labels.erase(label_stack.labels.begin());
+        label_stack.has_individual_label = false;
     }
 }
 
-XrSdkSessionLabelList* DebugUtilsData::GetSessionLabelList(XrSession session) {
+XrSdkSessionLabelStack* DebugUtilsData::GetSessionLabelStack(XrSession session) {
     auto session_label_iterator = session_labels_.find(session);
     if (session_label_iterator == session_labels_.end()) {
         return nullptr;
     }
-    return session_label_iterator->second.get();
+    return &session_label_iterator->second;
 }
 
-XrSdkSessionLabelList& DebugUtilsData::GetOrCreateSessionLabelList(XrSession session) {
-    XrSdkSessionLabelList* vec_ptr = GetSessionLabelList(session);
-    if (vec_ptr == nullptr) {
-        std::unique_ptr<XrSdkSessionLabelList> vec(new XrSdkSessionLabelList);
-        vec_ptr = vec.get();
-        session_labels_[session] = std::move(vec);
-    }
-    return *vec_ptr;
-}
+XrSdkSessionLabelStack& DebugUtilsData::GetOrCreateSessionLabelStack(XrSession session) { return session_labels_[session]; }
 
-void DebugUtilsData::BeginLabelRegion(XrSession session, const XrDebugUtilsLabelEXT& label_info) {
-    auto& vec = GetOrCreateSessionLabelList(session);
+void DebugUtilsData::PushLabel(XrSession session, const XrDebugUtilsLabelEXT& label_info, bool individual) {
+    auto& label_stack = GetOrCreateSessionLabelStack(session);
 
-    // Individual labels do not stay around in the transition into a new label region
-    RemoveIndividualLabel(vec);
+    // Individual labels do not stay around in the transition into a new label region, or past another individual label
+    RemoveIndividualLabel(label_stack);
 
+    XrDebugUtilsLabelEXT label = label_info;
+    // Point at the name we hold, and zero out the next pointer to avoid a dangling pointer
+    label.labelName = InternLabelName(label_info.labelName);
+    label.next = nullptr;
+    label_stack.labels.insert(label_stack.labels.begin(), label);
+    label_stack.has_individual_label = individual;
+}
+
+void DebugUtilsData::BeginLabelRegion(XrSession session, const XrDebugUtilsLabelEXT& label_info) {
     // Start the new label region
-    vec.emplace_back(XrSdkSessionLabel::make(label_info, false));
+    PushLabel(session, label_info, false);
 }
 
 void DebugUtilsData::EndLabelRegion(XrSession session) {
-    XrSdkSessionLabelList* vec_ptr = GetSessionLabelList(session);
-    if (vec_ptr == nullptr) {
+    XrSdkSessionLabelStack* stack_ptr = GetSessionLabelStack(session);
+    if (stack_ptr == nullptr) {
         return;
     }
 
     // Individual labels do not stay around in the transition out of label region
-    RemoveIndividualLabel(*vec_ptr);
+    RemoveIndividualLabel(*stack_ptr);
 
     // Remove the last label region
-    if (!vec_ptr->empty()) {
-        vec_ptr->pop_back();
+    if (!stack_ptr->labels.empty()) {
+        stack_ptr->labels.erase(stack_ptr->labels.begin());
     }
 }
 
 void DebugUtilsData::InsertLabel(XrSession session, const XrDebugUtilsLabelEXT& label_info) {
-    auto& vec = GetOrCreateSessionLabelList(session);
-
-    // Remove any individual layer that might already be there
-    RemoveIndividualLabel(vec);
-
     // Insert a new individual label
-    vec.emplace_back(XrSdkSessionLabel::make(label_info, true));
+    PushLabel(session, label_info, true);
 }
 
 void DebugUtilsData::DeleteObject(uint64_t object_handle, XrObjectType object_type) {
     object_info_.RemoveObject(object_handle, object_type);
 
     if (object_type == XR_OBJECT_TYPE_SESSION) {
-        auto session = TreatIntegerAsHandle<XrSession>(object_handle);
-        XrSdkSessionLabelList* vec_ptr = GetSessionLabelList(session);
-        if (vec_ptr != nullptr) {
-            session_labels_.erase(session);
-        }
+        DeleteSessionLabels(TreatIntegerAsHandle<XrSession>(object_handle));
     }
 }
 
-void DebugUtilsData::DeleteSessionLabels(XrSession session) { session_labels_.erase(session); }
+void DebugUtilsData::DeleteSessionLabels(XrSession session) {
+    session_labels_.erase(session);
+    // Once no session holds labels nothing points at the interned names any more.
+    if (session_labels_.empty()) {
+        label_names_.clear();
+    }
+}
 
 NamesAndLabels DebugUtilsData::PopulateNamesAndLabels(std::vector<XrSdkLogObjectInfo> objects) const {
-    std::vector<XrDebugUtilsLabelEXT> labels;
+    NamesAndLabels ret;
+    auto is_session = [](XrSdkLogObjectInfo const& obj) { return XR_OBJECT_TYPE_SESSION == obj.type; };
+    bool single_session = std::count_if(objects.begin(), objects.end(), is_session) == 1;
     for (auto& obj : objects) {
         // Check for any names that have been associated with the objects and set them up here
         object_info_.LookUpObjectName(obj);
         // If this is a session, see if there are any labels associated with it for us to add
-        // to the callback content.
-        if (XR_OBJECT_TYPE_SESSION == obj.type) {
-            LookUpSessionLabels(obj.GetTypedHandle<XrSession>(), labels);
+        // to the callback content. A single session can point straight at its label stack.
+        if (is_session(obj)) {
+            if (single_session) {
+                ret.borrowed_labels = GetSessionLabels(obj.GetTypedHandle<XrSession>(), ret.borrowed_label_count);
+            } else {
+                LookUpSessionLabels(obj.GetTypedHandle<XrSession>(), ret.labels);
+            }
         }
     }
 
-    return {objects, labels};
+    ret.sdk_objects = std::move(objects);
+    return ret;
 }
 
 void DebugUtilsData::WrapCallbackData(AugmentedCallbackData* aug_data,
@@ -244,6 +275,9 @@ void DebugUtilsData::WrapCallbackData(AugmentedCallbackData* aug_data,
 
     // Inspect each of the callback objects
     bool name_found = false;
+    uint32_t labeled_session_count = 0;
+    const XrDebugUtilsLabelEXT* session_labels = nullptr;
+    uint32_t session_label_count = 0;
     for (uint32_t obj = 0; obj < callback_data->objectCount; ++obj) {
         auto& current_obj = callback_data->objects[obj];
         name_found |= (nullptr != object_info_.LookUpStoredObjectInfo(current_obj.objectHandle, current_obj.objectType));
@@ -251,28 +285,45 @@ void DebugUtilsData::WrapCallbackData(AugmentedCallbackData* aug_data,
         // If this is a session, record any labels associated with it
         if (XR_OBJECT_TYPE_SESSION == current_obj.objectType) {
             XrSession session = TreatIntegerAsHandle<XrSession>(current_obj.objectHandle);
-            LookUpSessionLabels(session, aug_data->labels);
+            if (++labeled_session_count == 1) {
+                // Borrow the labels of the first session; only copy when several sessions must be merged.
+                session_labels = GetSessionLabels(session, session_label_count);
+            } else {
+                if (labeled_session_count == 2) {
+                    aug_data->labels.assign(session_labels, session_labels + session_label_count);
+                }
+                LookUpSessionLabels(session, aug_data->labels);
+            }
         }
     }
+    if (labeled_session_count > 1) {
+        session_labels = aug_data->labels.empty() ? nullptr : aug_data->labels.data();
+        session_label_count = static_cast<uint32_t>(aug_data->labels.size());
+    }
 
     // If we found nothing to add, return the original data
-    if (!name_found && aug_data->labels.empty()) {
+    if (!name_found && session_label_count == 0) {
         return;
     }
 
     // Found additional data - modify an internal copy and return that as the exported data
     memcpy(&aug_data->modified_data, callback_data, sizeof(XrDebugUtilsMessengerCallbackDataEXT));
-    aug_data->new_objects.assign(callback_data->objects, callback_data->objects + callback_data->objectCount);
+    XrDebugUtilsObjectNameInfoEXT* new_objects = aug_data->inline_objects;
+    if (callback_data->objectCount > AugmentedCallbackData::INLINE_OBJECT_COUNT) {
+        aug_data->new_objects.resize(callback_data->objectCount);
+        new_objects = aug_data->new_objects.data();
+    }
+    std::copy(callback_data->objects, callback_data->objects + callback_data->objectCount, new_objects);
 
     // Record (overwrite) the names of all incoming objects provided in our internal list
-    for (auto& obj : aug_data->new_objects) {
-        object_info_.LookUpObjectName(obj);
+    for (uint32_t obj = 0; obj < callback_data->objectCount; ++obj) {
+        object_info_.LookUpObjectName(new_objects[obj]);
     }
 
     // Update local copy & point export to it
-    aug_data->modified_data.objects = aug_data->new_objects.data();
-    aug_data->modified_data.sessionLabelCount = static_cast<uint32_t>(aug_data->labels.size());
-    aug_data->modified_data.sessionLabels = aug_data->labels.empty() ? nullptr : aug_data->labels.data();
+    aug_data->modified_data.objects = new_objects;
+    aug_data->modified_data.sessionLabelCount = session_label_count;
+    aug_data->modified_data.sessionLabels = const_cast<XrDebugUtilsLabelEXT*>(session_labels);
     aug_data->exported_data = &aug_data->modified_data;
     return;
 }
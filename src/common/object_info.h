@@ -19,9 +19,11 @@
 
 #include <openxr/openxr.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 struct XrSdkGenericObject {
@@ -136,23 +138,34 @@ class ObjectInfoCollection {
     bool Empty() const { return object_info_.empty(); }
 
    private:
-    // Object names that have been set for given objects
-    std::vector<XrSdkLogObjectInfo> object_info_;
+    //! Identity of a named object: handle values are only unique per object type.
+    struct ObjectKey {
+        uint64_t handle;
+        XrObjectType type;
+        bool operator==(ObjectKey const& other) const { return handle == other.handle && type == other.type; }
+    };
+
+    struct ObjectKeyHash {
+        size_t operator()(ObjectKey const& key) const {
+            return std::hash<uint64_t>()(key.handle ^ (static_cast<uint64_t>(key.type) * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+
+    // Object names that have been set for given objects, keyed on handle and type.
+    // Values are node-allocated, so pointers returned by LookUpStoredObjectInfo stay valid until the entry is removed.
+    std::unordered_map<ObjectKey, XrSdkLogObjectInfo, ObjectKeyHash> object_info_;
 };
 
-struct XrSdkSessionLabel;
-using XrSdkSessionLabelPtr = std::unique_ptr<XrSdkSessionLabel>;
-using XrSdkSessionLabelList = std::vector<XrSdkSessionLabelPtr>;
-
-struct XrSdkSessionLabel {
-    static XrSdkSessionLabelPtr make(const XrDebugUtilsLabelEXT& label_info, bool individual);
-
-    std::string label_name;
-    XrDebugUtilsLabelEXT debug_utils_label;
-    bool is_individual_label;
+/// The label stack of one session.
+///
+/// Labels are kept most-recent-first, which is the order callbacks report them in, so the storage can be handed
+/// out as-is. Popping keeps the capacity, so steady-state begin/end/insert calls do not allocate.
+struct XrSdkSessionLabelStack {
+    //! Active labels, most recent first. Label names point into the owning DebugUtilsData's interned names.
+    std::vector<XrDebugUtilsLabelEXT> labels;
 
-   private:
-    XrSdkSessionLabel(const XrDebugUtilsLabelEXT& label_info, bool individual);
+    //! True if labels.front() is an individual label from xrSessionInsertDebugUtilsLabelEXT
+    bool has_individual_label = false;
 };
 
 /// The metadata for a collection of objects. Must persist unmodified during the entire debug messenger call!
@@ -162,17 +175,30 @@ struct NamesAndLabels {
     /// C++ structure owning the data (strings) backing the objects vector.
     std::vector<XrSdkLogObjectInfo> sdk_objects;
 
+    /// Filled in from sdk_objects by PopulateCallbackData.
     std::vector<XrDebugUtilsObjectNameInfoEXT> objects;
     std::vector<XrDebugUtilsLabelEXT> labels;
 
+    /// Labels of a single session, borrowed from the session label stack instead of copied into labels.
+    const XrDebugUtilsLabelEXT* borrowed_labels = nullptr;
+    uint32_t borrowed_label_count = 0;
+
+    /// The session labels to report, whether owned or borrowed.
+    const XrDebugUtilsLabelEXT* LabelData() const;
+    uint32_t LabelCount() const;
+
     /// Populate the debug utils callback data structure.
-    void PopulateCallbackData(XrDebugUtilsMessengerCallbackDataEXT& data) const;
+    void PopulateCallbackData(XrDebugUtilsMessengerCallbackDataEXT& data);
     // XrDebugUtilsMessengerCallbackDataEXT MakeCallbackData() const;
 };
 
 struct AugmentedCallbackData {
+    //! Objects up to this count are renamed in inline_objects rather than in a heap-allocated vector.
+    static constexpr size_t INLINE_OBJECT_COUNT = 8;
+
     std::vector<XrDebugUtilsLabelEXT> labels;
     std::vector<XrDebugUtilsObjectNameInfoEXT> new_objects;
+    XrDebugUtilsObjectNameInfoEXT inline_objects[INLINE_OBJECT_COUNT];
     XrDebugUtilsMessengerCallbackDataEXT modified_data;
     const XrDebugUtilsMessengerCallbackDataEXT* exported_data;
 };
@@ -205,6 +231,14 @@ class DebugUtilsData {
     /// Retrieve labels for the given session, if any, and push them in reverse order on the vector.
     void LookUpSessionLabels(XrSession session, std::vector<XrDebugUtilsLabelEXT>& labels) const;
 
+    /// Retrieve the labels for the given session, most recent first, without copying them.
+    ///
+    /// The returned storage is only valid until the next label call for that session.
+    const XrDebugUtilsLabelEXT* GetSessionLabels(XrSession session, uint32_t& label_count) const;
+
+    /// The name of the innermost label region open on the given session, or nullptr if there is none.
+    const char* GetInnermostLabelRegionName(XrSession session) const;
+
     /// Removes all data related to this object - including session labels if it's a session.
     ///
     /// Does not take care of handling child objects - you must do this yourself.
@@ -217,12 +251,20 @@ class DebugUtilsData {
                           const XrDebugUtilsMessengerCallbackDataEXT* provided_callback_data) const;
 
    private:
-    void RemoveIndividualLabel(XrSdkSessionLabelList& label_vec);
-    XrSdkSessionLabelList* GetSessionLabelList(XrSession session);
-    XrSdkSessionLabelList& GetOrCreateSessionLabelList(XrSession session);
+    void RemoveIndividualLabel(XrSdkSessionLabelStack& label_stack);
+    XrSdkSessionLabelStack* GetSessionLabelStack(XrSession session);
+    XrSdkSessionLabelStack& GetOrCreateSessionLabelStack(XrSession session);
+    void PushLabel(XrSession session, const XrDebugUtilsLabelEXT& label_info, bool individual);
+    const char* InternLabelName(const char* label_name);
+
+    // Session labels: one stack of them per session.
+    std::unordered_map<XrSession, XrSdkSessionLabelStack> session_labels_;
+
+    // Every distinct label name seen while any session had labels. Nodes are stable, so labels can point at them.
+    std::unordered_set<std::string> label_names_;
 
-    // Session labels: one vector of them per session.
-    std::unordered_map<XrSession, std::unique_ptr<XrSdkSessionLabelList>> session_labels_;
+    // Reused key for label_names_ lookups, so repeated labels do not allocate.
+    std::string label_name_lookup_;
 
     // Names for objects.
     ObjectInfoCollection object_info_;
@@ -0,0 +1,120 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+#pragma once
+
+// Tracepoints for the timeline tools of each platform: ATrace for systrace and Perfetto on Android, TraceLogging for
+// ETW and WPA on Windows, and USDT probes for perf, bpftrace and LTTng on Linux.  They are only built in when
+// XR_USE_PLATFORM_TRACE is defined, by the BUILD_WITH_PLATFORM_TRACE CMake option.  Otherwise XR_TRACE_SCOPE expands
+// to nothing.  Once built in, a scope with no tracer attached costs a check that one is (ATrace, ETW) or two
+// nops (USDT).
+//
+// XR_TRACE_SCOPE(name) marks the rest of the enclosing block, name being a string literal.  It also counts the heap
+// allocations made in the block when allocation tracking is built in, see allocation_tracker.hpp.  On Windows, each
+// module using it defines the provider in one of its source files with XR_TRACE_DEFINE_PROVIDER().
+
+#include "allocation_tracker.hpp"
+
+#if defined(XR_USE_PLATFORM_TRACE)
+
+#if defined(__ANDROID__)
+#include <android/trace.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+#else
+#include <sys/sdt.h>
+#endif
+
+#if defined(_WIN32)
+// All modules register the same provider, so one ETW session records the loader and layers together.
+TRACELOGGING_DECLARE_PROVIDER(g_xr_trace_provider);
+
+#define XR_TRACE_DEFINE_PROVIDER()                                                                          \
+    TRACELOGGING_DEFINE_PROVIDER(g_xr_trace_provider, "Khronos.OpenXR.SDK",                                 \
+                                 (0x5f0a7b21, 0x8c3e, 0x4d19, 0x9a, 0x6b, 0x2e, 0x71, 0xc4, 0x0d, 0x93, 0xb8))
+
+// Registered on first use and unregistered when the module is unloaded, before ETW could call into it.
+class PlatformTraceRegistration {
+   public:
+    PlatformTraceRegistration() : _registered(SUCCEEDED(TraceLoggingRegister(g_xr_trace_provider))) {}
+    ~PlatformTraceRegistration() {
+        if (_registered) {
+            TraceLoggingUnregister(g_xr_trace_provider);
+        }
+    }
+
+    PlatformTraceRegistration(const PlatformTraceRegistration&) = delete;
+    PlatformTraceRegistration& operator=(const PlatformTraceRegistration&) = delete;
+
+    static bool Enabled() {
+        static PlatformTraceRegistration registration;
+        return registration._registered && TraceLoggingProviderEnabled(g_xr_trace_provider, 0, 0);
+    }
+
+   private:
+    bool _registered;
+};
+#else
+#define XR_TRACE_DEFINE_PROVIDER()
+#endif
+
+class PlatformTraceScope {
+   public:
+    explicit PlatformTraceScope(const char* name) noexcept : _name(name) {
+#if defined(__ANDROID__)
+        _began = ATrace_isEnabled();
+        if (_began) {
+            ATrace_beginSection(_name);
+        }
+#elif defined(_WIN32)
+        _began = PlatformTraceRegistration::Enabled();
+        if (_began) {
+            TraceLoggingWrite(g_xr_trace_provider, "Scope", TraceLoggingOpcode(WINEVENT_OPCODE_START),
+                              TraceLoggingString(_name, "Name"));
+        }
+#else
+        DTRACE_PROBE1(openxr, scope_begin, _name);
+#endif
+    }
+
+    ~PlatformTraceScope() {
+#if defined(__ANDROID__)
+        if (_began) {
+            ATrace_endSection();
+        }
+#elif defined(_WIN32)
+        if (_began) {
+            TraceLoggingWrite(g_xr_trace_provider, "Scope", TraceLoggingOpcode(WINEVENT_OPCODE_STOP),
+                              TraceLoggingString(_name, "Name"));
+        }
+#else
+        DTRACE_PROBE1(openxr, scope_end, _name);
+#endif
+    }
+
+    PlatformTraceScope(const PlatformTraceScope&) = delete;
+    PlatformTraceScope& operator=(const PlatformTraceScope&) = delete;
+
+   private:
+    const char* _name;
+#if defined(__ANDROID__) || defined(_WIN32)
+    // A tracer attached in the middle of a scope only sees the scopes begun after it.
+    bool _began;
+#endif
+};
+
+#define XR_TRACE_CONCAT_INNER(a, b) a##b
+#define XR_TRACE_CONCAT(a, b) XR_TRACE_CONCAT_INNER(a, b)
+#define XR_TRACE_SCOPE(name)                                             \
+    PlatformTraceScope XR_TRACE_CONCAT(xr_trace_scope_, __LINE__)(name); \
+    XR_ALLOCATION_SCOPE(name)
+
+#else  // !defined(XR_USE_PLATFORM_TRACE)
+
+#define XR_TRACE_DEFINE_PROVIDER()
+#define XR_TRACE_SCOPE(name) XR_ALLOCATION_SCOPE(name)
+
+#endif  // defined(XR_USE_PLATFORM_TRACE)
@@ -27,6 +27,9 @@
 // OpenXR Loader environment variables of interest
 #define OPENXR_RUNTIME_JSON_ENV_VAR "XR_RUNTIME_JSON"
 #define OPENXR_API_LAYER_PATH_ENV_VAR "XR_API_LAYER_PATH"
+#define OPENXR_MANIFEST_INDEX_ENV_VAR "XR_LOADER_MANIFEST_INDEX"
+#define OPENXR_MANIFEST_SHARED_ENV_VAR "XR_LOADER_MANIFEST_SHARED"
+#define OPENXR_LIBRARY_BINDING_ENV_VAR "XR_LOADER_LIBRARY_BINDING"
 
 // This is a CMake generated file with #defines for any functions/includes
 // that it found present and build-time configuration.
@@ -86,7 +89,6 @@ void LogPlatformUtilsError(const std::string& message);
 
 #include <unistd.h>
 #include <fcntl.h>
-#include <iostream>
 #include <sys/stat.h>
 
 namespace detail {
@@ -0,0 +1,83 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include "xr_linear.h"
+
+#include <openxr/openxr.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Late latching: locating the views of a frame again once its draws are recorded, just before they are submitted, and
+// updating what the recorded draws read from memory the CPU may still write, so the frame is rendered from the runtime's
+// most recent prediction of the view poses.  The projection views submitted with the frame take the same poses.
+namespace XrLateLatch {
+
+// Locate the views again, with the locate info the frame was rendered with, into views sized to the view count
+// located then.  False if the runtime no longer has a valid position and orientation for them, or locates another
+// number of views; the contents of views are meaningless then, and the frame keeps the poses it was rendered with.
+inline bool RelocateViews(XrSession session, const XrViewLocateInfo& locateInfo, std::vector<XrView>& views) {
+    XrViewState viewState{XR_TYPE_VIEW_STATE};
+    uint32_t viewCount = 0;
+    if (XR_FAILED(xrLocateViews(session, &locateInfo, &viewState, (uint32_t)views.size(), &viewCount, views.data()))) {
+        return false;
+    }
+    const XrViewStateFlags valid = XR_VIEW_STATE_POSITION_VALID_BIT | XR_VIEW_STATE_ORIENTATION_VALID_BIT;
+    return (viewState.viewStateFlags & valid) == valid && viewCount == views.size();
+}
+
+// The rigid transform of app space that corrects draws recorded for a view at renderedPose to the view at latestPose:
+// ViewProjection(rendered) * correction is ViewProjection(latest), for the same projection.  It is for draws whose
+// view-projection can no longer be updated, but whose model transforms can: each is multiplied by it on the left.
+// Views that move together, like the eyes of a head mounted display, have the same correction, so any one of them
+// gives the correction of a draw to all of them at once.
+inline void CreateCorrection(XrMatrix4x4f* result, const XrPosef& renderedPose, const XrPosef& latestPose) {
+    // A view matrix is the inverse of its pose, so inverse(View(rendered)) * View(latest) is rendered * inverse(latest).
+    XrMatrix4x4f rendered;
+    XrMatrix4x4f_CreateFromRigidTransform(&rendered, &renderedPose);
+    XrMatrix4x4f latest;
+    XrMatrix4x4f_CreateFromRigidTransform(&latest, &latestPose);
+    XrMatrix4x4f latestInverse;
+    XrMatrix4x4f_InvertRigidBody(&latestInverse, &latest);
+    XrMatrix4x4f_Multiply(result, &rendered, &latestInverse);
+}
+
+// Apply a correction to model transforms in place.
+inline void CorrectTransforms(const XrMatrix4x4f& correction, XrMatrix4x4f* transforms, size_t count) {
+    XrMatrix4x4f_MultiplyArray(transforms, &correction, transforms, (uint32_t)count);
+}
+
+// How far a view moved from one pose to another.
+struct PoseDelta {
+    float distance{0};  // Meters between the positions
+    float angle{0};     // Radians of the rotation between the orientations
+};
+
+inline PoseDelta Difference(const XrPosef& from, const XrPosef& to) {
+    XrVector3f offset;
+    XrVector3f_Sub(&offset, &to.position, &from.position);
+    const XrQuaternionf& a = from.orientation;
+    const XrQuaternionf& b = to.orientation;
+    const float dot = std::fabs(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+    return {XrVector3f_Length(&offset), 2.0f * std::acos(dot < 1.0f ? dot : 1.0f)};
+}
+
+}  // namespace XrLateLatch
@@ -60,20 +60,31 @@ inline static void XrVector3f_Decay(XrVector3f* result, const XrVector3f* a, con
 inline static void XrVector3f_Lerp(XrVector3f* result, const XrVector3f* a, const XrVector3f* b, const float fraction);
 inline static void XrVector3f_Scale(XrVector3f* result, const XrVector3f* a, const float scaleFactor);
 inline static void XrVector3f_Normalize(XrVector3f* v);
+inline static void XrVector3f_NormalizeFast(XrVector3f* v);
 inline static float XrVector3f_Length(const XrVector3f* v);
 
 inline static void XrQuaternionf_CreateIdentity(XrQuaternionf* q);
 inline static void XrQuaternionf_CreateFromAxisAngle(XrQuaternionf* result, const XrVector3f* axis, const float angleInRadians);
 inline static void XrQuaternionf_Lerp(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b, const float fraction);
+inline static void XrQuaternionf_LerpFast(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b,
+                                          const float fraction);
+inline static void XrQuaternionf_LerpArray(XrQuaternionf* results, const XrQuaternionf* a, const XrQuaternionf* b,
+                                           const float fraction, uint32_t count);
 inline static void XrQuaternionf_Multiply(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b);
 inline static void XrQuaternionf_Invert(XrQuaternionf* result, const XrQuaternionf* q);
 inline static void XrQuaternionf_Normalize(XrQuaternionf* q);
+inline static void XrQuaternionf_NormalizeFast(XrQuaternionf* q);
+inline static void XrQuaternionf_NormalizeArray(XrQuaternionf* results, const XrQuaternionf* q, uint32_t count);
 inline static void XrQuaternionf_RotateVector3f(XrVector3f* result, const XrQuaternionf* a, const XrVector3f* v);
 
 inline static void XrPosef_CreateIdentity(XrPosef* result);
 inline static void XrPosef_TransformVector3f(XrVector3f* result, const XrPosef* a, const XrVector3f* v);
+inline static void XrPosef_TransformVector3fArray(XrVector3f* results, const XrPosef* a, const XrVector3f* v, uint32_t count);
 inline static void XrPosef_Multiply(XrPosef* result, const XrPosef* a, const XrPosef* b);
 inline static void XrPosef_Invert(XrPosef* result, const XrPosef* a);
+inline static void XrPosef_LerpArray(XrPosef* results, const XrPosef* a, const XrPosef* b, const float fraction, uint32_t count);
+inline static void XrPosef_MultiplyArray(XrPosef* results, const XrPosef* a, const XrQuaternionf* orientations,
+                                         const XrVector3f* positions, uint32_t count);
 
 inline static void XrMatrix4x4f_CreateIdentity(XrMatrix4x4f* result);
 inline static void XrMatrix4x4f_CreateTranslation(XrMatrix4x4f* result, const float x, const float y, const float z);
@@ -82,12 +93,17 @@ inline static void XrMatrix4x4f_CreateRotation(XrMatrix4x4f* result, const float
 inline static void XrMatrix4x4f_CreateScale(XrMatrix4x4f* result, const float x, const float y, const float z);
 inline static void XrMatrix4x4f_CreateTranslationRotationScale(XrMatrix4x4f* result, const XrVector3f* translation,
                                                                const XrQuaternionf* rotation, const XrVector3f* scale);
+inline static void XrMatrix4x4f_CreateTranslationRotationScaleArray(XrMatrix4x4f* results, const XrVector3f* translations,
+                                                                    const XrQuaternionf* rotations, const XrVector3f* scales,
+                                                                    uint32_t count);
 inline static void XrMatrix4x4f_CreateFromRigidTransform(XrMatrix4x4f* result, const XrPosef* s);
 inline static void XrMatrix4x4f_CreateProjection(XrMatrix4x4f* result, GraphicsAPI graphicsApi, const float tanAngleLeft,
                                                  const float tanAngleRight, const float tanAngleUp, float const tanAngleDown,
                                                  const float nearZ, const float farZ);
 inline static void XrMatrix4x4f_CreateProjectionFov(XrMatrix4x4f* result, GraphicsAPI graphicsApi, const XrFovf fov,
                                                     const float nearZ, const float farZ);
+inline static void XrMatrix4x4f_CreateViewProjectionFromPoseFov(XrMatrix4x4f* result, GraphicsAPI graphicsApi, const XrPosef* pose,
+                                                               const XrFovf fov, const float nearZ, const float farZ);
 inline static void XrMatrix4x4f_CreateFromQuaternion(XrMatrix4x4f* result, const XrQuaternionf* quat);
 inline static void XrMatrix4x4f_CreateOffsetScaleForBounds(XrMatrix4x4f* result, const XrMatrix4x4f* matrix, const XrVector3f* mins,
                                                            const XrVector3f* maxs);
@@ -102,6 +118,7 @@ inline static void XrMatrix4x4f_GetRotation(XrQuaternionf* result, const XrMatri
 inline static void XrMatrix4x4f_GetScale(XrVector3f* result, const XrMatrix4x4f* src);
 
 inline static void XrMatrix4x4f_Multiply(XrMatrix4x4f* result, const XrMatrix4x4f* a, const XrMatrix4x4f* b);
+inline static void XrMatrix4x4f_MultiplyArray(XrMatrix4x4f* results, const XrMatrix4x4f* a, const XrMatrix4x4f* b, uint32_t count);
 inline static void XrMatrix4x4f_Transpose(XrMatrix4x4f* result, const XrMatrix4x4f* src);
 inline static void XrMatrix4x4f_Invert(XrMatrix4x4f* result, const XrMatrix4x4f* src);
 inline static void XrMatrix4x4f_InvertRigidBody(XrMatrix4x4f* result, const XrMatrix4x4f* src);
@@ -113,6 +130,11 @@ inline static void XrMatrix4x4f_TransformBounds(XrVector3f* resultMins, XrVector
                                                 const XrVector3f* mins, const XrVector3f* maxs);
 inline static bool XrMatrix4x4f_CullBounds(const XrMatrix4x4f* mvp, const XrVector3f* mins, const XrVector3f* maxs);
 
+inline static bool XrPosef_CreateCombinedFrustumPlanes(XrVector4f* planes, const XrPosef* poses, const XrFovf* fovs,
+                                                       uint32_t viewCount);
+inline static uint32_t XrVector4f_CullSpheres(uint32_t* visibleIndices, const XrVector4f* planes, uint32_t planeCount,
+                                              const XrVector4f* spheres, uint32_t count);
+
 ================================================================================================
 */
 
@@ -120,6 +142,17 @@ inline static bool XrMatrix4x4f_CullBounds(const XrMatrix4x4f* mvp, const XrVect
 #include <math.h>
 #include <stdbool.h>
 
+// The matrix and quaternion products have SSE2 and NEON versions, selected at compile time.  Both do the same float
+// operations in the same order as the scalar code, so on IEEE hardware the results are identical.  Only AArch64 uses
+// NEON: 32-bit ARM NEON flushes denormals to zero.  Define XR_LINEAR_NO_SIMD to use the scalar code everywhere.
+#if !defined(XR_LINEAR_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define XR_LINEAR_SSE2 1
+#include <emmintrin.h>
+#elif !defined(XR_LINEAR_NO_SIMD) && (defined(__aarch64__) || defined(_M_ARM64))
+#define XR_LINEAR_NEON 1
+#include <arm_neon.h>
+#endif
+
 #define MATH_PI 3.14159265358979323846f
 
 #define DEFAULT_NEAR_Z 0.015625f  // exact floating point representation
@@ -147,6 +180,57 @@ inline static float XrRcpSqrt(const float x) {
     return rcp;
 }
 
+// The functions named Fast, and the quaternion Array functions, use the hardware reciprocal square root estimate, refined
+// by Newton-Raphson steps to within a few units in the last place, instead of a square root and a division.  The
+// results are not bit-identical to the exact functions, nor between SSE2, NEON and the scalar code, which stays exact.
+// Most of the gain is in the Array functions, which take four at a time: a compiler may already vectorize a loop of the
+// exact single-value functions, and then the Fast ones are no faster.
+#if defined(XR_LINEAR_SSE2)
+inline static __m128 XrRcpSqrtFastSse2(const __m128 x) {
+    const __m128 normal = _mm_cmpge_ps(x, _mm_set1_ps(1.1754943508222875e-038f));
+    // rsqrtps is good to 12 bits, and one step to 22: e * (1.5 - 0.5 * x * e * e).
+    const __m128 e = _mm_rsqrt_ps(x);
+    const __m128 rcp = _mm_mul_ps(e, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x), _mm_mul_ps(e, e))));
+    return _mm_or_ps(_mm_and_ps(normal, rcp), _mm_andnot_ps(normal, _mm_set1_ps(1.0f)));
+}
+#elif defined(XR_LINEAR_NEON)
+inline static float32x4_t XrRcpSqrtFastNeon(const float32x4_t x) {
+    const uint32x4_t normal = vcgeq_f32(x, vdupq_n_f32(1.1754943508222875e-038f));
+    // The NEON estimate is only good to 8 bits, so it takes two steps: e * (3 - x * e * e) / 2.
+    float32x4_t e = vrsqrteq_f32(x);
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(x, e), e));
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(x, e), e));
+    return vbslq_f32(normal, e, vdupq_n_f32(1.0f));
+}
+
+// The transpose of the 4x4 matrix whose rows are r[0] to r[3].
+inline static void XrTranspose4Neon(float32x4_t* r) {
+    const float32x4x2_t t01 = vtrnq_f32(r[0], r[1]);
+    const float32x4x2_t t23 = vtrnq_f32(r[2], r[3]);
+    r[0] = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r[1] = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r[2] = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r[3] = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+#endif
+
+inline static float XrRcpSqrtFast(const float x) {
+    const float SMALLEST_NON_DENORMAL = 1.1754943508222875e-038f;  // ( 1U << 23 )
+    if (!(x >= SMALLEST_NON_DENORMAL)) {
+        return 1.0f;
+    }
+#if defined(XR_LINEAR_SSE2)
+    const float e = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    return e * (1.5f - 0.5f * x * e * e);
+#elif defined(XR_LINEAR_NEON)
+    float e = vrsqrtes_f32(x);
+    e *= vrsqrtss_f32(x * e, e);
+    return e * vrsqrtss_f32(x * e, e);
+#else
+    return 1.0f / sqrtf(x);
+#endif
+}
+
 inline static float XrVector2f_Length(const XrVector2f* v) { return sqrtf(v->x * v->x + v->y * v->y); }
 
 inline static void XrVector3f_Set(XrVector3f* v, const float value) {
@@ -215,6 +299,13 @@ inline static void XrVector3f_Normalize(XrVector3f* v) {
     v->z *= lengthRcp;
 }
 
+inline static void XrVector3f_NormalizeFast(XrVector3f* v) {
+    const float lengthRcp = XrRcpSqrtFast(v->x * v->x + v->y * v->y + v->z * v->z);
+    v->x *= lengthRcp;
+    v->y *= lengthRcp;
+    v->z *= lengthRcp;
+}
+
 inline static float XrVector3f_Length(const XrVector3f* v) { return sqrtf(v->x * v->x + v->y * v->y + v->z * v->z); }
 
 inline static void XrQuaternionf_CreateIdentity(XrQuaternionf* q) {
@@ -248,11 +339,138 @@ inline static void XrQuaternionf_Lerp(XrQuaternionf* result, const XrQuaternionf
     result->w = w * lengthRcp;
 }
 
+inline static void XrQuaternionf_LerpFast(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b,
+                                          const float fraction) {
+    const float s = a->x * b->x + a->y * b->y + a->z * b->z + a->w * b->w;
+    const float fa = 1.0f - fraction;
+    const float fb = (s < 0.0f) ? -fraction : fraction;
+    const float x = a->x * fa + b->x * fb;
+    const float y = a->y * fa + b->y * fb;
+    const float z = a->z * fa + b->z * fb;
+    const float w = a->w * fa + b->w * fb;
+    const float lengthRcp = XrRcpSqrtFast(x * x + y * y + z * z + w * w);
+    result->x = x * lengthRcp;
+    result->y = y * lengthRcp;
+    result->z = z * lengthRcp;
+    result->w = w * lengthRcp;
+}
+
+#if defined(XR_LINEAR_SSE2) || defined(XR_LINEAR_NEON)
+// XrQuaternionf_LerpFast for the four quaternions at a, b and results, which are stride floats apart: 4 for arrays of
+// quaternions, 7 for the orientations of arrays of poses.  All four are loaded before any is stored.
+inline static void XrQuaternionf_LerpFast4(float* results, const float* a, const float* b, const float fraction,
+                                           const uint32_t stride) {
+#if defined(XR_LINEAR_SSE2)
+    // Transposed, each register holds one component of the four quaternions.
+    __m128 ax = _mm_loadu_ps(a);
+    __m128 ay = _mm_loadu_ps(a + stride);
+    __m128 az = _mm_loadu_ps(a + 2 * stride);
+    __m128 aw = _mm_loadu_ps(a + 3 * stride);
+    _MM_TRANSPOSE4_PS(ax, ay, az, aw);
+    __m128 bx = _mm_loadu_ps(b);
+    __m128 by = _mm_loadu_ps(b + stride);
+    __m128 bz = _mm_loadu_ps(b + 2 * stride);
+    __m128 bw = _mm_loadu_ps(b + 3 * stride);
+    _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+    const __m128 s =
+        _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz)), _mm_mul_ps(aw, bw));
+    const __m128 fa = _mm_set1_ps(1.0f - fraction);
+    const __m128 fb = _mm_xor_ps(_mm_set1_ps(fraction), _mm_and_ps(_mm_cmplt_ps(s, _mm_setzero_ps()), _mm_set1_ps(-0.0f)));
+    __m128 x = _mm_add_ps(_mm_mul_ps(ax, fa), _mm_mul_ps(bx, fb));
+    __m128 y = _mm_add_ps(_mm_mul_ps(ay, fa), _mm_mul_ps(by, fb));
+    __m128 z = _mm_add_ps(_mm_mul_ps(az, fa), _mm_mul_ps(bz, fb));
+    __m128 w = _mm_add_ps(_mm_mul_ps(aw, fa), _mm_mul_ps(bw, fb));
+    const __m128 lengthRcp = XrRcpSqrtFastSse2(
+        _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)), _mm_mul_ps(w, w)));
+    x = _mm_mul_ps(x, lengthRcp);
+    y = _mm_mul_ps(y, lengthRcp);
+    z = _mm_mul_ps(z, lengthRcp);
+    w = _mm_mul_ps(w, lengthRcp);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps(results, x);
+    _mm_storeu_ps(results + stride, y);
+    _mm_storeu_ps(results + 2 * stride, z);
+    _mm_storeu_ps(results + 3 * stride, w);
+#else
+    float32x4_t va[4];
+    float32x4_t vb[4];
+    for (uint32_t k = 0; k < 4; k++) {
+        va[k] = vld1q_f32(a + k * stride);
+        vb[k] = vld1q_f32(b + k * stride);
+    }
+    XrTranspose4Neon(va);
+    XrTranspose4Neon(vb);
+    const float32x4_t s = vaddq_f32(
+        vaddq_f32(vaddq_f32(vmulq_f32(va[0], vb[0]), vmulq_f32(va[1], vb[1])), vmulq_f32(va[2], vb[2])), vmulq_f32(va[3], vb[3]));
+    const float32x4_t fa = vdupq_n_f32(1.0f - fraction);
+    const float32x4_t f = vdupq_n_f32(fraction);
+    const float32x4_t fb = vbslq_f32(vcltq_f32(s, vdupq_n_f32(0.0f)), vnegq_f32(f), f);
+    float32x4_t v[4];
+    for (uint32_t c = 0; c < 4; c++) {
+        v[c] = vaddq_f32(vmulq_f32(va[c], fa), vmulq_f32(vb[c], fb));
+    }
+    const float32x4_t lengthRcp = XrRcpSqrtFastNeon(vaddq_f32(
+        vaddq_f32(vaddq_f32(vmulq_f32(v[0], v[0]), vmulq_f32(v[1], v[1])), vmulq_f32(v[2], v[2])), vmulq_f32(v[3], v[3])));
+    for (uint32_t c = 0; c < 4; c++) {
+        v[c] = vmulq_f32(v[c], lengthRcp);
+    }
+    XrTranspose4Neon(v);
+    for (uint32_t k = 0; k < 4; k++) {
+        vst1q_f32(results + k * stride, v[k]);
+    }
+#endif
+}
+#endif
+
+// Like XrQuaternionf_LerpFast(results[i], a[i], b[i], fraction) for count quaternions, e.g. the joints of a skeleton
+// between two key frames.  The SIMD versions take four quaternions at a time.  results may be a or b.
+inline static void XrQuaternionf_LerpArray(XrQuaternionf* results, const XrQuaternionf* a, const XrQuaternionf* b,
+                                           const float fraction, uint32_t count) {
+    uint32_t i = 0;
+#if defined(XR_LINEAR_SSE2) || defined(XR_LINEAR_NEON)
+    for (; i + 4 <= count; i += 4) {
+        XrQuaternionf_LerpFast4(&results[i].x, &a[i].x, &b[i].x, fraction, 4);
+    }
+#endif
+    for (; i < count; i++) {
+        XrQuaternionf_LerpFast(&results[i], &a[i], &b[i], fraction);
+    }
+}
+
 inline static void XrQuaternionf_Multiply(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b) {
+    // Each product is b->w * a plus b->x, b->y and b->z times a permutation of a with some signs flipped.
+#if defined(XR_LINEAR_SSE2)
+    const __m128 va = _mm_loadu_ps(&a->x);
+    const __m128 signs1 = _mm_castsi128_ps(_mm_set_epi32((int)0x80000000, 0, (int)0x80000000, 0));
+    const __m128 signs2 = _mm_castsi128_ps(_mm_set_epi32((int)0x80000000, (int)0x80000000, 0, 0));
+    const __m128 signs3 = _mm_castsi128_ps(_mm_set_epi32((int)0x80000000, 0, 0, (int)0x80000000));
+    const __m128 wzyx = _mm_xor_ps(_mm_shuffle_ps(va, va, _MM_SHUFFLE(0, 1, 2, 3)), signs1);
+    const __m128 zwxy = _mm_xor_ps(_mm_shuffle_ps(va, va, _MM_SHUFFLE(1, 0, 3, 2)), signs2);
+    const __m128 yxwz = _mm_xor_ps(_mm_shuffle_ps(va, va, _MM_SHUFFLE(2, 3, 0, 1)), signs3);
+    __m128 sum = _mm_mul_ps(_mm_set1_ps(b->w), va);
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(b->x), wzyx));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(b->y), zwxy));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(b->z), yxwz));
+    _mm_storeu_ps(&result->x, sum);
+#elif defined(XR_LINEAR_NEON)
+    static const float signs1[4] = {1.0f, -1.0f, 1.0f, -1.0f};
+    static const float signs2[4] = {1.0f, 1.0f, -1.0f, -1.0f};
+    static const float signs3[4] = {-1.0f, 1.0f, 1.0f, -1.0f};
+    const float32x4_t va = vld1q_f32(&a->x);
+    const float32x4_t zwxy = vextq_f32(va, va, 2);
+    const float32x4_t wzyx = vmulq_f32(vrev64q_f32(zwxy), vld1q_f32(signs1));
+    const float32x4_t yxwz = vmulq_f32(vrev64q_f32(va), vld1q_f32(signs3));
+    float32x4_t sum = vmulq_f32(vdupq_n_f32(b->w), va);
+    sum = vaddq_f32(sum, vmulq_f32(vdupq_n_f32(b->x), wzyx));
+    sum = vaddq_f32(sum, vmulq_f32(vdupq_n_f32(b->y), vmulq_f32(zwxy, vld1q_f32(signs2))));
+    sum = vaddq_f32(sum, vmulq_f32(vdupq_n_f32(b->z), yxwz));
+    vst1q_f32(&result->x, sum);
+#else
     result->x = (b->w * a->x) + (b->x * a->w) + (b->y * a->z) - (b->z * a->y);
     result->y = (b->w * a->y) - (b->x * a->z) + (b->y * a->w) + (b->z * a->x);
     result->z = (b->w * a->z) + (b->x * a->y) - (b->y * a->x) + (b->z * a->w);
     result->w = (b->w * a->w) - (b->x * a->x) - (b->y * a->y) - (b->z * a->z);
+#endif
 }
 
 inline static void XrQuaternionf_Invert(XrQuaternionf* result, const XrQuaternionf* q) {
@@ -270,18 +488,68 @@ inline static void XrQuaternionf_Normalize(XrQuaternionf* q) {
     q->w *= lengthRcp;
 }
 
-inline static void XrQuaternionf_RotateVector3f(XrVector3f* result, const XrQuaternionf* a, const XrVector3f* v) {
-    XrQuaternionf q = {v->x, v->y, v->z, 0.0f};
-    XrQuaternionf aq;
-    XrQuaternionf_Multiply(&aq, &q, a);
-    XrQuaternionf aInv;
-    XrQuaternionf_Invert(&aInv, a);
-    XrQuaternionf aqaInv;
-    XrQuaternionf_Multiply(&aqaInv, &aInv, &aq);
+inline static void XrQuaternionf_NormalizeFast(XrQuaternionf* q) {
+    const float lengthRcp = XrRcpSqrtFast(q->x * q->x + q->y * q->y + q->z * q->z + q->w * q->w);
+    q->x *= lengthRcp;
+    q->y *= lengthRcp;
+    q->z *= lengthRcp;
+    q->w *= lengthRcp;
+}
 
-    result->x = aqaInv.x;
-    result->y = aqaInv.y;
-    result->z = aqaInv.z;
+// Normalizes count quaternions like XrQuaternionf_NormalizeFast, four at a time in the SIMD versions.  results may be q.
+inline static void XrQuaternionf_NormalizeArray(XrQuaternionf* results, const XrQuaternionf* q, uint32_t count) {
+    uint32_t i = 0;
+#if defined(XR_LINEAR_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(&q[i].x);
+        __m128 y = _mm_loadu_ps(&q[i + 1].x);
+        __m128 z = _mm_loadu_ps(&q[i + 2].x);
+        __m128 w = _mm_loadu_ps(&q[i + 3].x);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        const __m128 lengthRcp = XrRcpSqrtFastSse2(
+            _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)), _mm_mul_ps(w, w)));
+        x = _mm_mul_ps(x, lengthRcp);
+        y = _mm_mul_ps(y, lengthRcp);
+        z = _mm_mul_ps(z, lengthRcp);
+        w = _mm_mul_ps(w, lengthRcp);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(&results[i].x, x);
+        _mm_storeu_ps(&results[i + 1].x, y);
+        _mm_storeu_ps(&results[i + 2].x, z);
+        _mm_storeu_ps(&results[i + 3].x, w);
+    }
+#elif defined(XR_LINEAR_NEON)
+    for (; i + 4 <= count; i += 4) {
+        float32x4x4_t v = vld4q_f32(&q[i].x);
+        const float32x4_t lengthRcp = XrRcpSqrtFastNeon(
+            vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(v.val[0], v.val[0]), vmulq_f32(v.val[1], v.val[1])),
+                                vmulq_f32(v.val[2], v.val[2])),
+                      vmulq_f32(v.val[3], v.val[3])));
+        for (int c = 0; c < 4; c++) {
+            v.val[c] = vmulq_f32(v.val[c], lengthRcp);
+        }
+        vst4q_f32(&results[i].x, v);
+    }
+#endif
+    for (; i < count; i++) {
+        results[i] = q[i];
+        XrQuaternionf_NormalizeFast(&results[i]);
+    }
+}
+
+inline static void XrQuaternionf_RotateVector3f(XrVector3f* result, const XrQuaternionf* a, const XrVector3f* v) {
+    // The vector part of a * v * inverse(a), expanded to (w^2 - u.u) v + 2 (u.v) u + 2 w (u x v) for a = (u, w), which
+    // takes about half the multiplies of the two quaternion products.
+    const float uu = a->x * a->x + a->y * a->y + a->z * a->z;
+    const float uv2 = 2.0f * (a->x * v->x + a->y * v->y + a->z * v->z);
+    const float vScale = a->w * a->w - uu;
+    const float w2 = a->w + a->w;
+    const float x = vScale * v->x + uv2 * a->x + w2 * (a->y * v->z - a->z * v->y);
+    const float y = vScale * v->y + uv2 * a->y + w2 * (a->z * v->x - a->x * v->z);
+    const float z = vScale * v->z + uv2 * a->z + w2 * (a->x * v->y - a->y * v->x);
+    result->x = x;
+    result->y = y;
+    result->z = z;
 }
 
 inline static void XrPosef_CreateIdentity(XrPosef* result) {
@@ -295,11 +563,77 @@ inline static void XrPosef_TransformVector3f(XrVector3f* result, const XrPosef*
     XrVector3f_Add(result, &r0, &a->position);
 }
 
+// Transforms count vectors by the same pose.  The rotation is turned into a matrix once, so results can differ from
+// those of XrPosef_TransformVector3f by rounding.  results may be v.
+inline static void XrPosef_TransformVector3fArray(XrVector3f* results, const XrPosef* a, const XrVector3f* v, uint32_t count) {
+    const XrQuaternionf* q = &a->orientation;
+    const float x2 = q->x + q->x;
+    const float y2 = q->y + q->y;
+    const float z2 = q->z + q->z;
+    const float xx2 = q->x * x2;
+    const float yy2 = q->y * y2;
+    const float zz2 = q->z * z2;
+    const float yz2 = q->y * z2;
+    const float wx2 = q->w * x2;
+    const float xy2 = q->x * y2;
+    const float wz2 = q->w * z2;
+    const float xz2 = q->x * z2;
+    const float wy2 = q->w * y2;
+
+    const float r0 = 1.0f - yy2 - zz2, r3 = xy2 - wz2, r6 = xz2 + wy2;
+    const float r1 = xy2 + wz2, r4 = 1.0f - xx2 - zz2, r7 = yz2 - wx2;
+    const float r2 = xz2 - wy2, r5 = yz2 + wx2, r8 = 1.0f - xx2 - yy2;
+    const XrVector3f t = a->position;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const float x = v[i].x;
+        const float y = v[i].y;
+        const float z = v[i].z;
+        results[i].x = r0 * x + r3 * y + r6 * z + t.x;
+        results[i].y = r1 * x + r4 * y + r7 * z + t.y;
+        results[i].z = r2 * x + r5 * y + r8 * z + t.z;
+    }
+}
+
 inline static void XrPosef_Multiply(XrPosef* result, const XrPosef* a, const XrPosef* b) {
     XrQuaternionf_Multiply(&result->orientation, &b->orientation, &a->orientation);
     XrPosef_TransformVector3f(&result->position, a, &b->position);
 }
 
+// Multiplies a by count poses, given as separate arrays of orientations and positions, like XrPosef_Multiply(results[i],
+// a, pose i).  The rotation of a is turned into a matrix once, as in XrPosef_TransformVector3fArray.
+inline static void XrPosef_MultiplyArray(XrPosef* results, const XrPosef* a, const XrQuaternionf* orientations,
+                                         const XrVector3f* positions, uint32_t count) {
+    const XrQuaternionf* q = &a->orientation;
+    const float x2 = q->x + q->x;
+    const float y2 = q->y + q->y;
+    const float z2 = q->z + q->z;
+    const float xx2 = q->x * x2;
+    const float yy2 = q->y * y2;
+    const float zz2 = q->z * z2;
+    const float yz2 = q->y * z2;
+    const float wx2 = q->w * x2;
+    const float xy2 = q->x * y2;
+    const float wz2 = q->w * z2;
+    const float xz2 = q->x * z2;
+    const float wy2 = q->w * y2;
+
+    const float r0 = 1.0f - yy2 - zz2, r3 = xy2 - wz2, r6 = xz2 + wy2;
+    const float r1 = xy2 + wz2, r4 = 1.0f - xx2 - zz2, r7 = yz2 - wx2;
+    const float r2 = xz2 - wy2, r5 = yz2 + wx2, r8 = 1.0f - xx2 - yy2;
+    const XrVector3f t = a->position;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const float x = positions[i].x;
+        const float y = positions[i].y;
+        const float z = positions[i].z;
+        results[i].position.x = r0 * x + r3 * y + r6 * z + t.x;
+        results[i].position.y = r1 * x + r4 * y + r7 * z + t.y;
+        results[i].position.z = r2 * x + r5 * y + r8 * z + t.z;
+        XrQuaternionf_Multiply(&results[i].orientation, &orientations[i], q);
+    }
+}
+
 inline static void XrPosef_Invert(XrPosef* result, const XrPosef* a) {
     XrQuaternionf_Invert(&result->orientation, &a->orientation);
     XrVector3f aPosNeg;
@@ -307,8 +641,55 @@ inline static void XrPosef_Invert(XrPosef* result, const XrPosef* a) {
     XrQuaternionf_RotateVector3f(&result->position, &result->orientation, &aPosNeg);
 }
 
+// Interpolates count poses, e.g. two tracked frames at a display time in between, with XrVector3f_Lerp for the
+// positions and XrQuaternionf_LerpFast for the orientations.  results may be a or b.
+inline static void XrPosef_LerpArray(XrPosef* results, const XrPosef* a, const XrPosef* b, const float fraction, uint32_t count) {
+    uint32_t i = 0;
+#if defined(XR_LINEAR_SSE2) || defined(XR_LINEAR_NEON)
+    const uint32_t stride = sizeof(XrPosef) / sizeof(float);
+    for (; i + 4 <= count; i += 4) {
+        XrQuaternionf_LerpFast4(&results[i].orientation.x, &a[i].orientation.x, &b[i].orientation.x, fraction, stride);
+        for (uint32_t k = i; k < i + 4; k++) {
+            XrVector3f_Lerp(&results[k].position, &a[k].position, &b[k].position, fraction);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        XrVector3f_Lerp(&results[i].position, &a[i].position, &b[i].position, fraction);
+        XrQuaternionf_LerpFast(&results[i].orientation, &a[i].orientation, &b[i].orientation, fraction);
+    }
+}
+
 // Use left-multiplication to accumulate transformations.
 inline static void XrMatrix4x4f_Multiply(XrMatrix4x4f* result, const XrMatrix4x4f* a, const XrMatrix4x4f* b) {
+    // Each column of the result is the columns of a weighted by the elements of the same column of b.
+#if defined(XR_LINEAR_SSE2)
+    const __m128 a0 = _mm_loadu_ps(&a->m[0]);
+    const __m128 a1 = _mm_loadu_ps(&a->m[4]);
+    const __m128 a2 = _mm_loadu_ps(&a->m[8]);
+    const __m128 a3 = _mm_loadu_ps(&a->m[12]);
+    for (int column = 0; column < 4; column++) {
+        const float* bc = &b->m[4 * column];
+        __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(bc[0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(bc[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(bc[2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(bc[3])));
+        _mm_storeu_ps(&result->m[4 * column], sum);
+    }
+#elif defined(XR_LINEAR_NEON)
+    const float32x4_t a0 = vld1q_f32(&a->m[0]);
+    const float32x4_t a1 = vld1q_f32(&a->m[4]);
+    const float32x4_t a2 = vld1q_f32(&a->m[8]);
+    const float32x4_t a3 = vld1q_f32(&a->m[12]);
+    for (int column = 0; column < 4; column++) {
+        const float32x4_t bc = vld1q_f32(&b->m[4 * column]);
+        float32x4_t sum = vmulq_laneq_f32(a0, bc, 0);
+        sum = vaddq_f32(sum, vmulq_laneq_f32(a1, bc, 1));
+        sum = vaddq_f32(sum, vmulq_laneq_f32(a2, bc, 2));
+        sum = vaddq_f32(sum, vmulq_laneq_f32(a3, bc, 3));
+        vst1q_f32(&result->m[4 * column], sum);
+    }
+#else
     result->m[0] = a->m[0] * b->m[0] + a->m[4] * b->m[1] + a->m[8] * b->m[2] + a->m[12] * b->m[3];
     result->m[1] = a->m[1] * b->m[0] + a->m[5] * b->m[1] + a->m[9] * b->m[2] + a->m[13] * b->m[3];
     result->m[2] = a->m[2] * b->m[0] + a->m[6] * b->m[1] + a->m[10] * b->m[2] + a->m[14] * b->m[3];
@@ -328,6 +709,50 @@ inline static void XrMatrix4x4f_Multiply(XrMatrix4x4f* result, const XrMatrix4x4
     result->m[13] = a->m[1] * b->m[12] + a->m[5] * b->m[13] + a->m[9] * b->m[14] + a->m[13] * b->m[15];
     result->m[14] = a->m[2] * b->m[12] + a->m[6] * b->m[13] + a->m[10] * b->m[14] + a->m[14] * b->m[15];
     result->m[15] = a->m[3] * b->m[12] + a->m[7] * b->m[13] + a->m[11] * b->m[14] + a->m[15] * b->m[15];
+#endif
+}
+
+// Use left-multiplication to accumulate transformations into each of count matrices, like many model matrices into
+// model-view-projection matrices.  a is loaded once for all of them.  results may be b, but must not overlap a.
+inline static void XrMatrix4x4f_MultiplyArray(XrMatrix4x4f* results, const XrMatrix4x4f* a, const XrMatrix4x4f* b,
+                                              uint32_t count) {
+#if defined(XR_LINEAR_SSE2)
+    const __m128 a0 = _mm_loadu_ps(&a->m[0]);
+    const __m128 a1 = _mm_loadu_ps(&a->m[4]);
+    const __m128 a2 = _mm_loadu_ps(&a->m[8]);
+    const __m128 a3 = _mm_loadu_ps(&a->m[12]);
+    for (uint32_t i = 0; i < count; i++) {
+        for (int column = 0; column < 4; column++) {
+            const float* bc = &b[i].m[4 * column];
+            __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(bc[0]));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(bc[1])));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(bc[2])));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(bc[3])));
+            _mm_storeu_ps(&results[i].m[4 * column], sum);
+        }
+    }
+#elif defined(XR_LINEAR_NEON)
+    const float32x4_t a0 = vld1q_f32(&a->m[0]);
+    const float32x4_t a1 = vld1q_f32(&a->m[4]);
+    const float32x4_t a2 = vld1q_f32(&a->m[8]);
+    const float32x4_t a3 = vld1q_f32(&a->m[12]);
+    for (uint32_t i = 0; i < count; i++) {
+        for (int column = 0; column < 4; column++) {
+            const float32x4_t bc = vld1q_f32(&b[i].m[4 * column]);
+            float32x4_t sum = vmulq_laneq_f32(a0, bc, 0);
+            sum = vaddq_f32(sum, vmulq_laneq_f32(a1, bc, 1));
+            sum = vaddq_f32(sum, vmulq_laneq_f32(a2, bc, 2));
+            sum = vaddq_f32(sum, vmulq_laneq_f32(a3, bc, 3));
+            vst1q_f32(&results[i].m[4 * column], sum);
+        }
+    }
+#else
+    for (uint32_t i = 0; i < count; i++) {
+        XrMatrix4x4f product;
+        XrMatrix4x4f_Multiply(&product, a, &b[i]);
+        results[i] = product;
+    }
+#endif
 }
 
 // Creates the transpose of the given matrix.
@@ -365,26 +790,46 @@ inline static float XrMatrix4x4f_Minor(const XrMatrix4x4f* matrix, int r0, int r
 
 // Calculates the inverse of a 4x4 matrix.
 inline static void XrMatrix4x4f_Invert(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
-    const float rcpDet =
-        1.0f / (src->m[0] * XrMatrix4x4f_Minor(src, 1, 2, 3, 1, 2, 3) - src->m[1] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 2, 3) +
-                src->m[2] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 3) - src->m[3] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 2));
-
-    result->m[0] = XrMatrix4x4f_Minor(src, 1, 2, 3, 1, 2, 3) * rcpDet;
-    result->m[1] = -XrMatrix4x4f_Minor(src, 0, 2, 3, 1, 2, 3) * rcpDet;
-    result->m[2] = XrMatrix4x4f_Minor(src, 0, 1, 3, 1, 2, 3) * rcpDet;
-    result->m[3] = -XrMatrix4x4f_Minor(src, 0, 1, 2, 1, 2, 3) * rcpDet;
-    result->m[4] = -XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 2, 3) * rcpDet;
-    result->m[5] = XrMatrix4x4f_Minor(src, 0, 2, 3, 0, 2, 3) * rcpDet;
-    result->m[6] = -XrMatrix4x4f_Minor(src, 0, 1, 3, 0, 2, 3) * rcpDet;
-    result->m[7] = XrMatrix4x4f_Minor(src, 0, 1, 2, 0, 2, 3) * rcpDet;
-    result->m[8] = XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 3) * rcpDet;
-    result->m[9] = -XrMatrix4x4f_Minor(src, 0, 2, 3, 0, 1, 3) * rcpDet;
-    result->m[10] = XrMatrix4x4f_Minor(src, 0, 1, 3, 0, 1, 3) * rcpDet;
-    result->m[11] = -XrMatrix4x4f_Minor(src, 0, 1, 2, 0, 1, 3) * rcpDet;
-    result->m[12] = -XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 2) * rcpDet;
-    result->m[13] = XrMatrix4x4f_Minor(src, 0, 2, 3, 0, 1, 2) * rcpDet;
-    result->m[14] = -XrMatrix4x4f_Minor(src, 0, 1, 3, 0, 1, 2) * rcpDet;
-    result->m[15] = XrMatrix4x4f_Minor(src, 0, 1, 2, 0, 1, 2) * rcpDet;
+    // The cofactors are built from the 2x2 determinants of the first two and the last two columns, so each of those is
+    // computed once instead of once per 3x3 minor.
+    const float* m = src->m;
+    const float s0 = m[0] * m[5] - m[4] * m[1];
+    const float s1 = m[0] * m[6] - m[4] * m[2];
+    const float s2 = m[0] * m[7] - m[4] * m[3];
+    const float s3 = m[1] * m[6] - m[5] * m[2];
+    const float s4 = m[1] * m[7] - m[5] * m[3];
+    const float s5 = m[2] * m[7] - m[6] * m[3];
+
+    const float c5 = m[10] * m[15] - m[14] * m[11];
+    const float c4 = m[9] * m[15] - m[13] * m[11];
+    const float c3 = m[9] * m[14] - m[13] * m[10];
+    const float c2 = m[8] * m[15] - m[12] * m[11];
+    const float c1 = m[8] * m[14] - m[12] * m[10];
+    const float c0 = m[8] * m[13] - m[12] * m[9];
+
+    const float rcpDet = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+    float inverse[16];
+    inverse[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * rcpDet;
+    inverse[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * rcpDet;
+    inverse[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * rcpDet;
+    inverse[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * rcpDet;
+    inverse[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * rcpDet;
+    inverse[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * rcpDet;
+    inverse[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * rcpDet;
+    inverse[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * rcpDet;
+    inverse[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * rcpDet;
+    inverse[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * rcpDet;
+    inverse[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * rcpDet;
+    inverse[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * rcpDet;
+    inverse[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * rcpDet;
+    inverse[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * rcpDet;
+    inverse[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * rcpDet;
+    inverse[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * rcpDet;
+
+    for (int i = 0; i < 16; i++) {
+        result->m[i] = inverse[i];
+    }
 }
 
 // Calculates the inverse of a rigid body transform.
@@ -548,6 +993,48 @@ inline static void XrMatrix4x4f_CreateTranslationRotationScale(XrMatrix4x4f* res
     XrMatrix4x4f_Multiply(result, &translationMatrix, &combinedMatrix);
 }
 
+// Creates count combined translation(rotation(scale(object))) matrices from separate arrays of translations, rotations
+// and scales.  Each matrix is written directly instead of by multiplying three matrices, with the same results for
+// finite inputs, up to the sign of zeros.
+inline static void XrMatrix4x4f_CreateTranslationRotationScaleArray(XrMatrix4x4f* results, const XrVector3f* translations,
+                                                                    const XrQuaternionf* rotations, const XrVector3f* scales,
+                                                                    uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        const XrQuaternionf* q = &rotations[i];
+        const float x2 = q->x + q->x;
+        const float y2 = q->y + q->y;
+        const float z2 = q->z + q->z;
+        const float xx2 = q->x * x2;
+        const float yy2 = q->y * y2;
+        const float zz2 = q->z * z2;
+        const float yz2 = q->y * z2;
+        const float wx2 = q->w * x2;
+        const float xy2 = q->x * y2;
+        const float wz2 = q->w * z2;
+        const float xz2 = q->x * z2;
+        const float wy2 = q->w * y2;
+
+        const XrVector3f* s = &scales[i];
+        float* m = results[i].m;
+        m[0] = (1.0f - yy2 - zz2) * s->x;
+        m[1] = (xy2 + wz2) * s->x;
+        m[2] = (xz2 - wy2) * s->x;
+        m[3] = 0.0f;
+        m[4] = (xy2 - wz2) * s->y;
+        m[5] = (1.0f - xx2 - zz2) * s->y;
+        m[6] = (yz2 + wx2) * s->y;
+        m[7] = 0.0f;
+        m[8] = (xz2 + wy2) * s->z;
+        m[9] = (yz2 - wx2) * s->z;
+        m[10] = (1.0f - xx2 - yy2) * s->z;
+        m[11] = 0.0f;
+        m[12] = translations[i].x;
+        m[13] = translations[i].y;
+        m[14] = translations[i].z;
+        m[15] = 1.0f;
+    }
+}
+
 inline static void XrMatrix4x4f_CreateFromRigidTransform(XrMatrix4x4f* result, const XrPosef* s) {
     const XrVector3f identityScale = {1.0f, 1.0f, 1.0f};
     XrMatrix4x4f_CreateTranslationRotationScale(result, &s->position, &s->orientation, &identityScale);
@@ -631,6 +1118,34 @@ inline static void XrMatrix4x4f_CreateProjectionFov(XrMatrix4x4f* result, Graphi
     XrMatrix4x4f_CreateProjection(result, graphicsApi, tanLeft, tanRight, tanUp, tanDown, nearZ, farZ);
 }
 
+// Creates the view-projection matrix of a view with the given pose and FOV: the projection matrix times the inverse of
+// the pose's rigid transform.  Both are built in place and only the non-zero elements of the projection are
+// multiplied, instead of inverting a rigid body matrix and then doing a full matrix multiply, with the same results.
+inline static void XrMatrix4x4f_CreateViewProjectionFromPoseFov(XrMatrix4x4f* result, GraphicsAPI graphicsApi, const XrPosef* pose,
+                                                               const XrFovf fov, const float nearZ, const float farZ) {
+    XrMatrix4x4f projection;
+    XrMatrix4x4f_CreateProjectionFov(&projection, graphicsApi, fov, nearZ, farZ);
+    const float* p = projection.m;
+
+    // The inverse of a rigid body transform rotates by the transpose, then translates by the negated, rotated position.
+    XrMatrix4x4f rotation;
+    XrMatrix4x4f_CreateFromQuaternion(&rotation, &pose->orientation);
+    const float* r = rotation.m;
+    const XrVector3f* t = &pose->position;
+    const float tx = -(r[0] * t->x + r[1] * t->y + r[2] * t->z);
+    const float ty = -(r[4] * t->x + r[5] * t->y + r[6] * t->z);
+    const float tz = -(r[8] * t->x + r[9] * t->y + r[10] * t->z);
+    const float view[16] = {r[0], r[4], r[8], 0.0f, r[1], r[5], r[9], 0.0f, r[2], r[6], r[10], 0.0f, tx, ty, tz, 1.0f};
+
+    for (int column = 0; column < 4; column++) {
+        const float* v = &view[4 * column];
+        result->m[4 * column + 0] = p[0] * v[0] + p[8] * v[2];
+        result->m[4 * column + 1] = p[5] * v[1] + p[9] * v[2];
+        result->m[4 * column + 2] = p[10] * v[2] + p[14] * v[3];
+        result->m[4 * column + 3] = p[11] * v[2];
+    }
+}
+
 // Creates a matrix that transforms the -1 to 1 cube to cover the given 'mins' and 'maxs' transformed with the given 'matrix'.
 inline static void XrMatrix4x4f_CreateOffsetScaleForBounds(XrMatrix4x4f* result, const XrMatrix4x4f* matrix, const XrVector3f* mins,
                                                            const XrVector3f* maxs) {
@@ -779,10 +1294,29 @@ inline static void XrMatrix4x4f_TransformVector3f(XrVector3f* result, const XrMa
 
 // Transforms a 4D vector.
 inline static void XrMatrix4x4f_TransformVector4f(XrVector4f* result, const XrMatrix4x4f* m, const XrVector4f* v) {
-    result->x = m->m[0] * v->x + m->m[4] * v->y + m->m[8] * v->z + m->m[12] * v->w;
-    result->y = m->m[1] * v->x + m->m[5] * v->y + m->m[9] * v->z + m->m[13] * v->w;
-    result->z = m->m[2] * v->x + m->m[6] * v->y + m->m[10] * v->z + m->m[14] * v->w;
-    result->w = m->m[3] * v->x + m->m[7] * v->y + m->m[11] * v->z + m->m[15] * v->w;
+#if defined(XR_LINEAR_SSE2)
+    __m128 sum = _mm_mul_ps(_mm_loadu_ps(&m->m[0]), _mm_set1_ps(v->x));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&m->m[4]), _mm_set1_ps(v->y)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&m->m[8]), _mm_set1_ps(v->z)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&m->m[12]), _mm_set1_ps(v->w)));
+    _mm_storeu_ps(&result->x, sum);
+#elif defined(XR_LINEAR_NEON)
+    const float32x4_t vv = vld1q_f32(&v->x);
+    float32x4_t sum = vmulq_laneq_f32(vld1q_f32(&m->m[0]), vv, 0);
+    sum = vaddq_f32(sum, vmulq_laneq_f32(vld1q_f32(&m->m[4]), vv, 1));
+    sum = vaddq_f32(sum, vmulq_laneq_f32(vld1q_f32(&m->m[8]), vv, 2));
+    sum = vaddq_f32(sum, vmulq_laneq_f32(vld1q_f32(&m->m[12]), vv, 3));
+    vst1q_f32(&result->x, sum);
+#else
+    const float x = v->x;
+    const float y = v->y;
+    const float z = v->z;
+    const float w = v->w;
+    result->x = m->m[0] * x + m->m[4] * y + m->m[8] * z + m->m[12] * w;
+    result->y = m->m[1] * x + m->m[5] * y + m->m[9] * z + m->m[13] * w;
+    result->z = m->m[2] * x + m->m[6] * y + m->m[10] * z + m->m[14] * w;
+    result->w = m->m[3] * x + m->m[7] * y + m->m[11] * z + m->m[15] * w;
+#endif
 }
 
 // Transforms the 'mins' and 'maxs' bounds with the given 'matrix'.
@@ -866,4 +1400,160 @@ inline static bool XrMatrix4x4f_CullBounds(const XrMatrix4x4f* mvp, const XrVect
     return i == 8;
 }
 
+// The four side planes of one frustum that contains the frusta of all the views, e.g. both eyes of a stereo view
+// configuration, so the views can be culled once instead of once each.  A plane is its unit normal in xyz and its
+// distance in w, with the inside positive.  The frustum has the orientation of the first view and, on each side, the
+// widest tangent of any view, and its apex is just far enough behind the views to contain them all.  It has no near or
+// far plane.  Returns false if there is no such frustum, when a view looks sideways or backwards from the first.
+inline static bool XrPosef_CreateCombinedFrustumPlanes(XrVector4f* planes, const XrPosef* poses, const XrFovf* fovs,
+                                                       uint32_t viewCount) {
+    if (viewCount == 0) {
+        return false;
+    }
+
+    // Work in the space of the first view, where the frustum looks down -z.
+    XrQuaternionf inverse;
+    XrQuaternionf_Invert(&inverse, &poses[0].orientation);
+    float tanLeft = 0.0f;
+    float tanRight = 0.0f;
+    float tanDown = 0.0f;
+    float tanUp = 0.0f;
+    XrVector3f eyeMins = {0.0f, 0.0f, 0.0f};
+    XrVector3f eyeMaxs = {0.0f, 0.0f, 0.0f};
+    for (uint32_t i = 0; i < viewCount; i++) {
+        XrQuaternionf relative;
+        XrQuaternionf_Multiply(&relative, &poses[i].orientation, &inverse);
+        const float tanX[2] = {tanf(fovs[i].angleLeft), tanf(fovs[i].angleRight)};
+        const float tanY[2] = {tanf(fovs[i].angleDown), tanf(fovs[i].angleUp)};
+        // A view's frustum cut by the plane z = -1 is the convex quad of its rotated corners, bounded by their tangents.
+        for (int corner = 0; corner < 4; corner++) {
+            const XrVector3f direction = {tanX[corner & 1], tanY[corner >> 1], -1.0f};
+            XrVector3f rotated;
+            XrQuaternionf_RotateVector3f(&rotated, &relative, &direction);
+            if (!(rotated.z < -1e-4f)) {
+                return false;
+            }
+            const float tx = rotated.x / -rotated.z;
+            const float ty = rotated.y / -rotated.z;
+            tanLeft = (i == 0 && corner == 0) ? tx : (tx < tanLeft ? tx : tanLeft);
+            tanRight = (i == 0 && corner == 0) ? tx : (tx > tanRight ? tx : tanRight);
+            tanDown = (i == 0 && corner == 0) ? ty : (ty < tanDown ? ty : tanDown);
+            tanUp = (i == 0 && corner == 0) ? ty : (ty > tanUp ? ty : tanUp);
+        }
+        XrVector3f offset;
+        XrVector3f_Sub(&offset, &poses[i].position, &poses[0].position);
+        XrVector3f eye;
+        XrQuaternionf_RotateVector3f(&eye, &inverse, &offset);
+        XrVector3f_Min(&eyeMins, &eyeMins, &eye);
+        XrVector3f_Max(&eyeMaxs, &eyeMaxs, &eye);
+    }
+    if (!(tanLeft < 0.0f && tanRight > 0.0f && tanDown < 0.0f && tanUp > 0.0f)) {
+        return false;
+    }
+
+    // The apex is centered on the views, and each view, being inside the frustum, has its whole frustum inside it.
+    const float apexX = (eyeMins.x + eyeMaxs.x) * 0.5f;
+    const float apexY = (eyeMins.y + eyeMaxs.y) * 0.5f;
+    float apexZ = eyeMaxs.z;
+    for (uint32_t i = 0; i < viewCount; i++) {
+        XrVector3f offset;
+        XrVector3f_Sub(&offset, &poses[i].position, &poses[0].position);
+        XrVector3f eye;
+        XrQuaternionf_RotateVector3f(&eye, &inverse, &offset);
+        const float dx = eye.x - apexX;
+        const float dy = eye.y - apexY;
+        const float depthX = dx > 0.0f ? dx / tanRight : dx / tanLeft;
+        const float depthY = dy > 0.0f ? dy / tanUp : dy / tanDown;
+        const float depth = eye.z + (depthX > depthY ? depthX : depthY);
+        apexZ = depth > apexZ ? depth : apexZ;
+    }
+
+    // Inside the left plane, x - apexX >= tanLeft * (apexZ - z); the others are alike.
+    const XrVector4f local[4] = {
+        {1.0f, 0.0f, tanLeft, -(apexX + tanLeft * apexZ)},
+        {-1.0f, 0.0f, -tanRight, apexX + tanRight * apexZ},
+        {0.0f, 1.0f, tanDown, -(apexY + tanDown * apexZ)},
+        {0.0f, -1.0f, -tanUp, apexY + tanUp * apexZ},
+    };
+    for (int i = 0; i < 4; i++) {
+        const XrVector3f normal = {local[i].x, local[i].y, local[i].z};
+        const float lengthRcp = XrRcpSqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        XrVector3f rotated;
+        XrQuaternionf_RotateVector3f(&rotated, &poses[0].orientation, &normal);
+        XrVector3f_Scale(&rotated, &rotated, lengthRcp);
+        planes[i].x = rotated.x;
+        planes[i].y = rotated.y;
+        planes[i].z = rotated.z;
+        planes[i].w = local[i].w * lengthRcp -
+                      (rotated.x * poses[0].position.x + rotated.y * poses[0].position.y + rotated.z * poses[0].position.z);
+    }
+    return true;
+}
+
+// Writes the indices of the spheres, center in xyz and radius in w, that are not wholly outside any of the planes, in
+// order, to visibleIndices, and returns how many there are.  The planes are unit normals in xyz and distances in w, with
+// the inside positive, like those of XrPosef_CreateCombinedFrustumPlanes.  The SIMD versions test four spheres at a
+// time.
+inline static uint32_t XrVector4f_CullSpheres(uint32_t* visibleIndices, const XrVector4f* planes, uint32_t planeCount,
+                                              const XrVector4f* spheres, uint32_t count) {
+    uint32_t visibleCount = 0;
+    uint32_t i = 0;
+#if defined(XR_LINEAR_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        // Transposed, each register holds one component of the four spheres.
+        __m128 x = _mm_loadu_ps(&spheres[i].x);
+        __m128 y = _mm_loadu_ps(&spheres[i + 1].x);
+        __m128 z = _mm_loadu_ps(&spheres[i + 2].x);
+        __m128 r = _mm_loadu_ps(&spheres[i + 3].x);
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+        const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (uint32_t p = 0; p < planeCount; p++) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(planes[p].x)), _mm_set1_ps(planes[p].w));
+            distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(planes[p].y)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(planes[p].z)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+        const int mask = _mm_movemask_ps(inside);
+        for (uint32_t k = 0; k < 4; k++) {
+            visibleIndices[visibleCount] = i + k;
+            visibleCount += (uint32_t)(mask >> k) & 1;
+        }
+    }
+#elif defined(XR_LINEAR_NEON)
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t v[4];
+        for (uint32_t k = 0; k < 4; k++) {
+            v[k] = vld1q_f32(&spheres[i + k].x);
+        }
+        XrTranspose4Neon(v);
+        const float32x4_t negativeRadius = vnegq_f32(v[3]);
+        uint32x4_t inside = vdupq_n_u32(0xFFFFFFFF);
+        for (uint32_t p = 0; p < planeCount; p++) {
+            float32x4_t distance = vaddq_f32(vmulq_n_f32(v[0], planes[p].x), vdupq_n_f32(planes[p].w));
+            distance = vaddq_f32(distance, vmulq_n_f32(v[1], planes[p].y));
+            distance = vaddq_f32(distance, vmulq_n_f32(v[2], planes[p].z));
+            inside = vandq_u32(inside, vcgeq_f32(distance, negativeRadius));
+        }
+        uint32_t mask[4];
+        vst1q_u32(mask, inside);
+        for (uint32_t k = 0; k < 4; k++) {
+            visibleIndices[visibleCount] = i + k;
+            visibleCount += mask[k] & 1;
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        bool inside = true;
+        for (uint32_t p = 0; p < planeCount; p++) {
+            const float distance =
+                spheres[i].x * planes[p].x + spheres[i].y * planes[p].y + spheres[i].z * planes[p].z + planes[p].w;
+            inside = inside && distance >= -spheres[i].w;
+        }
+        visibleIndices[visibleCount] = i;
+        visibleCount += inside ? 1 : 0;
+    }
+    return visibleCount;
+}
+
 #endif  // XR_LINEAR_H_
@@ -0,0 +1,137 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include "xr_linear.h"
+
+// constexpr versions of the xr_linear.h constructors, for C++14 and later, so static transforms can be computed at
+// compile time.  They return by value instead of writing through a pointer, and give the same results as the functions
+// they mirror, except Sin and Cos, which can differ from sinf and cosf in the last bit.
+namespace XrLinear {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// sin(x) for |x| <= pi, by its Taylor series.
+constexpr double SinReduced(const double x) {
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; ++n) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+// x reduced to [-pi, pi].
+constexpr double ReduceAngle(const double x) {
+    const long long turns = static_cast<long long>(x / (2.0 * kPi) + (x >= 0.0 ? 0.5 : -0.5));
+    return x - static_cast<double>(turns) * 2.0 * kPi;
+}
+
+constexpr float Sin(const float radians) { return static_cast<float>(SinReduced(ReduceAngle(radians))); }
+
+constexpr float Cos(const float radians) { return static_cast<float>(SinReduced(ReduceAngle(radians + kPi / 2.0))); }
+
+constexpr XrQuaternionf CreateIdentityQuaternion() { return XrQuaternionf{0.0f, 0.0f, 0.0f, 1.0f}; }
+
+// Unlike XrQuaternionf_CreateFromAxisAngle, the axis must already be normalized.
+constexpr XrQuaternionf CreateQuaternionFromAxisAngle(const XrVector3f& axis, const float angleInRadians) {
+    const float s = Sin(angleInRadians / 2.0f);
+    return XrQuaternionf{s * axis.x, s * axis.y, s * axis.z, Cos(angleInRadians / 2.0f)};
+}
+
+constexpr XrPosef CreateIdentityPose() { return XrPosef{CreateIdentityQuaternion(), XrVector3f{0.0f, 0.0f, 0.0f}}; }
+
+constexpr XrMatrix4x4f CreateIdentity() {
+    return XrMatrix4x4f{{1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f}};
+}
+
+constexpr XrMatrix4x4f CreateTranslation(const float x, const float y, const float z) {
+    return XrMatrix4x4f{{1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, x, y, z, 1.0f}};
+}
+
+constexpr XrMatrix4x4f CreateScale(const float x, const float y, const float z) {
+    return XrMatrix4x4f{{x, 0.0f, 0.0f, 0.0f, 0.0f, y, 0.0f, 0.0f, 0.0f, 0.0f, z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f}};
+}
+
+// See XrMatrix4x4f_CreateProjection.  There is no constexpr version of XrMatrix4x4f_CreateProjectionFov, because it
+// needs the tangents of the FOV angles.
+constexpr XrMatrix4x4f CreateProjection(const GraphicsAPI graphicsApi, const float tanAngleLeft, const float tanAngleRight,
+                                        const float tanAngleUp, const float tanAngleDown, const float nearZ, const float farZ) {
+    const float tanAngleWidth = tanAngleRight - tanAngleLeft;
+    const float tanAngleHeight = graphicsApi == GRAPHICS_VULKAN ? (tanAngleDown - tanAngleUp) : (tanAngleUp - tanAngleDown);
+    const float offsetZ = (graphicsApi == GRAPHICS_OPENGL || graphicsApi == GRAPHICS_OPENGL_ES) ? nearZ : 0;
+
+    XrMatrix4x4f result{};
+    result.m[0] = 2.0f / tanAngleWidth;
+    result.m[8] = (tanAngleRight + tanAngleLeft) / tanAngleWidth;
+    result.m[5] = 2.0f / tanAngleHeight;
+    result.m[9] = (tanAngleUp + tanAngleDown) / tanAngleHeight;
+    if (farZ <= nearZ) {
+        // place the far plane at infinity
+        result.m[10] = -1.0f;
+        result.m[14] = -(nearZ + offsetZ);
+    } else {
+        result.m[10] = -(farZ + offsetZ) / (farZ - nearZ);
+        result.m[14] = -(farZ * (nearZ + offsetZ)) / (farZ - nearZ);
+    }
+    result.m[11] = -1.0f;
+    return result;
+}
+
+// See XrMatrix4x4f_Multiply.
+constexpr XrMatrix4x4f Multiply(const XrMatrix4x4f& a, const XrMatrix4x4f& b) {
+    XrMatrix4x4f result{};
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            result.m[4 * column + row] = a.m[row] * b.m[4 * column] + a.m[4 + row] * b.m[4 * column + 1] +
+                                         a.m[8 + row] * b.m[4 * column + 2] + a.m[12 + row] * b.m[4 * column + 3];
+        }
+    }
+    return result;
+}
+
+// See XrMatrix4x4f_CreateFromQuaternion.
+constexpr XrMatrix4x4f CreateFromQuaternion(const XrQuaternionf& quat) {
+    const float x2 = quat.x + quat.x;
+    const float y2 = quat.y + quat.y;
+    const float z2 = quat.z + quat.z;
+
+    const float xx2 = quat.x * x2;
+    const float yy2 = quat.y * y2;
+    const float zz2 = quat.z * z2;
+
+    const float yz2 = quat.y * z2;
+    const float wx2 = quat.w * x2;
+    const float xy2 = quat.x * y2;
+    const float wz2 = quat.w * z2;
+    const float xz2 = quat.x * z2;
+    const float wy2 = quat.w * y2;
+
+    return XrMatrix4x4f{{1.0f - yy2 - zz2, xy2 + wz2, xz2 - wy2, 0.0f, xy2 - wz2, 1.0f - xx2 - zz2, yz2 + wx2, 0.0f, xz2 + wy2,
+                         yz2 - wx2, 1.0f - xx2 - yy2, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f}};
+}
+
+// See XrMatrix4x4f_CreateTranslationRotationScale.
+constexpr XrMatrix4x4f CreateTranslationRotationScale(const XrVector3f& translation, const XrQuaternionf& rotation,
+                                                      const XrVector3f& scale) {
+    return Multiply(CreateTranslation(translation.x, translation.y, translation.z),
+                    Multiply(CreateFromQuaternion(rotation), CreateScale(scale.x, scale.y, scale.z)));
+}
+
+}  // namespace XrLinear
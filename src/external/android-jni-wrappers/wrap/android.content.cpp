@@ -14,15 +14,11 @@ Context::Meta::Meta(bool deferDrop)
         MetaBaseDroppable::dropClassRef();
     }
 }
-ContentUris::Meta::Meta(bool deferDrop)
-    : MetaBaseDroppable(ContentUris::getTypeName()),
+ContentUris::Meta::Meta()
+    : MetaBase(ContentUris::getTypeName()),
       appendId(classRef().getStaticMethod(
           "appendId",
-          "(Landroid/net/Uri$Builder;J)Landroid/net/Uri$Builder;")) {
-    if (!deferDrop) {
-        MetaBaseDroppable::dropClassRef();
-    }
-}
+          "(Landroid/net/Uri$Builder;J)Landroid/net/Uri$Builder;")) {}
 ComponentName::Meta::Meta()
     : MetaBase(ComponentName::getTypeName()),
       init(classRef().getMethod("<init>",
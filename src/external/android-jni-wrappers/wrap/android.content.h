@@ -92,19 +92,19 @@ class ContentUris : public ObjectWrapperBase {
     /*!
      * Class metadata
      */
-    struct Meta : public MetaBaseDroppable {
+    struct Meta : public MetaBase {
         jni::method_t appendId;
 
         /*!
          * Singleton accessor
          */
-        static Meta &data(bool deferDrop = false) {
-            static Meta instance{deferDrop};
+        static Meta &data() {
+            static Meta instance{};
             return instance;
         }
 
       private:
-        explicit Meta(bool deferDrop);
+        Meta();
     };
 };
 
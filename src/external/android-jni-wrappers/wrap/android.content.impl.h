@@ -19,11 +19,9 @@ inline ContentResolver Context::getContentResolver() const {
 
 inline net::Uri_Builder ContentUris::appendId(net::Uri_Builder &uri_Builder,
                                               long long longParam) {
-    auto &data = Meta::data(true);
-    auto ret = net::Uri_Builder(data.clazz().call<jni::Object>(
+    auto &data = Meta::data();
+    return net::Uri_Builder(data.clazz().call<jni::Object>(
         data.appendId, uri_Builder.object(), longParam));
-    data.dropClassRef();
-    return ret;
 }
 
 inline ComponentName ComponentName::construct(std::string const &pkg,
@@ -12,7 +12,7 @@ Uri::Meta::Meta()
     MetaBaseDroppable::dropClassRef();
 }
 Uri_Builder::Meta::Meta()
-    : MetaBaseDroppable(Uri_Builder::getTypeName()),
+    : MetaBase(Uri_Builder::getTypeName()),
       init(classRef().getMethod("<init>", "()V")),
       scheme(classRef().getMethod(
           "scheme", "(Ljava/lang/String;)Landroid/net/Uri$Builder;")),
@@ -20,8 +20,6 @@ Uri_Builder::Meta::Meta()
           "authority", "(Ljava/lang/String;)Landroid/net/Uri$Builder;")),
       appendPath(classRef().getMethod(
           "appendPath", "(Ljava/lang/String;)Landroid/net/Uri$Builder;")),
-      build(classRef().getMethod("build", "()Landroid/net/Uri;")) {
-    MetaBaseDroppable::dropClassRef();
-}
+      build(classRef().getMethod("build", "()Landroid/net/Uri;")) {}
 } // namespace android::net
 } // namespace wrap
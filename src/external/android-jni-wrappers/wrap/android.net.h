@@ -124,7 +124,7 @@ class Uri_Builder : public ObjectWrapperBase {
     /*!
      * Class metadata
      */
-    struct Meta : public MetaBaseDroppable {
+    struct Meta : public MetaBase {
         jni::method_t init;
         jni::method_t scheme;
         jni::method_t authority;
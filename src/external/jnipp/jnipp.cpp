@@ -1127,11 +1127,19 @@ namespace jni
     {
     }
 
-    template <> Array<std::string>::Array(long length) : Object(env()->NewObjectArray(length, Class("java/lang/String").getHandle(), nullptr)), _length(length)
+    // Found once per process, rather than for every string array.  Never destroyed, as the thread running static
+    // destructors may have no JNIEnv to release the reference with.
+    static const Class& stringClass()
     {
+        static const Class* cls = new Class("java/lang/String");
+        return *cls;
     }
 
-    template <> Array<std::wstring>::Array(long length) : Object(env()->NewObjectArray(length, Class("java/lang/String").getHandle(), nullptr)), _length(length)
+    template <> Array<std::string>::Array(long length) : Object(env()->NewObjectArray(length, stringClass().getHandle(), nullptr)), _length(length)
+    {
+    }
+
+    template <> Array<std::wstring>::Array(long length) : Object(env()->NewObjectArray(length, stringClass().getHandle(), nullptr)), _length(length)
     {
     }
 
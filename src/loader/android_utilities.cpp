@@ -11,11 +11,13 @@
 #include <wrap/android.net.h>
 #include <wrap/android.content.h>
 #include <wrap/android.database.h>
-#include <json/value.h>
 
 #include <openxr/openxr.h>
 
 #include <dlfcn.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <mutex>
 #include <sstream>
 #include <vector>
 #include <android/log.h>
@@ -186,36 +188,10 @@ static constexpr auto ABI = "x86_64";
 #error "Unknown ABI!"
 #endif
 
-/// Helper class to generate the jsoncpp object corresponding to a synthetic runtime manifest.
-class JsonManifestBuilder {
-   public:
-    JsonManifestBuilder(const std::string &libraryPathParent, const std::string &libraryPath);
-    JsonManifestBuilder &function(const std::string &functionName, const std::string &symbolName);
-
-    Json::Value build() const { return root_node; }
-
-   private:
-    Json::Value root_node;
-};
-
-inline JsonManifestBuilder::JsonManifestBuilder(const std::string &libraryPathParent, const std::string &libraryPath)
-    : root_node(Json::objectValue) {
-    root_node["file_format_version"] = "1.0.0";
-    root_node["instance_extensions"] = Json::Value(Json::arrayValue);
-    root_node["functions"] = Json::Value(Json::objectValue);
-    root_node[libraryPathParent] = Json::objectValue;
-    root_node[libraryPathParent]["library_path"] = libraryPath;
-}
-
-inline JsonManifestBuilder &JsonManifestBuilder::function(const std::string &functionName, const std::string &symbolName) {
-    root_node["functions"][functionName] = symbolName;
-    return *this;
-}
-
 static constexpr const char *getBrokerTypeName(bool systemBroker) { return systemBroker ? "system" : "installable"; }
 
 static int populateFunctions(wrap::android::content::Context const &context, bool systemBroker, const std::string &packageName,
-                             JsonManifestBuilder &builder) {
+                             std::vector<std::pair<std::string, std::string>> &renamedFunctions) {
     jni::Array<std::string> projection = makeArray({functions::Columns::FUNCTION_NAME, functions::Columns::SYMBOL_NAME});
 
     auto uri = functions::makeContentUri(systemBroker, XR_VERSION_MAJOR(XR_CURRENT_API_VERSION), packageName, ABI);
@@ -235,7 +211,7 @@ static int populateFunctions(wrap::android::content::Context const &context, boo
     auto functionIndex = cursor.getColumnIndex(functions::Columns::FUNCTION_NAME);
     auto symbolIndex = cursor.getColumnIndex(functions::Columns::SYMBOL_NAME);
     while (cursor.moveToNext()) {
-        builder.function(cursor.getString(functionIndex), cursor.getString(symbolIndex));
+        renamedFunctions.emplace_back(cursor.getString(functionIndex), cursor.getString(symbolIndex));
     }
 
     cursor.close();
@@ -289,7 +265,8 @@ static bool getActiveRuntimeCursor(wrap::android::content::Context const &contex
     return true;
 }
 
-int getActiveRuntimeVirtualManifest(wrap::android::content::Context const &context, Json::Value &virtualManifest) {
+/// Query the brokers for the active runtime, and the function remapping rows if it has them.
+static int queryActiveRuntime(wrap::android::content::Context const &context, ActiveRuntime &runtime) {
     jni::Array<std::string> projection = makeArray({active_runtime::Columns::PACKAGE_NAME, active_runtime::Columns::NATIVE_LIB_DIR,
                                                     active_runtime::Columns::SO_FILENAME, active_runtime::Columns::HAS_FUNCTIONS});
 
@@ -325,15 +302,15 @@ int getActiveRuntimeVirtualManifest(wrap::android::content::Context const &conte
             // we found a runtime that we can dlopen, use it.
             dlclose(lib);
 
-            JsonManifestBuilder builder{"runtime", lib_path};
+            ActiveRuntime found{lib_path, {}};
             if (hasFunctions) {
-                int result = populateFunctions(context, systemBroker, packageName, builder);
+                int result = populateFunctions(context, systemBroker, packageName, found.functions);
                 if (result != 0) {
                     ALOGW("Unable to populate functions from runtime: %s, checking for more records...", lib_path.c_str());
                     continue;
                 }
             }
-            virtualManifest = builder.build();
+            runtime = std::move(found);
             cursor.close();
             return 0;
         }
@@ -346,6 +323,53 @@ int getActiveRuntimeVirtualManifest(wrap::android::content::Context const &conte
     cursor.close();
     return -1;
 }
+/// The runtime of the last successful query.  Each query goes across JNI and Binder to the broker's content provider,
+/// so the few loader calls of an application's startup share one.  The broker has no change notification or version
+/// row to check, so the runtime is reused for a limited time, and only while its library is the same file.
+struct CachedActiveRuntime {
+    std::mutex mutex;
+    bool valid = false;
+    ActiveRuntime runtime;
+    struct stat libraryStat {};
+    std::chrono::steady_clock::time_point queried;
+};
+
+static constexpr std::chrono::seconds kActiveRuntimeCacheLifetime{30};
+
+static CachedActiveRuntime &getCachedActiveRuntime() {
+    static CachedActiveRuntime cached;
+    return cached;
+}
+
+static bool isSameFile(struct stat const &a, struct stat const &b) {
+    return a.st_dev == b.st_dev && a.st_ino == b.st_ino && a.st_size == b.st_size && a.st_mtime == b.st_mtime;
+}
+
+int getActiveRuntime(wrap::android::content::Context const &context, ActiveRuntime &runtime) {
+    CachedActiveRuntime &cached = getCachedActiveRuntime();
+    std::unique_lock<std::mutex> lock(cached.mutex);
+    const auto now = std::chrono::steady_clock::now();
+    if (cached.valid && now - cached.queried < kActiveRuntimeCacheLifetime) {
+        struct stat libraryStat {};
+        if (0 == stat(cached.runtime.libraryPath.c_str(), &libraryStat) && isSameFile(libraryStat, cached.libraryStat)) {
+            ALOGV("Using the cached active runtime %s", cached.runtime.libraryPath.c_str());
+            runtime = cached.runtime;
+            return 0;
+        }
+    }
+    cached.valid = false;
+
+    const int result = queryActiveRuntime(context, runtime);
+    if (result != 0) {
+        return result;
+    }
+    if (0 == stat(runtime.libraryPath.c_str(), &cached.libraryStat)) {
+        cached.runtime = runtime;
+        cached.queried = now;
+        cached.valid = true;
+    }
+    return 0;
+}
 }  // namespace openxr_android
 
 #endif  // __ANDROID__
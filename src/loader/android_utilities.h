@@ -11,22 +11,34 @@
 #include "wrap/android.content.h"
 
 #include <string>
-namespace Json {
-class Value;
-}  // namespace Json
+#include <utility>
+#include <vector>
 
 namespace openxr_android {
 using wrap::android::content::Context;
 
 /*!
- * Find the single active OpenXR runtime on the system, and return a constructed JSON object representing it.
+ * The active runtime, as the runtime broker describes it.
+ */
+struct ActiveRuntime {
+    //! The absolute path of the runtime library.
+    std::string libraryPath;
+    //! Function names the runtime exports under other symbol names, paired with those symbol names.
+    std::vector<std::pair<std::string, std::string>> functions;
+};
+
+/*!
+ * Find the single active OpenXR runtime on the system, and return what the runtime broker says about it.
+ *
+ * The result is cached for the process: calls shortly after a successful one reuse it, without querying the runtime
+ * broker again, while the runtime library file is unchanged.
  *
  * @param context An Android context, preferably an Activity Context.
- * @param[out] virtualManifest The Json::Value to fill with the virtual manifest.
+ * @param[out] runtime The runtime library and its renamed functions.
  *
  * @return 0 on success, something else on failure.
  */
-int getActiveRuntimeVirtualManifest(wrap::android::content::Context const &context, Json::Value &virtualManifest);
+int getActiveRuntime(wrap::android::content::Context const &context, ActiveRuntime &runtime);
 }  // namespace openxr_android
 
 #endif  // __ANDROID__
@@ -15,6 +15,7 @@
 #include "loader_platform.hpp"
 #include "manifest_file.hpp"
 #include "platform_utils.hpp"
+#include "static_chain.hpp"
 
 #include <openxr/openxr.h>
 #include <openxr/openxr_loader_negotiation.h>
@@ -29,8 +30,24 @@
 #include <vector>
 
 #define OPENXR_ENABLE_LAYERS_ENV_VAR "XR_ENABLE_API_LAYERS"
+#define OPENXR_DEFER_UNUSED_LAYERS_ENV_VAR "XR_LOADER_DEFER_UNUSED_API_LAYERS"
 
 // Add any layers defined in the loader layer environment variable.
+// Find the API layer manifests of a type.  With the static chain, its layers stand in for the implicit layers instead, and
+// there are no explicit layers.
+static XrResult FindApiLayerManifestFiles(const std::string& openxr_command, ManifestFileType type,
+                                          std::vector<std::unique_ptr<ApiLayerManifestFile>>& manifest_files) {
+#if defined(XR_LOADER_STATIC_CHAIN)
+    (void)openxr_command;
+    if (type == MANIFEST_TYPE_IMPLICIT_API_LAYER) {
+        ApiLayerManifestFile::AddStaticChainManifestFiles(manifest_files);
+    }
+    return XR_SUCCESS;
+#else
+    return ApiLayerManifestFile::FindManifestFiles(openxr_command, type, manifest_files);
+#endif  // defined(XR_LOADER_STATIC_CHAIN)
+}
+
 static void AddEnvironmentApiLayers(std::vector<std::string>& enabled_layers) {
     std::string layers = LoaderProperty::Get(OPENXR_ENABLE_LAYERS_ENV_VAR);
 
@@ -75,10 +92,10 @@ XrResult ApiLayerInterface::GetApiLayerProperties(const std::string& openxr_comm
     }
 
     // Find any implicit layers which we may need to report information for.
-    XrResult result = ApiLayerManifestFile::FindManifestFiles(openxr_command, MANIFEST_TYPE_IMPLICIT_API_LAYER, manifest_files);
+    XrResult result = FindApiLayerManifestFiles(openxr_command, MANIFEST_TYPE_IMPLICIT_API_LAYER, manifest_files);
     if (XR_SUCCEEDED(result)) {
         // Find any explicit layers which we may need to report information for.
-        result = ApiLayerManifestFile::FindManifestFiles(openxr_command, MANIFEST_TYPE_EXPLICIT_API_LAYER, manifest_files);
+        result = FindApiLayerManifestFiles(openxr_command, MANIFEST_TYPE_EXPLICIT_API_LAYER, manifest_files);
     }
     if (XR_FAILED(result)) {
         LoaderLogger::LogErrorMessage(openxr_command,
@@ -129,10 +146,10 @@ XrResult ApiLayerInterface::GetInstanceExtensionProperties(const std::string& op
 
     // If a layer name is supplied, only use the information out of that one layer
     if (nullptr != layer_name && 0 != strlen(layer_name)) {
-        XrResult result = ApiLayerManifestFile::FindManifestFiles(openxr_command, MANIFEST_TYPE_IMPLICIT_API_LAYER, manifest_files);
+        XrResult result = FindApiLayerManifestFiles(openxr_command, MANIFEST_TYPE_IMPLICIT_API_LAYER, manifest_files);
         if (XR_SUCCEEDED(result)) {
             // Find any explicit layers which we may need to report information for.
-            result = ApiLayerManifestFile::FindManifestFiles(openxr_command, MANIFEST_TYPE_EXPLICIT_API_LAYER, manifest_files);
+            result = FindApiLayerManifestFiles(openxr_command, MANIFEST_TYPE_EXPLICIT_API_LAYER, manifest_files);
             if (XR_FAILED(result)) {
                 LoaderLogger::LogErrorMessage(
                     openxr_command,
@@ -158,7 +175,7 @@ XrResult ApiLayerInterface::GetInstanceExtensionProperties(const std::string& op
         }
         // Otherwise, we want to add only implicit API layers and explicit API layers enabled using the environment variables
     } else {
-        XrResult result = ApiLayerManifestFile::FindManifestFiles(openxr_command, MANIFEST_TYPE_IMPLICIT_API_LAYER, manifest_files);
+        XrResult result = FindApiLayerManifestFiles(openxr_command, MANIFEST_TYPE_IMPLICIT_API_LAYER, manifest_files);
         if (XR_SUCCEEDED(result)) {
             // Find any environmentally enabled explicit layers.  If they're present, treat them like implicit layers
             // since we know that they're going to be enabled.
@@ -166,8 +183,7 @@ XrResult ApiLayerInterface::GetInstanceExtensionProperties(const std::string& op
             AddEnvironmentApiLayers(env_enabled_layers);
             if (!env_enabled_layers.empty()) {
                 std::vector<std::unique_ptr<ApiLayerManifestFile>> exp_layer_man_files = {};
-                result =
-                    ApiLayerManifestFile::FindManifestFiles(openxr_command, MANIFEST_TYPE_EXPLICIT_API_LAYER, exp_layer_man_files);
+                result = FindApiLayerManifestFiles(openxr_command, MANIFEST_TYPE_EXPLICIT_API_LAYER, exp_layer_man_files);
                 if (XR_SUCCEEDED(result)) {
                     for (auto& exp_layer_man_file : exp_layer_man_files) {
                         for (std::string& enabled_layer : env_enabled_layers) {
@@ -191,8 +207,35 @@ XrResult ApiLayerInterface::GetInstanceExtensionProperties(const std::string& op
     return XR_SUCCESS;
 }
 
+// An implicit layer whose manifest lists instance extensions, none of which the application enabled, is only
+// there to provide those extensions.  When deferring is enabled such a layer is left out of the chain instead of
+// having its library loaded.  Layers that list no extensions may intercept core functions, so they always load.
+static bool IsUnusedImplicitApiLayer(ApiLayerManifestFile& manifest_file, uint32_t enabled_extension_count,
+                                     const char* const* enabled_extension_names) {
+    if (manifest_file.Type() != MANIFEST_TYPE_IMPLICIT_API_LAYER) {
+        return false;
+    }
+    std::vector<XrExtensionProperties> extension_properties;
+    manifest_file.GetInstanceExtensionProperties(extension_properties);
+    if (extension_properties.empty()) {
+        return false;
+    }
+    if (nullptr == enabled_extension_names) {
+        return true;
+    }
+    for (const XrExtensionProperties& prop : extension_properties) {
+        for (uint32_t ext = 0; ext < enabled_extension_count; ++ext) {
+            if (strcmp(prop.extensionName, enabled_extension_names[ext]) == 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uint32_t enabled_api_layer_count,
-                                          const char* const* enabled_api_layer_names,
+                                          const char* const* enabled_api_layer_names, uint32_t enabled_extension_count,
+                                          const char* const* enabled_extension_names,
                                           std::vector<std::unique_ptr<ApiLayerInterface>>& api_layer_interfaces) {
     XrResult last_error = XR_SUCCESS;
     std::unordered_set<std::string> layers_already_found;
@@ -201,8 +244,8 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
     std::vector<std::unique_ptr<ApiLayerManifestFile>> enabled_layer_manifest_files_in_init_order = {};
 
     // Find any implicit layers.
-    XrResult result = ApiLayerManifestFile::FindManifestFiles(openxr_command, MANIFEST_TYPE_IMPLICIT_API_LAYER,
-                                                              enabled_layer_manifest_files_in_init_order);
+    XrResult result =
+        FindApiLayerManifestFiles(openxr_command, MANIFEST_TYPE_IMPLICIT_API_LAYER, enabled_layer_manifest_files_in_init_order);
 
     for (const auto& enabled_layer_manifest_file : enabled_layer_manifest_files_in_init_order) {
         layers_already_found.insert(enabled_layer_manifest_file->LayerName());
@@ -212,8 +255,7 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
     std::vector<std::unique_ptr<ApiLayerManifestFile>> explicit_layer_manifest_files = {};
 
     if (XR_SUCCEEDED(result)) {
-        result = ApiLayerManifestFile::FindManifestFiles(openxr_command, MANIFEST_TYPE_EXPLICIT_API_LAYER,
-                                                         explicit_layer_manifest_files);
+        result = FindApiLayerManifestFiles(openxr_command, MANIFEST_TYPE_EXPLICIT_API_LAYER, explicit_layer_manifest_files);
     }
 
     bool found_all_layers = true;
@@ -273,8 +315,30 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
         }
     }
 
+    if (LoaderProperty::IsSet(OPENXR_DEFER_UNUSED_LAYERS_ENV_VAR)) {
+        auto& manifest_files = enabled_layer_manifest_files_in_init_order;
+        for (auto it = manifest_files.begin(); it != manifest_files.end();) {
+            if (IsUnusedImplicitApiLayer(**it, enabled_extension_count, enabled_extension_names)) {
+                LoaderLogger::LogInfoMessage(openxr_command, "ApiLayerInterface::LoadApiLayers deferring layer " +
+                                                                 (*it)->LayerName() + ", none of its extensions are enabled");
+                it = manifest_files.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
     for (std::unique_ptr<ApiLayerManifestFile>& manifest_file : enabled_layer_manifest_files_in_init_order) {
-        LoaderPlatformLibraryHandle layer_library = LoaderPlatformLibraryOpen(manifest_file->LibraryPath());
+        LoaderPlatformLibraryHandle layer_library = nullptr;
+#if defined(XR_LOADER_STATIC_CHAIN)
+        // The layer is linked into the loader, so there is no library to load.
+        const bool forwardedInitLoader = false;
+        PFN_xrNegotiateLoaderApiLayerInterface negotiate = FindStaticChainApiLayer(manifest_file->LayerName())->negotiate;
+#else
+        {
+            LoaderPhaseTimer timer(openxr_command.c_str(), "layer_library_load", manifest_file->LayerName());
+            layer_library = LoaderPlatformLibraryOpen(manifest_file->LibraryPath());
+        }
         if (nullptr == layer_library) {
             if (!any_loaded) {
                 last_error = XR_ERROR_FILE_ACCESS_ERROR;
@@ -336,6 +400,7 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
             last_error = XR_ERROR_API_LAYER_NOT_PRESENT;
             continue;
         }
+#endif  // defined(XR_LOADER_STATIC_CHAIN)
 
         // Loader info for negotiation
         XrNegotiateLoaderInfo loader_info = {};
@@ -353,7 +418,11 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
         api_layer_info.structVersion = XR_API_LAYER_INFO_STRUCT_VERSION;
         api_layer_info.structSize = sizeof(XrNegotiateApiLayerRequest);
 
-        XrResult res = negotiate(&loader_info, manifest_file->LayerName().c_str(), &api_layer_info);
+        XrResult res = XR_SUCCESS;
+        {
+            LoaderPhaseTimer timer(openxr_command.c_str(), "layer_negotiate", manifest_file->LayerName());
+            res = negotiate(&loader_info, manifest_file->LayerName().c_str(), &api_layer_info);
+        }
         // If we supposedly succeeded, but got a nullptr for getInstanceProcAddr
         // then something still went wrong, so return with an error.
         if (XR_SUCCEEDED(res) && nullptr == api_layer_info.getInstanceProcAddr) {
@@ -13,26 +13,34 @@
 
 #include "api_layer_interface.hpp"
 #include "exception_handling.hpp"
+#include "filesystem_utils.hpp"
 #include "hex_and_handles.h"
 #include "loader_init_data.hpp"
 #include "loader_instance.hpp"
 #include "loader_logger_recorders.hpp"
 #include "loader_logger.hpp"
 #include "loader_platform.hpp"
+#include "loader_properties.hpp"
+#include "manifest_file.hpp"
+#include "platform_trace.hpp"
 #include "runtime_interface.hpp"
 #include "xr_generated_dispatch_table_core.h"
 #include "xr_generated_loader.hpp"
 
 #include <openxr/openxr.h>
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+XR_TRACE_DEFINE_PROVIDER();
+
 // Global loader lock to:
 //   1. Ensure ActiveLoaderInstance get and set operations are done atomically.
 //   2. Ensure RuntimeInterface isn't used to unload the runtime while the runtime is in use.
@@ -41,6 +49,104 @@ static std::mutex &GetGlobalLoaderMutex() {
     return loader_mutex;
 }
 
+#if !defined(XR_LOADER_STATIC_CHAIN)
+// With XR_LOADER_PREDISCOVER set, xrInitializeLoaderKHR finds and parses the runtime and API layer manifests on a
+// thread of its own, so the later calls find them in the manifest cache while the app was busy with its own startup.
+// Set to "preload", the thread also opens the runtime library, which stays open until the runtime is loaded.
+class Prediscovery {
+   public:
+    static Prediscovery &Get() {
+        static Prediscovery prediscovery;
+        return prediscovery;
+    }
+
+    ~Prediscovery() {
+        Wait();
+        ReleasePreloadedLibraries();
+    }
+
+    void Start() {
+        Wait();
+        const std::string mode = LoaderProperty::Get("XR_LOADER_PREDISCOVER");
+        if (mode.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        _thread = std::thread(&Prediscovery::Run, this, mode == "preload");
+    }
+
+    // Called before the loader mutex is taken by the calls that use the manifests.
+    void Wait() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    // Called once the runtime is loaded, which holds its own reference to the library.
+    void ReleasePreloadedLibraries() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (LoaderPlatformLibraryHandle library : _preloaded_libraries) {
+            LoaderPlatformLibraryClose(library);
+        }
+        _preloaded_libraries.clear();
+    }
+
+   private:
+    Prediscovery() = default;
+
+    void Run(bool preload) {
+        std::unique_lock<std::mutex> loader_lock(GetGlobalLoaderMutex());
+        FileSysUtilsScopedCache fs_cache;
+        LoaderProperty::ScopedSnapshot property_snapshot;
+        LoaderPhaseTimer timer("xrInitializeLoaderKHR", "prediscovery");
+
+        std::vector<std::unique_ptr<RuntimeManifestFile>> runtime_manifest_files;
+        if (XR_SUCCEEDED(RuntimeManifestFile::FindManifestFiles("xrInitializeLoaderKHR", runtime_manifest_files)) && preload &&
+            !runtime_manifest_files.empty()) {
+            // Only the runtime that will be tried first, and no layers: opening a library runs its static constructors.
+            LoaderPlatformLibraryHandle library = LoaderPlatformLibraryOpen(runtime_manifest_files.front()->LibraryPath());
+            if (library != nullptr) {
+                // Not under _mutex, which Wait holds while joining this thread.
+                _preloaded_libraries.push_back(library);
+            }
+        }
+        for (ManifestFileType type : {MANIFEST_TYPE_IMPLICIT_API_LAYER, MANIFEST_TYPE_EXPLICIT_API_LAYER}) {
+            std::vector<std::unique_ptr<ApiLayerManifestFile>> layer_manifest_files;
+            ApiLayerManifestFile::FindManifestFiles("xrInitializeLoaderKHR", type, layer_manifest_files);
+        }
+    }
+
+    std::mutex _mutex;
+    std::thread _thread;
+    std::vector<LoaderPlatformLibraryHandle> _preloaded_libraries;
+};
+#endif  // !defined(XR_LOADER_STATIC_CHAIN)
+
+// Joins any background discovery before a call that uses the manifests, and once a call that loads the runtime is
+// over, closes the runtime library opened ahead of it.
+class ScopedPrediscoveryJoin {
+   public:
+    explicit ScopedPrediscoveryJoin(bool loads_runtime) : _loads_runtime(loads_runtime) {
+#if !defined(XR_LOADER_STATIC_CHAIN)
+        Prediscovery::Get().Wait();
+#endif  // !defined(XR_LOADER_STATIC_CHAIN)
+    }
+    ~ScopedPrediscoveryJoin() {
+#if !defined(XR_LOADER_STATIC_CHAIN)
+        if (_loads_runtime) {
+            Prediscovery::Get().ReleasePreloadedLibraries();
+        }
+#endif  // !defined(XR_LOADER_STATIC_CHAIN)
+    }
+
+    ScopedPrediscoveryJoin(const ScopedPrediscoveryJoin &) = delete;
+    ScopedPrediscoveryJoin &operator=(const ScopedPrediscoveryJoin &) = delete;
+
+   private:
+    bool _loads_runtime;
+};
+
 // Prototypes for the debug utils calls used internally.
 static XRAPI_ATTR XrResult XRAPI_CALL LoaderTrampolineCreateDebugUtilsMessengerEXT(
     XrInstance instance, const XrDebugUtilsMessengerCreateInfoEXT *createInfo, XrDebugUtilsMessengerEXT *messenger);
@@ -59,6 +165,9 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermDestroyDebugUtilsMessengerEXT(
 static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermSubmitDebugUtilsMessageEXT(
     XrInstance instance, XrDebugUtilsMessageSeverityFlagsEXT messageSeverity, XrDebugUtilsMessageTypeFlagsEXT messageTypes,
     const XrDebugUtilsMessengerCallbackDataEXT *callbackData);
+static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermSessionBeginDebugUtilsLabelRegionEXT(XrSession, const XrDebugUtilsLabelEXT *);
+static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermSessionEndDebugUtilsLabelRegionEXT(XrSession);
+static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermSessionInsertDebugUtilsLabelEXT(XrSession, const XrDebugUtilsLabelEXT *);
 static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrGetInstanceProcAddr(XrInstance instance, const char *name,
                                                                   PFN_xrVoidFunction *function);
 
@@ -74,23 +183,40 @@ inline bool IsMissingNullTerminator(const char (&str)[max_length]) {
     return true;
 }
 
+// The generated trampolines call only these on the way to the next layer, and have nothing to destroy when it returns,
+// so they need no exception handling of their own.
+static_assert(noexcept(ActiveLoaderInstance::GetDispatchTable()), "generated trampolines must not throw");
+static_assert(noexcept(ActiveLoaderInstance::NoActiveInstance("")), "generated trampolines must not throw");
+
 // ---- Core 1.0 manual loader trampoline functions
 static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrInitializeLoaderKHR(const XrLoaderInitInfoBaseHeaderKHR *);
 
 static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrInitializeLoaderKHR(const XrLoaderInitInfoBaseHeaderKHR *loaderInitInfo)
     XRLOADER_ABI_TRY {
+    XR_TRACE_SCOPE("xrInitializeLoaderKHR");
     LoaderLogger::LogVerboseMessage("xrInitializeLoaderKHR", "Entering loader trampoline");
-    return InitializeLoaderInitData(loaderInitInfo);
+    XrResult result = InitializeLoaderInitData(loaderInitInfo);
+#if !defined(XR_LOADER_STATIC_CHAIN)
+    if (XR_SUCCEEDED(result)) {
+        Prediscovery::Get().Start();
+    }
+#endif  // !defined(XR_LOADER_STATIC_CHAIN)
+    return result;
 }
 XRLOADER_ABI_CATCH_FALLBACK
 
 static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrEnumerateApiLayerProperties(uint32_t propertyCapacityInput,
                                                                           uint32_t *propertyCountOutput,
                                                                           XrApiLayerProperties *properties) XRLOADER_ABI_TRY {
+    XR_TRACE_SCOPE("xrEnumerateApiLayerProperties");
     LoaderLogger::LogVerboseMessage("xrEnumerateApiLayerProperties", "Entering loader trampoline");
 
+    ScopedPrediscoveryJoin prediscovery_join(false);
     // Make sure only one thread is attempting to read the JSON files at a time.
     std::unique_lock<std::mutex> loader_lock(GetGlobalLoaderMutex());
+    // Read each search directory and environment variable at most once during this call.
+    FileSysUtilsScopedCache fs_cache;
+    LoaderProperty::ScopedSnapshot property_snapshot;
 
     XrResult result = ApiLayerInterface::GetApiLayerProperties("xrEnumerateApiLayerProperties", propertyCapacityInput,
                                                                propertyCountOutput, properties);
@@ -102,9 +228,66 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrEnumerateApiLayerProperties(uint32
 }
 XRLOADER_ABI_CATCH_FALLBACK
 
+static bool SameExtensionProperties(const std::vector<XrExtensionProperties> &a, const std::vector<XrExtensionProperties> &b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](const XrExtensionProperties &x, const XrExtensionProperties &y) {
+               return x.extensionVersion == y.extensionVersion && 0 == strcmp(x.extensionName, y.extensionName);
+           });
+}
+
+// The instance extensions of the layers that are enabled without being asked for, the runtime and the loader, merged
+// and sorted by name.  The count and fill calls of the two-call idiom, and any repeat of them, see the same layers and
+// runtime, so the merge is kept and only redone when what discovery found changes.  Called with the global loader
+// mutex held, after loading the runtime.
+static const std::vector<XrExtensionProperties> &MergedInstanceExtensionProperties(
+    const std::vector<XrExtensionProperties> &layer_properties) {
+    struct Merged {
+        uint64_t runtime_generation{0};
+        std::vector<XrExtensionProperties> layer_properties;
+        std::vector<XrExtensionProperties> properties;
+    };
+    static Merged merged;
+
+    const RuntimeInterface &runtime = RuntimeInterface::GetRuntime();
+    if (merged.runtime_generation == runtime.Generation() && SameExtensionProperties(merged.layer_properties, layer_properties)) {
+        return merged.properties;
+    }
+
+    std::vector<XrExtensionProperties> properties = layer_properties;
+    runtime.GetInstanceExtensionProperties(properties);
+
+    // Add the loader-specific extension properties as well.  These are extensions that the loader directly supports.
+    for (const XrExtensionProperties &loader_prop : LoaderInstance::LoaderSpecificExtensions()) {
+        bool found_prop = false;
+        for (XrExtensionProperties &existing_prop : properties) {
+            if (0 == strcmp(existing_prop.extensionName, loader_prop.extensionName)) {
+                found_prop = true;
+                // Use the loader version if it is newer
+                if (existing_prop.extensionVersion < loader_prop.extensionVersion) {
+                    existing_prop.extensionVersion = loader_prop.extensionVersion;
+                }
+                break;
+            }
+        }
+        // Only add extensions not supported by the loader
+        if (!found_prop) {
+            properties.push_back(loader_prop);
+        }
+    }
+    std::stable_sort(properties.begin(), properties.end(), [](const XrExtensionProperties &a, const XrExtensionProperties &b) {
+        return strcmp(a.extensionName, b.extensionName) < 0;
+    });
+
+    merged.runtime_generation = runtime.Generation();
+    merged.layer_properties = layer_properties;
+    merged.properties = std::move(properties);
+    return merged.properties;
+}
+
 static XRAPI_ATTR XrResult XRAPI_CALL
 LoaderXrEnumerateInstanceExtensionProperties(const char *layerName, uint32_t propertyCapacityInput, uint32_t *propertyCountOutput,
                                              XrExtensionProperties *properties) XRLOADER_ABI_TRY {
+    XR_TRACE_SCOPE("xrEnumerateInstanceExtensionProperties");
     bool just_layer_properties = false;
     LoaderLogger::LogVerboseMessage("xrEnumerateInstanceExtensionProperties", "Entering loader trampoline");
 
@@ -123,8 +306,11 @@ LoaderXrEnumerateInstanceExtensionProperties(const char *layerName, uint32_t pro
     XrResult result;
 
     {
+        ScopedPrediscoveryJoin prediscovery_join(true);
         // Make sure the runtime isn't unloaded while this call is in progress.
         std::unique_lock<std::mutex> loader_lock(GetGlobalLoaderMutex());
+        FileSysUtilsScopedCache fs_cache;
+        LoaderProperty::ScopedSnapshot property_snapshot;
 
         // Get the layer extension properties
         result = ApiLayerInterface::GetInstanceExtensionProperties("xrEnumerateInstanceExtensionProperties", layerName,
@@ -133,7 +319,7 @@ LoaderXrEnumerateInstanceExtensionProperties(const char *layerName, uint32_t pro
             // If not specific to a layer, get the runtime extension properties
             result = RuntimeInterface::LoadRuntime("xrEnumerateInstanceExtensionProperties");
             if (XR_SUCCEEDED(result)) {
-                RuntimeInterface::GetRuntime().GetInstanceExtensionProperties(extension_properties);
+                extension_properties = MergedInstanceExtensionProperties(extension_properties);
             } else {
                 LoaderLogger::LogErrorMessage("xrEnumerateInstanceExtensionProperties",
                                               "Failed to find default runtime with RuntimeInterface::LoadRuntime()");
@@ -146,28 +332,6 @@ LoaderXrEnumerateInstanceExtensionProperties(const char *layerName, uint32_t pro
         return result;
     }
 
-    // If this is not in reference to a specific layer, then add the loader-specific extension properties as well.
-    // These are extensions that the loader directly supports.
-    if (!just_layer_properties) {
-        for (const XrExtensionProperties &loader_prop : LoaderInstance::LoaderSpecificExtensions()) {
-            bool found_prop = false;
-            for (XrExtensionProperties &existing_prop : extension_properties) {
-                if (0 == strcmp(existing_prop.extensionName, loader_prop.extensionName)) {
-                    found_prop = true;
-                    // Use the loader version if it is newer
-                    if (existing_prop.extensionVersion < loader_prop.extensionVersion) {
-                        existing_prop.extensionVersion = loader_prop.extensionVersion;
-                    }
-                    break;
-                }
-            }
-            // Only add extensions not supported by the loader
-            if (!found_prop) {
-                extension_properties.push_back(loader_prop);
-            }
-        }
-    }
-
     auto num_extension_properties = static_cast<uint32_t>(extension_properties.size());
     if (propertyCapacityInput == 0) {
         *propertyCountOutput = num_extension_properties;
@@ -214,6 +378,7 @@ XRLOADER_ABI_CATCH_FALLBACK
 
 static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrCreateInstance(const XrInstanceCreateInfo *info,
                                                              XrInstance *instance) XRLOADER_ABI_TRY {
+    XR_TRACE_SCOPE("xrCreateInstance");
     LoaderLogger::LogVerboseMessage("xrCreateInstance", "Entering loader trampoline");
     if (nullptr == info) {
         LoaderLogger::LogValidationErrorMessage("VUID-xrCreateInstance-info-parameter", "xrCreateInstance", "must be non-NULL");
@@ -238,8 +403,12 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrCreateInstance(const XrInstanceCre
         return XR_ERROR_VALIDATION_FAILURE;
     }
 
+    ScopedPrediscoveryJoin prediscovery_join(true);
     // Make sure the ActiveLoaderInstance::IsAvailable check is done atomically with RuntimeInterface::LoadRuntime.
     std::unique_lock<std::mutex> instance_lock(GetGlobalLoaderMutex());
+    // Runtime and both kinds of layer discovery share one cache of the search directories and environment.
+    FileSysUtilsScopedCache fs_cache;
+    LoaderProperty::ScopedSnapshot property_snapshot;
 
     // Check if there is already an XrInstance that is alive. If so, another instance cannot be created.
     // The loader does not support multiple simultaneous instances because the loader is intended to be
@@ -263,6 +432,7 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrCreateInstance(const XrInstanceCre
         } else {
             // Load the appropriate layers
             result = ApiLayerInterface::LoadApiLayers("xrCreateInstance", info->enabledApiLayerCount, info->enabledApiLayerNames,
+                                                      info->enabledExtensionCount, info->enabledExtensionNames,
                                                       api_layer_interfaces);
             if (XR_FAILED(result)) {
                 LoaderLogger::LogErrorMessage("xrCreateInstance", "Failed loading layer information");
@@ -312,6 +482,7 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrCreateInstance(const XrInstanceCre
     } else {
         *instance = loader_instance->GetInstanceHandle();
         LoaderLogger::LogVerboseMessage("xrCreateInstance", "Completed loader trampoline");
+        loader_instance->LogFootprint("xrCreateInstance");
     }
 
     return result;
@@ -319,6 +490,7 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrCreateInstance(const XrInstanceCre
 XRLOADER_ABI_CATCH_FALLBACK
 
 static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrDestroyInstance(XrInstance instance) XRLOADER_ABI_TRY {
+    XR_TRACE_SCOPE("xrDestroyInstance");
     LoaderLogger::LogVerboseMessage("xrDestroyInstance", "Entering loader trampoline");
     // Runtimes may detect XR_NULL_HANDLE provided as a required handle parameter and return XR_ERROR_HANDLE_INVALID. - 2.9
     if (XR_NULL_HANDLE == instance) {
@@ -330,7 +502,7 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrDestroyInstance(XrInstance instanc
     std::unique_lock<std::mutex> loader_lock(GetGlobalLoaderMutex());
 
     LoaderInstance *loader_instance;
-    XrResult result = ActiveLoaderInstance::Get(&loader_instance, "xrDestroyInstance");
+    XrResult result = ActiveLoaderInstance::Get(instance, &loader_instance, "xrDestroyInstance");
     if (XR_FAILED(result)) {
         return result;
     }
@@ -343,8 +515,11 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrDestroyInstance(XrInstance instanc
         LoaderTrampolineDestroyDebugUtilsMessengerEXT(messenger);
     }
 
+    // Function pointers resolved for this instance are no longer valid once it is destroyed.
+    loader_instance->ClearResolvedFunctions();
+
     // Now destroy the instance
-    if (XR_FAILED(dispatch_table->DestroyInstance(instance))) {
+    if (XR_FAILED(XR_GENERATED_DISPATCH_CORE(dispatch_table.get(), DestroyInstance)(instance))) {
         LoaderLogger::LogErrorMessage("xrDestroyInstance", "Unknown error occurred calling down chain");
     }
 
@@ -452,24 +627,44 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermGetInstanceProcAddr(XrInstance
 
     // NOTE: ActiveLoaderInstance cannot be used in this function because it is called before an instance is made active.
 
-    if (0 == strcmp(name, "xrGetInstanceProcAddr")) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermGetInstanceProcAddr);
-    } else if (0 == strcmp(name, "xrCreateInstance")) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermCreateInstance);
-    } else if (0 == strcmp(name, "xrDestroyInstance")) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermDestroyInstance);
-    } else if (0 == strcmp(name, "xrSetDebugUtilsObjectNameEXT")) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermSetDebugUtilsObjectNameEXT);
-    } else if (0 == strcmp(name, "xrCreateDebugUtilsMessengerEXT")) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermCreateDebugUtilsMessengerEXT);
-    } else if (0 == strcmp(name, "xrDestroyDebugUtilsMessengerEXT")) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermDestroyDebugUtilsMessengerEXT);
-    } else if (0 == strcmp(name, "xrSubmitDebugUtilsMessageEXT")) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermSubmitDebugUtilsMessageEXT);
-    } else if (0 == strcmp(name, "xrCreateApiLayerInstance")) {
-        // Special layer version of xrCreateInstance terminator.  If we get called this by a layer,
-        // we simply re-direct the information back into the standard xrCreateInstance terminator.
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermCreateApiLayerInstance);
+    switch (LoaderLookupGipaFunction(name)) {
+        case LoaderGipaFunction::GetInstanceProcAddr:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermGetInstanceProcAddr);
+            break;
+        case LoaderGipaFunction::CreateInstance:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermCreateInstance);
+            break;
+        case LoaderGipaFunction::DestroyInstance:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermDestroyInstance);
+            break;
+        case LoaderGipaFunction::SetDebugUtilsObjectNameEXT:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermSetDebugUtilsObjectNameEXT);
+            break;
+        case LoaderGipaFunction::CreateDebugUtilsMessengerEXT:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermCreateDebugUtilsMessengerEXT);
+            break;
+        case LoaderGipaFunction::DestroyDebugUtilsMessengerEXT:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermDestroyDebugUtilsMessengerEXT);
+            break;
+        case LoaderGipaFunction::SubmitDebugUtilsMessageEXT:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermSubmitDebugUtilsMessageEXT);
+            break;
+        case LoaderGipaFunction::SessionBeginDebugUtilsLabelRegionEXT:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermSessionBeginDebugUtilsLabelRegionEXT);
+            break;
+        case LoaderGipaFunction::SessionEndDebugUtilsLabelRegionEXT:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermSessionEndDebugUtilsLabelRegionEXT);
+            break;
+        case LoaderGipaFunction::SessionInsertDebugUtilsLabelEXT:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermSessionInsertDebugUtilsLabelEXT);
+            break;
+        case LoaderGipaFunction::CreateApiLayerInstance:
+            // Special layer version of xrCreateInstance terminator.  If we get called this by a layer,
+            // we simply re-direct the information back into the standard xrCreateInstance terminator.
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrTermCreateApiLayerInstance);
+            break;
+        default:
+            break;
     }
 
     if (nullptr != *function) {
@@ -485,6 +680,7 @@ XRLOADER_ABI_CATCH_FALLBACK
 static XRAPI_ATTR XrResult XRAPI_CALL
 LoaderTrampolineCreateDebugUtilsMessengerEXT(XrInstance instance, const XrDebugUtilsMessengerCreateInfoEXT *createInfo,
                                              XrDebugUtilsMessengerEXT *messenger) XRLOADER_ABI_TRY {
+    XR_TRACE_SCOPE("xrCreateDebugUtilsMessengerEXT");
     LoaderLogger::LogVerboseMessage("xrCreateDebugUtilsMessengerEXT", "Entering loader trampoline");
 
     if (instance == XR_NULL_HANDLE) {
@@ -493,12 +689,14 @@ LoaderTrampolineCreateDebugUtilsMessengerEXT(XrInstance instance, const XrDebugU
     }
 
     LoaderInstance *loader_instance;
-    XrResult result = ActiveLoaderInstance::Get(&loader_instance, "xrCreateDebugUtilsMessengerEXT");
+    XrResult result = ActiveLoaderInstance::Get(instance, &loader_instance, "xrCreateDebugUtilsMessengerEXT");
     if (XR_FAILED(result)) {
         return result;
     }
 
-    result = loader_instance->DispatchTable()->CreateDebugUtilsMessengerEXT(instance, createInfo, messenger);
+    PFN_xrCreateDebugUtilsMessengerEXT create =
+        XR_GENERATED_DISPATCH_CORE(loader_instance->DispatchTable().get(), CreateDebugUtilsMessengerEXT);
+    result = create(instance, createInfo, messenger);
     LoaderLogger::LogVerboseMessage("xrCreateDebugUtilsMessengerEXT", "Completed loader trampoline");
     return result;
 }
@@ -506,6 +704,7 @@ XRLOADER_ABI_CATCH_BAD_ALLOC_OOM XRLOADER_ABI_CATCH_FALLBACK
 
     static XRAPI_ATTR XrResult XRAPI_CALL
     LoaderTrampolineDestroyDebugUtilsMessengerEXT(XrDebugUtilsMessengerEXT messenger) XRLOADER_ABI_TRY {
+    XR_TRACE_SCOPE("xrDestroyDebugUtilsMessengerEXT");
     // TODO: get instance from messenger in loader
     // Also, is the loader really doing all this every call?
     LoaderLogger::LogVerboseMessage("xrDestroyDebugUtilsMessengerEXT", "Entering loader trampoline");
@@ -521,24 +720,58 @@ XRLOADER_ABI_CATCH_BAD_ALLOC_OOM XRLOADER_ABI_CATCH_FALLBACK
         return result;
     }
 
-    result = loader_instance->DispatchTable()->DestroyDebugUtilsMessengerEXT(messenger);
+    result = XR_GENERATED_DISPATCH_CORE(loader_instance->DispatchTable().get(), DestroyDebugUtilsMessengerEXT)(messenger);
     LoaderLogger::LogVerboseMessage("xrDestroyDebugUtilsMessengerEXT", "Completed loader trampoline");
     return result;
 }
 XRLOADER_ABI_CATCH_FALLBACK
 
-static XRAPI_ATTR XrResult XRAPI_CALL
-LoaderTrampolineSessionBeginDebugUtilsLabelRegionEXT(XrSession session, const XrDebugUtilsLabelEXT *labelInfo) XRLOADER_ABI_TRY {
+// The label commands are called every frame, so their trampolines are noexcept: everything that may allocate or throw,
+// logging an error or recording a label, is in one of these helpers, which report a failure as an XrResult instead.
+static XrResult LoaderTrampolineNullSession(const char *command_name) noexcept XRLOADER_ABI_TRY {
+    LoaderLogger::LogErrorMessage(command_name, "Session handle is XR_NULL_HANDLE.");
+    return XR_ERROR_HANDLE_INVALID;
+}
+XRLOADER_ABI_CATCH_FALLBACK
+
+static XrResult LoaderTrampolineNullLabelInfo(const char *vuid, const char *command_name, XrSession session) noexcept
+    XRLOADER_ABI_TRY {
+    LoaderLogger::LogValidationErrorMessage(vuid, command_name, "labelInfo must be non-NULL",
+                                            {XrSdkLogObjectInfo{session, XR_OBJECT_TYPE_SESSION}});
+    return XR_ERROR_VALIDATION_FAILURE;
+}
+XRLOADER_ABI_CATCH_FALLBACK
+
+static XrResult LoaderRecordBeginLabelRegion(XrSession session, const XrDebugUtilsLabelEXT *labelInfo) noexcept XRLOADER_ABI_TRY {
+    LoaderLogger::GetInstance().BeginLabelRegion(session, labelInfo);
+    return XR_SUCCESS;
+}
+XRLOADER_ABI_CATCH_BAD_ALLOC_OOM
+XRLOADER_ABI_CATCH_FALLBACK
+
+static XrResult LoaderRecordEndLabelRegion(XrSession session) noexcept XRLOADER_ABI_TRY {
+    LoaderLogger::GetInstance().EndLabelRegion(session);
+    return XR_SUCCESS;
+}
+XRLOADER_ABI_CATCH_FALLBACK
+
+static XrResult LoaderRecordInsertLabel(XrSession session, const XrDebugUtilsLabelEXT *labelInfo) noexcept XRLOADER_ABI_TRY {
+    LoaderLogger::GetInstance().InsertLabel(session, labelInfo);
+    return XR_SUCCESS;
+}
+XRLOADER_ABI_CATCH_BAD_ALLOC_OOM
+XRLOADER_ABI_CATCH_FALLBACK
+
+static XRAPI_ATTR XrResult XRAPI_CALL LoaderTrampolineSessionBeginDebugUtilsLabelRegionEXT(XrSession session,
+                                                                                         const XrDebugUtilsLabelEXT *labelInfo) noexcept {
+    XR_TRACE_SCOPE("xrSessionBeginDebugUtilsLabelRegionEXT");
     if (session == XR_NULL_HANDLE) {
-        LoaderLogger::LogErrorMessage("xrSessionBeginDebugUtilsLabelRegionEXT", "Session handle is XR_NULL_HANDLE.");
-        return XR_ERROR_HANDLE_INVALID;
+        return LoaderTrampolineNullSession("xrSessionBeginDebugUtilsLabelRegionEXT");
     }
 
     if (nullptr == labelInfo) {
-        LoaderLogger::LogValidationErrorMessage("VUID-xrSessionBeginDebugUtilsLabelRegionEXT-labelInfo-parameter",
-                                                "xrSessionBeginDebugUtilsLabelRegionEXT", "labelInfo must be non-NULL",
-                                                {XrSdkLogObjectInfo{session, XR_OBJECT_TYPE_SESSION}});
-        return XR_ERROR_VALIDATION_FAILURE;
+        return LoaderTrampolineNullLabelInfo("VUID-xrSessionBeginDebugUtilsLabelRegionEXT-labelInfo-parameter",
+                                             "xrSessionBeginDebugUtilsLabelRegionEXT", session);
     }
 
     LoaderInstance *loader_instance;
@@ -546,19 +779,25 @@ LoaderTrampolineSessionBeginDebugUtilsLabelRegionEXT(XrSession session, const Xr
     if (XR_FAILED(result)) {
         return result;
     }
-    LoaderLogger::GetInstance().BeginLabelRegion(session, labelInfo);
-    const std::unique_ptr<XrGeneratedDispatchTableCore> &dispatch_table = loader_instance->DispatchTable();
-    if (nullptr != dispatch_table->SessionBeginDebugUtilsLabelRegionEXT) {
-        return dispatch_table->SessionBeginDebugUtilsLabelRegionEXT(session, labelInfo);
+    if (LoaderLogger::GetInstance().SessionLabelsUsed()) {
+        result = LoaderRecordBeginLabelRegion(session, labelInfo);
+        if (XR_FAILED(result)) {
+            return result;
+        }
+    }
+    const XrGeneratedDispatchTableCore *dispatch_table = loader_instance->DispatchTable().get();
+    PFN_xrSessionBeginDebugUtilsLabelRegionEXT next =
+        XR_GENERATED_DISPATCH_CORE(dispatch_table, SessionBeginDebugUtilsLabelRegionEXT);
+    if (nullptr != next) {
+        return next(session, labelInfo);
     }
     return XR_SUCCESS;
 }
-XRLOADER_ABI_CATCH_FALLBACK
 
-static XRAPI_ATTR XrResult XRAPI_CALL LoaderTrampolineSessionEndDebugUtilsLabelRegionEXT(XrSession session) XRLOADER_ABI_TRY {
+static XRAPI_ATTR XrResult XRAPI_CALL LoaderTrampolineSessionEndDebugUtilsLabelRegionEXT(XrSession session) noexcept {
+    XR_TRACE_SCOPE("xrSessionEndDebugUtilsLabelRegionEXT");
     if (session == XR_NULL_HANDLE) {
-        LoaderLogger::LogErrorMessage("xrSessionEndDebugUtilsLabelRegionEXT", "Session handle is XR_NULL_HANDLE.");
-        return XR_ERROR_HANDLE_INVALID;
+        return LoaderTrampolineNullSession("xrSessionEndDebugUtilsLabelRegionEXT");
     }
 
     LoaderInstance *loader_instance;
@@ -567,20 +806,25 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderTrampolineSessionEndDebugUtilsLabelR
         return result;
     }
 
-    LoaderLogger::GetInstance().EndLabelRegion(session);
-    const std::unique_ptr<XrGeneratedDispatchTableCore> &dispatch_table = loader_instance->DispatchTable();
-    if (nullptr != dispatch_table->SessionEndDebugUtilsLabelRegionEXT) {
-        return dispatch_table->SessionEndDebugUtilsLabelRegionEXT(session);
+    if (LoaderLogger::GetInstance().SessionLabelsUsed()) {
+        result = LoaderRecordEndLabelRegion(session);
+        if (XR_FAILED(result)) {
+            return result;
+        }
+    }
+    const XrGeneratedDispatchTableCore *dispatch_table = loader_instance->DispatchTable().get();
+    PFN_xrSessionEndDebugUtilsLabelRegionEXT next = XR_GENERATED_DISPATCH_CORE(dispatch_table, SessionEndDebugUtilsLabelRegionEXT);
+    if (nullptr != next) {
+        return next(session);
     }
     return XR_SUCCESS;
 }
-XRLOADER_ABI_CATCH_FALLBACK
 
-static XRAPI_ATTR XrResult XRAPI_CALL
-LoaderTrampolineSessionInsertDebugUtilsLabelEXT(XrSession session, const XrDebugUtilsLabelEXT *labelInfo) XRLOADER_ABI_TRY {
+static XRAPI_ATTR XrResult XRAPI_CALL LoaderTrampolineSessionInsertDebugUtilsLabelEXT(XrSession session,
+                                                                                    const XrDebugUtilsLabelEXT *labelInfo) noexcept {
+    XR_TRACE_SCOPE("xrSessionInsertDebugUtilsLabelEXT");
     if (session == XR_NULL_HANDLE) {
-        LoaderLogger::LogErrorMessage("xrSessionInsertDebugUtilsLabelEXT", "Session handle is XR_NULL_HANDLE.");
-        return XR_ERROR_HANDLE_INVALID;
+        return LoaderTrampolineNullSession("xrSessionInsertDebugUtilsLabelEXT");
     }
 
     LoaderInstance *loader_instance;
@@ -590,30 +834,34 @@ LoaderTrampolineSessionInsertDebugUtilsLabelEXT(XrSession session, const XrDebug
     }
 
     if (nullptr == labelInfo) {
-        LoaderLogger::LogValidationErrorMessage("VUID-xrSessionInsertDebugUtilsLabelEXT-labelInfo-parameter",
-                                                "xrSessionInsertDebugUtilsLabelEXT", "labelInfo must be non-NULL",
-                                                {XrSdkLogObjectInfo{session, XR_OBJECT_TYPE_SESSION}});
-        return XR_ERROR_VALIDATION_FAILURE;
+        return LoaderTrampolineNullLabelInfo("VUID-xrSessionInsertDebugUtilsLabelEXT-labelInfo-parameter",
+                                             "xrSessionInsertDebugUtilsLabelEXT", session);
     }
 
-    LoaderLogger::GetInstance().InsertLabel(session, labelInfo);
+    if (LoaderLogger::GetInstance().SessionLabelsUsed()) {
+        result = LoaderRecordInsertLabel(session, labelInfo);
+        if (XR_FAILED(result)) {
+            return result;
+        }
+    }
 
-    const std::unique_ptr<XrGeneratedDispatchTableCore> &dispatch_table = loader_instance->DispatchTable();
-    if (nullptr != dispatch_table->SessionInsertDebugUtilsLabelEXT) {
-        return dispatch_table->SessionInsertDebugUtilsLabelEXT(session, labelInfo);
+    const XrGeneratedDispatchTableCore *dispatch_table = loader_instance->DispatchTable().get();
+    PFN_xrSessionInsertDebugUtilsLabelEXT next = XR_GENERATED_DISPATCH_CORE(dispatch_table, SessionInsertDebugUtilsLabelEXT);
+    if (nullptr != next) {
+        return next(session, labelInfo);
     }
 
     return XR_SUCCESS;
 }
-XRLOADER_ABI_CATCH_FALLBACK
 
 // No-op trampoline needed for xrGetInstanceProcAddr. Work done in terminator.
 static XRAPI_ATTR XrResult XRAPI_CALL
 LoaderTrampolineSetDebugUtilsObjectNameEXT(XrInstance instance, const XrDebugUtilsObjectNameInfoEXT *nameInfo) XRLOADER_ABI_TRY {
+    XR_TRACE_SCOPE("xrSetDebugUtilsObjectNameEXT");
     LoaderInstance *loader_instance;
     XrResult result = ActiveLoaderInstance::Get(&loader_instance, "xrSetDebugUtilsObjectNameEXT");
     if (XR_SUCCEEDED(result)) {
-        result = loader_instance->DispatchTable()->SetDebugUtilsObjectNameEXT(instance, nameInfo);
+        result = XR_GENERATED_DISPATCH_CORE(loader_instance->DispatchTable().get(), SetDebugUtilsObjectNameEXT)(instance, nameInfo);
     }
     return result;
 }
@@ -623,11 +871,13 @@ XRLOADER_ABI_CATCH_FALLBACK
 static XRAPI_ATTR XrResult XRAPI_CALL LoaderTrampolineSubmitDebugUtilsMessageEXT(
     XrInstance instance, XrDebugUtilsMessageSeverityFlagsEXT messageSeverity, XrDebugUtilsMessageTypeFlagsEXT messageTypes,
     const XrDebugUtilsMessengerCallbackDataEXT *callbackData) XRLOADER_ABI_TRY {
+    XR_TRACE_SCOPE("xrSubmitDebugUtilsMessageEXT");
     LoaderInstance *loader_instance;
     XrResult result = ActiveLoaderInstance::Get(&loader_instance, "xrSubmitDebugUtilsMessageEXT");
     if (XR_SUCCEEDED(result)) {
-        result =
-            loader_instance->DispatchTable()->SubmitDebugUtilsMessageEXT(instance, messageSeverity, messageTypes, callbackData);
+        PFN_xrSubmitDebugUtilsMessageEXT submit =
+            XR_GENERATED_DISPATCH_CORE(loader_instance->DispatchTable().get(), SubmitDebugUtilsMessageEXT);
+        result = submit(instance, messageSeverity, messageTypes, callbackData);
     }
     return result;
 }
@@ -647,8 +897,9 @@ XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermCreateDebugUtilsMessengerEXT(XrInstan
     const XrGeneratedDispatchTableCore *dispatch_table = RuntimeInterface::GetDispatchTable(instance);
     XrResult result = XR_SUCCESS;
     // This extension is supported entirely by the loader which means the runtime may or may not support it.
-    if (nullptr != dispatch_table->CreateDebugUtilsMessengerEXT) {
-        result = dispatch_table->CreateDebugUtilsMessengerEXT(instance, createInfo, messenger);
+    PFN_xrCreateDebugUtilsMessengerEXT runtime_function = XR_GENERATED_DISPATCH_CORE(dispatch_table, CreateDebugUtilsMessengerEXT);
+    if (nullptr != runtime_function) {
+        result = runtime_function(instance, createInfo, messenger);
     } else {
         // Just allocate a character so we have a unique value
         char *temp_mess_ptr = new char;
@@ -670,8 +921,10 @@ XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermDestroyDebugUtilsMessengerEXT(XrDebug
     LoaderLogger::GetInstance().RemoveLogRecorder(MakeHandleGeneric(messenger));
     RuntimeInterface::GetRuntime().ForgetDebugMessenger(messenger);
     // This extension is supported entirely by the loader which means the runtime may or may not support it.
-    if (nullptr != dispatch_table->DestroyDebugUtilsMessengerEXT) {
-        result = dispatch_table->DestroyDebugUtilsMessengerEXT(messenger);
+    PFN_xrDestroyDebugUtilsMessengerEXT runtime_function =
+        XR_GENERATED_DISPATCH_CORE(dispatch_table, DestroyDebugUtilsMessengerEXT);
+    if (nullptr != runtime_function) {
+        result = runtime_function(messenger);
     } else {
         // Delete the character we would've created
         delete (reinterpret_cast<char *>(MakeHandleGeneric(messenger)));
@@ -687,8 +940,9 @@ XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermSubmitDebugUtilsMessageEXT(
     LoaderLogger::LogVerboseMessage("xrSubmitDebugUtilsMessageEXT", "Entering loader terminator");
     const XrGeneratedDispatchTableCore *dispatch_table = RuntimeInterface::GetDispatchTable(instance);
     XrResult result = XR_SUCCESS;
-    if (nullptr != dispatch_table->SubmitDebugUtilsMessageEXT) {
-        result = dispatch_table->SubmitDebugUtilsMessageEXT(instance, messageSeverity, messageTypes, callbackData);
+    PFN_xrSubmitDebugUtilsMessageEXT runtime_function = XR_GENERATED_DISPATCH_CORE(dispatch_table, SubmitDebugUtilsMessageEXT);
+    if (nullptr != runtime_function) {
+        result = runtime_function(instance, messageSeverity, messageTypes, callbackData);
     } else {
         // Only log the message from the loader if the runtime doesn't support this extension.  If we did,
         // then the user would receive multiple instances of the same message.
@@ -704,8 +958,9 @@ LoaderXrTermSetDebugUtilsObjectNameEXT(XrInstance instance, const XrDebugUtilsOb
     LoaderLogger::LogVerboseMessage("xrSetDebugUtilsObjectNameEXT", "Entering loader terminator");
     const XrGeneratedDispatchTableCore *dispatch_table = RuntimeInterface::GetDispatchTable(instance);
     XrResult result = XR_SUCCESS;
-    if (nullptr != dispatch_table->SetDebugUtilsObjectNameEXT) {
-        result = dispatch_table->SetDebugUtilsObjectNameEXT(instance, nameInfo);
+    PFN_xrSetDebugUtilsObjectNameEXT runtime_function = XR_GENERATED_DISPATCH_CORE(dispatch_table, SetDebugUtilsObjectNameEXT);
+    if (nullptr != runtime_function) {
+        result = runtime_function(instance, nameInfo);
     }
     LoaderLogger::GetInstance().AddObjectName(nameInfo->objectHandle, nameInfo->objectType, nameInfo->objectName);
     LoaderLogger::LogVerboseMessage("xrSetDebugUtilsObjectNameEXT", "Completed loader terminator");
@@ -713,8 +968,54 @@ LoaderXrTermSetDebugUtilsObjectNameEXT(XrInstance instance, const XrDebugUtilsOb
 }
 XRLOADER_ABI_CATCH_FALLBACK
 
+// The label terminators: the loader trampolines have already recorded the label, and layers call these whether or not the
+// runtime has the command, so do nothing when it does not.
+static const XrGeneratedDispatchTableCore *LoaderTermSessionDispatchTable(const char *command_name) {
+    LoaderInstance *loader_instance;
+    if (XR_FAILED(ActiveLoaderInstance::Get(&loader_instance, command_name))) {
+        return nullptr;
+    }
+    return RuntimeInterface::GetDispatchTable(loader_instance->GetInstanceHandle());
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermSessionBeginDebugUtilsLabelRegionEXT(XrSession session,
+                                                                                const XrDebugUtilsLabelEXT *labelInfo) XRLOADER_ABI_TRY {
+    const XrGeneratedDispatchTableCore *dispatch_table = LoaderTermSessionDispatchTable("xrSessionBeginDebugUtilsLabelRegionEXT");
+    PFN_xrSessionBeginDebugUtilsLabelRegionEXT runtime_function =
+        nullptr == dispatch_table ? nullptr : XR_GENERATED_DISPATCH_CORE(dispatch_table, SessionBeginDebugUtilsLabelRegionEXT);
+    if (nullptr != runtime_function) {
+        return runtime_function(session, labelInfo);
+    }
+    return XR_SUCCESS;
+}
+XRLOADER_ABI_CATCH_FALLBACK
+
+XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermSessionEndDebugUtilsLabelRegionEXT(XrSession session) XRLOADER_ABI_TRY {
+    const XrGeneratedDispatchTableCore *dispatch_table = LoaderTermSessionDispatchTable("xrSessionEndDebugUtilsLabelRegionEXT");
+    PFN_xrSessionEndDebugUtilsLabelRegionEXT runtime_function =
+        nullptr == dispatch_table ? nullptr : XR_GENERATED_DISPATCH_CORE(dispatch_table, SessionEndDebugUtilsLabelRegionEXT);
+    if (nullptr != runtime_function) {
+        return runtime_function(session);
+    }
+    return XR_SUCCESS;
+}
+XRLOADER_ABI_CATCH_FALLBACK
+
+XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermSessionInsertDebugUtilsLabelEXT(XrSession session,
+                                                                           const XrDebugUtilsLabelEXT *labelInfo) XRLOADER_ABI_TRY {
+    const XrGeneratedDispatchTableCore *dispatch_table = LoaderTermSessionDispatchTable("xrSessionInsertDebugUtilsLabelEXT");
+    PFN_xrSessionInsertDebugUtilsLabelEXT runtime_function =
+        nullptr == dispatch_table ? nullptr : XR_GENERATED_DISPATCH_CORE(dispatch_table, SessionInsertDebugUtilsLabelEXT);
+    if (nullptr != runtime_function) {
+        return runtime_function(session, labelInfo);
+    }
+    return XR_SUCCESS;
+}
+XRLOADER_ABI_CATCH_FALLBACK
+
 XRAPI_ATTR XrResult XRAPI_CALL LoaderXrGetInstanceProcAddr(XrInstance instance, const char *name,
                                                            PFN_xrVoidFunction *function) XRLOADER_ABI_TRY {
+    XR_TRACE_SCOPE("xrGetInstanceProcAddr");
     if (nullptr == function) {
         LoaderLogger::LogValidationErrorMessage("VUID-xrGetInstanceProcAddr-function-parameter", "xrGetInstanceProcAddr",
                                                 "Invalid Function pointer");
@@ -730,11 +1031,16 @@ XRAPI_ATTR XrResult XRAPI_CALL LoaderXrGetInstanceProcAddr(XrInstance instance,
     // Initialize the function to nullptr in case it does not get caught in a known case
     *function = nullptr;
 
+    // Look the name up once in the generated table of loader-handled commands.
+    const LoaderGipaFunction loader_function = LoaderLookupGipaFunction(name);
+
     LoaderInstance *loader_instance = nullptr;
     if (instance == XR_NULL_HANDLE) {
         // Null instance is allowed for a few specific API entry points, otherwise return error
-        if (strcmp(name, "xrCreateInstance") != 0 && strcmp(name, "xrEnumerateApiLayerProperties") != 0 &&
-            strcmp(name, "xrEnumerateInstanceExtensionProperties") != 0 && strcmp(name, "xrInitializeLoaderKHR") != 0) {
+        if (loader_function != LoaderGipaFunction::CreateInstance &&
+            loader_function != LoaderGipaFunction::EnumerateApiLayerProperties &&
+            loader_function != LoaderGipaFunction::EnumerateInstanceExtensionProperties &&
+            loader_function != LoaderGipaFunction::InitializeLoaderKHR) {
             // TODO why is xrGetInstanceProcAddr not listed in here?
             std::string error_str = "XR_NULL_HANDLE for instance but query for ";
             error_str += name;
@@ -745,63 +1051,74 @@ XRAPI_ATTR XrResult XRAPI_CALL LoaderXrGetInstanceProcAddr(XrInstance instance,
         }
     } else {
         // non null instance passed in, it should be our current instance
-        XrResult result = ActiveLoaderInstance::Get(&loader_instance, "xrGetInstanceProcAddr");
+        XrResult result = ActiveLoaderInstance::Get(instance, &loader_instance, "xrGetInstanceProcAddr");
         if (XR_FAILED(result)) {
             return result;
         }
-        if (loader_instance->GetInstanceHandle() != instance) {
-            return XR_ERROR_HANDLE_INVALID;
-        }
-    }
-
-    // These functions must always go through the loader's implementation (trampoline).
-    if (strcmp(name, "xrGetInstanceProcAddr") == 0) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrGetInstanceProcAddr);
-        return XR_SUCCESS;
-    } else if (strcmp(name, "xrInitializeLoaderKHR") == 0) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrInitializeLoaderKHR);
-        return XR_SUCCESS;
-    } else if (strcmp(name, "xrEnumerateApiLayerProperties") == 0) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrEnumerateApiLayerProperties);
-        return XR_SUCCESS;
-    } else if (strcmp(name, "xrEnumerateInstanceExtensionProperties") == 0) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrEnumerateInstanceExtensionProperties);
-        return XR_SUCCESS;
-    } else if (strcmp(name, "xrCreateInstance") == 0) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrCreateInstance);
-        return XR_SUCCESS;
-    } else if (strcmp(name, "xrDestroyInstance") == 0) {
-        *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrDestroyInstance);
-        return XR_SUCCESS;
     }
 
-    // XR_EXT_debug_utils is built into the loader and handled partly through the xrGetInstanceProcAddress terminator,
-    // but the check to see if the extension is enabled must be done here where ActiveLoaderInstance is safe to use.
-    if (*function == nullptr) {
-        if (strcmp(name, "xrCreateDebugUtilsMessengerEXT") == 0) {
+    bool is_debug_utils_function = false;
+    switch (loader_function) {
+        // These functions must always go through the loader's implementation (trampoline).
+        case LoaderGipaFunction::GetInstanceProcAddr:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrGetInstanceProcAddr);
+            return XR_SUCCESS;
+        case LoaderGipaFunction::InitializeLoaderKHR:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrInitializeLoaderKHR);
+            return XR_SUCCESS;
+        case LoaderGipaFunction::EnumerateApiLayerProperties:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrEnumerateApiLayerProperties);
+            return XR_SUCCESS;
+        case LoaderGipaFunction::EnumerateInstanceExtensionProperties:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrEnumerateInstanceExtensionProperties);
+            return XR_SUCCESS;
+        case LoaderGipaFunction::CreateInstance:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrCreateInstance);
+            return XR_SUCCESS;
+        case LoaderGipaFunction::DestroyInstance:
+            *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderXrDestroyInstance);
+            return XR_SUCCESS;
+
+        // XR_EXT_debug_utils is built into the loader and handled partly through the xrGetInstanceProcAddress terminator,
+        // but the check to see if the extension is enabled must be done here where ActiveLoaderInstance is safe to use.
+        case LoaderGipaFunction::CreateDebugUtilsMessengerEXT:
             *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderTrampolineCreateDebugUtilsMessengerEXT);
-        } else if (strcmp(name, "xrDestroyDebugUtilsMessengerEXT") == 0) {
+            is_debug_utils_function = true;
+            break;
+        case LoaderGipaFunction::DestroyDebugUtilsMessengerEXT:
             *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderTrampolineDestroyDebugUtilsMessengerEXT);
-        } else if (strcmp(name, "xrSessionBeginDebugUtilsLabelRegionEXT") == 0) {
+            is_debug_utils_function = true;
+            break;
+        case LoaderGipaFunction::SessionBeginDebugUtilsLabelRegionEXT:
             *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderTrampolineSessionBeginDebugUtilsLabelRegionEXT);
-        } else if (strcmp(name, "xrSessionEndDebugUtilsLabelRegionEXT") == 0) {
+            is_debug_utils_function = true;
+            break;
+        case LoaderGipaFunction::SessionEndDebugUtilsLabelRegionEXT:
             *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderTrampolineSessionEndDebugUtilsLabelRegionEXT);
-        } else if (strcmp(name, "xrSessionInsertDebugUtilsLabelEXT") == 0) {
+            is_debug_utils_function = true;
+            break;
+        case LoaderGipaFunction::SessionInsertDebugUtilsLabelEXT:
             *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderTrampolineSessionInsertDebugUtilsLabelEXT);
-        } else if (strcmp(name, "xrSetDebugUtilsObjectNameEXT") == 0) {
+            is_debug_utils_function = true;
+            break;
+        case LoaderGipaFunction::SetDebugUtilsObjectNameEXT:
             *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderTrampolineSetDebugUtilsObjectNameEXT);
-        } else if (strcmp(name, "xrSubmitDebugUtilsMessageEXT") == 0) {
+            is_debug_utils_function = true;
+            break;
+        case LoaderGipaFunction::SubmitDebugUtilsMessageEXT:
             *function = reinterpret_cast<PFN_xrVoidFunction>(LoaderTrampolineSubmitDebugUtilsMessageEXT);
-        }
+            is_debug_utils_function = true;
+            break;
+        default:
+            break;
+    }
 
-        if (*function != nullptr && !loader_instance->ExtensionIsEnabled("XR_EXT_debug_utils")) {
+    if (is_debug_utils_function) {
+        if (!loader_instance->ExtensionIsEnabled(LoaderExtension::EXT_debug_utils)) {
             // The function matches one of the XR_EXT_debug_utils functions but the extension is not enabled.
             *function = nullptr;
             return XR_ERROR_FUNCTION_UNSUPPORTED;
         }
-    }
-
-    if (*function != nullptr) {
         // The loader has a trampoline or implementation of this function.
         return XR_SUCCESS;
     }
@@ -13,6 +13,10 @@
 #include "loader_init_data.hpp"
 #include "loader_properties.hpp"
 
+#include <string>
+#include <unordered_map>
+#include <utility>
+
 XrResult LoaderInitData::initialize(const XrLoaderInitInfoBaseHeaderKHR* info) {
     // We iterate the chain per struct type, so we only pick the first of each type in the chain.
 
@@ -52,10 +56,12 @@ XrResult LoaderInitData::initializeProperties(const XrLoaderInitInfoBaseHeaderKH
             }
 
             // Inject provided properties into the loader property store.
-            LoaderProperty::ClearOverrides();
+            // Published all at once, so property reads never see only some of them.
+            std::unordered_map<std::string, std::string> overrides;
             for (uint32_t i = 0; i < propertyInfo->propertyValueCount; i++) {
-                LoaderProperty::SetOverride(propertyInfo->propertyValues[i].name, propertyInfo->propertyValues[i].value);
+                overrides.emplace(propertyInfo->propertyValues[i].name, propertyInfo->propertyValues[i].value);
             }
+            LoaderProperty::SetOverrides(std::move(overrides));
             // Take only the first such struct.
             return XR_SUCCESS;
         }
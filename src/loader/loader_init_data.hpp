@@ -13,7 +13,6 @@
 #include <openxr/openxr_platform.h>
 
 #if defined(XR_USE_PLATFORM_ANDROID)
-#include <json/value.h>
 #include <android/asset_manager_jni.h>
 #include "android_utilities.h"
 
@@ -120,7 +119,7 @@ class LoaderInitData {
 XrResult InitializeLoaderInitData(const XrLoaderInitInfoBaseHeaderKHR* loaderInitInfo);
 
 #if defined(XR_USE_PLATFORM_ANDROID) && defined(XR_HAS_REQUIRED_PLATFORM_LOADER_INIT_STRUCT)
-XrResult GetPlatformRuntimeVirtualManifest(Json::Value& out_manifest);
+XrResult GetPlatformActiveRuntime(openxr_android::ActiveRuntime& out_runtime);
 std::string GetAndroidNativeLibraryDir();
 void* GetAndroidAssetManager();
 #endif  // defined(XR_USE_PLATFORM_ANDROID) && defined(XR_HAS_REQUIRED_PLATFORM_LOADER_INIT_STRUCT)
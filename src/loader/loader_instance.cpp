@@ -14,8 +14,10 @@
 #include "loader_instance.hpp"
 
 #include "api_layer_interface.hpp"
+#include "exception_handling.hpp"
 #include "hex_and_handles.h"
 #include "loader_logger.hpp"
+#include "manifest_file.hpp"
 #include "runtime_interface.hpp"
 #include "xr_generated_dispatch_table_core.h"
 #include "xr_generated_loader.hpp"
@@ -23,7 +25,10 @@
 #include <openxr/openxr.h>
 #include <openxr/openxr_loader_negotiation.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <iterator>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -31,10 +36,18 @@
 #include <vector>
 
 namespace {
+// The owning pointer is only modified by xrCreateInstance and xrDestroyInstance, which hold the global loader
+// mutex.  The raw pointer is published separately so that xrGetInstanceProcAddr and the trampolines can look up
+// the active instance without taking that mutex.
 std::unique_ptr<LoaderInstance>& GetSetCurrentLoaderInstance() {
     static std::unique_ptr<LoaderInstance> current_loader_instance;
     return current_loader_instance;
 }
+
+std::atomic<LoaderInstance*>& GetPublishedLoaderInstance() noexcept {
+    static std::atomic<LoaderInstance*> published_loader_instance{nullptr};
+    return published_loader_instance;
+}
 }  // namespace
 
 namespace ActiveLoaderInstance {
@@ -45,22 +58,44 @@ XrResult Set(std::unique_ptr<LoaderInstance> loader_instance, const char* log_fu
     }
 
     GetSetCurrentLoaderInstance() = std::move(loader_instance);
+    GetPublishedLoaderInstance().store(GetSetCurrentLoaderInstance().get(), std::memory_order_release);
+    PublishedDispatchTable().store(GetSetCurrentLoaderInstance()->DispatchTable().get(), std::memory_order_release);
     return XR_SUCCESS;
 }
 
-XrResult Get(LoaderInstance** loader_instance, const char* log_function_name) {
-    *loader_instance = GetSetCurrentLoaderInstance().get();
+XrResult Get(LoaderInstance** loader_instance, const char* log_function_name) noexcept {
+    *loader_instance = GetPublishedLoaderInstance().load(std::memory_order_acquire);
     if (*loader_instance == nullptr) {
-        LoaderLogger::LogErrorMessage(log_function_name, "No active XrInstance handle.");
-        return XR_ERROR_HANDLE_INVALID;
+        return NoActiveInstance(log_function_name);
     }
 
     return XR_SUCCESS;
 }
 
-bool IsAvailable() { return GetSetCurrentLoaderInstance() != nullptr; }
+XrResult NoActiveInstance(const char* log_function_name) noexcept XRLOADER_ABI_TRY {
+    LoaderLogger::LogErrorMessage(log_function_name, "No active XrInstance handle.");
+    return XR_ERROR_HANDLE_INVALID;
+}
+XRLOADER_ABI_CATCH_FALLBACK
+
+XrResult Get(XrInstance instance, LoaderInstance** loader_instance, const char* log_function_name) {
+    XrResult result = Get(loader_instance, log_function_name);
+    if (XR_SUCCEEDED(result) && (*loader_instance)->GetInstanceHandle() != instance) {
+        LoaderLogger::LogErrorMessage(log_function_name, "XrInstance handle is not the active instance.");
+        *loader_instance = nullptr;
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    return result;
+}
+
+bool IsAvailable() { return GetPublishedLoaderInstance().load(std::memory_order_acquire) != nullptr; }
 
-void Remove() { GetSetCurrentLoaderInstance().reset(nullptr); }
+void Remove() {
+    // Unpublish before destroying so no new lookups can find the instance.
+    GetPublishedLoaderInstance().store(nullptr, std::memory_order_release);
+    PublishedDispatchTable().store(nullptr, std::memory_order_release);
+    GetSetCurrentLoaderInstance().reset(nullptr);
+}
 }  // namespace ActiveLoaderInstance
 
 // Extensions that are supported by the loader, but may not be supported
@@ -72,63 +107,42 @@ const std::array<XrExtensionProperties, 1>& LoaderInstance::LoaderSpecificExtens
 }
 
 namespace {
+bool CStringLess(const char* a, const char* b) { return strcmp(a, b) < 0; }
+
+// The application's XrInstanceCreateInfo as passed down the layer chain, without the extensions to skip.  The
+// filtered name array is built in one pass, and only if one of the enabled extensions is skipped; otherwise the
+// application's own create info is passed down as it is.  The names are the application's strings, not copies.
 class InstanceCreateInfoManager {
    public:
-    explicit InstanceCreateInfoManager(const XrInstanceCreateInfo* info) : original_create_info(info), modified_create_info(*info) {
-        Reset();
-    }
-
-    // Reset the "modified" state to match the original state.
-    void Reset() {
-        enabled_extensions_cstr.clear();
-        enabled_extensions_cstr.reserve(original_create_info->enabledExtensionCount);
-
-        for (uint32_t i = 0; i < original_create_info->enabledExtensionCount; ++i) {
-            enabled_extensions_cstr.push_back(original_create_info->enabledExtensionNames[i]);
+    InstanceCreateInfoManager(const XrInstanceCreateInfo* info, const std::vector<const char*>& extensions_to_skip)
+        : create_info(info) {
+        auto is_skipped = [&](const char* extension) {
+            return std::any_of(extensions_to_skip.begin(), extensions_to_skip.end(),
+                               [&](const char* skip) { return strcmp(skip, extension) == 0; });
+        };
+        const char* const* begin = info->enabledExtensionNames;
+        const char* const* end = begin + info->enabledExtensionCount;
+        const char* const* first_skipped = std::find_if(begin, end, is_skipped);
+        if (first_skipped == end) {
+            return;
         }
-        Update();
-    }
-
-    // Remove extensions named in the parameter and return a pointer to the current state.
-    const XrInstanceCreateInfo* FilterOutExtensions(const std::vector<const char*>& extensions_to_skip) {
-        if (enabled_extensions_cstr.empty()) {
-            return Get();
-        }
-        if (extensions_to_skip.empty()) {
-            return Get();
-        }
-        for (auto& ext : extensions_to_skip) {
-            FilterOutExtension(ext);
-        }
-        return Update();
-    }
-    // Remove the extension named in the parameter and return a pointer to the current state.
-    const XrInstanceCreateInfo* FilterOutExtension(const char* extension_to_skip) {
-        if (enabled_extensions_cstr.empty()) {
-            return &modified_create_info;
-        }
-        auto b = enabled_extensions_cstr.begin();
-        auto e = enabled_extensions_cstr.end();
-        auto it = std::find_if(b, e, [&](const char* extension) { return strcmp(extension_to_skip, extension) == 0; });
-        if (it != e) {
-            // Just that one element goes away
-            enabled_extensions_cstr.erase(it);
-        }
-        return Update();
-    }
+        enabled_extensions_cstr.reserve(info->enabledExtensionCount - 1);
+        enabled_extensions_cstr.assign(begin, first_skipped);
+        std::remove_copy_if(first_skipped + 1, end, std::back_inserter(enabled_extensions_cstr), is_skipped);
 
-    // Get the current modified XrInstanceCreateInfo
-    const XrInstanceCreateInfo* Get() const { return &modified_create_info; }
-
-   private:
-    const XrInstanceCreateInfo* Update() {
+        modified_create_info = *info;
         modified_create_info.enabledExtensionCount = static_cast<uint32_t>(enabled_extensions_cstr.size());
         modified_create_info.enabledExtensionNames = enabled_extensions_cstr.empty() ? nullptr : enabled_extensions_cstr.data();
-        return &modified_create_info;
+        create_info = &modified_create_info;
     }
-    const XrInstanceCreateInfo* original_create_info;
+    InstanceCreateInfoManager(const InstanceCreateInfoManager&) = delete;
+    InstanceCreateInfoManager& operator=(const InstanceCreateInfoManager&) = delete;
 
-    XrInstanceCreateInfo modified_create_info;
+    const XrInstanceCreateInfo* Get() const { return create_info; }
+
+   private:
+    const XrInstanceCreateInfo* create_info;
+    XrInstanceCreateInfo modified_create_info{};
     std::vector<const char*> enabled_extensions_cstr;
 };
 }  // namespace
@@ -141,33 +155,27 @@ XrResult LoaderInstance::CreateInstance(PFN_xrGetInstanceProcAddr get_instance_p
                                         const XrInstanceCreateInfo* info, std::unique_ptr<LoaderInstance>* loader_instance) {
     LoaderLogger::LogVerboseMessage("xrCreateInstance", "Entering LoaderInstance::CreateInstance");
 
-    // Check the list of enabled extensions to make sure something supports them, and, if we do,
-    // add it to the list of enabled extensions
+    // Check the list of enabled extensions to make sure something supports them: the runtime, the loader or one of
+    // the enabled layers.  Their extension names are sorted once, so each enabled extension is a binary search.
     XrResult last_error = XR_SUCCESS;
-    for (uint32_t ext = 0; ext < info->enabledExtensionCount; ++ext) {
-        bool found = false;
-        // First check the runtime
-        if (RuntimeInterface::GetRuntime().SupportsExtension(info->enabledExtensionNames[ext])) {
-            found = true;
+    std::vector<const char*> supported_names;
+    if (info->enabledExtensionCount > 0) {
+        for (const XrExtensionProperties& runtime_extension : RuntimeInterface::GetRuntime().ExtensionProperties()) {
+            supported_names.push_back(runtime_extension.extensionName);
         }
-        // Next check the loader
-        if (!found) {
-            for (auto& loader_extension : LoaderInstance::LoaderSpecificExtensions()) {
-                if (strcmp(loader_extension.extensionName, info->enabledExtensionNames[ext]) == 0) {
-                    found = true;
-                    break;
-                }
-            }
+        for (const XrExtensionProperties& loader_extension : LoaderInstance::LoaderSpecificExtensions()) {
+            supported_names.push_back(loader_extension.extensionName);
         }
-        // Finally, check the enabled layers
-        if (!found) {
-            for (auto& layer_interface : api_layer_interfaces) {
-                if (layer_interface->SupportsExtension(info->enabledExtensionNames[ext])) {
-                    found = true;
-                    break;
-                }
+        for (const auto& layer_interface : api_layer_interfaces) {
+            for (const std::string& layer_extension : layer_interface->SupportedExtensions()) {
+                supported_names.push_back(layer_extension.c_str());
             }
         }
+        std::sort(supported_names.begin(), supported_names.end(), CStringLess);
+    }
+    for (uint32_t ext = 0; ext < info->enabledExtensionCount; ++ext) {
+        const bool found =
+            std::binary_search(supported_names.begin(), supported_names.end(), info->enabledExtensionNames[ext], CStringLess);
         if (!found) {
             std::string msg = "LoaderInstance::CreateInstance, no support found for requested extension: ";
             msg += info->enabledExtensionNames[ext];
@@ -184,17 +192,16 @@ XrResult LoaderInstance::CreateInstance(PFN_xrGetInstanceProcAddr get_instance_p
     if (XR_SUCCEEDED(last_error)) {
         // Remove the loader-supported-extensions (debug utils), if it's in the list of enabled extensions but not supported by
         // the runtime.
-        InstanceCreateInfoManager create_info_manager{info};
-        const XrInstanceCreateInfo* modified_create_info = info;
+        std::vector<const char*> extensions_to_skip;
         if (info->enabledExtensionCount > 0) {
-            std::vector<const char*> extensions_to_skip;
             for (const auto& ext : LoaderInstance::LoaderSpecificExtensions()) {
                 if (!RuntimeInterface::GetRuntime().SupportsExtension(ext.extensionName)) {
                     extensions_to_skip.emplace_back(ext.extensionName);
                 }
             }
-            modified_create_info = create_info_manager.FilterOutExtensions(extensions_to_skip);
         }
+        InstanceCreateInfoManager create_info_manager{info, extensions_to_skip};
+        const XrInstanceCreateInfo* modified_create_info = create_info_manager.Get();
 
         // Only start the xrCreateApiLayerInstance stack if we have layers.
         if (!api_layer_interfaces.empty()) {
@@ -243,10 +250,12 @@ XrResult LoaderInstance::CreateInstance(PFN_xrGetInstanceProcAddr get_instance_p
             api_layer_ci.nextInfo = next_info_list.get();
             //! @todo do we filter our create info extension list here?
             //! Think that actually each layer might need to filter...
+            LoaderPhaseTimer timer("xrCreateInstance", "layer_chain_create_instance");
             last_error = topmost_cali_fp(modified_create_info, &api_layer_ci, &instance);
 
         } else {
             // The loader's terminator is the topmost CreateInstance if there are no layers.
+            LoaderPhaseTimer timer("xrCreateInstance", "layer_chain_create_instance");
             last_error = create_instance_term(modified_create_info, &instance);
         }
 
@@ -270,7 +279,63 @@ XrResult LoaderInstance::CreateInstance(PFN_xrGetInstanceProcAddr get_instance_p
 }
 
 XrResult LoaderInstance::GetInstanceProcAddr(const char* name, PFN_xrVoidFunction* function) {
-    return _topmost_gipa(_runtime_instance, name, function);
+    const std::string name_str(name);
+    {
+        std::unique_lock<std::mutex> lock(_resolved_functions_mutex);
+        auto it = _resolved_functions.find(name_str);
+        if (it != _resolved_functions.end()) {
+            *function = it->second;
+            return XR_SUCCESS;
+        }
+    }
+
+    XrResult result = _topmost_gipa(_runtime_instance, name, function);
+
+    // Only successful lookups are remembered, failures are always passed down the chain again.
+    if (XR_SUCCEEDED(result) && nullptr != *function) {
+        std::unique_lock<std::mutex> lock(_resolved_functions_mutex);
+        _resolved_functions.emplace(name_str, *function);
+    }
+    return result;
+}
+
+void LoaderInstance::ClearResolvedFunctions() {
+    std::unique_lock<std::mutex> lock(_resolved_functions_mutex);
+    _resolved_functions.clear();
+}
+
+void LoaderInstance::LogFootprint(const char* command_name) {
+    if (!LoaderLogger::GetInstance().TimingEnabled()) {
+        return;
+    }
+    // Each unordered container node holds its value and a next pointer, and each bucket one pointer.
+    size_t dispatch_bytes = sizeof(XrGeneratedDispatchTableCore);
+    {
+        std::unique_lock<std::mutex> lock(_resolved_functions_mutex);
+        dispatch_bytes += _resolved_functions.bucket_count() * sizeof(void*);
+        for (const auto& resolved : _resolved_functions) {
+            dispatch_bytes += sizeof(resolved) + sizeof(void*) + resolved.first.capacity();
+        }
+    }
+    LoaderLogFootprint(command_name, "loader_dispatch_table", dispatch_bytes);
+
+    size_t layer_bytes = _api_layer_interfaces.capacity() * sizeof(std::unique_ptr<ApiLayerInterface>);
+    for (const auto& layer_interface : _api_layer_interfaces) {
+        layer_bytes += sizeof(ApiLayerInterface) + layer_interface->LayerName().size();
+        for (const auto& extension : layer_interface->SupportedExtensions()) {
+            layer_bytes += sizeof(extension) + extension.capacity();
+        }
+    }
+    LoaderLogFootprint(command_name, "api_layer_interfaces", layer_bytes);
+
+    size_t extension_bytes = _enabled_known_extensions.capacity() / 8 + _enabled_unknown_extensions.bucket_count() * sizeof(void*);
+    for (const auto& extension : _enabled_unknown_extensions) {
+        extension_bytes += sizeof(extension) + sizeof(void*) + extension.capacity();
+    }
+    LoaderLogFootprint(command_name, "enabled_extensions", extension_bytes);
+
+    LoaderLogFootprint(command_name, "runtime_interface", RuntimeInterface::GetRuntime().Footprint());
+    LoaderLogFootprint(command_name, "manifest_cache", ManifestFile::CacheFootprint());
 }
 
 LoaderInstance::LoaderInstance(XrInstance instance, const XrInstanceCreateInfo* create_info, PFN_xrGetInstanceProcAddr topmost_gipa,
@@ -279,11 +344,18 @@ LoaderInstance::LoaderInstance(XrInstance instance, const XrInstanceCreateInfo*
       _topmost_gipa(topmost_gipa),
       _api_layer_interfaces(std::move(api_layer_interfaces)),
       _dispatch_table(new XrGeneratedDispatchTableCore{}) {
+    _enabled_known_extensions.resize(static_cast<size_t>(LoaderExtension::Count));
     for (uint32_t ext = 0; ext < create_info->enabledExtensionCount; ++ext) {
-        _enabled_extensions.push_back(create_info->enabledExtensionNames[ext]);
+        const char* name = create_info->enabledExtensionNames[ext];
+        const LoaderExtension known = LoaderLookupExtension(name);
+        if (known != LoaderExtension::Unknown) {
+            _enabled_known_extensions[static_cast<uint32_t>(known)] = true;
+        } else {
+            _enabled_unknown_extensions.insert(name);
+        }
     }
 
-    GeneratedXrPopulateDispatchTableCore(_dispatch_table.get(), instance, topmost_gipa);
+    GeneratedXrPopulateDispatchTableCoreLazy(_dispatch_table.get(), instance, topmost_gipa);
 }
 
 LoaderInstance::~LoaderInstance() {
@@ -293,11 +365,10 @@ LoaderInstance::~LoaderInstance() {
     LoaderLogger::LogInfoMessage("xrDestroyInstance", oss.str());
 }
 
-bool LoaderInstance::ExtensionIsEnabled(const std::string& extension) {
-    for (std::string& cur_enabled : _enabled_extensions) {
-        if (cur_enabled == extension) {
-            return true;
-        }
+bool LoaderInstance::ExtensionIsEnabled(const std::string& extension) const {
+    const LoaderExtension known = LoaderLookupExtension(extension.c_str());
+    if (known != LoaderExtension::Unknown) {
+        return ExtensionIsEnabled(known);
     }
-    return false;
+    return _enabled_unknown_extensions.count(extension) != 0;
 }
@@ -15,16 +15,19 @@
 #include <openxr/openxr_loader_negotiation.h>
 
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class ApiLayerInterface;
 struct XrGeneratedDispatchTableCore;
 class LoaderInstance;
+enum class LoaderExtension : uint32_t;  // Generated in xr_generated_loader.hpp
 
 // Manage the single loader instance that is available.
 namespace ActiveLoaderInstance {
@@ -34,8 +37,26 @@ XrResult Set(std::unique_ptr<LoaderInstance> loader_instance, const char* log_fu
 // Returns true if there is an active loader instance.
 bool IsAvailable();
 
-// Get the active LoaderInstance.
-XrResult Get(LoaderInstance** loader_instance, const char* log_function_name);
+// Get the active LoaderInstance.  Safe to call without holding the global loader mutex.
+XrResult Get(LoaderInstance** loader_instance, const char* log_function_name) noexcept;
+
+// Get the active LoaderInstance, failing with XR_ERROR_HANDLE_INVALID if its handle is not instance.
+XrResult Get(XrInstance instance, LoaderInstance** loader_instance, const char* log_function_name);
+
+// The dispatch table of the active LoaderInstance, published with it for the generated trampolines.
+inline std::atomic<const XrGeneratedDispatchTableCore*>& PublishedDispatchTable() noexcept {
+    static std::atomic<const XrGeneratedDispatchTableCore*> published_dispatch_table{nullptr};
+    return published_dispatch_table;
+}
+
+// Get the dispatch table of the active LoaderInstance, or nullptr if there is none.  Safe to call without holding the
+// global loader mutex; the table is valid until the instance is destroyed.
+inline const XrGeneratedDispatchTableCore* GetDispatchTable() noexcept {
+    return PublishedDispatchTable().load(std::memory_order_acquire);
+}
+
+// Log that there is no active instance, for log_function_name, and return XR_ERROR_HANDLE_INVALID.
+XrResult NoActiveInstance(const char* log_function_name) noexcept;
 
 // Destroy the currently active LoaderInstance if there is one. This will make the loader able to create a new XrInstance if needed.
 void Remove();
@@ -56,10 +77,17 @@ class LoaderInstance {
     XrInstance GetInstanceHandle() { return _runtime_instance; }
     const std::unique_ptr<XrGeneratedDispatchTableCore>& DispatchTable() { return _dispatch_table; }
     std::vector<std::unique_ptr<ApiLayerInterface>>& LayerInterfaces() { return _api_layer_interfaces; }
-    bool ExtensionIsEnabled(const std::string& extension);
+    bool ExtensionIsEnabled(LoaderExtension extension) const {
+        return _enabled_known_extensions[static_cast<uint32_t>(extension)];
+    }
+    bool ExtensionIsEnabled(const std::string& extension) const;
     XrDebugUtilsMessengerEXT DefaultDebugUtilsMessenger() { return _messenger; }
     void SetDefaultDebugUtilsMessenger(XrDebugUtilsMessengerEXT messenger) { _messenger = messenger; }
     XrResult GetInstanceProcAddr(const char* name, PFN_xrVoidFunction* function);
+    // Forget every function pointer resolved through GetInstanceProcAddr, called when the instance is destroyed.
+    void ClearResolvedFunctions();
+    // Report the estimated bytes held by each loader subsystem for this instance, when timing is enabled.
+    void LogFootprint(const char* command_name);
 
    private:
     LoaderInstance(XrInstance instance, const XrInstanceCreateInfo* createInfo, PFN_xrGetInstanceProcAddr topmost_gipa,
@@ -68,10 +96,17 @@ class LoaderInstance {
    private:
     XrInstance _runtime_instance{XR_NULL_HANDLE};
     PFN_xrGetInstanceProcAddr _topmost_gipa{nullptr};
-    std::vector<std::string> _enabled_extensions;
+    // The enabled extensions the loader was generated with, indexed by LoaderExtension, and the names of the others.
+    std::vector<bool> _enabled_known_extensions;
+    std::unordered_set<std::string> _enabled_unknown_extensions;
     std::vector<std::unique_ptr<ApiLayerInterface>> _api_layer_interfaces;
 
     std::unique_ptr<XrGeneratedDispatchTableCore> _dispatch_table;
     // Internal debug messenger created during xrCreateInstance
     XrDebugUtilsMessengerEXT _messenger{XR_NULL_HANDLE};
+
+    // Functions already resolved down the layer chain, so repeated queries for the same name
+    // do not have to walk every layer's xrGetInstanceProcAddr again.
+    std::mutex _resolved_functions_mutex;
+    std::unordered_map<std::string, PFN_xrVoidFunction> _resolved_functions;
 };
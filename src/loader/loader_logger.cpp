@@ -125,6 +125,7 @@ LoaderLogger::LoaderLogger() {
     // appropriate logging out to std::cout.
     if (!debug_string.empty()) {
         XrLoaderLogMessageSeverityFlags debug_flags = {};
+        XrLoaderLogMessageTypeFlags debug_types = XR_LOADER_LOG_MESSAGE_TYPE_DEFAULT_BITS;
         if (debug_string == "error") {
             debug_flags = XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT;
         } else if (debug_string == "warn") {
@@ -135,20 +136,60 @@ LoaderLogger::LoaderLogger() {
         } else if (debug_string == "all" || debug_string == "verbose") {
             debug_flags = XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT |
                           XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT;
+        } else if (debug_string == "timing") {
+            // Only the phase timings, not the rest of the info messages.
+            debug_flags = XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT;
+            debug_types = XR_LOADER_LOG_MESSAGE_TYPE_PERFORMANCE_BIT;
+            _timing_enabled = true;
         }
-        AddLogRecorder(MakeStdOutLoaderLogRecorder(nullptr, debug_flags));
+        std::unique_ptr<LoaderLogRecorder> stdout_recorder = MakeStdOutLoaderLogRecorder(nullptr, debug_flags, debug_types);
+        // Optionally move the writes off the logging threads so verbose output does not disturb frame timing.
+        if (LoaderProperty::IsSet("XR_LOADER_LOG_ASYNC")) {
+            stdout_recorder = MakeAsyncLoaderLogRecorder(std::move(stdout_recorder));
+        }
+        AddLogRecorder(std::move(stdout_recorder));
+    }
+
+    // Phase timings can also be appended to a file, one JSON object per line.
+    std::string timing_file = LoaderProperty::GetSecure("XR_LOADER_TIMING_FILE");
+    if (!timing_file.empty()) {
+        AddLogRecorder(MakeFileLoaderLogRecorder(timing_file, XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT,
+                                                 XR_LOADER_LOG_MESSAGE_TYPE_PERFORMANCE_BIT));
+        _timing_enabled = true;
+    }
+
+    // Every message can also be written to a binary trace file for tools that would rather not parse text.
+    std::string trace_file = LoaderProperty::GetSecure("XR_LOADER_TRACE_FILE");
+    if (!trace_file.empty()) {
+        AddLogRecorder(MakeBinaryTraceLoaderLogRecorder(trace_file));
     }
 }
 
+void LoaderLogger::UpdateEnabledMasks() {
+    XrLoaderLogMessageSeverityFlags severity_mask = 0;
+    XrLoaderLogMessageTypeFlags type_mask = 0;
+    bool session_labels_used = false;
+    for (const std::unique_ptr<LoaderLogRecorder>& recorder : _recorders) {
+        severity_mask |= recorder->MessageSeverities();
+        type_mask |= recorder->MessageTypes();
+        session_labels_used |= recorder->UsesSessionLabels();
+    }
+    _severity_mask.store(severity_mask, std::memory_order_relaxed);
+    _type_mask.store(type_mask, std::memory_order_relaxed);
+    _session_labels_used.store(session_labels_used, std::memory_order_relaxed);
+}
+
 void LoaderLogger::AddLogRecorder(std::unique_ptr<LoaderLogRecorder>&& recorder) {
     std::unique_lock<std::shared_timed_mutex> lock(_mutex);
     _recorders.push_back(std::move(recorder));
+    UpdateEnabledMasks();
 }
 
 void LoaderLogger::AddLogRecorderForXrInstance(XrInstance instance, std::unique_ptr<LoaderLogRecorder>&& recorder) {
     std::unique_lock<std::shared_timed_mutex> lock(_mutex);
     _recordersByInstance[instance].insert(recorder->UniqueId());
     _recorders.emplace_back(std::move(recorder));
+    UpdateEnabledMasks();
 }
 
 void LoaderLogger::RemoveLogRecorder(uint64_t unique_id) {
@@ -161,6 +202,7 @@ void LoaderLogger::RemoveLogRecorder(uint64_t unique_id) {
             messengersForInstance.erase(unique_id);
         }
     }
+    UpdateEnabledMasks();
 }
 
 void LoaderLogger::RemoveLogRecordersForXrInstance(XrInstance instance) {
@@ -171,23 +213,37 @@ void LoaderLogger::RemoveLogRecordersForXrInstance(XrInstance instance) {
             return recorders.find(recorder->UniqueId()) != recorders.end();
         });
         _recordersByInstance.erase(instance);
+        UpdateEnabledMasks();
     }
 }
 
 bool LoaderLogger::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
                               const std::string& message_id, const std::string& command_name, const std::string& message,
                               const std::vector<XrSdkLogObjectInfo>& objects) {
+    // Skip resolving object names and labels, and the lock, when nobody is listening.
+    if (!IsEnabled(message_severity, message_type)) {
+        return false;
+    }
+
     XrLoaderLogMessengerCallbackData callback_data = {};
     callback_data.message_id = message_id.c_str();
     callback_data.command_name = command_name.c_str();
     callback_data.message = message.c_str();
 
-    auto names_and_labels = data_.PopulateNamesAndLabels(objects);
-    callback_data.objects = names_and_labels.sdk_objects.empty() ? nullptr : names_and_labels.sdk_objects.data();
-    callback_data.object_count = static_cast<uint8_t>(names_and_labels.objects.size());
-
-    callback_data.session_labels = names_and_labels.labels.empty() ? nullptr : names_and_labels.labels.data();
-    callback_data.session_labels_count = static_cast<uint8_t>(names_and_labels.labels.size());
+    // Without any names or labels registered the objects can be passed through untouched.
+    std::unique_lock<std::mutex> data_lock(_data_mutex);
+    NamesAndLabels names_and_labels;
+    if (data_.Empty()) {
+        callback_data.objects = objects.empty() ? nullptr : const_cast<XrSdkLogObjectInfo*>(objects.data());
+        callback_data.object_count = static_cast<uint8_t>(objects.size());
+    } else {
+        names_and_labels = data_.PopulateNamesAndLabels(objects);
+        callback_data.objects = names_and_labels.sdk_objects.empty() ? nullptr : names_and_labels.sdk_objects.data();
+        callback_data.object_count = static_cast<uint8_t>(names_and_labels.sdk_objects.size());
+
+        callback_data.session_labels = const_cast<XrDebugUtilsLabelEXT*>(names_and_labels.LabelData());
+        callback_data.session_labels_count = static_cast<uint8_t>(names_and_labels.LabelCount());
+    }
 
     std::shared_lock<std::shared_timed_mutex> lock(_mutex);
     bool exit_app = false;
@@ -207,7 +263,11 @@ bool LoaderLogger::LogDebugUtilsMessage(XrDebugUtilsMessageSeverityFlagsEXT mess
     bool exit_app = false;
     XrLoaderLogMessageSeverityFlags log_message_severity = DebugUtilsSeveritiesToLoaderLogMessageSeverities(message_severity);
     XrLoaderLogMessageTypeFlags log_message_type = DebugUtilsMessageTypesToLoaderLogMessageTypes(message_type);
+    if (!IsEnabled(log_message_severity, log_message_type)) {
+        return false;
+    }
 
+    std::unique_lock<std::mutex> data_lock(_data_mutex);
     AugmentedCallbackData augmented_data;
     data_.WrapCallbackData(&augmented_data, callback_data);
 
@@ -227,17 +287,71 @@ bool LoaderLogger::LogDebugUtilsMessage(XrDebugUtilsMessageSeverityFlagsEXT mess
 }
 
 void LoaderLogger::AddObjectName(uint64_t object_handle, XrObjectType object_type, const std::string& object_name) {
+    std::unique_lock<std::mutex> data_lock(_data_mutex);
     data_.AddObjectName(object_handle, object_type, object_name);
 }
 
 void LoaderLogger::BeginLabelRegion(XrSession session, const XrDebugUtilsLabelEXT* label_info) {
+    std::unique_lock<std::mutex> data_lock(_data_mutex);
     data_.BeginLabelRegion(session, *label_info);
 }
 
-void LoaderLogger::EndLabelRegion(XrSession session) { data_.EndLabelRegion(session); }
+void LoaderLogger::EndLabelRegion(XrSession session) {
+    std::unique_lock<std::mutex> data_lock(_data_mutex);
+    data_.EndLabelRegion(session);
+}
 
 void LoaderLogger::InsertLabel(XrSession session, const XrDebugUtilsLabelEXT* label_info) {
+    std::unique_lock<std::mutex> data_lock(_data_mutex);
     data_.InsertLabel(session, *label_info);
 }
 
-void LoaderLogger::DeleteSessionLabels(XrSession session) { data_.DeleteSessionLabels(session); }
+void LoaderLogger::DeleteSessionLabels(XrSession session) {
+    std::unique_lock<std::mutex> data_lock(_data_mutex);
+    data_.DeleteSessionLabels(session);
+}
+
+LoaderPhaseTimer::LoaderPhaseTimer(const char* command_name, const char* phase, const std::string& detail)
+    : _enabled(LoaderLogger::GetInstance().TimingEnabled()),
+      _command_name(command_name),
+      _phase(phase)
+#if defined(XR_USE_PLATFORM_TRACE)
+      ,
+      _trace(phase)
+#endif  // defined(XR_USE_PLATFORM_TRACE)
+{
+    if (_enabled) {
+        _detail = detail;
+        _start = std::chrono::steady_clock::now();
+    }
+}
+
+LoaderPhaseTimer::~LoaderPhaseTimer() {
+    if (!_enabled) {
+        return;
+    }
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start);
+
+    std::ostringstream oss;
+    oss << "{\"command\":\"" << _command_name << "\",\"phase\":\"" << _phase << "\",\"detail\":\"";
+    for (char c : _detail) {
+        if (c == '"' || c == '\\') {
+            oss << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            oss << ' ';
+        } else {
+            oss << c;
+        }
+    }
+    oss << "\",\"duration_us\":" << duration.count() << "}";
+    LoaderLogger::LogPerformanceMessage(_command_name, oss.str());
+}
+
+void LoaderLogFootprint(const char* command_name, const char* subsystem, size_t bytes) {
+    if (!LoaderLogger::GetInstance().TimingEnabled()) {
+        return;
+    }
+    std::ostringstream oss;
+    oss << "{\"command\":\"" << command_name << "\",\"subsystem\":\"" << subsystem << "\",\"bytes\":" << bytes << "}";
+    LoaderLogger::LogPerformanceMessage(command_name, oss.str());
+}
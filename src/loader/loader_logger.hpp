@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -23,6 +25,7 @@
 
 #include "hex_and_handles.h"
 #include "object_info.h"
+#include "platform_trace.hpp"
 
 // Use internal versions of flags similar to XR_EXT_debug_utils so that
 // we're not tightly coupled to that extension.  This way, if the extension
@@ -59,6 +62,8 @@ enum XrLoaderLogType {
     XR_LOADER_LOG_DEBUG_UTILS,
     XR_LOADER_LOG_DEBUGGER,
     XR_LOADER_LOG_LOGCAT,
+    XR_LOADER_LOG_FILE,
+    XR_LOADER_LOG_TRACE,
 };
 
 class LoaderLogRecorder {
@@ -71,6 +76,7 @@ class LoaderLogRecorder {
         _unique_id = 0;
         _message_severities = message_severities;
         _message_types = message_types;
+        _uses_session_labels = true;
     }
     virtual ~LoaderLogRecorder() = default;
 
@@ -82,6 +88,9 @@ class LoaderLogRecorder {
 
     XrLoaderLogMessageTypeFlags MessageTypes() { return _message_types; }
 
+    //! False if the recorder never shows the session labels of a message, so they need not be tracked for it.
+    bool UsesSessionLabels() { return _uses_session_labels; }
+
     virtual void Start() { _active = true; }
 
     bool IsPaused() { return _active; }
@@ -107,6 +116,7 @@ class LoaderLogRecorder {
     void* _user_data;
     XrLoaderLogMessageSeverityFlags _message_severities;
     XrLoaderLogMessageTypeFlags _message_types;
+    bool _uses_session_labels;
 };
 
 class LoaderLogger {
@@ -142,15 +152,31 @@ class LoaderLogger {
         return GetInstance().LogMessage(XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT, XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT,
                                         "OpenXR-Loader", command_name, message, objects);
     }
-    static bool LogInfoMessage(const std::string& command_name, const std::string& message,
+    // Info and verbose messages are usually disabled, so these take the strings by template parameter: string
+    // literals are only converted to std::string once a recorder is known to want the message.
+    template <typename CommandName, typename Message>
+    static bool LogInfoMessage(const CommandName& command_name, const Message& message,
                                const std::vector<XrSdkLogObjectInfo>& objects = {}) {
-        return GetInstance().LogMessage(XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT, XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT,
-                                        "OpenXR-Loader", command_name, message, objects);
+        LoaderLogger& logger = GetInstance();
+        if (!logger.IsEnabled(XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT, XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT)) {
+            return false;
+        }
+        return logger.LogMessage(XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT, XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT, "OpenXR-Loader",
+                                 command_name, message, objects);
     }
-    static bool LogVerboseMessage(const std::string& command_name, const std::string& message,
+    template <typename CommandName, typename Message>
+    static bool LogVerboseMessage(const CommandName& command_name, const Message& message,
                                   const std::vector<XrSdkLogObjectInfo>& objects = {}) {
-        return GetInstance().LogMessage(XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT, XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT,
-                                        "OpenXR-Loader", command_name, message, objects);
+        LoaderLogger& logger = GetInstance();
+        if (!logger.IsEnabled(XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT, XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT)) {
+            return false;
+        }
+        return logger.LogMessage(XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT, XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT,
+                                 "OpenXR-Loader", command_name, message, objects);
+    }
+    static bool LogPerformanceMessage(const std::string& command_name, const std::string& message) {
+        return GetInstance().LogMessage(XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT, XR_LOADER_LOG_MESSAGE_TYPE_PERFORMANCE_BIT,
+                                        "OpenXR-Loader", command_name, message);
     }
     static bool LogValidationErrorMessage(const std::string& vuid, const std::string& command_name, const std::string& message,
                                           const std::vector<XrSdkLogObjectInfo>& objects = {}) {
@@ -167,6 +193,21 @@ class LoaderLogger {
     bool LogDebugUtilsMessage(XrDebugUtilsMessageSeverityFlagsEXT message_severity, XrDebugUtilsMessageTypeFlagsEXT message_type,
                               const XrDebugUtilsMessengerCallbackDataEXT* callback_data);
 
+    //! True if any recorder may want a message of this severity and type.  Conservative: the masks of all
+    //! recorders are combined, so this can return true when no single recorder matches both.
+    bool IsEnabled(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type) const {
+        return (message_severity == 0 || (_severity_mask.load(std::memory_order_relaxed) & message_severity) != 0) &&
+               (message_type == 0 || (_type_mask.load(std::memory_order_relaxed) & message_type) != 0);
+    }
+
+    //! True if a recorder that shows session labels is registered.  Without one, the label calls only go down the
+    //! chain: regions begun while nothing listens are never reported, and ones still open when the last listener
+    //! goes away are reported once another is added, until they are ended.
+    bool SessionLabelsUsed() const { return _session_labels_used.load(std::memory_order_relaxed); }
+
+    //! True if XR_LOADER_DEBUG=timing or XR_LOADER_TIMING_FILE requested loader phase timings.
+    bool TimingEnabled() const { return _timing_enabled; }
+
     // Non-copyable
     LoaderLogger(const LoaderLogger&) = delete;
     LoaderLogger& operator=(const LoaderLogger&) = delete;
@@ -174,6 +215,14 @@ class LoaderLogger {
    private:
     LoaderLogger();
 
+    // Must be called with _mutex held exclusively.
+    void UpdateEnabledMasks();
+
+    bool _timing_enabled{false};
+    std::atomic<XrLoaderLogMessageSeverityFlags> _severity_mask{0};
+    std::atomic<XrLoaderLogMessageTypeFlags> _type_mask{0};
+    std::atomic<bool> _session_labels_used{false};
+
     std::shared_timed_mutex _mutex;
 
     // List of *all* available recorder objects (including created specifically for an Instance)
@@ -182,9 +231,39 @@ class LoaderLogger {
     // List of recorder objects only created specifically for an XrInstance
     std::unordered_map<XrInstance, std::unordered_set<uint64_t>> _recordersByInstance;
 
+    // Guards data_.  Held while a message is handed to the recorders, as the labels it reports are borrowed from data_.
+    std::mutex _data_mutex;
     DebugUtilsData data_;
 };
 
+// Measures one phase of loader startup (manifest search, library load, negotiation, ...) and reports it as a
+// performance message when it goes out of scope.  The message text is a single-line JSON object so that the
+// XR_LOADER_TIMING_FILE output can be consumed by tools.  Does nothing unless timing is enabled, except mark the phase
+// as a platform trace scope when those are built in.
+class LoaderPhaseTimer {
+   public:
+    LoaderPhaseTimer(const char* command_name, const char* phase, const std::string& detail = {});
+    ~LoaderPhaseTimer();
+
+    // Non-copyable
+    LoaderPhaseTimer(const LoaderPhaseTimer&) = delete;
+    LoaderPhaseTimer& operator=(const LoaderPhaseTimer&) = delete;
+
+   private:
+    bool _enabled;
+    const char* _command_name;
+    const char* _phase;
+    std::string _detail;
+    std::chrono::steady_clock::time_point _start;
+#if defined(XR_USE_PLATFORM_TRACE)
+    PlatformTraceScope _trace;
+#endif  // defined(XR_USE_PLATFORM_TRACE)
+};
+
+// Reports the memory held by one loader subsystem, in bytes, as a performance message in the same single-line JSON form
+// as the phase timings.  Does nothing unless timing is enabled.
+void LoaderLogFootprint(const char* command_name, const char* subsystem, size_t bytes);
+
 // Utility functions for converting to/from XR_EXT_debug_utils values
 XrLoaderLogMessageSeverityFlags DebugUtilsSeveritiesToLoaderLogMessageSeverities(
     XrDebugUtilsMessageSeverityFlagsEXT utils_severities);
@@ -14,11 +14,18 @@
 
 #include <openxr/openxr.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <iostream>
-#include <sstream>
 
 #ifdef __ANDROID__
 #include "android/log.h"
@@ -30,49 +37,138 @@
 
 // Anonymous namespace to keep these types private
 namespace {
-void OutputMessageToStream(std::ostream& os, XrLoaderLogMessageSeverityFlagBits message_severity,
-                           XrLoaderLogMessageTypeFlags message_type, const XrLoaderLogMessengerCallbackData* callback_data) {
+// Per-thread scratch buffer the text recorders format messages into.  Text goes into a fixed inline array and
+// only spills into a heap string for messages larger than that; the spill string keeps its capacity between
+// messages, so steady-state logging does not allocate.
+class LogMessageBuffer {
+   public:
+    static LogMessageBuffer& ForThisThread() {
+        static thread_local LogMessageBuffer buffer;
+        return buffer;
+    }
+
+    void Clear() {
+        _size = 0;
+        _overflow.clear();
+    }
+
+    void Append(const char* str, size_t length) {
+        if (_overflow.empty() && _size + length < kInlineCapacity) {
+            memcpy(_inline + _size, str, length);
+            _size += length;
+            return;
+        }
+        if (_overflow.empty()) {
+            _overflow.assign(_inline, _size);
+        }
+        _overflow.append(str, length);
+    }
+
+    void Append(const char* str) { Append(str, strlen(str)); }
+    void Append(const std::string& str) { Append(str.data(), str.size()); }
+
+    void AppendUnsigned(uint32_t value) {
+        char digits[10];
+        size_t count = 0;
+        do {
+            digits[sizeof(digits) - ++count] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        Append(digits + sizeof(digits) - count, count);
+    }
+
+    // Same format as Uint64ToHexString: "0x" followed by all 16 digits.
+    void AppendHex(uint64_t value) {
+        char digits[kHexStringBufferSize];
+        Append(to_hex(value, digits), kHexStringBufferSize - 1);
+    }
+
+    //! The formatted text, null-terminated.
+    const char* CStr() {
+        if (!_overflow.empty()) {
+            return _overflow.c_str();
+        }
+        _inline[_size] = '\0';
+        return _inline;
+    }
+
+    size_t Size() const { return _overflow.empty() ? _size : _overflow.size(); }
+
+   private:
+    LogMessageBuffer() = default;
+
+    static const size_t kInlineCapacity = 2048;
+    char _inline[kInlineCapacity];
+    size_t _size = 0;
+    std::string _overflow;
+};
+
+// Formats a message the way every text recorder prints it, into this thread's LogMessageBuffer.
+LogMessageBuffer& FormatLogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
+                                const XrLoaderLogMessengerCallbackData* callback_data) {
+    LogMessageBuffer& buffer = LogMessageBuffer::ForThisThread();
+    buffer.Clear();
     if (XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT > message_severity) {
-        os << "Verbose [";
+        buffer.Append("Verbose [");
     } else if (XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT > message_severity) {
-        os << "Info [";
+        buffer.Append("Info [");
     } else if (XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT > message_severity) {
-        os << "Warning [";
+        buffer.Append("Warning [");
     } else {
-        os << "Error [";
+        buffer.Append("Error [");
     }
     switch (message_type) {
         case XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT:
-            os << "GENERAL";
+            buffer.Append("GENERAL");
             break;
         case XR_LOADER_LOG_MESSAGE_TYPE_SPECIFICATION_BIT:
-            os << "SPEC";
+            buffer.Append("SPEC");
             break;
         case XR_LOADER_LOG_MESSAGE_TYPE_PERFORMANCE_BIT:
-            os << "PERF";
+            buffer.Append("PERF");
             break;
         default:
-            os << "UNKNOWN";
+            buffer.Append("UNKNOWN");
             break;
     }
-    os << " | " << callback_data->command_name << " | " << callback_data->message_id << "] : " << callback_data->message
-       << std::endl;
+    buffer.Append(" | ");
+    buffer.Append(callback_data->command_name);
+    buffer.Append(" | ");
+    buffer.Append(callback_data->message_id);
+    buffer.Append("] : ");
+    buffer.Append(callback_data->message);
+    buffer.Append("\n");
 
     for (uint32_t obj = 0; obj < callback_data->object_count; ++obj) {
-        os << "    Object[" << obj << "] = " << callback_data->objects[obj].ToString();
-        os << std::endl;
+        const XrSdkLogObjectInfo& object = callback_data->objects[obj];
+        buffer.Append("    Object[");
+        buffer.AppendUnsigned(obj);
+        buffer.Append("] = ");
+        buffer.AppendHex(object.handle);
+        if (!object.name.empty()) {
+            buffer.Append(" (");
+            buffer.Append(object.name);
+            buffer.Append(")");
+        }
+        buffer.Append("\n");
     }
     for (uint32_t label = 0; label < callback_data->session_labels_count; ++label) {
-        os << "    SessionLabel[" << std::to_string(label) << "] = " << callback_data->session_labels[label].labelName;
-        os << std::endl;
+        buffer.Append("    SessionLabel[");
+        buffer.AppendUnsigned(label);
+        buffer.Append("] = ");
+        buffer.Append(callback_data->session_labels[label].labelName);
+        buffer.Append("\n");
     }
+    return buffer;
 }
 
 // With std::cerr: Standard Error logger, always on for now
 // With std::cout: Standard Output logger used with XR_LOADER_DEBUG
 class OstreamLoaderLogRecorder : public LoaderLogRecorder {
    public:
-    OstreamLoaderLogRecorder(std::ostream& os, void* user_data, XrLoaderLogMessageSeverityFlags flags);
+    OstreamLoaderLogRecorder(std::ostream& os, void* user_data, XrLoaderLogMessageSeverityFlags flags,
+                             XrLoaderLogMessageTypeFlags types = XR_LOADER_LOG_MESSAGE_TYPE_DEFAULT_BITS,
+                             bool uses_session_labels = true);
 
     bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
                     const XrLoaderLogMessengerCallbackData* callback_data) override;
@@ -81,6 +177,87 @@ class OstreamLoaderLogRecorder : public LoaderLogRecorder {
     std::ostream& os_;
 };
 
+// Appends the bare message text to a file, one message per line.
+class FileLoaderLogRecorder : public LoaderLogRecorder {
+   public:
+    FileLoaderLogRecorder(const std::string& filename, XrLoaderLogMessageSeverityFlags flags, XrLoaderLogMessageTypeFlags types);
+
+    bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
+                    const XrLoaderLogMessengerCallbackData* callback_data) override;
+
+   private:
+    std::mutex _mutex;
+    std::ofstream _file;
+};
+
+// Writes every message to a file as compact binary records instead of formatted text.  Message ids and command
+// names are interned: each distinct string is written once as a string record and events refer to it by index.
+// All integers are little-endian.  See the "Binary Trace" section of the loader debug documentation for the layout.
+class BinaryTraceLoaderLogRecorder : public LoaderLogRecorder {
+   public:
+    explicit BinaryTraceLoaderLogRecorder(const std::string& filename);
+
+    bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
+                    const XrLoaderLogMessengerCallbackData* callback_data) override;
+
+   private:
+    static const uint32_t kMagic = 0x544c5258;  // "XRLT"
+    static const uint32_t kVersion = 1;
+    enum RecordTag : uint8_t { kStringRecord = 1, kEventRecord = 2 };
+
+    uint32_t InternString(const char* str);
+    void PutU8(uint8_t value) { _record.push_back(value); }
+    void PutU32(uint32_t value);
+    void PutU64(uint64_t value);
+    void PutBytes(const char* str, uint32_t length) { _record.insert(_record.end(), str, str + length); }
+    void Flush();
+
+    std::mutex _mutex;
+    std::ofstream _file;
+    std::chrono::steady_clock::time_point _start;
+    std::unordered_map<std::string, uint32_t> _strings;
+    std::vector<uint8_t> _record;
+};
+
+// Queues messages in a bounded multi-producer ring buffer and forwards them to the wrapped recorder on a
+// background thread.  Producers claim slots with a compare-exchange on the write position and publish them
+// through a per-slot sequence number, so logging threads never take a lock or wait for output.
+class AsyncLoaderLogRecorder : public LoaderLogRecorder {
+   public:
+    explicit AsyncLoaderLogRecorder(std::unique_ptr<LoaderLogRecorder> recorder);
+    ~AsyncLoaderLogRecorder() override;
+
+    bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
+                    const XrLoaderLogMessengerCallbackData* callback_data) override;
+
+   private:
+    static const size_t kCapacity = 1024;  // Must be a power of two.
+
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        XrLoaderLogMessageSeverityFlagBits message_severity{0};
+        XrLoaderLogMessageTypeFlags message_type{0};
+        std::string message_id;
+        std::string command_name;
+        std::string message;
+        std::vector<XrSdkLogObjectInfo> objects;
+        std::vector<std::string> label_names;
+    };
+
+    void Drain();
+    void DrainThread();
+
+    std::unique_ptr<LoaderLogRecorder> _recorder;
+    std::unique_ptr<Slot[]> _slots;
+    std::atomic<size_t> _write_pos{0};
+    size_t _read_pos{0};
+    std::atomic<uint64_t> _dropped{0};
+    std::atomic<bool> _stop{false};
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    std::thread _thread;
+};
+
 // Debug Utils logger used with XR_EXT_debug_utils
 class DebugUtilsLogRecorder : public LoaderLogRecorder {
    public:
@@ -119,8 +296,10 @@ class DebuggerLoaderLogRecorder : public LoaderLogRecorder {
 #endif
 
 // Unified stdout/stderr logger
-OstreamLoaderLogRecorder::OstreamLoaderLogRecorder(std::ostream& os, void* user_data, XrLoaderLogMessageSeverityFlags flags)
-    : LoaderLogRecorder(XR_LOADER_LOG_STDOUT, user_data, flags, 0xFFFFFFFFUL), os_(os) {
+OstreamLoaderLogRecorder::OstreamLoaderLogRecorder(std::ostream& os, void* user_data, XrLoaderLogMessageSeverityFlags flags,
+                                                   XrLoaderLogMessageTypeFlags types, bool uses_session_labels)
+    : LoaderLogRecorder(XR_LOADER_LOG_STDOUT, user_data, flags, types), os_(os) {
+    _uses_session_labels = uses_session_labels;
     // Automatically start
     Start();
 }
@@ -129,7 +308,125 @@ bool OstreamLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits mes
                                           XrLoaderLogMessageTypeFlags message_type,
                                           const XrLoaderLogMessengerCallbackData* callback_data) {
     if (_active && 0 != (_message_severities & message_severity) && 0 != (_message_types & message_type)) {
-        OutputMessageToStream(os_, message_severity, message_type, callback_data);
+        LogMessageBuffer& buffer = FormatLogMessage(message_severity, message_type, callback_data);
+        os_.write(buffer.CStr(), static_cast<std::streamsize>(buffer.Size()));
+        os_.flush();
+    }
+
+    // Return of "true" means that we should exit the application after the logged message.  We
+    // don't want to do that for our internal logging.  Only let a user return true.
+    return false;
+}
+
+FileLoaderLogRecorder::FileLoaderLogRecorder(const std::string& filename, XrLoaderLogMessageSeverityFlags flags,
+                                             XrLoaderLogMessageTypeFlags types)
+    : LoaderLogRecorder(XR_LOADER_LOG_FILE, nullptr, flags, types), _file(filename, std::ios::out | std::ios::app) {
+    // Only the message text is written
+    _uses_session_labels = false;
+    // Only start if the file could be opened
+    if (_file.is_open()) {
+        Start();
+    }
+}
+
+bool FileLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
+                                       XrLoaderLogMessageTypeFlags message_type,
+                                       const XrLoaderLogMessengerCallbackData* callback_data) {
+    if (_active && 0 != (_message_severities & message_severity) && 0 != (_message_types & message_type)) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _file << callback_data->message << std::endl;
+    }
+
+    // Return of "true" means that we should exit the application after the logged message.  We
+    // don't want to do that for our internal logging.  Only let a user return true.
+    return false;
+}
+
+BinaryTraceLoaderLogRecorder::BinaryTraceLoaderLogRecorder(const std::string& filename)
+    : LoaderLogRecorder(XR_LOADER_LOG_TRACE, nullptr,
+                        XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT |
+                            XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT,
+                        XR_LOADER_LOG_MESSAGE_TYPE_DEFAULT_BITS),
+      _file(filename, std::ios::out | std::ios::binary | std::ios::trunc),
+      _start(std::chrono::steady_clock::now()) {
+    // Only start if the file could be opened
+    if (!_file.is_open()) {
+        return;
+    }
+
+    // Header: magic, version, then the wall clock time (ns since the epoch) that event timestamps are relative to.
+    uint64_t start_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    PutU32(kMagic);
+    PutU32(kVersion);
+    PutU64(start_ns);
+    Flush();
+    Start();
+}
+
+void BinaryTraceLoaderLogRecorder::PutU32(uint32_t value) {
+    for (int byte = 0; byte < 4; ++byte) {
+        _record.push_back(static_cast<uint8_t>(value >> (8 * byte)));
+    }
+}
+
+void BinaryTraceLoaderLogRecorder::PutU64(uint64_t value) {
+    for (int byte = 0; byte < 8; ++byte) {
+        _record.push_back(static_cast<uint8_t>(value >> (8 * byte)));
+    }
+}
+
+void BinaryTraceLoaderLogRecorder::Flush() {
+    _file.write(reinterpret_cast<const char*>(_record.data()), static_cast<std::streamsize>(_record.size()));
+    _record.clear();
+}
+
+uint32_t BinaryTraceLoaderLogRecorder::InternString(const char* str) {
+    if (str == nullptr) {
+        str = "";
+    }
+    auto it = _strings.find(str);
+    if (it != _strings.end()) {
+        return it->second;
+    }
+
+    // First use: define the string ahead of the event that refers to it.
+    auto index = static_cast<uint32_t>(_strings.size());
+    _strings.emplace(str, index);
+    auto length = static_cast<uint32_t>(strlen(str));
+    PutU8(kStringRecord);
+    PutU32(index);
+    PutU32(length);
+    PutBytes(str, length);
+    return index;
+}
+
+bool BinaryTraceLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
+                                              XrLoaderLogMessageTypeFlags message_type,
+                                              const XrLoaderLogMessengerCallbackData* callback_data) {
+    if (_active && 0 != (_message_severities & message_severity) && 0 != (_message_types & message_type)) {
+        uint64_t timestamp_ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count());
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        uint32_t message_id = InternString(callback_data->message_id);
+        uint32_t command_name = InternString(callback_data->command_name);
+        auto message_length = static_cast<uint32_t>(strlen(callback_data->message));
+
+        PutU8(kEventRecord);
+        PutU64(timestamp_ns);
+        PutU32(message_severity);
+        PutU32(message_type);
+        PutU32(message_id);
+        PutU32(command_name);
+        PutU8(callback_data->object_count);
+        for (uint8_t obj = 0; obj < callback_data->object_count; ++obj) {
+            PutU64(callback_data->objects[obj].handle);
+            PutU32(static_cast<uint32_t>(callback_data->objects[obj].type));
+        }
+        PutU32(message_length);
+        PutBytes(callback_data->message, message_length);
+        Flush();
     }
 
     // Return of "true" means that we should exit the application after the logged message.  We
@@ -137,6 +434,122 @@ bool OstreamLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits mes
     return false;
 }
 
+AsyncLoaderLogRecorder::AsyncLoaderLogRecorder(std::unique_ptr<LoaderLogRecorder> recorder)
+    : LoaderLogRecorder(recorder->Type(), nullptr, recorder->MessageSeverities(), recorder->MessageTypes()),
+      _recorder(std::move(recorder)),
+      _slots(new Slot[kCapacity]) {
+    _uses_session_labels = _recorder->UsesSessionLabels();
+    for (size_t i = 0; i < kCapacity; ++i) {
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    _thread = std::thread(&AsyncLoaderLogRecorder::DrainThread, this);
+    // Automatically start
+    Start();
+}
+
+AsyncLoaderLogRecorder::~AsyncLoaderLogRecorder() {
+    {
+        std::unique_lock<std::mutex> lock(_wake_mutex);
+        _stop.store(true, std::memory_order_release);
+    }
+    _wake.notify_one();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+bool AsyncLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
+                                        XrLoaderLogMessageTypeFlags message_type,
+                                        const XrLoaderLogMessengerCallbackData* callback_data) {
+    if (!_active || 0 == (_message_severities & message_severity) || 0 == (_message_types & message_type)) {
+        return false;
+    }
+
+    size_t pos = _write_pos.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;) {
+        slot = &_slots[pos & (kCapacity - 1)];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence == pos) {
+            if (_write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (sequence < pos) {
+            // Full: drop rather than stall the caller.
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = _write_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->message_severity = message_severity;
+    slot->message_type = message_type;
+    slot->message_id = callback_data->message_id;
+    slot->command_name = callback_data->command_name;
+    slot->message = callback_data->message;
+    slot->objects.assign(callback_data->objects, callback_data->objects + callback_data->object_count);
+    slot->label_names.clear();
+    for (uint8_t label = 0; label < callback_data->session_labels_count; ++label) {
+        slot->label_names.emplace_back(callback_data->session_labels[label].labelName);
+    }
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    // Return of "true" means that we should exit the application after the logged message.  We
+    // don't want to do that for our internal logging.  Only let a user return true.
+    return false;
+}
+
+void AsyncLoaderLogRecorder::Drain() {
+    for (;;) {
+        Slot& slot = _slots[_read_pos & (kCapacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != _read_pos + 1) {
+            break;
+        }
+
+        std::vector<XrDebugUtilsLabelEXT> labels(slot.label_names.size());
+        for (size_t label = 0; label < labels.size(); ++label) {
+            labels[label].type = XR_TYPE_DEBUG_UTILS_LABEL_EXT;
+            labels[label].next = nullptr;
+            labels[label].labelName = slot.label_names[label].c_str();
+        }
+        XrLoaderLogMessengerCallbackData callback_data = {};
+        callback_data.message_id = slot.message_id.c_str();
+        callback_data.command_name = slot.command_name.c_str();
+        callback_data.message = slot.message.c_str();
+        callback_data.objects = slot.objects.empty() ? nullptr : slot.objects.data();
+        callback_data.object_count = static_cast<uint8_t>(slot.objects.size());
+        callback_data.session_labels = labels.empty() ? nullptr : labels.data();
+        callback_data.session_labels_count = static_cast<uint8_t>(labels.size());
+        _recorder->LogMessage(slot.message_severity, slot.message_type, &callback_data);
+
+        slot.sequence.store(_read_pos + kCapacity, std::memory_order_release);
+        ++_read_pos;
+    }
+
+    const uint64_t dropped = _dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped != 0) {
+        const std::string message = "AsyncLoaderLogRecorder dropped " + std::to_string(dropped) + " messages";
+        XrLoaderLogMessengerCallbackData callback_data = {};
+        callback_data.message_id = "OpenXR-Loader";
+        callback_data.command_name = "";
+        callback_data.message = message.c_str();
+        _recorder->LogMessage(XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT, XR_LOADER_LOG_MESSAGE_TYPE_PERFORMANCE_BIT,
+                              &callback_data);
+    }
+}
+
+void AsyncLoaderLogRecorder::DrainThread() {
+    // Producers never signal, to keep them lock-free, so poll at a short interval.
+    const auto poll_interval = std::chrono::milliseconds(5);
+    while (!_stop.load(std::memory_order_acquire)) {
+        Drain();
+        std::unique_lock<std::mutex> lock(_wake_mutex);
+        _wake.wait_for(lock, poll_interval, [this] { return _stop.load(std::memory_order_acquire); });
+    }
+    Drain();
+}
+
 // A logger associated with the XR_EXT_debug_utils extension
 
 DebugUtilsLogRecorder::DebugUtilsLogRecorder(const XrDebugUtilsMessengerCreateInfoEXT* create_info,
@@ -215,6 +628,8 @@ LogcatLoaderLogRecorder::LogcatLoaderLogRecorder()
                         XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT |
                             XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT,
                         0xFFFFFFFFUL) {
+    // Always present, so it only shows labels tracked for another recorder
+    _uses_session_labels = false;
     // Automatically start
     Start();
 }
@@ -223,9 +638,8 @@ bool LogcatLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits mess
                                          XrLoaderLogMessageTypeFlags message_type,
                                          const XrLoaderLogMessengerCallbackData* callback_data) {
     if (_active && 0 != (_message_severities & message_severity) && 0 != (_message_types & message_type)) {
-        std::stringstream ss;
-        OutputMessageToStream(ss, message_severity, message_type, callback_data);
-        __android_log_write(LoaderToAndroidLogPriority(message_severity), "OpenXR-Loader", ss.str().c_str());
+        LogMessageBuffer& buffer = FormatLogMessage(message_severity, message_type, callback_data);
+        __android_log_write(LoaderToAndroidLogPriority(message_severity), "OpenXR-Loader", buffer.CStr());
     }
 
     // Return of "true" means that we should exit the application after the logged message.  We
@@ -238,6 +652,8 @@ bool LogcatLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits mess
 // Unified stdout/stderr logger
 DebuggerLoaderLogRecorder::DebuggerLoaderLogRecorder(void* user_data, XrLoaderLogMessageSeverityFlags flags)
     : LoaderLogRecorder(XR_LOADER_LOG_DEBUGGER, user_data, flags, 0xFFFFFFFFUL) {
+    // Always present, so it only shows labels tracked for another recorder
+    _uses_session_labels = false;
     // Automatically start
     Start();
 }
@@ -246,10 +662,8 @@ bool DebuggerLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits me
                                            XrLoaderLogMessageTypeFlags message_type,
                                            const XrLoaderLogMessengerCallbackData* callback_data) {
     if (_active && 0 != (_message_severities & message_severity) && 0 != (_message_types & message_type)) {
-        std::stringstream ss;
-        OutputMessageToStream(ss, message_severity, message_type, callback_data);
-
-        OutputDebugStringA(ss.str().c_str());
+        LogMessageBuffer& buffer = FormatLogMessage(message_severity, message_type, callback_data);
+        OutputDebugStringA(buffer.CStr());
     }
 
     // Return of "true" means that we should exit the application after the logged message.  We
@@ -259,14 +673,32 @@ bool DebuggerLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits me
 #endif
 }  // namespace
 
-std::unique_ptr<LoaderLogRecorder> MakeStdOutLoaderLogRecorder(void* user_data, XrLoaderLogMessageSeverityFlags flags) {
-    std::unique_ptr<LoaderLogRecorder> recorder(new OstreamLoaderLogRecorder(std::cout, user_data, flags));
+std::unique_ptr<LoaderLogRecorder> MakeStdOutLoaderLogRecorder(void* user_data, XrLoaderLogMessageSeverityFlags flags,
+                                                               XrLoaderLogMessageTypeFlags types) {
+    std::unique_ptr<LoaderLogRecorder> recorder(new OstreamLoaderLogRecorder(std::cout, user_data, flags, types));
+    return recorder;
+}
+
+std::unique_ptr<LoaderLogRecorder> MakeAsyncLoaderLogRecorder(std::unique_ptr<LoaderLogRecorder> recorder) {
+    std::unique_ptr<LoaderLogRecorder> async_recorder(new AsyncLoaderLogRecorder(std::move(recorder)));
+    return async_recorder;
+}
+
+std::unique_ptr<LoaderLogRecorder> MakeFileLoaderLogRecorder(const std::string& filename, XrLoaderLogMessageSeverityFlags flags,
+                                                             XrLoaderLogMessageTypeFlags types) {
+    std::unique_ptr<LoaderLogRecorder> recorder(new FileLoaderLogRecorder(filename, flags, types));
+    return recorder;
+}
+
+std::unique_ptr<LoaderLogRecorder> MakeBinaryTraceLoaderLogRecorder(const std::string& filename) {
+    std::unique_ptr<LoaderLogRecorder> recorder(new BinaryTraceLoaderLogRecorder(filename));
     return recorder;
 }
 
 std::unique_ptr<LoaderLogRecorder> MakeStdErrLoaderLogRecorder(void* user_data) {
-    std::unique_ptr<LoaderLogRecorder> recorder(
-        new OstreamLoaderLogRecorder(std::cerr, user_data, XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT));
+    // Always present, so it only shows labels tracked for another recorder
+    std::unique_ptr<LoaderLogRecorder> recorder(new OstreamLoaderLogRecorder(
+        std::cerr, user_data, XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT, XR_LOADER_LOG_MESSAGE_TYPE_DEFAULT_BITS, false));
     return recorder;
 }
 
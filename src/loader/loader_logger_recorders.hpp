@@ -14,12 +14,27 @@
 #include <openxr/openxr.h>
 
 #include <memory>
+#include <string>
 
 //! Standard Error logger, on by default. Disabled with environment variable XR_LOADER_DEBUG = "none".
 std::unique_ptr<LoaderLogRecorder> MakeStdErrLoaderLogRecorder(void* user_data);
 
 //! Standard Output logger used with XR_LOADER_DEBUG environment variable.
-std::unique_ptr<LoaderLogRecorder> MakeStdOutLoaderLogRecorder(void* user_data, XrLoaderLogMessageSeverityFlags flags);
+std::unique_ptr<LoaderLogRecorder> MakeStdOutLoaderLogRecorder(
+    void* user_data, XrLoaderLogMessageSeverityFlags flags, XrLoaderLogMessageTypeFlags types = XR_LOADER_LOG_MESSAGE_TYPE_DEFAULT_BITS);
+
+//! Wraps another recorder so that messages are queued in a bounded ring buffer and written by a background
+//! thread.  Messages are dropped (and the drops counted) when the buffer is full, so the logging thread never
+//! blocks.  Used for the stdout/stderr loggers when XR_LOADER_LOG_ASYNC is set.
+std::unique_ptr<LoaderLogRecorder> MakeAsyncLoaderLogRecorder(std::unique_ptr<LoaderLogRecorder> recorder);
+
+//! File logger that appends the bare message text, one message per line.  Used with XR_LOADER_TIMING_FILE.
+std::unique_ptr<LoaderLogRecorder> MakeFileLoaderLogRecorder(const std::string& filename, XrLoaderLogMessageSeverityFlags flags,
+                                                             XrLoaderLogMessageTypeFlags types);
+
+//! Binary trace logger that writes every message as a compact record with interned message ids and command
+//! names, instead of formatted text.  Used with XR_LOADER_TRACE_FILE.
+std::unique_ptr<LoaderLogRecorder> MakeBinaryTraceLoaderLogRecorder(const std::string& filename);
 
 #ifdef __ANDROID__
 //! Android liblog ("logcat") logger
@@ -36,5 +51,4 @@ std::unique_ptr<LoaderLogRecorder> MakeDebuggerLoaderLogRecorder(void* user_data
 #endif
 
 // TODO: Add other Derived classes:
-//  - FileLoaderLogRecorder     - During/after xrCreateInstance
 //  - PipeLoaderLogRecorder?    - During/after xrCreateInstance
@@ -15,6 +15,7 @@
 
 #include "xr_dependencies.h"
 #include "platform_utils.hpp"
+#include "loader_properties.hpp"
 
 #if defined(__GNUC__) && __GNUC__ >= 4
 #define LOADER_EXPORT __attribute__((visibility("default")))
@@ -41,15 +42,39 @@
 #define PATH_SEPARATOR ':'
 #define DIRECTORY_SYMBOL '/'
 
+// The dlopen flags for runtime and API layer libraries, from OPENXR_LIBRARY_BINDING_ENV_VAR: a comma-separated list
+// of "lazy" or "now", and "local" or "deepbind".  Unknown words are ignored.
+static inline int LoaderPlatformLibraryOpenFlags() {
+    // By default we use RTLD_LAZY so that not all symbols have to be resolved at this time
+    // (which improves performance). Note that if not all symbols can be resolved, this could
+    // cause crashes later.  "now" resolves them here instead, as the LD_BIND_NOW environment
+    // variable does for every library.
+    int binding = RTLD_LAZY;
+    int scope = RTLD_LOCAL;
+    std::istringstream words(LoaderProperty::GetSecure(OPENXR_LIBRARY_BINDING_ENV_VAR));
+    std::string word;
+    while (std::getline(words, word, ',')) {
+        if (word == "lazy") {
+            binding = RTLD_LAZY;
+        } else if (word == "now") {
+            binding = RTLD_NOW;
+        } else if (word == "local") {
+            scope = RTLD_LOCAL;
+#if defined(RTLD_DEEPBIND)
+        } else if (word == "deepbind") {
+            // The library prefers its own symbols to those already loaded, such as a runtime's own copy of a
+            // library the application also links.
+            scope = RTLD_LOCAL | RTLD_DEEPBIND;
+#endif  // defined(RTLD_DEEPBIND)
+        }
+    }
+    return binding | scope;
+}
+
 // Dynamic Loading of libraries:
 typedef void *LoaderPlatformLibraryHandle;
 static inline LoaderPlatformLibraryHandle LoaderPlatformLibraryOpen(const std::string &path) {
-    // When loading the library, we use RTLD_LAZY so that not all symbols have to be
-    // resolved at this time (which improves performance). Note that if not all symbols
-    // can be resolved, this could cause crashes later.
-    // For experimenting/debugging: Define the LD_BIND_NOW environment variable to force all
-    // symbols to be resolved here.
-    return dlopen(path.c_str(), RTLD_LAZY | RTLD_LOCAL);
+    return dlopen(path.c_str(), LoaderPlatformLibraryOpenFlags());
 }
 
 static inline const char *LoaderPlatformLibraryOpenError(const std::string &path) {
@@ -57,7 +82,12 @@ static inline const char *LoaderPlatformLibraryOpenError(const std::string &path
     return dlerror();
 }
 
-static inline void LoaderPlatformLibraryClose(LoaderPlatformLibraryHandle library) { dlclose(library); }
+// A null library, of a runtime or API layer linked into the loader, is ignored.
+static inline void LoaderPlatformLibraryClose(LoaderPlatformLibraryHandle library) {
+    if (library != nullptr) {
+        dlclose(library);
+    }
+}
 
 static inline void *LoaderPlatformLibraryGetProcAddr(LoaderPlatformLibraryHandle library, const std::string &name) {
     assert(library);
@@ -155,7 +185,12 @@ static inline std::string LoaderPlatformLibraryOpenError(const std::string &path
     return ss.str();
 }
 
-static inline void LoaderPlatformLibraryClose(LoaderPlatformLibraryHandle library) { FreeLibrary(library); }
+// A null library, of a runtime or API layer linked into the loader, is ignored.
+static inline void LoaderPlatformLibraryClose(LoaderPlatformLibraryHandle library) {
+    if (library != nullptr) {
+        FreeLibrary(library);
+    }
+}
 
 static inline void *LoaderPlatformLibraryGetProcAddr(LoaderPlatformLibraryHandle library, const std::string &name) {
     assert(library);
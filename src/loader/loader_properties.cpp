@@ -6,26 +6,76 @@
 #include "loader_properties.hpp"
 #include <platform_utils.hpp>
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <mutex>
+#include <utility>
+#include <vector>
+
+namespace LoaderProperty {
+struct SnapshotValues {
+    std::unordered_map<std::string, std::string> values;
+    std::unordered_map<std::string, std::string> secure_values;
+    std::unordered_map<std::string, bool> is_set;
+};
+}  // namespace LoaderProperty
 
 namespace {
 
+// The values of the outermost LoaderProperty::ScopedSnapshot alive on this thread, if any.
+thread_local LoaderProperty::SnapshotValues* g_active_snapshot = nullptr;
+
+// Look name up in the active snapshot's map, reading it with read_value the first time.
+template <typename T, typename ReadValue>
+T LookUpSnapshotValue(std::unordered_map<std::string, T>& snapshot_map, const std::string& name, ReadValue read_value) {
+    auto it = snapshot_map.find(name);
+    if (it == snapshot_map.end()) {
+        it = snapshot_map.emplace(name, read_value(name)).first;
+    }
+    return it->second;
+}
+
+using OverrideProperties = std::unordered_map<std::string, std::string>;
+
+// The overrides are never changed once published, so properties are read without a lock: setting them publishes a
+// new map.  Only those setting them take the mutex.
 std::mutex& GetOverridePropertiesMutex() {
     static std::mutex override_properties_mutex;
     return override_properties_mutex;
 }
 
-std::unordered_map<std::string, std::string>& GetOverrideProperties() {
-    static std::unordered_map<std::string, std::string> override_properties;
-    return override_properties;
+// The current overrides, or null when there are none.
+std::atomic<const OverrideProperties*>& GetPublishedOverrideProperties() {
+    static std::atomic<const OverrideProperties*> published_override_properties{nullptr};
+    return published_override_properties;
+}
+
+// Every map ever published, since a reader may still be looking at a replaced one.  The overrides are set once per
+// xrInitializeLoaderKHR, so this stays small.
+std::vector<std::unique_ptr<const OverrideProperties>>& GetAllOverrideProperties() {
+    static std::vector<std::unique_ptr<const OverrideProperties>> all_override_properties;
+    return all_override_properties;
+}
+
+// Must be called with the mutex held.
+void PublishOverrideProperties(std::unique_ptr<const OverrideProperties> override_properties) {
+    const OverrideProperties* published = nullptr;
+    if (override_properties && !override_properties->empty()) {
+        published = override_properties.get();
+        GetAllOverrideProperties().push_back(std::move(override_properties));
+    }
+    GetPublishedOverrideProperties().store(published, std::memory_order_release);
 }
 
 const std::string* TryGetPropertyOverride(const std::string& name) {
-    const auto& overrideProperties = GetOverrideProperties();
-    const auto& overrideProperty = overrideProperties.find(name);
-    if (overrideProperty != overrideProperties.end()) {
+    const OverrideProperties* overrideProperties = GetPublishedOverrideProperties().load(std::memory_order_acquire);
+    if (overrideProperties == nullptr) {
+        return nullptr;
+    }
+    const auto& overrideProperty = overrideProperties->find(name);
+    if (overrideProperty != overrideProperties->end()) {
         return &overrideProperty->second;
     }
     return nullptr;
@@ -39,8 +89,7 @@ const std::string* TryGetPropertyOverride(const std::string& name) {
 
 namespace LoaderProperty {
 
-std::string Get(const std::string& name) {
-    std::lock_guard<std::mutex> lock(GetOverridePropertiesMutex());
+static std::string ReadProperty(const std::string& name) {
     const std::string* propertyOverride = TryGetPropertyOverride(name);
     if (propertyOverride != nullptr) {
         return *propertyOverride;
@@ -49,8 +98,7 @@ std::string Get(const std::string& name) {
     }
 }
 
-std::string GetSecure(const std::string& name) {
-    std::lock_guard<std::mutex> lock(GetOverridePropertiesMutex());
+static std::string ReadSecureProperty(const std::string& name) {
     const std::string* propertyOverride = TryGetPropertyOverride(name);
     if (propertyOverride != nullptr) {
         return *propertyOverride;
@@ -59,22 +107,66 @@ std::string GetSecure(const std::string& name) {
     }
 }
 
-bool IsSet(const std::string& name) {
-    std::lock_guard<std::mutex> lock(GetOverridePropertiesMutex());
+static bool ReadIsSet(const std::string& name) {
     const std::string* propertyOverride = TryGetPropertyOverride(name);
     return propertyOverride != nullptr || PlatformUtilsGetEnvSet(name.c_str());
 }
 
+std::string Get(const std::string& name) {
+    if (g_active_snapshot == nullptr) {
+        return ReadProperty(name);
+    }
+    return LookUpSnapshotValue(g_active_snapshot->values, name, ReadProperty);
+}
+
+std::string GetSecure(const std::string& name) {
+    if (g_active_snapshot == nullptr) {
+        return ReadSecureProperty(name);
+    }
+    return LookUpSnapshotValue(g_active_snapshot->secure_values, name, ReadSecureProperty);
+}
+
+bool IsSet(const std::string& name) {
+    if (g_active_snapshot == nullptr) {
+        return ReadIsSet(name);
+    }
+    return LookUpSnapshotValue(g_active_snapshot->is_set, name, ReadIsSet);
+}
+
 void SetOverride(std::string name, std::string value) {
     std::lock_guard<std::mutex> lock(GetOverridePropertiesMutex());
-    auto& overrideProperties = GetOverrideProperties();
-    overrideProperties.insert(std::make_pair(std::move(name), std::move(value)));
+    const OverrideProperties* current = GetPublishedOverrideProperties().load(std::memory_order_relaxed);
+    if (current != nullptr && current->find(name) != current->end()) {
+        return;
+    }
+    std::unique_ptr<OverrideProperties> overrideProperties(current != nullptr ? new OverrideProperties(*current)
+                                                                                : new OverrideProperties);
+    overrideProperties->insert(std::make_pair(std::move(name), std::move(value)));
+    PublishOverrideProperties(std::move(overrideProperties));
+}
+
+void SetOverrides(std::unordered_map<std::string, std::string> overrides) {
+    std::lock_guard<std::mutex> lock(GetOverridePropertiesMutex());
+    PublishOverrideProperties(std::unique_ptr<const OverrideProperties>(new OverrideProperties(std::move(overrides))));
 }
 
 void ClearOverrides() {
     std::lock_guard<std::mutex> lock(GetOverridePropertiesMutex());
-    auto& overrideProperties = GetOverrideProperties();
-    overrideProperties.clear();
+    PublishOverrideProperties(nullptr);
+}
+
+ScopedSnapshot::ScopedSnapshot() {
+    // Nested snapshots share the outer one.
+    if (g_active_snapshot == nullptr) {
+        _values.reset(new SnapshotValues);
+        g_active_snapshot = _values.get();
+    }
+}
+
+ScopedSnapshot::~ScopedSnapshot() {
+    if (_values) {
+        g_active_snapshot = nullptr;
+    }
 }
 
 }  // namespace LoaderProperty
@@ -5,7 +5,9 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 
 // Exposes a centralized way to read properties which may be passed to the loader through xrInitializeLoaderKHR or available through
 // environment variables.
@@ -14,5 +16,25 @@ std::string Get(const std::string& name);
 std::string GetSecure(const std::string& name);
 bool IsSet(const std::string& name);
 void SetOverride(std::string name, std::string value);
+// Replaces every override at once, as xrInitializeLoaderKHR does.
+void SetOverrides(std::unordered_map<std::string, std::string> overrides);
 void ClearOverrides();
+
+struct SnapshotValues;
+
+// While an instance is alive, Get, GetSecure and IsSet on the same thread read each property from the environment
+// once and return that value for the rest of the scope.  Held for the duration of a single loader operation, so
+// repeated lookups are cheap (no GetEnvironmentVariableW and UTF-8 round trip on Windows) and consistent.
+class ScopedSnapshot {
+   public:
+    ScopedSnapshot();
+    ~ScopedSnapshot();
+
+    ScopedSnapshot(const ScopedSnapshot&) = delete;
+    ScopedSnapshot& operator=(const ScopedSnapshot&) = delete;
+
+   private:
+    // Null when an outer snapshot on this thread is already active.
+    std::unique_ptr<SnapshotValues> _values;
+};
 }  // namespace LoaderProperty
@@ -23,24 +23,40 @@
 #include "loader_properties.hpp"
 #include "platform_utils.hpp"
 #include "loader_logger.hpp"
+#include "manifest_reader.hpp"
+#include "static_chain.hpp"
 #include "unique_asset.h"
 
 #include <json/json.h>
 #include <openxr/openxr.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <cwchar>
+#include <exception>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#if defined(XR_OS_LINUX)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // XR_OS_LINUX
+
 #ifndef FALLBACK_CONFIG_DIRS
 #define FALLBACK_CONFIG_DIRS "/etc/xdg"
 #endif  // !FALLBACK_CONFIG_DIRS
@@ -66,6 +82,11 @@
 
 #include "runtime_interface.hpp"
 
+#include "exception_handling.hpp"
+
+// Set to parse API layer manifests on a small pool of worker threads instead of one after another.
+#define OPENXR_PARALLEL_MANIFEST_PARSE_ENV_VAR "XR_LOADER_PARALLEL_MANIFEST_PARSE"
+
 // Utility functions for finding files in the appropriate paths
 
 static inline bool StringEndsWith(const std::string &value, const std::string &ending) {
@@ -113,6 +134,24 @@ static void CheckAllFilesInThePath(const std::string &search_path, bool is_direc
     }
 }
 
+// Drop later entries that resolve to the same file as an earlier one, e.g. when a directory appears in more than one
+// search variable, so each manifest is only parsed once.
+static void RemoveDuplicateManifestFiles(std::vector<std::string> &manifest_files) {
+    std::unordered_set<std::string> seen;
+    std::vector<std::string> unique_files;
+    unique_files.reserve(manifest_files.size());
+    for (std::string &cur_file : manifest_files) {
+        std::string canonical_path;
+        if (!FileSysUtilsGetCanonicalPath(cur_file, canonical_path)) {
+            canonical_path = cur_file;
+        }
+        if (seen.insert(canonical_path).second) {
+            unique_files.push_back(std::move(cur_file));
+        }
+    }
+    manifest_files = std::move(unique_files);
+}
+
 // Add all manifest files in the provided paths to the manifest_files list.  If search_path
 // is made up of directory listings (versus direct manifest file names) search each path for
 // any manifest files.
@@ -249,6 +288,7 @@ static void ReadDataFilesInSearchPaths(const std::string &override_env_var, cons
 
     // Now, parse the paths and add any manifest files found in them.
     AddFilesInPath(search_path, true, manifest_files);
+    RemoveDuplicateManifestFiles(manifest_files);
 }
 
 #ifdef XR_OS_LINUX
@@ -359,16 +399,135 @@ static bool FindXDGConfigFile(const char *relative_dir, uint16_t major_version,
 
 #ifdef XR_OS_WINDOWS
 
+// The values of the runtime and API layer registry keys are cached for the life of the process, like the parsed
+// manifests below, so that back-to-back enumerate and create calls don't open and enumerate the keys again.  Each
+// cached key is kept open with RegNotifyChangeKeyValue registered on it, and is only read again once the notification
+// has signalled that its values changed.  A key that does not exist is not cached, so it is looked for again each time.
+#ifndef REG_NOTIFY_THREAD_AGNOSTIC
+#define REG_NOTIFY_THREAD_AGNOSTIC 0x10000000L
+#endif  // !REG_NOTIFY_THREAD_AGNOSTIC
+
+namespace {
+struct RegistryValue {
+    std::wstring name;
+    DWORD type;
+    std::vector<BYTE> data;
+};
+
+class RegistryKeyCache {
+   public:
+    static RegistryKeyCache &instance() {
+        static RegistryKeyCache cache;
+        return cache;
+    }
+
+    ~RegistryKeyCache() {
+        for (auto &entry : _entries) {
+            Close(entry.second);
+        }
+    }
+
+    // Get the values of the key at path under hive.  Returns false if the key can't be opened or read.
+    bool GetValues(HKEY hive, const std::wstring &path, std::vector<RegistryValue> &values) {
+        const std::wstring cache_key = (hive == HKEY_LOCAL_MACHINE ? L"HKLM\\" : L"HKCU\\") + path;
+        std::unique_lock<std::mutex> lock(_mutex);
+        auto it = _entries.find(cache_key);
+        if (it != _entries.end()) {
+            // The event resets itself, so a signalled change is only acted on once.
+            if (WaitForSingleObject(it->second.changed, 0) == WAIT_TIMEOUT) {
+                values = it->second.values;
+                return true;
+            }
+            // Watch again before reading, so that a change made while reading is not missed.
+            if (Watch(it->second) && ReadValues(it->second.hkey, it->second.values)) {
+                values = it->second.values;
+                return true;
+            }
+            // The key may have been deleted, and created again since.
+            Close(it->second);
+            _entries.erase(it);
+        }
+
+        Entry entry{};
+        if (ERROR_SUCCESS != RegOpenKeyExW(hive, path.c_str(), 0, KEY_QUERY_VALUE | KEY_NOTIFY, &entry.hkey)) {
+            return false;
+        }
+        entry.changed = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        const bool watched = entry.changed != nullptr && Watch(entry);
+        const bool read = ReadValues(entry.hkey, entry.values);
+        if (read) {
+            values = entry.values;
+        }
+        if (read && watched) {
+            _entries.emplace(cache_key, std::move(entry));
+        } else {
+            Close(entry);
+        }
+        return read;
+    }
+
+   private:
+    struct Entry {
+        HKEY hkey;
+        HANDLE changed;
+        std::vector<RegistryValue> values;
+    };
+
+    RegistryKeyCache() = default;
+
+    static bool Watch(const Entry &entry) {
+        const DWORD filter = REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET | REG_NOTIFY_THREAD_AGNOSTIC;
+        return ERROR_SUCCESS == RegNotifyChangeKeyValue(entry.hkey, FALSE, filter, entry.changed, TRUE);
+    }
+
+    static bool ReadValues(HKEY hkey, std::vector<RegistryValue> &values) {
+        values.clear();
+        DWORD value_count = 0;
+        DWORD max_name_length = 0;
+        DWORD max_data_size = 0;
+        if (ERROR_SUCCESS != RegQueryInfoKeyW(hkey, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &value_count,
+                                              &max_name_length, &max_data_size, nullptr, nullptr)) {
+            return false;
+        }
+        std::vector<wchar_t> name_w(max_name_length + 1);
+        std::vector<BYTE> data(max_data_size + 1);
+        for (DWORD index = 0; index < value_count; ++index) {
+            DWORD name_length = static_cast<DWORD>(name_w.size());
+            DWORD data_size = static_cast<DWORD>(data.size());
+            DWORD type = REG_NONE;
+            const LONG result = RegEnumValueW(hkey, index, name_w.data(), &name_length, nullptr, &type, data.data(), &data_size);
+            if (ERROR_NO_MORE_ITEMS == result) {
+                break;
+            }
+            if (ERROR_SUCCESS != result) {
+                // Changed while being read, e.g. ERROR_MORE_DATA: the notification has fired, and the next lookup
+                // reads the key again.
+                continue;
+            }
+            values.push_back(
+                {std::wstring(name_w.data(), name_length), type, std::vector<BYTE>(data.begin(), data.begin() + data_size)});
+        }
+        return true;
+    }
+
+    static void Close(Entry &entry) {
+        if (entry.changed != nullptr) {
+            CloseHandle(entry.changed);
+            entry.changed = nullptr;
+        }
+        RegCloseKey(entry.hkey);
+    }
+
+    std::mutex _mutex;
+    std::unordered_map<std::wstring, Entry> _entries;
+};
+}  // namespace
+
 // Look for runtime data files in the provided paths, but first check the environment override to determine
 // if we should use that instead.
 static void ReadRuntimeDataFilesInRegistry(const std::string &runtime_registry_location,
                                            const std::string &default_runtime_value_name,
                                            std::vector<std::string> &manifest_files) {
-    HKEY hkey;
-    DWORD access_flags;
-    wchar_t value_w[1024];
-    DWORD value_size_w = sizeof(value_w);  // byte size of the buffer.
-
     // Generate the full registry location for the registry information
     std::string full_registry_location = OPENXR_REGISTRY_LOCATION;
     full_registry_location += std::to_string(XR_VERSION_MAJOR(XR_CURRENT_API_VERSION));
@@ -378,41 +537,41 @@ static void ReadRuntimeDataFilesInRegistry(const std::string &runtime_registry_l
     const std::wstring default_runtime_value_name_w = utf8_to_wide(default_runtime_value_name);
 
     // Use 64 bit regkey for 64bit application, and use 32 bit regkey in WOW for 32bit application.
-    access_flags = KEY_QUERY_VALUE;
-    LONG open_value = RegOpenKeyExW(HKEY_LOCAL_MACHINE, full_registry_location_w.c_str(), 0, access_flags, &hkey);
-
-    if (ERROR_SUCCESS != open_value) {
+    std::vector<RegistryValue> values;
+    if (!RegistryKeyCache::instance().GetValues(HKEY_LOCAL_MACHINE, full_registry_location_w, values)) {
         LoaderLogger::LogWarningMessage("",
                                         "ReadRuntimeDataFilesInRegistry - failed to open registry key " + full_registry_location);
         return;
     }
 
-    if (ERROR_SUCCESS != RegGetValueW(hkey, nullptr, default_runtime_value_name_w.c_str(),
-                                      RRF_RT_REG_SZ | REG_EXPAND_SZ | RRF_ZEROONFAILURE, NULL, reinterpret_cast<LPBYTE>(&value_w),
-                                      &value_size_w)) {
+    // Value names are not case sensitive.  Only REG_SZ values are used, as with RegGetValueW and RRF_RT_REG_SZ.
+    auto value = std::find_if(values.begin(), values.end(), [&](const RegistryValue &candidate) {
+        return candidate.type == REG_SZ && _wcsicmp(candidate.name.c_str(), default_runtime_value_name_w.c_str()) == 0;
+    });
+    if (value == values.end()) {
         LoaderLogger::LogWarningMessage(
             "", "ReadRuntimeDataFilesInRegistry - failed to read registry value " + default_runtime_value_name);
-    } else {
-        // Not using AddFilesInPath here (as only api_layer manifest paths allow multiple
-        // separated paths)
-        // Small time-of-check vs time-of-use issue here but it mainly only affects the error message.
-        // It does not introduce a security defect.
-        std::string activeRuntimePath = wide_to_utf8(value_w);
-        if (FileSysUtilsIsRegularFile(activeRuntimePath)) {
-            // If the file exists, try to add it
-            std::string absolute_path;
-            FileSysUtilsGetAbsolutePath(activeRuntimePath, absolute_path);
-            if (!AddIfJson(absolute_path, manifest_files)) {
-                LoaderLogger::LogErrorMessage(
-                    "", "ReadRuntimeDataFilesInRegistry - registry runtime path is not json " + activeRuntimePath);
-            }
-        } else {
+        return;
+    }
+
+    // Not using AddFilesInPath here (as only api_layer manifest paths allow multiple
+    // separated paths)
+    // Small time-of-check vs time-of-use issue here but it mainly only affects the error message.
+    // It does not introduce a security defect.
+    const wchar_t *value_w = reinterpret_cast<const wchar_t *>(value->data.data());
+    std::string activeRuntimePath = wide_to_utf8(std::wstring(value_w, wcsnlen(value_w, value->data.size() / sizeof(wchar_t))));
+    if (FileSysUtilsIsRegularFile(activeRuntimePath)) {
+        // If the file exists, try to add it
+        std::string absolute_path;
+        FileSysUtilsGetAbsolutePath(activeRuntimePath, absolute_path);
+        if (!AddIfJson(absolute_path, manifest_files)) {
             LoaderLogger::LogErrorMessage(
-                "", "ReadRuntimeDataFilesInRegistry - registry runtime path does not exist " + activeRuntimePath);
+                "", "ReadRuntimeDataFilesInRegistry - registry runtime path is not json " + activeRuntimePath);
         }
+    } else {
+        LoaderLogger::LogErrorMessage("",
+                                      "ReadRuntimeDataFilesInRegistry - registry runtime path does not exist " + activeRuntimePath);
     }
-
-    RegCloseKey(hkey);
 }
 
 // Look for layer data files in the provided paths, but first check the environment override to determine
@@ -422,30 +581,23 @@ static void ReadLayerDataFilesInRegistry(const std::string &registry_location, s
         utf8_to_wide(OPENXR_REGISTRY_LOCATION + std::to_string(XR_VERSION_MAJOR(XR_CURRENT_API_VERSION)) + registry_location);
 
     auto ReadLayerDataFilesInHive = [&](HKEY hive) {
-        HKEY hkey;
-        LONG open_value = RegOpenKeyExW(hive, full_registry_location_w.c_str(), 0, KEY_QUERY_VALUE, &hkey);
-        if (ERROR_SUCCESS != open_value) {
+        std::vector<RegistryValue> values;
+        if (!RegistryKeyCache::instance().GetValues(hive, full_registry_location_w, values)) {
             return false;
         }
 
-        wchar_t name_w[1024]{};
-        LONG rtn_value;
-        DWORD name_size = 1023;
-        DWORD value;
-        DWORD value_size = sizeof(value);
-        DWORD key_index = 0;
-        while (ERROR_SUCCESS ==
-               (rtn_value = RegEnumValueW(hkey, key_index++, name_w, &name_size, NULL, NULL, (LPBYTE)&value, &value_size))) {
-            if (value_size == sizeof(value) && value == 0) {
-                const std::string filename = wide_to_utf8(name_w);
+        // Each value names a manifest file, which is enabled if the value is a DWORD of 0.
+        for (const RegistryValue &value : values) {
+            DWORD enabled = 1;
+            if (value.data.size() == sizeof(enabled)) {
+                memcpy(&enabled, value.data.data(), sizeof(enabled));
+            }
+            if (enabled == 0) {
+                const std::string filename = wide_to_utf8(value.name);
                 AddFilesInPath(filename, false, manifest_files);
             }
-            // Reset some items for the next loop
-            name_size = 1023;
         }
 
-        RegCloseKey(hkey);
-
         return true;
     };
 
@@ -467,6 +619,408 @@ static void ReadLayerDataFilesInRegistry(const std::string &registry_location, s
 
 #endif  // XR_OS_WINDOWS
 
+// Parsed manifest JSON is cached for the life of the process so that back-to-back enumerate and create calls
+// don't have to read and parse every manifest again.  An entry is only reused while the file's modification
+// time and size match the values recorded when it was parsed.
+//
+// If OPENXR_MANIFEST_INDEX_ENV_VAR is set, the cache is also persisted to an index file so that a cold start
+// only has to open the manifests that changed since the index was written.  The variable holds either the path
+// of the index file, or any other non-empty value to use the default location in the user's cache directory.
+//
+// On Linux, if OPENXR_MANIFEST_SHARED_ENV_VAR is set, the same index is also published in a shared memory segment
+// of the user's, so that sibling processes of an application attach to the manifests one of them already read
+// instead of reading them again.  Each manifest is still only used while its file's stamp matches, and layer
+// validation still runs in every process, since it depends on the process's environment.
+namespace {
+struct ManifestFileStamp {
+    std::string canonical_path;
+    uint64_t modified_time{0};
+    uint64_t file_size{0};
+    bool valid{false};
+};
+
+struct ManifestJsonCacheEntry {
+    uint64_t modified_time;
+    uint64_t file_size;
+    std::shared_ptr<const Json::Value> root_node;
+    // Compact JSON text loaded from the index file, parsed on first use.
+    std::string json_text;
+};
+
+// "XRMI" followed by the layout version of the index file
+const uint32_t kManifestIndexMagic = 0x494d5258;
+const uint32_t kManifestIndexVersion = 1;
+
+class ManifestIndexReader {
+   public:
+    explicit ManifestIndexReader(const std::string &data) : _data(data) {}
+
+    template <typename T>
+    bool Read(T &value) {
+        if (_data.size() - _offset < sizeof(T)) {
+            return false;
+        }
+        memcpy(&value, _data.data() + _offset, sizeof(T));
+        _offset += sizeof(T);
+        return true;
+    }
+
+    bool Read(std::string &value) {
+        uint32_t length = 0;
+        if (!Read(length) || _data.size() - _offset < length) {
+            return false;
+        }
+        value.assign(_data, _offset, length);
+        _offset += length;
+        return true;
+    }
+
+   private:
+    const std::string &_data;
+    size_t _offset{0};
+};
+
+template <typename T>
+void WriteIndexValue(std::ostream &stream, const T &value) {
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void WriteIndexValue(std::ostream &stream, const std::string &value) {
+    WriteIndexValue(stream, static_cast<uint32_t>(value.size()));
+    stream.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+#if defined(XR_OS_LINUX)
+// The shared memory segment is a file in /dev/shm, as shm_open would make, private to the user.
+std::string GetManifestSharedSegmentName() {
+    if (LoaderProperty::GetSecure(OPENXR_MANIFEST_SHARED_ENV_VAR).empty()) {
+        return {};
+    }
+    return "/dev/shm/openxr_loader_manifests_" + std::to_string(static_cast<unsigned long>(getuid())) + "_" +
+           std::to_string(XR_VERSION_MAJOR(XR_CURRENT_API_VERSION));
+}
+
+// Only a regular file of this user's that nobody else can write is trusted.
+bool IsPrivateSharedSegment(int fd) {
+    struct stat segment_stat {};
+    return fstat(fd, &segment_stat) == 0 && S_ISREG(segment_stat.st_mode) && segment_stat.st_uid == getuid() &&
+           (segment_stat.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+// Copy the published index out of the shared memory segment, under a shared lock so no writer changes it meanwhile.
+bool ReadManifestSharedSegment(const std::string &segment_name, std::string &data) {
+    const int fd = open(segment_name.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool read = false;
+    if (IsPrivateSharedSegment(fd) && flock(fd, LOCK_SH) == 0) {
+        struct stat segment_stat {};
+        if (fstat(fd, &segment_stat) == 0 && segment_stat.st_size > 0) {
+            const size_t size = static_cast<size_t>(segment_stat.st_size);
+            void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping != MAP_FAILED) {
+                data.assign(static_cast<const char *>(mapping), size);
+                munmap(mapping, size);
+                read = true;
+            }
+        }
+        flock(fd, LOCK_UN);
+    }
+    close(fd);
+    return read;
+}
+
+// Replace the published index, under an exclusive lock.
+bool WriteManifestSharedSegment(const std::string &segment_name, const std::string &data) {
+    const int fd = open(segment_name.c_str(), O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        return false;
+    }
+    bool written = false;
+    if (IsPrivateSharedSegment(fd) && flock(fd, LOCK_EX) == 0) {
+        written = ftruncate(fd, static_cast<off_t>(data.size())) == 0;
+        void *mapping = written ? mmap(nullptr, data.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (mapping != MAP_FAILED) {
+            memcpy(mapping, data.data(), data.size());
+            munmap(mapping, data.size());
+        } else {
+            // Left zero filled, which readers do not recognize as an index.
+            written = false;
+        }
+        flock(fd, LOCK_UN);
+    }
+    close(fd);
+    return written;
+}
+#endif  // XR_OS_LINUX
+
+std::string GetManifestIndexFilename() {
+    std::string index_filename = LoaderProperty::GetSecure(OPENXR_MANIFEST_INDEX_ENV_VAR);
+    if (index_filename.empty() || FileSysUtilsIsAbsolutePath(index_filename)) {
+        return index_filename;
+    }
+    std::string cache_dir;
+#if defined(XR_OS_LINUX)
+    cache_dir = GetXDGEnvHome("XDG_CACHE_HOME", ".cache");
+#elif defined(XR_OS_WINDOWS)
+    cache_dir = LoaderProperty::GetSecure("LOCALAPPDATA");
+#endif
+    if (cache_dir.empty()) {
+        return cache_dir;
+    }
+    std::string combined;
+    FileSysUtilsCombinePaths(cache_dir,
+                             "openxr_loader_manifest_index_" + std::to_string(XR_VERSION_MAJOR(XR_CURRENT_API_VERSION)) + ".bin",
+                             combined);
+    return combined;
+}
+
+class ManifestJsonCache {
+   public:
+    static ManifestJsonCache &instance() {
+        static ManifestJsonCache cache;
+        return cache;
+    }
+
+    // Look up the parsed JSON for filename.  Returns nullptr if it is not cached or the file changed since it was
+    // parsed.  The current stamp of the file is returned in stamp so it can be used by a subsequent Insert.
+    std::shared_ptr<const Json::Value> Find(const std::string &filename, ManifestFileStamp &stamp) {
+        stamp = {};
+        if (!FileSysUtilsGetCanonicalPath(filename, stamp.canonical_path)) {
+            stamp.canonical_path = filename;
+        }
+        stamp.valid = FileSysUtilsGetFileStamp(stamp.canonical_path, stamp.modified_time, stamp.file_size);
+        if (!stamp.valid) {
+            return nullptr;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        LoadIndex();
+        auto it = _entries.find(stamp.canonical_path);
+        if (it == _entries.end()) {
+            return nullptr;
+        }
+        if (it->second.modified_time != stamp.modified_time || it->second.file_size != stamp.file_size) {
+            _entries.erase(it);
+            _index_dirty = true;
+            return nullptr;
+        }
+        if (!it->second.root_node) {
+            // Loaded from the index file and not used yet.
+            std::shared_ptr<Json::Value> root_node = std::make_shared<Json::Value>(Json::nullValue);
+            Json::CharReaderBuilder builder;
+            std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+            const std::string &text = it->second.json_text;
+            if (!reader->parse(text.data(), text.data() + text.size(), root_node.get(), nullptr) || !root_node->isObject()) {
+                _entries.erase(it);
+                _index_dirty = true;
+                return nullptr;
+            }
+            it->second.root_node = std::move(root_node);
+        }
+        return it->second.root_node;
+    }
+
+    void Insert(const ManifestFileStamp &stamp, std::shared_ptr<const Json::Value> root_node) {
+        if (!stamp.valid) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        _entries[stamp.canonical_path] =
+            ManifestJsonCacheEntry{stamp.modified_time, stamp.file_size, std::move(root_node), std::string()};
+        _index_dirty = true;
+    }
+
+    size_t Footprint() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        size_t bytes = _entries.bucket_count() * sizeof(void *);
+        for (const auto &entry : _entries) {
+            bytes += sizeof(decltype(_entries)::value_type) + sizeof(void *) + entry.first.capacity() +
+                     entry.second.json_text.capacity();
+            if (entry.second.root_node) {
+                bytes += JsonValueFootprint(*entry.second.root_node);
+            }
+        }
+        return bytes;
+    }
+
+    // Write the index file and shared memory segment, those that are enabled, if anything changed since they were loaded.
+    void SaveIndex() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!_index_dirty || (_index_filename.empty() && _shared_segment_name.empty())) {
+            return;
+        }
+        _index_dirty = false;
+
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        std::ostringstream oss;
+        uint32_t count = 0;
+        for (auto &entry : _entries) {
+            // Drop manifests that have been removed since they were indexed.
+            if (!FileSysUtilsPathExists(entry.first)) {
+                continue;
+            }
+            if (entry.second.json_text.empty() && entry.second.root_node) {
+                entry.second.json_text = Json::writeString(builder, *entry.second.root_node);
+            }
+            WriteIndexValue(oss, entry.first);
+            WriteIndexValue(oss, entry.second.modified_time);
+            WriteIndexValue(oss, entry.second.file_size);
+            WriteIndexValue(oss, entry.second.json_text);
+            ++count;
+        }
+        std::ostringstream index_oss;
+        WriteIndexValue(index_oss, kManifestIndexMagic);
+        WriteIndexValue(index_oss, kManifestIndexVersion);
+        WriteIndexValue(index_oss, count);
+        index_oss << oss.str();
+        const std::string index = index_oss.str();
+
+#if defined(XR_OS_LINUX)
+        if (!_shared_segment_name.empty() && !WriteManifestSharedSegment(_shared_segment_name, index)) {
+            LoaderLogger::LogWarningMessage("", "ManifestJsonCache::SaveIndex - failed to publish " + _shared_segment_name);
+        }
+#endif  // XR_OS_LINUX
+        if (_index_filename.empty()) {
+            return;
+        }
+
+        // Write to a temporary file and move it into place so a concurrent reader never sees a partial index.
+        const std::string temp_filename = _index_filename + ".tmp";
+        {
+            std::ofstream index_stream(temp_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!index_stream.is_open()) {
+                LoaderLogger::LogWarningMessage("", "ManifestJsonCache::SaveIndex - failed to write " + temp_filename);
+                return;
+            }
+            index_stream.write(index.data(), static_cast<std::streamsize>(index.size()));
+            if (!index_stream.good()) {
+                index_stream.close();
+                std::remove(temp_filename.c_str());
+                return;
+            }
+        }
+        if (std::rename(temp_filename.c_str(), _index_filename.c_str()) != 0) {
+            // Windows will not rename over an existing file.
+            std::remove(_index_filename.c_str());
+            if (std::rename(temp_filename.c_str(), _index_filename.c_str()) != 0) {
+                std::remove(temp_filename.c_str());
+                LoaderLogger::LogWarningMessage("", "ManifestJsonCache::SaveIndex - failed to replace " + _index_filename);
+            }
+        }
+    }
+
+   private:
+    // Each value, the characters of strings, and a map node per element of objects and arrays, with the member name.
+    static size_t JsonValueFootprint(const Json::Value &value) {
+        size_t bytes = sizeof(Json::Value);
+        const char *begin = nullptr;
+        const char *end = nullptr;
+        if (value.getString(&begin, &end)) {
+            bytes += static_cast<size_t>(end - begin);
+        } else if (value.isObject()) {
+            for (auto it = value.begin(); it != value.end(); ++it) {
+                bytes += 4 * sizeof(void *) + it.name().size() + JsonValueFootprint(*it);
+            }
+        } else if (value.isArray()) {
+            for (const auto &element : value) {
+                bytes += 4 * sizeof(void *) + JsonValueFootprint(element);
+            }
+        }
+        return bytes;
+    }
+
+    // Must be called with _mutex held.
+    void LoadIndex() {
+        if (_index_loaded) {
+            return;
+        }
+        _index_loaded = true;
+        _index_filename = GetManifestIndexFilename();
+#if defined(XR_OS_LINUX)
+        _shared_segment_name = GetManifestSharedSegmentName();
+        std::string shared_data;
+        if (!_shared_segment_name.empty() && ReadManifestSharedSegment(_shared_segment_name, shared_data) &&
+            ParseIndex(shared_data, _shared_segment_name)) {
+            return;
+        }
+        _entries.clear();
+#endif  // XR_OS_LINUX
+        if (_index_filename.empty()) {
+            return;
+        }
+
+        // Read the whole index in a single request rather than record by record.
+        std::ifstream index_stream(_index_filename, std::ios::in | std::ios::binary);
+        if (!index_stream.is_open()) {
+            return;
+        }
+        std::ostringstream data_stream;
+        data_stream << index_stream.rdbuf();
+        if (!ParseIndex(data_stream.str(), _index_filename)) {
+            // Rewrite it from the manifests.
+            _index_dirty = true;
+        }
+    }
+
+    // Add the entries of an index file or shared memory segment.  Must be called with _mutex held.
+    bool ParseIndex(const std::string &data, const std::string &source) {
+        ManifestIndexReader reader(data);
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t count = 0;
+        if (!reader.Read(magic) || magic != kManifestIndexMagic || !reader.Read(version) || version != kManifestIndexVersion ||
+            !reader.Read(count)) {
+            LoaderLogger::LogWarningMessage("", "ManifestJsonCache::LoadIndex - ignoring unrecognized index " + source);
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string path;
+            ManifestJsonCacheEntry entry{0, 0, nullptr, std::string()};
+            if (!reader.Read(path) || !reader.Read(entry.modified_time) || !reader.Read(entry.file_size) ||
+                !reader.Read(entry.json_text)) {
+                LoaderLogger::LogWarningMessage("", "ManifestJsonCache::LoadIndex - index " + source + " is truncated");
+                _entries.clear();
+                return false;
+            }
+            _entries.emplace(std::move(path), std::move(entry));
+        }
+        LoaderLogger::LogVerboseMessage("", "ManifestJsonCache::LoadIndex - loaded " + std::to_string(count) + " manifests from " +
+                                                source);
+        return true;
+    }
+
+    std::mutex _mutex;
+    std::unordered_map<std::string, ManifestJsonCacheEntry> _entries;
+    std::string _index_filename;
+    std::string _shared_segment_name;
+    bool _index_loaded{false};
+    bool _index_dirty{false};
+};
+}  // namespace
+
+// Parse a manifest in memory.  The manifest reader handles the common case without building a full
+// jsoncpp document; anything it does not handle is parsed by jsoncpp instead, which also reports the errors.
+static bool ParseManifestJson(const char *begin, const char *end, Json::Value &root_node, std::string &errors) {
+    if (ManifestReaderParse(begin, end, root_node)) {
+        return true;
+    }
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    root_node = Json::Value(Json::nullValue);
+    return reader->parse(begin, end, &root_node, &errors);
+}
+
+// Parse a manifest from a stream.
+static bool ParseManifestJson(std::istream &json_stream, Json::Value &root_node, std::string &errors) {
+    std::ostringstream buffer_stream;
+    buffer_stream << json_stream.rdbuf();
+    const std::string buffer = buffer_stream.str();
+    return ParseManifestJson(buffer.data(), buffer.data() + buffer.size(), root_node, errors);
+}
+
 ManifestFile::ManifestFile(ManifestFileType type, const std::string &filename, const std::string &library_path)
     : _filename(filename), _type(type), _library_path(library_path) {}
 
@@ -524,6 +1078,8 @@ std::string ManifestFile::GetFunctionName(const std::string &func_name) const {
     return func_name;
 }
 
+size_t ManifestFile::CacheFootprint() { return ManifestJsonCache::instance().Footprint(); }
+
 RuntimeManifestFile::RuntimeManifestFile(const std::string &filename, const std::string &library_path)
     : ManifestFile(MANIFEST_TYPE_RUNTIME, filename, library_path) {}
 
@@ -568,21 +1124,38 @@ void ManifestFile::ParseCommon(Json::Value const &root_node) {
     }
 }
 
+void ManifestFile::AddRenamedFunction(const std::string &func_name, const std::string &symbol_name) {
+    _functions_renamed.emplace(func_name, symbol_name);
+}
+
+void ManifestFile::AddInstanceExtension(const std::string &name, uint32_t extension_version) {
+    _instance_extensions.push_back({name, extension_version});
+}
+
 void RuntimeManifestFile::CreateIfValid(std::string const &filename,
                                         std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files) {
+    LoaderLogger::LogInfoMessage("", "RuntimeManifestFile::CreateIfValid - attempting to load " + filename);
+
+    ManifestFileStamp stamp;
+    std::shared_ptr<const Json::Value> cached_root_node = ManifestJsonCache::instance().Find(filename, stamp);
+    if (cached_root_node) {
+        LoaderLogger::LogVerboseMessage("", "RuntimeManifestFile::CreateIfValid - reusing cached parse of " + filename);
+        CreateIfValid(*cached_root_node, filename, manifest_files);
+        return;
+    }
+
     std::ifstream json_stream(filename, std::ifstream::in);
 
-    LoaderLogger::LogInfoMessage("", "RuntimeManifestFile::CreateIfValid - attempting to load " + filename);
     std::ostringstream error_ss("RuntimeManifestFile::CreateIfValid ");
     if (!json_stream.is_open()) {
         error_ss << "failed to open " << filename << ".  Does it exist?";
         LoaderLogger::LogErrorMessage("", error_ss.str());
         return;
     }
-    Json::CharReaderBuilder builder;
+    LoaderPhaseTimer timer("", "manifest_parse", filename);
     std::string errors;
-    Json::Value root_node = Json::nullValue;
-    if (!Json::parseFromStream(builder, json_stream, &root_node, &errors) || !root_node.isObject()) {
+    std::shared_ptr<Json::Value> root_node = std::make_shared<Json::Value>(Json::nullValue);
+    if (!ParseManifestJson(json_stream, *root_node, errors) || !root_node->isObject()) {
         error_ss << "failed to parse " << filename << ".";
         if (!errors.empty()) {
             error_ss << " (Error message: " << errors << ")";
@@ -591,8 +1164,9 @@ void RuntimeManifestFile::CreateIfValid(std::string const &filename,
         LoaderLogger::LogErrorMessage("", error_ss.str());
         return;
     }
+    ManifestJsonCache::instance().Insert(stamp, root_node);
 
-    CreateIfValid(root_node, filename, manifest_files);
+    CreateIfValid(*root_node, filename, manifest_files);
 }
 
 void RuntimeManifestFile::CreateIfValid(const Json::Value &root_node, const std::string &filename,
@@ -647,9 +1221,19 @@ void RuntimeManifestFile::CreateIfValid(const Json::Value &root_node, const std:
     manifest_files.back()->ParseCommon(runtime_root_node);
 }
 
+void RuntimeManifestFile::CreateFromLibrary(const std::string &library_path,
+                                            const std::vector<std::pair<std::string, std::string>> &renamed_functions,
+                                            std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files) {
+    manifest_files.emplace_back(new RuntimeManifestFile("", library_path));
+    for (const auto &renamed : renamed_functions) {
+        manifest_files.back()->AddRenamedFunction(renamed.first, renamed.second);
+    }
+}
+
 // Find all manifest files in the appropriate search paths/registries for the given type.
 XrResult RuntimeManifestFile::FindManifestFiles(const std::string &openxr_command,
                                                 std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files) {
+    LoaderPhaseTimer timer(openxr_command.c_str(), "runtime_manifest_search");
     XrResult result = XR_SUCCESS;
     std::string filename = LoaderProperty::GetSecure(OPENXR_RUNTIME_JSON_ENV_VAR);
     if (!filename.empty()) {
@@ -683,10 +1267,11 @@ XrResult RuntimeManifestFile::FindManifestFiles(const std::string &openxr_comman
 #else  // !defined(XR_OS_WINDOWS) && !defined(XR_OS_LINUX)
 
 #if defined(XR_USE_PLATFORM_ANDROID) && defined(XR_HAS_REQUIRED_PLATFORM_LOADER_INIT_STRUCT)
-        Json::Value virtualManifest;
-        result = GetPlatformRuntimeVirtualManifest(virtualManifest);
+        // The runtime broker's description is used as is, without building a manifest to parse.
+        openxr_android::ActiveRuntime active_runtime;
+        result = GetPlatformActiveRuntime(active_runtime);
         if (XR_SUCCESS == result) {
-            RuntimeManifestFile::CreateIfValid(virtualManifest, "", manifest_files);
+            RuntimeManifestFile::CreateFromLibrary(active_runtime.libraryPath, active_runtime.functions, manifest_files);
             return result;
         }
 #endif  // defined(XR_USE_PLATFORM_ANDROID) && defined(XR_HAS_REQUIRED_PLATFORM_LOADER_INIT_STRUCT)
@@ -703,6 +1288,7 @@ XrResult RuntimeManifestFile::FindManifestFiles(const std::string &openxr_comman
 #endif  // !defined(XR_OS_WINDOWS) && !defined(XR_OS_LINUX)
     }
     RuntimeManifestFile::CreateIfValid(filename, manifest_files);
+    ManifestJsonCache::instance().SaveIndex();
 
     return result;
 }
@@ -774,29 +1360,45 @@ void ApiLayerManifestFile::AddManifestFilesAndroid(const std::string &openxr_com
 
             continue;
         }
-        std::istringstream json_stream(std::string{buf, length});
 
-        CreateIfValid(type, filename, json_stream, &ApiLayerManifestFile::LocateLibraryInAssets, manifest_files);
+        // Parsed in place, from the asset's buffer.
+        CreateIfValid(type, filename, buf, buf + length, &ApiLayerManifestFile::LocateLibraryInAssets, manifest_files);
     }
 }
 #endif  // defined(XR_USE_PLATFORM_ANDROID) && defined(XR_HAS_REQUIRED_PLATFORM_LOADER_INIT_STRUCT)
 
-void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::string &filename, std::istream &json_stream,
-                                         LibraryLocator locate_library,
-                                         std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
-    std::ostringstream error_ss("ApiLayerManifestFile::CreateIfValid ");
-    Json::CharReaderBuilder builder;
+// Parse a layer manifest, in memory or from a stream.  Returns nullptr (after logging) if it is not valid JSON.
+template <typename... Source>
+static std::shared_ptr<Json::Value> ParseApiLayerManifestJson(const std::string &filename, Source &&...source) {
+    LoaderPhaseTimer timer("", "manifest_parse", filename);
     std::string errors;
-    Json::Value root_node = Json::nullValue;
-    if (!Json::parseFromStream(builder, json_stream, &root_node, &errors) || !root_node.isObject()) {
+    std::shared_ptr<Json::Value> root_node = std::make_shared<Json::Value>(Json::nullValue);
+    if (!ParseManifestJson(std::forward<Source>(source)..., *root_node, errors) || !root_node->isObject()) {
+        std::ostringstream error_ss("ApiLayerManifestFile::CreateIfValid ");
         error_ss << "failed to parse " << filename << ".";
         if (!errors.empty()) {
             error_ss << " (Error message: " << errors << ")";
         }
         error_ss << " Is it a valid layer manifest file?";
         LoaderLogger::LogErrorMessage("", error_ss.str());
-        return;
+        return nullptr;
+    }
+    return root_node;
+}
+
+void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::string &filename, const char *json_begin,
+                                         const char *json_end, LibraryLocator locate_library,
+                                         std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
+    std::shared_ptr<Json::Value> root_node = ParseApiLayerManifestJson(filename, json_begin, json_end);
+    if (root_node) {
+        CreateIfValid(type, filename, *root_node, locate_library, manifest_files);
     }
+}
+
+void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::string &filename, const Json::Value &root_node,
+                                         LibraryLocator locate_library,
+                                         std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
+    std::ostringstream error_ss("ApiLayerManifestFile::CreateIfValid ");
     JsonVersion file_version = {};
     if (!ManifestFile::IsValidJson(root_node, file_version)) {
         error_ss << "isValidJson indicates " << filename << " is not a valid manifest file.";
@@ -899,14 +1501,25 @@ void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::strin
 
 void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::string &filename,
                                          std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
-    std::ifstream json_stream(filename, std::ifstream::in);
-    if (!json_stream.is_open()) {
-        std::ostringstream error_ss("ApiLayerManifestFile::CreateIfValid ");
-        error_ss << "failed to open " << filename << ".  Does it exist?";
-        LoaderLogger::LogErrorMessage("", error_ss.str());
-        return;
+    ManifestFileStamp stamp;
+    std::shared_ptr<const Json::Value> root_node = ManifestJsonCache::instance().Find(filename, stamp);
+    if (root_node) {
+        LoaderLogger::LogVerboseMessage("", "ApiLayerManifestFile::CreateIfValid - reusing cached parse of " + filename);
+    } else {
+        std::ifstream json_stream(filename, std::ifstream::in);
+        if (!json_stream.is_open()) {
+            std::ostringstream error_ss("ApiLayerManifestFile::CreateIfValid ");
+            error_ss << "failed to open " << filename << ".  Does it exist?";
+            LoaderLogger::LogErrorMessage("", error_ss.str());
+            return;
+        }
+        root_node = ParseApiLayerManifestJson(filename, json_stream);
+        if (!root_node) {
+            return;
+        }
+        ManifestJsonCache::instance().Insert(stamp, root_node);
     }
-    CreateIfValid(type, filename, json_stream, &ApiLayerManifestFile::LocateLibraryRelativeToJson, manifest_files);
+    CreateIfValid(type, filename, *root_node, &ApiLayerManifestFile::LocateLibraryRelativeToJson, manifest_files);
 }
 
 bool ApiLayerManifestFile::LocateLibraryRelativeToJson(
@@ -950,9 +1563,80 @@ void ApiLayerManifestFile::PopulateApiLayerProperties(XrApiLayerProperties &prop
     }
 }
 
+// Parse the given manifest files concurrently.  Each file gets its own result slot, and the slots are merged in
+// the order of filenames afterwards so that layer ordering is the same as when parsing sequentially.
+void ApiLayerManifestFile::CreateIfValidParallel(ManifestFileType type, const std::vector<std::string> &filenames,
+                                                 std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
+    const size_t max_workers = 4;
+    size_t worker_count = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), max_workers);
+    worker_count = std::min(worker_count, filenames.size());
+
+    std::vector<std::vector<std::unique_ptr<ApiLayerManifestFile>>> results(filenames.size());
+    std::atomic<size_t> next_file{0};
+#ifndef XRLOADER_DISABLE_EXCEPTION_HANDLING
+    std::vector<std::exception_ptr> worker_errors(worker_count);
+#endif  // !XRLOADER_DISABLE_EXCEPTION_HANDLING
+
+    auto parse_files = [&](size_t worker) {
+        (void)worker;
+#ifndef XRLOADER_DISABLE_EXCEPTION_HANDLING
+        try {
+#endif  // !XRLOADER_DISABLE_EXCEPTION_HANDLING
+            for (size_t i = next_file++; i < filenames.size(); i = next_file++) {
+                ApiLayerManifestFile::CreateIfValid(type, filenames[i], results[i]);
+            }
+#ifndef XRLOADER_DISABLE_EXCEPTION_HANDLING
+        } catch (...) {
+            worker_errors[worker] = std::current_exception();
+        }
+#endif  // !XRLOADER_DISABLE_EXCEPTION_HANDLING
+    };
+
+    // The calling thread does its share of the work too.
+    std::vector<std::thread> workers;
+    for (size_t worker = 1; worker < worker_count; ++worker) {
+        workers.emplace_back(parse_files, worker);
+    }
+    parse_files(0);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+#ifndef XRLOADER_DISABLE_EXCEPTION_HANDLING
+    for (std::exception_ptr &error : worker_errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+#endif  // !XRLOADER_DISABLE_EXCEPTION_HANDLING
+
+    for (auto &result : results) {
+        for (auto &manifest_file : result) {
+            manifest_files.emplace_back(std::move(manifest_file));
+        }
+    }
+}
+
 // Find all layer manifest files in the appropriate search paths/registries for the given type.
+#if defined(XR_LOADER_STATIC_CHAIN)
+void ApiLayerManifestFile::AddStaticChainManifestFiles(std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
+    const ManifestFileType type = MANIFEST_TYPE_IMPLICIT_API_LAYER;
+    const JsonVersion api_version{XR_VERSION_MAJOR(XR_CURRENT_API_VERSION), XR_VERSION_MINOR(XR_CURRENT_API_VERSION),
+                                  XR_VERSION_PATCH(XR_CURRENT_API_VERSION)};
+    for (const StaticChainApiLayer &layer : StaticChainApiLayers()) {
+        manifest_files.emplace_back(
+            new ApiLayerManifestFile(type, "", layer.layer_name, "API layer linked into the loader", api_version, 1, ""));
+        for (const std::string &extension : layer.instance_extensions) {
+            manifest_files.back()->AddInstanceExtension(extension, 1);
+        }
+    }
+}
+#endif  // defined(XR_LOADER_STATIC_CHAIN)
+
 XrResult ApiLayerManifestFile::FindManifestFiles(const std::string &openxr_command, ManifestFileType type,
                                                  std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
+    LoaderPhaseTimer timer(openxr_command.c_str(), type == MANIFEST_TYPE_IMPLICIT_API_LAYER ? "implicit_layer_manifest_search"
+                                                                                            : "explicit_layer_manifest_search");
     std::string relative_path;
     std::string override_env_var;
 #ifdef XR_OS_WINDOWS
@@ -996,13 +1680,19 @@ XrResult ApiLayerManifestFile::FindManifestFiles(const std::string &openxr_comma
     }
 #endif
 
-    for (std::string &cur_file : filenames) {
-        ApiLayerManifestFile::CreateIfValid(type, cur_file, manifest_files);
+    if (filenames.size() > 1 && LoaderProperty::IsSet(OPENXR_PARALLEL_MANIFEST_PARSE_ENV_VAR)) {
+        CreateIfValidParallel(type, filenames, manifest_files);
+    } else {
+        for (std::string &cur_file : filenames) {
+            ApiLayerManifestFile::CreateIfValid(type, cur_file, manifest_files);
+        }
     }
 
 #if defined(XR_USE_PLATFORM_ANDROID) && defined(XR_HAS_REQUIRED_PLATFORM_LOADER_INIT_STRUCT)
     ApiLayerManifestFile::AddManifestFilesAndroid(openxr_command, type, manifest_files);
 #endif  // defined(XR_USE_PLATFORM_ANDROID) && defined(XR_HAS_REQUIRED_PLATFORM_LOADER_INIT_STRUCT)
 
+    ManifestJsonCache::instance().SaveIndex();
+
     return XR_SUCCESS;
 }
@@ -16,6 +16,7 @@
 #include <vector>
 #include <iosfwd>
 #include <unordered_map>
+#include <utility>
 
 namespace Json {
 class Value;
@@ -52,10 +53,14 @@ class ManifestFile {
     const std::string &LibraryPath() const { return _library_path; }
     void GetInstanceExtensionProperties(std::vector<XrExtensionProperties> &props);
     std::string GetFunctionName(const std::string &func_name) const;
+    // Estimated bytes held by the in-process cache of parsed manifest JSON, which outlives the manifests themselves.
+    static size_t CacheFootprint();
 
    protected:
     ManifestFile(ManifestFileType type, const std::string &filename, const std::string &library_path);
     void ParseCommon(Json::Value const &root_node);
+    void AddRenamedFunction(const std::string &func_name, const std::string &symbol_name);
+    void AddInstanceExtension(const std::string &name, uint32_t extension_version);
     static bool IsValidJson(const Json::Value &root, JsonVersion &version);
 
    private:
@@ -79,6 +84,10 @@ class RuntimeManifestFile : public ManifestFile {
     static void CreateIfValid(const std::string &filename, std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files);
     static void CreateIfValid(const Json::Value &root_node, const std::string &filename,
                               std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files);
+    // For a runtime that is described by the platform rather than a manifest file, with no instance extensions listed.
+    static void CreateFromLibrary(const std::string &library_path,
+                                  const std::vector<std::pair<std::string, std::string>> &renamed_functions,
+                                  std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files);
 };
 
 using LibraryLocator = bool (*)(const std::string &json_filename, const std::string &library_path, std::string &out_combined_path);
@@ -91,6 +100,11 @@ class ApiLayerManifestFile : public ManifestFile {
     static XrResult FindManifestFiles(const std::string &openxr_command, ManifestFileType type,
                                       std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files);
 
+#if defined(XR_LOADER_STATIC_CHAIN)
+    // Stand-ins for the manifests of the API layers linked into the loader, which are always enabled like implicit layers.
+    static void AddStaticChainManifestFiles(std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files);
+#endif  // defined(XR_LOADER_STATIC_CHAIN)
+
     const std::string &LayerName() const { return _layer_name; }
     void PopulateApiLayerProperties(XrApiLayerProperties &props) const;
 
@@ -99,10 +113,14 @@ class ApiLayerManifestFile : public ManifestFile {
                          const std::string &description, const JsonVersion &api_version, const uint32_t &implementation_version,
                          const std::string &library_path);
 
-    static void CreateIfValid(ManifestFileType type, const std::string &filename, std::istream &json_stream,
+    static void CreateIfValid(ManifestFileType type, const std::string &filename, const char *json_begin, const char *json_end,
+                              LibraryLocator locate_library, std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files);
+    static void CreateIfValid(ManifestFileType type, const std::string &filename, const Json::Value &root_node,
                               LibraryLocator locate_library, std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files);
     static void CreateIfValid(ManifestFileType type, const std::string &filename,
                               std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files);
+    static void CreateIfValidParallel(ManifestFileType type, const std::vector<std::string> &filenames,
+                                      std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files);
     /// @return false if we could not find the library.
     static bool LocateLibraryRelativeToJson(const std::string &json_filename, const std::string &library_path,
                                             std::string &out_combined_path);
@@ -0,0 +1,349 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+#include "manifest_reader.hpp"
+
+#include <json/json.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// Deeper nesting than this is not expected in a manifest, so leave it to jsoncpp.
+const int kMaxDepth = 32;
+
+class ManifestReader {
+   public:
+    ManifestReader(const char *begin, const char *end) : _cur(begin), _end(end) {}
+
+    bool ParseRoot(Json::Value &root_node) {
+        SkipWhitespace();
+        if (!Consume('{')) {
+            return false;
+        }
+        root_node = Json::Value(Json::objectValue);
+        SkipWhitespace();
+        if (!Consume('}')) {
+            do {
+                const char *key_begin = nullptr;
+                const char *key_end = nullptr;
+                SkipWhitespace();
+                if (AtTrailingComma('}')) {
+                    break;
+                }
+                if (!ReadRawString(key_begin, key_end)) {
+                    return false;
+                }
+                SkipWhitespace();
+                if (!Consume(':')) {
+                    return false;
+                }
+                SkipWhitespace();
+                if (IsInterestingKey(key_begin, key_end)) {
+                    if (!ParseValue(root_node[std::string(key_begin, key_end)], 1)) {
+                        return false;
+                    }
+                } else if (!SkipValue(1)) {
+                    return false;
+                }
+                SkipWhitespace();
+            } while (Consume(','));
+            if (!Consume('}')) {
+                return false;
+            }
+        }
+        SkipWhitespace();
+        return _cur == _end;
+    }
+
+   private:
+    static bool KeyEquals(const char *begin, const char *end, const char *key) {
+        const size_t length = static_cast<size_t>(end - begin);
+        return length == strlen(key) && memcmp(begin, key, length) == 0;
+    }
+
+    static bool IsInterestingKey(const char *begin, const char *end) {
+        return KeyEquals(begin, end, "file_format_version") || KeyEquals(begin, end, "runtime") ||
+               KeyEquals(begin, end, "api_layer");
+    }
+
+    void SkipWhitespace() {
+        while (_cur != _end && (*_cur == ' ' || *_cur == '\t' || *_cur == '\n' || *_cur == '\r')) {
+            ++_cur;
+        }
+    }
+
+    bool Consume(char c) {
+        if (_cur != _end && *_cur == c) {
+            ++_cur;
+            return true;
+        }
+        return false;
+    }
+
+    // jsoncpp accepts a comma before the closing bracket by default, so do the same.
+    bool AtTrailingComma(char close) const { return _cur != _end && *_cur == close; }
+
+    bool ConsumeLiteral(const char *literal) {
+        const size_t length = strlen(literal);
+        if (static_cast<size_t>(_end - _cur) < length || memcmp(_cur, literal, length) != 0) {
+            return false;
+        }
+        _cur += length;
+        return true;
+    }
+
+    // Scan a string token, returning the range between the quotes without decoding escapes.
+    bool ReadRawString(const char *&begin, const char *&end) {
+        if (!Consume('"')) {
+            return false;
+        }
+        begin = _cur;
+        while (_cur != _end && *_cur != '"') {
+            if (static_cast<unsigned char>(*_cur) < 0x20) {
+                return false;
+            }
+            if (*_cur == '\\') {
+                if (++_cur == _end) {
+                    return false;
+                }
+            }
+            ++_cur;
+        }
+        if (_cur == _end) {
+            return false;
+        }
+        end = _cur++;
+        return true;
+    }
+
+    bool ReadString(std::string &value) {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+        if (!ReadRawString(begin, end)) {
+            return false;
+        }
+        if (memchr(begin, '\\', static_cast<size_t>(end - begin)) == nullptr) {
+            value.assign(begin, end);
+            return true;
+        }
+        value.clear();
+        value.reserve(static_cast<size_t>(end - begin));
+        for (const char *c = begin; c != end; ++c) {
+            if (*c != '\\') {
+                value.push_back(*c);
+                continue;
+            }
+            switch (*++c) {
+                case '"':
+                case '\\':
+                case '/':
+                    value.push_back(*c);
+                    break;
+                case 'b':
+                    value.push_back('\b');
+                    break;
+                case 'f':
+                    value.push_back('\f');
+                    break;
+                case 'n':
+                    value.push_back('\n');
+                    break;
+                case 'r':
+                    value.push_back('\r');
+                    break;
+                case 't':
+                    value.push_back('\t');
+                    break;
+                default:
+                    // \u escapes are rare enough in manifests to leave to jsoncpp.
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool ReadInteger(Json::Value &value) {
+        const bool negative = Consume('-');
+        if (_cur == _end || *_cur < '0' || *_cur > '9') {
+            return false;
+        }
+        uint64_t magnitude = 0;
+        while (_cur != _end && *_cur >= '0' && *_cur <= '9') {
+            const uint64_t digit = static_cast<uint64_t>(*_cur - '0');
+            if (magnitude > (UINT64_MAX - digit) / 10) {
+                return false;
+            }
+            magnitude = magnitude * 10 + digit;
+            ++_cur;
+        }
+        if (_cur != _end && (*_cur == '.' || *_cur == 'e' || *_cur == 'E')) {
+            return false;
+        }
+        if (negative) {
+            if (magnitude > static_cast<uint64_t>(INT64_MAX)) {
+                return false;
+            }
+            value = Json::Value(static_cast<Json::Int64>(-static_cast<int64_t>(magnitude)));
+        } else if (magnitude <= static_cast<uint64_t>(INT64_MAX)) {
+            // Match the value types jsoncpp picks for the same text.
+            value = Json::Value(static_cast<Json::Int64>(magnitude));
+        } else {
+            value = Json::Value(static_cast<Json::UInt64>(magnitude));
+        }
+        return true;
+    }
+
+    bool ParseValue(Json::Value &value, int depth) {
+        if (_cur == _end || depth > kMaxDepth) {
+            return false;
+        }
+        switch (*_cur) {
+            case '{': {
+                ++_cur;
+                value = Json::Value(Json::objectValue);
+                SkipWhitespace();
+                if (Consume('}')) {
+                    return true;
+                }
+                std::string key;
+                do {
+                    SkipWhitespace();
+                    if (AtTrailingComma('}')) {
+                        break;
+                    }
+                    if (!ReadString(key)) {
+                        return false;
+                    }
+                    SkipWhitespace();
+                    if (!Consume(':')) {
+                        return false;
+                    }
+                    SkipWhitespace();
+                    if (!ParseValue(value[key], depth + 1)) {
+                        return false;
+                    }
+                    SkipWhitespace();
+                } while (Consume(','));
+                return Consume('}');
+            }
+            case '[': {
+                ++_cur;
+                value = Json::Value(Json::arrayValue);
+                SkipWhitespace();
+                if (Consume(']')) {
+                    return true;
+                }
+                do {
+                    SkipWhitespace();
+                    if (AtTrailingComma(']')) {
+                        break;
+                    }
+                    if (!ParseValue(value.append(Json::Value()), depth + 1)) {
+                        return false;
+                    }
+                    SkipWhitespace();
+                } while (Consume(','));
+                return Consume(']');
+            }
+            case '"': {
+                std::string str;
+                if (!ReadString(str)) {
+                    return false;
+                }
+                value = Json::Value(str);
+                return true;
+            }
+            case 't':
+                value = Json::Value(true);
+                return ConsumeLiteral("true");
+            case 'f':
+                value = Json::Value(false);
+                return ConsumeLiteral("false");
+            case 'n':
+                value = Json::Value(Json::nullValue);
+                return ConsumeLiteral("null");
+            default:
+                return ReadInteger(value);
+        }
+    }
+
+    // Validate and step over a value without building anything.
+    bool SkipValue(int depth) {
+        if (_cur == _end || depth > kMaxDepth) {
+            return false;
+        }
+        const char *begin = nullptr;
+        const char *end = nullptr;
+        switch (*_cur) {
+            case '{':
+                ++_cur;
+                SkipWhitespace();
+                if (Consume('}')) {
+                    return true;
+                }
+                do {
+                    SkipWhitespace();
+                    if (AtTrailingComma('}')) {
+                        break;
+                    }
+                    if (!ReadRawString(begin, end)) {
+                        return false;
+                    }
+                    SkipWhitespace();
+                    if (!Consume(':')) {
+                        return false;
+                    }
+                    SkipWhitespace();
+                    if (!SkipValue(depth + 1)) {
+                        return false;
+                    }
+                    SkipWhitespace();
+                } while (Consume(','));
+                return Consume('}');
+            case '[':
+                ++_cur;
+                SkipWhitespace();
+                if (Consume(']')) {
+                    return true;
+                }
+                do {
+                    SkipWhitespace();
+                    if (AtTrailingComma(']')) {
+                        break;
+                    }
+                    if (!SkipValue(depth + 1)) {
+                        return false;
+                    }
+                    SkipWhitespace();
+                } while (Consume(','));
+                return Consume(']');
+            case '"':
+                return ReadRawString(begin, end);
+            case 't':
+                return ConsumeLiteral("true");
+            case 'f':
+                return ConsumeLiteral("false");
+            case 'n':
+                return ConsumeLiteral("null");
+            default: {
+                Json::Value ignored;
+                return ReadInteger(ignored);
+            }
+        }
+    }
+
+    const char *_cur;
+    const char *_end;
+};
+
+}  // namespace
+
+bool ManifestReaderParse(const char *begin, const char *end, Json::Value &root_node) {
+    ManifestReader reader(begin, end);
+    return reader.ParseRoot(root_node);
+}
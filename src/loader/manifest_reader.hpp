@@ -0,0 +1,21 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+#pragma once
+
+#include <cstddef>
+
+namespace Json {
+class Value;
+}
+
+// Pull-style reader for the subset of JSON used by runtime and API layer manifests.
+//
+// The buffer is scanned in place and only the top-level members the loader consumes ("file_format_version",
+// "runtime" and "api_layer") are materialized into root_node; every other member is skipped without
+// allocating.  Returns false if the buffer is malformed or uses something the reader does not handle
+// (comments, \u escapes, non-integer numbers, a byte order mark, ...), in which case the caller should
+// fall back to jsoncpp, which also produces the error message.
+bool ManifestReaderParse(const char *begin, const char *end, Json::Value &root_node);
@@ -17,20 +17,21 @@
 #include "loader_logger.hpp"
 #include "loader_platform.hpp"
 #include "loader_properties.hpp"
+#include "static_chain.hpp"
 #include "xr_generated_dispatch_table_core.h"
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #if defined(XR_USE_PLATFORM_ANDROID) && defined(XR_HAS_REQUIRED_PLATFORM_LOADER_INIT_STRUCT)
-#include <json/value.h>
-
-XrResult GetPlatformRuntimeVirtualManifest(Json::Value& out_manifest) {
+XrResult GetPlatformActiveRuntime(openxr_android::ActiveRuntime& out_runtime) {
     using wrap::android::content::Context;
     auto& initData = LoaderInitData::instance();
     if (!initData.initialized()) {
@@ -40,18 +41,20 @@ XrResult GetPlatformRuntimeVirtualManifest(Json::Value& out_manifest) {
     if (context.isNull()) {
         return XR_ERROR_INITIALIZATION_FAILED;
     }
-    Json::Value virtualManifest;
-    if (0 != openxr_android::getActiveRuntimeVirtualManifest(context, virtualManifest)) {
+    if (0 != openxr_android::getActiveRuntime(context, out_runtime)) {
         return XR_ERROR_INITIALIZATION_FAILED;
     }
-    out_manifest = virtualManifest;
     return XR_SUCCESS;
 }
 #endif  // defined(XR_USE_PLATFORM_ANDROID) && defined(XR_HAS_REQUIRED_PLATFORM_LOADER_INIT_STRUCT)
 
 XrResult RuntimeInterface::TryLoadingSingleRuntime(const std::string& openxr_command,
                                                    std::unique_ptr<RuntimeManifestFile>& manifest_file) {
-    LoaderPlatformLibraryHandle runtime_library = LoaderPlatformLibraryOpen(manifest_file->LibraryPath());
+    LoaderPlatformLibraryHandle runtime_library = nullptr;
+    {
+        LoaderPhaseTimer timer(openxr_command.c_str(), "runtime_library_load", manifest_file->LibraryPath());
+        runtime_library = LoaderPlatformLibraryOpen(manifest_file->LibraryPath());
+    }
     if (nullptr == runtime_library) {
         std::string library_message = LoaderPlatformLibraryOpenError(manifest_file->LibraryPath());
         std::string warning_message = "RuntimeInterface::LoadRuntime skipping manifest file ";
@@ -103,6 +106,14 @@ XrResult RuntimeInterface::TryLoadingSingleRuntime(const std::string& openxr_com
     auto negotiate =
         reinterpret_cast<PFN_xrNegotiateLoaderRuntimeInterface>(LoaderPlatformLibraryGetProcAddr(runtime_library, function_name));
 
+    return NegotiateRuntime(openxr_command, "manifest file " + manifest_file->Filename(), runtime_library, negotiate,
+                            function_name, forwardedInitLoader);
+}
+
+XrResult RuntimeInterface::NegotiateRuntime(const std::string& openxr_command, const std::string& description,
+                                            LoaderPlatformLibraryHandle runtime_library,
+                                            PFN_xrNegotiateLoaderRuntimeInterface negotiate, const std::string& function_name,
+                                            bool forwardedInitLoader) {
     // Loader info for negotiation
     XrNegotiateLoaderInfo loader_info = {};
     loader_info.structType = XR_LOADER_INTERFACE_STRUCT_LOADER_INFO;
@@ -123,6 +134,7 @@ XrResult RuntimeInterface::TryLoadingSingleRuntime(const std::string& openxr_com
     // could not get loaded
     XrResult res = XR_ERROR_RUNTIME_FAILURE;
     if (nullptr != negotiate) {
+        LoaderPhaseTimer timer(openxr_command.c_str(), "runtime_negotiate", description);
         res = negotiate(&loader_info, &runtime_info);
     } else {
         std::string error_message = "RuntimeInterface::LoadRuntime failed to find negotiate function ";
@@ -136,21 +148,21 @@ XrResult RuntimeInterface::TryLoadingSingleRuntime(const std::string& openxr_com
         uint32_t runtime_minor = XR_VERSION_MINOR(runtime_info.runtimeApiVersion);
         uint32_t loader_major = XR_VERSION_MAJOR(XR_CURRENT_API_VERSION);
         if (nullptr == runtime_info.getInstanceProcAddr) {
-            std::string error_message = "RuntimeInterface::LoadRuntime skipping manifest file ";
-            error_message += manifest_file->Filename();
+            std::string error_message = "RuntimeInterface::LoadRuntime skipping ";
+            error_message += description;
             error_message += ", negotiation succeeded but returned NULL getInstanceProcAddr";
             LoaderLogger::LogErrorMessage(openxr_command, error_message);
             res = XR_ERROR_FILE_CONTENTS_INVALID;
         } else if (0 >= runtime_info.runtimeInterfaceVersion ||
                    XR_CURRENT_LOADER_RUNTIME_VERSION < runtime_info.runtimeInterfaceVersion) {
-            std::string error_message = "RuntimeInterface::LoadRuntime skipping manifest file ";
-            error_message += manifest_file->Filename();
+            std::string error_message = "RuntimeInterface::LoadRuntime skipping ";
+            error_message += description;
             error_message += ", negotiation succeeded but returned invalid interface version";
             LoaderLogger::LogErrorMessage(openxr_command, error_message);
             res = XR_ERROR_FILE_CONTENTS_INVALID;
         } else if (runtime_major != loader_major || (runtime_major == 0 && runtime_minor == 0)) {
-            std::string error_message = "RuntimeInterface::LoadRuntime skipping manifest file ";
-            error_message += manifest_file->Filename();
+            std::string error_message = "RuntimeInterface::LoadRuntime skipping ";
+            error_message += description;
             error_message += ", OpenXR version returned not compatible with this loader";
             LoaderLogger::LogErrorMessage(openxr_command, error_message);
             res = XR_ERROR_FILE_CONTENTS_INVALID;
@@ -187,8 +199,8 @@ XrResult RuntimeInterface::TryLoadingSingleRuntime(const std::string& openxr_com
     }
 
     if (XR_FAILED(res)) {
-        std::string warning_message = "RuntimeInterface::LoadRuntime skipping manifest file ";
-        warning_message += manifest_file->Filename();
+        std::string warning_message = "RuntimeInterface::LoadRuntime skipping ";
+        warning_message += description;
         warning_message += ", negotiation failed with error ";
         warning_message += std::to_string(res);
         LoaderLogger::LogErrorMessage(openxr_command, warning_message);
@@ -196,8 +208,8 @@ XrResult RuntimeInterface::TryLoadingSingleRuntime(const std::string& openxr_com
         return res;
     }
 
-    std::string info_message = "RuntimeInterface::LoadRuntime succeeded loading runtime defined in manifest file ";
-    info_message += manifest_file->Filename();
+    std::string info_message = "RuntimeInterface::LoadRuntime succeeded loading runtime defined in ";
+    info_message += description;
     info_message += " using interface version ";
     info_message += std::to_string(runtime_info.runtimeInterfaceVersion);
     info_message += " and OpenXR API version ";
@@ -209,16 +221,9 @@ XrResult RuntimeInterface::TryLoadingSingleRuntime(const std::string& openxr_com
     // Use this runtime
     GetInstance().reset(new RuntimeInterface(runtime_library, runtime_info.getInstanceProcAddr));
 
-    // Grab the list of extensions this runtime supports for easy filtering after the
+    // Grab the list of extensions this runtime supports, once, for enumeration and for filtering after the
     // xrCreateInstance call
-    std::vector<std::string> supported_extensions;
-    std::vector<XrExtensionProperties> extension_properties;
-    GetInstance()->GetInstanceExtensionProperties(extension_properties);
-    supported_extensions.reserve(extension_properties.size());
-    for (XrExtensionProperties ext_prop : extension_properties) {
-        supported_extensions.emplace_back(ext_prop.extensionName);
-    }
-    GetInstance()->SetSupportedExtensions(supported_extensions);
+    GetInstance()->QueryExtensionProperties();
 
     return XR_SUCCESS;
 }
@@ -237,6 +242,12 @@ XrResult RuntimeInterface::LoadRuntime(const std::string& openxr_command) {
     }
 #endif  // XR_HAS_REQUIRED_PLATFORM_LOADER_INIT_STRUCT
 
+#if defined(XR_LOADER_STATIC_CHAIN)
+    // The runtime is linked into the loader, so there is no manifest to find and no library to load.
+    XrResult last_error = RuntimeInterface::NegotiateRuntime(openxr_command, "the static chain", nullptr,
+                                                             StaticChainRuntimeNegotiate(), "xrNegotiateLoaderRuntimeInterface",
+                                                             false);
+#else
     std::vector<std::unique_ptr<RuntimeManifestFile>> runtime_manifest_files = {};
 
     // Find the available runtimes which we may need to report information for.
@@ -252,6 +263,7 @@ XrResult RuntimeInterface::LoadRuntime(const std::string& openxr_command) {
             }
         }
     }
+#endif  // defined(XR_LOADER_STATIC_CHAIN)
 
     // Unsuccessful in loading any runtime, throw the runtime unavailable message.
     if (XR_FAILED(last_error)) {
@@ -274,11 +286,17 @@ XrResult RuntimeInterface::GetInstanceProcAddr(XrInstance instance, const char*
 }
 
 const XrGeneratedDispatchTableCore* RuntimeInterface::GetDispatchTable(XrInstance instance) {
+    RuntimeInterface* runtime = GetInstance().get();
+    const InstanceDispatchTable* single = runtime->_single_dispatch_table.load(std::memory_order_acquire);
+    if (single != nullptr && single->instance == instance) {
+        return single->table.get();
+    }
+
     XrGeneratedDispatchTableCore* table = nullptr;
-    std::lock_guard<std::mutex> mlock(GetInstance()->_dispatch_table_mutex);
-    auto it = GetInstance()->_dispatch_table_map.find(instance);
-    if (it != GetInstance()->_dispatch_table_map.end()) {
-        table = it->second.get();
+    std::shared_lock<std::shared_timed_mutex> mlock(runtime->_dispatch_table_mutex);
+    auto it = runtime->_dispatch_table_map.find(instance);
+    if (it != runtime->_dispatch_table_map.end()) {
+        table = it->second->table.get();
     }
     return table;
 }
@@ -286,7 +304,7 @@ const XrGeneratedDispatchTableCore* RuntimeInterface::GetDispatchTable(XrInstanc
 const XrGeneratedDispatchTableCore* RuntimeInterface::GetDebugUtilsMessengerDispatchTable(XrDebugUtilsMessengerEXT messenger) {
     XrInstance runtime_instance = XR_NULL_HANDLE;
     {
-        std::lock_guard<std::mutex> mlock(GetInstance()->_messenger_to_instance_mutex);
+        std::shared_lock<std::shared_timed_mutex> mlock(GetInstance()->_messenger_to_instance_mutex);
         auto it = GetInstance()->_messenger_to_instance_map.find(messenger);
         if (it != GetInstance()->_messenger_to_instance_map.end()) {
             runtime_instance = it->second;
@@ -295,21 +313,52 @@ const XrGeneratedDispatchTableCore* RuntimeInterface::GetDebugUtilsMessengerDisp
     return GetDispatchTable(runtime_instance);
 }
 
+void RuntimeInterface::UpdateSingleDispatchTable() {
+    const InstanceDispatchTable* single = nullptr;
+    if (_dispatch_table_map.size() == 1) {
+        single = _dispatch_table_map.begin()->second.get();
+    }
+    _single_dispatch_table.store(single, std::memory_order_release);
+}
+
+size_t RuntimeInterface::Footprint() {
+    // Each unordered_map node holds its value and a next pointer, and each bucket one pointer.
+    size_t bytes = _extension_properties.capacity() * sizeof(XrExtensionProperties);
+    {
+        std::shared_lock<std::shared_timed_mutex> mlock(_dispatch_table_mutex);
+        bytes += _dispatch_table_map.bucket_count() * sizeof(void*) +
+                 _dispatch_table_map.size() * (sizeof(decltype(_dispatch_table_map)::value_type) + sizeof(void*) +
+                                               sizeof(InstanceDispatchTable) + sizeof(XrGeneratedDispatchTableCore));
+    }
+    {
+        std::shared_lock<std::shared_timed_mutex> mlock(_messenger_to_instance_mutex);
+        bytes += _messenger_to_instance_map.bucket_count() * sizeof(void*) +
+                 _messenger_to_instance_map.size() * (sizeof(decltype(_messenger_to_instance_map)::value_type) + sizeof(void*));
+    }
+    return bytes;
+}
+
 RuntimeInterface::RuntimeInterface(LoaderPlatformLibraryHandle runtime_library, PFN_xrGetInstanceProcAddr get_instance_proc_addr)
-    : _runtime_library(runtime_library), _get_instance_proc_addr(get_instance_proc_addr) {}
+    : _runtime_library(runtime_library), _get_instance_proc_addr(get_instance_proc_addr), _generation(NextGeneration()) {}
 
 RuntimeInterface::~RuntimeInterface() {
     std::string info_message = "RuntimeInterface being destroyed.";
     LoaderLogger::LogInfoMessage("", info_message);
     {
-        std::lock_guard<std::mutex> mlock(_dispatch_table_mutex);
+        std::unique_lock<std::shared_timed_mutex> mlock(_dispatch_table_mutex);
         _dispatch_table_map.clear();
+        UpdateSingleDispatchTable();
     }
     LoaderPlatformLibraryClose(_runtime_library);
 }
 
-void RuntimeInterface::GetInstanceExtensionProperties(std::vector<XrExtensionProperties>& extension_properties) {
-    std::vector<XrExtensionProperties> runtime_extension_properties;
+uint64_t RuntimeInterface::NextGeneration() {
+    static std::atomic<uint64_t> generation{0};
+    return ++generation;
+}
+
+void RuntimeInterface::QueryExtensionProperties() {
+    std::vector<XrExtensionProperties>& runtime_extension_properties = _extension_properties;
     PFN_xrEnumerateInstanceExtensionProperties rt_xrEnumerateInstanceExtensionProperties;
     _get_instance_proc_addr(XR_NULL_HANDLE, "xrEnumerateInstanceExtensionProperties",
                             reinterpret_cast<PFN_xrVoidFunction*>(&rt_xrEnumerateInstanceExtensionProperties));
@@ -323,7 +372,16 @@ void RuntimeInterface::GetInstanceExtensionProperties(std::vector<XrExtensionPro
         runtime_extension_properties.resize(count_output, example_properties);
         count = count_output;
         rt_xrEnumerateInstanceExtensionProperties(nullptr, count, &count_output, runtime_extension_properties.data());
+        runtime_extension_properties.resize(std::min(count, count_output));
     }
+    std::stable_sort(runtime_extension_properties.begin(), runtime_extension_properties.end(),
+                     [](const XrExtensionProperties& a, const XrExtensionProperties& b) {
+                         return strcmp(a.extensionName, b.extensionName) < 0;
+                     });
+}
+
+void RuntimeInterface::GetInstanceExtensionProperties(std::vector<XrExtensionProperties>& extension_properties) const {
+    const std::vector<XrExtensionProperties>& runtime_extension_properties = _extension_properties;
     size_t ext_count = runtime_extension_properties.size();
     size_t props_count = extension_properties.size();
     for (size_t ext = 0; ext < ext_count; ++ext) {
@@ -349,13 +407,18 @@ XrResult RuntimeInterface::CreateInstance(const XrInstanceCreateInfo* info, XrIn
     bool create_succeeded = false;
     PFN_xrCreateInstance rt_xrCreateInstance;
     _get_instance_proc_addr(XR_NULL_HANDLE, "xrCreateInstance", reinterpret_cast<PFN_xrVoidFunction*>(&rt_xrCreateInstance));
-    res = rt_xrCreateInstance(info, instance);
+    {
+        LoaderPhaseTimer timer("xrCreateInstance", "runtime_create_instance");
+        res = rt_xrCreateInstance(info, instance);
+    }
     if (XR_SUCCEEDED(res)) {
         create_succeeded = true;
-        std::unique_ptr<XrGeneratedDispatchTableCore> dispatch_table(new XrGeneratedDispatchTableCore());
-        GeneratedXrPopulateDispatchTableCore(dispatch_table.get(), *instance, _get_instance_proc_addr);
-        std::lock_guard<std::mutex> mlock(_dispatch_table_mutex);
+        std::unique_ptr<XrGeneratedDispatchTableCore> table(new XrGeneratedDispatchTableCore());
+        std::unique_ptr<InstanceDispatchTable> dispatch_table(new InstanceDispatchTable{*instance, std::move(table)});
+        GeneratedXrPopulateDispatchTableCoreLazy(dispatch_table->table.get(), *instance, _get_instance_proc_addr);
+        std::unique_lock<std::shared_timed_mutex> mlock(_dispatch_table_mutex);
         _dispatch_table_map[*instance] = std::move(dispatch_table);
+        UpdateSingleDispatchTable();
     }
 
     // If the failure occurred during the populate, clean up the instance we had picked up from the runtime
@@ -373,11 +436,12 @@ XrResult RuntimeInterface::DestroyInstance(XrInstance instance) {
     if (XR_NULL_HANDLE != instance) {
         // Destroy the dispatch table for this instance first
         {
-            std::lock_guard<std::mutex> mlock(_dispatch_table_mutex);
+            std::unique_lock<std::shared_timed_mutex> mlock(_dispatch_table_mutex);
             auto map_iter = _dispatch_table_map.find(instance);
             if (map_iter != _dispatch_table_map.end()) {
                 _dispatch_table_map.erase(map_iter);
             }
+            UpdateSingleDispatchTable();
         }
         // Now delete the instance
         PFN_xrDestroyInstance rt_xrDestroyInstance;
@@ -388,29 +452,21 @@ XrResult RuntimeInterface::DestroyInstance(XrInstance instance) {
 }
 
 bool RuntimeInterface::TrackDebugMessenger(XrInstance instance, XrDebugUtilsMessengerEXT messenger) {
-    std::lock_guard<std::mutex> mlock(_messenger_to_instance_mutex);
+    std::unique_lock<std::shared_timed_mutex> mlock(_messenger_to_instance_mutex);
     _messenger_to_instance_map[messenger] = instance;
     return true;
 }
 
 void RuntimeInterface::ForgetDebugMessenger(XrDebugUtilsMessengerEXT messenger) {
     if (XR_NULL_HANDLE != messenger) {
-        std::lock_guard<std::mutex> mlock(_messenger_to_instance_mutex);
+        std::unique_lock<std::shared_timed_mutex> mlock(_messenger_to_instance_mutex);
         _messenger_to_instance_map.erase(messenger);
     }
 }
 
-void RuntimeInterface::SetSupportedExtensions(std::vector<std::string>& supported_extensions) {
-    _supported_extensions = supported_extensions;
-}
-
-bool RuntimeInterface::SupportsExtension(const std::string& extension_name) {
-    bool found_prop = false;
-    for (const std::string& supported_extension : _supported_extensions) {
-        if (supported_extension == extension_name) {
-            found_prop = true;
-            break;
-        }
-    }
-    return found_prop;
+bool RuntimeInterface::SupportsExtension(const char* extension_name) const {
+    auto it = std::lower_bound(
+        _extension_properties.begin(), _extension_properties.end(), extension_name,
+        [](const XrExtensionProperties& prop, const char* name) { return strcmp(prop.extensionName, name) < 0; });
+    return it != _extension_properties.end() && strcmp(it->extensionName, extension_name) == 0;
 }
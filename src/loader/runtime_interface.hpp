@@ -12,12 +12,15 @@
 #include "loader_platform.hpp"
 
 #include <openxr/openxr.h>
+#include <openxr/openxr_loader_negotiation.h>
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <mutex>
 #include <memory>
+#include <shared_mutex>
 
 namespace Json {
 class Value;
@@ -40,12 +43,21 @@ class RuntimeInterface {
     static const XrGeneratedDispatchTableCore* GetDispatchTable(XrInstance instance);
     static const XrGeneratedDispatchTableCore* GetDebugUtilsMessengerDispatchTable(XrDebugUtilsMessengerEXT messenger);
 
-    void GetInstanceExtensionProperties(std::vector<XrExtensionProperties>& extension_properties);
-    bool SupportsExtension(const std::string& extension_name);
+    // Merge the runtime's instance extensions into extension_properties, with the runtime's versions.  They are queried
+    // once, when the runtime is loaded.
+    void GetInstanceExtensionProperties(std::vector<XrExtensionProperties>& extension_properties) const;
+    // The runtime's instance extensions, sorted by name.
+    const std::vector<XrExtensionProperties>& ExtensionProperties() const { return _extension_properties; }
+    bool SupportsExtension(const char* extension_name) const;
+    // Different for each runtime loaded during the life of the process, so anything derived from one can be reused
+    // until it is unloaded.
+    uint64_t Generation() const { return _generation; }
     XrResult CreateInstance(const XrInstanceCreateInfo* info, XrInstance* instance);
     XrResult DestroyInstance(XrInstance instance);
     bool TrackDebugMessenger(XrInstance instance, XrDebugUtilsMessengerEXT messenger);
     void ForgetDebugMessenger(XrDebugUtilsMessengerEXT messenger);
+    // Estimated bytes held for the instances of this runtime: dispatch tables, messenger map and extension list.
+    size_t Footprint();
 
     // No default construction
     RuntimeInterface() = delete;
@@ -56,8 +68,13 @@ class RuntimeInterface {
 
    private:
     RuntimeInterface(LoaderPlatformLibraryHandle runtime_library, PFN_xrGetInstanceProcAddr get_instance_proc_addr);
-    void SetSupportedExtensions(std::vector<std::string>& supported_extensions);
+    void QueryExtensionProperties();
+    static uint64_t NextGeneration();
     static XrResult TryLoadingSingleRuntime(const std::string& openxr_command, std::unique_ptr<RuntimeManifestFile>& manifest_file);
+    // Negotiate with a runtime found in a manifest, or linked into the loader with a null runtime_library.
+    static XrResult NegotiateRuntime(const std::string& openxr_command, const std::string& description,
+                                     LoaderPlatformLibraryHandle runtime_library, PFN_xrNegotiateLoaderRuntimeInterface negotiate,
+                                     const std::string& function_name, bool forwardedInitLoader);
 
     static std::unique_ptr<RuntimeInterface>& GetInstance() {
         static std::unique_ptr<RuntimeInterface> instance;
@@ -66,9 +83,22 @@ class RuntimeInterface {
 
     LoaderPlatformLibraryHandle _runtime_library;
     PFN_xrGetInstanceProcAddr _get_instance_proc_addr;
-    std::unordered_map<XrInstance, std::unique_ptr<XrGeneratedDispatchTableCore>> _dispatch_table_map;
-    std::mutex _dispatch_table_mutex;
+    // A dispatch table together with the instance it belongs to, so the single-instance fast path can check
+    // both with one atomic load.
+    struct InstanceDispatchTable {
+        XrInstance instance;
+        std::unique_ptr<XrGeneratedDispatchTableCore> table;
+    };
+
+    // Must be called with _dispatch_table_mutex held exclusively.
+    void UpdateSingleDispatchTable();
+
+    std::unordered_map<XrInstance, std::unique_ptr<InstanceDispatchTable>> _dispatch_table_map;
+    std::shared_timed_mutex _dispatch_table_mutex;
+    // Set while exactly one dispatch table exists, which is the common case, so lookups skip the lock.
+    std::atomic<const InstanceDispatchTable*> _single_dispatch_table{nullptr};
     std::unordered_map<XrDebugUtilsMessengerEXT, XrInstance> _messenger_to_instance_map;
-    std::mutex _messenger_to_instance_mutex;
-    std::vector<std::string> _supported_extensions;
+    std::shared_timed_mutex _messenger_to_instance_mutex;
+    std::vector<XrExtensionProperties> _extension_properties;
+    const uint64_t _generation;
 };
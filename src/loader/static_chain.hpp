@@ -0,0 +1,42 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+#pragma once
+
+#if defined(XR_LOADER_STATIC_CHAIN)
+
+#include <openxr/openxr.h>
+#include <openxr/openxr_loader_negotiation.h>
+
+#include <string>
+#include <vector>
+
+// With BUILD_LOADER_STATIC_CHAIN, the runtime and API layers are linked into the loader, in a chain fixed when the
+// loader is built, instead of being found through manifest files and loaded as libraries.  The definitions are in
+// the xr_static_chain.cpp that CMake generates from static_chain.cpp.in.
+
+struct StaticChainApiLayer {
+    std::string layer_name;
+    PFN_xrNegotiateLoaderApiLayerInterface negotiate;
+    std::vector<std::string> instance_extensions;
+};
+
+// The negotiate function of the runtime.
+PFN_xrNegotiateLoaderRuntimeInterface StaticChainRuntimeNegotiate();
+
+// The API layers, closest to the application first.
+const std::vector<StaticChainApiLayer>& StaticChainApiLayers();
+
+// The API layer with this name, or nullptr if it is not in the chain.
+inline const StaticChainApiLayer* FindStaticChainApiLayer(const std::string& layer_name) {
+    for (const StaticChainApiLayer& layer : StaticChainApiLayers()) {
+        if (layer.layer_name == layer_name) {
+            return &layer;
+        }
+    }
+    return nullptr;
+}
+
+#endif  // defined(XR_LOADER_STATIC_CHAIN)
@@ -48,6 +48,17 @@ LOADER_STRUCTS = [
     'XrNegotiateApiLayerRequest',
 ]
 
+LOADER_ENUMS = [
+    'XrLoaderInterfaceStructs',
+]
+
+# Outputs, besides created handles, that binary captures record for openxr_replay: (type, name, expression) by command.
+RECORDED_OUTPUTS = {
+    'xrGetSystem': [('XrSystemId', '*systemId', 'std::to_string(*systemId)')],
+    'xrStringToPath': [('XrPath', '*path', 'std::to_string(*path)')],
+    'xrWaitFrame': [('XrTime', 'frameState->predictedDisplayTime', 'std::to_string(frameState->predictedDisplayTime)')],
+}
+
 # ApiDumpOutputGenerator - subclass of AutomaticSourceOutputGenerator.
 
 
@@ -73,6 +84,8 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
         if self.genOpts.filename == 'xr_generated_api_dump.hpp':
             preamble += '#pragma once\n\n'
             preamble += '#include "api_layer_platform_defines.h"\n'
+            preamble += '#include "api_dump_dispatch_map.h"\n'
+            preamble += '#include "hex_and_handles.h"\n'
             preamble += '#include <openxr/openxr.h>\n'
             preamble += '#include <openxr/openxr_platform.h>\n\n'
             preamble += '#include <mutex>\n'
@@ -84,7 +97,8 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
         elif self.genOpts.filename == 'xr_generated_api_dump.cpp':
             preamble += '#include "xr_generated_api_dump.hpp"\n'
             preamble += '#include "xr_generated_dispatch_table.h"\n'
-            preamble += '#include "hex_and_handles.h"\n\n'
+            preamble += '#include "hex_and_handles.h"\n'
+            preamble += '#include "platform_trace.hpp"\n\n'
             preamble += '#include <cstring>\n'
             preamble += '#include <mutex>\n'
             preamble += '#include <sstream>\n'
@@ -100,6 +114,7 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
         if self.genOpts.filename == 'xr_generated_api_dump.hpp':
             file_data += self.outputLayerHeaderPrototypes()
             file_data += self.outputApiDumpExterns()
+            file_data += self.outputApiDumpNameFuncs()
 
         elif self.genOpts.filename == 'xr_generated_api_dump.cpp':
             file_data += self.outputApiDumpMapMutexItems()
@@ -120,9 +135,7 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
             base_handle_name = undecorate(handle.name)
             if handle.protect_value is not None:
                 externs += f'#if {handle.protect_string}\n'
-            externs += 'extern std::unordered_map<%s, XrGeneratedDispatchTable*> g_%s_dispatch_map;\n' % (
-                handle.name, base_handle_name)
-            externs += f'extern std::mutex g_{base_handle_name}_dispatch_mutex;\n'
+            externs += f'extern ApiDumpDispatchMap<{handle.name}> g_{base_handle_name}_dispatch_map;\n'
             if handle.protect_value is not None:
                 externs += f'#endif // {handle.protect_string}\n'
         externs += 'void ApiDumpCleanUpMapsForTable(XrGeneratedDispatchTable *table);\n'
@@ -139,6 +152,11 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
         generated_prototypes += 'PFN_xrVoidFunction ApiDumpLayerInnerGetInstanceProcAddr(const char* name);\n\n'
         generated_prototypes += '// Api Dump Log Command\n'
         generated_prototypes += 'bool ApiDumpLayerRecordContent(std::vector<std::tuple<std::string, std::string, std::string>> contents);\n\n'
+        generated_prototypes += '// Api Dump flight recorder triggers\n'
+        generated_prototypes += 'void ApiDumpLayerRecordFailure(const char* command_name, XrResult result);\n'
+        generated_prototypes += 'void ApiDumpLayerRecordTrigger(const char* message_id, const char* message);\n\n'
+        generated_prototypes += '// Api Dump outputs of a call, for binary captures\n'
+        generated_prototypes += 'void ApiDumpLayerRecordOutputs(std::vector<std::tuple<std::string, std::string, std::string>> contents);\n\n'
         generated_prototypes += '// Api Dump Manual Functions\n'
         generated_prototypes += 'XrInstance FindInstanceFromDispatchTable(XrGeneratedDispatchTable* dispatch_table);\n'
         generated_prototypes += 'XRAPI_ATTR XrResult XRAPI_CALL ApiDumpLayerXrCreateInstance(const XrInstanceCreateInfo *info,\n'
@@ -169,10 +187,9 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                 generated_prototypes += f'#endif // {xr_struct.protect_string}\n'
         return generated_prototypes
 
-    # Output the unordered_map's required to track all the data we need per handle type.  Also, create
-    # a mutex that allows us to access the unordered_maps in a thread-safe manner.  Finally, wrap it
-    # all up by creating utility functions for cleaning up a dispatch table when it's instance has
-    # been deleted.
+    # Output the maps required to track the dispatch table of each handle, per handle type.  Finally,
+    # wrap it all up by creating a utility function for cleaning up a dispatch table when it's instance
+    # has been deleted.
     #   self            the ApiDumpOutputGenerator object
     def outputApiDumpMapMutexItems(self):
         maps_mutexes = ''
@@ -180,41 +197,94 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
             base_handle_name = undecorate(handle.name)
             if handle.protect_value:
                 maps_mutexes += f'#if {handle.protect_string}\n'
-            maps_mutexes += 'std::unordered_map<%s, XrGeneratedDispatchTable*> g_%s_dispatch_map;\n' % (
-                handle.name, base_handle_name)
-            maps_mutexes += f'std::mutex g_{base_handle_name}_dispatch_mutex;\n'
+            maps_mutexes += f'ApiDumpDispatchMap<{handle.name}> g_{base_handle_name}_dispatch_map;\n'
             if handle.protect_value:
                 maps_mutexes += f'#endif // {handle.protect_string}\n'
         maps_mutexes += '\n'
-        maps_mutexes += '// Template function to reduce duplicating the map locking, searching, and deleting.`\n'
-        maps_mutexes += 'template <typename MapType>\n'
-        maps_mutexes += 'void eraseAllTableMapElements(MapType &search_map, std::mutex &mutex, XrGeneratedDispatchTable *search_value) {\n'
-        maps_mutexes += '    std::unique_lock<std::mutex> lock(mutex);\n'
-        maps_mutexes += '    for (auto it = search_map.begin(); it != search_map.end();) {\n'
-        maps_mutexes += '        if (it->second == search_value) {\n'
-        maps_mutexes += '            search_map.erase(it++);\n'
-        maps_mutexes += '        } else {\n'
-        maps_mutexes += '            ++it;\n'
-        maps_mutexes += '        }\n'
-        maps_mutexes += '    }\n'
-        maps_mutexes += '}\n'
-        maps_mutexes += '\n'
         maps_mutexes += '// Function used to clean up any residual map values that point to an instance prior to that\n'
         maps_mutexes += '// instance being deleted.\n'
         maps_mutexes += 'void ApiDumpCleanUpMapsForTable(XrGeneratedDispatchTable *table) {\n'
-        # Call each handle's erase utility function using the template we defined above.
         for handle in self.api_handles:
             base_handle_name = undecorate(handle.name)
             if handle.protect_value:
                 maps_mutexes += f'#if {handle.protect_string}\n'
-            maps_mutexes += f'    eraseAllTableMapElements<std::unordered_map<{handle.name}, XrGeneratedDispatchTable*>>'
-            maps_mutexes += f'(g_{base_handle_name}_dispatch_map, g_{base_handle_name}_dispatch_mutex, table);\n'
+            maps_mutexes += f'    g_{base_handle_name}_dispatch_map.EraseTable(table);\n'
             if handle.protect_value:
                 maps_mutexes += f'#endif // {handle.protect_string}\n'
         maps_mutexes += '}\n'
         maps_mutexes += '\n'
         return maps_mutexes
 
+    # Output the functions turning enum values and flags into their names.  The names are compiled in,
+    # so writing an enum costs no call down the chain (the runtime used to be asked for XrResult and
+    # XrStructureType names) and no formatting.
+    #   self            the ApiDumpOutputGenerator object
+    def outputApiDumpNameFuncs(self):
+        name_funcs = '\n// Names of enum values and flag bits\n'
+        for enum_tuple in self.api_enums:
+            if enum_tuple.name in LOADER_ENUMS:
+                continue
+            if enum_tuple.protect_value:
+                name_funcs += f'#if {enum_tuple.protect_string}\n'
+            name_funcs += f'inline std::string ApiDumpEnumToString({enum_tuple.name} value) {{\n'
+            name_funcs += '    switch (value) {\n'
+            for cur_value in enum_tuple.values:
+                # An alias would duplicate the case of the value it aliases.
+                if cur_value.alias:
+                    continue
+                value_protect = cur_value.protect_value and enum_tuple.protect_value != cur_value.protect_value
+                if value_protect:
+                    name_funcs += f'#if {cur_value.protect_string}\n'
+                name_funcs += f'        case {cur_value.name}:\n'
+                name_funcs += f'            return "{cur_value.name}";\n'
+                if value_protect:
+                    name_funcs += f'#endif // {cur_value.protect_string}\n'
+            name_funcs += '        default:\n'
+            name_funcs += '            return std::to_string(value);\n'
+            name_funcs += '    }\n'
+            name_funcs += '}\n\n'
+            if enum_tuple.protect_value:
+                name_funcs += f'#endif // {enum_tuple.protect_string}\n'
+
+        name_funcs += '// Flags are written as the names of their set bits joined by " | ", followed by any unknown bits in hex.\n'
+        name_funcs += 'inline void ApiDumpAppendFlagBit(XrFlags64 &value, XrFlags64 bit, const char *name, std::string &bits) {\n'
+        name_funcs += '    if ((value & bit) != 0) {\n'
+        name_funcs += '        if (!bits.empty()) {\n'
+        name_funcs += '            bits += " | ";\n'
+        name_funcs += '        }\n'
+        name_funcs += '        bits += name;\n'
+        name_funcs += '        value &= ~bit;\n'
+        name_funcs += '    }\n'
+        name_funcs += '}\n\n'
+        name_funcs += 'inline std::string ApiDumpFinishFlags(XrFlags64 unknown_bits, std::string &bits) {\n'
+        name_funcs += '    if (unknown_bits != 0) {\n'
+        name_funcs += '        ApiDumpAppendFlagBit(unknown_bits, unknown_bits, ToHexChars(unknown_bits).text, bits);\n'
+        name_funcs += '    } else if (bits.empty()) {\n'
+        name_funcs += '        bits = "0";\n'
+        name_funcs += '    }\n'
+        name_funcs += '    return bits;\n'
+        name_funcs += '}\n\n'
+        for flag_tuple in self.api_flags:
+            if flag_tuple.protect_value:
+                name_funcs += f'#if {flag_tuple.protect_string}\n'
+            name_funcs += f'inline std::string ApiDump{flag_tuple.name}ToString(XrFlags64 value) {{\n'
+            name_funcs += '    std::string bits;\n'
+            for mask_tuple in self.api_bitmasks:
+                if mask_tuple.name == flag_tuple.valid_flags:
+                    for cur_value in mask_tuple.values:
+                        value_protect = cur_value.protect_value and flag_tuple.protect_value != cur_value.protect_value
+                        if value_protect:
+                            name_funcs += f'#if {cur_value.protect_string}\n'
+                        name_funcs += f'    ApiDumpAppendFlagBit(value, {cur_value.name}, "{cur_value.name}", bits);\n'
+                        if value_protect:
+                            name_funcs += f'#endif // {cur_value.protect_string}\n'
+                    break
+            name_funcs += '    return ApiDumpFinishFlags(value, bits);\n'
+            name_funcs += '}\n\n'
+            if flag_tuple.protect_value:
+                name_funcs += f'#endif // {flag_tuple.protect_string}\n'
+        return name_funcs
+
     # Generate a short version of the parameter name that we can use as a variable.
     #   self            the ApiDumpOutputGenerator object
     #   param_name      the name of the parameter to parse
@@ -449,40 +519,12 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
             write_string += f'contents.emplace_back("{full_type}", {description}'
             write_string += f', oss_{short_pname}.str());\n'
         else:
-            if base_type == 'XrResult':
-                write_string += self.writeIndent(indent)
-                write_string += 'if (nullptr != gen_dispatch_table) {\n'
-                indent = indent + 1
-                write_string += self.writeIndent(indent)
-                write_string += f'char {short_pname}_string[XR_MAX_RESULT_STRING_SIZE] = {{}};\n'
-                write_string += self.writeIndent(indent)
-                write_string += 'gen_dispatch_table->ResultToString(FindInstanceFromDispatchTable(gen_dispatch_table),\n'
-                write_string += self.writeIndent(indent)
-                write_string += f'                                   {full_name}, {short_pname}_string);\n'
-                write_string += self.writeIndent(indent)
-                write_string += f'contents.emplace_back("{full_type}", {description}, {short_pname}_string);\n'
-                write_string += self.writeIndent(indent - 1)
-                write_string += '} else {\n'
-                write_string += self.writeIndent(indent)
-            elif base_type == 'XrStructureType':
-                write_string += self.writeIndent(indent)
-                write_string += 'if (nullptr != gen_dispatch_table) {\n'
-                indent = indent + 1
-                write_string += self.writeIndent(indent)
-                write_string += f'char {short_pname}_string[XR_MAX_STRUCTURE_NAME_SIZE] = {{}};\n'
-                write_string += self.writeIndent(indent)
-                write_string += 'gen_dispatch_table->StructureTypeToString(FindInstanceFromDispatchTable(gen_dispatch_table),\n'
-                write_string += self.writeIndent(indent)
-                write_string += f'                                          {full_name}, {short_pname}_string);\n'
-                write_string += self.writeIndent(indent)
-                write_string += f'contents.emplace_back("{full_type}", {description}, {short_pname}_string);\n'
-                write_string += self.writeIndent(indent - 1)
-                write_string += '} else {\n'
-                write_string += self.writeIndent(indent)
-
             # If we're outputting using a string stream, determine the type of information
             # we're generating and format it appropriately.
-            if use_stream:
+            if use_stream and self.isHandle(base_type) and pointer_count == 0 and not is_array:
+                write_string += self.writeIndent(indent)
+                write_string += f'contents.emplace_back("{full_type}", {description}, HandleToHexString({full_name}));\n'
+            elif use_stream:
                 write_string += self.writeIndent(indent)
                 write_string += f'std::ostringstream oss_{short_pname};\n'
                 write_string += self.writeIndent(indent)
@@ -516,7 +558,11 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
             else:
                 write_string += self.writeIndent(indent)
                 write_string += f'contents.emplace_back("{full_type}", {description}, '
-                if not is_char:
+                if self.isEnumType(base_type):
+                    write_string += 'ApiDumpEnumToString('
+                elif self.isFlagType(base_type):
+                    write_string += f'ApiDump{base_type}ToString('
+                elif not is_char:
                     write_string += 'std::to_string('
                 if can_dereference:
                     write_string += '*' * pointer_count
@@ -528,11 +574,6 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                 if not is_char:
                     write_string += ')'
                 write_string += ');\n'
-
-            if base_type in ('XrResult', 'XrStructureType'):
-                indent = indent - 1
-                write_string += self.writeIndent(indent)
-                write_string += '}\n'
         return write_string
 
     # Output a single parameter/member.
@@ -1082,6 +1123,7 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                 prototype = cur_cmd.cdecl.replace(" xr", " ApiDumpLayerXr")
                 prototype = prototype.replace(";", " {\n")
                 generated_commands += prototype
+                generated_commands += f'    XR_TRACE_SCOPE("api_dump {cur_cmd.name}");\n'
 
                 if has_return:
                     if cur_cmd.return_type is None or not cur_cmd.return_type.text:
@@ -1105,15 +1147,10 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                     handle_param = cur_cmd.params[0]
                     base_handle_name = undecorate(handle_param.type)
                     first_handle_name = self.getFirstHandleName(handle_param)
-                    generated_commands += f'        XrGeneratedDispatchTable *gen_dispatch_table = nullptr;\n\n'
-                    generated_commands += f'        {{\n'
-                    generated_commands += f'            std::unique_lock<std::mutex> mlock(g_{base_handle_name}_dispatch_mutex);\n'
-                    generated_commands += f'            auto map_iter = g_{base_handle_name}_dispatch_map.find({first_handle_name});\n'
-                    generated_commands += f'            if (map_iter == g_{base_handle_name}_dispatch_map.end()) {{\n'
-                    generated_commands += f'                return XR_ERROR_VALIDATION_FAILURE;\n'
-                    generated_commands += f'            }}\n';
-                    generated_commands += f'            gen_dispatch_table = map_iter->second;\n'
-                    generated_commands += f'        }}\n\n';
+                    generated_commands += f'        XrGeneratedDispatchTable *gen_dispatch_table = g_{base_handle_name}_dispatch_map.Find({first_handle_name});\n'
+                    generated_commands += f'        if (nullptr == gen_dispatch_table) {{\n'
+                    generated_commands += f'            return XR_ERROR_VALIDATION_FAILURE;\n'
+                    generated_commands += f'        }}\n\n'
                 else:
                     generated_commands += self.printCodeGenErrorMessage(
                         f'Command {cur_cmd.name} does not have an OpenXR Object handle as the first parameter.')
@@ -1137,6 +1174,13 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                 # Now record the information
                 generated_commands += '        ApiDumpLayerRecordContent(contents);\n\n'
 
+                # An application can ask for the flight recorder to be written out, or change the layer's settings, with a
+                # debug utils message.
+                if cur_cmd.name == 'xrSubmitDebugUtilsMessageEXT':
+                    generated_commands += '        if (nullptr != callbackData) {\n'
+                    generated_commands += '            ApiDumpLayerRecordTrigger(callbackData->messageId, callbackData->message);\n'
+                    generated_commands += '        }\n\n'
+
                 # Call down, looking for the returned result if required.
                 generated_commands += '        '
                 if has_return:
@@ -1151,6 +1195,12 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                     count = count + 1
                 generated_commands += ');\n'
 
+                # Failures write out the flight recorder.
+                if has_return and cur_cmd.return_type.text == 'XrResult':
+                    generated_commands += '        if (XR_FAILED(result)) {\n'
+                    generated_commands += f'            ApiDumpLayerRecordFailure("{cur_cmd.name}", result);\n'
+                    generated_commands += '        }\n'
+
                 # If this is a create command, we have to create an entry in the appropriate
                 # unordered_map pointing to the correct dispatch table for the newly created
                 # object.  Likewise, if it's a delete command, we have to remove the entry
@@ -1160,22 +1210,23 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                     second_base_handle_name = undecorate(cur_cmd.params[-1].type)
                     if is_create:
                         generated_commands += '        if (XR_SUCCESS == result && nullptr != %s) {\n' % cur_cmd.params[-1].name
-                        generated_commands += '            auto exists = g_%s_dispatch_map.find(*%s);\n' % (
+                        generated_commands += '            g_%s_dispatch_map.Insert(*%s, gen_dispatch_table);\n' % (
                             second_base_handle_name, cur_cmd.params[-1].name)
-                        generated_commands += '            if (exists == g_%s_dispatch_map.end()) {\n' % second_base_handle_name
-                        generated_commands += f'                std::unique_lock<std::mutex> lock(g_{second_base_handle_name}_dispatch_mutex);\n'
-                        generated_commands += '                g_%s_dispatch_map[*%s] = gen_dispatch_table;\n' % (
-                            second_base_handle_name, cur_cmd.params[-1].name)
-                        generated_commands += '            }\n'
+                        generated_commands += '            ApiDumpLayerRecordOutputs({std::make_tuple("XrResult", "%s", ""),\n' % cur_cmd.name
+                        generated_commands += '                                       std::make_tuple("%s", "*%s", HandleToHexString(*%s))});\n' % (
+                            cur_cmd.params[-1].type, cur_cmd.params[-1].name, cur_cmd.params[-1].name)
                         generated_commands += '        }\n'
                     elif is_destroy:
-                        generated_commands += '        auto exists = g_%s_dispatch_map.find(%s);\n' % (
-                            second_base_handle_name, cur_cmd.params[-1].name)
-                        generated_commands += '        if (exists != g_%s_dispatch_map.end()) {\n' % second_base_handle_name
-                        generated_commands += f'            std::unique_lock<std::mutex> lock(g_{second_base_handle_name}_dispatch_mutex);\n'
-                        generated_commands += '            g_%s_dispatch_map.erase(%s);\n' % (
+                        generated_commands += '        g_%s_dispatch_map.Erase(%s);\n' % (
                             second_base_handle_name, cur_cmd.params[-1].name)
-                        generated_commands += '        }\n'
+
+                if cur_cmd.name in RECORDED_OUTPUTS:
+                    generated_commands += '        if (XR_SUCCEEDED(result)) {\n'
+                    generated_commands += f'            ApiDumpLayerRecordOutputs({{std::make_tuple("XrResult", "{cur_cmd.name}", "")'
+                    for output_type, output_name, output_value in RECORDED_OUTPUTS[cur_cmd.name]:
+                        generated_commands += f',\n                                       std::make_tuple("{output_type}", "{output_name}", {output_value})'
+                    generated_commands += '});\n'
+                    generated_commands += '        }\n'
 
                 # Catch any exceptions that may have occurred.  If any occurred between any of the
                 # valid mutex lock/unlock statements, perform the unlock now.
@@ -0,0 +1,152 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2017-2025 The Khronos Group Inc.
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Generates a synthetic tree of manifests for scaling tests of loader discovery:
+#
+#   <out>/runtime/active_runtime.json
+#   <out>/data_<d>/openxr/<major>/api_layers/explicit.d/XrApiLayer_tree_<n>.json
+#   <out>/data_<d>/openxr/<major>/api_layers/explicit.d/data_<d+1>/...      (with --nest)
+#   <out>/manifest_tree.env
+#
+# Layers are spread round-robin over the data directories.  Each data directory is laid out like an
+# XDG_DATA_DIRS entry, and its explicit.d directory can also be listed in XR_API_LAYER_PATH.  With --bad,
+# the malformed manifest variants from generate_api_layer_manifest.py are added to the first directory.
+# With --copy, each layer gets its own copy of the layer library, so stacking several of them loads separate
+# modules rather than one module several times.  Each --extra NAME=LIBRARY adds a manifest for XR_APILAYER_NAME to
+# the first directory, for putting other layers in the tree.
+# manifest_tree.env holds one NAME=VALUE line per environment variable a consumer should set.
+
+import getopt
+import os
+import shutil
+import sys
+
+import generate_api_layer_manifest
+import generate_runtime_manifest
+
+
+def main(argv):
+    output_dir = ''
+    layer_library = ''
+    runtime_library = ''
+    api_version = ''
+    layer_count = 1
+    dir_count = 1
+    nested = False
+    generate_badjson_jsons = False
+    copy_layer_library = False
+    extra_layers = []
+
+    usage = '\ngenerate_manifest_tree.py <ARGS>\n'
+    usage += '    -o/--out <output directory>\n'
+    usage += '    -l/--lib <API layer library location>\n'
+    usage += '    -r/--runtime <runtime library location>\n'
+    usage += '    -a/--api <OpenXR API version>\n'
+    usage += '    -n/--layers <number of layer manifests>\n'
+    usage += '    -m/--dirs <number of search directories>\n'
+    usage += '    -s/--nest\n'
+    usage += '    -b/--bad\n'
+    usage += '    -c/--copy\n'
+    usage += '    -e/--extra <layer name>=<API layer library location>\n'
+
+    try:
+        opts, _ = getopt.getopt(argv, "hsbco:l:r:a:n:m:e:",
+                                ["nest", "bad", "copy", "out=", "lib=", "runtime=", "api=", "layers=", "dirs=", "extra="])
+    except getopt.GetoptError:
+        print(usage)
+        sys.exit(2)
+    for opt, arg in opts:
+        if opt == '-h':
+            print(usage)
+            sys.exit()
+        elif opt in ("-o", "--out"):
+            output_dir = arg.strip()
+        elif opt in ("-l", "--lib"):
+            layer_library = arg.strip()
+        elif opt in ("-r", "--runtime"):
+            runtime_library = arg.strip()
+        elif opt in ("-a", "--api"):
+            api_version = arg.strip()
+        elif opt in ("-n", "--layers"):
+            layer_count = int(arg)
+        elif opt in ("-m", "--dirs"):
+            dir_count = int(arg)
+        elif opt in ("-s", "--nest"):
+            nested = True
+        elif opt in ("-b", "--bad"):
+            generate_badjson_jsons = True
+        elif opt in ("-c", "--copy"):
+            copy_layer_library = True
+        elif opt in ("-e", "--extra"):
+            name, _, library = arg.strip().partition('=')
+            extra_layers.append((name, library))
+
+    if not output_dir or not layer_library or not runtime_library or not api_version or dir_count < 1:
+        print(usage)
+        sys.exit(2)
+
+    # Start from scratch so a tree regenerated with fewer layers does not keep stale manifests.
+    shutil.rmtree(output_dir, ignore_errors=True)
+
+    relative_layer_dir = os.path.join('openxr', api_version.split('.')[0], 'api_layers', 'explicit.d')
+
+    # With --nest each data directory lives inside the previous one's explicit.d, so discovery has to cope
+    # with subdirectories it should not descend into.
+    data_dirs = []
+    parent = output_dir
+    for cur_dir in range(dir_count):
+        data_dir = os.path.join(parent, f'data_{cur_dir}')
+        data_dirs.append(data_dir)
+        os.makedirs(os.path.join(data_dir, relative_layer_dir), exist_ok=True)
+        if nested:
+            parent = os.path.join(data_dir, relative_layer_dir)
+
+    for layer in range(layer_count):
+        layer_dir = os.path.join(data_dirs[layer % dir_count], relative_layer_dir)
+        library = layer_library
+        if copy_layer_library:
+            base, ext = os.path.splitext(os.path.basename(layer_library))
+            library = os.path.join(layer_dir, f'{base}_tree_{layer}{ext}')
+            shutil.copyfile(layer_library, library)
+            # Written into the JSON as is, so no backslashes.
+            library = library.replace(os.sep, '/')
+        args = ['-f', os.path.join(layer_dir, f'XrApiLayer_tree_{layer}.json'), '-n', f'tree_{layer}', '-l', library,
+                '-a', api_version, '-v', '1', '-d', 'Synthetic_manifest_tree_layer']
+        if generate_badjson_jsons and layer == 0:
+            args.append('-b')
+        generate_api_layer_manifest.main(args)
+
+    for name, library in extra_layers:
+        layer_dir = os.path.join(data_dirs[0], relative_layer_dir)
+        generate_api_layer_manifest.main(['-f', os.path.join(layer_dir, f'XrApiLayer_{name}.json'), '-n', name, '-l', library,
+                                          '-a', api_version, '-v', '1', '-d', 'Manifest_tree_extra_layer'])
+
+    runtime_dir = os.path.join(output_dir, 'runtime')
+    os.makedirs(runtime_dir, exist_ok=True)
+    runtime_json = os.path.join(runtime_dir, 'active_runtime.json')
+    generate_runtime_manifest.main(['-f', runtime_json, '-l', runtime_library])
+
+    layer_dirs = [os.path.join(data_dir, relative_layer_dir) for data_dir in data_dirs]
+    with open(os.path.join(output_dir, 'manifest_tree.env'), 'w') as f:
+        f.write(f'XR_RUNTIME_JSON={runtime_json}\n')
+        f.write(f'XR_API_LAYER_PATH={os.pathsep.join(layer_dirs)}\n')
+        f.write(f'XDG_DATA_DIRS={os.pathsep.join(data_dirs)}\n')
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
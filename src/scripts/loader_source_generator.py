@@ -52,6 +52,30 @@ EXTENSIONS_LOADER_IMPLEMENTS = [
     'XR_EXT_debug_utils'
 ]
 
+# The following commands are resolved directly by the loader's
+# xrGetInstanceProcAddr trampoline or terminator instead of being
+# forwarded down the layer chain.  A sorted lookup table of these names
+# is generated so the loader can binary search it instead of walking a
+# chain of string compares for every query.
+LOADER_GIPA_FUNCS = (
+    'xrGetInstanceProcAddr',
+    'xrInitializeLoaderKHR',
+    'xrEnumerateApiLayerProperties',
+    'xrEnumerateInstanceExtensionProperties',
+    'xrCreateInstance',
+    'xrDestroyInstance',
+    'xrCreateApiLayerInstance',
+
+    # For XR_EXT_debug_utils:
+    'xrCreateDebugUtilsMessengerEXT',
+    'xrDestroyDebugUtilsMessengerEXT',
+    'xrSessionBeginDebugUtilsLabelRegionEXT',
+    'xrSessionEndDebugUtilsLabelRegionEXT',
+    'xrSessionInsertDebugUtilsLabelEXT',
+    'xrSetDebugUtilsObjectNameEXT',
+    'xrSubmitDebugUtilsMessageEXT',
+)
+
 
 def generateErrorMessage(indent_level, vuid, cur_cmd, message, object_info):
     lines = []
@@ -128,6 +152,7 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
             preamble += '#include "loader_instance.hpp"\n'
             preamble += '#include "loader_logger.hpp"\n'
             preamble += '#include "loader_platform.hpp"\n'
+            preamble += '#include "platform_trace.hpp"\n'
             preamble += '#include "runtime_interface.hpp"\n'
             preamble += '#include "xr_generated_dispatch_table_core.h"\n\n'
 
@@ -135,7 +160,10 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
             preamble += '#include <openxr/openxr.h>\n'
             preamble += '#include <openxr/openxr_platform.h>\n\n'
 
+            preamble += '#include <algorithm>\n'
+            preamble += '#include <cstdint>\n'
             preamble += '#include <cstring>\n'
+            preamble += '#include <iterator>\n'
             preamble += '#include <memory>\n'
             preamble += '#include <new>\n'
             preamble += '#include <string>\n'
@@ -150,6 +178,8 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
         file_data = ''
 
         if self.genOpts.filename == 'xr_generated_loader.hpp':
+            file_data += self.outputLoaderGipaLookupDecl()
+            file_data += self.outputLoaderExtensionLookupDecl()
             file_data += '#ifdef __cplusplus\n'
             file_data += 'extern "C" { \n'
             file_data += '#endif\n'
@@ -159,6 +189,8 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
             file_data += '#endif\n'
 
         elif self.genOpts.filename == 'xr_generated_loader.cpp':
+            file_data += self.outputLoaderGipaLookupTable()
+            file_data += self.outputLoaderExtensionLookupTable()
             file_data += self.outputLoaderGeneratedFuncs()
 
         write(file_data, file=self.outFile)
@@ -166,6 +198,136 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
         # Finish processing in superclass
         AutomaticSourceOutputGenerator.endFile(self)
 
+    # Return the names in LOADER_GIPA_FUNCS sorted in strcmp order, making sure
+    # each of them is actually a command in the registry (xrCreateApiLayerInstance
+    # is only a loader negotiation function pointer type, so it is exempt).
+    #   self            the LoaderSourceOutputGenerator object
+    def getLoaderGipaFuncs(self):
+        known_commands = set(cmd.name for cmd in self.core_commands)
+        known_commands.update(cmd.name for cmd in self.ext_commands)
+        for name in LOADER_GIPA_FUNCS:
+            if name not in known_commands and name != 'xrCreateApiLayerInstance':
+                self.printCodeGenErrorMessage(f'Loader-handled command {name} is not in the registry')
+        # Python string ordering matches strcmp for the ASCII command names.
+        return sorted(LOADER_GIPA_FUNCS)
+
+    # Declare the enum and lookup function for the commands the loader
+    # resolves itself in xrGetInstanceProcAddr.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderGipaLookupDecl(self):
+        decl = '\n// Commands resolved directly by the loader in xrGetInstanceProcAddr\n'
+        decl += 'enum class LoaderGipaFunction {\n'
+        decl += '    Unknown = 0,\n'
+        for name in self.getLoaderGipaFuncs():
+            decl += f'    {name[2:]},\n'
+        decl += '};\n\n'
+        decl += '// Look up a command name in the sorted table of loader-handled commands.\n'
+        decl += '// Returns LoaderGipaFunction::Unknown if the loader does not handle the command itself.\n'
+        decl += 'LoaderGipaFunction LoaderLookupGipaFunction(const char* name);\n\n'
+        return decl
+
+    # Output a sorted name table as one string pool plus entries holding
+    # offsets into it.  Unlike an array of const char* this needs no dynamic
+    # relocations, so the table stays in read-only data and costs nothing when
+    # the loader library is mapped.
+    #   self            the LoaderSourceOutputGenerator object
+    #   entry_type      name of the entry struct to declare
+    #   pool_name       name of the string pool array
+    #   table_name      name of the entry array
+    #   value_type      enum type stored alongside each name
+    #   value_field     member name of the enum value in the entry struct
+    #   names           names in strcmp order, paired with their enumerant names
+    def outputLoaderNameTable(self, entry_type, pool_name, table_name, value_type, value_field, names):
+        table = f'struct {entry_type} {{\n'
+        table += f'    uint16_t name_offset;  // into {pool_name}\n'
+        table += f'    {value_type} {value_field};\n'
+        table += '};\n\n'
+        table += f'constexpr char {pool_name}[] =\n'
+        offsets = []
+        offset = 0
+        for name, _ in names:
+            offsets.append(offset)
+            offset += len(name) + 1
+            table += f'    "{name}\\0"\n'
+        table = table[:-1] + ';\n'
+        table += f'static_assert(sizeof({pool_name}) <= UINT16_MAX, "{entry_type}::name_offset is too narrow");\n\n'
+        table += f'constexpr {entry_type} {table_name}[] = {{\n'
+        for (name, enumerant), name_offset in zip(names, offsets):
+            table += f'    {{{name_offset}, {value_type}::{enumerant}}},  // {name}\n'
+        table += '};\n'
+        return table
+
+    # Output the binary search over a table written by outputLoaderNameTable.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderNameSearch(self, entry_type, pool_name, table_name, value_type, value_field):
+        search = f'    auto begin = std::begin({table_name});\n'
+        search += f'    auto end = std::end({table_name});\n'
+        search += '    auto it = std::lower_bound(begin, end, name, [](const ' + entry_type + '& entry, const char* n) {\n'
+        search += f'        return strcmp({pool_name} + entry.name_offset, n) < 0;\n'
+        search += '    });\n'
+        search += f'    if (it != end && strcmp({pool_name} + it->name_offset, name) == 0) {{\n'
+        search += f'        return it->{value_field};\n'
+        search += '    }\n'
+        search += f'    return {value_type}::Unknown;\n'
+        return search
+
+    # Output the sorted constexpr table of loader-handled command names and
+    # the binary search used to look names up in it.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderGipaLookupTable(self):
+        args = ('LoaderGipaEntry', 'kLoaderGipaNames', 'kLoaderGipaEntries', 'LoaderGipaFunction', 'function')
+        names = [(name, name[2:]) for name in self.getLoaderGipaFuncs()]
+        table = '\n// Sorted (strcmp order) table of commands resolved directly by the loader\n'
+        table += 'namespace {\n'
+        table += self.outputLoaderNameTable(*args, names)
+        table += '}  // namespace\n\n'
+        table += 'LoaderGipaFunction LoaderLookupGipaFunction(const char* name) {\n'
+        table += '    // Every command name starts with "xr", so reject anything else without searching.\n'
+        table += "    if (name[0] != 'x' || name[1] != 'r') {\n"
+        table += '        return LoaderGipaFunction::Unknown;\n'
+        table += '    }\n'
+        table += self.outputLoaderNameSearch(*args)
+        table += '}\n'
+        return table
+
+    # Return the names of the known instance and system extensions sorted in
+    # strcmp order.
+    #   self            the LoaderSourceOutputGenerator object
+    def getLoaderExtensions(self):
+        # Python string ordering matches strcmp for the ASCII extension names.
+        return sorted(set(ext.name for ext in self.extensions))
+
+    # Declare the enum indexing the known extensions, so a LoaderInstance can
+    # keep which are enabled as bits, and the lookup function mapping names to it.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderExtensionLookupDecl(self):
+        decl = '// Extensions known to the loader, indexing the enabled extension bits of a LoaderInstance\n'
+        decl += 'enum class LoaderExtension : uint32_t {\n'
+        decl += '    Unknown = 0,\n'
+        for name in self.getLoaderExtensions():
+            decl += f'    {name[3:]},\n'
+        decl += '    Count,\n'
+        decl += '};\n\n'
+        decl += '// Look up an extension name in the sorted table of known extensions.\n'
+        decl += '// Returns LoaderExtension::Unknown if the loader was not generated with it.\n'
+        decl += 'LoaderExtension LoaderLookupExtension(const char* name);\n\n'
+        return decl
+
+    # Output the sorted constexpr table of known extension names and the
+    # binary search used to look names up in it.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderExtensionLookupTable(self):
+        args = ('LoaderExtensionEntry', 'kLoaderExtensionNames', 'kLoaderExtensionEntries', 'LoaderExtension', 'extension')
+        names = [(name, name[3:]) for name in self.getLoaderExtensions()]
+        table = '\n// Sorted (strcmp order) table of extensions known to the loader\n'
+        table += 'namespace {\n'
+        table += self.outputLoaderNameTable(*args, names)
+        table += '}  // namespace\n\n'
+        table += 'LoaderExtension LoaderLookupExtension(const char* name) {\n'
+        table += self.outputLoaderNameSearch(*args)
+        table += '}\n'
+        return table
+
     # Create prototypes for the loader's manually generated functions
     # so the generated code can call them.
     #   self            the LoaderSourceOutputGenerator object
@@ -236,9 +398,11 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
                         base_handle_name = undecorate(param.type)
                         first_handle_name = self.getFirstHandleName(param)
 
-                        tramp_variable_defines += '    LoaderInstance* loader_instance;\n'
-                        tramp_variable_defines += f'    XrResult result = ActiveLoaderInstance::Get(&loader_instance, "{cur_cmd.name}");\n'
-                        tramp_variable_defines += '    if (XR_SUCCEEDED(result)) {\n'
+                        # Only the published table is read, so the success path is a load, a check and a tail call.
+                        tramp_variable_defines += '    const XrGeneratedDispatchTableCore* dispatch_table = ActiveLoaderInstance::GetDispatchTable();\n'
+                        tramp_variable_defines += '    if (dispatch_table == nullptr) {\n'
+                        tramp_variable_defines += f'        return ActiveLoaderInstance::NoActiveInstance("{cur_cmd.name}");\n'
+                        tramp_variable_defines += '    }\n'
 
                         # These should be mutually exclusive - verify it.
                         assert ((not cur_cmd.is_destroy_disconnect) or
@@ -260,19 +424,20 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
 
             if cur_cmd.protect_value:
                 generated_funcs += f'#if {cur_cmd.protect_string}\n'
-            decl = self.getProto(cur_cmd).replace(";", " XRLOADER_ABI_TRY {\n")
+            # Nothing on the way to the next function can throw: NoActiveInstance catches its own exceptions, so no
+            # XRLOADER_ABI_TRY is needed, and leaving it out lets the compiler turn the call into a jump.
+            decl = self.getProto(cur_cmd).replace(";", " {\n")
 
             generated_funcs += decl
+            generated_funcs += f'    XR_TRACE_SCOPE("{cur_cmd.name}");\n'
             generated_funcs += tramp_variable_defines
 
             if has_return:
-                generated_funcs += '        result = '
+                generated_funcs += '    return '
             else:
-                generated_funcs += '        '
+                generated_funcs += '    '
 
-            generated_funcs += 'loader_instance->DispatchTable()->'
-            generated_funcs += base_name
-            generated_funcs += '('
+            generated_funcs += f'XR_GENERATED_DISPATCH_CORE(dispatch_table, {base_name})('
             count = 0
             for param in tramp_param_replace:
                 if count > 0:
@@ -280,13 +445,7 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
                 generated_funcs += param.name
                 count = count + 1
             generated_funcs += ');\n'
-
-            generated_funcs += '    }\n'
-
-            if has_return:
-                generated_funcs += '    return result;\n'
-
-            generated_funcs += '}\nXRLOADER_ABI_CATCH_FALLBACK\n'
+            generated_funcs += '}\n'
 
             if cur_cmd.protect_value:
                 generated_funcs += f'#endif // {cur_cmd.protect_string}\n'
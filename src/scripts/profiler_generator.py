@@ -0,0 +1,221 @@
+#!/usr/bin/env python3 -i
+#
+# Copyright (c) 2017-2025 The Khronos Group Inc.
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Purpose:      This file utilizes the content formatted in the
+#               automatic_source_generator.py class to produce the
+#               generated source code for the Profiler layer.
+
+from automatic_source_generator import AutomaticSourceOutputGenerator, CurrentExtensionTracker
+from generator import write
+
+# The following commands should not be generated for the layer
+MANUALLY_DEFINED_IN_LAYER = set((
+    'xrGetInstanceProcAddr',
+    'xrCreateInstance',
+    'xrDestroyInstance',
+))
+
+# Commands whose successful calls are also recorded in the trace, with the call that records them
+TRACE_HOOKS = {
+    'xrWaitFrame': 'ProfilerLayerTraceWaitFrame(session, frameState);',
+    'xrDestroySession': 'ProfilerLayerTraceDestroySession(session);',
+    'xrSessionBeginDebugUtilsLabelRegionEXT': 'ProfilerLayerTraceBeginLabelRegion(session, labelInfo);',
+    'xrSessionEndDebugUtilsLabelRegionEXT': 'ProfilerLayerTraceEndLabelRegion(session);',
+    'xrSessionInsertDebugUtilsLabelEXT': 'ProfilerLayerTraceInsertLabel(session, labelInfo);',
+}
+
+# ProfilerOutputGenerator - subclass of AutomaticSourceOutputGenerator.
+
+
+class ProfilerOutputGenerator(AutomaticSourceOutputGenerator):
+    """Generate Profiler layer source using XML element attributes from registry"""
+
+    # Override the base class header warning so the comment indicates this file.
+    #   self            the AutomaticSourceOutputGenerator object
+    def outputGeneratedHeaderWarning(self):
+        # File Comment
+        generated_warning = '// *********** THIS FILE IS GENERATED - DO NOT EDIT ***********\n'
+        generated_warning += '//     See profiler_generator.py for modifications\n'
+        generated_warning += '// ************************************************************\n'
+        write(generated_warning, file=self.outFile)
+
+    # Call the base class to properly begin the file, and then add
+    # the file-specific header information.
+    #   self            the ProfilerOutputGenerator object
+    #   gen_opts        the ProfilerGeneratorOptions object
+    def beginFile(self, genOpts):
+        AutomaticSourceOutputGenerator.beginFile(self, genOpts)
+        preamble = ''
+        if self.genOpts.filename == 'xr_generated_profiler.hpp':
+            preamble += '#pragma once\n\n'
+            preamble += '#include "api_layer_platform_defines.h"\n'
+            preamble += '#include <openxr/openxr.h>\n'
+            preamble += '#include <openxr/openxr_platform.h>\n\n'
+        elif self.genOpts.filename == 'xr_generated_profiler.cpp':
+            preamble += '#include "xr_generated_profiler.hpp"\n'
+            preamble += '#include "profiler.h"\n'
+            preamble += '#include "xr_generated_dispatch_table.h"\n\n'
+            preamble += '#include <string>\n\n'
+        write(preamble, file=self.outFile)
+
+    # Write out all the information for the appropriate file,
+    # and then call down to the base class to wrap everything up.
+    #   self            the ProfilerOutputGenerator object
+    def endFile(self):
+        file_data = ''
+        if self.genOpts.filename == 'xr_generated_profiler.hpp':
+            file_data += self.outputProfilerCommandIndices()
+            file_data += self.outputLayerHeaderPrototypes()
+
+        elif self.genOpts.filename == 'xr_generated_profiler.cpp':
+            file_data += self.outputProfilerCommandNames()
+            file_data += self.outputLayerCommands()
+
+        write(file_data, file=self.outFile)
+
+        # Finish processing in superclass
+        AutomaticSourceOutputGenerator.endFile(self)
+
+    # The commands the layer keeps statistics for: every command that reaches a layer.
+    #   self            the ProfilerOutputGenerator object
+    def profiledCommands(self):
+        return [cur_cmd for cur_cmd in self.core_commands + self.ext_commands
+                if cur_cmd.name not in self.no_trampoline_or_terminator]
+
+    # Output an index for each command.  The indices are not protected by platform defines, so they are the
+    # same for every build.
+    #   self            the ProfilerOutputGenerator object
+    def outputProfilerCommandIndices(self):
+        indices = '// Index of each command in the profiler\'s statistics\n'
+        indices += 'enum ProfilerCommand {\n'
+        for cur_cmd in self.profiledCommands():
+            indices += f'    PROFILER_COMMAND_{cur_cmd.name},\n'
+        indices += '    PROFILER_COMMAND_COUNT\n'
+        indices += '};\n\n'
+        indices += 'extern const char *const kProfilerCommandNames[PROFILER_COMMAND_COUNT];\n\n'
+        return indices
+
+    # Output the prototypes of the manually written functions the generated code calls.
+    #   self            the ProfilerOutputGenerator object
+    def outputLayerHeaderPrototypes(self):
+        generated_prototypes = '// Profiler Inner xrGetInstanceProcAddr helper\n'
+        generated_prototypes += 'PFN_xrVoidFunction ProfilerLayerInnerGetInstanceProcAddr(const char* name);\n\n'
+        generated_prototypes += '// Profiler Manual Functions\n'
+        generated_prototypes += 'XRAPI_ATTR XrResult XRAPI_CALL ProfilerLayerXrGetInstanceProcAddr(XrInstance instance,\n'
+        generated_prototypes += '                                          const char* name, PFN_xrVoidFunction* function);\n'
+        generated_prototypes += 'XRAPI_ATTR XrResult XRAPI_CALL ProfilerLayerXrDestroyInstance(XrInstance instance);\n'
+        generated_prototypes += 'void ProfilerLayerExportTrigger(const char* message_id);\n'
+        generated_prototypes += 'void ProfilerLayerTraceWaitFrame(XrSession session, const XrFrameState* frame_state);\n'
+        generated_prototypes += 'void ProfilerLayerTraceDestroySession(XrSession session);\n'
+        generated_prototypes += 'void ProfilerLayerTraceBeginLabelRegion(XrSession session, const XrDebugUtilsLabelEXT* label_info);\n'
+        generated_prototypes += 'void ProfilerLayerTraceEndLabelRegion(XrSession session);\n'
+        generated_prototypes += 'void ProfilerLayerTraceInsertLabel(XrSession session, const XrDebugUtilsLabelEXT* label_info);\n'
+        return generated_prototypes
+
+    #   self            the ProfilerOutputGenerator object
+    def outputProfilerCommandNames(self):
+        names = 'const char *const kProfilerCommandNames[PROFILER_COMMAND_COUNT] = {\n'
+        for cur_cmd in self.profiledCommands():
+            names += f'    "{cur_cmd.name}",\n'
+        names += '};\n'
+        return names
+
+    # Output a wrapper for each command that times the call down the chain.
+    #   self            the ProfilerOutputGenerator object
+    def outputLayerCommands(self):
+        cur_extension = CurrentExtensionTracker(self.conventions.api_version_prefix)
+        generated_commands = '\n// Automatically generated profiler layer commands\n'
+        for cur_cmd in self.core_commands + self.ext_commands:
+            assert cur_cmd.ext_name
+            generated_commands += cur_extension.format_if_extension_changed(cur_cmd.ext_name, "\n// ---- {} commands\n")
+
+            if cur_cmd.name in self.no_trampoline_or_terminator or cur_cmd.name in MANUALLY_DEFINED_IN_LAYER:
+                continue
+
+            if cur_cmd.return_type is None or cur_cmd.return_type.text != 'XrResult':
+                raise RuntimeError(f'Command {cur_cmd.name} does not return XrResult!')
+
+            if cur_cmd.protect_value:
+                generated_commands += f'#if {cur_cmd.protect_string}\n'
+
+            prototype = cur_cmd.cdecl.replace(" xr", " ProfilerLayerXr")
+            prototype = prototype.replace(";", " {\n")
+            generated_commands += prototype
+
+            generated_commands += '    XrGeneratedDispatchTable *gen_dispatch_table = ProfilerNextDispatch();\n'
+            generated_commands += '    if (nullptr == gen_dispatch_table) {\n'
+            generated_commands += '        return XR_ERROR_HANDLE_INVALID;\n'
+            generated_commands += '    }\n'
+
+            # An application can ask for the statistics to be written out with a debug utils message.
+            if cur_cmd.name == 'xrSubmitDebugUtilsMessageEXT':
+                generated_commands += '    if (nullptr != callbackData) {\n'
+                generated_commands += '        ProfilerLayerExportTrigger(callbackData->messageId);\n'
+                generated_commands += '    }\n'
+
+            call = f'gen_dispatch_table->{cur_cmd.name[2:]}('
+            call += ', '.join(param.name for param in cur_cmd.params)
+            call += ');\n'
+            if cur_cmd.name in TRACE_HOOKS:
+                generated_commands += '    XrResult result;\n'
+                generated_commands += '    {\n'
+                generated_commands += f'        ProfilerCallTimer timer(PROFILER_COMMAND_{cur_cmd.name});\n'
+                generated_commands += f'        result = {call}'
+                generated_commands += '    }\n'
+                generated_commands += '    if (XR_SUCCEEDED(result)) {\n'
+                generated_commands += f'        {TRACE_HOOKS[cur_cmd.name]}\n'
+                generated_commands += '    }\n'
+                generated_commands += '    return result;\n'
+            else:
+                generated_commands += f'    ProfilerCallTimer timer(PROFILER_COMMAND_{cur_cmd.name});\n'
+                generated_commands += f'    return {call}'
+            generated_commands += '}\n\n'
+            if cur_cmd.protect_value:
+                generated_commands += f'#endif // {cur_cmd.protect_string}\n'
+
+        generated_commands += 'PFN_xrVoidFunction ProfilerLayerInnerGetInstanceProcAddr(\n'
+        generated_commands += '    const char*                                 name) {\n'
+        generated_commands += '        std::string func_name = name;\n\n'
+
+        # reset the state
+        cur_extension = CurrentExtensionTracker(self.conventions.api_version_prefix)
+
+        for cur_cmd in self.core_commands + self.ext_commands:
+            assert cur_cmd.ext_name
+            generated_commands += cur_extension.format_if_extension_changed(cur_cmd.ext_name, "\n        // ---- {} commands\n")
+
+            # The loader creates instances through xrCreateApiLayerInstance.
+            if cur_cmd.name in self.no_trampoline_or_terminator or cur_cmd.name == 'xrCreateInstance':
+                continue
+
+            # Replace 'xr' in proto name with a Profiler-specific name to avoid collisions.
+            layer_command_name = cur_cmd.name.replace("xr", "ProfilerLayerXr")
+
+            if cur_cmd.protect_value:
+                generated_commands += f'#if {cur_cmd.protect_string}\n'
+
+            generated_commands += '        if (func_name == "%s") {\n' % cur_cmd.name
+            generated_commands += f'            return reinterpret_cast<PFN_xrVoidFunction>({layer_command_name});\n'
+            generated_commands += '        }\n'
+            if cur_cmd.protect_value:
+                generated_commands += f'#endif // {cur_cmd.protect_string}\n'
+
+        generated_commands += '        return nullptr;\n'
+        generated_commands += '    }\n'
+
+        return generated_commands
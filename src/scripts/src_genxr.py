@@ -31,6 +31,7 @@ from api_dump_generator import ApiDumpOutputGenerator
 from automatic_source_generator import AutomaticSourceGeneratorOptions
 from generator import write
 from loader_source_generator import LoaderSourceOutputGenerator
+from profiler_generator import ProfilerOutputGenerator
 from reflib import logDiag, logWarn, logErr, setLogFile
 from reg import Registry
 from utility_source_generator import UtilitySourceOutputGenerator
@@ -218,21 +219,30 @@ def makeGenOpts(args):
         'xr_generated_dispatch_table_core.c',
     ]
 
+    # The dispatch tables that can also be populated lazily, resolving each command the first time it is used.  Code
+    # using them takes commands with the XR_GENERATED_DISPATCH_CORE accessor rather than reading the entries.
+    LAZY_DISPATCH_TABLE_FILES = [
+        'xr_generated_dispatch_table_core.h',
+        'xr_generated_dispatch_table_core.c',
+    ]
+
     for filename in DISPATCH_TABLE_FILES:
+        dispatchTableOpts = AutomaticSourceGeneratorOptions(
+            conventions=conventions,
+            filename=filename,
+            directory=directory,
+            apiname='openxr',
+            profile=None,
+            versions=featuresPat,
+            emitversions=featuresPat,
+            defaultExtensions='openxr',
+            addExtensions=None,
+            removeExtensions=None,
+            emitExtensions=emitExtensionsPat)
+        dispatchTableOpts.lazyDispatch = filename in LAZY_DISPATCH_TABLE_FILES
         genOpts[filename] = [
             UtilitySourceOutputGenerator,
-            AutomaticSourceGeneratorOptions(
-                conventions=conventions,
-                filename=filename,
-                directory=directory,
-                apiname='openxr',
-                profile=None,
-                versions=featuresPat,
-                emitversions=featuresPat,
-                defaultExtensions='openxr',
-                addExtensions=None,
-                removeExtensions=None,
-                emitExtensions=emitExtensionsPat)
+            dispatchTableOpts
         ]
 
     genOpts['xr_generated_loader.hpp'] = [
@@ -322,6 +332,45 @@ def makeGenOpts(args):
             apientryp='XRAPI_PTR *')
     ]
 
+    # Source files generated for the profiler layer
+    genOpts['xr_generated_profiler.cpp'] = [
+        ProfilerOutputGenerator,
+        AutomaticSourceGeneratorOptions(
+            conventions=conventions,
+            filename='xr_generated_profiler.cpp',
+            directory=directory,
+            apiname='openxr',
+            profile=None,
+            versions=featuresPat,
+            emitversions=featuresPat,
+            defaultExtensions='openxr',
+            addExtensions=None,
+            removeExtensions=None,
+            emitExtensions=emitExtensionsPat,
+            apicall='XRAPI_ATTR ',
+            apientry='XRAPI_CALL ',
+            apientryp='XRAPI_PTR *')
+    ]
+
+    genOpts['xr_generated_profiler.hpp'] = [
+        ProfilerOutputGenerator,
+        AutomaticSourceGeneratorOptions(
+            conventions=conventions,
+            filename='xr_generated_profiler.hpp',
+            directory=directory,
+            apiname='openxr',
+            profile=None,
+            versions=featuresPat,
+            emitversions=featuresPat,
+            defaultExtensions='openxr',
+            addExtensions=None,
+            removeExtensions=None,
+            emitExtensions=emitExtensionsPat,
+            apicall='XRAPI_ATTR ',
+            apientry='XRAPI_CALL ',
+            apientryp='XRAPI_PTR *')
+    ]
+
     # Source files generated for the core validation layer
     genOpts['xr_generated_core_validation.hpp'] = [
         ValidationSourceOutputGenerator,
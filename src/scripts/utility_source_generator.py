@@ -20,6 +20,25 @@
 from automatic_source_generator import AutomaticSourceOutputGenerator, CurrentExtensionTracker
 from generator import write
 
+# Commands an application calls every frame, placed first in the dispatch tables in this order so that the loader
+# and layers dispatching them touch as few cache lines as possible.  Commands the registry does not have are skipped.
+HOT_DISPATCH_COMMANDS = [
+    'xrWaitFrame',
+    'xrBeginFrame',
+    'xrEndFrame',
+    'xrLocateViews',
+    'xrAcquireSwapchainImage',
+    'xrWaitSwapchainImage',
+    'xrReleaseSwapchainImage',
+    'xrSyncActions',
+    'xrGetActionStateBoolean',
+    'xrGetActionStateFloat',
+    'xrGetActionStateVector2f',
+    'xrGetActionStatePose',
+    'xrLocateSpace',
+    'xrLocateSpaces',
+]
+
 # UtilitySourceOutputGenerator - subclass of AutomaticSourceOutputGenerator.
 
 
@@ -61,6 +80,8 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
             # All .c files start the same
             header = self.genOpts.filename.replace('.c', '.h')
             preamble += f'#include "{header}"\n\n'
+            if self.isLazy():
+                preamble += '#include <string.h>\n'
         else:
             raise RuntimeError(f"Unknown filename extension! {self.genOpts.filename}")
 
@@ -110,19 +131,51 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
         # Finish processing in superclass
         AutomaticSourceOutputGenerator.endFile(self)
 
+    # Whether the tables of this file can be populated lazily, with each command resolved on first use.  Set with
+    # the lazyDispatch attribute of the generator options, in src_genxr.py.
+    #   self            the UtilitySourceOutputGenerator object
+    def isLazy(self):
+        return getattr(self.genOpts, 'lazyDispatch', False)
+
+    # The names of the table struct and of its functions, without 'struct ', and the accessor macro.
+    #   self            the UtilitySourceOutputGenerator object
+    def tableNames(self):
+        if self.genOpts.filename.startswith('xr_generated_dispatch_table_core.'):
+            return 'XrGeneratedDispatchTableCore', 'XR_GENERATED_DISPATCH_CORE'
+        return 'XrGeneratedDispatchTable', 'XR_GENERATED_DISPATCH'
+
     # Write out a prototype for a C-style command to populate a Dispatch table
     #   self            the ApiDumpOutputGenerator object
     def outputDispatchPrototypes(self):
+        table_name, macro_name = self.tableNames()
         table_helper = '\n'
         table_helper += '// Prototype for dispatch table helper function\n'
-
-        if self.genOpts.filename == 'xr_generated_dispatch_table_core.h':
-            table_helper += 'void GeneratedXrPopulateDispatchTableCore(struct XrGeneratedDispatchTableCore *table,\n'
-        else:
-            table_helper += 'void GeneratedXrPopulateDispatchTable(struct XrGeneratedDispatchTable *table,\n'
-
+        table_helper += f'void GeneratedXrPopulate{table_name[len("XrGenerated"):]}(struct {table_name} *table,\n'
         table_helper += '                                      XrInstance instance,\n'
         table_helper += '                                      PFN_xrGetInstanceProcAddr get_inst_proc_addr);\n'
+
+        if self.isLazy():
+            short_name = table_name[len("XrGenerated"):]
+            table_helper += '\n'
+            table_helper += '// Prototype for the helper function that populates a dispatch table lazily: only GetInstanceProcAddr is\n'
+            table_helper += f'// resolved now, and every other command the first time it is taken from the table with {macro_name}.\n'
+            table_helper += f'void GeneratedXrPopulate{short_name}Lazy(struct {table_name} *table,\n'
+            table_helper += '                                      XrInstance instance,\n'
+            table_helper += '                                      PFN_xrGetInstanceProcAddr get_inst_proc_addr);\n'
+            table_helper += '\n'
+            table_helper += '// Resolve a command of a lazily populated table and store it in its entry.  NULL if the command is not\n'
+            table_helper += '// available, or the table was populated with all its commands at once.\n'
+            table_helper += f'PFN_xrVoidFunction GeneratedXrResolve{short_name}Command(const struct {table_name} *table,\n'
+            table_helper += '                                      const char *name,\n'
+            table_helper += '                                      PFN_xrVoidFunction *entry);\n'
+            table_helper += '\n'
+            table_helper += '// A command of a dispatch table, or NULL if it is not available.  A command of a lazily populated table is\n'
+            table_helper += '// resolved the first time it is taken; threads that take it first at the same time store the same pointer.\n'
+            table_helper += f'#define {macro_name}(table, command) \\\n'
+            table_helper += '    ((table)->command != NULL \\\n'
+            table_helper += '         ? (table)->command \\\n'
+            table_helper += f'         : (PFN_xr##command)GeneratedXrResolve{short_name}Command((table), "xr" #command, \\\n'
+            table_helper += '                                                                   (PFN_xrVoidFunction *)&(table)->command))\n'
         return table_helper
 
     def _feature_name_to_core_version(self, ext_name: str):
@@ -148,6 +201,32 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
             'xrNegotiateLoaderRuntimeInterface',
             'xrNegotiateLoaderApiLayerInterface',
         ]
+
+        # Write out each command using it's function pointer for each command
+        def output_member(cur_cmd):
+            # Remove 'xr' from proto name
+            base_name = cur_cmd.name[2:]
+            member = ''
+
+            # If a protect statement exists, use it.
+            if cur_cmd.protect_value:
+                member += f'#if {cur_cmd.protect_string}\n'
+
+            member += f'    PFN_{cur_cmd.name} {base_name};\n'
+
+            # If a protect statement exists, wrap it up.
+            if cur_cmd.protect_value:
+                member += f'#endif // {cur_cmd.protect_string}\n'
+            return member
+
+        # The frame loop commands come first, together.  They are all core commands, so they are in both tables.
+        all_commands = {cur_cmd.name: cur_cmd for cur_cmd in self.core_commands + self.ext_commands}
+        hot_commands = [all_commands[name] for name in HOT_DISPATCH_COMMANDS if name in all_commands]
+        table += '    // ---- Frame loop commands, first so that they share as few cache lines as possible\n'
+        for cur_cmd in hot_commands:
+            assert self.isCoreExtensionName(cur_cmd.ext_name)
+            table += output_member(cur_cmd)
+
         # Loop through both core commands, and extension commands
         # Outputting the core commands first, and then the extension commands.
         for x in range(0, 2):
@@ -167,8 +246,8 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
                         # Skip anything that is not core or XR_EXT_debug_utils in the loader dispatch table
                         continue
 
-                # Skip loader-use-only functions in dispatch tables.
-                if cur_cmd.name in LOADER_FUNCTIONS:
+                # Skip loader-use-only functions in dispatch tables, and the frame loop commands already written.
+                if cur_cmd.name in LOADER_FUNCTIONS or cur_cmd.name in HOT_DISPATCH_COMMANDS:
                     continue
 
                 # If we've switched to a new "feature" print out a comment on what it is.  Usually,
@@ -176,19 +255,13 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
                 assert cur_cmd.ext_name
                 table += cur_extension.format_if_extension_changed(cur_cmd.ext_name, "\n    // ---- {} commands\n")
 
-                # Remove 'xr' from proto name
-                base_name = cur_cmd.name[2:]
+                table += output_member(cur_cmd)
 
-                # If a protect statement exists, use it.
-                if cur_cmd.protect_value:
-                    table += f'#if {cur_cmd.protect_string}\n'
-
-                # Write out each command using it's function pointer for each command
-                table += f'    PFN_{cur_cmd.name} {base_name};\n'
-
-                # If a protect statement exists, wrap it up.
-                if cur_cmd.protect_value:
-                    table += f'#endif // {cur_cmd.protect_string}\n'
+        if self.isLazy():
+            table += '\n'
+            table += '    // ---- For resolving commands on first use, when the table is populated lazily\n'
+            table += '    XrInstance LazyInstance;\n'
+            table += '    PFN_xrGetInstanceProcAddr LazyGetInstanceProcAddr;\n'
         table += '};\n\n'
         return table
 
@@ -256,5 +329,34 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
 
                 if cur_cmd.protect_value:
                     table_helper += f'#endif // {cur_cmd.protect_string}\n'
+
+        if self.isLazy():
+            table_helper += '\n'
+            table_helper += '    table->LazyInstance = XR_NULL_HANDLE;\n'
+            table_helper += '    table->LazyGetInstanceProcAddr = NULL;\n'
         table_helper += '}\n\n'
+
+        if self.isLazy():
+            table_name, _ = self.tableNames()
+            short_name = table_name[len("XrGenerated"):]
+            table_helper += '// Helper function to populate an instance dispatch table lazily\n'
+            table_helper += f'void GeneratedXrPopulate{short_name}Lazy(struct {table_name} *table,\n'
+            table_helper += '                                      XrInstance instance,\n'
+            table_helper += '                                      PFN_xrGetInstanceProcAddr get_inst_proc_addr) {\n'
+            table_helper += '    memset(table, 0, sizeof(*table));\n'
+            table_helper += '    table->GetInstanceProcAddr = get_inst_proc_addr;\n'
+            table_helper += '    table->LazyInstance = instance;\n'
+            table_helper += '    table->LazyGetInstanceProcAddr = get_inst_proc_addr;\n'
+            table_helper += '}\n\n'
+            table_helper += f'PFN_xrVoidFunction GeneratedXrResolve{short_name}Command(const struct {table_name} *table,\n'
+            table_helper += '                                      const char *name,\n'
+            table_helper += '                                      PFN_xrVoidFunction *entry) {\n'
+            table_helper += '    PFN_xrVoidFunction function = NULL;\n'
+            table_helper += '    if (table->LazyGetInstanceProcAddr == NULL ||\n'
+            table_helper += '        XR_FAILED(table->LazyGetInstanceProcAddr(table->LazyInstance, name, &function))) {\n'
+            table_helper += '        return NULL;\n'
+            table_helper += '    }\n'
+            table_helper += '    *entry = function;\n'
+            table_helper += '    return function;\n'
+            table_helper += '}\n\n'
         return table_helper
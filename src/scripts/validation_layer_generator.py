@@ -40,8 +40,25 @@ VALID_USAGE_MANUALLY_DEFINED = set((
     'xrSessionBeginDebugUtilsLabelRegionEXT',
     'xrSessionEndDebugUtilsLabelRegionEXT',
     'xrSessionInsertDebugUtilsLabelEXT',
+    # Debug utils messages can also change the layer's settings at runtime
+    'xrSubmitDebugUtilsMessageEXT',
 ))
 
+# Per-frame commands whose parameter validation can be sampled with XR_CORE_VALIDATION_SAMPLE_RATE.
+# Calls that are not sampled still verify their first handle.
+VALID_USAGE_SAMPLED = set((
+    'xrWaitFrame',
+    'xrBeginFrame',
+    'xrEndFrame',
+    'xrLocateViews',
+    'xrLocateSpace',
+    'xrSyncActions',
+))
+
+# With XR_CORE_VALIDATION_FRAME_CACHE, the composition layers of an xrEndFrame call structurally unchanged since the
+# last full validation only get their handles checked; see CoreValidationFrameEndUnchanged.
+VALID_USAGE_FRAME_CACHED = 'xrEndFrame'
+
 LOADER_STRUCTS = [
     'XrApiLayerNextInfo',
     'XrApiLayerCreateInfo',
@@ -100,6 +117,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
             preamble += '\n'
             preamble += '#include "api_layer_platform_defines.h"\n'
             preamble += '#include "hex_and_handles.h"\n'
+            preamble += '#include "platform_trace.hpp"\n'
             preamble += '#include "validation_utils.h"\n'
             preamble += '#include "xr_dependencies.h"\n'
             preamble += '#include "xr_generated_dispatch_table.h"\n'
@@ -213,12 +231,12 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         next_chain_info += '// Prototype for validateNextChain command (it uses the validate structure commands so add it after\n'
         next_chain_info += 'NextChainResult ValidateNextChain(GenValidUsageXrInstanceInfo *instance_info,\n'
         next_chain_info += '                                  const std::string &command_name,\n'
-        next_chain_info += '                                  std::vector<GenValidUsageXrObjectInfo>& objects_info,\n'
+        next_chain_info += '                                  GenValidUsageXrObjectInfoList& objects_info,\n'
         next_chain_info += '                                  const void* next,\n'
-        next_chain_info += '                                  std::unordered_set<XrStructureType>& valid_ext_structs,\n'
-        next_chain_info += '                                  std::unordered_set<XrStructureType>& encountered_structs,\n'
-        next_chain_info += '                                  std::unordered_set<XrStructureType>& unknown_structs,\n'
-        next_chain_info += '                                  std::unordered_set<XrStructureType>& duplicate_structs);\n\n'
+        next_chain_info += '                                  const StructTypeSpan& valid_ext_structs,\n'
+        next_chain_info += '                                  StructTypeSet& encountered_structs,\n'
+        next_chain_info += '                                  StructTypeSet& unknown_structs,\n'
+        next_chain_info += '                                  StructTypeSet& duplicate_structs);\n\n'
         return next_chain_info
 
     # Generate C++ enum and utility function prototypes for validating
@@ -283,7 +301,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
             enum_value_validate += '                    const std::string &command_name,\n'
             enum_value_validate += '                    const std::string &validation_name,\n'
             enum_value_validate += '                    const std::string &item_name,\n'
-            enum_value_validate += '                    std::vector<GenValidUsageXrObjectInfo>& objects_info,\n'
+            enum_value_validate += '                    GenValidUsageXrObjectInfoList& objects_info,\n'
             enum_value_validate += '                    const %s value) {\n' % enum_tuple.name
             indent = 1
             enum_value_validate += self.writeIndent(indent)
@@ -436,7 +454,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
             if xr_struct.protect_value:
                 validation_internal_protos += f'#if {xr_struct.protect_string}\n'
             validation_internal_protos += 'XrResult ValidateXrStruct(GenValidUsageXrInstanceInfo *instance_info, const std::string &command_name,\n'
-            validation_internal_protos += '                          std::vector<GenValidUsageXrObjectInfo>& objects_info, bool check_members, bool check_pnext,\n'
+            validation_internal_protos += '                          GenValidUsageXrObjectInfoList& objects_info, bool check_members, bool check_pnext,\n'
             validation_internal_protos += f'                          const {xr_struct.name}* value);\n'
             if xr_struct.protect_value:
                 validation_internal_protos += f'#endif // {xr_struct.protect_string}\n'
@@ -449,12 +467,12 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         next_chain_info = ''
         next_chain_info += 'NextChainResult ValidateNextChain(GenValidUsageXrInstanceInfo *instance_info,\n'
         next_chain_info += '                                  const std::string &command_name,\n'
-        next_chain_info += '                                  std::vector<GenValidUsageXrObjectInfo>& objects_info,\n'
+        next_chain_info += '                                  GenValidUsageXrObjectInfoList& objects_info,\n'
         next_chain_info += '                                  const void* next,\n'
-        next_chain_info += '                                  std::unordered_set<XrStructureType>& valid_ext_structs,\n'
-        next_chain_info += '                                  std::unordered_set<XrStructureType>& encountered_structs,\n'
-        next_chain_info += '                                  std::unordered_set<XrStructureType>& unknown_structs,\n'
-        next_chain_info += '                                  std::unordered_set<XrStructureType>& duplicate_structs) {\n'
+        next_chain_info += '                                  const StructTypeSpan& valid_ext_structs,\n'
+        next_chain_info += '                                  StructTypeSet& encountered_structs,\n'
+        next_chain_info += '                                  StructTypeSet& unknown_structs,\n'
+        next_chain_info += '                                  StructTypeSet& duplicate_structs) {\n'
         next_chain_info += self.writeIndent(indent)
         next_chain_info += 'NextChainResult return_result = NEXT_CHAIN_RESULT_VALID;\n'
         # When validating structs along the next chain, we do it iteratively and only check the type to make sure it's allowed in the chain
@@ -464,14 +482,14 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         next_chain_info += 'while (next_header != nullptr) {\n'
         indent += 1
         next_chain_info += self.writeIndent(indent)
-        next_chain_info += 'bool valid_ext = valid_ext_structs.count(next_header->type) > 0;\n'
+        next_chain_info += 'bool valid_ext = valid_ext_structs.contains(next_header->type);\n'
         next_chain_info += self.writeIndent(indent)
         next_chain_info += 'if (!valid_ext) {\n'
         indent += 1
         next_chain_info += self.writeIndent(indent)
         next_chain_info += '// Not a known valid extension structure type for this next chain.\n'
         next_chain_info += self.writeIndent(indent)
-        next_chain_info += 'if (unknown_structs.count(next_header->type) > 0) {\n'
+        next_chain_info += 'if (unknown_structs.contains(next_header->type)) {\n'
         indent += 1
         next_chain_info += self.writeIndent(indent)
         next_chain_info += 'duplicate_structs.insert(next_header->type);\n'
@@ -491,7 +509,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         next_chain_info += self.writeIndent(indent)
         next_chain_info += '// Check to see if we\'ve already encountered this structure.\n'
         next_chain_info += self.writeIndent(indent)
-        next_chain_info += 'bool already_encountered_ext = encountered_structs.count(next_header->type) > 0;\n'
+        next_chain_info += 'bool already_encountered_ext = encountered_structs.contains(next_header->type);\n'
         next_chain_info += self.writeIndent(indent)
         next_chain_info += 'if (already_encountered_ext) {\n'
         indent += 1
@@ -586,9 +604,6 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         validation_header_info = ''
         cur_extension = CurrentExtensionTracker(self.conventions.api_version_prefix)
 
-        validation_header_info += '// Unordered Map associating pointer to a vector of session label information to a session\'s handle\n'
-        validation_header_info += 'extern std::unordered_map<XrSession, std::vector<GenValidUsageXrInternalSessionLabel*>*> g_xr_session_labels;\n\n'
-
         for x in range(0, 2):
             if x == 0:
                 commands = self.core_commands
@@ -632,6 +647,22 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         validation_header_info += '\n// Current API version of the Core Validation API Layer\n#define XR_CORE_VALIDATION_API_VERSION '
         validation_header_info += self.api_version_define
         validation_header_info += '\n'
+        validation_header_info += '\n// The checks compiled into the layer, set with the XR_CORE_VALIDATION_LEVEL CMake option.  Each level\n'
+        validation_header_info += '// includes those below it:\n'
+        validation_header_info += '//   HANDLES     handle parameters, their common parents, and begin/end state\n'
+        validation_header_info += '//   PARAMETERS  also pointers, arrays, enums, flags and structure members\n'
+        validation_header_info += '//   FULL        also next chains\n'
+        validation_header_info += '#define XR_CORE_VALIDATION_LEVEL_HANDLES 0\n'
+        validation_header_info += '#define XR_CORE_VALIDATION_LEVEL_PARAMETERS 1\n'
+        validation_header_info += '#define XR_CORE_VALIDATION_LEVEL_FULL 2\n'
+        validation_header_info += '#ifndef XR_CORE_VALIDATION_LEVEL\n'
+        validation_header_info += '#define XR_CORE_VALIDATION_LEVEL XR_CORE_VALIDATION_LEVEL_FULL\n'
+        validation_header_info += '#endif\n'
+        validation_header_info += '// Set with the XR_CORE_VALIDATION_TABLES CMake option: validate the structures that allow it from tables\n'
+        validation_header_info += '// of their members rather than with a function of their own, for a smaller layer.\n'
+        validation_header_info += '#ifndef XR_CORE_VALIDATION_TABLES\n'
+        validation_header_info += '#define XR_CORE_VALIDATION_TABLES 0\n'
+        validation_header_info += '#endif\n'
         validation_header_info += '#if defined(__GNUC__)\n'
         validation_header_info += '#pragma GCC diagnostic push\n'
         validation_header_info += '#pragma GCC diagnostic ignored "-Wunused-parameter"\n'
@@ -677,7 +708,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         verify_extensions += 'bool ValidateInstanceExtensionDependencies(GenValidUsageXrInstanceInfo *gen_instance_info,\n'
         verify_extensions += '                                           const std::string &command,\n'
         verify_extensions += '                                           const std::string &struct_name,\n'
-        verify_extensions += '                                           std::vector<GenValidUsageXrObjectInfo>& objects_info,\n'
+        verify_extensions += '                                           GenValidUsageXrObjectInfoList& objects_info,\n'
         verify_extensions += '                                           std::vector<std::string> &extensions) {\n'
         indent = 1
         if number_of_instance_extensions > 0:
@@ -765,7 +796,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         verify_extensions += 'bool ValidateSystemExtensionDependencies(GenValidUsageXrInstanceInfo *gen_instance_info,\n'
         verify_extensions += '                                         const std::string &command,\n'
         verify_extensions += '                                         const std::string &struct_name,\n'
-        verify_extensions += '                                         std::vector<GenValidUsageXrObjectInfo>& objects_info,\n'
+        verify_extensions += '                                         GenValidUsageXrObjectInfoList& objects_info,\n'
         verify_extensions += '                                         std::vector<std::string> &extensions) {\n'
         indent = 1
         if number_of_system_extensions > 0:
@@ -1008,28 +1039,15 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         verify_parent += '}\n\n'
         return verify_parent
 
-    # Generate inline C++ code to check if a 'next' chain is valid for the current structure.
+    # The structure types permitted in the 'next' chain of a structure, without duplicates.
     #   self            the ValidationSourceOutputGenerator object
     #   struct_type     the name of the type of structure performing the validation check
-    #   member          the member generated in automatic_source_generator.py to validate
-    #   indent          the number of "tabs" to space in for the resulting C+ code.
-    def writeValidateStructNextCheck(self, struct_type, struct_name, member, indent):
-        validate_struct_next = self.writeIndent(indent)
-        validate_struct_next += 'if (check_pnext) {\n'
-        indent += 1
-        validate_struct_next += self.writeIndent(indent)
-        validate_struct_next += 'std::unordered_set<XrStructureType> valid_ext_structs;\n'
-        validate_struct_next += self.writeIndent(indent)
-        validate_struct_next += 'std::unordered_set<XrStructureType> unknown_structs;\n'
-        validate_struct_next += self.writeIndent(indent)
-        validate_struct_next += 'std::unordered_set<XrStructureType> duplicate_ext_structs;\n'
-        validate_struct_next += self.writeIndent(indent)
-        validate_struct_next += 'std::unordered_set<XrStructureType> encountered_structs;\n'
+    #   member          the 'next' member generated in automatic_source_generator.py
+    def getValidExtStructTypes(self, struct_type, member):
         # First add valid extension struct for this struct
+        valid_ext_struct_types = []
         if member.valid_extension_structs:
-            for valid_struct in member.valid_extension_structs:
-                validate_struct_next += self.writeIndent(indent)
-                validate_struct_next += f'valid_ext_structs.insert({self.genXrStructureType(valid_struct)});\n'
+            valid_ext_struct_types.extend(member.valid_extension_structs)
 
         # Then check if this struct is part of a relation group (extends a base struct) and add the base structs valid extension structs.
         for xr_struct in self.api_structures:
@@ -1045,10 +1063,43 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                     for parent_memeber in xr_struct.members:
                         if parent_memeber.name == 'next':
                             if parent_memeber.valid_extension_structs:
-                                for valid_struct in parent_memeber.valid_extension_structs:
-                                    validate_struct_next += self.writeIndent(indent)
-                                    validate_struct_next += f'valid_ext_structs.insert({self.genXrStructureType(valid_struct)});\n'
+                                valid_ext_struct_types.extend(parent_memeber.valid_extension_structs)
                     break
+        return list(dict.fromkeys(valid_ext_struct_types))
+
+    # Generate inline C++ code to check if a 'next' chain is valid for the current structure.
+    #   self            the ValidationSourceOutputGenerator object
+    #   struct_type     the name of the type of structure performing the validation check
+    #   member          the member generated in automatic_source_generator.py to validate
+    #   indent          the number of "tabs" to space in for the resulting C+ code.
+    def writeValidateStructNextCheck(self, struct_type, struct_name, member, indent):
+        validate_struct_next = self.writeIndent(indent)
+        validate_struct_next += 'if (check_pnext) {\n'
+        indent += 1
+        # The permitted types are a static array and the tracking sets live on the stack, so validating a next
+        # chain does not allocate.
+        valid_ext_struct_types = self.getValidExtStructTypes(struct_type, member)
+        if valid_ext_struct_types:
+            validate_struct_next += self.writeIndent(indent)
+            validate_struct_next += 'static const XrStructureType valid_ext_struct_types[] = {\n'
+            for valid_struct in valid_ext_struct_types:
+                validate_struct_next += self.writeIndent(indent + 1)
+                validate_struct_next += f'{self.genXrStructureType(valid_struct)},\n'
+            validate_struct_next += self.writeIndent(indent)
+            validate_struct_next += '};\n'
+            validate_struct_next += self.writeIndent(indent)
+            validate_struct_next += 'const StructTypeSpan valid_ext_structs{valid_ext_struct_types,\n'
+            validate_struct_next += self.writeIndent(indent)
+            validate_struct_next += '                                      sizeof(valid_ext_struct_types) / sizeof(valid_ext_struct_types[0])};\n'
+        else:
+            validate_struct_next += self.writeIndent(indent)
+            validate_struct_next += 'const StructTypeSpan valid_ext_structs{nullptr, 0};\n'
+        validate_struct_next += self.writeIndent(indent)
+        validate_struct_next += 'StructTypeSet unknown_structs;\n'
+        validate_struct_next += self.writeIndent(indent)
+        validate_struct_next += 'StructTypeSet duplicate_ext_structs;\n'
+        validate_struct_next += self.writeIndent(indent)
+        validate_struct_next += 'StructTypeSet encountered_structs;\n'
 
         validate_struct_next += self.writeIndent(indent)
         validate_struct_next += 'NextChainResult next_result = ValidateNextChain(instance_info, command_name, objects_info,\n'
@@ -1080,13 +1131,13 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         validate_struct_next += '}\n'
 
         validate_struct_next += self.writeIndent(indent)
-        validate_struct_next += 'if (unknown_structs.size() > 0) {\n'
+        validate_struct_next += 'if (!unknown_structs.empty()) {\n'
         validate_struct_next += self.writeIndent(indent + 1)
         validate_struct_next += 'std::string error_message = "Unknown structures type(s) in \\"next\\" chain for ";\n'
         validate_struct_next += self.writeIndent(indent + 1)
         validate_struct_next += f'error_message += "{struct_type} : ";\n'
         validate_struct_next += self.writeIndent(indent + 1)
-        validate_struct_next += 'error_message += StructTypesToString(instance_info, unknown_structs);\n'
+        validate_struct_next += 'error_message += StructTypesToString(instance_info, unknown_structs.span());\n'
         validate_struct_next += self.writeIndent(indent + 1)
         validate_struct_next += 'error_message += ", the valid structure type(s) are ";\n'
         validate_struct_next += self.writeIndent(indent + 1)
@@ -1103,13 +1154,13 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         validate_struct_next += '}\n'
 
         validate_struct_next += self.writeIndent(indent)
-        validate_struct_next += 'if (duplicate_ext_structs.size() > 0) {\n'
+        validate_struct_next += 'if (!duplicate_ext_structs.empty()) {\n'
         validate_struct_next += self.writeIndent(indent + 1)
         validate_struct_next += 'std::string error_message = "Multiple structures of the same type(s) in \\"next\\" chain for ";\n'
         validate_struct_next += self.writeIndent(indent + 1)
         validate_struct_next += f'error_message += "{struct_type} : ";\n'
         validate_struct_next += self.writeIndent(indent + 1)
-        validate_struct_next += 'error_message += StructTypesToString(instance_info, duplicate_ext_structs);\n'
+        validate_struct_next += 'error_message += StructTypesToString(instance_info, duplicate_ext_structs.span());\n'
         validate_struct_next += self.writeIndent(indent + 1)
         validate_struct_next += f'CoreValidLogMessage(instance_info, "VUID-{struct_type}-next-unique",\n'
         validate_struct_next += self.writeIndent(indent + 1)
@@ -1235,7 +1286,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         inline_enum_str += self.writeIndent(int_indent)
         inline_enum_str += f'oss_enum << "{error_prefix} {param_type} \\"{param_name}\\" enum value ";\n'
         inline_enum_str += self.writeIndent(int_indent)
-        inline_enum_str += f'oss_enum << Uint32ToHexString(static_cast<uint32_t>({pointer_string}{full_param_name}));\n'
+        inline_enum_str += f'oss_enum << ToHexChars(static_cast<uint32_t>({pointer_string}{full_param_name})).text;\n'
         inline_enum_str += self.writeIndent(int_indent)
         inline_enum_str += 'CoreValidLogMessage(%s, "VUID-%s-%s-parameter",\n' % (instance_info_string,
                                                                                   cmd_struct_name,
@@ -1324,8 +1375,8 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
             inline_flag_str += self.writeIndent(int_indent)
             inline_flag_str += f'oss_enum << "{error_prefix} {param_type} \\"{param_name}\\" flag value ";\n'
             inline_flag_str += self.writeIndent(int_indent)
-            inline_flag_str += 'oss_enum << Uint32ToHexString(static_cast<uint32_t>(%s%s));\n' % (pointer_string,
-                                                                                                  full_param_name)
+            inline_flag_str += 'oss_enum << ToHexChars(static_cast<uint32_t>(%s%s)).text;\n' % (pointer_string,
+                                                                                                       full_param_name)
             inline_flag_str += self.writeIndent(int_indent)
             inline_flag_str += 'oss_enum <<" contains illegal bit";\n'
             inline_flag_str += self.writeIndent(int_indent)
@@ -1435,7 +1486,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
             inline_validate_handle += self.writeIndent(indent)
             inline_validate_handle += f'oss << "Invalid {member_param.type} handle \\"{member_param.name}\\" ";\n'
             inline_validate_handle += self.writeIndent(indent)
-            inline_validate_handle += f'oss << HandleToHexString({mem_par_desc_name});\n'
+            inline_validate_handle += f'oss << ToHexChars({mem_par_desc_name}).text;\n'
             inline_validate_handle += self.writeIndent(indent)
             inline_validate_handle += 'CoreValidLogMessage(%s, "VUID-%s-%s-parameter",\n' % (instance_info_name,
                                                                                              vuid_name,
@@ -1965,6 +2016,328 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
 
         return param_member_contents
 
+    # Describe the member checks of a structure for the table-driven validation, as (member, check) pairs, or return
+    # None when the structure needs its generated function: base structures, handles that must share a parent, and
+    # members that are nested structures, arrays or pointers.
+    #   self            the ValidationSourceOutputGenerator object
+    #   xr_struct       the structure generated in automatic_source_generator.py
+    def getStructTableMembers(self, xr_struct):
+        if xr_struct.name in LOADER_STRUCTS or xr_struct.name in self.structs_with_no_type:
+            return None
+        if self.getRelationGroupForBaseStruct(xr_struct.name) is not None:
+            return None
+        if not any(member.name == 'type' for member in xr_struct.members):
+            return None
+        table_members = []
+        handle_count = 0
+        for member in xr_struct.members:
+            if member.name in ('type', 'next'):
+                if member.no_auto_validity:
+                    return None
+                continue
+            if member.no_auto_validity or xr_struct.returned_only:
+                continue
+            if member.name in ('enabledExtensionCount', 'enabledExtensionNames'):
+                return None
+            is_scalar = (member.pointer_count == 0 and not member.is_array and not member.is_static_array and
+                         not member.array_count_var and not member.pointer_count_var)
+            if member.is_handle:
+                # A second handle is checked against the first for a common parent, which the tables leave out
+                handle_count += 1
+                if not is_scalar or handle_count > 1 or xr_struct.name == 'XrSwapchainSubImage':
+                    return None
+                if member.is_optional:
+                    table_members.append((member, 'VALIDATE_XR_MEMBER_OPTIONAL_HANDLE'))
+                else:
+                    table_members.append((member, 'VALIDATE_XR_MEMBER_HANDLE'))
+            elif is_scalar and self.isEnumType(member.type):
+                table_members.append((member, 'VALIDATE_XR_MEMBER_ENUM'))
+            elif is_scalar and self.isFlagType(member.type):
+                if not self.flagHasValidValues(member.type):
+                    table_members.append((member, 'VALIDATE_XR_MEMBER_ZERO_FLAGS'))
+                elif member.is_optional:
+                    table_members.append((member, 'VALIDATE_XR_MEMBER_FLAGS'))
+                else:
+                    table_members.append((member, 'VALIDATE_XR_MEMBER_REQUIRED_FLAGS'))
+            elif (member.is_static_array and member.pointer_count == 0 and _CHAR_RE.search(member.type) and
+                  not member.is_null_terminated and not member.array_length_for):
+                table_members.append((member, 'VALIDATE_XR_MEMBER_STRING'))
+            else:
+                # Anything else must be left unchecked by the generated function too
+                contents = self.outputParamMemberContents(False, xr_struct.name, member, 'value->', 'instance_info',
+                                                          'command_name', False, None, None, None, False, 1)
+                if any(line.strip() and not line.strip().startswith('//') for line in contents.splitlines()):
+                    return None
+        return table_members
+
+    # Write the types and the engine of the table-driven structure validation, built with the
+    # XR_CORE_VALIDATION_TABLES CMake option.  The engine needs a validation function for each enum type by number, so
+    # this also numbers the enum types the tables use.
+    #   self            the ValidationSourceOutputGenerator object
+    def writeValidateStructTableEngine(self):
+        self.table_enum_ids = {}
+        for xr_struct in self.api_structures:
+            for member, check in self.getStructTableMembers(xr_struct) or []:
+                if check == 'VALIDATE_XR_MEMBER_ENUM' and member.type not in self.table_enum_ids:
+                    self.table_enum_ids[member.type] = len(self.table_enum_ids)
+
+        engine = '#if XR_CORE_VALIDATION_TABLES\n'
+        engine += '// Table-driven structure validation: instead of code of its own, each structure whose members can be\n'
+        engine += '// described gets a table of them, walked by ValidateXrStructWithTable.  Structures with nested structures,\n'
+        engine += '// arrays, pointers or handles that must share a parent keep their generated functions.\n'
+        engine += 'enum GenValidUsageXrMemberCheck : uint8_t {\n'
+        engine += '    VALIDATE_XR_MEMBER_ENUM,             // arg numbers the enum type for ValidateXrEnumById\n'
+        engine += '    VALIDATE_XR_MEMBER_FLAGS,            // Valid bits or zero\n'
+        engine += '    VALIDATE_XR_MEMBER_REQUIRED_FLAGS,   // Valid bits, at least one\n'
+        engine += '    VALIDATE_XR_MEMBER_ZERO_FLAGS,       // No bits are defined, so zero\n'
+        engine += '    VALIDATE_XR_MEMBER_STRING,           // Char array, arg the longest string it may hold\n'
+        engine += '    VALIDATE_XR_MEMBER_HANDLE,           // Valid, not XR_NULL_HANDLE\n'
+        engine += '    VALIDATE_XR_MEMBER_OPTIONAL_HANDLE,  // Valid or XR_NULL_HANDLE\n'
+        engine += '};\n\n'
+        engine += '// The handle check of a member table, for any type of handle\n'
+        engine += 'template <typename HandleType, ValidateXrHandleResult (*Verify)(const HandleType*)>\n'
+        engine += 'static ValidateXrHandleResult VerifyXrHandleFromTable(const void* handle) {\n'
+        engine += '    return Verify(static_cast<const HandleType*>(handle));\n'
+        engine += '}\n\n'
+        engine += 'struct GenValidUsageXrMemberTable {\n'
+        engine += '    const char* name;\n'
+        engine += '    const char* type_name;\n'
+        engine += '    uint32_t offset;\n'
+        engine += '    GenValidUsageXrMemberCheck check;\n'
+        engine += '    uint32_t arg;\n'
+        engine += '    ValidateXrFlagsResult (*validate_flags)(const XrFlags64 value);\n'
+        engine += '    ValidateXrHandleResult (*verify_handle)(const void* handle);\n'
+        engine += '};\n\n'
+        engine += 'struct GenValidUsageXrStructTable {\n'
+        engine += '    const char* name;\n'
+        engine += '    XrStructureType type;\n'
+        engine += '    const char* type_name;\n'
+        engine += '    bool has_next;\n'
+        engine += '    StructTypeSpan next_types;\n'
+        engine += '    const GenValidUsageXrMemberTable* members;\n'
+        engine += '    uint32_t member_count;\n'
+        engine += '};\n\n'
+
+        engine += 'static bool ValidateXrEnumById(uint32_t enum_id, GenValidUsageXrInstanceInfo *instance_info,\n'
+        engine += '                               const std::string &command_name, const std::string &validation_name,\n'
+        engine += '                               const std::string &item_name,\n'
+        engine += '                               GenValidUsageXrObjectInfoList& objects_info, int32_t value) {\n'
+        engine += '    switch (enum_id) {\n'
+        for enum_name, enum_id in self.table_enum_ids.items():
+            enum_tuple = [x for x in self.api_enums if x.name == self.resolve_type_name_alias(enum_name)][0]
+            if enum_tuple.protect_value:
+                engine += f'#if {enum_tuple.protect_string}\n'
+            engine += f'        case {enum_id}:\n'
+            engine += '            return ValidateXrEnum(instance_info, command_name, validation_name, item_name, objects_info,\n'
+            engine += f'                                  static_cast<{enum_name}>(value));\n'
+            if enum_tuple.protect_value:
+                engine += f'#endif // {enum_tuple.protect_string}\n'
+        engine += '        default:\n'
+        engine += '            return false;\n'
+        engine += '    }\n'
+        engine += '}\n\n'
+
+        engine += 'static XrResult ValidateXrStructWithTable(GenValidUsageXrInstanceInfo *instance_info, const std::string &command_name,\n'
+        engine += '                                          GenValidUsageXrObjectInfoList& objects_info, bool check_members,\n'
+        engine += '                                          bool check_pnext, const GenValidUsageXrStructTable& table,\n'
+        engine += '                                          const void* value) {\n'
+        engine += '    XrResult xr_result = XR_SUCCESS;\n'
+        engine += '    const XrBaseInStructure* header = reinterpret_cast<const XrBaseInStructure*>(value);\n'
+        engine += '    // The VUIDs and messages are only put together once a check fails\n'
+        engine += '    auto vuid = [&table](const char* member_name, const char* suffix) {\n'
+        engine += '        return std::string("VUID-") + table.name + "-" + member_name + "-" + suffix;\n'
+        engine += '    };\n'
+        engine += '    // Make sure the structure type is correct\n'
+        engine += '    if (header->type != table.type) {\n'
+        engine += '        InvalidStructureType(instance_info, command_name, objects_info, table.name, header->type,\n'
+        engine += '                             vuid("type", "type").c_str(), table.type, table.type_name);\n'
+        engine += '        xr_result = XR_ERROR_VALIDATION_FAILURE;\n'
+        engine += '    }\n'
+        engine += '#if XR_CORE_VALIDATION_LEVEL >= XR_CORE_VALIDATION_LEVEL_FULL\n'
+        engine += '    if (check_pnext && table.has_next) {\n'
+        engine += '        StructTypeSet unknown_structs;\n'
+        engine += '        StructTypeSet duplicate_ext_structs;\n'
+        engine += '        StructTypeSet encountered_structs;\n'
+        engine += '        NextChainResult next_result = ValidateNextChain(instance_info, command_name, objects_info,\n'
+        engine += '                                                         header->next, table.next_types,\n'
+        engine += '                                                         encountered_structs,\n'
+        engine += '                                                         unknown_structs,\n'
+        engine += '                                                         duplicate_ext_structs);\n'
+        engine += '        if (NEXT_CHAIN_RESULT_ERROR == next_result) {\n'
+        engine += '            CoreValidLogMessage(instance_info, vuid("next", "next"),\n'
+        engine += '                                VALID_USAGE_DEBUG_SEVERITY_ERROR, command_name, objects_info,\n'
+        engine += '                                std::string("Invalid structure(s) in \\"next\\" chain for ") + table.name +\n'
+        engine += '                                    " struct \\"next\\"");\n'
+        engine += '            xr_result = XR_ERROR_VALIDATION_FAILURE;\n'
+        engine += '        }\n'
+        engine += '        if (!unknown_structs.empty()) {\n'
+        engine += '            std::string error_message = "Unknown structures type(s) in \\"next\\" chain for ";\n'
+        engine += '            error_message += table.name;\n'
+        engine += '            error_message += " : ";\n'
+        engine += '            error_message += StructTypesToString(instance_info, unknown_structs.span());\n'
+        engine += '            error_message += ", the valid structure type(s) are ";\n'
+        engine += '            error_message += StructTypesToString(instance_info, table.next_types);\n'
+        engine += '            CoreValidLogMessage(instance_info, vuid("next", "unknown"),\n'
+        engine += '                                VALID_USAGE_DEBUG_SEVERITY_DEBUG, command_name,\n'
+        engine += '                                objects_info,\n'
+        engine += '                                error_message);\n'
+        engine += '        }\n'
+        engine += '        if (!duplicate_ext_structs.empty()) {\n'
+        engine += '            std::string error_message = "Multiple structures of the same type(s) in \\"next\\" chain for ";\n'
+        engine += '            error_message += table.name;\n'
+        engine += '            error_message += " : ";\n'
+        engine += '            error_message += StructTypesToString(instance_info, duplicate_ext_structs.span());\n'
+        engine += '            CoreValidLogMessage(instance_info, vuid("next", "unique"),\n'
+        engine += '                                VALID_USAGE_DEBUG_SEVERITY_DEBUG, command_name,\n'
+        engine += '                                objects_info,\n'
+        engine += '                                error_message);\n'
+        engine += '        }\n'
+        engine += '    }\n'
+        engine += '#endif // XR_CORE_VALIDATION_LEVEL >= XR_CORE_VALIDATION_LEVEL_FULL\n'
+        engine += '    // If we are not to check the rest of the members, just return here.\n'
+        engine += '    if (!check_members || XR_SUCCESS != xr_result) {\n'
+        engine += '        return xr_result;\n'
+        engine += '    }\n'
+        engine += '    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(value);\n'
+        engine += '    for (uint32_t member_index = 0; member_index < table.member_count; ++member_index) {\n'
+        engine += '        const GenValidUsageXrMemberTable& member = table.members[member_index];\n'
+        engine += '        switch (member.check) {\n'
+        engine += '            case VALIDATE_XR_MEMBER_ENUM: {\n'
+        engine += '                int32_t enum_value;\n'
+        engine += '                std::memcpy(&enum_value, bytes + member.offset, sizeof(enum_value));\n'
+        engine += '                if (!ValidateXrEnumById(member.arg, instance_info, command_name, table.name, member.name,\n'
+        engine += '                                        objects_info, enum_value)) {\n'
+        engine += '                    std::ostringstream oss_enum;\n'
+        engine += '                    oss_enum << table.name << " contains invalid " << member.type_name << " \\"" << member.name\n'
+        engine += '                             << "\\" enum value ";\n'
+        engine += '                    oss_enum << ToHexChars(static_cast<uint32_t>(enum_value)).text;\n'
+        engine += '                    CoreValidLogMessage(instance_info, vuid(member.name, "parameter"),\n'
+        engine += '                                        VALID_USAGE_DEBUG_SEVERITY_ERROR, command_name,\n'
+        engine += '                                        objects_info, oss_enum.str());\n'
+        engine += '                    return XR_ERROR_VALIDATION_FAILURE;\n'
+        engine += '                }\n'
+        engine += '                break;\n'
+        engine += '            }\n'
+        engine += '            case VALIDATE_XR_MEMBER_FLAGS:\n'
+        engine += '            case VALIDATE_XR_MEMBER_REQUIRED_FLAGS:\n'
+        engine += '            case VALIDATE_XR_MEMBER_ZERO_FLAGS: {\n'
+        engine += '                XrFlags64 flags_value;\n'
+        engine += '                std::memcpy(&flags_value, bytes + member.offset, sizeof(flags_value));\n'
+        engine += '                ValidateXrFlagsResult flags_result = member.validate_flags(flags_value);\n'
+        engine += '                if (VALIDATE_XR_MEMBER_ZERO_FLAGS == member.check) {\n'
+        engine += '                    // Flags must be zero in this case.\n'
+        engine += '                    if (VALIDATE_XR_FLAGS_ZERO != flags_result) {\n'
+        engine += '                        CoreValidLogMessage(instance_info, vuid(member.name, "zerobitmask"),\n'
+        engine += '                                            VALID_USAGE_DEBUG_SEVERITY_ERROR, command_name, objects_info,\n'
+        engine += '                                            std::string(member.type_name) + " \\"" + member.name +\n'
+        engine += '                                                "\\" flag must be zero");\n'
+        engine += '                        return XR_ERROR_VALIDATION_FAILURE;\n'
+        engine += '                    }\n'
+        engine += '                    break;\n'
+        engine += '                }\n'
+        engine += '                if (VALIDATE_XR_MEMBER_REQUIRED_FLAGS == member.check && VALIDATE_XR_FLAGS_ZERO == flags_result) {\n'
+        engine += '                    CoreValidLogMessage(instance_info, vuid(member.name, "requiredbitmask"),\n'
+        engine += '                                        VALID_USAGE_DEBUG_SEVERITY_ERROR, command_name, objects_info,\n'
+        engine += '                                        std::string(member.type_name) + " \\"" + member.name +\n'
+        engine += '                                            "\\" flag must be non-zero");\n'
+        engine += '                    return XR_ERROR_VALIDATION_FAILURE;\n'
+        engine += '                }\n'
+        engine += '                if (VALIDATE_XR_FLAGS_INVALID == flags_result) {\n'
+        engine += '                    std::ostringstream oss_enum;\n'
+        engine += '                    oss_enum << table.name << " invalid member " << member.type_name << " \\"" << member.name\n'
+        engine += '                             << "\\" flag value ";\n'
+        engine += '                    oss_enum << ToHexChars(static_cast<uint32_t>(flags_value)).text;\n'
+        engine += '                    oss_enum << " contains illegal bit";\n'
+        engine += '                    CoreValidLogMessage(instance_info, vuid(member.name, "parameter"),\n'
+        engine += '                                        VALID_USAGE_DEBUG_SEVERITY_ERROR, command_name,\n'
+        engine += '                                        objects_info, oss_enum.str());\n'
+        engine += '                    return XR_ERROR_VALIDATION_FAILURE;\n'
+        engine += '                }\n'
+        engine += '                break;\n'
+        engine += '            }\n'
+        engine += '            case VALIDATE_XR_MEMBER_STRING:\n'
+        engine += '                if (member.arg < std::strlen(reinterpret_cast<const char*>(bytes + member.offset))) {\n'
+        engine += '                    CoreValidLogMessage(instance_info, vuid(member.name, "parameter"),\n'
+        engine += '                                        VALID_USAGE_DEBUG_SEVERITY_ERROR, command_name, objects_info,\n'
+        engine += '                                        std::string("Structure ") + table.name + " member " + member.name +\n'
+        engine += '                                            " length is too long.");\n'
+        engine += '                    return XR_ERROR_VALIDATION_FAILURE;\n'
+        engine += '                }\n'
+        engine += '                break;\n'
+        engine += '            case VALIDATE_XR_MEMBER_HANDLE:\n'
+        engine += '            case VALIDATE_XR_MEMBER_OPTIONAL_HANDLE: {\n'
+        engine += '                ValidateXrHandleResult handle_result = member.verify_handle(bytes + member.offset);\n'
+        engine += '                if (handle_result == VALIDATE_XR_HANDLE_INVALID ||\n'
+        engine += '                    (VALIDATE_XR_MEMBER_HANDLE == member.check && handle_result != VALIDATE_XR_HANDLE_SUCCESS)) {\n'
+        engine += '                    uint64_t handle_value;\n'
+        engine += '                    std::memcpy(&handle_value, bytes + member.offset, sizeof(handle_value));\n'
+        engine += '                    std::ostringstream oss;\n'
+        engine += '                    oss << "Invalid " << member.type_name << " handle \\"" << member.name << "\\" ";\n'
+        engine += '                    oss << ToHexChars(handle_value).text;\n'
+        engine += '                    CoreValidLogMessage(instance_info, vuid(member.name, "parameter"),\n'
+        engine += '                                        VALID_USAGE_DEBUG_SEVERITY_ERROR, command_name,\n'
+        engine += '                                        objects_info, oss.str());\n'
+        engine += '                    return XR_ERROR_HANDLE_INVALID;\n'
+        engine += '                }\n'
+        engine += '                break;\n'
+        engine += '            }\n'
+        engine += '        }\n'
+        engine += '    }\n'
+        engine += '    // Everything checked out properly\n'
+        engine += '    return xr_result;\n'
+        engine += '}\n'
+        engine += '#endif // XR_CORE_VALIDATION_TABLES\n\n'
+        return engine
+
+    # Write the table describing a structure for ValidateXrStructWithTable, and its ValidateXrStruct calling it.
+    #   self            the ValidationSourceOutputGenerator object
+    #   xr_struct       the structure generated in automatic_source_generator.py
+    #   table_members   the (member, check) pairs from getStructTableMembers
+    def writeValidateStructTable(self, xr_struct, table_members):
+        struct_table = ''
+        next_member = [x for x in xr_struct.members if x.name == 'next']
+        next_types = self.getValidExtStructTypes(xr_struct.name, next_member[0]) if next_member else []
+        if next_types:
+            struct_table += f'static const XrStructureType {xr_struct.name}_next_types[] = {{\n'
+            for valid_struct in next_types:
+                struct_table += f'    {self.genXrStructureType(valid_struct)},\n'
+            struct_table += '};\n'
+        if table_members:
+            struct_table += f'static const GenValidUsageXrMemberTable {xr_struct.name}_members[] = {{\n'
+            for member, check in table_members:
+                arg = '0'
+                validate_flags = 'nullptr'
+                verify_handle = 'nullptr'
+                if check == 'VALIDATE_XR_MEMBER_ENUM':
+                    arg = str(self.table_enum_ids[member.type])
+                elif check == 'VALIDATE_XR_MEMBER_STRING':
+                    arg = member.static_array_sizes[0]
+                elif member.is_handle:
+                    verify_handle = f'VerifyXrHandleFromTable<{member.type}, Verify{member.type}Handle>'
+                else:
+                    validate_flags = f'ValidateXr{member.type[2:]}'
+                struct_table += f'    {{"{member.name}", "{member.type}", offsetof({xr_struct.name}, {member.name}), {check}, {arg},\n'
+                struct_table += f'     {validate_flags}, {verify_handle}}},\n'
+            struct_table += '};\n'
+        expected = self.genXrStructureType(xr_struct.name)
+        struct_table += f'static const GenValidUsageXrStructTable {xr_struct.name}_table = {{\n'
+        struct_table += f'    "{xr_struct.name}", {expected}, "{expected}", {"true" if next_member else "false"},\n'
+        if next_types:
+            struct_table += f'    {{{xr_struct.name}_next_types, {len(next_types)}}},\n'
+        else:
+            struct_table += '    {nullptr, 0},\n'
+        if table_members:
+            struct_table += f'    {xr_struct.name}_members, {len(table_members)}}};\n\n'
+        else:
+            struct_table += '    nullptr, 0};\n\n'
+        struct_table += 'XrResult ValidateXrStruct(GenValidUsageXrInstanceInfo *instance_info, const std::string &command_name,\n'
+        struct_table += '                          GenValidUsageXrObjectInfoList& objects_info, bool check_members, bool check_pnext,\n'
+        struct_table += '                          const %s* value) {\n' % xr_struct.name
+        struct_table += '    return ValidateXrStructWithTable(instance_info, command_name, objects_info, check_members, check_pnext,\n'
+        struct_table += f'                                     {xr_struct.name}_table, value);\n'
+        struct_table += '}\n\n'
+        return struct_table
+
     # Write the validation function for every struct we know about.
     #   self            the ValidationSourceOutputGenerator object
 
@@ -1984,8 +2357,13 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
 
             if xr_struct.protect_value:
                 struct_check += f'#if {xr_struct.protect_string}\n'
+            table_members = self.getStructTableMembers(xr_struct)
+            if table_members is not None:
+                struct_check += '#if XR_CORE_VALIDATION_TABLES\n'
+                struct_check += self.writeValidateStructTable(xr_struct, table_members)
+                struct_check += '#else\n'
             struct_check += 'XrResult ValidateXrStruct(GenValidUsageXrInstanceInfo *instance_info, const std::string &command_name,\n'
-            struct_check += '                          std::vector<GenValidUsageXrObjectInfo>& objects_info, bool check_members, bool check_pnext,\n'
+            struct_check += '                          GenValidUsageXrObjectInfoList& objects_info, bool check_members, bool check_pnext,\n'
             struct_check += '                          const %s* value) {\n' % xr_struct.name
             setup_bail = False
             struct_check += '    XrResult xr_result = XR_SUCCESS;\n'
@@ -2091,8 +2469,10 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                     struct_check += '}\n'
                     continue
                 elif member.name == 'next':
+                    struct_check += '#if XR_CORE_VALIDATION_LEVEL >= XR_CORE_VALIDATION_LEVEL_FULL\n'
                     struct_check += self.writeValidateStructNextCheck(
                         xr_struct.name, 'value', member, indent)
+                    struct_check += '#endif // XR_CORE_VALIDATION_LEVEL >= XR_CORE_VALIDATION_LEVEL_FULL\n'
                 elif xr_struct.returned_only:
                     struct_check += self.writeIndent(indent)
                     struct_check += '// Skip checking member "%s" because this struct is returned only.\n' % member.name
@@ -2157,6 +2537,8 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
             struct_check += self.writeIndent(indent)
             struct_check += 'return xr_result;\n'
             struct_check += '}\n\n'
+            if table_members is not None:
+                struct_check += '#endif // XR_CORE_VALIDATION_TABLES\n'
             if xr_struct.protect_value:
                 struct_check += f'#endif // {xr_struct.protect_string}\n'
         struct_check += '\n'
@@ -2214,23 +2596,23 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         parent_check_string += self.writeIndent(indent)
         parent_check_string += 'std::ostringstream oss_error;\n'
         parent_check_string += self.writeIndent(indent)
-        parent_check_string += 'oss_error << "%s " << HandleToHexString(%s);\n' % (
+        parent_check_string += 'oss_error << "%s " << ToHexChars(%s).text;\n' % (
             first_handle_mem_param.type, first_handle_desc_name)
         if first_handle_tuple.name == cur_handle_tuple.parent:
             parent_check_string += self.writeIndent(indent)
             parent_check_string += f'oss_error << " must be a parent to {cur_handle_mem_param.type} ";\n'
             parent_check_string += self.writeIndent(indent)
-            parent_check_string += f'oss_error << HandleToHexString({cur_handle_desc_name});\n'
+            parent_check_string += f'oss_error << ToHexChars({cur_handle_desc_name}).text;\n'
         elif cur_handle_tuple.name == first_handle_tuple.parent:
             parent_check_string += self.writeIndent(indent)
             parent_check_string += f'oss_error << " must be a child of {cur_handle_mem_param.type} ";\n'
             parent_check_string += self.writeIndent(indent)
-            parent_check_string += f'oss_error << HandleToHexString({cur_handle_desc_name});\n'
+            parent_check_string += f'oss_error << ToHexChars({cur_handle_desc_name}).text;\n'
         else:
             parent_check_string += self.writeIndent(indent)
             parent_check_string += f'oss_error <<  " and {cur_handle_mem_param.type} ";\n'
             parent_check_string += self.writeIndent(indent)
-            parent_check_string += f'oss_error << HandleToHexString({cur_handle_desc_name});\n'
+            parent_check_string += f'oss_error << ToHexChars({cur_handle_desc_name}).text;\n'
             parent_check_string += self.writeIndent(indent)
             parent_check_string += 'oss_error <<  " must share a parent";\n'
         parent_check_string += self.writeIndent(indent)
@@ -2269,7 +2651,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         pre_validate_func += self.writeIndent(indent)
         pre_validate_func += 'XrResult xr_result = XR_SUCCESS;\n'
         pre_validate_func += self.writeIndent(indent)
-        pre_validate_func += 'std::vector<GenValidUsageXrObjectInfo> objects_info;\n'
+        pre_validate_func += 'GenValidUsageXrObjectInfoList objects_info;\n'
         first_param = cur_command.params[0]
         first_param_tuple = self.getHandle(first_param.type)
         if first_param_tuple is not None:
@@ -2338,16 +2720,25 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
 
         instance_info_variable = 'gen_instance_info' if first_param_tuple else 'nullptr'
 
-        # Check for non-optional null pointers
+        # Check for non-optional null pointers.  Only handle parameters are checked at every validation level; the
+        # checks of the others are compiled in from XR_CORE_VALIDATION_LEVEL_PARAMETERS up.
+        in_parameters_level = False
         for count, param in enumerate(cur_command.params):
             is_first = (count == 0)
             if is_first and first_param_tuple:
                 # This is the first param, which we already validated as being a handle above. Skip this here.
                 continue
-            if not is_first and param.is_handle and not param.pointer_count > 0:
+            is_plain_handle = param.is_handle and not param.pointer_count > 0
+            if is_plain_handle and in_parameters_level:
+                pre_validate_func += '#endif // XR_CORE_VALIDATION_LEVEL >= XR_CORE_VALIDATION_LEVEL_PARAMETERS\n'
+                in_parameters_level = False
+            if not is_first and is_plain_handle:
                 pre_validate_func += self.writeIndent(indent)
                 pre_validate_func += f'objects_info.emplace_back({param.name}, {self.genXrObjectType(param.type)});\n'
             if not param.no_auto_validity:
+                if not is_plain_handle and not in_parameters_level:
+                    pre_validate_func += '#if XR_CORE_VALIDATION_LEVEL >= XR_CORE_VALIDATION_LEVEL_PARAMETERS\n'
+                    in_parameters_level = True
                 pre_validate_func += self.outputParamMemberContents(True, cur_command.name, param, '',
                                                                     instance_info_variable,
                                                                     command_name_string,
@@ -2359,6 +2750,8 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                                                                     indent)
                 wrote_handle_check_proto = True
             count = count + 1
+        if in_parameters_level:
+            pre_validate_func += '#endif // XR_CORE_VALIDATION_LEVEL >= XR_CORE_VALIDATION_LEVEL_PARAMETERS\n'
 
         # If this command needs to be checked to ensure that it is executing between
         # a "begin" and an "end" command, do so.
@@ -2607,7 +3000,8 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
             elif is_destroy:
                 if last_param.type == 'XrSession':
                     next_validate_func += '\n        // Clean up any labels associated with this session\n'
-                    next_validate_func += '        CoreValidationDeleteSessionLabels(session);\n\n'
+                    next_validate_func += '        CoreValidationDeleteSessionLabels(session);\n'
+                    next_validate_func += '        CoreValidationDeleteSessionFrameCache(session);\n\n'
                 # Only remove the handle from our map if the runtime returned success
                 next_validate_func += '        if (XR_SUCCEEDED(result)) {\n'
 
@@ -2684,6 +3078,13 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
             auto_validate_func += 'return test_result;\n'
             auto_validate_func += self.writeIndent(1)
             auto_validate_func += '}\n'
+        if cur_command.name in VALID_USAGE_SAMPLED:
+            auto_validate_func = self.wrapSampledValidateInputs(cur_command, auto_validate_func)
+        # Trace the whole command, the calldown included, whether or not this call is sampled
+        prototype_end = auto_validate_func.index('{\n') + 2
+        auto_validate_func = (auto_validate_func[:prototype_end] +
+                              f'    XR_TRACE_SCOPE("core_validation {cur_command.name}");\n' +
+                              auto_validate_func[prototype_end:])
         # Make the calldown to the next layer
         auto_validate_func += self.writeIndent(1)
         if has_return:
@@ -2699,6 +3100,38 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         auto_validate_func += '}\n\n'
         return auto_validate_func
 
+    # Wrap the pre-validate call of a top-level function so that it only runs on the calls picked by
+    # CoreValidationSampleCall, and for xrEndFrame only when its layers changed; the others only verify the first handle.
+    #   self            the ValidationSourceOutputGenerator object
+    #   cur_command     the command generated in automatic_source_generator.py to validate
+    #   func            the top-level function generated so far, ending after the pre-validate call
+    def wrapSampledValidateInputs(self, cur_command, func):
+        prototype_end = func.index('{\n') + 2
+        first_param = cur_command.params[0]
+        assert cur_command.return_type.text == 'XrResult' and self.getHandle(first_param.type) is not None
+        wrapped = func[:prototype_end]
+        wrapped += self.writeIndent(1)
+        wrapped += 'static std::atomic<uint32_t> call_count{0};\n'
+        frame_cached = cur_command.name == VALID_USAGE_FRAME_CACHED
+        wrapped += self.writeIndent(1)
+        if frame_cached:
+            args = ', '.join(param.name for param in cur_command.params)
+            wrapped += f'if (CoreValidationSampleCall(call_count) && !CoreValidationFrameEndUnchanged({args})) {{\n'
+        else:
+            wrapped += 'if (CoreValidationSampleCall(call_count)) {\n'
+        for line in func[prototype_end:].splitlines(True):
+            wrapped += self.writeIndent(1) + line
+        if frame_cached:
+            wrapped += self.writeIndent(2)
+            wrapped += f'CoreValidationFrameEndValidated({first_param.name});\n'
+        wrapped += self.writeIndent(1)
+        wrapped += f'}} else if (VALIDATE_XR_HANDLE_SUCCESS != Verify{first_param.type}Handle(&{first_param.name})) {{\n'
+        wrapped += self.writeIndent(2)
+        wrapped += 'return XR_ERROR_HANDLE_INVALID;\n'
+        wrapped += self.writeIndent(1)
+        wrapped += '}\n'
+        return wrapped
+
     # Implementation for generated validation commands
     #   self                the ValidationSourceOutputGenerator object
     def outputValidationSourceFuncs(self):
@@ -2707,8 +3140,6 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         cur_extension_name = ''
 
         # First, output the mapping and mutex items
-        validation_source_funcs += '// Unordered Map associating pointer to a vector of session label information to a session\'s handle\n'
-        validation_source_funcs += 'std::unordered_map<XrSession, std::vector<GenValidUsageXrInternalSessionLabel*>*> g_xr_session_labels;\n\n'
         validation_source_funcs += self.outputInfoMapDeclarations(extern=False)
         validation_source_funcs += '\n'
         validation_source_funcs += self.outputValidationInternalProtos()
@@ -2765,6 +3196,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         validation_source_funcs += self.writeVerifyExtensions()
         validation_source_funcs += self.writeValidateHandleChecks()
         validation_source_funcs += self.writeValidateHandleParent()
+        validation_source_funcs += self.writeValidateStructTableEngine()
         validation_source_funcs += self.writeValidateStructFuncs()
         validation_source_funcs += self.outputValidationSourceNextChainFunc()
 
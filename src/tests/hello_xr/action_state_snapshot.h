@@ -0,0 +1,67 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// The states of a set of actions, queried together once after each xrSyncActions, for the code that reads them
+// during the frame.  OpenXR has no call that gets several action states at once, so each state is still one query
+// through the loader, the API layers and the runtime; but it is made once per action and subaction path a frame,
+// however many places read it, and every reader sees the states of the same sync.
+//
+// Register each action and subaction path once, after creating the action, and keep the slot returned; registering
+// the same one again, e.g. from another system that reads it, returns the same slot rather than adding a query.
+class ActionStateSnapshot {
+   public:
+    using Slot = size_t;
+
+    Slot AddBoolean(XrAction action, XrPath subactionPath = XR_NULL_PATH) {
+        return Add(m_booleanQueries, m_booleans, {XR_TYPE_ACTION_STATE_BOOLEAN}, action, subactionPath);
+    }
+    Slot AddFloat(XrAction action, XrPath subactionPath = XR_NULL_PATH) {
+        return Add(m_floatQueries, m_floats, {XR_TYPE_ACTION_STATE_FLOAT}, action, subactionPath);
+    }
+    Slot AddPose(XrAction action, XrPath subactionPath = XR_NULL_PATH) {
+        return Add(m_poseQueries, m_poses, {XR_TYPE_ACTION_STATE_POSE}, action, subactionPath);
+    }
+
+    // Query every registered state; call after each xrSyncActions.
+    void Update(XrSession session) {
+        Query(m_booleanQueries, m_booleans, session, xrGetActionStateBoolean);
+        Query(m_floatQueries, m_floats, session, xrGetActionStateFloat);
+        Query(m_poseQueries, m_poses, session, xrGetActionStatePose);
+    }
+
+    const XrActionStateBoolean& Boolean(Slot slot) const { return m_booleans[slot]; }
+    const XrActionStateFloat& Float(Slot slot) const { return m_floats[slot]; }
+    const XrActionStatePose& Pose(Slot slot) const { return m_poses[slot]; }
+
+   private:
+    template <typename State>
+    static Slot Add(std::vector<XrActionStateGetInfo>& queries, std::vector<State>& states, const State& initial,
+                    XrAction action, XrPath subactionPath) {
+        for (Slot slot = 0; slot < queries.size(); ++slot) {
+            if (queries[slot].action == action && queries[slot].subactionPath == subactionPath) {
+                return slot;
+            }
+        }
+        queries.push_back({XR_TYPE_ACTION_STATE_GET_INFO, nullptr, action, subactionPath});
+        states.push_back(initial);
+        return queries.size() - 1;
+    }
+
+    template <typename State, typename GetState>
+    static void Query(const std::vector<XrActionStateGetInfo>& queries, std::vector<State>& states, XrSession session,
+                      GetState getState) {
+        for (size_t i = 0; i < queries.size(); ++i) {
+            CHECK_XRCMD(getState(session, &queries[i], &states[i]));
+        }
+    }
+
+    std::vector<XrActionStateGetInfo> m_booleanQueries;
+    std::vector<XrActionStateBoolean> m_booleans;
+    std::vector<XrActionStateGetInfo> m_floatQueries;
+    std::vector<XrActionStateFloat> m_floats;
+    std::vector<XrActionStateGetInfo> m_poseQueries;
+    std::vector<XrActionStatePose> m_poses;
+};
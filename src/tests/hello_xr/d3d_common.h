@@ -8,7 +8,8 @@
 
 #include <DirectXMath.h>
 
-struct ModelConstantBuffer {
+// Per-instance vertex data, row by row: unlike the constant buffer, not transposed for the shader.
+struct ModelInstance {
     DirectX::XMFLOAT4X4 Model;
 };
 struct ViewProjectionConstantBuffer {
@@ -24,17 +25,15 @@ constexpr char ShaderHlsl[] = R"_(
     struct Vertex {
         float3 Pos : POSITION;
         float3 Color : COLOR0;
+        row_major float4x4 Model : MODEL;  // Per instance
     };
-    cbuffer ModelConstantBuffer : register(b0) {
-        float4x4 Model;
-    };
-    cbuffer ViewProjectionConstantBuffer : register(b1) {
+    cbuffer ViewProjectionConstantBuffer : register(b0) {
         float4x4 ViewProjection;
     };
 
     PSVertex MainVS(Vertex input) {
        PSVertex output;
-       output.Pos = mul(mul(float4(input.Pos, 1), Model), ViewProjection);
+       output.Pos = mul(mul(float4(input.Pos, 1), input.Model), ViewProjection);
        output.Color = input.Color;
        return output;
     }
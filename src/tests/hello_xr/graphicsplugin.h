@@ -30,16 +30,103 @@ struct IGraphicsPlugin {
     virtual std::vector<XrSwapchainImageBaseHeader*> AllocateSwapchainImageStructs(
         uint32_t capacity, const XrSwapchainCreateInfo& swapchainCreateInfo) = 0;
 
-    // Render to a swapchain image for a projection view.
+    // Free the swapchain image structures and what the plugin made to render to their images, such as depth buffers, before
+    // the swapchains are destroyed, so that another session can create its own with the same device.  Outside of BeginFrame
+    // and EndFrame; waits for the GPU to finish rendering to the images.
+    virtual void ReleaseSwapchainImages() = 0;
+
+    // Bracket the RenderView or RenderMultiView calls of one frame.  A plugin may defer submitting the frame's rendering to
+    // EndFrame, so the swapchain images are released only after it.
+    virtual void BeginFrame() {}
+    virtual void EndFrame() {}
+
+    // Render to a swapchain image for a projection view, or to layer subImage.imageArrayIndex of a texture array swapchain
+    // image.
     virtual void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                             int64_t swapchainFormat, const std::vector<Cube>& cubes) = 0;
 
+    // Select the format of a depth swapchain that RenderViewWithDepth can render to, or 0 if the plugin cannot render to depth
+    // swapchains or supports none of the runtime's formats.
+    virtual int64_t SelectDepthSwapchainFormat(const std::vector<int64_t>& /*runtimeFormats*/) const { return 0; }
+
+    // Render like RenderView, with layer depthArrayIndex of a texture array depth swapchain image as the depth buffer, in
+    // place of one of the plugin's own, so the depth can be submitted with XR_KHR_composition_layer_depth.
+    virtual void RenderViewWithDepth(const XrCompositionLayerProjectionView& /*layerView*/,
+                                     const XrSwapchainImageBaseHeader* /*swapchainImage*/, int64_t /*swapchainFormat*/,
+                                     const XrSwapchainImageBaseHeader* /*depthImage*/, uint32_t /*depthArrayIndex*/,
+                                     const std::vector<Cube>& /*cubes*/) {
+        THROW("Depth swapchains are not supported by this graphics plugin");
+    }
+
+    // Select the formats of the motion vector and depth swapchains that RenderMotionVectors renders to, or return false if the
+    // plugin cannot render the motion vectors of XR_FB_space_warp, or supports none of the runtime's formats.
+    virtual bool SelectSpaceWarpSwapchainFormats(const std::vector<int64_t>& /*runtimeFormats*/, int64_t* /*motionVectorFormat*/,
+                                                 int64_t* /*depthFormat*/) const {
+        return false;
+    }
+
+    // Between BeginFrame and EndFrame, render how far the cubes moved since the previous frame, as seen from a projection
+    // view, to layer arrayIndex of a motion vector swapchain image, and their depth to the same layer of a depth swapchain
+    // image, for XR_FB_space_warp.  previousCubes[i] is cubes[i] a frame earlier; the cubes past its end did not move.  The
+    // motion of the view itself is left out, the runtime has it from the view poses.
+    virtual void RenderMotionVectors(const XrCompositionLayerProjectionView& /*layerView*/,
+                                     const XrSwapchainImageBaseHeader* /*motionVectorImage*/,
+                                     const XrSwapchainImageBaseHeader* /*depthImage*/, uint32_t /*arrayIndex*/,
+                                     const std::vector<Cube>& /*cubes*/, const std::vector<Cube>& /*previousCubes*/) {
+        THROW("Space warp is not supported by this graphics plugin");
+    }
+
+    // Whether RenderMultiView can render every view of the stereo view configuration in one pass, after InitializeDevice.
+    virtual bool SupportsMultiview() const { return false; }
+
+    // Render to a texture array swapchain image for all projection views at once: layerViews[i] to array layer i.
+    virtual void RenderMultiView(const std::vector<XrCompositionLayerProjectionView>& /*layerViews*/,
+                                 const XrSwapchainImageBaseHeader* /*swapchainImage*/, int64_t /*swapchainFormat*/,
+                                 const std::vector<Cube>& /*cubes*/) {
+        THROW("Multiview rendering is not supported by this graphics plugin");
+    }
+
+    // Whether BeginFrame, RenderView, RenderMultiView and EndFrame may be called from a thread other than the one that
+    // initialized the device.  Not for OpenGL and OpenGL ES, whose context is current only on the thread that created it.
+    virtual bool SupportsRenderThread() const { return true; }
+
+    // Take the GPU time of a frame bracketed by BeginFrame and EndFrame, in milliseconds.  A plugin reads a frame's timestamps
+    // when it reuses the frame's resources, a few frames later, so this returns each frame's time once, some frames late.
+    // False if there is no new frame time, or if the plugin does not measure GPU time.
+    virtual bool TakeGpuFrameTime(double* /*milliseconds*/) { return false; }
+
+    // The most views of a frame whose GPU times a plugin measures; the views after them are still in the frame time.
+    static constexpr uint32_t MaxTimedViews = 4;
+
+    // Take the GPU times of the views of the frame whose time TakeGpuFrameTime last returned, in milliseconds, in the order
+    // they were rendered: one for each RenderView call, or one for a RenderMultiView call.  Returns the number of views
+    // timed, 0 if they are already taken, or if the plugin does not measure the GPU time of views.
+    virtual uint32_t TakeGpuViewTimes(std::array<double, MaxTimedViews>& /*milliseconds*/) { return 0; }
+
+    // Whether LateLatchViews can update the views of a frame after they are rendered.  Only a plugin that submits a frame
+    // in EndFrame, and whose recorded draws read their transforms from memory the CPU can still write, can.
+    virtual bool SupportsLateLatching() const { return false; }
+
+    // Between the last RenderView or RenderMultiView of a frame and EndFrame, make the frame render from the views located
+    // again: layerViews[i] is the layer view of the i-th call to RenderView, or the first layer view of RenderMultiView,
+    // with the latest pose.  The fov is unchanged; views that move together are corrected as one.
+    virtual void LateLatchViews(const std::vector<XrCompositionLayerProjectionView>& /*layerViews*/) {
+        THROW("Late latching is not supported by this graphics plugin");
+    }
+
     // Get recommended number of sub-data element samples in view (recommendedSwapchainSampleCount)
     // if supported by the graphics plugin. A supported value otherwise.
     virtual uint32_t GetSupportedSwapchainSampleCount(const XrViewConfigurationView& view) {
         return view.recommendedSwapchainSampleCount;
     }
 
+    // An estimate of the memory that one image of a swapchain takes, with the depth buffer the plugin renders it with, in
+    // bytes, ignoring padding and compression; for tuning the render scale and formats to a device.  The color formats
+    // SelectColorSwapchainFormat selects, and the depth formats, take 4 bytes a sample unless a plugin says otherwise.
+    virtual uint64_t GetSwapchainImageMemorySize(const XrSwapchainCreateInfo& createInfo) const {
+        return (uint64_t)createInfo.width * createInfo.height * createInfo.arraySize * createInfo.sampleCount * (4 + 4);
+    }
+
     // Perform required steps after updating Options
     virtual void UpdateOptions(const std::shared_ptr<struct Options>& options) = 0;
 };
@@ -94,15 +94,17 @@ struct D3D11GraphicsPlugin : public IGraphicsPlugin {
         const D3D11_INPUT_ELEMENT_DESC vertexDesc[] = {
             {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
             {"COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+            {"MODEL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"MODEL", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"MODEL", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"MODEL", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
         };
 
         CHECK_HRCMD(m_device->CreateInputLayout(vertexDesc, (UINT)ArraySize(vertexDesc), vertexShaderBytes->GetBufferPointer(),
                                                 vertexShaderBytes->GetBufferSize(), &m_inputLayout));
 
-        const CD3D11_BUFFER_DESC modelConstantBufferDesc(sizeof(ModelConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
-        CHECK_HRCMD(m_device->CreateBuffer(&modelConstantBufferDesc, nullptr, m_modelCBuffer.ReleaseAndGetAddressOf()));
-
-        const CD3D11_BUFFER_DESC viewProjectionConstantBufferDesc(sizeof(ViewProjectionConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
+        const CD3D11_BUFFER_DESC viewProjectionConstantBufferDesc(sizeof(ViewProjectionConstantBuffer), D3D11_BIND_CONSTANT_BUFFER,
+                                                                  D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
         CHECK_HRCMD(
             m_device->CreateBuffer(&viewProjectionConstantBufferDesc, nullptr, m_viewProjectionCBuffer.ReleaseAndGetAddressOf()));
 
@@ -113,6 +115,17 @@ struct D3D11GraphicsPlugin : public IGraphicsPlugin {
         const D3D11_SUBRESOURCE_DATA indexBufferData{Geometry::c_cubeIndices};
         const CD3D11_BUFFER_DESC indexBufferDesc(sizeof(Geometry::c_cubeIndices), D3D11_BIND_INDEX_BUFFER);
         CHECK_HRCMD(m_device->CreateBuffer(&indexBufferDesc, &indexBufferData, m_cubeIndexBuffer.ReleaseAndGetAddressOf()));
+
+        for (FrameTimer& timer : m_frameTimers) {
+            const CD3D11_QUERY_DESC disjointDesc(D3D11_QUERY_TIMESTAMP_DISJOINT);
+            CHECK_HRCMD(m_device->CreateQuery(&disjointDesc, timer.disjoint.ReleaseAndGetAddressOf()));
+            const CD3D11_QUERY_DESC timestampDesc(D3D11_QUERY_TIMESTAMP);
+            CHECK_HRCMD(m_device->CreateQuery(&timestampDesc, timer.begin.ReleaseAndGetAddressOf()));
+            CHECK_HRCMD(m_device->CreateQuery(&timestampDesc, timer.end.ReleaseAndGetAddressOf()));
+            for (ComPtr<ID3D11Query>& viewEnd : timer.viewEnds) {
+                CHECK_HRCMD(m_device->CreateQuery(&timestampDesc, viewEnd.ReleaseAndGetAddressOf()));
+            }
+        }
     }
 
     int64_t SelectColorSwapchainFormat(const std::vector<int64_t>& runtimeFormats) const override {
@@ -154,6 +167,13 @@ struct D3D11GraphicsPlugin : public IGraphicsPlugin {
         return swapchainImageBase;
     }
 
+    // The device context keeps what its commands still use alive, so the images need no wait.
+    void ReleaseSwapchainImages() override {
+        m_colorToDepthMap.clear();
+        m_depthSwapchainViews.clear();
+        m_swapchainImageBuffers.clear();
+    }
+
     ComPtr<ID3D11DepthStencilView> GetDepthStencilView(ID3D11Texture2D* colorTexture) {
         // If a depth-stencil view has already been created for this back-buffer, use it.
         auto depthBufferIt = m_colorToDepthMap.find(colorTexture);
@@ -161,14 +181,15 @@ struct D3D11GraphicsPlugin : public IGraphicsPlugin {
             return depthBufferIt->second;
         }
 
-        // This back-buffer has no corresponding depth-stencil texture, so create one with matching dimensions.
+        // This back-buffer has no corresponding depth-stencil texture, so create one with matching dimensions.  The layers of
+        // a texture array are rendered one at a time, so they share one depth layer.
         D3D11_TEXTURE2D_DESC colorDesc;
         colorTexture->GetDesc(&colorDesc);
 
         D3D11_TEXTURE2D_DESC depthDesc{};
         depthDesc.Width = colorDesc.Width;
         depthDesc.Height = colorDesc.Height;
-        depthDesc.ArraySize = colorDesc.ArraySize;
+        depthDesc.ArraySize = 1;
         depthDesc.MipLevels = 1;
         depthDesc.Format = DXGI_FORMAT_R32_TYPELESS;
         depthDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_DEPTH_STENCIL;
@@ -187,66 +208,196 @@ struct D3D11GraphicsPlugin : public IGraphicsPlugin {
 
     void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                     int64_t swapchainFormat, const std::vector<Cube>& cubes) override {
-        CHECK(layerView.subImage.imageArrayIndex == 0);  // Texture arrays not supported.
+        ID3D11Texture2D* const colorTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(swapchainImage)->texture;
+        RenderViewTo(layerView, colorTexture, swapchainFormat, GetDepthStencilView(colorTexture).Get(), cubes);
+        EndViewTimer();
+    }
+
+    int64_t SelectDepthSwapchainFormat(const std::vector<int64_t>& runtimeFormats) const override {
+        constexpr DXGI_FORMAT SupportedDepthSwapchainFormats[] = {
+            DXGI_FORMAT_D32_FLOAT,
+            DXGI_FORMAT_D24_UNORM_S8_UINT,
+            DXGI_FORMAT_D16_UNORM,
+        };
 
+        auto swapchainFormatIt =
+            std::find_first_of(runtimeFormats.begin(), runtimeFormats.end(), std::begin(SupportedDepthSwapchainFormats),
+                               std::end(SupportedDepthSwapchainFormats));
+        return swapchainFormatIt == runtimeFormats.end() ? 0 : *swapchainFormatIt;
+    }
+
+    void RenderViewWithDepth(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
+                             int64_t swapchainFormat, const XrSwapchainImageBaseHeader* depthImage, uint32_t depthArrayIndex,
+                             const std::vector<Cube>& cubes) override {
         ID3D11Texture2D* const colorTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(swapchainImage)->texture;
+        ID3D11Texture2D* const depthTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(depthImage)->texture;
+
+        // Create and cache a depth stencil view of each layer of each depth swapchain image.
+        auto depthStencilViewIt = m_depthSwapchainViews.find({depthTexture, depthArrayIndex});
+        if (depthStencilViewIt == m_depthSwapchainViews.end()) {
+            D3D11_TEXTURE2D_DESC depthDesc;
+            depthTexture->GetDesc(&depthDesc);
+            ComPtr<ID3D11DepthStencilView> depthStencilView;
+            const CD3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc(D3D11_DSV_DIMENSION_TEXTURE2DARRAY,
+                                                                      GetDepthViewFormat(depthDesc.Format), 0, depthArrayIndex, 1);
+            CHECK_HRCMD(m_device->CreateDepthStencilView(depthTexture, &depthStencilViewDesc, depthStencilView.GetAddressOf()));
+            depthStencilViewIt = m_depthSwapchainViews.insert({{depthTexture, depthArrayIndex}, depthStencilView}).first;
+        }
+
+        RenderViewTo(layerView, colorTexture, swapchainFormat, depthStencilViewIt->second.Get(), cubes);
+        EndViewTimer();
+    }
+
+    // The format to view a depth swapchain texture with, which the runtime may have created typeless.
+    static DXGI_FORMAT GetDepthViewFormat(DXGI_FORMAT textureFormat) {
+        switch (textureFormat) {
+            case DXGI_FORMAT_R32_TYPELESS:
+                return DXGI_FORMAT_D32_FLOAT;
+            case DXGI_FORMAT_R24G8_TYPELESS:
+                return DXGI_FORMAT_D24_UNORM_S8_UINT;
+            case DXGI_FORMAT_R16_TYPELESS:
+                return DXGI_FORMAT_D16_UNORM;
+            default:
+                return textureFormat;
+        }
+    }
 
+    void RenderViewTo(const XrCompositionLayerProjectionView& layerView, ID3D11Texture2D* colorTexture, int64_t swapchainFormat,
+                      ID3D11DepthStencilView* depthStencilView, const std::vector<Cube>& cubes) {
         CD3D11_VIEWPORT viewport((float)layerView.subImage.imageRect.offset.x, (float)layerView.subImage.imageRect.offset.y,
                                  (float)layerView.subImage.imageRect.extent.width,
                                  (float)layerView.subImage.imageRect.extent.height);
         m_deviceContext->RSSetViewports(1, &viewport);
 
-        // Create RenderTargetView with original swapchain format (swapchain is typeless).
+        // Create RenderTargetView with original swapchain format (swapchain is typeless), of the view's layer of the texture
+        // array, which is the only one of other swapchains.
         ComPtr<ID3D11RenderTargetView> renderTargetView;
-        const CD3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc(D3D11_RTV_DIMENSION_TEXTURE2D, (DXGI_FORMAT)swapchainFormat);
+        const CD3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc(D3D11_RTV_DIMENSION_TEXTURE2DARRAY, (DXGI_FORMAT)swapchainFormat,
+                                                                  0, layerView.subImage.imageArrayIndex, 1);
         CHECK_HRCMD(
             m_device->CreateRenderTargetView(colorTexture, &renderTargetViewDesc, renderTargetView.ReleaseAndGetAddressOf()));
 
-        const ComPtr<ID3D11DepthStencilView> depthStencilView = GetDepthStencilView(colorTexture);
-
         // Clear swapchain and depth buffer. NOTE: This will clear the entire render target view, not just the specified view.
         m_deviceContext->ClearRenderTargetView(renderTargetView.Get(), static_cast<const FLOAT*>(m_clearColor.data()));
-        m_deviceContext->ClearDepthStencilView(depthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+        m_deviceContext->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
         ID3D11RenderTargetView* renderTargets[] = {renderTargetView.Get()};
-        m_deviceContext->OMSetRenderTargets((UINT)ArraySize(renderTargets), renderTargets, depthStencilView.Get());
+        m_deviceContext->OMSetRenderTargets((UINT)ArraySize(renderTargets), renderTargets, depthStencilView);
 
         const XMMATRIX spaceToView = XMMatrixInverse(nullptr, LoadXrPose(layerView.pose));
         XrMatrix4x4f projectionMatrix;
         XrMatrix4x4f_CreateProjectionFov(&projectionMatrix, GRAPHICS_D3D, layerView.fov, 0.05f, 100.0f);
 
         // Set shaders and constant buffers.
-        ViewProjectionConstantBuffer viewProjection;
-        XMStoreFloat4x4(&viewProjection.ViewProjection, XMMatrixTranspose(spaceToView * LoadXrMatrix(projectionMatrix)));
-        m_deviceContext->UpdateSubresource(m_viewProjectionCBuffer.Get(), 0, nullptr, &viewProjection, 0, 0);
-
-        ID3D11Buffer* const constantBuffers[] = {m_modelCBuffer.Get(), m_viewProjectionCBuffer.Get()};
+        // Like the instance buffer, the constant buffer is dynamic, so the driver renames it on Map instead of copying.
+        D3D11_MAPPED_SUBRESOURCE mappedViewProjection;
+        CHECK_HRCMD(m_deviceContext->Map(m_viewProjectionCBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedViewProjection));
+        XMStoreFloat4x4(&static_cast<ViewProjectionConstantBuffer*>(mappedViewProjection.pData)->ViewProjection,
+                        XMMatrixTranspose(spaceToView * LoadXrMatrix(projectionMatrix)));
+        m_deviceContext->Unmap(m_viewProjectionCBuffer.Get(), 0);
+
+        ID3D11Buffer* const constantBuffers[] = {m_viewProjectionCBuffer.Get()};
         m_deviceContext->VSSetConstantBuffers(0, (UINT)ArraySize(constantBuffers), constantBuffers);
         m_deviceContext->VSSetShader(m_vertexShader.Get(), nullptr, 0);
         m_deviceContext->PSSetShader(m_pixelShader.Get(), nullptr, 0);
 
+        if (cubes.empty()) {
+            return;
+        }
+
+        // Compute the model transform of every cube into the instance buffer, growing it first when they do not fit.
+        if (cubes.size() > m_cubeInstanceCapacity) {
+            m_cubeInstanceCapacity = std::max<UINT>((UINT)cubes.size(), std::max<UINT>(2 * m_cubeInstanceCapacity, 64));
+            const CD3D11_BUFFER_DESC instanceBufferDesc(sizeof(ModelInstance) * m_cubeInstanceCapacity, D3D11_BIND_VERTEX_BUFFER,
+                                                        D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+            CHECK_HRCMD(m_device->CreateBuffer(&instanceBufferDesc, nullptr, m_cubeInstanceBuffer.ReleaseAndGetAddressOf()));
+        }
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        CHECK_HRCMD(m_deviceContext->Map(m_cubeInstanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+        ModelInstance* const instances = static_cast<ModelInstance*>(mapped.pData);
+        for (size_t i = 0; i < cubes.size(); ++i) {
+            const Cube& cube = cubes[i];
+            XMStoreFloat4x4(&instances[i].Model, XMMatrixScaling(cube.Scale.x, cube.Scale.y, cube.Scale.z) * LoadXrPose(cube.Pose));
+        }
+        m_deviceContext->Unmap(m_cubeInstanceBuffer.Get(), 0);
+
         // Set cube primitive data.
-        const UINT strides[] = {sizeof(Geometry::Vertex)};
-        const UINT offsets[] = {0};
-        ID3D11Buffer* vertexBuffers[] = {m_cubeVertexBuffer.Get()};
+        const UINT strides[] = {sizeof(Geometry::Vertex), sizeof(ModelInstance)};
+        const UINT offsets[] = {0, 0};
+        ID3D11Buffer* vertexBuffers[] = {m_cubeVertexBuffer.Get(), m_cubeInstanceBuffer.Get()};
         m_deviceContext->IASetVertexBuffers(0, (UINT)ArraySize(vertexBuffers), vertexBuffers, strides, offsets);
         m_deviceContext->IASetIndexBuffer(m_cubeIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
         m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
         m_deviceContext->IASetInputLayout(m_inputLayout.Get());
 
-        // Render each cube
-        for (const Cube& cube : cubes) {
-            // Compute and update the model transform.
-            ModelConstantBuffer model;
-            XMStoreFloat4x4(&model.Model,
-                            XMMatrixTranspose(XMMatrixScaling(cube.Scale.x, cube.Scale.y, cube.Scale.z) * LoadXrPose(cube.Pose)));
-            m_deviceContext->UpdateSubresource(m_modelCBuffer.Get(), 0, nullptr, &model, 0, 0);
+        // Draw every cube.
+        m_deviceContext->DrawIndexedInstanced((UINT)ArraySize(Geometry::c_cubeIndices), (UINT)cubes.size(), 0, 0, 0);
+    }
+
+    // Read the timestamps of the frame that last used this timer, FrameTimerCount - 1 frames back, then time this one.
+    void BeginFrame() override {
+        m_frameTimerIndex = (m_frameTimerIndex + 1) % FrameTimerCount;
+        FrameTimer& timer = m_frameTimers[m_frameTimerIndex];
+        if (timer.pending) {
+            D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+            while (m_deviceContext->GetData(timer.disjoint.Get(), &disjoint, sizeof(disjoint), 0) == S_FALSE) {
+                std::this_thread::yield();
+            }
+            UINT64 begin = 0;
+            UINT64 end = 0;
+            CHECK_HRCMD(m_deviceContext->GetData(timer.begin.Get(), &begin, sizeof(begin), 0));
+            CHECK_HRCMD(m_deviceContext->GetData(timer.end.Get(), &end, sizeof(end), 0));
+            // The timestamps are meaningless if the GPU clock changed frequency in between.
+            if (!disjoint.Disjoint) {
+                m_gpuFrameTime = (end - begin) * 1000.0 / disjoint.Frequency;
+                m_gpuFrameTimeAvailable = true;
+                UINT64 viewBegin = begin;
+                for (uint32_t view = 0; view < timer.viewCount; ++view) {
+                    UINT64 viewEnd = 0;
+                    CHECK_HRCMD(m_deviceContext->GetData(timer.viewEnds[view].Get(), &viewEnd, sizeof(viewEnd), 0));
+                    m_gpuViewTimes[view] = (viewEnd - viewBegin) * 1000.0 / disjoint.Frequency;
+                    viewBegin = viewEnd;
+                }
+                m_gpuViewTimeCount = timer.viewCount;
+            }
+            timer.pending = false;
+        }
+        m_deviceContext->Begin(timer.disjoint.Get());
+        m_deviceContext->End(timer.begin.Get());
+        timer.viewCount = 0;
+    }
 
-            // Draw the cube.
-            m_deviceContext->DrawIndexed((UINT)ArraySize(Geometry::c_cubeIndices), 0, 0);
+    // After the commands of a view; the view takes from the previous timestamp to this one.
+    void EndViewTimer() {
+        FrameTimer& timer = m_frameTimers[m_frameTimerIndex];
+        if (timer.viewCount < MaxTimedViews) {
+            m_deviceContext->End(timer.viewEnds[timer.viewCount++].Get());
         }
     }
 
+    void EndFrame() override {
+        FrameTimer& timer = m_frameTimers[m_frameTimerIndex];
+        m_deviceContext->End(timer.end.Get());
+        m_deviceContext->End(timer.disjoint.Get());
+        timer.pending = true;
+    }
+
+    bool TakeGpuFrameTime(double* milliseconds) override {
+        if (!m_gpuFrameTimeAvailable) {
+            return false;
+        }
+        *milliseconds = m_gpuFrameTime;
+        m_gpuFrameTimeAvailable = false;
+        return true;
+    }
+
+    uint32_t TakeGpuViewTimes(std::array<double, MaxTimedViews>& milliseconds) override {
+        const uint32_t viewCount = m_gpuViewTimeCount;
+        milliseconds = m_gpuViewTimes;
+        m_gpuViewTimeCount = 0;
+        return viewCount;
+    }
+
     uint32_t GetSupportedSwapchainSampleCount(const XrViewConfigurationView&) override { return 1; }
 
     void UpdateOptions(const std::shared_ptr<Options>& options) override { m_clearColor = options->GetBackgroundClearColor(); }
@@ -259,13 +410,33 @@ struct D3D11GraphicsPlugin : public IGraphicsPlugin {
     ComPtr<ID3D11VertexShader> m_vertexShader;
     ComPtr<ID3D11PixelShader> m_pixelShader;
     ComPtr<ID3D11InputLayout> m_inputLayout;
-    ComPtr<ID3D11Buffer> m_modelCBuffer;
     ComPtr<ID3D11Buffer> m_viewProjectionCBuffer;
     ComPtr<ID3D11Buffer> m_cubeVertexBuffer;
     ComPtr<ID3D11Buffer> m_cubeIndexBuffer;
+    ComPtr<ID3D11Buffer> m_cubeInstanceBuffer;
+    UINT m_cubeInstanceCapacity{0};
+
+    // The timestamp queries of the last frames, each read when BeginFrame reuses it.
+    struct FrameTimer {
+        ComPtr<ID3D11Query> disjoint;
+        ComPtr<ID3D11Query> begin;
+        ComPtr<ID3D11Query> end;
+        std::array<ComPtr<ID3D11Query>, MaxTimedViews> viewEnds;
+        uint32_t viewCount{0};  // Of viewEnds ended in the frame
+        bool pending{false};
+    };
+    static constexpr uint32_t FrameTimerCount = 3;
+    std::array<FrameTimer, FrameTimerCount> m_frameTimers;
+    uint32_t m_frameTimerIndex{0};
+    double m_gpuFrameTime{0};  // Milliseconds
+    bool m_gpuFrameTimeAvailable{false};
+    std::array<double, MaxTimedViews> m_gpuViewTimes{};  // Milliseconds, of the views of m_gpuFrameTime
+    uint32_t m_gpuViewTimeCount{0};
 
     // Map color buffer to associated depth buffer. This map is populated on demand.
     std::map<ID3D11Texture2D*, ComPtr<ID3D11DepthStencilView>> m_colorToDepthMap;
+    // Views of the layers of depth swapchain images, used instead of the depth buffers above when depth is submitted.
+    std::map<std::pair<ID3D11Texture2D*, uint32_t>, ComPtr<ID3D11DepthStencilView>> m_depthSwapchainViews;
     std::array<float, 4> m_clearColor;
 };
 }  // namespace
@@ -37,11 +37,14 @@ constexpr uint32_t AlignTo(uint32_t n) {
     return (n + alignment - 1) & ~(alignment - 1);
 }
 
-ComPtr<ID3D12Resource> CreateBuffer(ID3D12Device* d3d12Device, uint32_t size, D3D12_HEAP_TYPE heapType) {
+ComPtr<ID3D12Resource> CreateBuffer(ID3D12Device* d3d12Device, uint32_t size, D3D12_HEAP_TYPE heapType,
+                                    D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE) {
     D3D12_RESOURCE_STATES d3d12ResourceState;
     if (heapType == D3D12_HEAP_TYPE_UPLOAD) {
         d3d12ResourceState = D3D12_RESOURCE_STATE_GENERIC_READ;
         size = AlignTo<D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT>(size);
+    } else if (heapType == D3D12_HEAP_TYPE_READBACK) {
+        d3d12ResourceState = D3D12_RESOURCE_STATE_COPY_DEST;
     } else {
         d3d12ResourceState = D3D12_RESOURCE_STATE_COMMON;
     }
@@ -62,7 +65,7 @@ ComPtr<ID3D12Resource> CreateBuffer(ID3D12Device* d3d12Device, uint32_t size, D3
     buffDesc.SampleDesc.Count = 1;
     buffDesc.SampleDesc.Quality = 0;
     buffDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-    buffDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+    buffDesc.Flags = flags;
 
     ComPtr<ID3D12Resource> buffer;
     CHECK_HRCMD(d3d12Device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &buffDesc, d3d12ResourceState, nullptr,
@@ -71,6 +74,67 @@ ComPtr<ID3D12Resource> CreateBuffer(ID3D12Device* d3d12Device, uint32_t size, D3
     return buffer;
 }
 
+D3D12_RESOURCE_BARRIER TransitionBarrier(ID3D12Resource* resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) {
+    D3D12_RESOURCE_BARRIER barrier{};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Transition.pResource = resource;
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    barrier.Transition.StateBefore = before;
+    barrier.Transition.StateAfter = after;
+    return barrier;
+}
+
+// The compute shader of Options::IndirectDraw: the model transform of each cube whose bounding sphere is inside the frustum
+// planes is written to the instance buffer, row by row like ModelInstance, after those of the others inside, and counted
+// into the instance count of the draw arguments.
+constexpr char CullShaderHlsl[] = R"_(
+    struct Cube {
+        float4 Orientation;
+        float3 Position;
+        float3 Scale;
+    };
+    cbuffer CullConstants : register(b0) {
+        float4 Planes[4];  // Unit normals pointing inside, and distances
+        uint CubeCount;
+    };
+    StructuredBuffer<Cube> Cubes : register(t0);
+    RWStructuredBuffer<float4> Models : register(u0);
+    RWByteAddressBuffer DrawArgs : register(u1);  // D3D12_DRAW_INDEXED_ARGUMENTS
+
+    [numthreads(64, 1, 1)]
+    void MainCS(uint3 id : SV_DispatchThreadID) {
+        if (id.x >= CubeCount) {
+            return;
+        }
+        const Cube cube = Cubes[id.x];
+        const float4 position = float4(cube.Position, 1);
+        const float inside = min(min(dot(Planes[0], position), dot(Planes[1], position)),
+                                 min(dot(Planes[2], position), dot(Planes[3], position)));
+        if (inside <= -0.5 * length(cube.Scale)) {
+            return;
+        }
+        uint instance;
+        DrawArgs.InterlockedAdd(4, 1, instance);
+
+        const float4 q = cube.Orientation;
+        const float3 q2 = q.xyz + q.xyz;
+        const float xx2 = q.x * q2.x, yy2 = q.y * q2.y, zz2 = q.z * q2.z;
+        const float yz2 = q.y * q2.z, wx2 = q.w * q2.x, xy2 = q.x * q2.y;
+        const float wz2 = q.w * q2.z, xz2 = q.x * q2.z, wy2 = q.w * q2.y;
+        Models[instance * 4] = float4(float3(1 - yy2 - zz2, xy2 + wz2, xz2 - wy2) * cube.Scale.x, 0);
+        Models[instance * 4 + 1] = float4(float3(xy2 - wz2, 1 - xx2 - zz2, yz2 + wx2) * cube.Scale.y, 0);
+        Models[instance * 4 + 2] = float4(float3(xz2 + wy2, yz2 - wx2, 1 - xx2 - yy2) * cube.Scale.z, 0);
+        Models[instance * 4 + 3] = position;
+    }
+    )_";
+
+// The root constants of CullShaderHlsl.
+struct CullConstants {
+    XrVector4f Planes[4];
+    uint32_t CubeCount;
+};
+constexpr uint32_t CullGroupSize = 64;  // numthreads of CullShaderHlsl
+
 class SwapchainImageContext {
    public:
     std::vector<XrSwapchainImageBaseHeader*> Create(ID3D12Device* d3d12Device, uint32_t capacity) {
@@ -83,14 +147,16 @@ class SwapchainImageContext {
             bases[i] = reinterpret_cast<XrSwapchainImageBaseHeader*>(&m_swapchainImages[i]);
         }
 
-        CHECK_HRCMD(m_d3d12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, __uuidof(ID3D12CommandAllocator),
-                                                          reinterpret_cast<void**>(m_commandAllocator.ReleaseAndGetAddressOf())));
-
-        m_viewProjectionCBuffer = CreateBuffer(m_d3d12Device, sizeof(ViewProjectionConstantBuffer), D3D12_HEAP_TYPE_UPLOAD);
-
         return bases;
     }
 
+    // Whether the image struct is one of this context's.
+    bool Owns(const XrSwapchainImageBaseHeader* swapchainImageHeader) const {
+        auto p = reinterpret_cast<const XrSwapchainImageD3D12KHR*>(swapchainImageHeader);
+        const std::less_equal<const XrSwapchainImageD3D12KHR*> lessEqual;
+        return !m_swapchainImages.empty() && lessEqual(&m_swapchainImages.front(), p) && lessEqual(p, &m_swapchainImages.back());
+    }
+
     uint32_t ImageIndex(const XrSwapchainImageBaseHeader* swapchainImageHeader) {
         auto p = reinterpret_cast<const XrSwapchainImageD3D12KHR*>(swapchainImageHeader);
         return (uint32_t)(p - &m_swapchainImages[0]);
@@ -131,30 +197,164 @@ class SwapchainImageContext {
         return m_depthStencilTexture.Get();
     }
 
-    ID3D12CommandAllocator* GetCommandAllocator() const { return m_commandAllocator.Get(); }
+   private:
+    ID3D12Device* m_d3d12Device{nullptr};
+
+    std::vector<XrSwapchainImageD3D12KHR> m_swapchainImages;
+    ComPtr<ID3D12Resource> m_depthStencilTexture;
+};
+
+// The command allocator, command list and upload buffer of one frame in flight, reused once the GPU has passed the fence
+// value that the frame signaled.
+class FrameResources {
+   public:
+    void Create(ID3D12Device* d3d12Device) {
+        m_d3d12Device = d3d12Device;
+        CHECK_HRCMD(m_d3d12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, __uuidof(ID3D12CommandAllocator),
+                                                          reinterpret_cast<void**>(m_commandAllocator.ReleaseAndGetAddressOf())));
+        CHECK_HRCMD(m_d3d12Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocator.Get(), nullptr,
+                                                     __uuidof(ID3D12GraphicsCommandList),
+                                                     reinterpret_cast<void**>(m_commandList.ReleaseAndGetAddressOf())));
+        CHECK_HRCMD(m_commandList->Close());
+        CreateUploadBuffer(InitialUploadCapacity);
+
+        D3D12_QUERY_HEAP_DESC timestampHeapDesc{};
+        timestampHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        timestampHeapDesc.Count = TimestampCount;
+        CHECK_HRCMD(m_d3d12Device->CreateQueryHeap(&timestampHeapDesc, __uuidof(ID3D12QueryHeap),
+                                                   reinterpret_cast<void**>(m_timestampHeap.ReleaseAndGetAddressOf())));
+        m_timestampBuffer = CreateBuffer(m_d3d12Device, TimestampCount * sizeof(uint64_t), D3D12_HEAP_TYPE_READBACK);
+    }
+
+    // Start recording the frame.  The GPU must be done with the previous use of these resources.
+    void Begin() {
+        CHECK_HRCMD(m_commandAllocator->Reset());
+        CHECK_HRCMD(m_commandList->Reset(m_commandAllocator.Get(), nullptr));
+        m_uploadOffset = 0;
+        m_retiredUploadBuffers.clear();
+        m_indirectViewsUsed = 0;
+    }
 
-    uint64_t GetFrameFenceValue() const { return m_fenceValue; }
-    void SetFrameFenceValue(uint64_t fenceValue) { m_fenceValue = fenceValue; }
+    ID3D12GraphicsCommandList* GetCommandList() const { return m_commandList.Get(); }
 
-    void ResetCommandAllocator() { CHECK_HRCMD(m_commandAllocator->Reset()); }
+    uint64_t GetFenceValue() const { return m_fenceValue; }
+    void SetFenceValue(uint64_t fenceValue) { m_fenceValue = fenceValue; }
 
-    void RequestModelCBuffer(uint32_t requiredSize) {
-        if (!m_modelCBuffer || (requiredSize > m_modelCBuffer->GetDesc().Width)) {
-            m_modelCBuffer = CreateBuffer(m_d3d12Device, requiredSize, D3D12_HEAP_TYPE_UPLOAD);
+    // Bracket the frame's commands with timestamps, with one after each of its first views between them, resolved into the
+    // readback buffer at the end of the command list.
+    void BeginTiming() {
+        m_commandList->EndQuery(m_timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0);
+        m_timedViews = 0;
+    }
+
+    // After the commands of a view; the view takes from the previous timestamp to this one.
+    void EndViewTiming() {
+        if (m_timedViews < IGraphicsPlugin::MaxTimedViews) {
+            m_commandList->EndQuery(m_timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 1 + m_timedViews++);
+        }
+    }
+
+    void EndTiming() {
+        m_commandList->EndQuery(m_timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 1 + m_timedViews);
+        m_commandList->ResolveQueryData(m_timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0, m_timedViews + 2,
+                                        m_timestampBuffer.Get(), 0);
+        m_timestampsResolved = true;
+    }
+
+    // The GPU times of the last frame timed with these resources and of its views, once the GPU is done with it.  False if
+    // they are already taken, or no frame was timed.
+    bool TakeGpuTime(uint64_t timestampFrequency, double* milliseconds,
+                     std::array<double, IGraphicsPlugin::MaxTimedViews>* viewMilliseconds, uint32_t* viewCount) {
+        if (!m_timestampsResolved) {
+            return false;
         }
+        m_timestampsResolved = false;
+        const D3D12_RANGE readRange{0, (m_timedViews + 2) * sizeof(uint64_t)};
+        uint64_t* timestamps;
+        CHECK_HRCMD(m_timestampBuffer->Map(0, &readRange, reinterpret_cast<void**>(&timestamps)));
+        *milliseconds = (timestamps[m_timedViews + 1] - timestamps[0]) * 1000.0 / timestampFrequency;
+        for (uint32_t view = 0; view < m_timedViews; ++view) {
+            (*viewMilliseconds)[view] = (timestamps[view + 1] - timestamps[view]) * 1000.0 / timestampFrequency;
+        }
+        *viewCount = m_timedViews;
+        const D3D12_RANGE writeRange{0, 0};
+        m_timestampBuffer->Unmap(0, &writeRange);
+        return true;
+    }
+
+    // The constants and instance data of a view are sub-allocated in order from one upload buffer, mapped once when it is
+    // created.  All of it is free again when the frame begins.
+    struct UploadAllocation {
+        void* data;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+        ID3D12Resource* buffer;
+        uint32_t offset;  // In buffer
+    };
+
+    UploadAllocation AllocateUpload(uint32_t size) {
+        uint32_t offset = AlignTo<D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT>(m_uploadOffset);
+        if (offset + size > m_uploadCapacity) {
+            // Grow geometrically.  Commands already recorded may read the old buffer, so it lives until the fence.
+            m_retiredUploadBuffers.push_back(std::move(m_uploadBuffer));
+            CreateUploadBuffer(std::max(m_uploadCapacity * 2, AlignTo<D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT>(size)));
+            offset = 0;
+        }
+        m_uploadOffset = offset + size;
+        return {m_uploadData + offset, m_uploadBuffer->GetGPUVirtualAddress() + offset, m_uploadBuffer.Get(), offset};
     }
 
-    ID3D12Resource* GetModelCBuffer() const { return m_modelCBuffer.Get(); }
-    ID3D12Resource* GetViewProjectionCBuffer() const { return m_viewProjectionCBuffer.Get(); }
+    // With Options::IndirectDraw, the model transforms the cull shader writes for a view, and the draw arguments it counts
+    // them into, in buffers it may write.  Both are in the common state until the view uses them, as buffers decay to it
+    // once the command list that used them is done.
+    struct IndirectView {
+        ComPtr<ID3D12Resource> models;
+        uint32_t capacity{0};  // Model transforms
+        ComPtr<ID3D12Resource> args;
+    };
+
+    // The buffers of the next view of the frame, grown to hold cubeCount model transforms.
+    IndirectView& NextIndirectView(uint32_t cubeCount) {
+        if (m_indirectViewsUsed == m_indirectViews.size()) {
+            m_indirectViews.emplace_back();
+            m_indirectViews.back().args = CreateBuffer(m_d3d12Device, sizeof(D3D12_DRAW_INDEXED_ARGUMENTS),
+                                                       D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        }
+        IndirectView& view = m_indirectViews[m_indirectViewsUsed++];
+        if (cubeCount > view.capacity) {
+            view.capacity = std::max(cubeCount, view.capacity * 2);
+            view.models = CreateBuffer(m_d3d12Device, view.capacity * sizeof(ModelInstance), D3D12_HEAP_TYPE_DEFAULT,
+                                       D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        }
+        return view;
+    }
 
    private:
-    ID3D12Device* m_d3d12Device{nullptr};
+    static constexpr uint32_t InitialUploadCapacity = 64 * 1024;
+    // The start and end of a frame, and the end of each of its first views.
+    static constexpr uint32_t TimestampCount = IGraphicsPlugin::MaxTimedViews + 2;
+
+    void CreateUploadBuffer(uint32_t capacity) {
+        m_uploadBuffer = CreateBuffer(m_d3d12Device, capacity, D3D12_HEAP_TYPE_UPLOAD);
+        // Upload heap resources may stay mapped for their whole lifetime; the CPU only writes to it.
+        const D3D12_RANGE readRange{0, 0};
+        CHECK_HRCMD(m_uploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_uploadData)));
+        m_uploadCapacity = capacity;
+    }
 
-    std::vector<XrSwapchainImageD3D12KHR> m_swapchainImages;
+    ID3D12Device* m_d3d12Device{nullptr};
     ComPtr<ID3D12CommandAllocator> m_commandAllocator;
-    ComPtr<ID3D12Resource> m_depthStencilTexture;
-    ComPtr<ID3D12Resource> m_modelCBuffer;
-    ComPtr<ID3D12Resource> m_viewProjectionCBuffer;
+    ComPtr<ID3D12GraphicsCommandList> m_commandList;
+    ComPtr<ID3D12Resource> m_uploadBuffer;
+    uint8_t* m_uploadData{nullptr};
+    uint32_t m_uploadCapacity{0};
+    uint32_t m_uploadOffset{0};
+    std::vector<ComPtr<ID3D12Resource>> m_retiredUploadBuffers;
+    std::deque<IndirectView> m_indirectViews;
+    uint32_t m_indirectViewsUsed{0};
+    ComPtr<ID3D12QueryHeap> m_timestampHeap;
+    ComPtr<ID3D12Resource> m_timestampBuffer;
+    bool m_timestampsResolved{false};
+    uint32_t m_timedViews{0};  // Views timed in the frame
     uint64_t m_fenceValue = 0;
 };
 
@@ -162,9 +362,20 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
     D3D12GraphicsPlugin(const std::shared_ptr<Options>& options, std::shared_ptr<IPlatformPlugin>)
         : m_vertexShaderBytes(CompileShader(ShaderHlsl, "MainVS", "vs_5_1")),
           m_pixelShaderBytes(CompileShader(ShaderHlsl, "MainPS", "ps_5_1")),
-          m_clearColor(options->GetBackgroundClearColor()) {}
+          m_clearColor(options->GetBackgroundClearColor()),
+          m_indirectDraw(options->IndirectDraw) {
+        if (m_indirectDraw) {
+            m_cullShaderBytes = CompileShader(CullShaderHlsl, "MainCS", "cs_5_1");
+        }
+    }
 
-    ~D3D12GraphicsPlugin() override { CloseHandle(m_fenceEvent); }
+    ~D3D12GraphicsPlugin() override {
+        if (m_fence) {
+            // The frames in flight may still use the resources about to be released.
+            WaitForGpu();
+        }
+        CloseHandle(m_fenceEvent);
+    }
 
     std::vector<std::string> GetInstanceExtensions() const override { return {XR_KHR_D3D12_ENABLE_EXTENSION_NAME}; }
 
@@ -186,6 +397,7 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
         queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
         CHECK_HRCMD(m_device->CreateCommandQueue(&queueDesc, __uuidof(ID3D12CommandQueue),
                                                  reinterpret_cast<void**>(m_cmdQueue.ReleaseAndGetAddressOf())));
+        CHECK_HRCMD(m_cmdQueue->GetTimestampFrequency(&m_timestampFrequency));
 
         InitializeResources();
 
@@ -211,15 +423,11 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
                                                        reinterpret_cast<void**>(m_dsvHeap.ReleaseAndGetAddressOf())));
         }
 
-        D3D12_ROOT_PARAMETER rootParams[2];
+        D3D12_ROOT_PARAMETER rootParams[1];
         rootParams[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
         rootParams[0].Descriptor.ShaderRegister = 0;
         rootParams[0].Descriptor.RegisterSpace = 0;
         rootParams[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
-        rootParams[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
-        rootParams[1].Descriptor.ShaderRegister = 1;
-        rootParams[1].Descriptor.RegisterSpace = 0;
-        rootParams[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
 
         D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc{};
         rootSignatureDesc.NumParameters = (UINT)ArraySize(rootParams);
@@ -235,13 +443,18 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
                                                   __uuidof(ID3D12RootSignature),
                                                   reinterpret_cast<void**>(m_rootSignature.ReleaseAndGetAddressOf())));
 
-        SwapchainImageContext initializeContext;
-        std::vector<XrSwapchainImageBaseHeader*> _ = initializeContext.Create(m_device.Get(), 1);
+        if (m_indirectDraw) {
+            InitializeCullResources();
+        }
 
-        ComPtr<ID3D12GraphicsCommandList> cmdList;
-        CHECK_HRCMD(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, initializeContext.GetCommandAllocator(), nullptr,
-                                                __uuidof(ID3D12GraphicsCommandList),
-                                                reinterpret_cast<void**>(cmdList.ReleaseAndGetAddressOf())));
+        for (FrameResources& frame : m_frames) {
+            frame.Create(m_device.Get());
+        }
+
+        // Upload the cube geometry with the command list of the first frame, whose fence WaitForGpu passes below.
+        FrameResources& initializeFrame = m_frames[0];
+        initializeFrame.Begin();
+        ID3D12GraphicsCommandList* cmdList = initializeFrame.GetCommandList();
 
         ComPtr<ID3D12Resource> cubeVertexBufferUpload;
         m_cubeVertexBuffer = CreateBuffer(m_device.Get(), sizeof(Geometry::c_cubeVertices), D3D12_HEAP_TYPE_DEFAULT);
@@ -273,7 +486,7 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
         }
 
         CHECK_HRCMD(cmdList->Close());
-        ID3D12CommandList* cmdLists[] = {cmdList.Get()};
+        ID3D12CommandList* cmdLists[] = {cmdList};
         m_cmdQueue->ExecuteCommandLists((UINT)ArraySize(cmdLists), cmdLists);
 
         CHECK_HRCMD(m_device->CreateFence(m_fenceValue, D3D12_FENCE_FLAG_NONE, __uuidof(ID3D12Fence),
@@ -284,6 +497,51 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
         WaitForGpu();
     }
 
+    // The root signature and pipeline state of the cull shader, and the command signature of the indirect draws it counts the
+    // visible cubes into.
+    void InitializeCullResources() {
+        D3D12_ROOT_PARAMETER rootParams[4]{};
+        rootParams[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+        rootParams[0].Constants.ShaderRegister = 0;
+        rootParams[0].Constants.Num32BitValues = sizeof(CullConstants) / sizeof(uint32_t);
+        rootParams[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+        rootParams[1].Descriptor.ShaderRegister = 0;
+        rootParams[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV;
+        rootParams[2].Descriptor.ShaderRegister = 0;
+        rootParams[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV;
+        rootParams[3].Descriptor.ShaderRegister = 1;
+        for (D3D12_ROOT_PARAMETER& rootParam : rootParams) {
+            rootParam.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+        }
+
+        D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc{};
+        rootSignatureDesc.NumParameters = (UINT)ArraySize(rootParams);
+        rootSignatureDesc.pParameters = rootParams;
+
+        ComPtr<ID3DBlob> rootSignatureBlob;
+        ComPtr<ID3DBlob> error;
+        CHECK_HRCMD(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1_0,
+                                                rootSignatureBlob.ReleaseAndGetAddressOf(), error.ReleaseAndGetAddressOf()));
+        CHECK_HRCMD(m_device->CreateRootSignature(0, rootSignatureBlob->GetBufferPointer(), rootSignatureBlob->GetBufferSize(),
+                                                  __uuidof(ID3D12RootSignature),
+                                                  reinterpret_cast<void**>(m_cullRootSignature.ReleaseAndGetAddressOf())));
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC pipelineStateDesc{};
+        pipelineStateDesc.pRootSignature = m_cullRootSignature.Get();
+        pipelineStateDesc.CS = {m_cullShaderBytes->GetBufferPointer(), m_cullShaderBytes->GetBufferSize()};
+        CHECK_HRCMD(m_device->CreateComputePipelineState(&pipelineStateDesc, __uuidof(ID3D12PipelineState),
+                                                         reinterpret_cast<void**>(m_cullPipelineState.ReleaseAndGetAddressOf())));
+
+        D3D12_INDIRECT_ARGUMENT_DESC argumentDesc{};
+        argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+        D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc{};
+        commandSignatureDesc.ByteStride = sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+        commandSignatureDesc.NumArgumentDescs = 1;
+        commandSignatureDesc.pArgumentDescs = &argumentDesc;
+        CHECK_HRCMD(m_device->CreateCommandSignature(&commandSignatureDesc, nullptr, __uuidof(ID3D12CommandSignature),
+                                                     reinterpret_cast<void**>(m_drawCommandSignature.ReleaseAndGetAddressOf())));
+    }
+
     int64_t SelectColorSwapchainFormat(const std::vector<int64_t>& runtimeFormats) const override {
         // List of supported color swapchain formats.
         constexpr DXGI_FORMAT SupportedColorSwapchainFormats[] = {
@@ -315,14 +573,24 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
         m_swapchainImageContexts.emplace_back();
         SwapchainImageContext& swapchainImageContext = m_swapchainImageContexts.back();
 
-        std::vector<XrSwapchainImageBaseHeader*> bases = swapchainImageContext.Create(m_device.Get(), capacity);
+        return swapchainImageContext.Create(m_device.Get(), capacity);
+    }
 
-        // Map every swapchainImage base pointer to this context
-        for (auto& base : bases) {
-            m_swapchainImageContextMap[base] = &swapchainImageContext;
-        }
+    void ReleaseSwapchainImages() override {
+        CHECK(!m_frameInProgress);
+        CpuWaitForFence(m_fenceValue);
+        m_swapchainImageContexts.clear();
+    }
 
-        return bases;
+    // The context of the swapchain the image struct belongs to.  There are only a couple of swapchains, so this is cheaper
+    // than a map lookup, and allocates nothing.
+    SwapchainImageContext& GetSwapchainImageContext(const XrSwapchainImageBaseHeader* swapchainImage) {
+        for (SwapchainImageContext& swapchainImageContext : m_swapchainImageContexts) {
+            if (swapchainImageContext.Owns(swapchainImage)) {
+                return swapchainImageContext;
+            }
+        }
+        THROW("Unknown swapchain image");
     }
 
     ID3D12PipelineState* GetOrCreatePipelineState(DXGI_FORMAT swapchainFormat) {
@@ -336,6 +604,14 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
              D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
             {"COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
              0},
+            {"MODEL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT,
+             D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
+            {"MODEL", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT,
+             D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
+            {"MODEL", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT,
+             D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
+            {"MODEL", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT,
+             D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
         };
 
         D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineStateDesc{};
@@ -411,16 +687,21 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
 
     void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                     int64_t swapchainFormat, const std::vector<Cube>& cubes) override {
-        CHECK(layerView.subImage.imageArrayIndex == 0);  // Texture arrays not supported.
+        // Outside of BeginFrame and EndFrame, the view is a frame of its own.
+        const bool ownFrame = !m_frameInProgress;
+        if (ownFrame) {
+            BeginFrame();
+        }
 
-        auto& swapchainContext = *m_swapchainImageContextMap[swapchainImage];
-        CpuWaitForFence(swapchainContext.GetFrameFenceValue());
-        swapchainContext.ResetCommandAllocator();
+        auto& swapchainContext = GetSwapchainImageContext(swapchainImage);
+        FrameResources& frame = m_frames[m_frameIndex];
+        ID3D12GraphicsCommandList* cmdList = frame.GetCommandList();
 
-        ComPtr<ID3D12GraphicsCommandList> cmdList;
-        CHECK_HRCMD(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, swapchainContext.GetCommandAllocator(), nullptr,
-                                                __uuidof(ID3D12GraphicsCommandList),
-                                                reinterpret_cast<void**>(cmdList.ReleaseAndGetAddressOf())));
+        // With indirect draws, the cull shader computes the instances the draw reads, before the state is set for it.
+        FrameResources::IndirectView* indirectView = nullptr;
+        if (m_indirectDraw && !cubes.empty()) {
+            indirectView = &RecordCull(frame, layerView, cubes);
+        }
 
         ID3D12PipelineState* pipelineState = GetOrCreatePipelineState((DXGI_FORMAT)swapchainFormat);
         cmdList->SetPipelineState(pipelineState);
@@ -442,17 +723,22 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
                                         layerView.subImage.imageRect.offset.y + layerView.subImage.imageRect.extent.height};
         cmdList->RSSetScissorRects(1, &scissorRect);
 
-        // Create RenderTargetView with original swapchain format (swapchain is typeless).
+        // Create RenderTargetView with original swapchain format (swapchain is typeless), of the view's layer of a texture
+        // array.
+        const UINT arraySlice = layerView.subImage.imageArrayIndex;
+        CHECK(arraySlice < colorTextureDesc.DepthOrArraySize);
         D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
         D3D12_RENDER_TARGET_VIEW_DESC renderTargetViewDesc{};
         renderTargetViewDesc.Format = (DXGI_FORMAT)swapchainFormat;
         if (colorTextureDesc.DepthOrArraySize > 1) {
             if (colorTextureDesc.SampleDesc.Count > 1) {
                 renderTargetViewDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DMSARRAY;
-                renderTargetViewDesc.Texture2DMSArray.ArraySize = colorTextureDesc.DepthOrArraySize;
+                renderTargetViewDesc.Texture2DMSArray.FirstArraySlice = arraySlice;
+                renderTargetViewDesc.Texture2DMSArray.ArraySize = 1;
             } else {
                 renderTargetViewDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
-                renderTargetViewDesc.Texture2DArray.ArraySize = colorTextureDesc.DepthOrArraySize;
+                renderTargetViewDesc.Texture2DArray.FirstArraySlice = arraySlice;
+                renderTargetViewDesc.Texture2DArray.ArraySize = 1;
             }
         } else {
             if (colorTextureDesc.SampleDesc.Count > 1) {
@@ -471,10 +757,12 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
         if (depthStencilTextureDesc.DepthOrArraySize > 1) {
             if (depthStencilTextureDesc.SampleDesc.Count > 1) {
                 depthStencilViewDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2DMSARRAY;
-                depthStencilViewDesc.Texture2DMSArray.ArraySize = colorTextureDesc.DepthOrArraySize;
+                depthStencilViewDesc.Texture2DMSArray.FirstArraySlice = arraySlice;
+                depthStencilViewDesc.Texture2DMSArray.ArraySize = 1;
             } else {
                 depthStencilViewDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2DARRAY;
-                depthStencilViewDesc.Texture2DArray.ArraySize = colorTextureDesc.DepthOrArraySize;
+                depthStencilViewDesc.Texture2DArray.FirstArraySlice = arraySlice;
+                depthStencilViewDesc.Texture2DArray.ArraySize = 1;
             }
         } else {
             if (depthStencilTextureDesc.SampleDesc.Count > 1) {
@@ -492,69 +780,171 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
         D3D12_CPU_DESCRIPTOR_HANDLE renderTargets[] = {renderTargetView};
         cmdList->OMSetRenderTargets((UINT)ArraySize(renderTargets), renderTargets, true, &depthStencilView);
 
-        const XMMATRIX spaceToView = XMMatrixInverse(nullptr, LoadXrPose(layerView.pose));
-        XrMatrix4x4f projectionMatrix;
-        XrMatrix4x4f_CreateProjectionFov(&projectionMatrix, GRAPHICS_D3D, layerView.fov, 0.05f, 100.0f);
-
         // Set shaders and constant buffers.
-        ID3D12Resource* viewProjectionCBuffer = swapchainContext.GetViewProjectionCBuffer();
-        ViewProjectionConstantBuffer viewProjection;
-        XMStoreFloat4x4(&viewProjection.ViewProjection, XMMatrixTranspose(spaceToView * LoadXrMatrix(projectionMatrix)));
-        {
-            void* data;
-            const D3D12_RANGE readRange{0, 0};
-            CHECK_HRCMD(viewProjectionCBuffer->Map(0, &readRange, &data));
-            memcpy(data, &viewProjection, sizeof(viewProjection));
-            viewProjectionCBuffer->Unmap(0, nullptr);
-        }
-
-        cmdList->SetGraphicsRootConstantBufferView(1, viewProjectionCBuffer->GetGPUVirtualAddress());
-
-        // Set cube primitive data.
-        const D3D12_VERTEX_BUFFER_VIEW vertexBufferView[] = {
-            {m_cubeVertexBuffer->GetGPUVirtualAddress(), sizeof(Geometry::c_cubeVertices), sizeof(Geometry::Vertex)}};
-        cmdList->IASetVertexBuffers(0, (UINT)ArraySize(vertexBufferView), vertexBufferView);
-
-        D3D12_INDEX_BUFFER_VIEW indexBufferView{m_cubeIndexBuffer->GetGPUVirtualAddress(), sizeof(Geometry::c_cubeIndices),
-                                                DXGI_FORMAT_R16_UINT};
-        cmdList->IASetIndexBuffer(&indexBufferView);
-
-        cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-        constexpr uint32_t cubeCBufferSize = AlignTo<D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT>(sizeof(ModelConstantBuffer));
-        swapchainContext.RequestModelCBuffer(static_cast<uint32_t>(cubeCBufferSize * cubes.size()));
-        ID3D12Resource* modelCBuffer = swapchainContext.GetModelCBuffer();
-
-        // Render each cube
-        uint32_t offset = 0;
-        for (const Cube& cube : cubes) {
-            // Compute and update the model transform.
-            ModelConstantBuffer model;
-            XMStoreFloat4x4(&model.Model,
-                            XMMatrixTranspose(XMMatrixScaling(cube.Scale.x, cube.Scale.y, cube.Scale.z) * LoadXrPose(cube.Pose)));
-            {
-                uint8_t* data;
-                const D3D12_RANGE readRange{0, 0};
-                CHECK_HRCMD(modelCBuffer->Map(0, &readRange, reinterpret_cast<void**>(&data)));
-                memcpy(data + offset, &model, sizeof(model));
-                const D3D12_RANGE writeRange{offset, offset + cubeCBufferSize};
-                modelCBuffer->Unmap(0, &writeRange);
+        const FrameResources::UploadAllocation viewProjectionCBuffer = frame.AllocateUpload(sizeof(ViewProjectionConstantBuffer));
+        auto viewProjection = static_cast<ViewProjectionConstantBuffer*>(viewProjectionCBuffer.data);
+        StoreViewProjection(layerView, viewProjection);
+        m_viewProjections.push_back(viewProjection);
+
+        cmdList->SetGraphicsRootConstantBufferView(0, viewProjectionCBuffer.gpuAddress);
+
+        if (!cubes.empty()) {
+            // Compute the model transform of every cube straight into the mapped upload buffer, unless the cull shader did.
+            const uint32_t instanceBufferSize = static_cast<uint32_t>(sizeof(ModelInstance) * cubes.size());
+            D3D12_GPU_VIRTUAL_ADDRESS instanceBufferAddress;
+            if (indirectView != nullptr) {
+                instanceBufferAddress = indirectView->models->GetGPUVirtualAddress();
+            } else {
+                const FrameResources::UploadAllocation instanceBuffer = frame.AllocateUpload(instanceBufferSize);
+                ModelInstance* instances = static_cast<ModelInstance*>(instanceBuffer.data);
+                for (size_t i = 0; i < cubes.size(); ++i) {
+                    const Cube& cube = cubes[i];
+                    XMStoreFloat4x4(&instances[i].Model,
+                                    XMMatrixScaling(cube.Scale.x, cube.Scale.y, cube.Scale.z) * LoadXrPose(cube.Pose));
+                }
+                instanceBufferAddress = instanceBuffer.gpuAddress;
+            }
+
+            // Set cube primitive data.
+            const D3D12_VERTEX_BUFFER_VIEW vertexBufferView[] = {
+                {m_cubeVertexBuffer->GetGPUVirtualAddress(), sizeof(Geometry::c_cubeVertices), sizeof(Geometry::Vertex)},
+                {instanceBufferAddress, instanceBufferSize, sizeof(ModelInstance)}};
+            cmdList->IASetVertexBuffers(0, (UINT)ArraySize(vertexBufferView), vertexBufferView);
+
+            D3D12_INDEX_BUFFER_VIEW indexBufferView{m_cubeIndexBuffer->GetGPUVirtualAddress(), sizeof(Geometry::c_cubeIndices),
+                                                    DXGI_FORMAT_R16_UINT};
+            cmdList->IASetIndexBuffer(&indexBufferView);
+
+            cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+            // Draw every cube, or as many as the cull shader counted.
+            if (indirectView != nullptr) {
+                cmdList->ExecuteIndirect(m_drawCommandSignature.Get(), 1, indirectView->args.Get(), 0, nullptr, 0);
+            } else {
+                cmdList->DrawIndexedInstanced((UINT)ArraySize(Geometry::c_cubeIndices), (UINT)cubes.size(), 0, 0, 0);
             }
+        }
+        frame.EndViewTiming();
 
-            cmdList->SetGraphicsRootConstantBufferView(0, modelCBuffer->GetGPUVirtualAddress() + offset);
+        if (ownFrame) {
+            EndFrame();
+        }
+    }
 
-            // Draw the cube.
-            cmdList->DrawIndexedInstanced((UINT)ArraySize(Geometry::c_cubeIndices), 1, 0, 0, 0);
+    // Records the cull shader over the cubes of a view, which writes the model transforms of the visible ones to the view's
+    // instance buffer and counts them into its draw arguments, and the transitions the draw reads them behind.  The host only
+    // copies the cubes as they are to the upload buffer; all the work for each of them is on the GPU.
+    FrameResources::IndirectView& RecordCull(FrameResources& frame, const XrCompositionLayerProjectionView& layerView,
+                                             const std::vector<Cube>& cubes) {
+        static_assert(sizeof(Cube) == 10 * sizeof(float), "The cull shader reads each cube as 10 floats");
+        ID3D12GraphicsCommandList* cmdList = frame.GetCommandList();
+        const uint32_t cubeCount = (uint32_t)cubes.size();
+        FrameResources::IndirectView& view = frame.NextIndirectView(cubeCount);
+
+        const FrameResources::UploadAllocation cubeBuffer = frame.AllocateUpload(sizeof(Cube) * cubeCount);
+        memcpy(cubeBuffer.data, cubes.data(), sizeof(Cube) * cubeCount);
+        const FrameResources::UploadAllocation argsUpload = frame.AllocateUpload(sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+        *static_cast<D3D12_DRAW_INDEXED_ARGUMENTS*>(argsUpload.data) = {(UINT)ArraySize(Geometry::c_cubeIndices), 0, 0, 0, 0};
+
+        const D3D12_RESOURCE_BARRIER beginBarriers[] = {
+            TransitionBarrier(view.args.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST),
+            TransitionBarrier(view.models.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)};
+        cmdList->ResourceBarrier((UINT)ArraySize(beginBarriers), beginBarriers);
+        cmdList->CopyBufferRegion(view.args.Get(), 0, argsUpload.buffer, argsUpload.offset, sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+        const D3D12_RESOURCE_BARRIER argsBarrier =
+            TransitionBarrier(view.args.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        cmdList->ResourceBarrier(1, &argsBarrier);
+
+        // The frustum of the view, or planes that keep every cube if it has none.
+        CullConstants constants{};
+        if (!XrPosef_CreateCombinedFrustumPlanes(constants.Planes, &layerView.pose, &layerView.fov, 1)) {
+            for (XrVector4f& plane : constants.Planes) {
+                plane = {0.0f, 0.0f, 0.0f, 1.0f};
+            }
+        }
+        constants.CubeCount = cubeCount;
+
+        cmdList->SetPipelineState(m_cullPipelineState.Get());
+        cmdList->SetComputeRootSignature(m_cullRootSignature.Get());
+        cmdList->SetComputeRoot32BitConstants(0, sizeof(constants) / sizeof(uint32_t), &constants, 0);
+        cmdList->SetComputeRootShaderResourceView(1, cubeBuffer.gpuAddress);
+        cmdList->SetComputeRootUnorderedAccessView(2, view.models->GetGPUVirtualAddress());
+        cmdList->SetComputeRootUnorderedAccessView(3, view.args->GetGPUVirtualAddress());
+        cmdList->Dispatch((cubeCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+        const D3D12_RESOURCE_BARRIER endBarriers[] = {
+            TransitionBarrier(view.args.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT),
+            TransitionBarrier(view.models.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                              D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER)};
+        cmdList->ResourceBarrier((UINT)ArraySize(endBarriers), endBarriers);
+        return view;
+    }
 
-            offset += cubeCBufferSize;
+    // Every view of a frame is recorded into the command list of one frame slot and submitted with a single
+    // ExecuteCommandLists in EndFrame.  BeginFrame only waits for the GPU to finish the frame that last used the slot, up
+    // to FramesInFlight frames ago, rather than for the previous view.
+    void BeginFrame() override {
+        CHECK(!m_frameInProgress);
+        m_frameIndex = (m_frameIndex + 1) % FramesInFlight;
+        FrameResources& frame = m_frames[m_frameIndex];
+        CpuWaitForFence(frame.GetFenceValue());
+        if (frame.TakeGpuTime(m_timestampFrequency, &m_gpuFrameTime, &m_gpuViewTimes, &m_gpuViewTimeCount)) {
+            m_gpuFrameTimeAvailable = true;
         }
+        frame.Begin();
+        frame.BeginTiming();
+        m_viewProjections.clear();
+        m_frameInProgress = true;
+    }
 
+    void EndFrame() override {
+        CHECK(m_frameInProgress);
+        m_frameInProgress = false;
+        FrameResources& frame = m_frames[m_frameIndex];
+        frame.EndTiming();
+        ID3D12GraphicsCommandList* cmdList = frame.GetCommandList();
         CHECK_HRCMD(cmdList->Close());
-        ID3D12CommandList* cmdLists[] = {cmdList.Get()};
+        ID3D12CommandList* cmdLists[] = {cmdList};
         m_cmdQueue->ExecuteCommandLists((UINT)ArraySize(cmdLists), cmdLists);
 
         SignalFence();
-        swapchainContext.SetFrameFenceValue(m_fenceValue);
+        frame.SetFenceValue(m_fenceValue);
+    }
+
+    // The view-projection constants of the frame's views stay in the mapped upload buffer until EndFrame submits the command
+    // list, so they are simply rewritten from the latest poses.
+    bool SupportsLateLatching() const override { return true; }
+
+    void LateLatchViews(const std::vector<XrCompositionLayerProjectionView>& layerViews) override {
+        CHECK(m_frameInProgress);
+        CHECK(m_viewProjections.size() <= layerViews.size());
+        for (size_t i = 0; i < m_viewProjections.size(); ++i) {
+            StoreViewProjection(layerViews[i], m_viewProjections[i]);
+        }
+    }
+
+    bool TakeGpuFrameTime(double* milliseconds) override {
+        if (!m_gpuFrameTimeAvailable) {
+            return false;
+        }
+        *milliseconds = m_gpuFrameTime;
+        m_gpuFrameTimeAvailable = false;
+        return true;
+    }
+
+    uint32_t TakeGpuViewTimes(std::array<double, MaxTimedViews>& milliseconds) override {
+        const uint32_t viewCount = m_gpuViewTimeCount;
+        milliseconds = m_gpuViewTimes;
+        m_gpuViewTimeCount = 0;
+        return viewCount;
+    }
+
+    // Write the constants straight to the upload buffer, which is write-combined: it is never read back.
+    static void StoreViewProjection(const XrCompositionLayerProjectionView& layerView, ViewProjectionConstantBuffer* constants) {
+        const XMMATRIX spaceToView = XMMatrixInverse(nullptr, LoadXrPose(layerView.pose));
+        XrMatrix4x4f projectionMatrix;
+        XrMatrix4x4f_CreateProjectionFov(&projectionMatrix, GRAPHICS_D3D, layerView.fov, 0.05f, 100.0f);
+        XMStoreFloat4x4(&constants->ViewProjection, XMMatrixTranspose(spaceToView * LoadXrMatrix(projectionMatrix)));
     }
 
     void SignalFence() {
@@ -582,13 +972,24 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
    private:
     const ComPtr<ID3DBlob> m_vertexShaderBytes;
     const ComPtr<ID3DBlob> m_pixelShaderBytes;
+    ComPtr<ID3DBlob> m_cullShaderBytes;  // With Options::IndirectDraw
     ComPtr<ID3D12Device> m_device;
     ComPtr<ID3D12CommandQueue> m_cmdQueue;
     ComPtr<ID3D12Fence> m_fence;
     uint64_t m_fenceValue = 0;
     HANDLE m_fenceEvent = INVALID_HANDLE_VALUE;
     std::list<SwapchainImageContext> m_swapchainImageContexts;
-    std::map<const XrSwapchainImageBaseHeader*, SwapchainImageContext*> m_swapchainImageContextMap;
+    // The number of frames the CPU may record ahead of the GPU.
+    static constexpr uint32_t FramesInFlight = 3;
+    std::array<FrameResources, FramesInFlight> m_frames;
+    uint32_t m_frameIndex{0};
+    bool m_frameInProgress{false};
+    std::vector<ViewProjectionConstantBuffer*> m_viewProjections;  // Of the views rendered in the frame, in order
+    uint64_t m_timestampFrequency{1};  // Ticks per second of the command queue's timestamps
+    double m_gpuFrameTime{0};          // Milliseconds
+    bool m_gpuFrameTimeAvailable{false};
+    std::array<double, MaxTimedViews> m_gpuViewTimes{};  // Milliseconds, of the views of m_gpuFrameTime
+    uint32_t m_gpuViewTimeCount{0};
     XrGraphicsBindingD3D12KHR m_graphicsBinding{XR_TYPE_GRAPHICS_BINDING_D3D12_KHR};
     ComPtr<ID3D12RootSignature> m_rootSignature;
     std::map<DXGI_FORMAT, ComPtr<ID3D12PipelineState>> m_pipelineStates;
@@ -597,6 +998,12 @@ struct D3D12GraphicsPlugin : public IGraphicsPlugin {
     ComPtr<ID3D12DescriptorHeap> m_rtvHeap;
     ComPtr<ID3D12DescriptorHeap> m_dsvHeap;
     std::array<float, 4> m_clearColor;
+    // With Options::IndirectDraw, each view's cubes are culled and their transforms computed by the cull shader, and drawn
+    // with ExecuteIndirect.
+    bool m_indirectDraw{false};
+    ComPtr<ID3D12RootSignature> m_cullRootSignature;
+    ComPtr<ID3D12PipelineState> m_cullPipelineState;
+    ComPtr<ID3D12CommandSignature> m_drawCommandSignature;
 };
 }  // namespace
 
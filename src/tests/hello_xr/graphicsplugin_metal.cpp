@@ -18,12 +18,23 @@
 #include <QuartzCore/QuartzCore.hpp>
 
 #include <common/xr_linear.h>
+#include <dispatch/dispatch.h>
 #include <simd/simd.h>
 
 struct MetalGraphicsPlugin : public IGraphicsPlugin {
     MetalGraphicsPlugin(const std::shared_ptr<Options>& /*options*/, std::shared_ptr<IPlatformPlugin>) {}
 
     ~MetalGraphicsPlugin() override {
+        // Wait for the GPU to finish every frame in flight.  The semaphore is given back its initial value, since
+        // libdispatch does not allow releasing a semaphore with a lower value.
+        for (uint32_t i = 0; i < FramesInFlight; i++) {
+            dispatch_semaphore_wait(m_frameSemaphore, DISPATCH_TIME_FOREVER);
+        }
+        for (uint32_t i = 0; i < FramesInFlight; i++) {
+            dispatch_semaphore_signal(m_frameSemaphore);
+        }
+        dispatch_release(m_frameSemaphore);
+
         DestroyResources();
         m_commandQueue.reset();
         m_device.reset();
@@ -45,6 +56,7 @@ struct MetalGraphicsPlugin : public IGraphicsPlugin {
         m_graphicsBinding.commandQueue = m_commandQueue.get();
 
         InitializeResources();
+        InitializeViewTimers();
     }
 
     void InitializeResources() {
@@ -68,11 +80,12 @@ struct MetalGraphicsPlugin : public IGraphicsPlugin {
             v2f vertex vertexMain( uint vertexId [[vertex_id]],
                                    uint instanceId [[instance_id]],
                                    device const VertexBuffer* vertexBuffer [[buffer(0)]],
-                                   device const float4x4* matricesBuffer [[buffer(1)]] )
+                                   device const float4x4* modelsBuffer [[buffer(1)]],
+                                   constant float4x4& viewProjection [[buffer(2)]] )
             {
                 v2f o;
                 float4 pos = vertexBuffer[vertexId].position;
-                o.position = matricesBuffer[instanceId] * pos;
+                o.position = viewProjection * (modelsBuffer[instanceId] * pos);
                 o.color = half4(vertexBuffer[vertexId].color);
                 return o;
             }
@@ -105,12 +118,78 @@ struct MetalGraphicsPlugin : public IGraphicsPlugin {
     void DestroyResources() {
         DestroyBuffers();
 
+        for (FrameSlot& frame : m_frames) {
+            frame.viewTimestamps.reset();
+        }
         m_depthStencilState.reset();
         m_vertexFunction.reset();
         m_fragmentFunction.reset();
         m_library.reset();
     }
 
+    // Give each frame slot a buffer of GPU timestamps, sampled at the start of the vertex stage and the end of the fragment
+    // stage of each of its first views, if the device samples them at the boundaries of render stages.
+    void InitializeViewTimers() {
+        if (!m_device->supportsCounterSampling(MTL::CounterSamplingPointAtStageBoundary)) {
+            return;
+        }
+        MTL::CounterSet* timestampCounterSet = nullptr;
+        NS::Array* counterSets = m_device->counterSets();
+        for (NS::UInteger i = 0; counterSets != nullptr && i < counterSets->count(); ++i) {
+            MTL::CounterSet* counterSet = counterSets->object<MTL::CounterSet>(i);
+            if (counterSet->name()->isEqualToString(MTL::CommonCounterSetTimestamp)) {
+                timestampCounterSet = counterSet;
+            }
+        }
+        if (timestampCounterSet == nullptr) {
+            return;
+        }
+
+        auto sampleBufferDesc = NS::TransferPtr(MTL::CounterSampleBufferDescriptor::alloc()->init());
+        sampleBufferDesc->setCounterSet(timestampCounterSet);
+        sampleBufferDesc->setStorageMode(MTL::StorageModeShared);
+        sampleBufferDesc->setSampleCount(2 * MaxTimedViews);
+        for (FrameSlot& frame : m_frames) {
+            NS::Error* pError = nullptr;
+            frame.viewTimestamps = NS::TransferPtr(m_device->newCounterSampleBuffer(sampleBufferDesc.get(), &pError));
+            if (!frame.viewTimestamps) {
+                Log::Write(Log::Level::Warning, Fmt("Views are not timed: %s", pError->localizedDescription()->utf8String()));
+                for (FrameSlot& timedFrame : m_frames) {
+                    timedFrame.viewTimestamps.reset();
+                }
+                return;
+            }
+        }
+        // The GPU timestamps are in ticks of their own; a second sample of both clocks when they are read converts them.
+        m_device->sampleTimestamps(&m_cpuCalibrationTime, &m_gpuCalibrationTime);
+    }
+
+    // Convert the view timestamps of the current frame slot's last frame, which the GPU is done with, to milliseconds.
+    void ReadViewTimes() {
+        const FrameSlot& frame = m_frames[m_frameIndex];
+        MTL::Timestamp cpuTime = 0;
+        MTL::Timestamp gpuTime = 0;
+        m_device->sampleTimestamps(&cpuTime, &gpuTime);
+        if (gpuTime <= m_gpuCalibrationTime) {
+            return;
+        }
+        const double nanosecondsPerTick = (double)(cpuTime - m_cpuCalibrationTime) / (gpuTime - m_gpuCalibrationTime);
+        NS::Data* data = frame.viewTimestamps->resolveCounterRange(NS::Range::Make(0, 2 * frame.timedViews));
+        if (data == nullptr) {
+            return;
+        }
+        auto timestamps = static_cast<const MTL::CounterResultTimestamp*>(data->mutableBytes());
+        for (uint32_t view = 0; view < frame.timedViews; ++view) {
+            const MTL::Timestamp begin = timestamps[2 * view].timestamp;
+            const MTL::Timestamp end = timestamps[2 * view + 1].timestamp;
+            if (begin == MTL::CounterErrorValue || end == MTL::CounterErrorValue || end < begin) {
+                return;
+            }
+            m_gpuViewTimes[view] = (end - begin) * nanosecondsPerTick / 1e6;
+        }
+        m_gpuViewTimeCount = frame.timedViews;
+    }
+
     void BuildBuffers() {
         struct VertexData {
             simd::float4 position;
@@ -138,7 +217,10 @@ struct MetalGraphicsPlugin : public IGraphicsPlugin {
     }
 
     void DestroyBuffers() {
-        m_swapchainContextMap.clear();
+        for (FrameSlot& frame : m_frames) {
+            frame.matricesBuffer.reset();
+            frame.matricesOffset = 0;
+        }
         m_cubeVerticesBuffer.reset();
         m_cubeIndicesBuffer.reset();
     }
@@ -165,28 +247,34 @@ struct MetalGraphicsPlugin : public IGraphicsPlugin {
         uint32_t capacity, const XrSwapchainCreateInfo& /*swapchainCreateInfo*/) override {
         // Allocate and initialize the buffer of image structs (must be sequential in memory for xrEnumerateSwapchainImages).
         // Return back an array of pointers to each swapchain image struct so the consumer doesn't need to know the type/size.
-        std::vector<XrSwapchainImageMetalKHR> swapchainImageBuffer(capacity);
+        // Keep the buffer alive by adding it into the list of buffers.
+        m_swapchainImageBuffers.emplace_back(capacity);
         std::vector<XrSwapchainImageBaseHeader*> swapchainImageBase;
-        for (XrSwapchainImageMetalKHR& image : swapchainImageBuffer) {
+        for (XrSwapchainImageMetalKHR& image : m_swapchainImageBuffers.back()) {
             image.type = XR_TYPE_SWAPCHAIN_IMAGE_METAL_KHR;
             swapchainImageBase.push_back(reinterpret_cast<XrSwapchainImageBaseHeader*>(&image));
         }
 
-        // Keep the buffer alive by moving it into the list of buffers.
-        m_swapchainImageBuffers.push_back(std::move(swapchainImageBuffer));
-
-        for (auto imageBaseHeader : swapchainImageBase) {
-            m_swapchainContextMap.insert({imageBaseHeader, SwapchainContext()});
-        }
-
         return swapchainImageBase;
     }
 
+    // A command buffer keeps the textures it uses alive, so the images need no wait.  The depth texture is created again
+    // with the size of the next swapchains.
+    void ReleaseSwapchainImages() override {
+        CHECK(!m_frameCommandBuffer);
+        m_depthStencilTexture.reset();
+        m_swapchainImageBuffers.clear();
+    }
+
     void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                     int64_t swapchainFormat, const std::vector<Cube>& cubes) override {
         auto pAutoReleasePool = NS::TransferPtr(NS::AutoreleasePool::alloc()->init());
 
-        SwapchainContext& swapchainContext = m_swapchainContextMap[swapchainImage];
+        // Outside of BeginFrame and EndFrame, the view is a frame of its own.
+        const bool ownFrame = !m_frameCommandBuffer;
+        if (ownFrame) {
+            BeginFrame();
+        }
 
         auto mtlSwapchainFormat = (MTL::PixelFormat)swapchainFormat;
         if (mtlSwapchainFormat != m_colorAttachmentFormat) {
@@ -201,18 +289,28 @@ struct MetalGraphicsPlugin : public IGraphicsPlugin {
             if (!m_pipelineStateObject) {
                 Log::Write(Log::Level::Error, Fmt("%s", pError->localizedDescription()->utf8String()));
                 assert(false);
+                if (ownFrame) {
+                    EndFrame();
+                }
                 return;
             }
             m_colorAttachmentFormat = mtlSwapchainFormat;
         }
 
-        CHECK(layerView.subImage.imageArrayIndex == 0);  // Texture arrays not supported.
         void* rawTexture = reinterpret_cast<const XrSwapchainImageMetalKHR*>(swapchainImage)->texture;
         NS::SharedPtr<MTL::Texture> colorTexture = NS::RetainPtr(reinterpret_cast<MTL::Texture*>(rawTexture));
+        CHECK(layerView.subImage.imageArrayIndex < colorTexture->arrayLength());
 
+        // The layers of a texture array are rendered one at a time, so they share one depth texture of a single layer.
         if (!m_depthStencilTexture) {
+            MTL::TextureType depthTextureType = colorTexture->textureType();
+            if (depthTextureType == MTL::TextureType2DArray) {
+                depthTextureType = MTL::TextureType2D;
+            } else if (depthTextureType == MTL::TextureType2DMultisampleArray) {
+                depthTextureType = MTL::TextureType2DMultisample;
+            }
             auto depthTextureDescriptor = NS::TransferPtr(MTL::TextureDescriptor::alloc()->init());
-            depthTextureDescriptor->setTextureType(colorTexture->textureType());
+            depthTextureDescriptor->setTextureType(depthTextureType);
             depthTextureDescriptor->setPixelFormat(MTL::PixelFormatDepth32Float);
             depthTextureDescriptor->setWidth(colorTexture->width());
             depthTextureDescriptor->setHeight(colorTexture->height());
@@ -221,10 +319,9 @@ struct MetalGraphicsPlugin : public IGraphicsPlugin {
             m_depthStencilTexture = NS::TransferPtr(m_device->newTexture(depthTextureDescriptor.get()));
         }
 
-        MTL::CommandBuffer* pCmd = m_commandQueue->commandBuffer();
-
         auto renderPassDesc = NS::TransferPtr(MTL::RenderPassDescriptor::alloc()->init());
         renderPassDesc->colorAttachments()->object(0)->setTexture(colorTexture.get());
+        renderPassDesc->colorAttachments()->object(0)->setSlice(layerView.subImage.imageArrayIndex);
         renderPassDesc->colorAttachments()->object(0)->setClearColor(
             MTL::ClearColor(m_clearColor[0], m_clearColor[1], m_clearColor[2], m_clearColor[3]));
         renderPassDesc->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
@@ -233,7 +330,19 @@ struct MetalGraphicsPlugin : public IGraphicsPlugin {
         renderPassDesc->depthAttachment()->setLoadAction(MTL::LoadActionClear);
         renderPassDesc->depthAttachment()->setStoreAction(MTL::StoreActionStore);
 
-        MTL::RenderCommandEncoder* pEnc = pCmd->renderCommandEncoder(renderPassDesc.get());
+        FrameSlot& frame = m_frames[m_frameIndex];
+        if (frame.viewTimestamps && frame.timedViews < MaxTimedViews) {
+            MTL::RenderPassSampleBufferAttachmentDescriptor* sampleAttachment =
+                renderPassDesc->sampleBufferAttachments()->object(0);
+            sampleAttachment->setSampleBuffer(frame.viewTimestamps.get());
+            sampleAttachment->setStartOfVertexSampleIndex(2 * frame.timedViews);
+            sampleAttachment->setEndOfVertexSampleIndex(MTL::CounterDontSample);
+            sampleAttachment->setStartOfFragmentSampleIndex(MTL::CounterDontSample);
+            sampleAttachment->setEndOfFragmentSampleIndex(2 * frame.timedViews + 1);
+            frame.timedViews++;
+        }
+
+        MTL::RenderCommandEncoder* pEnc = m_frameCommandBuffer->renderCommandEncoder(renderPassDesc.get());
 
         MTL::Viewport viewport{(double)layerView.subImage.imageRect.offset.x,
                                (double)layerView.subImage.imageRect.offset.y,
@@ -245,48 +354,127 @@ struct MetalGraphicsPlugin : public IGraphicsPlugin {
         pEnc->setDepthStencilState(m_depthStencilState.get());
         pEnc->setCullMode(MTL::CullModeBack);
 
-        // Compute the view-projection transform.
-        // Note all matrixes are column-major, right-handed.
-        const auto& pose = layerView.pose;
-        XrMatrix4x4f proj;
-        XrMatrix4x4f_CreateProjectionFov(&proj, GRAPHICS_METAL, layerView.fov, 0.05f, 100.0f);
-        XrMatrix4x4f toView;
-        XrVector3f scale{1.f, 1.f, 1.f};
-        XrMatrix4x4f_CreateTranslationRotationScale(&toView, &pose.position, &pose.orientation, &scale);
-        XrMatrix4x4f view;
-        XrMatrix4x4f_InvertRigidBody(&view, &toView);
-        XrMatrix4x4f vp;
-        XrMatrix4x4f_Multiply(&vp, &proj, &view);
-
         static_assert(sizeof(XrMatrix4x4f) == sizeof(simd::float4x4), "Unexpected matrix size");
 
-        size_t matricesBufferLength = cubes.size() * sizeof(simd::float4x4);
-        if (!swapchainContext.m_cubeMatricesBuffer || swapchainContext.m_cubeMatricesBuffer->length() != matricesBufferLength) {
-            swapchainContext.m_cubeMatricesBuffer =
-                NS::TransferPtr(m_device->newBuffer(matricesBufferLength, MTL::ResourceStorageModeManaged));
-        }
-
-        auto matricesBufferData = (simd::float4x4*)swapchainContext.m_cubeMatricesBuffer->contents();
-        for (auto i = 0; i < cubes.size(); ++i) {
-            auto& cube = cubes[i];
-            // Compute and update the model transform.
-            XrMatrix4x4f model;
-            XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-            XrMatrix4x4f mvp;
-            XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-            memcpy(&matricesBufferData[i], &mvp, sizeof(simd::float4x4));
+        // Compute the view-projection transform into the frame's buffer too, where LateLatchViews can still rewrite it.
+        // Note all matrixes are column-major, right-handed.
+        MTL::Buffer* viewProjectionBuffer = nullptr;
+        const NS::UInteger viewProjectionOffset = AllocateMatrices(sizeof(simd::float4x4), &viewProjectionBuffer);
+        auto viewProjection = (XrMatrix4x4f*)((uint8_t*)viewProjectionBuffer->contents() + viewProjectionOffset);
+        XrMatrix4x4f_CreateViewProjectionFromPoseFov(viewProjection, GRAPHICS_METAL, &layerView.pose, layerView.fov, 0.05f, 100.0f);
+        m_viewProjections.push_back(viewProjection);
+
+        // Compute the model transform of every cube in place in the frame's buffer; the shader applies the view-projection.
+        MTL::Buffer* matricesBuffer = nullptr;
+        const NS::UInteger matricesOffset = AllocateMatrices(cubes.size() * sizeof(simd::float4x4), &matricesBuffer);
+        auto matricesBufferData = (XrMatrix4x4f*)((uint8_t*)matricesBuffer->contents() + matricesOffset);
+        for (size_t i = 0; i < cubes.size(); ++i) {
+            XrMatrix4x4f_CreateTranslationRotationScale(&matricesBufferData[i], &cubes[i].Pose.position, &cubes[i].Pose.orientation,
+                                                        &cubes[i].Scale);
         }
-        swapchainContext.m_cubeMatricesBuffer->didModifyRange(NS::Range::Make(0, swapchainContext.m_cubeMatricesBuffer->length()));
 
         pEnc->setRenderPipelineState(m_pipelineStateObject.get());
         pEnc->setVertexBuffer(m_cubeVerticesBuffer.get(), 0, 0);
-        pEnc->setVertexBuffer(swapchainContext.m_cubeMatricesBuffer.get(), 0, 1);
+        pEnc->setVertexBuffer(matricesBuffer, matricesOffset, 1);
+        pEnc->setVertexBuffer(viewProjectionBuffer, viewProjectionOffset, 2);
         uint32_t numCubeIdicies = sizeof(Geometry::c_cubeIndices) / sizeof(Geometry::c_cubeIndices[0]);
         pEnc->drawIndexedPrimitives(MTL::PrimitiveType::PrimitiveTypeTriangle, numCubeIdicies, MTL::IndexTypeUInt16,
                                     m_cubeIndicesBuffer.get(), 0, cubes.size());
 
         pEnc->endEncoding();
-        pCmd->commit();
+
+        if (ownFrame) {
+            EndFrame();
+        }
+    }
+
+    // Every view of a frame is encoded into one command buffer, committed in EndFrame.  The semaphore counts the frames
+    // the GPU has not finished: BeginFrame waits only when FramesInFlight frames are in flight, and then for the oldest,
+    // whose frame slot is reused.
+    void BeginFrame() override {
+        CHECK(!m_frameCommandBuffer);
+        dispatch_semaphore_wait(m_frameSemaphore, DISPATCH_TIME_FOREVER);
+        m_frameIndex = (m_frameIndex + 1) % FramesInFlight;
+        FrameSlot& frame = m_frames[m_frameIndex];
+        frame.matricesOffset = 0;
+        m_viewProjections.clear();
+
+        auto pAutoReleasePool = NS::TransferPtr(NS::AutoreleasePool::alloc()->init());
+        // The wait above is for this slot's previous frame, since a queue's command buffers complete in order.
+        if (frame.gpuTimed) {
+            m_gpuFrameTime = frame.gpuTime;
+            m_gpuFrameTimeAvailable = true;
+            frame.gpuTimed = false;
+            m_gpuViewTimeCount = 0;
+            if (frame.timedViews > 0) {
+                ReadViewTimes();
+            }
+        }
+        frame.timedViews = 0;
+
+        m_frameCommandBuffer = NS::RetainPtr(m_commandQueue->commandBuffer());
+    }
+
+    void EndFrame() override {
+        CHECK(m_frameCommandBuffer);
+        dispatch_semaphore_t frameSemaphore = m_frameSemaphore;
+        FrameSlot* frame = &m_frames[m_frameIndex];
+        m_frameCommandBuffer->addCompletedHandler([frameSemaphore, frame](MTL::CommandBuffer* commandBuffer) {
+            frame->gpuTime = (commandBuffer->GPUEndTime() - commandBuffer->GPUStartTime()) * 1000.0;
+            frame->gpuTimed = true;
+            dispatch_semaphore_signal(frameSemaphore);
+        });
+        m_frameCommandBuffer->commit();
+        m_frameCommandBuffer.reset();
+    }
+
+    // The command buffer is committed by EndFrame, and reads the view-projection transforms from shared storage, so they are
+    // simply rewritten from the latest poses.
+    bool SupportsLateLatching() const override { return true; }
+
+    void LateLatchViews(const std::vector<XrCompositionLayerProjectionView>& layerViews) override {
+        CHECK(m_frameCommandBuffer);
+        CHECK(m_viewProjections.size() <= layerViews.size());
+        for (size_t i = 0; i < m_viewProjections.size(); ++i) {
+            XrMatrix4x4f_CreateViewProjectionFromPoseFov(m_viewProjections[i], GRAPHICS_METAL, &layerViews[i].pose,
+                                                         layerViews[i].fov, 0.05f, 100.0f);
+        }
+    }
+
+    bool TakeGpuFrameTime(double* milliseconds) override {
+        if (!m_gpuFrameTimeAvailable) {
+            return false;
+        }
+        *milliseconds = m_gpuFrameTime;
+        m_gpuFrameTimeAvailable = false;
+        return true;
+    }
+
+    uint32_t TakeGpuViewTimes(std::array<double, MaxTimedViews>& milliseconds) override {
+        const uint32_t viewCount = m_gpuViewTimeCount;
+        milliseconds = m_gpuViewTimes;
+        m_gpuViewTimeCount = 0;
+        return viewCount;
+    }
+
+    // Sub-allocate space for the matrices of a view from the current frame slot's buffer.  The buffer is in shared
+    // storage, so the CPU writes are visible to the GPU without a didModifyRange.  When it is full it is replaced by one of
+    // twice the capacity; a command buffer keeps the buffers it uses alive, so the previous one outlives the frames that
+    // read it.
+    NS::UInteger AllocateMatrices(NS::UInteger size, MTL::Buffer** buffer) {
+        FrameSlot& frame = m_frames[m_frameIndex];
+        NS::UInteger offset = (frame.matricesOffset + MatricesAlignment - 1) & ~(MatricesAlignment - 1);
+        if (!frame.matricesBuffer || offset + size > frame.matricesBuffer->length()) {
+            NS::UInteger capacity = frame.matricesBuffer ? frame.matricesBuffer->length() * 2 : InitialMatricesCapacity;
+            while (capacity < size) {
+                capacity *= 2;
+            }
+            frame.matricesBuffer = NS::TransferPtr(m_device->newBuffer(capacity, MTL::ResourceStorageModeShared));
+            offset = 0;
+        }
+        frame.matricesOffset = offset + size;
+        *buffer = frame.matricesBuffer.get();
+        return offset;
     }
 
     void UpdateOptions(const std::shared_ptr<Options>& options) override { m_clearColor = options->GetBackgroundClearColor(); }
@@ -308,10 +496,31 @@ struct MetalGraphicsPlugin : public IGraphicsPlugin {
     XrGraphicsBindingMetalKHR m_graphicsBinding{XR_TYPE_GRAPHICS_BINDING_METAL_KHR};
     std::list<std::vector<XrSwapchainImageMetalKHR>> m_swapchainImageBuffers;
 
-    struct SwapchainContext {
-        NS::SharedPtr<MTL::Buffer> m_cubeMatricesBuffer;
+    // The number of frames the CPU may encode ahead of the GPU.
+    static constexpr uint32_t FramesInFlight = 3;
+    // The model matrices of each view start at a multiple of this offset in the frame slot's buffer.
+    static constexpr NS::UInteger MatricesAlignment = 256;
+    static constexpr NS::UInteger InitialMatricesCapacity = 64 * 1024;
+    struct FrameSlot {
+        NS::SharedPtr<MTL::Buffer> matricesBuffer;
+        NS::UInteger matricesOffset{0};
+        // Set by the completed handler of the slot's last frame, before it signals the frame semaphore.
+        double gpuTime{0};  // Milliseconds
+        bool gpuTimed{false};
+        NS::SharedPtr<MTL::CounterSampleBuffer> viewTimestamps;  // Two a view; none if the device cannot time views
+        uint32_t timedViews{0};                                  // Views sampled in the slot's last frame
     };
-    std::map<const XrSwapchainImageBaseHeader*, SwapchainContext> m_swapchainContextMap;
+    std::array<FrameSlot, FramesInFlight> m_frames;
+    uint32_t m_frameIndex{0};
+    dispatch_semaphore_t m_frameSemaphore{dispatch_semaphore_create(FramesInFlight)};
+    NS::SharedPtr<MTL::CommandBuffer> m_frameCommandBuffer;
+    std::vector<XrMatrix4x4f*> m_viewProjections;  // Of the views rendered in the frame, in order
+    double m_gpuFrameTime{0};  // Milliseconds
+    bool m_gpuFrameTimeAvailable{false};
+    std::array<double, MaxTimedViews> m_gpuViewTimes{};  // Milliseconds, of the views of m_gpuFrameTime
+    uint32_t m_gpuViewTimeCount{0};
+    MTL::Timestamp m_cpuCalibrationTime{0};  // Nanoseconds
+    MTL::Timestamp m_gpuCalibrationTime{0};  // GPU ticks at the same time
 
     NS::SharedPtr<MTL::Texture> m_depthStencilTexture;
 
@@ -20,13 +20,14 @@ static const char* VertexShaderGlsl = R"_(
 
     in vec3 VertexPos;
     in vec3 VertexColor;
+    in mat4 Model;  // Per instance
 
     out vec3 PSVertexColor;
 
-    uniform mat4 ModelViewProjection;
+    uniform mat4 ViewProjection;
 
     void main() {
-       gl_Position = ModelViewProjection * vec4(VertexPos, 1.0);
+       gl_Position = ViewProjection * (Model * vec4(VertexPos, 1.0));
        PSVertexColor = VertexColor;
     }
     )_";
@@ -42,9 +43,135 @@ static const char* FragmentShaderGlsl = R"_(
     }
     )_";
 
+// Not in the GL headers of gfxwrapper.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Whether the context has an extension, from its list of extension strings.
+bool HasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, (GLuint)i));
+        if (extension != nullptr && strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Linked program binaries kept across runs in a file keyed by the driver's vendor, renderer and version strings and by the
+// shader sources, so the shaders are only compiled on the first run, or after the driver or the shaders change.  Without
+// a directory, or if the driver has no program binary formats, nothing is kept.
+struct ProgramBinaryCache {
+    void Init(const std::string& directory, std::initializer_list<const char*> shaderSources) {
+        GLint formatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        if (directory.empty() || formatCount == 0) {
+            return;
+        }
+        std::string sources;
+        for (const char* source : shaderSources) {
+            sources += source;
+        }
+        // The file holds the whole key, which is checked on load; its hash only names the file.
+        m_key = Fmt("%s|%s|%s|%016llx", reinterpret_cast<const char*>(glGetString(GL_VENDOR)),
+                    reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+                    reinterpret_cast<const char*>(glGetString(GL_VERSION)),
+                    (unsigned long long)std::hash<std::string>{}(sources));
+        m_path = Fmt("%s/hello_xr_program_%016llx.bin", directory.c_str(), (unsigned long long)std::hash<std::string>{}(m_key));
+    }
+
+    // Before a program is linked from its shaders, so that its binary can be saved.
+    void PrepareLink(GLuint program) const {
+        if (!m_path.empty()) {
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+    }
+
+    // Load the program from the file, if it has a binary of this key that the driver accepts.
+    bool Load(GLuint program) const {
+        FILE* file = m_path.empty() ? nullptr : fopen(m_path.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        std::vector<char> data;
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            data.insert(data.end(), buffer, buffer + read);
+        }
+        fclose(file);
+
+        // The key and its terminator, the binary format, then the binary.
+        const size_t headerSize = m_key.size() + 1 + sizeof(GLenum);
+        if (data.size() <= headerSize || memcmp(data.data(), m_key.c_str(), m_key.size() + 1) != 0) {
+            Log::Write(Log::Level::Warning, Fmt("Ignoring the program binary %s of another driver", m_path.c_str()));
+            return false;
+        }
+        GLenum format;
+        memcpy(&format, data.data() + m_key.size() + 1, sizeof(format));
+        glProgramBinary(program, format, data.data() + headerSize, (GLsizei)(data.size() - headerSize));
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked == GL_FALSE) {
+            Log::Write(Log::Level::Warning, Fmt("The driver rejected the program binary %s", m_path.c_str()));
+            return false;
+        }
+        Log::Write(Log::Level::Verbose, Fmt("Program binary %s: %zu bytes loaded", m_path.c_str(), data.size() - headerSize));
+        return true;
+    }
+
+    // Write the binary of a linked program to the file, through a temporary file so that a crash never leaves a truncated
+    // binary behind.
+    void Save(GLuint program) const {
+        if (m_path.empty()) {
+            return;
+        }
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+        std::vector<char> data(m_key.c_str(), m_key.c_str() + m_key.size() + 1);
+        const size_t headerSize = data.size() + sizeof(GLenum);
+        data.resize(headerSize + length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, data.data() + headerSize);
+        memcpy(data.data() + headerSize - sizeof(format), &format, sizeof(format));
+        data.resize(headerSize + length);
+
+        const std::string tempPath = m_path + ".tmp";
+        FILE* file = fopen(tempPath.c_str(), "wb");
+        if (file == nullptr) {
+            Log::Write(Log::Level::Warning, Fmt("Cannot write the program binary %s", tempPath.c_str()));
+            return;
+        }
+        const bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+        if (fclose(file) != 0 || !written) {
+            Log::Write(Log::Level::Warning, Fmt("Cannot write the program binary %s", tempPath.c_str()));
+            remove(tempPath.c_str());
+            return;
+        }
+        // rename does not replace an existing file everywhere
+        remove(m_path.c_str());
+        if (rename(tempPath.c_str(), m_path.c_str()) != 0) {
+            Log::Write(Log::Level::Warning, Fmt("Cannot write the program binary %s", m_path.c_str()));
+            remove(tempPath.c_str());
+        }
+    }
+
+   private:
+    std::string m_key;
+    std::string m_path;
+};
+
 struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
     OpenGLGraphicsPlugin(const std::shared_ptr<Options>& options, const std::shared_ptr<IPlatformPlugin> /*unused*/&)
-        : m_clearColor(options->GetBackgroundClearColor()) {}
+        : m_clearColor(options->GetBackgroundClearColor()),
+          m_lowBandwidth(options->LowBandwidth),
+          m_cacheDirectory(options->CacheDirectory) {}
 
     OpenGLGraphicsPlugin(const OpenGLGraphicsPlugin&) = delete;
     OpenGLGraphicsPlugin& operator=(const OpenGLGraphicsPlugin&) = delete;
@@ -67,6 +194,18 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         if (m_cubeIndexBuffer != 0) {
             glDeleteBuffers(1, &m_cubeIndexBuffer);
         }
+        DestroyInstanceRing();
+        if (m_cubeInstanceBuffer != 0) {
+            glDeleteBuffers(1, &m_cubeInstanceBuffer);
+        }
+        if (m_timerQueries[0] != 0) {
+            glDeleteQueries((GLsizei)m_timerQueries.size(), m_timerQueries.data());
+        }
+        for (auto& viewTimestampQueries : m_viewTimestampQueries) {
+            if (viewTimestampQueries[0] != 0) {
+                glDeleteQueries((GLsizei)viewTimestampQueries.size(), viewTimestampQueries.data());
+            }
+        }
 
         for (auto& colorToDepth : m_colorToDepthMap) {
             if (colorToDepth.second != 0) {
@@ -163,29 +302,34 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
     void InitializeResources() {
         glGenFramebuffers(1, &m_swapchainFramebuffer);
 
-        GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShader, 1, &VertexShaderGlsl, nullptr);
-        glCompileShader(vertexShader);
-        CheckShader(vertexShader);
-
-        GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShader, 1, &FragmentShaderGlsl, nullptr);
-        glCompileShader(fragmentShader);
-        CheckShader(fragmentShader);
-
+        // Start on the program first: loaded from the program binary cache, or else compiled and linked, which a driver
+        // with GL_KHR_parallel_shader_compile does on its own threads while the buffers are set up below.  The attributes
+        // are bound to fixed locations, so the vertex array does not wait for the link to look them up.
+        m_vertexAttribCoords = 0;
+        m_vertexAttribColor = 1;
+        m_vertexAttribModel = 2;  // To 5, a column per location
         m_program = glCreateProgram();
-        glAttachShader(m_program, vertexShader);
-        glAttachShader(m_program, fragmentShader);
-        glLinkProgram(m_program);
-        CheckProgram(m_program);
-
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
-
-        m_modelViewProjectionUniformLocation = glGetUniformLocation(m_program, "ModelViewProjection");
-
-        m_vertexAttribCoords = glGetAttribLocation(m_program, "VertexPos");
-        m_vertexAttribColor = glGetAttribLocation(m_program, "VertexColor");
+        glBindAttribLocation(m_program, m_vertexAttribCoords, "VertexPos");
+        glBindAttribLocation(m_program, m_vertexAttribColor, "VertexColor");
+        glBindAttribLocation(m_program, m_vertexAttribModel, "Model");
+        m_programCache.Init(m_cacheDirectory, {VertexShaderGlsl, FragmentShaderGlsl});
+        const bool programCached = m_programCache.Load(m_program);
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        if (!programCached) {
+            vertexShader = glCreateShader(GL_VERTEX_SHADER);
+            glShaderSource(vertexShader, 1, &VertexShaderGlsl, nullptr);
+            glCompileShader(vertexShader);
+
+            fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(fragmentShader, 1, &FragmentShaderGlsl, nullptr);
+            glCompileShader(fragmentShader);
+
+            glAttachShader(m_program, vertexShader);
+            glAttachShader(m_program, fragmentShader);
+            m_programCache.PrepareLink(m_program);
+            glLinkProgram(m_program);
+        }
 
         glGenBuffers(1, &m_cubeVertexBuffer);
         glBindBuffer(GL_ARRAY_BUFFER, m_cubeVertexBuffer);
@@ -195,6 +339,8 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cubeIndexBuffer);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Geometry::c_cubeIndices), Geometry::c_cubeIndices, GL_STATIC_DRAW);
 
+        glGenBuffers(1, &m_cubeInstanceBuffer);
+
         glGenVertexArrays(1, &m_vao);
         glBindVertexArray(m_vao);
         glEnableVertexAttribArray(m_vertexAttribCoords);
@@ -204,6 +350,82 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         glVertexAttribPointer(m_vertexAttribCoords, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex), nullptr);
         glVertexAttribPointer(m_vertexAttribColor, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex),
                               reinterpret_cast<const void*>(sizeof(XrVector3f)));
+
+        // The model transform is per instance, one column per attribute location.
+        glBindBuffer(GL_ARRAY_BUFFER, m_cubeInstanceBuffer);
+        for (GLuint column = 0; column < 4; ++column) {
+            const GLuint location = m_vertexAttribModel + column;
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(XrMatrix4x4f),
+                                  reinterpret_cast<const void*>(column * 4 * sizeof(float)));
+            glVertexAttribDivisor(location, 1);
+        }
+
+        // Only now wait for the program, whose status queries block until the driver is done with it.
+        if (!programCached) {
+            if (HasGLExtension("GL_KHR_parallel_shader_compile") || HasGLExtension("GL_ARB_parallel_shader_compile")) {
+                GLint completed = GL_FALSE;
+                glGetProgramiv(m_program, GL_COMPLETION_STATUS_KHR, &completed);
+                Log::Write(Log::Level::Verbose,
+                           completed == GL_TRUE ? "Program linked in parallel" : "Waiting for the program to link");
+            }
+            CheckShader(vertexShader);
+            CheckShader(fragmentShader);
+            CheckProgram(m_program);
+            glDeleteShader(vertexShader);
+            glDeleteShader(fragmentShader);
+            m_programCache.Save(m_program);
+        }
+        m_viewProjectionUniformLocation = glGetUniformLocation(m_program, "ViewProjection");
+
+        CreateInstanceRing(InitialInstanceRegionCapacity);
+
+        glGenQueries((GLsizei)m_timerQueries.size(), m_timerQueries.data());
+        for (auto& viewTimestampQueries : m_viewTimestampQueries) {
+            glGenQueries((GLsizei)viewTimestampQueries.size(), viewTimestampQueries.data());
+        }
+    }
+
+    // With buffer storage, the cube transforms of every view are written straight into a persistently mapped ring of
+    // InstanceRegionCount regions, one per frame.  A frame's region is reused once the fence that EndFrame put after its
+    // draws has signaled, so neither the CPU nor the driver copies or waits on transforms still being read.
+    void CreateInstanceRing(size_t regionCapacity) {
+        DestroyInstanceRing();
+        if (!(GLAD_GL_VERSION_4_4 != 0 || GLAD_GL_ARB_buffer_storage != 0)) {
+            return;  // RenderView respecifies the instance buffer for every view instead.
+        }
+
+        // Buffer storage is immutable, so a ring that is too small is replaced by a new buffer.  Draws already made from
+        // the old one keep it alive until they are done.
+        if (m_cubeInstanceBuffer != 0) {
+            glDeleteBuffers(1, &m_cubeInstanceBuffer);
+        }
+        glGenBuffers(1, &m_cubeInstanceBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_cubeInstanceBuffer);
+        const GLsizeiptr size = static_cast<GLsizeiptr>(regionCapacity * InstanceRegionCount * sizeof(XrMatrix4x4f));
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        m_instanceRing = static_cast<XrMatrix4x4f*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        CHECK_MSG(m_instanceRing != nullptr, "Unable to map the instance ring buffer");
+        m_instanceRegionCapacity = regionCapacity;
+    }
+
+    void DestroyInstanceRing() {
+        for (GLsync& fence : m_instanceRegionFences) {
+            if (fence != nullptr) {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+        if (m_instanceRing != nullptr) {
+            glBindBuffer(GL_ARRAY_BUFFER, m_cubeInstanceBuffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            m_instanceRing = nullptr;
+        }
+        m_instanceRegion = 0;
+        m_instanceRegionUsed = 0;
     }
 
     void CheckShader(GLuint shader) {
@@ -238,10 +460,19 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
             GL_RGBA8,
             GL_RGBA8_SNORM,
         };
+        // With Options::LowBandwidth, banding is preferred to the twice as many bytes per pixel of GL_RGBA16F.
+        constexpr int64_t LowBandwidthColorSwapchainFormats[] = {
+            GL_RGB10_A2,
+            GL_RGBA8,
+            GL_RGBA8_SNORM,
+            GL_RGBA16F,
+        };
+        const int64_t* const supportedBegin =
+            m_lowBandwidth ? std::begin(LowBandwidthColorSwapchainFormats) : std::begin(SupportedColorSwapchainFormats);
+        const int64_t* const supportedEnd =
+            m_lowBandwidth ? std::end(LowBandwidthColorSwapchainFormats) : std::end(SupportedColorSwapchainFormats);
 
-        auto swapchainFormatIt =
-            std::find_first_of(runtimeFormats.begin(), runtimeFormats.end(), std::begin(SupportedColorSwapchainFormats),
-                               std::end(SupportedColorSwapchainFormats));
+        auto swapchainFormatIt = std::find_first_of(runtimeFormats.begin(), runtimeFormats.end(), supportedBegin, supportedEnd);
         if (swapchainFormatIt == runtimeFormats.end()) {
             THROW("No runtime swapchain format supported for color swapchain");
         }
@@ -254,13 +485,16 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
     }
 
     std::vector<XrSwapchainImageBaseHeader*> AllocateSwapchainImageStructs(
-        uint32_t capacity, const XrSwapchainCreateInfo& /*swapchainCreateInfo*/) override {
+        uint32_t capacity, const XrSwapchainCreateInfo& swapchainCreateInfo) override {
         // Allocate and initialize the buffer of image structs (must be sequential in memory for xrEnumerateSwapchainImages).
         // Return back an array of pointers to each swapchain image struct so the consumer doesn't need to know the type/size.
         std::vector<XrSwapchainImageOpenGLKHR> swapchainImageBuffer(capacity, {XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR});
         std::vector<XrSwapchainImageBaseHeader*> swapchainImageBase;
         for (XrSwapchainImageOpenGLKHR& image : swapchainImageBuffer) {
             swapchainImageBase.push_back(reinterpret_cast<XrSwapchainImageBaseHeader*>(&image));
+            if (swapchainCreateInfo.arraySize > 1) {
+                m_textureArrayImages.insert(swapchainImageBase.back());
+            }
         }
 
         // Keep the buffer alive by moving it into the list of buffers.
@@ -269,7 +503,20 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         return swapchainImageBase;
     }
 
-    uint32_t GetDepthTexture(uint32_t colorTexture) {
+    // The driver keeps deleted textures until the commands using them are done, so the images need no wait.
+    void ReleaseSwapchainImages() override {
+        for (auto& colorToDepth : m_colorToDepthMap) {
+            if (colorToDepth.second != 0) {
+                glDeleteTextures(1, &colorToDepth.second);
+            }
+        }
+        m_colorToDepthMap.clear();
+        m_textureArrayImages.clear();
+        m_swapchainImageBuffers.clear();
+    }
+
+    // The layers of a texture array are rendered one at a time, so they share one depth texture of a single layer.
+    uint32_t GetDepthTexture(uint32_t colorTexture, GLenum colorTarget) {
         // If a depth-stencil view has already been created for this back-buffer, use it.
         auto depthBufferIt = m_colorToDepthMap.find(colorTexture);
         if (depthBufferIt != m_colorToDepthMap.end()) {
@@ -280,9 +527,9 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
 
         GLint width;
         GLint height;
-        glBindTexture(GL_TEXTURE_2D, colorTexture);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+        glBindTexture(colorTarget, colorTexture);
+        glGetTexLevelParameteriv(colorTarget, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(colorTarget, 0, GL_TEXTURE_HEIGHT, &height);
 
         uint32_t depthTexture;
         glGenTextures(1, &depthTexture);
@@ -300,13 +547,39 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
 
     void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                     int64_t swapchainFormat, const std::vector<Cube>& cubes) override {
-        CHECK(layerView.subImage.imageArrayIndex == 0);  // Texture arrays not supported.
-        UNUSED_PARM(swapchainFormat);                    // Not used in this function for now.
+        UNUSED_PARM(swapchainFormat);  // Not used in this function for now.
+
+        const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(swapchainImage)->image;
+        const GLenum colorTarget = m_textureArrayImages.count(swapchainImage) != 0 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
 
         glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, GetDepthTexture(colorTexture, colorTarget), 0);
+        RenderViewToFramebuffer(layerView, swapchainImage, cubes);
+    }
 
-        const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(swapchainImage)->image;
+    int64_t SelectDepthSwapchainFormat(const std::vector<int64_t>& runtimeFormats) const override {
+        constexpr int64_t SupportedDepthSwapchainFormats[] = {GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT16};
+
+        auto swapchainFormatIt =
+            std::find_first_of(runtimeFormats.begin(), runtimeFormats.end(), std::begin(SupportedDepthSwapchainFormats),
+                               std::end(SupportedDepthSwapchainFormats));
+        return swapchainFormatIt == runtimeFormats.end() ? 0 : *swapchainFormatIt;
+    }
+
+    void RenderViewWithDepth(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
+                             int64_t /*swapchainFormat*/, const XrSwapchainImageBaseHeader* depthImage, uint32_t depthArrayIndex,
+                             const std::vector<Cube>& cubes) override {
+        const uint32_t depthTexture = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(depthImage)->image;
 
+        glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, (GLint)depthArrayIndex);
+        RenderViewToFramebuffer(layerView, swapchainImage, cubes);
+    }
+
+    // Render a view to the swapchain image, or to its layer of a texture array, with the depth attachment of the bound
+    // swapchain framebuffer, which is unbound after.
+    void RenderViewToFramebuffer(const XrCompositionLayerProjectionView& layerView,
+                                 const XrSwapchainImageBaseHeader* swapchainImage, const std::vector<Cube>& cubes) {
         glViewport(static_cast<GLint>(layerView.subImage.imageRect.offset.x),
                    static_cast<GLint>(layerView.subImage.imageRect.offset.y),
                    static_cast<GLsizei>(layerView.subImage.imageRect.extent.width),
@@ -317,10 +590,14 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         glEnable(GL_CULL_FACE);
         glEnable(GL_DEPTH_TEST);
 
-        const uint32_t depthTexture = GetDepthTexture(colorTexture);
-
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+        const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(swapchainImage)->image;
+        if (m_textureArrayImages.count(swapchainImage) != 0) {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0,
+                                      (GLint)layerView.subImage.imageArrayIndex);
+        } else {
+            CHECK(layerView.subImage.imageArrayIndex == 0);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        }
 
         // Clear swapchain and depth buffer.
         glClearColor(m_clearColor[0], m_clearColor[1], m_clearColor[2], m_clearColor[3]);
@@ -330,39 +607,147 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         // Set shaders and uniform variables.
         glUseProgram(m_program);
 
-        const auto& pose = layerView.pose;
-        XrMatrix4x4f proj;
-        XrMatrix4x4f_CreateProjectionFov(&proj, GRAPHICS_OPENGL, layerView.fov, 0.05f, 100.0f);
-        XrMatrix4x4f toView;
-        XrMatrix4x4f_CreateFromRigidTransform(&toView, &pose);
-        XrMatrix4x4f view;
-        XrMatrix4x4f_InvertRigidBody(&view, &toView);
         XrMatrix4x4f vp;
-        XrMatrix4x4f_Multiply(&vp, &proj, &view);
+        XrMatrix4x4f_CreateViewProjectionFromPoseFov(&vp, GRAPHICS_OPENGL, &layerView.pose, layerView.fov, 0.05f, 100.0f);
+
+        glUniformMatrix4fv(m_viewProjectionUniformLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&vp));
 
         // Set cube primitive data.
         glBindVertexArray(m_vao);
+        UploadCubeModels(cubes);
 
-        // Render each cube
-        for (const Cube& cube : cubes) {
-            // Compute the model-view-projection transform and set it..
-            XrMatrix4x4f model;
-            XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-            XrMatrix4x4f mvp;
-            XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-            glUniformMatrix4fv(m_modelViewProjectionUniformLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&mvp));
-
-            // Draw the cube.
-            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(ArraySize(Geometry::c_cubeIndices)), GL_UNSIGNED_SHORT, nullptr);
-        }
+        // Draw every cube.
+        glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(ArraySize(Geometry::c_cubeIndices)), GL_UNSIGNED_SHORT, nullptr,
+                                static_cast<GLsizei>(cubes.size()));
 
         glBindVertexArray(0);
         glUseProgram(0);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // The view takes from the previous timestamp to this one.
+        uint32_t& viewCount = m_timedViewCounts[m_timerQueryIndex];
+        if (viewCount < MaxTimedViews) {
+            glQueryCounter(m_viewTimestampQueries[m_timerQueryIndex][1 + viewCount++], GL_TIMESTAMP);
+        }
+    }
+
+    // Compute the model transform of every cube into the instance buffer, and point the per instance Model attribute at
+    // them.  Needs the vertex array bound.
+    void UploadCubeModels(const std::vector<Cube>& cubes) {
+        if (m_instanceRing != nullptr && m_instanceRegionUsed + cubes.size() > m_instanceRegionCapacity) {
+            CreateInstanceRing(std::max(m_instanceRegionCapacity * 2, m_instanceRegionUsed + cubes.size()));
+        }
+
+        XrMatrix4x4f* models;
+        size_t offset = 0;
+        if (m_instanceRing != nullptr) {
+            const size_t first = m_instanceRegion * m_instanceRegionCapacity + m_instanceRegionUsed;
+            models = m_instanceRing + first;
+            offset = first * sizeof(XrMatrix4x4f);
+            m_instanceRegionUsed += cubes.size();
+        } else {
+            m_cubeModels.resize(cubes.size());
+            models = m_cubeModels.data();
+        }
+        for (size_t i = 0; i < cubes.size(); ++i) {
+            XrMatrix4x4f_CreateTranslationRotationScale(&models[i], &cubes[i].Pose.position, &cubes[i].Pose.orientation,
+                                                        &cubes[i].Scale);
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_cubeInstanceBuffer);
+        if (m_instanceRing == nullptr) {
+            // Respecifying the storage lets the driver hand out new memory instead of waiting for draws still reading the
+            // previous transforms.
+            glBufferData(GL_ARRAY_BUFFER, m_cubeModels.size() * sizeof(XrMatrix4x4f), m_cubeModels.data(), GL_STREAM_DRAW);
+        }
+        for (GLuint column = 0; column < 4; ++column) {
+            glVertexAttribPointer(m_vertexAttribModel + column, 4, GL_FLOAT, GL_FALSE, sizeof(XrMatrix4x4f),
+                                  reinterpret_cast<const void*>(offset + column * 4 * sizeof(float)));
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void BeginFrame() override {
+        // Read the time of the frame that last used this timer query, TimerQueryCount - 1 frames back, then time this one.
+        m_timerQueryIndex = (m_timerQueryIndex + 1) % TimerQueryCount;
+        const GLuint timerQuery = m_timerQueries[m_timerQueryIndex];
+        if (m_timerQueryPending[m_timerQueryIndex]) {
+            GLuint64 elapsedNanoseconds = 0;
+            glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsedNanoseconds);
+            m_gpuFrameTime = elapsedNanoseconds / 1e6;
+            m_gpuFrameTimeAvailable = true;
+            m_timerQueryPending[m_timerQueryIndex] = false;
+
+            // The views are timed with timestamps, since GL_TIME_ELAPSED queries do not nest.
+            const uint32_t viewCount = m_timedViewCounts[m_timerQueryIndex];
+            GLuint64 viewBegin = 0;
+            glGetQueryObjectui64v(m_viewTimestampQueries[m_timerQueryIndex][0], GL_QUERY_RESULT, &viewBegin);
+            for (uint32_t view = 0; view < viewCount; ++view) {
+                GLuint64 viewEnd = 0;
+                glGetQueryObjectui64v(m_viewTimestampQueries[m_timerQueryIndex][1 + view], GL_QUERY_RESULT, &viewEnd);
+                m_gpuViewTimes[view] = (viewEnd - viewBegin) / 1e6;
+                viewBegin = viewEnd;
+            }
+            m_gpuViewTimeCount = viewCount;
+        }
+        glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+        glQueryCounter(m_viewTimestampQueries[m_timerQueryIndex][0], GL_TIMESTAMP);
+        m_timedViewCounts[m_timerQueryIndex] = 0;
+
+        if (m_instanceRing == nullptr) {
+            return;
+        }
+        m_instanceRegion = (m_instanceRegion + 1) % InstanceRegionCount;
+        m_instanceRegionUsed = 0;
+        GLsync& fence = m_instanceRegionFences[m_instanceRegion];
+        if (fence != nullptr) {
+            // Normally signaled long ago, InstanceRegionCount - 1 frames back.
+            GLenum result;
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+            CHECK_MSG(result != GL_WAIT_FAILED, "glClientWaitSync failed");
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    void EndFrame() override {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_timerQueryPending[m_timerQueryIndex] = true;
+
+        if (m_instanceRing != nullptr) {
+            m_instanceRegionFences[m_instanceRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
     }
 
+    bool TakeGpuFrameTime(double* milliseconds) override {
+        if (!m_gpuFrameTimeAvailable) {
+            return false;
+        }
+        *milliseconds = m_gpuFrameTime;
+        m_gpuFrameTimeAvailable = false;
+        return true;
+    }
+
+    uint32_t TakeGpuViewTimes(std::array<double, MaxTimedViews>& milliseconds) override {
+        const uint32_t viewCount = m_gpuViewTimeCount;
+        milliseconds = m_gpuViewTimes;
+        m_gpuViewTimeCount = 0;
+        return viewCount;
+    }
+
+    bool SupportsRenderThread() const override { return false; }
+
     uint32_t GetSupportedSwapchainSampleCount(const XrViewConfigurationView&) override { return 1; }
 
+    uint64_t GetSwapchainImageMemorySize(const XrSwapchainCreateInfo& createInfo) const override {
+        // The depth texture of a color texture is GL_DEPTH_COMPONENT32, and is not multisampled.
+        const uint64_t colorSampleSize = createInfo.format == GL_RGBA16F ? 8 : 4;
+        const uint64_t pixelCount = (uint64_t)createInfo.width * createInfo.height * createInfo.arraySize;
+        return pixelCount * (colorSampleSize * createInfo.sampleCount + 4);
+    }
+
     void UpdateOptions(const std::shared_ptr<Options>& options) override { m_clearColor = options->GetBackgroundClearColor(); }
 
    private:
@@ -381,18 +766,47 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
 #endif
 
     std::list<std::vector<XrSwapchainImageOpenGLKHR>> m_swapchainImageBuffers;
+    std::set<const XrSwapchainImageBaseHeader*> m_textureArrayImages;  // The image structs of texture array swapchains
     GLuint m_swapchainFramebuffer{0};
     GLuint m_program{0};
-    GLint m_modelViewProjectionUniformLocation{0};
+    GLint m_viewProjectionUniformLocation{0};
     GLint m_vertexAttribCoords{0};
     GLint m_vertexAttribColor{0};
+    GLint m_vertexAttribModel{0};
     GLuint m_vao{0};
+    std::vector<XrMatrix4x4f> m_cubeModels;
     GLuint m_cubeVertexBuffer{0};
     GLuint m_cubeIndexBuffer{0};
+    GLuint m_cubeInstanceBuffer{0};
+
+    // The persistently mapped instance ring, or null without buffer storage.
+    static constexpr uint32_t InstanceRegionCount = 3;
+    static constexpr size_t InitialInstanceRegionCapacity = 256;  // Transforms per region
+    XrMatrix4x4f* m_instanceRing{nullptr};
+    size_t m_instanceRegionCapacity{0};
+    uint32_t m_instanceRegion{0};
+    size_t m_instanceRegionUsed{0};  // Transforms already written to the current region in this frame
+    std::array<GLsync, InstanceRegionCount> m_instanceRegionFences{};
+
+    // GL_TIME_ELAPSED queries of the last frames, each read when BeginFrame reuses it, with GL_TIMESTAMP queries at the
+    // start of each frame and after each of its first views.
+    static constexpr uint32_t TimerQueryCount = 3;
+    std::array<GLuint, TimerQueryCount> m_timerQueries{};
+    std::array<std::array<GLuint, MaxTimedViews + 1>, TimerQueryCount> m_viewTimestampQueries{};
+    std::array<uint32_t, TimerQueryCount> m_timedViewCounts{};
+    std::array<bool, TimerQueryCount> m_timerQueryPending{};
+    uint32_t m_timerQueryIndex{0};
+    double m_gpuFrameTime{0};  // Milliseconds
+    bool m_gpuFrameTimeAvailable{false};
+    std::array<double, MaxTimedViews> m_gpuViewTimes{};  // Milliseconds, of the views of m_gpuFrameTime
+    uint32_t m_gpuViewTimeCount{0};
 
     // Map color buffer to associated depth buffer. This map is populated on demand.
     std::map<uint32_t, uint32_t> m_colorToDepthMap;
     std::array<float, 4> m_clearColor;
+    const bool m_lowBandwidth;  // Options::LowBandwidth
+    std::string m_cacheDirectory;  // Options::CacheDirectory, where m_programCache keeps program binaries
+    ProgramBinaryCache m_programCache;
 };
 }  // namespace
 
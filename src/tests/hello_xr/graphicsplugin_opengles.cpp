@@ -20,13 +20,14 @@ static const char* VertexShaderGlsl = R"_(#version 320 es
 
     in vec3 VertexPos;
     in vec3 VertexColor;
+    in mat4 Model;  // Per instance
 
     out vec3 PSVertexColor;
 
-    uniform mat4 ModelViewProjection;
+    uniform mat4 ViewProjection;
 
     void main() {
-       gl_Position = ModelViewProjection * vec4(VertexPos, 1.0);
+       gl_Position = ViewProjection * (Model * vec4(VertexPos, 1.0));
        PSVertexColor = VertexColor;
     }
     )_";
@@ -42,9 +43,133 @@ static const char* FragmentShaderGlsl = R"_(#version 320 es
     }
     )_";
 
+// Not in the GL headers of gfxwrapper.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Whether the context has an extension, from its list of extension strings.
+bool HasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, (GLuint)i));
+        if (extension != nullptr && strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Linked program binaries kept across runs in a file keyed by the driver's vendor, renderer and version strings and by the
+// shader sources, so the shaders are only compiled on the first run, or after the driver or the shaders change.  Without
+// a directory, or if the driver has no program binary formats, nothing is kept.
+struct ProgramBinaryCache {
+    void Init(const std::string& directory, std::initializer_list<const char*> shaderSources) {
+        GLint formatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        if (directory.empty() || formatCount == 0) {
+            return;
+        }
+        std::string sources;
+        for (const char* source : shaderSources) {
+            sources += source;
+        }
+        // The file holds the whole key, which is checked on load; its hash only names the file.
+        m_key = Fmt("%s|%s|%s|%016llx", reinterpret_cast<const char*>(glGetString(GL_VENDOR)),
+                    reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+                    reinterpret_cast<const char*>(glGetString(GL_VERSION)),
+                    (unsigned long long)std::hash<std::string>{}(sources));
+        m_path = Fmt("%s/hello_xr_program_%016llx.bin", directory.c_str(), (unsigned long long)std::hash<std::string>{}(m_key));
+    }
+
+    // Before a program is linked from its shaders, so that its binary can be saved.
+    void PrepareLink(GLuint program) const {
+        if (!m_path.empty()) {
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+    }
+
+    // Load the program from the file, if it has a binary of this key that the driver accepts.
+    bool Load(GLuint program) const {
+        FILE* file = m_path.empty() ? nullptr : fopen(m_path.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        std::vector<char> data;
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            data.insert(data.end(), buffer, buffer + read);
+        }
+        fclose(file);
+
+        // The key and its terminator, the binary format, then the binary.
+        const size_t headerSize = m_key.size() + 1 + sizeof(GLenum);
+        if (data.size() <= headerSize || memcmp(data.data(), m_key.c_str(), m_key.size() + 1) != 0) {
+            Log::Write(Log::Level::Warning, Fmt("Ignoring the program binary %s of another driver", m_path.c_str()));
+            return false;
+        }
+        GLenum format;
+        memcpy(&format, data.data() + m_key.size() + 1, sizeof(format));
+        glProgramBinary(program, format, data.data() + headerSize, (GLsizei)(data.size() - headerSize));
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked == GL_FALSE) {
+            Log::Write(Log::Level::Warning, Fmt("The driver rejected the program binary %s", m_path.c_str()));
+            return false;
+        }
+        Log::Write(Log::Level::Verbose, Fmt("Program binary %s: %zu bytes loaded", m_path.c_str(), data.size() - headerSize));
+        return true;
+    }
+
+    // Write the binary of a linked program to the file, through a temporary file so that a crash never leaves a truncated
+    // binary behind.
+    void Save(GLuint program) const {
+        if (m_path.empty()) {
+            return;
+        }
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+        std::vector<char> data(m_key.c_str(), m_key.c_str() + m_key.size() + 1);
+        const size_t headerSize = data.size() + sizeof(GLenum);
+        data.resize(headerSize + length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, data.data() + headerSize);
+        memcpy(data.data() + headerSize - sizeof(format), &format, sizeof(format));
+        data.resize(headerSize + length);
+
+        const std::string tempPath = m_path + ".tmp";
+        FILE* file = fopen(tempPath.c_str(), "wb");
+        if (file == nullptr) {
+            Log::Write(Log::Level::Warning, Fmt("Cannot write the program binary %s", tempPath.c_str()));
+            return;
+        }
+        const bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+        if (fclose(file) != 0 || !written) {
+            Log::Write(Log::Level::Warning, Fmt("Cannot write the program binary %s", tempPath.c_str()));
+            remove(tempPath.c_str());
+            return;
+        }
+        // rename does not replace an existing file everywhere
+        remove(m_path.c_str());
+        if (rename(tempPath.c_str(), m_path.c_str()) != 0) {
+            Log::Write(Log::Level::Warning, Fmt("Cannot write the program binary %s", m_path.c_str()));
+            remove(tempPath.c_str());
+        }
+    }
+
+   private:
+    std::string m_key;
+    std::string m_path;
+};
+
 struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
     OpenGLESGraphicsPlugin(const std::shared_ptr<Options>& options, const std::shared_ptr<IPlatformPlugin> /*unused*/&)
-        : m_clearColor(options->GetBackgroundClearColor()) {}
+        : m_clearColor(options->GetBackgroundClearColor()), m_cacheDirectory(options->CacheDirectory) {}
 
     OpenGLESGraphicsPlugin(const OpenGLESGraphicsPlugin&) = delete;
     OpenGLESGraphicsPlugin& operator=(const OpenGLESGraphicsPlugin&) = delete;
@@ -67,6 +192,10 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         if (m_cubeIndexBuffer != 0) {
             glDeleteBuffers(1, &m_cubeIndexBuffer);
         }
+        DestroyInstanceRing();
+        if (m_cubeInstanceBuffer != 0) {
+            glDeleteBuffers(1, &m_cubeInstanceBuffer);
+        }
 
         for (auto& colorToDepth : m_colorToDepthMap) {
             if (colorToDepth.second != 0) {
@@ -140,29 +269,34 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
     void InitializeResources() {
         glGenFramebuffers(1, &m_swapchainFramebuffer);
 
-        GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShader, 1, &VertexShaderGlsl, nullptr);
-        glCompileShader(vertexShader);
-        CheckShader(vertexShader);
-
-        GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShader, 1, &FragmentShaderGlsl, nullptr);
-        glCompileShader(fragmentShader);
-        CheckShader(fragmentShader);
-
+        // Start on the program first: loaded from the program binary cache, or else compiled and linked, which a driver
+        // with GL_KHR_parallel_shader_compile does on its own threads while the buffers are set up below.  The attributes
+        // are bound to fixed locations, so the vertex array does not wait for the link to look them up.
+        m_vertexAttribCoords = 0;
+        m_vertexAttribColor = 1;
+        m_vertexAttribModel = 2;  // To 5, a column per location
         m_program = glCreateProgram();
-        glAttachShader(m_program, vertexShader);
-        glAttachShader(m_program, fragmentShader);
-        glLinkProgram(m_program);
-        CheckProgram(m_program);
-
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
-
-        m_modelViewProjectionUniformLocation = glGetUniformLocation(m_program, "ModelViewProjection");
-
-        m_vertexAttribCoords = glGetAttribLocation(m_program, "VertexPos");
-        m_vertexAttribColor = glGetAttribLocation(m_program, "VertexColor");
+        glBindAttribLocation(m_program, m_vertexAttribCoords, "VertexPos");
+        glBindAttribLocation(m_program, m_vertexAttribColor, "VertexColor");
+        glBindAttribLocation(m_program, m_vertexAttribModel, "Model");
+        m_programCache.Init(m_cacheDirectory, {VertexShaderGlsl, FragmentShaderGlsl});
+        const bool programCached = m_programCache.Load(m_program);
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        if (!programCached) {
+            vertexShader = glCreateShader(GL_VERTEX_SHADER);
+            glShaderSource(vertexShader, 1, &VertexShaderGlsl, nullptr);
+            glCompileShader(vertexShader);
+
+            fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(fragmentShader, 1, &FragmentShaderGlsl, nullptr);
+            glCompileShader(fragmentShader);
+
+            glAttachShader(m_program, vertexShader);
+            glAttachShader(m_program, fragmentShader);
+            m_programCache.PrepareLink(m_program);
+            glLinkProgram(m_program);
+        }
 
         glGenBuffers(1, &m_cubeVertexBuffer);
         glBindBuffer(GL_ARRAY_BUFFER, m_cubeVertexBuffer);
@@ -172,6 +306,8 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cubeIndexBuffer);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Geometry::c_cubeIndices), Geometry::c_cubeIndices, GL_STATIC_DRAW);
 
+        glGenBuffers(1, &m_cubeInstanceBuffer);
+
         glGenVertexArrays(1, &m_vao);
         glBindVertexArray(m_vao);
         glEnableVertexAttribArray(m_vertexAttribCoords);
@@ -181,6 +317,77 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         glVertexAttribPointer(m_vertexAttribCoords, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex), nullptr);
         glVertexAttribPointer(m_vertexAttribColor, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex),
                               reinterpret_cast<const void*>(sizeof(XrVector3f)));
+
+        // The model transform is per instance, one column per attribute location.
+        glBindBuffer(GL_ARRAY_BUFFER, m_cubeInstanceBuffer);
+        for (GLuint column = 0; column < 4; ++column) {
+            const GLuint location = m_vertexAttribModel + column;
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(XrMatrix4x4f),
+                                  reinterpret_cast<const void*>(column * 4 * sizeof(float)));
+            glVertexAttribDivisor(location, 1);
+        }
+
+        // Only now wait for the program, whose status queries block until the driver is done with it.
+        if (!programCached) {
+            if (HasGLExtension("GL_KHR_parallel_shader_compile")) {
+                GLint completed = GL_FALSE;
+                glGetProgramiv(m_program, GL_COMPLETION_STATUS_KHR, &completed);
+                Log::Write(Log::Level::Verbose,
+                           completed == GL_TRUE ? "Program linked in parallel" : "Waiting for the program to link");
+            }
+            CheckShader(vertexShader);
+            CheckShader(fragmentShader);
+            CheckProgram(m_program);
+            glDeleteShader(vertexShader);
+            glDeleteShader(fragmentShader);
+            m_programCache.Save(m_program);
+        }
+        m_viewProjectionUniformLocation = glGetUniformLocation(m_program, "ViewProjection");
+
+        CreateInstanceRing(InitialInstanceRegionCapacity);
+    }
+
+    // With buffer storage, the cube transforms of every view are written straight into a persistently mapped ring of
+    // InstanceRegionCount regions, one per frame.  A frame's region is reused once the fence that EndFrame put after its
+    // draws has signaled, so neither the CPU nor the driver copies or waits on transforms still being read.
+    void CreateInstanceRing(size_t regionCapacity) {
+        DestroyInstanceRing();
+        if (!(GLAD_GL_EXT_buffer_storage != 0)) {
+            return;  // RenderView respecifies the instance buffer for every view instead.
+        }
+
+        // Buffer storage is immutable, so a ring that is too small is replaced by a new buffer.  Draws already made from
+        // the old one keep it alive until they are done.
+        if (m_cubeInstanceBuffer != 0) {
+            glDeleteBuffers(1, &m_cubeInstanceBuffer);
+        }
+        glGenBuffers(1, &m_cubeInstanceBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_cubeInstanceBuffer);
+        const GLsizeiptr size = static_cast<GLsizeiptr>(regionCapacity * InstanceRegionCount * sizeof(XrMatrix4x4f));
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorageEXT(GL_ARRAY_BUFFER, size, nullptr, flags);
+        m_instanceRing = static_cast<XrMatrix4x4f*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        CHECK_MSG(m_instanceRing != nullptr, "Unable to map the instance ring buffer");
+        m_instanceRegionCapacity = regionCapacity;
+    }
+
+    void DestroyInstanceRing() {
+        for (GLsync& fence : m_instanceRegionFences) {
+            if (fence != nullptr) {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+        if (m_instanceRing != nullptr) {
+            glBindBuffer(GL_ARRAY_BUFFER, m_cubeInstanceBuffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            m_instanceRing = nullptr;
+        }
+        m_instanceRegion = 0;
+        m_instanceRegionUsed = 0;
     }
 
     void CheckShader(GLuint shader) {
@@ -229,13 +436,16 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
     }
 
     std::vector<XrSwapchainImageBaseHeader*> AllocateSwapchainImageStructs(
-        uint32_t capacity, const XrSwapchainCreateInfo& /*swapchainCreateInfo*/) override {
+        uint32_t capacity, const XrSwapchainCreateInfo& swapchainCreateInfo) override {
         // Allocate and initialize the buffer of image structs (must be sequential in memory for xrEnumerateSwapchainImages).
         // Return back an array of pointers to each swapchain image struct so the consumer doesn't need to know the type/size.
         std::vector<XrSwapchainImageOpenGLESKHR> swapchainImageBuffer(capacity, {XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_ES_KHR});
         std::vector<XrSwapchainImageBaseHeader*> swapchainImageBase;
         for (XrSwapchainImageOpenGLESKHR& image : swapchainImageBuffer) {
             swapchainImageBase.push_back(reinterpret_cast<XrSwapchainImageBaseHeader*>(&image));
+            if (swapchainCreateInfo.arraySize > 1) {
+                m_textureArrayImages.insert(swapchainImageBase.back());
+            }
         }
 
         // Keep the buffer alive by moving it into the list of buffers.
@@ -244,7 +454,20 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         return swapchainImageBase;
     }
 
-    uint32_t GetDepthTexture(uint32_t colorTexture) {
+    // The driver keeps deleted textures until the commands using them are done, so the images need no wait.
+    void ReleaseSwapchainImages() override {
+        for (auto& colorToDepth : m_colorToDepthMap) {
+            if (colorToDepth.second != 0) {
+                glDeleteTextures(1, &colorToDepth.second);
+            }
+        }
+        m_colorToDepthMap.clear();
+        m_textureArrayImages.clear();
+        m_swapchainImageBuffers.clear();
+    }
+
+    // The layers of a texture array are rendered one at a time, so they share one depth texture of a single layer.
+    uint32_t GetDepthTexture(uint32_t colorTexture, GLenum colorTarget) {
         // If a depth-stencil view has already been created for this back-buffer, use it.
         auto depthBufferIt = m_colorToDepthMap.find(colorTexture);
         if (depthBufferIt != m_colorToDepthMap.end()) {
@@ -255,9 +478,9 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
 
         GLint width;
         GLint height;
-        glBindTexture(GL_TEXTURE_2D, colorTexture);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+        glBindTexture(colorTarget, colorTexture);
+        glGetTexLevelParameteriv(colorTarget, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(colorTarget, 0, GL_TEXTURE_HEIGHT, &height);
 
         uint32_t depthTexture;
         glGenTextures(1, &depthTexture);
@@ -275,8 +498,7 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
 
     void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                     int64_t swapchainFormat, const std::vector<Cube>& cubes) override {
-        CHECK(layerView.subImage.imageArrayIndex == 0);  // Texture arrays not supported.
-        UNUSED_PARM(swapchainFormat);                    // Not used in this function for now.
+        UNUSED_PARM(swapchainFormat);  // Not used in this function for now.
 
         glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer);
 
@@ -292,9 +514,16 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         glEnable(GL_CULL_FACE);
         glEnable(GL_DEPTH_TEST);
 
-        const uint32_t depthTexture = GetDepthTexture(colorTexture);
+        const bool textureArray = m_textureArrayImages.count(swapchainImage) != 0;
+        const uint32_t depthTexture = GetDepthTexture(colorTexture, textureArray ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D);
 
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        if (textureArray) {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0,
+                                      (GLint)layerView.subImage.imageArrayIndex);
+        } else {
+            CHECK(layerView.subImage.imageArrayIndex == 0);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        }
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
 
         // Clear swapchain and depth buffer.
@@ -305,37 +534,87 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         // Set shaders and uniform variables.
         glUseProgram(m_program);
 
-        const auto& pose = layerView.pose;
-        XrMatrix4x4f proj;
-        XrMatrix4x4f_CreateProjectionFov(&proj, GRAPHICS_OPENGL_ES, layerView.fov, 0.05f, 100.0f);
-        XrMatrix4x4f toView;
-        XrMatrix4x4f_CreateFromRigidTransform(&toView, &pose);
-        XrMatrix4x4f view;
-        XrMatrix4x4f_InvertRigidBody(&view, &toView);
         XrMatrix4x4f vp;
-        XrMatrix4x4f_Multiply(&vp, &proj, &view);
+        XrMatrix4x4f_CreateViewProjectionFromPoseFov(&vp, GRAPHICS_OPENGL_ES, &layerView.pose, layerView.fov, 0.05f, 100.0f);
+
+        glUniformMatrix4fv(m_viewProjectionUniformLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&vp));
 
         // Set cube primitive data.
         glBindVertexArray(m_vao);
+        UploadCubeModels(cubes);
 
-        // Render each cube
-        for (const Cube& cube : cubes) {
-            // Compute the model-view-projection transform and set it..
-            XrMatrix4x4f model;
-            XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-            XrMatrix4x4f mvp;
-            XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-            glUniformMatrix4fv(m_modelViewProjectionUniformLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&mvp));
-
-            // Draw the cube.
-            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(ArraySize(Geometry::c_cubeIndices)), GL_UNSIGNED_SHORT, nullptr);
-        }
+        // Draw every cube.
+        glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(ArraySize(Geometry::c_cubeIndices)), GL_UNSIGNED_SHORT, nullptr,
+                                static_cast<GLsizei>(cubes.size()));
 
         glBindVertexArray(0);
         glUseProgram(0);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 
+    // Compute the model transform of every cube into the instance buffer, and point the per instance Model attribute at
+    // them.  Needs the vertex array bound.
+    void UploadCubeModels(const std::vector<Cube>& cubes) {
+        if (m_instanceRing != nullptr && m_instanceRegionUsed + cubes.size() > m_instanceRegionCapacity) {
+            CreateInstanceRing(std::max(m_instanceRegionCapacity * 2, m_instanceRegionUsed + cubes.size()));
+        }
+
+        XrMatrix4x4f* models;
+        size_t offset = 0;
+        if (m_instanceRing != nullptr) {
+            const size_t first = m_instanceRegion * m_instanceRegionCapacity + m_instanceRegionUsed;
+            models = m_instanceRing + first;
+            offset = first * sizeof(XrMatrix4x4f);
+            m_instanceRegionUsed += cubes.size();
+        } else {
+            m_cubeModels.resize(cubes.size());
+            models = m_cubeModels.data();
+        }
+        for (size_t i = 0; i < cubes.size(); ++i) {
+            XrMatrix4x4f_CreateTranslationRotationScale(&models[i], &cubes[i].Pose.position, &cubes[i].Pose.orientation,
+                                                        &cubes[i].Scale);
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_cubeInstanceBuffer);
+        if (m_instanceRing == nullptr) {
+            // Respecifying the storage lets the driver hand out new memory instead of waiting for draws still reading the
+            // previous transforms.
+            glBufferData(GL_ARRAY_BUFFER, m_cubeModels.size() * sizeof(XrMatrix4x4f), m_cubeModels.data(), GL_STREAM_DRAW);
+        }
+        for (GLuint column = 0; column < 4; ++column) {
+            glVertexAttribPointer(m_vertexAttribModel + column, 4, GL_FLOAT, GL_FALSE, sizeof(XrMatrix4x4f),
+                                  reinterpret_cast<const void*>(offset + column * 4 * sizeof(float)));
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void BeginFrame() override {
+        if (m_instanceRing == nullptr) {
+            return;
+        }
+        m_instanceRegion = (m_instanceRegion + 1) % InstanceRegionCount;
+        m_instanceRegionUsed = 0;
+        GLsync& fence = m_instanceRegionFences[m_instanceRegion];
+        if (fence != nullptr) {
+            // Normally signaled long ago, InstanceRegionCount - 1 frames back.
+            GLenum result;
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+            CHECK_MSG(result != GL_WAIT_FAILED, "glClientWaitSync failed");
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    void EndFrame() override {
+        if (m_instanceRing != nullptr) {
+            m_instanceRegionFences[m_instanceRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+    }
+
+    bool SupportsRenderThread() const override { return false; }
+
     uint32_t GetSupportedSwapchainSampleCount(const XrViewConfigurationView&) override { return 1; }
 
     void UpdateOptions(const std::shared_ptr<Options>& options) override { m_clearColor = options->GetBackgroundClearColor(); }
@@ -346,19 +625,34 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
 #endif
 
     std::list<std::vector<XrSwapchainImageOpenGLESKHR>> m_swapchainImageBuffers;
+    std::set<const XrSwapchainImageBaseHeader*> m_textureArrayImages;  // The image structs of texture array swapchains
     GLuint m_swapchainFramebuffer{0};
     GLuint m_program{0};
-    GLint m_modelViewProjectionUniformLocation{0};
+    GLint m_viewProjectionUniformLocation{0};
     GLint m_vertexAttribCoords{0};
     GLint m_vertexAttribColor{0};
+    GLint m_vertexAttribModel{0};
     GLuint m_vao{0};
+    std::vector<XrMatrix4x4f> m_cubeModels;
     GLuint m_cubeVertexBuffer{0};
     GLuint m_cubeIndexBuffer{0};
+    GLuint m_cubeInstanceBuffer{0};
+
+    // The persistently mapped instance ring, or null without buffer storage.
+    static constexpr uint32_t InstanceRegionCount = 3;
+    static constexpr size_t InitialInstanceRegionCapacity = 256;  // Transforms per region
+    XrMatrix4x4f* m_instanceRing{nullptr};
+    size_t m_instanceRegionCapacity{0};
+    uint32_t m_instanceRegion{0};
+    size_t m_instanceRegionUsed{0};  // Transforms already written to the current region in this frame
+    std::array<GLsync, InstanceRegionCount> m_instanceRegionFences{};
     GLint m_contextApiMajorVersion{0};
 
     // Map color buffer to associated depth buffer. This map is populated on demand.
     std::map<uint32_t, uint32_t> m_colorToDepthMap;
     std::array<float, 4> m_clearColor;
+    std::string m_cacheDirectory;  // Options::CacheDirectory, where m_programCache keeps program binaries
+    ProgramBinaryCache m_programCache;
 };
 }  // namespace
 
@@ -10,6 +10,7 @@
 
 #ifdef XR_USE_GRAPHICS_API_VULKAN
 #include <common/vulkan_debug_object_namer.hpp>
+#include <common/xr_late_latch.hpp>
 #include <common/xr_linear.h>
 
 #ifdef USE_ONLINE_VULKAN_SHADERC
@@ -112,11 +113,12 @@ constexpr char VertexShaderGlsl[] =
 
     layout (std140, push_constant) uniform buf
     {
-        mat4 mvp;
+        mat4 vp;
     } ubuf;
 
     layout (location = 0) in vec3 Position;
     layout (location = 1) in vec3 Color;
+    layout (location = 2) in mat4 Model;
 
     layout (location = 0) out vec4 oColor;
     out gl_PerVertex
@@ -127,7 +129,36 @@ constexpr char VertexShaderGlsl[] =
     void main()
     {
         oColor.rgba  = Color.rgba;
-        gl_Position = ubuf.mvp * Position;
+        gl_Position = ubuf.vp * (Model * vec4(Position, 1));
+    }
+)_";
+
+// VertexShaderGlsl for a multiview render pass: gl_ViewIndex selects the view's view-projection matrix.
+constexpr char MultiviewVertexShaderGlsl[] =
+    R"_(
+    #version 450
+    #extension GL_ARB_separate_shader_objects : enable
+    #extension GL_EXT_multiview : require
+
+    layout (std140, push_constant) uniform buf
+    {
+        mat4 vp[2];
+    } ubuf;
+
+    layout (location = 0) in vec3 Position;
+    layout (location = 1) in vec3 Color;
+    layout (location = 2) in mat4 Model;
+
+    layout (location = 0) out vec4 oColor;
+    out gl_PerVertex
+    {
+        vec4 gl_Position;
+    };
+
+    void main()
+    {
+        oColor = vec4(Color, 1.0);
+        gl_Position = ubuf.vp[gl_ViewIndex] * (Model * vec4(Position, 1));
     }
 )_";
 
@@ -145,37 +176,371 @@ constexpr char FragmentShaderGlsl[] =
         FragColor = oColor;
     }
 )_";
+
+// The shaders of the motion vectors of XR_FB_space_warp: how far each cube moved since the previous frame, in normalized
+// device coordinates of the current view.
+constexpr char MotionVectorVertexShaderGlsl[] =
+    R"_(
+    #version 430
+    #extension GL_ARB_separate_shader_objects : enable
+
+    layout (std140, push_constant) uniform buf
+    {
+        mat4 vp;
+    } ubuf;
+
+    layout (location = 0) in vec3 Position;
+    layout (location = 2) in mat4 Model;
+    layout (location = 6) in mat4 PreviousModel;
+
+    layout (location = 0) out vec4 oPosition;
+    layout (location = 1) out vec4 oPreviousPosition;
+    out gl_PerVertex
+    {
+        vec4 gl_Position;
+    };
+
+    void main()
+    {
+        oPosition = ubuf.vp * (Model * vec4(Position, 1));
+        oPreviousPosition = ubuf.vp * (PreviousModel * vec4(Position, 1));
+        gl_Position = oPosition;
+    }
+)_";
+
+constexpr char MotionVectorFragmentShaderGlsl[] =
+    R"_(
+    #version 430
+    #extension GL_ARB_separate_shader_objects : enable
+
+    layout (location = 0) in vec4 oPosition;
+    layout (location = 1) in vec4 oPreviousPosition;
+
+    layout (location = 0) out vec4 MotionVector;
+
+    void main()
+    {
+        MotionVector = vec4(oPosition.xyz / oPosition.w - oPreviousPosition.xyz / oPreviousPosition.w, 0.0);
+    }
+)_";
+
+// The compute shader of Options::IndirectDraw: the model transform of each cube whose bounding sphere is inside the frustum
+// planes is written to the instance buffer, after those of the others inside, and counted into the draw's instance count.
+constexpr char CullComputeShaderGlsl[] =
+    R"_(
+    #version 450
+
+    layout (local_size_x = 64) in;
+
+    layout (std140, push_constant) uniform buf
+    {
+        vec4 planes[4];
+        uint cubeCount;
+    } ubuf;
+
+    layout (std430, binding = 0) readonly buffer Cubes
+    {
+        float cubes[];
+    };
+
+    layout (std430, binding = 1) writeonly buffer Models
+    {
+        vec4 models[];
+    };
+
+    layout (std430, binding = 2) buffer DrawIndexedIndirect
+    {
+        uint indexCount;
+        uint instanceCount;
+        uint firstIndex;
+        int vertexOffset;
+        uint firstInstance;
+    } draw;
+
+    void main()
+    {
+        uint cube = gl_GlobalInvocationID.x;
+        if (cube < ubuf.cubeCount) {
+            uint c = cube * 10u;
+            vec4 q = vec4(cubes[c], cubes[c + 1u], cubes[c + 2u], cubes[c + 3u]);
+            vec3 position = vec3(cubes[c + 4u], cubes[c + 5u], cubes[c + 6u]);
+            vec3 scale = vec3(cubes[c + 7u], cubes[c + 8u], cubes[c + 9u]);
+
+            float radius = 0.5 * length(scale);
+            float inside = min(min(dot(ubuf.planes[0].xyz, position) + ubuf.planes[0].w,
+                                   dot(ubuf.planes[1].xyz, position) + ubuf.planes[1].w),
+                               min(dot(ubuf.planes[2].xyz, position) + ubuf.planes[2].w,
+                                   dot(ubuf.planes[3].xyz, position) + ubuf.planes[3].w));
+            if (inside > -radius) {
+                uint instance = atomicAdd(draw.instanceCount, 1u);
+
+                vec3 q2 = q.xyz + q.xyz;
+                float xx2 = q.x * q2.x;
+                float yy2 = q.y * q2.y;
+                float zz2 = q.z * q2.z;
+                float yz2 = q.y * q2.z;
+                float wx2 = q.w * q2.x;
+                float xy2 = q.x * q2.y;
+                float wz2 = q.w * q2.z;
+                float xz2 = q.x * q2.z;
+                float wy2 = q.w * q2.y;
+                models[instance * 4u] = vec4(vec3(1.0 - yy2 - zz2, xy2 + wz2, xz2 - wy2) * scale.x, 0.0);
+                models[instance * 4u + 1u] = vec4(vec3(xy2 - wz2, 1.0 - xx2 - zz2, yz2 + wx2) * scale.y, 0.0);
+                models[instance * 4u + 2u] = vec4(vec3(xz2 + wy2, yz2 - wx2, 1.0 - xx2 - yy2) * scale.z, 0.0);
+                models[instance * 4u + 3u] = vec4(position, 1.0);
+            }
+        }
+    }
+)_";
 #endif  // USE_ONLINE_VULKAN_SHADERC
 
+// A range of one of MemoryAllocator's blocks.  Resources bind to memory at offset; in host visible memory, mapped is the
+// range's host address, valid until the range is freed.
+struct MemoryAllocation {
+    VkDeviceMemory memory{VK_NULL_HANDLE};
+    VkDeviceSize offset{0};
+    VkDeviceSize size{0};
+    uint8_t* mapped{nullptr};
+    uint32_t block{0};
+};
+
+// Sub-allocates resource memory from a few large blocks per memory type, so that vkAllocateMemory is called a handful of
+// times however many resources there are, well under maxMemoryAllocationCount.  Resources that live as long as the device,
+// like the static geometry, come from linear blocks that are only ever appended to.  Resources that come and go, like depth
+// buffers and instance buffers, come from free-list blocks, whose freed ranges are merged with their free neighbors and
+// reused.
 struct MemoryAllocator {
+    enum class Pool { Linear, FreeList };
+
+    static const VkFlags defaultFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    static constexpr VkDeviceSize maxBlockSize = 64 * 1024 * 1024;
+
+    MemoryAllocator() = default;
+
+    ~MemoryAllocator() {
+        if (m_vkDevice != VK_NULL_HANDLE) {
+            for (const Block& block : m_blocks) {
+                vkFreeMemory(m_vkDevice, block.memory, nullptr);
+            }
+        }
+        m_blocks.clear();
+        m_vkDevice = VK_NULL_HANDLE;
+    }
+
+    MemoryAllocator(const MemoryAllocator&) = delete;
+    MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+    MemoryAllocator(MemoryAllocator&&) = delete;
+    MemoryAllocator& operator=(MemoryAllocator&&) = delete;
+
     void Init(VkPhysicalDevice physicalDevice, VkDevice device) {
         m_vkDevice = device;
         vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memProps);
+
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(physicalDevice, &props);
+        m_bufferImageGranularity = props.limits.bufferImageGranularity;
     }
 
-    static const VkFlags defaultFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    MemoryAllocation Allocate(VkMemoryRequirements const& memReqs, VkFlags flags = defaultFlags, Pool pool = Pool::FreeList) {
+        const uint32_t memoryTypeIndex = FindMemoryType(memReqs, flags);
+
+        // Every range is aligned to bufferImageGranularity as well, so buffers and optimal tiling images can share blocks.
+        const VkDeviceSize alignment = std::max(memReqs.alignment, m_bufferImageGranularity);
+        const VkDeviceSize size = AlignUp(memReqs.size, alignment);
+
+        MemoryAllocation allocation;
+        for (uint32_t i = 0; i < (uint32_t)m_blocks.size(); ++i) {
+            Block& block = m_blocks[i];
+            if (block.memoryTypeIndex == memoryTypeIndex && block.pool == pool &&
+                AllocateFrom(block, size, alignment, &allocation)) {
+                allocation.block = i;
+                return allocation;
+            }
+        }
+
+        // No room: add a block, or a range of its own for a resource bigger than a block.
+        const VkDeviceSize heapSize = m_memProps.memoryHeaps[m_memProps.memoryTypes[memoryTypeIndex].heapIndex].size;
+        Block block;
+        block.memoryTypeIndex = memoryTypeIndex;
+        block.pool = pool;
+        block.size = std::max(size, std::min(maxBlockSize, heapSize / 8));
+        VkMemoryAllocateInfo memAlloc{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        memAlloc.allocationSize = block.size;
+        memAlloc.memoryTypeIndex = memoryTypeIndex;
+        CHECK_VKCMD(vkAllocateMemory(m_vkDevice, &memAlloc, nullptr, &block.memory));
+        if ((m_memProps.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) {
+            // A block can only be mapped once, so host visible blocks stay mapped for their whole lifetime.
+            CHECK_VKCMD(vkMapMemory(m_vkDevice, block.memory, 0, VK_WHOLE_SIZE, 0, (void**)&block.mapped));
+        }
+        block.freeRanges[0] = block.size;
+        m_blocks.push_back(block);
 
-    void Allocate(VkMemoryRequirements const& memReqs, VkDeviceMemory* mem, VkFlags flags = defaultFlags,
-                  const void* pNext = nullptr) const {
+        CHECK(AllocateFrom(m_blocks.back(), size, alignment, &allocation));
+        allocation.block = (uint32_t)m_blocks.size() - 1;
+        return allocation;
+    }
+
+    // Return the range to its block and reset the allocation.  The GPU must be done with the resources bound to it.  Ranges
+    // of linear blocks are only reclaimed with their block, when the allocator is destroyed.
+    void Free(MemoryAllocation* allocation) {
+        if (allocation->memory == VK_NULL_HANDLE) {
+            return;
+        }
+        Block& block = m_blocks[allocation->block];
+        if (block.pool == Pool::FreeList) {
+            auto range = block.freeRanges.emplace(allocation->offset, allocation->size).first;
+            auto next = std::next(range);
+            if (next != block.freeRanges.end() && range->first + range->second == next->first) {
+                range->second += next->second;
+                block.freeRanges.erase(next);
+            }
+            if (range != block.freeRanges.begin()) {
+                auto prev = std::prev(range);
+                if (prev->first + prev->second == range->first) {
+                    prev->second += range->second;
+                    block.freeRanges.erase(range);
+                }
+            }
+        }
+        *allocation = {};
+    }
+
+   private:
+    struct Block {
+        VkDeviceMemory memory{VK_NULL_HANDLE};
+        VkDeviceSize size{0};
+        uint32_t memoryTypeIndex{0};
+        Pool pool{Pool::FreeList};
+        uint8_t* mapped{nullptr};
+        // Offset and size of every free range, in offset order.  A linear block only has the one range at its end.
+        std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+    };
+
+    static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    uint32_t FindMemoryType(VkMemoryRequirements const& memReqs, VkFlags flags) const {
         // Search memtypes to find first index with those properties
         for (uint32_t i = 0; i < m_memProps.memoryTypeCount; ++i) {
             if ((memReqs.memoryTypeBits & (1 << i)) != 0u) {
                 // Type is available, does it match user properties?
                 if ((m_memProps.memoryTypes[i].propertyFlags & flags) == flags) {
-                    VkMemoryAllocateInfo memAlloc{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, pNext};
-                    memAlloc.allocationSize = memReqs.size;
-                    memAlloc.memoryTypeIndex = i;
-                    CHECK_VKCMD(vkAllocateMemory(m_vkDevice, &memAlloc, nullptr, mem));
-                    return;
+                    return i;
                 }
             }
         }
         THROW("Memory format not supported");
     }
 
-   private:
+    // Take the first free range that fits, splitting off what is left of it on either side.
+    static bool AllocateFrom(Block& block, VkDeviceSize size, VkDeviceSize alignment, MemoryAllocation* allocation) {
+        for (auto range = block.freeRanges.begin(); range != block.freeRanges.end(); ++range) {
+            const VkDeviceSize rangeOffset = range->first;
+            const VkDeviceSize rangeEnd = range->first + range->second;
+            const VkDeviceSize offset = AlignUp(rangeOffset, alignment);
+            if (offset + size > rangeEnd) {
+                continue;
+            }
+            block.freeRanges.erase(range);
+            if (offset > rangeOffset && block.pool == Pool::FreeList) {
+                block.freeRanges[rangeOffset] = offset - rangeOffset;
+            }
+            if (offset + size < rangeEnd) {
+                block.freeRanges[offset + size] = rangeEnd - (offset + size);
+            }
+
+            allocation->memory = block.memory;
+            allocation->offset = offset;
+            allocation->size = size;
+            allocation->mapped = block.mapped != nullptr ? block.mapped + offset : nullptr;
+            return true;
+        }
+        return false;
+    }
+
     VkDevice m_vkDevice{VK_NULL_HANDLE};
     VkPhysicalDeviceMemoryProperties m_memProps{};
+    VkDeviceSize m_bufferImageGranularity{1};
+    std::vector<Block> m_blocks;
+};
+
+// QueueTimeline - the VK_KHR_timeline_semaphore of a queue, when the device enables it.  Every submission to the queue
+// signals the semaphore with the next value of one counter, so a submission is done once the semaphore reaches its value:
+// that is a compare against the last value read back, and the host only waits on a submission that is not known to be done.
+struct QueueTimeline {
+    VkSemaphore semaphore{VK_NULL_HANDLE};
+
+    QueueTimeline() = default;
+
+    QueueTimeline(const QueueTimeline&) = delete;
+    QueueTimeline& operator=(const QueueTimeline&) = delete;
+    QueueTimeline(QueueTimeline&&) = delete;
+    QueueTimeline& operator=(QueueTimeline&&) = delete;
+
+    ~QueueTimeline() {
+        if (m_vkDevice != nullptr && semaphore != VK_NULL_HANDLE) {
+            vkDestroySemaphore(m_vkDevice, semaphore, nullptr);
+        }
+        semaphore = VK_NULL_HANDLE;
+        m_vkDevice = nullptr;
+    }
+
+#if defined(VK_KHR_timeline_semaphore)
+    // Returns false if the device lacks the commands, leaving the timeline unused.
+    bool Init(const VulkanDebugObjectNamer& namer, VkDevice device) {
+        m_vkGetSemaphoreCounterValueKHR =
+            (PFN_vkGetSemaphoreCounterValueKHR)vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR");
+        m_vkWaitSemaphoresKHR = (PFN_vkWaitSemaphoresKHR)vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR");
+        if (m_vkGetSemaphoreCounterValueKHR == nullptr || m_vkWaitSemaphoresKHR == nullptr) {
+            return false;
+        }
+
+        m_vkDevice = device;
+        VkSemaphoreTypeCreateInfoKHR typeInfo{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR};
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+        typeInfo.initialValue = 0;
+        VkSemaphoreCreateInfo semInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        semInfo.pNext = &typeInfo;
+        CHECK_VKCMD(vkCreateSemaphore(m_vkDevice, &semInfo, nullptr, &semaphore));
+        CHECK_VKCMD(namer.SetName(VK_OBJECT_TYPE_SEMAPHORE, (uint64_t)semaphore, "hello_xr queue timeline semaphore"));
+        return true;
+    }
+
+    // The value the next submission signals.
+    uint64_t Next() { return ++m_submitted; }
+
+    bool Reached(uint64_t value) {
+        if (value > m_completed) {
+            CHECK_VKCMD(m_vkGetSemaphoreCounterValueKHR(m_vkDevice, semaphore, &m_completed));
+        }
+        return value <= m_completed;
+    }
+
+    bool Wait(uint64_t value, uint64_t timeoutNs) {
+        if (Reached(value)) {
+            return true;
+        }
+        VkSemaphoreWaitInfoKHR waitInfo{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR};
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+        if (m_vkWaitSemaphoresKHR(m_vkDevice, &waitInfo, timeoutNs) != VK_SUCCESS) {
+            return false;
+        }
+        m_completed = std::max(m_completed, value);
+        return true;
+    }
+#endif
+
+   private:
+    VkDevice m_vkDevice{VK_NULL_HANDLE};
+    uint64_t m_submitted{0};
+    uint64_t m_completed{0};  // The last value read back, which the semaphore has reached
+#if defined(VK_KHR_timeline_semaphore)
+    PFN_vkGetSemaphoreCounterValueKHR m_vkGetSemaphoreCounterValueKHR{nullptr};
+    PFN_vkWaitSemaphoresKHR m_vkWaitSemaphoresKHR{nullptr};
+#endif
 };
 
 // CmdBuffer - manage VkCommandBuffer state
@@ -194,7 +559,8 @@ struct CmdBuffer {
     CmdBufferState state{CmdBufferState::Undefined};
     VkCommandPool pool{VK_NULL_HANDLE};
     VkCommandBuffer buf{VK_NULL_HANDLE};
-    VkFence execFence{VK_NULL_HANDLE};
+    VkFence execFence{VK_NULL_HANDLE};  // Null with a timeline, which tracks the buffer by the value it signals instead
+    uint64_t execValue{0};
 
     CmdBuffer() = default;
 
@@ -242,10 +608,12 @@ struct CmdBuffer {
         }                                                                                                          \
     while (0)
 
-    bool Init(const VulkanDebugObjectNamer& namer, VkDevice device, uint32_t queueFamilyIndex) {
+    // With a timeline, every submission of the buffer signals it, and no fence is created.
+    bool Init(const VulkanDebugObjectNamer& namer, VkDevice device, uint32_t queueFamilyIndex, QueueTimeline* timeline = nullptr) {
         CHECK_CBSTATE(CmdBufferState::Undefined);
 
         m_vkDevice = device;
+        m_timeline = timeline;
 
         // Create a command pool to allocate our command buffer from
         VkCommandPoolCreateInfo cmdPoolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
@@ -262,9 +630,11 @@ struct CmdBuffer {
         CHECK_VKCMD(vkAllocateCommandBuffers(m_vkDevice, &cmd, &buf));
         CHECK_VKCMD(namer.SetName(VK_OBJECT_TYPE_COMMAND_BUFFER, (uint64_t)buf, "hello_xr command buffer"));
 
-        VkFenceCreateInfo fenceInfo{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
-        CHECK_VKCMD(vkCreateFence(m_vkDevice, &fenceInfo, nullptr, &execFence));
-        CHECK_VKCMD(namer.SetName(VK_OBJECT_TYPE_FENCE, (uint64_t)execFence, "hello_xr fence"));
+        if (m_timeline == nullptr) {
+            VkFenceCreateInfo fenceInfo{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+            CHECK_VKCMD(vkCreateFence(m_vkDevice, &fenceInfo, nullptr, &execFence));
+            CHECK_VKCMD(namer.SetName(VK_OBJECT_TYPE_FENCE, (uint64_t)execFence, "hello_xr fence"));
+        }
 
         SetState(CmdBufferState::Initialized);
         return true;
@@ -291,6 +661,17 @@ struct CmdBuffer {
         VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &buf;
+#if defined(VK_KHR_timeline_semaphore)
+        VkTimelineSemaphoreSubmitInfoKHR timelineInfo{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR};
+        if (m_timeline != nullptr) {
+            execValue = m_timeline->Next();
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &execValue;
+            submitInfo.pNext = &timelineInfo;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &m_timeline->semaphore;
+        }
+#endif
         CHECK_VKCMD(vkQueueSubmit(queue, 1, &submitInfo, execFence));
 
         SetState(CmdBufferState::Executing);
@@ -307,8 +688,13 @@ struct CmdBuffer {
 
         const uint32_t timeoutNs = 1 * 1000 * 1000 * 1000;
         for (int i = 0; i < 5; ++i) {
-            auto res = vkWaitForFences(m_vkDevice, 1, &execFence, VK_TRUE, timeoutNs);
-            if (res == VK_SUCCESS) {
+#if defined(VK_KHR_timeline_semaphore)
+            const bool done = m_timeline != nullptr ? m_timeline->Wait(execValue, timeoutNs)
+                                                    : vkWaitForFences(m_vkDevice, 1, &execFence, VK_TRUE, timeoutNs) == VK_SUCCESS;
+#else
+            const bool done = vkWaitForFences(m_vkDevice, 1, &execFence, VK_TRUE, timeoutNs) == VK_SUCCESS;
+#endif
+            if (done) {
                 // Buffer can be executed multiple times...
                 SetState(CmdBufferState::Executable);
                 return true;
@@ -323,7 +709,9 @@ struct CmdBuffer {
         if (state != CmdBufferState::Initialized) {
             CHECK_CBSTATE(CmdBufferState::Executable);
 
-            CHECK_VKCMD(vkResetFences(m_vkDevice, 1, &execFence));
+            if (execFence != VK_NULL_HANDLE) {
+                CHECK_VKCMD(vkResetFences(m_vkDevice, 1, &execFence));
+            }
             CHECK_VKCMD(vkResetCommandBuffer(buf, 0));
 
             SetState(CmdBufferState::Initialized);
@@ -334,6 +722,7 @@ struct CmdBuffer {
 
    private:
     VkDevice m_vkDevice{VK_NULL_HANDLE};
+    QueueTimeline* m_timeline{nullptr};
 
     void SetState(CmdBufferState newState) { state = newState; }
 
@@ -341,6 +730,186 @@ struct CmdBuffer {
 #undef LIST_CMDBUFFER_STATES
 };
 
+// SecondaryCmdPool - a command pool of secondary command buffers, used by one thread, reset as a whole once the frame
+// that executed its buffers is done.  Buffers are allocated as they are first needed and reused by later frames.
+struct SecondaryCmdPool {
+    VkCommandPool pool{VK_NULL_HANDLE};
+
+    SecondaryCmdPool() = default;
+
+    SecondaryCmdPool(const SecondaryCmdPool&) = delete;
+    SecondaryCmdPool& operator=(const SecondaryCmdPool&) = delete;
+    SecondaryCmdPool(SecondaryCmdPool&&) = delete;
+    SecondaryCmdPool& operator=(SecondaryCmdPool&&) = delete;
+
+    ~SecondaryCmdPool() {
+        if (m_vkDevice != nullptr) {
+            if (!m_bufs.empty()) {
+                vkFreeCommandBuffers(m_vkDevice, pool, (uint32_t)m_bufs.size(), m_bufs.data());
+            }
+            if (pool != VK_NULL_HANDLE) {
+                vkDestroyCommandPool(m_vkDevice, pool, nullptr);
+            }
+        }
+        m_bufs.clear();
+        pool = VK_NULL_HANDLE;
+        m_vkDevice = nullptr;
+    }
+
+    void Init(const VulkanDebugObjectNamer& namer, VkDevice device, uint32_t queueFamilyIndex) {
+        m_vkDevice = device;
+        m_namer = &namer;
+        VkCommandPoolCreateInfo cmdPoolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+        cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        cmdPoolInfo.queueFamilyIndex = queueFamilyIndex;
+        CHECK_VKCMD(vkCreateCommandPool(m_vkDevice, &cmdPoolInfo, nullptr, &pool));
+        CHECK_VKCMD(namer.SetName(VK_OBJECT_TYPE_COMMAND_POOL, (uint64_t)pool, "hello_xr secondary command pool"));
+    }
+
+    // The next unused buffer of the frame, ready to begin.
+    VkCommandBuffer Next() {
+        if (m_used == m_bufs.size()) {
+            VkCommandBufferAllocateInfo cmd{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+            cmd.commandPool = pool;
+            cmd.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            cmd.commandBufferCount = 1;
+            VkCommandBuffer buf;
+            CHECK_VKCMD(vkAllocateCommandBuffers(m_vkDevice, &cmd, &buf));
+            CHECK_VKCMD(m_namer->SetName(VK_OBJECT_TYPE_COMMAND_BUFFER, (uint64_t)buf, "hello_xr secondary command buffer"));
+            m_bufs.push_back(buf);
+        }
+        return m_bufs[m_used++];
+    }
+
+    // Reset every buffer, once the GPU is done with the frame that executed them.
+    void Reset() {
+        if (m_used > 0) {
+            CHECK_VKCMD(vkResetCommandPool(m_vkDevice, pool, 0));
+            m_used = 0;
+        }
+    }
+
+   private:
+    VkDevice m_vkDevice{VK_NULL_HANDLE};
+    const VulkanDebugObjectNamer* m_namer{nullptr};
+    std::vector<VkCommandBuffer> m_bufs;
+    size_t m_used{0};
+};
+
+// RecordWorkers - threads that each run one share of a task alongside the thread that runs it, which runs share 0 itself,
+// such as recording a share of a view's draws into a secondary command buffer.  A share always runs on the same thread,
+// so a command pool per share needs no locking.  Run returns once every share is done, rethrowing the first exception.
+struct RecordWorkers {
+    RecordWorkers() = default;
+
+    RecordWorkers(const RecordWorkers&) = delete;
+    RecordWorkers& operator=(const RecordWorkers&) = delete;
+    RecordWorkers(RecordWorkers&&) = delete;
+    RecordWorkers& operator=(RecordWorkers&&) = delete;
+
+    ~RecordWorkers() { Stop(); }
+
+    void Start(uint32_t threadCount) {
+        CHECK(m_threads.empty());
+        m_stop = false;
+        for (uint32_t i = 0; i < threadCount; ++i) {
+            m_threads.emplace_back(&RecordWorkers::Work, this, i + 1);
+        }
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+        m_threads.clear();
+    }
+
+    // The most shares a task can be split into: one for each thread, and one for the calling thread.
+    uint32_t ShareCount() const { return (uint32_t)m_threads.size() + 1; }
+
+    // Run task(share) for shares 0 to shareCount - 1, share 0 on the calling thread.
+    template <typename Task>
+    void Run(uint32_t shareCount, const Task& task) {
+        CHECK(shareCount >= 1 && shareCount <= ShareCount());
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = [](const void* context, uint32_t share) { (*static_cast<const Task*>(context))(share); };
+            m_taskContext = &task;
+            m_shareCount = shareCount;
+            m_pending = shareCount - 1;
+            m_exception = nullptr;
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        std::exception_ptr exception;
+        try {
+            task(0);
+        } catch (...) {
+            exception = std::current_exception();
+        }
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [&] { return m_pending == 0; });
+            if (exception == nullptr) {
+                exception = m_exception;
+            }
+        }
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+   private:
+    void Work(uint32_t share) {
+        uint64_t generation = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [&] { return m_stop || m_generation != generation; });
+            if (m_stop) {
+                return;
+            }
+            generation = m_generation;
+            if (share >= m_shareCount) {
+                continue;
+            }
+            void (*const task)(const void*, uint32_t) = m_task;
+            const void* const taskContext = m_taskContext;
+            lock.unlock();
+            std::exception_ptr exception;
+            try {
+                task(taskContext, share);
+            } catch (...) {
+                exception = std::current_exception();
+            }
+            lock.lock();
+            if (exception != nullptr && m_exception == nullptr) {
+                m_exception = exception;
+            }
+            if (--m_pending == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    bool m_stop{false};
+    uint64_t m_generation{0};
+    void (*m_task)(const void*, uint32_t){nullptr};
+    const void* m_taskContext{nullptr};
+    uint32_t m_shareCount{0};
+    uint32_t m_pending{0};
+    std::exception_ptr m_exception;
+};
+
 // ShaderProgram to hold a pair of vertex & fragment shaders
 struct ShaderProgram {
     std::array<VkPipelineShaderStageCreateInfo, 2> shaderInfo{
@@ -408,9 +977,9 @@ struct ShaderProgram {
 // VertexBuffer base class
 struct VertexBufferBase {
     VkBuffer idxBuf{VK_NULL_HANDLE};
-    VkDeviceMemory idxMem{VK_NULL_HANDLE};
+    MemoryAllocation idxMem{};
     VkBuffer vtxBuf{VK_NULL_HANDLE};
-    VkDeviceMemory vtxMem{VK_NULL_HANDLE};
+    MemoryAllocation vtxMem{};
     VkVertexInputBindingDescription bindDesc{};
     std::vector<VkVertexInputAttributeDescription> attrDesc{};
     struct {
@@ -425,20 +994,14 @@ struct VertexBufferBase {
             if (idxBuf != VK_NULL_HANDLE) {
                 vkDestroyBuffer(m_vkDevice, idxBuf, nullptr);
             }
-            if (idxMem != VK_NULL_HANDLE) {
-                vkFreeMemory(m_vkDevice, idxMem, nullptr);
-            }
+            m_memAllocator->Free(&idxMem);
             if (vtxBuf != VK_NULL_HANDLE) {
                 vkDestroyBuffer(m_vkDevice, vtxBuf, nullptr);
             }
-            if (vtxMem != VK_NULL_HANDLE) {
-                vkFreeMemory(m_vkDevice, vtxMem, nullptr);
-            }
+            m_memAllocator->Free(&vtxMem);
         }
         idxBuf = VK_NULL_HANDLE;
-        idxMem = VK_NULL_HANDLE;
         vtxBuf = VK_NULL_HANDLE;
-        vtxMem = VK_NULL_HANDLE;
         bindDesc = {};
         attrDesc.clear();
         count = {0, 0};
@@ -449,7 +1012,7 @@ struct VertexBufferBase {
     VertexBufferBase& operator=(const VertexBufferBase&) = delete;
     VertexBufferBase(VertexBufferBase&&) = delete;
     VertexBufferBase& operator=(VertexBufferBase&&) = delete;
-    void Init(VkDevice device, const MemoryAllocator* memAllocator, const std::vector<VkVertexInputAttributeDescription>& attr) {
+    void Init(VkDevice device, MemoryAllocator* memAllocator, const std::vector<VkVertexInputAttributeDescription>& attr) {
         m_vkDevice = device;
         m_memAllocator = memAllocator;
         attrDesc = attr;
@@ -457,32 +1020,29 @@ struct VertexBufferBase {
 
    protected:
     VkDevice m_vkDevice{VK_NULL_HANDLE};
-    void AllocateBufferMemory(VkBuffer buf, VkDeviceMemory* mem) const {
+    MemoryAllocator* m_memAllocator{nullptr};
+    void AllocateBufferMemory(VkBuffer buf, MemoryAllocation* mem, VkFlags flags, MemoryAllocator::Pool pool) const {
         VkMemoryRequirements memReq = {};
         vkGetBufferMemoryRequirements(m_vkDevice, buf, &memReq);
-        m_memAllocator->Allocate(memReq, mem);
+        *mem = m_memAllocator->Allocate(memReq, flags, pool);
+        CHECK_VKCMD(vkBindBufferMemory(m_vkDevice, buf, mem->memory, mem->offset));
     }
-
-   private:
-    const MemoryAllocator* m_memAllocator{nullptr};
 };
 
-// VertexBuffer template to wrap the indices and vertices
+// VertexBuffer template to wrap the indices and vertices, which are static, so live in device local memory
 template <typename T>
 struct VertexBuffer : public VertexBufferBase {
     bool Create(uint32_t idxCount, uint32_t vtxCount) {
         VkBufferCreateInfo bufInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-        bufInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+        bufInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         bufInfo.size = sizeof(uint16_t) * idxCount;
         CHECK_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &idxBuf));
-        AllocateBufferMemory(idxBuf, &idxMem);
-        CHECK_VKCMD(vkBindBufferMemory(m_vkDevice, idxBuf, idxMem, 0));
+        AllocateBufferMemory(idxBuf, &idxMem, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryAllocator::Pool::Linear);
 
-        bufInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        bufInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         bufInfo.size = sizeof(T) * vtxCount;
         CHECK_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &vtxBuf));
-        AllocateBufferMemory(vtxBuf, &vtxMem);
-        CHECK_VKCMD(vkBindBufferMemory(m_vkDevice, vtxBuf, vtxMem, 0));
+        AllocateBufferMemory(vtxBuf, &vtxMem, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryAllocator::Pool::Linear);
 
         bindDesc.binding = 0;
         bindDesc.stride = sizeof(T);
@@ -493,37 +1053,227 @@ struct VertexBuffer : public VertexBufferBase {
         return true;
     }
 
-    void UpdateIndices(const uint16_t* data, uint32_t elements, uint32_t offset = 0) {
-        uint16_t* map = nullptr;
-        CHECK_VKCMD(vkMapMemory(m_vkDevice, idxMem, sizeof(map[0]) * offset, sizeof(map[0]) * elements, 0, (void**)&map));
-        for (size_t i = 0; i < elements; ++i) {
-            map[i] = data[i];
+    // Copy all the indices and vertices through a host visible staging buffer, and wait for the copy to complete.
+    void Upload(CmdBuffer* cmdBuffer, VkQueue queue, const uint16_t* indices, const T* vertices) {
+        const VkDeviceSize idxSize = sizeof(uint16_t) * count.idx;
+        const VkDeviceSize vtxSize = sizeof(T) * count.vtx;
+
+        VkBufferCreateInfo bufInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+        bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufInfo.size = idxSize + vtxSize;
+        VkBuffer stagingBuf{VK_NULL_HANDLE};
+        CHECK_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &stagingBuf));
+        MemoryAllocation stagingMem{};
+        AllocateBufferMemory(stagingBuf, &stagingMem, MemoryAllocator::defaultFlags, MemoryAllocator::Pool::FreeList);
+        memcpy(stagingMem.mapped, indices, (size_t)idxSize);
+        memcpy(stagingMem.mapped + idxSize, vertices, (size_t)vtxSize);
+
+        cmdBuffer->Reset();
+        cmdBuffer->Begin();
+        VkBufferCopy region{0, 0, idxSize};
+        vkCmdCopyBuffer(cmdBuffer->buf, stagingBuf, idxBuf, 1, &region);
+        region = {idxSize, 0, vtxSize};
+        vkCmdCopyBuffer(cmdBuffer->buf, stagingBuf, vtxBuf, 1, &region);
+
+        VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        vkCmdPipelineBarrier(cmdBuffer->buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0,
+                             nullptr, 0, nullptr);
+        cmdBuffer->End();
+        cmdBuffer->Exec(queue);
+        cmdBuffer->Wait();
+
+        vkDestroyBuffer(m_vkDevice, stagingBuf, nullptr);
+        m_memAllocator->Free(&stagingMem);
+    }
+};
+
+// Per-instance vertex buffer of the cubes' model transforms, host visible and grown with the cube count.  Binding 1
+// feeds each transform to the Model vertex attribute, one column per location from 2 to 5.
+struct InstanceBuffer {
+    static constexpr uint32_t binding = 1;
+
+    VkBuffer buf{VK_NULL_HANDLE};
+    MemoryAllocation mem{};
+    uint32_t capacity{0};
+
+    InstanceBuffer() = default;
+
+    ~InstanceBuffer() {
+        Destroy();
+        m_vkDevice = nullptr;
+    }
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+    InstanceBuffer(InstanceBuffer&&) = delete;
+    InstanceBuffer& operator=(InstanceBuffer&&) = delete;
+
+    void Init(VkDevice device, MemoryAllocator* memAllocator) {
+        m_vkDevice = device;
+        m_memAllocator = memAllocator;
+    }
+
+    // Each instance has this many transforms after one another, the columns of transform t in locations 2 + 4 * t onwards.
+    static VkVertexInputBindingDescription BindingDescription(uint32_t transforms = 1) {
+        return {binding, transforms * (uint32_t)sizeof(XrMatrix4x4f), VK_VERTEX_INPUT_RATE_INSTANCE};
+    }
+
+    static std::vector<VkVertexInputAttributeDescription> AttributeDescriptions(uint32_t transforms = 1) {
+        std::vector<VkVertexInputAttributeDescription> attr;
+        for (uint32_t i = 0; i < 4 * transforms; ++i) {
+            attr.push_back({2 + i, binding, VK_FORMAT_R32G32B32A32_SFLOAT, i * 4 * (uint32_t)sizeof(float)});
         }
-        vkUnmapMemory(m_vkDevice, idxMem);
+        return attr;
+    }
+
+    // Replace the transforms, growing the buffer first when they do not fit.  The GPU must be done with the previous ones.
+    void Update(const XrMatrix4x4f* models, uint32_t count) {
+        Reserve(count);
+        Write(models, 0, count);
+    }
+
+    // Grow the buffer, dropping its transforms, when count of them do not fit.  The GPU must be done with the previous ones.
+    void Reserve(uint32_t count) {
+        if (count > capacity) {
+            Destroy();
+            capacity = std::max(count, std::max(2 * capacity, 64u));
+
+            // Written by the host, or by the cull compute shader with Options::IndirectDraw.
+            VkBufferCreateInfo bufInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+            bufInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            bufInfo.size = sizeof(XrMatrix4x4f) * capacity;
+            CHECK_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &buf));
+            VkMemoryRequirements memReq = {};
+            vkGetBufferMemoryRequirements(m_vkDevice, buf, &memReq);
+            mem = m_memAllocator->Allocate(memReq);
+            CHECK_VKCMD(vkBindBufferMemory(m_vkDevice, buf, mem.memory, mem.offset));
+        }
+    }
+
+    // Replace the transforms first to first + count - 1, which Reserve made room for.  Threads may write separate ranges.
+    void Write(const XrMatrix4x4f* models, uint32_t first, uint32_t count) {
+        CHECK(first + count <= capacity || count == 0);
+        // Host coherent and always mapped, so it needs no flush.
+        memcpy(reinterpret_cast<XrMatrix4x4f*>(mem.mapped) + first, models, sizeof(XrMatrix4x4f) * count);
     }
 
-    void UpdateVertices(const T* data, uint32_t elements, uint32_t offset = 0) {
-        T* map = nullptr;
-        CHECK_VKCMD(vkMapMemory(m_vkDevice, vtxMem, sizeof(map[0]) * offset, sizeof(map[0]) * elements, 0, (void**)&map));
-        for (size_t i = 0; i < elements; ++i) {
-            map[i] = data[i];
+    // Replace the transforms written by Update with the same ones corrected, before the commands reading them are submitted.
+    // Only written, as the memory may be uncached for the host.
+    void Correct(const XrMatrix4x4f& correction, const XrMatrix4x4f* models, uint32_t count) {
+        CHECK(count <= capacity);
+        XrMatrix4x4f_MultiplyArray(reinterpret_cast<XrMatrix4x4f*>(mem.mapped), &correction, models, count);
+    }
+
+   private:
+    void Destroy() {
+        if (m_vkDevice != nullptr) {
+            if (buf != VK_NULL_HANDLE) {
+                vkDestroyBuffer(m_vkDevice, buf, nullptr);
+            }
+            m_memAllocator->Free(&mem);
+        }
+        buf = VK_NULL_HANDLE;
+        capacity = 0;
+    }
+
+    VkDevice m_vkDevice{VK_NULL_HANDLE};
+    MemoryAllocator* m_memAllocator{nullptr};
+};
+
+// A host coherent buffer that stays mapped, for what the host rewrites every frame for the GPU to read or update, like the
+// cubes the cull compute shader reads.
+struct MappedBuffer {
+    VkBuffer buf{VK_NULL_HANDLE};
+    MemoryAllocation mem{};
+    VkDeviceSize size{0};
+
+    MappedBuffer() = default;
+
+    ~MappedBuffer() {
+        Destroy();
+        m_vkDevice = nullptr;
+    }
+
+    MappedBuffer(const MappedBuffer&) = delete;
+    MappedBuffer& operator=(const MappedBuffer&) = delete;
+    MappedBuffer(MappedBuffer&&) = delete;
+    MappedBuffer& operator=(MappedBuffer&&) = delete;
+
+    void Init(VkDevice device, MemoryAllocator* memAllocator, VkBufferUsageFlags usage) {
+        m_vkDevice = device;
+        m_memAllocator = memAllocator;
+        m_usage = usage;
+    }
+
+    // The mapped buffer, grown first, dropping its contents, when bytes do not fit.  The GPU must be done with it.
+    void* Reserve(VkDeviceSize bytes) {
+        if (bytes > size) {
+            const VkDeviceSize newSize = std::max(bytes, 2 * size);
+            Destroy();
+            size = newSize;
+
+            VkBufferCreateInfo bufInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+            bufInfo.usage = m_usage;
+            bufInfo.size = size;
+            CHECK_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &buf));
+            VkMemoryRequirements memReq = {};
+            vkGetBufferMemoryRequirements(m_vkDevice, buf, &memReq);
+            mem = m_memAllocator->Allocate(memReq);
+            CHECK_VKCMD(vkBindBufferMemory(m_vkDevice, buf, mem.memory, mem.offset));
+        }
+        return mem.mapped;
+    }
+
+   private:
+    void Destroy() {
+        if (m_vkDevice != nullptr) {
+            if (buf != VK_NULL_HANDLE) {
+                vkDestroyBuffer(m_vkDevice, buf, nullptr);
+            }
+            m_memAllocator->Free(&mem);
         }
-        vkUnmapMemory(m_vkDevice, vtxMem);
+        buf = VK_NULL_HANDLE;
+        size = 0;
     }
+
+    VkDevice m_vkDevice{VK_NULL_HANDLE};
+    MemoryAllocator* m_memAllocator{nullptr};
+    VkBufferUsageFlags m_usage{0};
+};
+
+struct RenderTarget;
+
+// The commands of VK_KHR_dynamic_rendering, when the device enables it.
+struct DynamicRendering {
+#if defined(VK_KHR_dynamic_rendering)
+    PFN_vkCmdBeginRenderingKHR vkCmdBeginRenderingKHR{nullptr};
+    PFN_vkCmdEndRenderingKHR vkCmdEndRenderingKHR{nullptr};
+#endif
 };
 
 // RenderPass wrapper
 struct RenderPass {
     VkFormat colorFmt{};
     VkFormat depthFmt{};
-    VkRenderPass pass{VK_NULL_HANDLE};
+    uint32_t viewCount{1};
+    VkRenderPass pass{VK_NULL_HANDLE};  // Null with dynamic rendering, whose pipelines only know the attachment formats
 
     RenderPass() = default;
 
-    bool Create(const VulkanDebugObjectNamer& namer, VkDevice device, VkFormat aColorFmt, VkFormat aDepthFmt) {
+    // With a viewCount above 1, the subpass renders every view to its own layer of the attachments (VK_KHR_multiview).
+    // With dynamicRendering, no VkRenderPass is created, and Begin renders without a framebuffer.
+    bool Create(const VulkanDebugObjectNamer& namer, VkDevice device, VkFormat aColorFmt, VkFormat aDepthFmt,
+                uint32_t aViewCount = 1, const DynamicRendering* aDynamicRendering = nullptr) {
         m_vkDevice = device;
         colorFmt = aColorFmt;
         depthFmt = aDepthFmt;
+        viewCount = aViewCount;
+        m_dynamicRendering = aDynamicRendering;
+        if (m_dynamicRendering != nullptr) {
+            return true;
+        }
 
         VkSubpassDescription subpass = {};
         subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
@@ -570,12 +1320,59 @@ struct RenderPass {
             subpass.pDepthStencilAttachment = &depthRef;
         }
 
+        // Several frames may be in flight at once, all rendering to the one depth attachment: clear it only after earlier
+        // submissions are done with it.
+        VkSubpassDependency depthDependency{};
+        depthDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        depthDependency.dstSubpass = 0;
+        depthDependency.srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        depthDependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        depthDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        depthDependency.dstAccessMask =
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        if (depthFmt != VK_FORMAT_UNDEFINED) {
+            rpInfo.dependencyCount = 1;
+            rpInfo.pDependencies = &depthDependency;
+        }
+
+        // The views are rendered from nearly the same position, so also let the implementation render them concurrently.
+        const uint32_t viewMask = (1u << viewCount) - 1;
+        VkRenderPassMultiviewCreateInfoKHR multiviewInfo{VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO_KHR};
+        multiviewInfo.subpassCount = 1;
+        multiviewInfo.pViewMasks = &viewMask;
+        multiviewInfo.correlationMaskCount = 1;
+        multiviewInfo.pCorrelationMasks = &viewMask;
+        if (viewCount > 1) {
+            rpInfo.pNext = &multiviewInfo;
+        }
+
         CHECK_VKCMD(vkCreateRenderPass(m_vkDevice, &rpInfo, nullptr, &pass));
         CHECK_VKCMD(namer.SetName(VK_OBJECT_TYPE_RENDER_PASS, (uint64_t)pass, "hello_xr render pass"));
 
         return true;
     }
 
+    // The view mask of the subpass, or 0 without multiview.
+    uint32_t ViewMask() const { return viewCount > 1 ? (1u << viewCount) - 1 : 0; }
+
+    // Begin rendering to a render target of this render pass, clearing its color and depth.  With secondaryContents, the
+    // render pass is recorded into secondary command buffers begun with BeginSecondary, and executed from buf.
+    void Begin(VkCommandBuffer buf, const RenderTarget& target, VkExtent2D size, const std::array<VkClearValue, 2>& clearValues,
+               bool secondaryContents = false) const;
+
+    // Begin a secondary command buffer that continues rendering to a render target of this render pass.
+    void BeginSecondary(VkCommandBuffer buf, const RenderTarget& target) const;
+
+    void End(VkCommandBuffer buf) const {
+#if defined(VK_KHR_dynamic_rendering)
+        if (m_dynamicRendering != nullptr) {
+            m_dynamicRendering->vkCmdEndRenderingKHR(buf);
+            return;
+        }
+#endif
+        vkCmdEndRenderPass(buf);
+    }
+
     ~RenderPass() {
         if (m_vkDevice != nullptr) {
             if (pass != VK_NULL_HANDLE) {
@@ -593,6 +1390,7 @@ struct RenderPass {
 
    private:
     VkDevice m_vkDevice{VK_NULL_HANDLE};
+    const DynamicRendering* m_dynamicRendering{nullptr};
 };
 
 // VkImage + framebuffer wrapper
@@ -651,9 +1449,12 @@ struct RenderTarget {
         swap(m_vkDevice, other.m_vkDevice);
         return *this;
     }
+    // With a layerCount above 1, the views are array views of every layer, for a multiview render pass.  Otherwise they
+    // view layer baseLayer alone.
     void Create(const VulkanDebugObjectNamer& namer, VkDevice device, VkImage aColorImage, VkImage aDepthImage, VkExtent2D size,
-                RenderPass& renderPass) {
+                const RenderPass& renderPass, uint32_t layerCount = 1, uint32_t baseLayer = 0) {
         m_vkDevice = device;
+        const VkImageViewType viewType = layerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
 
         colorImage = aColorImage;
         depthImage = aDepthImage;
@@ -665,7 +1466,7 @@ struct RenderTarget {
         if (colorImage != VK_NULL_HANDLE) {
             VkImageViewCreateInfo colorViewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
             colorViewInfo.image = colorImage;
-            colorViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            colorViewInfo.viewType = viewType;
             colorViewInfo.format = renderPass.colorFmt;
             colorViewInfo.components.r = VK_COMPONENT_SWIZZLE_R;
             colorViewInfo.components.g = VK_COMPONENT_SWIZZLE_G;
@@ -674,8 +1475,8 @@ struct RenderTarget {
             colorViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             colorViewInfo.subresourceRange.baseMipLevel = 0;
             colorViewInfo.subresourceRange.levelCount = 1;
-            colorViewInfo.subresourceRange.baseArrayLayer = 0;
-            colorViewInfo.subresourceRange.layerCount = 1;
+            colorViewInfo.subresourceRange.baseArrayLayer = baseLayer;
+            colorViewInfo.subresourceRange.layerCount = layerCount;
             CHECK_VKCMD(vkCreateImageView(m_vkDevice, &colorViewInfo, nullptr, &colorView));
             CHECK_VKCMD(namer.SetName(VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t)colorView, "hello_xr color image view"));
             attachments[attachmentCount++] = colorView;
@@ -685,7 +1486,7 @@ struct RenderTarget {
         if (depthImage != VK_NULL_HANDLE) {
             VkImageViewCreateInfo depthViewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
             depthViewInfo.image = depthImage;
-            depthViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            depthViewInfo.viewType = viewType;
             depthViewInfo.format = renderPass.depthFmt;
             depthViewInfo.components.r = VK_COMPONENT_SWIZZLE_R;
             depthViewInfo.components.g = VK_COMPONENT_SWIZZLE_G;
@@ -694,13 +1495,18 @@ struct RenderTarget {
             depthViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
             depthViewInfo.subresourceRange.baseMipLevel = 0;
             depthViewInfo.subresourceRange.levelCount = 1;
-            depthViewInfo.subresourceRange.baseArrayLayer = 0;
-            depthViewInfo.subresourceRange.layerCount = 1;
+            depthViewInfo.subresourceRange.baseArrayLayer = baseLayer;
+            depthViewInfo.subresourceRange.layerCount = layerCount;
             CHECK_VKCMD(vkCreateImageView(m_vkDevice, &depthViewInfo, nullptr, &depthView));
             CHECK_VKCMD(namer.SetName(VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t)depthView, "hello_xr depth image view"));
             attachments[attachmentCount++] = depthView;
         }
 
+        // Dynamic rendering renders to the views themselves.
+        if (renderPass.pass == VK_NULL_HANDLE) {
+            return;
+        }
+
         VkFramebufferCreateInfo fbInfo{VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
         fbInfo.renderPass = renderPass.pass;
         fbInfo.attachmentCount = attachmentCount;
@@ -719,7 +1525,82 @@ struct RenderTarget {
     VkDevice m_vkDevice{VK_NULL_HANDLE};
 };
 
-// Simple vertex MVP xform & color fragment shader layout
+void RenderPass::Begin(VkCommandBuffer buf, const RenderTarget& target, VkExtent2D size,
+                       const std::array<VkClearValue, 2>& clearValues, bool secondaryContents) const {
+#if defined(VK_KHR_dynamic_rendering)
+    if (m_dynamicRendering != nullptr) {
+        // What the external subpass dependency of a VkRenderPass does: clear the depth only after earlier frames are done
+        // with it.
+        VkMemoryBarrier depthBarrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+        depthBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        const VkPipelineStageFlags fragmentTests =
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        vkCmdPipelineBarrier(buf, fragmentTests, fragmentTests, 0, 1, &depthBarrier, 0, nullptr, 0, nullptr);
+
+        VkRenderingAttachmentInfoKHR colorAttachment{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR};
+        colorAttachment.imageView = target.colorView;
+        colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.clearValue = clearValues[0];
+        VkRenderingAttachmentInfoKHR depthAttachment{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR};
+        depthAttachment.imageView = target.depthView;
+        depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        depthAttachment.clearValue = clearValues[1];
+
+        VkRenderingInfoKHR renderingInfo{VK_STRUCTURE_TYPE_RENDERING_INFO_KHR};
+        renderingInfo.flags = secondaryContents ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
+        renderingInfo.renderArea = {{0, 0}, size};
+        renderingInfo.layerCount = 1;
+        renderingInfo.viewMask = ViewMask();
+        renderingInfo.colorAttachmentCount = colorFmt != VK_FORMAT_UNDEFINED ? 1 : 0;
+        renderingInfo.pColorAttachments = &colorAttachment;
+        renderingInfo.pDepthAttachment = depthFmt != VK_FORMAT_UNDEFINED ? &depthAttachment : nullptr;
+        m_dynamicRendering->vkCmdBeginRenderingKHR(buf, &renderingInfo);
+        return;
+    }
+#endif
+    VkRenderPassBeginInfo renderPassBeginInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+    renderPassBeginInfo.renderPass = pass;
+    renderPassBeginInfo.framebuffer = target.fb;
+    renderPassBeginInfo.renderArea = {{0, 0}, size};
+    renderPassBeginInfo.clearValueCount = (uint32_t)clearValues.size();
+    renderPassBeginInfo.pClearValues = clearValues.data();
+    vkCmdBeginRenderPass(buf, &renderPassBeginInfo,
+                         secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void RenderPass::BeginSecondary(VkCommandBuffer buf, const RenderTarget& target) const {
+    VkCommandBufferInheritanceInfo inheritanceInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+    inheritanceInfo.renderPass = pass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = target.fb;
+#if defined(VK_KHR_dynamic_rendering)
+    // Without a VkRenderPass, the buffer is told the formats and views it renders to instead.
+    VkCommandBufferInheritanceRenderingInfoKHR renderingInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR};
+    renderingInfo.viewMask = ViewMask();
+    renderingInfo.colorAttachmentCount = colorFmt != VK_FORMAT_UNDEFINED ? 1 : 0;
+    renderingInfo.pColorAttachmentFormats = &colorFmt;
+    renderingInfo.depthAttachmentFormat = depthFmt;
+    renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    if (m_dynamicRendering != nullptr) {
+        inheritanceInfo.pNext = &renderingInfo;
+    }
+#endif
+
+    VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    CHECK_VKCMD(vkBeginCommandBuffer(buf, &beginInfo));
+}
+
+// The most views a multiview render pass renders, one view-projection matrix push constant each.
+constexpr uint32_t MaxMultiviewCount = 2;
+
+// Simple vertex view-projection xform & color fragment shader layout
 struct PipelineLayout {
     VkPipelineLayout layout{VK_NULL_HANDLE};
 
@@ -738,11 +1619,12 @@ struct PipelineLayout {
     void Create(VkDevice device) {
         m_vkDevice = device;
 
-        // MVP matrix is a push_constant
+        // View-projection matrix is a push_constant, or one per view for multiview.  Two fill the 128 bytes every device
+        // supports.  The model transforms are per-instance vertex attributes.
         VkPushConstantRange pcr = {};
         pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
         pcr.offset = 0;
-        pcr.size = 4 * 4 * sizeof(float);
+        pcr.size = MaxMultiviewCount * 4 * 4 * sizeof(float);
 
         VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
         pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
@@ -769,19 +1651,30 @@ struct Pipeline {
 
     void Dynamic(VkDynamicState state) { dynamicStateEnables.emplace_back(state); }
 
-    void Create(VkDevice device, VkExtent2D size, const PipelineLayout& layout, const RenderPass& rp, const ShaderProgram& sp,
-                const VertexBufferBase& vb) {
+    // The viewport and scissor are dynamic, so that one pipeline renders to swapchains of any size.  The shaders read
+    // instanceTransforms model transforms of each instance.
+    void Create(VkDevice device, VkPipelineCache cache, const PipelineLayout& layout, const RenderPass& rp, const ShaderProgram& sp,
+                const VertexBufferBase& vb, uint32_t instanceTransforms = 1) {
         m_vkDevice = device;
+        Dynamic(VK_DYNAMIC_STATE_VIEWPORT);
+        Dynamic(VK_DYNAMIC_STATE_SCISSOR);
 
         VkPipelineDynamicStateCreateInfo dynamicState{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
         dynamicState.dynamicStateCount = (uint32_t)dynamicStateEnables.size();
         dynamicState.pDynamicStates = dynamicStateEnables.data();
 
+        // The vertices in binding 0 and the per-instance model transforms in binding 1
+        const std::array<VkVertexInputBindingDescription, 2> bindDesc{vb.bindDesc,
+                                                                      InstanceBuffer::BindingDescription(instanceTransforms)};
+        std::vector<VkVertexInputAttributeDescription> attrDesc = vb.attrDesc;
+        for (const VkVertexInputAttributeDescription& attr : InstanceBuffer::AttributeDescriptions(instanceTransforms)) {
+            attrDesc.push_back(attr);
+        }
         VkPipelineVertexInputStateCreateInfo vi{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-        vi.vertexBindingDescriptionCount = 1;
-        vi.pVertexBindingDescriptions = &vb.bindDesc;
-        vi.vertexAttributeDescriptionCount = (uint32_t)vb.attrDesc.size();
-        vi.pVertexAttributeDescriptions = vb.attrDesc.data();
+        vi.vertexBindingDescriptionCount = (uint32_t)bindDesc.size();
+        vi.pVertexBindingDescriptions = bindDesc.data();
+        vi.vertexAttributeDescriptionCount = (uint32_t)attrDesc.size();
+        vi.pVertexAttributeDescriptions = attrDesc.data();
 
         VkPipelineInputAssemblyStateCreateInfo ia{VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
         ia.primitiveRestartEnable = VK_FALSE;
@@ -820,19 +1713,9 @@ struct Pipeline {
         cb.blendConstants[2] = 1.0f;
         cb.blendConstants[3] = 1.0f;
 
-        VkRect2D scissor = {{0, 0}, size};
-#if defined(ORIGIN_BOTTOM_LEFT)
-        // Flipped view so origin is bottom-left like GL (requires VK_KHR_maintenance1)
-        VkViewport viewport = {0.0f, (float)size.height, (float)size.width, -(float)size.height, 0.0f, 1.0f};
-#else
-        // Will invert y after projection
-        VkViewport viewport = {0.0f, 0.0f, (float)size.width, (float)size.height, 0.0f, 1.0f};
-#endif
         VkPipelineViewportStateCreateInfo vp{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
         vp.viewportCount = 1;
-        vp.pViewports = &viewport;
         vp.scissorCount = 1;
-        vp.pScissors = &scissor;
 
         VkPipelineDepthStencilStateCreateInfo ds{VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
         ds.depthTestEnable = VK_TRUE;
@@ -865,30 +1748,244 @@ struct Pipeline {
         if (dynamicState.dynamicStateCount > 0) {
             pipeInfo.pDynamicState = &dynamicState;
         }
-        pipeInfo.layout = layout.layout;
-        pipeInfo.renderPass = rp.pass;
-        pipeInfo.subpass = 0;
-        CHECK_VKCMD(vkCreateGraphicsPipelines(m_vkDevice, VK_NULL_HANDLE, 1, &pipeInfo, nullptr, &pipe));
+        pipeInfo.layout = layout.layout;
+        pipeInfo.renderPass = rp.pass;
+        pipeInfo.subpass = 0;
+#if defined(VK_KHR_dynamic_rendering)
+        // Without a render pass, the pipeline renders to any attachments of these formats.
+        VkPipelineRenderingCreateInfoKHR renderingInfo{VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR};
+        renderingInfo.viewMask = rp.ViewMask();
+        renderingInfo.colorAttachmentCount = rp.colorFmt != VK_FORMAT_UNDEFINED ? 1 : 0;
+        renderingInfo.pColorAttachmentFormats = &rp.colorFmt;
+        renderingInfo.depthAttachmentFormat = rp.depthFmt;
+        if (rp.pass == VK_NULL_HANDLE) {
+            pipeInfo.pNext = &renderingInfo;
+        }
+#endif
+        CHECK_VKCMD(vkCreateGraphicsPipelines(m_vkDevice, cache, 1, &pipeInfo, nullptr, &pipe));
+    }
+
+    void Release() {
+        if (m_vkDevice != nullptr) {
+            if (pipe != VK_NULL_HANDLE) {
+                vkDestroyPipeline(m_vkDevice, pipe, nullptr);
+            }
+        }
+        pipe = VK_NULL_HANDLE;
+        m_vkDevice = nullptr;
+    }
+
+    ~Pipeline() { Release(); }
+
+   private:
+    VkDevice m_vkDevice{VK_NULL_HANDLE};
+};
+
+// The render pass and pipeline shared by every swapchain with the same color format and layer count.
+struct RenderPipeline {
+    RenderPass rp{};
+    Pipeline pipe{};
+};
+
+// The compute pipeline of Options::IndirectDraw, which culls the cubes of a view into its instance buffer and the arguments
+// of its indirect draw.  The cubes, instance buffer and arguments are storage buffers in bindings 0 to 2 of one descriptor
+// set; the frustum planes and cube count are push constants.
+struct CullPipeline {
+    struct Constants {
+        XrVector4f planes[4];  // Unit normals pointing inside, and distances
+        uint32_t cubeCount;
+    };
+    static constexpr uint32_t BindingCount = 3;
+    static constexpr uint32_t GroupSize = 64;  // local_size_x of the shader
+
+    VkDescriptorSetLayout setLayout{VK_NULL_HANDLE};
+    VkPipelineLayout layout{VK_NULL_HANDLE};
+    VkPipeline pipe{VK_NULL_HANDLE};
+
+    CullPipeline() = default;
+
+    ~CullPipeline() {
+        if (m_vkDevice != nullptr) {
+            if (pipe != VK_NULL_HANDLE) {
+                vkDestroyPipeline(m_vkDevice, pipe, nullptr);
+            }
+            if (layout != VK_NULL_HANDLE) {
+                vkDestroyPipelineLayout(m_vkDevice, layout, nullptr);
+            }
+            if (setLayout != VK_NULL_HANDLE) {
+                vkDestroyDescriptorSetLayout(m_vkDevice, setLayout, nullptr);
+            }
+        }
+        pipe = VK_NULL_HANDLE;
+        layout = VK_NULL_HANDLE;
+        setLayout = VK_NULL_HANDLE;
+        m_vkDevice = nullptr;
+    }
+
+    CullPipeline(const CullPipeline&) = delete;
+    CullPipeline& operator=(const CullPipeline&) = delete;
+    CullPipeline(CullPipeline&&) = delete;
+    CullPipeline& operator=(CullPipeline&&) = delete;
+
+    void Create(VkDevice device, VkPipelineCache cache, const std::vector<uint32_t>& code) {
+        m_vkDevice = device;
+
+        std::array<VkDescriptorSetLayoutBinding, BindingCount> bindings{};
+        for (uint32_t i = 0; i < BindingCount; ++i) {
+            bindings[i] = {i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+        }
+        VkDescriptorSetLayoutCreateInfo setLayoutInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+        setLayoutInfo.bindingCount = (uint32_t)bindings.size();
+        setLayoutInfo.pBindings = bindings.data();
+        CHECK_VKCMD(vkCreateDescriptorSetLayout(m_vkDevice, &setLayoutInfo, nullptr, &setLayout));
+
+        const VkPushConstantRange pcr{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Constants)};
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &setLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pcr;
+        CHECK_VKCMD(vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutInfo, nullptr, &layout));
+
+        VkShaderModuleCreateInfo modInfo{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+        modInfo.codeSize = code.size() * sizeof(code[0]);
+        modInfo.pCode = code.data();
+        VkShaderModule module{VK_NULL_HANDLE};
+        CHECK_VKCMD(vkCreateShaderModule(m_vkDevice, &modInfo, nullptr, &module));
+
+        VkComputePipelineCreateInfo pipeInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+        pipeInfo.stage = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+        pipeInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipeInfo.stage.module = module;
+        pipeInfo.stage.pName = "main";
+        pipeInfo.layout = layout;
+        const VkResult result = vkCreateComputePipelines(m_vkDevice, cache, 1, &pipeInfo, nullptr, &pipe);
+        vkDestroyShaderModule(m_vkDevice, module, nullptr);
+        CHECK_VKRESULT(result, "vkCreateComputePipelines");
+
+        Log::Write(Log::Level::Info, "Loaded cull compute shader");
     }
 
-    void Release() {
+   private:
+    VkDevice m_vkDevice{VK_NULL_HANDLE};
+};
+
+// VkPipelineCache kept across runs in a file per device and driver version, so that pipelines are only compiled from
+// SPIR-V on the first run.  Without a directory, the cache only lives as long as the device.
+struct PipelineCache {
+    VkPipelineCache cache{VK_NULL_HANDLE};
+
+    PipelineCache() = default;
+
+    ~PipelineCache() {
         if (m_vkDevice != nullptr) {
-            if (pipe != VK_NULL_HANDLE) {
-                vkDestroyPipeline(m_vkDevice, pipe, nullptr);
+            if (cache != VK_NULL_HANDLE) {
+                vkDestroyPipelineCache(m_vkDevice, cache, nullptr);
             }
         }
-        pipe = VK_NULL_HANDLE;
+        cache = VK_NULL_HANDLE;
         m_vkDevice = nullptr;
     }
 
-    ~Pipeline() { Release(); }
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+    PipelineCache(PipelineCache&&) = delete;
+    PipelineCache& operator=(PipelineCache&&) = delete;
+
+    void Create(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& directory) {
+        m_vkDevice = device;
+        vkGetPhysicalDeviceProperties(physicalDevice, &m_props);
+
+        if (!directory.empty()) {
+            std::string uuid;
+            for (uint8_t byte : m_props.pipelineCacheUUID) {
+                uuid += Fmt("%02x", byte);
+            }
+            m_path = Fmt("%s/hello_xr_pipeline_cache_%s_%08x.bin", directory.c_str(), uuid.c_str(), m_props.driverVersion);
+        }
+
+        std::vector<uint8_t> data = Load();
+        VkPipelineCacheCreateInfo cacheInfo{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.data();
+        CHECK_VKCMD(vkCreatePipelineCache(m_vkDevice, &cacheInfo, nullptr, &cache));
+        Log::Write(Log::Level::Verbose, Fmt("Pipeline cache %s: %zu bytes loaded", m_path.c_str(), data.size()));
+    }
+
+    // Write the cache to its file, through a temporary file so that a crash never leaves a truncated cache behind.
+    void Save() const {
+        if (m_path.empty()) {
+            return;
+        }
+        size_t size = 0;
+        CHECK_VKCMD(vkGetPipelineCacheData(m_vkDevice, cache, &size, nullptr));
+        std::vector<uint8_t> data(size);
+        CHECK_VKCMD(vkGetPipelineCacheData(m_vkDevice, cache, &size, data.data()));
+
+        const std::string tempPath = m_path + ".tmp";
+        FILE* file = fopen(tempPath.c_str(), "wb");
+        if (file == nullptr) {
+            Log::Write(Log::Level::Warning, Fmt("Cannot write the pipeline cache %s", tempPath.c_str()));
+            return;
+        }
+        const bool written = fwrite(data.data(), 1, size, file) == size;
+        if (fclose(file) != 0 || !written) {
+            Log::Write(Log::Level::Warning, Fmt("Cannot write the pipeline cache %s", tempPath.c_str()));
+            remove(tempPath.c_str());
+            return;
+        }
+        // rename does not replace an existing file everywhere
+        remove(m_path.c_str());
+        if (rename(tempPath.c_str(), m_path.c_str()) != 0) {
+            Log::Write(Log::Level::Warning, Fmt("Cannot write the pipeline cache %s", m_path.c_str()));
+            remove(tempPath.c_str());
+        }
+    }
 
    private:
+    // The cache file's data, or nothing if there is none or it is not for this device: the file name already holds the
+    // cache UUID and driver version, but some drivers misbehave given another device's data, so the header is checked too.
+    std::vector<uint8_t> Load() const {
+        std::vector<uint8_t> data;
+        FILE* file = m_path.empty() ? nullptr : fopen(m_path.c_str(), "rb");
+        if (file == nullptr) {
+            return data;
+        }
+        uint8_t buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            data.insert(data.end(), buffer, buffer + read);
+        }
+        fclose(file);
+
+        // VkPipelineCacheHeaderVersionOne
+        struct {
+            uint32_t headerSize;
+            uint32_t headerVersion;
+            uint32_t vendorID;
+            uint32_t deviceID;
+            uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        } header{};
+        static_assert(sizeof(header) == 16 + VK_UUID_SIZE, "Unexpected pipeline cache header size");
+        if (data.size() >= sizeof(header)) {
+            memcpy(&header, data.data(), sizeof(header));
+        }
+        if (header.headerSize < sizeof(header) || header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+            header.vendorID != m_props.vendorID || header.deviceID != m_props.deviceID ||
+            memcmp(header.pipelineCacheUUID, m_props.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+            Log::Write(Log::Level::Warning, Fmt("Ignoring the pipeline cache %s of another device", m_path.c_str()));
+            data.clear();
+        }
+        return data;
+    }
+
     VkDevice m_vkDevice{VK_NULL_HANDLE};
+    VkPhysicalDeviceProperties m_props{};
+    std::string m_path;
 };
 
 struct DepthBuffer {
-    VkDeviceMemory depthMemory{VK_NULL_HANDLE};
+    MemoryAllocation depthMemory{};
     VkImage depthImage{VK_NULL_HANDLE};
 
     DepthBuffer() = default;
@@ -898,12 +1995,9 @@ struct DepthBuffer {
             if (depthImage != VK_NULL_HANDLE) {
                 vkDestroyImage(m_vkDevice, depthImage, nullptr);
             }
-            if (depthMemory != VK_NULL_HANDLE) {
-                vkFreeMemory(m_vkDevice, depthMemory, nullptr);
-            }
+            m_memAllocator->Free(&depthMemory);
         }
         depthImage = VK_NULL_HANDLE;
-        depthMemory = VK_NULL_HANDLE;
         m_vkDevice = nullptr;
     }
 
@@ -913,6 +2007,9 @@ struct DepthBuffer {
         swap(depthImage, other.depthImage);
         swap(depthMemory, other.depthMemory);
         swap(m_vkDevice, other.m_vkDevice);
+        swap(m_memAllocator, other.m_memAllocator);
+        swap(m_vkLayout, other.m_vkLayout);
+        swap(m_layerCount, other.m_layerCount);
     }
     DepthBuffer& operator=(DepthBuffer&& other) noexcept {
         if (&other == this) {
@@ -925,23 +2022,28 @@ struct DepthBuffer {
         swap(depthImage, other.depthImage);
         swap(depthMemory, other.depthMemory);
         swap(m_vkDevice, other.m_vkDevice);
+        swap(m_memAllocator, other.m_memAllocator);
+        swap(m_vkLayout, other.m_vkLayout);
+        swap(m_layerCount, other.m_layerCount);
         return *this;
     }
 
     void Create(const VulkanDebugObjectNamer& namer, VkDevice device, MemoryAllocator* memAllocator, VkFormat depthFormat,
                 const XrSwapchainCreateInfo& swapchainCreateInfo) {
         m_vkDevice = device;
+        m_memAllocator = memAllocator;
+        m_layerCount = swapchainCreateInfo.arraySize;
 
         VkExtent2D size = {swapchainCreateInfo.width, swapchainCreateInfo.height};
 
-        // Create a D32 depthbuffer
+        // Create a D32 depthbuffer, with a layer per color layer
         VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
         imageInfo.imageType = VK_IMAGE_TYPE_2D;
         imageInfo.extent.width = size.width;
         imageInfo.extent.height = size.height;
         imageInfo.extent.depth = 1;
         imageInfo.mipLevels = 1;
-        imageInfo.arrayLayers = 1;
+        imageInfo.arrayLayers = swapchainCreateInfo.arraySize;
         imageInfo.format = depthFormat;
         imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
         imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -953,9 +2055,8 @@ struct DepthBuffer {
 
         VkMemoryRequirements memRequirements{};
         vkGetImageMemoryRequirements(device, depthImage, &memRequirements);
-        memAllocator->Allocate(memRequirements, &depthMemory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        CHECK_VKCMD(namer.SetName(VK_OBJECT_TYPE_DEVICE_MEMORY, (uint64_t)depthMemory, "hello_xr fallback depth image memory"));
-        CHECK_VKCMD(vkBindImageMemory(device, depthImage, depthMemory, 0));
+        depthMemory = memAllocator->Allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        CHECK_VKCMD(vkBindImageMemory(device, depthImage, depthMemory.memory, depthMemory.offset));
     }
 
     void TransitionLayout(CmdBuffer* cmdBuffer, VkImageLayout newLayout) {
@@ -969,7 +2070,7 @@ struct DepthBuffer {
         depthBarrier.oldLayout = m_vkLayout;
         depthBarrier.newLayout = newLayout;
         depthBarrier.image = depthImage;
-        depthBarrier.subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1};
+        depthBarrier.subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, m_layerCount};
         vkCmdPipelineBarrier(cmdBuffer->buf, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, 0, 0, nullptr,
                              0, nullptr, 1, &depthBarrier);
 
@@ -981,7 +2082,9 @@ struct DepthBuffer {
 
    private:
     VkDevice m_vkDevice{VK_NULL_HANDLE};
+    MemoryAllocator* m_memAllocator{nullptr};
     VkImageLayout m_vkLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    uint32_t m_layerCount{1};
 };
 
 struct SwapchainImageContext {
@@ -990,59 +2093,106 @@ struct SwapchainImageContext {
     // A packed array of XrSwapchainImageVulkan2KHR's for xrEnumerateSwapchainImages
     std::vector<XrSwapchainImageVulkan2KHR> swapchainImages;
     std::vector<RenderTarget> renderTarget;
+    std::vector<RenderTarget> layerRenderTarget;  // Of each layer of each image of a texture array, rendered one at a time
+    // Of a motion vector swapchain, the render targets of each layer of each of its images with each depth swapchain image.
+    std::vector<RenderTarget> motionVectorRenderTarget;
     VkExtent2D size{};
+    uint32_t layerCount{1};  // The swapchain's arraySize: above 1, one layer per view
+    VkFormat format{VK_FORMAT_UNDEFINED};
     DepthBuffer depthBuffer{};
-    RenderPass rp{};
-    Pipeline pipe{};
-    CmdBuffer cmdBuffer{};
+    // Shared with the other swapchains of the same format and layer count.  A texture array is rendered to either with the
+    // multiview renderPipeline, null without multiview support, or a layer at a time with layerRenderPipeline.  Both are
+    // null for the motion vector and depth swapchains of space warp, which are rendered to together and need no depth buffer.
+    const RenderPipeline* renderPipeline{nullptr};
+    const RenderPipeline* layerRenderPipeline{nullptr};
     XrStructureType swapchainImageType;
 
     SwapchainImageContext() = default;
 
-    std::vector<XrSwapchainImageBaseHeader*> Create(const VulkanDebugObjectNamer& namer, VkDevice device, uint32_t queueFamilyIndex,
+    std::vector<XrSwapchainImageBaseHeader*> Create(const VulkanDebugObjectNamer& namer, VkDevice device,
                                                     MemoryAllocator* memAllocator, uint32_t capacity,
-                                                    const XrSwapchainCreateInfo& swapchainCreateInfo, const PipelineLayout& layout,
-                                                    const ShaderProgram& sp, const VertexBuffer<Geometry::Vertex>& vb) {
+                                                    const XrSwapchainCreateInfo& swapchainCreateInfo,
+                                                    const RenderPipeline* aRenderPipeline,
+                                                    const RenderPipeline* aLayerRenderPipeline) {
         m_vkDevice = device;
         m_namer = namer;
 
         size = {swapchainCreateInfo.width, swapchainCreateInfo.height};
-        VkFormat colorFormat = (VkFormat)swapchainCreateInfo.format;
-        VkFormat depthFormat = VK_FORMAT_D32_SFLOAT;
+        layerCount = swapchainCreateInfo.arraySize;
+        format = (VkFormat)swapchainCreateInfo.format;
+        renderPipeline = aRenderPipeline;
+        layerRenderPipeline = aLayerRenderPipeline;
         // XXX handle swapchainCreateInfo.sampleCount
 
-        depthBuffer.Create(namer, m_vkDevice, memAllocator, depthFormat, swapchainCreateInfo);
-        rp.Create(namer, m_vkDevice, colorFormat, depthFormat);
-        pipe.Create(m_vkDevice, size, layout, rp, sp, vb);
+        if (renderPipeline != nullptr || layerRenderPipeline != nullptr) {
+            const VkFormat depthFormat = (renderPipeline != nullptr ? renderPipeline : layerRenderPipeline)->rp.depthFmt;
+            depthBuffer.Create(namer, m_vkDevice, memAllocator, depthFormat, swapchainCreateInfo);
+        }
 
         swapchainImages.resize(capacity);
         renderTarget.resize(capacity);
+        if (layerRenderPipeline != nullptr) {
+            layerRenderTarget.resize(capacity * layerCount);
+        }
         std::vector<XrSwapchainImageBaseHeader*> bases(capacity);
         for (uint32_t i = 0; i < capacity; ++i) {
             swapchainImages[i] = {swapchainImageType};
             bases[i] = reinterpret_cast<XrSwapchainImageBaseHeader*>(&swapchainImages[i]);
         }
 
-        if (!cmdBuffer.Init(namer, device, queueFamilyIndex)) {
-            THROW("Failed to create command buffer");
-        }
-
         return bases;
     }
 
+    // Whether the image struct is one of this context's.
+    bool Owns(const XrSwapchainImageBaseHeader* swapchainImageHeader) const {
+        auto p = reinterpret_cast<const XrSwapchainImageVulkan2KHR*>(swapchainImageHeader);
+        const std::less_equal<const XrSwapchainImageVulkan2KHR*> lessEqual;
+        return !swapchainImages.empty() && lessEqual(&swapchainImages.front(), p) && lessEqual(p, &swapchainImages.back());
+    }
+
     uint32_t ImageIndex(const XrSwapchainImageBaseHeader* swapchainImageHeader) {
         auto p = reinterpret_cast<const XrSwapchainImageVulkan2KHR*>(swapchainImageHeader);
         return (uint32_t)(p - &swapchainImages[0]);
     }
 
-    void BindRenderTarget(uint32_t index, VkRenderPassBeginInfo* renderPassBeginInfo) {
-        if (renderTarget[index].fb == VK_NULL_HANDLE) {
-            renderTarget[index].Create(m_namer, m_vkDevice, swapchainImages[index].image, depthBuffer.depthImage, size, rp);
+    // Bind every layer of the image, and return the pipeline to render to it with.  The render targets are created with
+    // the first frame that renders to them.
+    const RenderPipeline& BindRenderTarget(uint32_t index, const RenderTarget** target) {
+        CHECK(renderPipeline != nullptr);
+        if (renderTarget[index].colorView == VK_NULL_HANDLE) {
+            renderTarget[index].Create(m_namer, m_vkDevice, swapchainImages[index].image, depthBuffer.depthImage, size,
+                                       renderPipeline->rp, layerCount);
+        }
+        *target = &renderTarget[index];
+        return *renderPipeline;
+    }
+
+    // Bind one layer of a texture array image, and return the pipeline to render to it with.
+    const RenderPipeline& BindLayerRenderTarget(uint32_t index, uint32_t layer, const RenderTarget** target) {
+        CHECK(layerRenderPipeline != nullptr && layer < layerCount);
+        RenderTarget& layerTarget = layerRenderTarget[index * layerCount + layer];
+        if (layerTarget.colorView == VK_NULL_HANDLE) {
+            layerTarget.Create(m_namer, m_vkDevice, swapchainImages[index].image, depthBuffer.depthImage, size,
+                               layerRenderPipeline->rp, 1, layer);
+        }
+        *target = &layerTarget;
+        return *layerRenderPipeline;
+    }
+
+    // Bind one layer of a motion vector image, with the same layer of an image of a depth swapchain as its depth buffer.
+    const RenderTarget& BindMotionVectorRenderTarget(uint32_t index, uint32_t layer, const SwapchainImageContext& depthContext,
+                                                     uint32_t depthIndex, const RenderPass& renderPass) {
+        CHECK(layer < layerCount && layer < depthContext.layerCount);
+        const size_t depthImageCount = depthContext.swapchainImages.size();
+        if (motionVectorRenderTarget.empty()) {
+            motionVectorRenderTarget.resize(swapchainImages.size() * layerCount * depthImageCount);
         }
-        renderPassBeginInfo->renderPass = rp.pass;
-        renderPassBeginInfo->framebuffer = renderTarget[index].fb;
-        renderPassBeginInfo->renderArea.offset = {0, 0};
-        renderPassBeginInfo->renderArea.extent = size;
+        RenderTarget& target = motionVectorRenderTarget[(index * layerCount + layer) * depthImageCount + depthIndex];
+        if (target.colorView == VK_NULL_HANDLE) {
+            target.Create(m_namer, m_vkDevice, swapchainImages[index].image, depthContext.swapchainImages[depthIndex].image, size,
+                          renderPass, 1, layer);
+        }
+        return target;
     }
 
    private:
@@ -1050,6 +2200,202 @@ struct SwapchainImageContext {
     VulkanDebugObjectNamer m_namer;
 };
 
+// With Options::IndirectDraw, the cubes of a view as the cull compute shader reads them, the arguments of the indirect draw
+// it counts the visible ones into, and the descriptor set that binds both and the view's instance buffer for it.
+struct IndirectDraw {
+    MappedBuffer cubes;
+    MappedBuffer args;
+    VkDescriptorSet set{VK_NULL_HANDLE};
+
+    IndirectDraw() = default;
+
+    ~IndirectDraw() {
+        if (m_vkDevice != nullptr && m_pool != VK_NULL_HANDLE) {
+            vkDestroyDescriptorPool(m_vkDevice, m_pool, nullptr);
+        }
+        m_pool = VK_NULL_HANDLE;
+        set = VK_NULL_HANDLE;
+        m_vkDevice = nullptr;
+    }
+
+    IndirectDraw(const IndirectDraw&) = delete;
+    IndirectDraw& operator=(const IndirectDraw&) = delete;
+    IndirectDraw(IndirectDraw&&) = delete;
+    IndirectDraw& operator=(IndirectDraw&&) = delete;
+
+    void Init(VkDevice device, MemoryAllocator* memAllocator, const CullPipeline& cullPipeline) {
+        m_vkDevice = device;
+        cubes.Init(device, memAllocator, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        args.Init(device, memAllocator, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+
+        // A pool of its own for the one set, so views come and go with no bookkeeping.
+        const VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, CullPipeline::BindingCount};
+        VkDescriptorPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+        poolInfo.maxSets = 1;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        CHECK_VKCMD(vkCreateDescriptorPool(m_vkDevice, &poolInfo, nullptr, &m_pool));
+
+        VkDescriptorSetAllocateInfo setInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+        setInfo.descriptorPool = m_pool;
+        setInfo.descriptorSetCount = 1;
+        setInfo.pSetLayouts = &cullPipeline.setLayout;
+        CHECK_VKCMD(vkAllocateDescriptorSets(m_vkDevice, &setInfo, &set));
+    }
+
+    // Bind the buffers as they are now, since growing replaces them.  The GPU must be done with the set.
+    void UpdateSet(const InstanceBuffer& instanceBuffer) const {
+        const std::array<VkDescriptorBufferInfo, CullPipeline::BindingCount> bufferInfos{
+            {{cubes.buf, 0, VK_WHOLE_SIZE}, {instanceBuffer.buf, 0, VK_WHOLE_SIZE}, {args.buf, 0, VK_WHOLE_SIZE}}};
+        VkWriteDescriptorSet write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        write.dstSet = set;
+        write.dstBinding = 0;
+        write.descriptorCount = (uint32_t)bufferInfos.size();
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = bufferInfos.data();
+        vkUpdateDescriptorSets(m_vkDevice, 1, &write, 0, nullptr);
+    }
+
+   private:
+    VkDevice m_vkDevice{VK_NULL_HANDLE};
+    VkDescriptorPool m_pool{VK_NULL_HANDLE};
+};
+
+// What the commands of one frame use.  Every view of the frame is recorded into its command buffer and submitted at once.
+// The cubes rendered to one view of a frame: the pose of the view, and the model transforms of the cubes, kept on the host
+// so LateLatchViews can write them corrected into the instance buffer the draw reads, without reading it back.
+struct ViewInstances {
+    XrPosef pose{};
+    std::vector<XrMatrix4x4f> models;
+    InstanceBuffer buffer;
+    IndirectDraw indirect;  // With Options::IndirectDraw, which leaves models empty
+};
+
+struct FrameResources {
+    CmdBuffer cmdBuffer{};
+    std::deque<ViewInstances> views;  // One per view rendered in the frame, only rewritten once cmdBuffer is done
+    uint32_t viewsRendered{0};
+    // One per view whose motion vectors are rendered in the frame, with the transform of each cube and its previous one.
+    std::deque<ViewInstances> motionVectorViews;
+    uint32_t motionVectorViewsRendered{0};
+    bool presentMirror{false};  // Whether the frame rendered to the last swapchain, and cycles the mirror window
+    // With record workers, a pool of secondary command buffers for each share, and the buffers a view executes.
+    std::deque<SecondaryCmdPool> recordPools;
+    std::vector<VkCommandBuffer> recordedShares;
+};
+
+// Enough frames that recording a frame does not wait for the GPU to finish the previous one.
+constexpr uint32_t FramesInFlight = 3;
+
+// FrameTimer - timestamps at the start of each frame in flight, after each of its first views, and at its end, in one
+// query pool.  Without timestamps on the graphics queue the pool is not created, and no frame is timed.
+struct FrameTimer {
+    VkQueryPool pool{VK_NULL_HANDLE};
+
+    FrameTimer() = default;
+
+    ~FrameTimer() {
+        if (m_vkDevice != nullptr) {
+            if (pool != VK_NULL_HANDLE) {
+                vkDestroyQueryPool(m_vkDevice, pool, nullptr);
+            }
+        }
+        pool = VK_NULL_HANDLE;
+        m_vkDevice = nullptr;
+    }
+
+    FrameTimer(const FrameTimer&) = delete;
+    FrameTimer& operator=(const FrameTimer&) = delete;
+    FrameTimer(FrameTimer&&) = delete;
+    FrameTimer& operator=(FrameTimer&&) = delete;
+
+    void Create(const VulkanDebugObjectNamer& namer, VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamilyIndex) {
+        m_vkDevice = device;
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilyProps(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProps.data());
+        const uint32_t validBits = queueFamilyProps[queueFamilyIndex].timestampValidBits;
+        if (validBits == 0) {
+            return;
+        }
+        m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(physicalDevice, &props);
+        m_timestampPeriod = props.limits.timestampPeriod;
+
+        VkQueryPoolCreateInfo queryPoolInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = QueriesPerFrame * FramesInFlight;
+        CHECK_VKCMD(vkCreateQueryPool(m_vkDevice, &queryPoolInfo, nullptr, &pool));
+        CHECK_VKCMD(namer.SetName(VK_OBJECT_TYPE_QUERY_POOL, (uint64_t)pool, "hello_xr frame timestamps"));
+    }
+
+    void Begin(VkCommandBuffer buf, uint32_t frameIndex) {
+        if (pool == VK_NULL_HANDLE) {
+            return;
+        }
+        vkCmdResetQueryPool(buf, pool, QueriesPerFrame * frameIndex, QueriesPerFrame);
+        vkCmdWriteTimestamp(buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pool, QueriesPerFrame * frameIndex);
+        m_viewCounts[frameIndex] = 0;
+    }
+
+    // After the commands of a view; the view takes from the previous timestamp to this one.
+    void EndView(VkCommandBuffer buf, uint32_t frameIndex) {
+        if (pool == VK_NULL_HANDLE || m_viewCounts[frameIndex] == IGraphicsPlugin::MaxTimedViews) {
+            return;
+        }
+        vkCmdWriteTimestamp(buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool,
+                            QueriesPerFrame * frameIndex + 1 + m_viewCounts[frameIndex]++);
+    }
+
+    void End(VkCommandBuffer buf, uint32_t frameIndex) {
+        if (pool == VK_NULL_HANDLE) {
+            return;
+        }
+        vkCmdWriteTimestamp(buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool,
+                            QueriesPerFrame * frameIndex + 1 + m_viewCounts[frameIndex]);
+        m_timed[frameIndex] = true;
+    }
+
+    // The GPU times of the frame last timed in the slot and of its views, in milliseconds, once its command buffer is done.
+    // False if they are already taken, or no frame was timed.
+    bool Take(uint32_t frameIndex, double* milliseconds, std::array<double, IGraphicsPlugin::MaxTimedViews>* viewMilliseconds,
+              uint32_t* viewCount) {
+        if (!m_timed[frameIndex]) {
+            return false;
+        }
+        m_timed[frameIndex] = false;
+        // Only the timestamps written since the reset are read, since waiting on the others would never return.
+        const uint32_t timestampCount = m_viewCounts[frameIndex] + 2;
+        std::array<uint64_t, QueriesPerFrame> timestamps;
+        CHECK_VKCMD(vkGetQueryPoolResults(m_vkDevice, pool, QueriesPerFrame * frameIndex, timestampCount,
+                                          timestampCount * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+                                          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+        *milliseconds = Milliseconds(timestamps[0], timestamps[timestampCount - 1]);
+        for (uint32_t view = 0; view < m_viewCounts[frameIndex]; ++view) {
+            (*viewMilliseconds)[view] = Milliseconds(timestamps[view], timestamps[view + 1]);
+        }
+        *viewCount = m_viewCounts[frameIndex];
+        return true;
+    }
+
+   private:
+    static constexpr uint32_t QueriesPerFrame = IGraphicsPlugin::MaxTimedViews + 2;
+
+    double Milliseconds(uint64_t begin, uint64_t end) const {
+        return ((end - begin) & m_timestampMask) * (double)m_timestampPeriod / 1e6;
+    }
+
+    VkDevice m_vkDevice{VK_NULL_HANDLE};
+    uint64_t m_timestampMask{0};
+    float m_timestampPeriod{1};  // Nanoseconds per timestamp tick
+    std::array<bool, FramesInFlight> m_timed{};
+    std::array<uint32_t, FramesInFlight> m_viewCounts{};  // Views timed in each slot's frame
+};
+
 #if defined(USE_MIRROR_WINDOW)
 // Swapchain
 struct Swapchain {
@@ -1058,6 +2404,9 @@ struct Swapchain {
     VkSwapchainKHR swapchain{VK_NULL_HANDLE};
     VkFence readyFence{VK_NULL_HANDLE};
     VkFence presentFence{VK_NULL_HANDLE};
+    // Rate limit the GPU rather than the host, with one semaphore per frame in flight: Acquire signals it and Present waits
+    // on it, and a frame's semaphore is free again once the queue is past the frame that reuses its slot.
+    std::array<VkSemaphore, FramesInFlight> frameSemaphores{};
     static const uint32_t maxImages = 4;
     uint32_t swapchainCount = 0;
     uint32_t renderImageIdx = 0;
@@ -1075,8 +2424,14 @@ struct Swapchain {
         if (m_vkDevice) {
             // Flush any pending Present() calls which are using the fence
             Wait();
+            // ...and any using the semaphores
+            if (frameSemaphores[0]) CHECK_VKCMD(vkDeviceWaitIdle(m_vkDevice));
             if (swapchain) vkDestroySwapchainKHR(m_vkDevice, swapchain, nullptr);
             if (readyFence) vkDestroyFence(m_vkDevice, readyFence, nullptr);
+            for (VkSemaphore& frameSemaphore : frameSemaphores) {
+                if (frameSemaphore) vkDestroySemaphore(m_vkDevice, frameSemaphore, nullptr);
+                frameSemaphore = VK_NULL_HANDLE;
+            }
         }
 
         if (m_vkInstance && surface) vkDestroySurfaceKHR(m_vkInstance, surface, nullptr);
@@ -1223,6 +2578,12 @@ void Swapchain::Create(VkInstance instance, VkPhysicalDevice physDevice, VkDevic
     VkFenceCreateInfo fenceInfo{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
     CHECK_VKCMD(vkCreateFence(m_vkDevice, &fenceInfo, nullptr, &readyFence));
 
+    // Semaphores to throttle the GPU instead
+    VkSemaphoreCreateInfo semInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    for (VkSemaphore& frameSemaphore : frameSemaphores) {
+        CHECK_VKCMD(vkCreateSemaphore(m_vkDevice, &semInfo, nullptr, &frameSemaphore));
+    }
+
     swapchainCount = 0;
     CHECK_VKCMD(vkGetSwapchainImagesKHR(m_vkDevice, swapchain, &swapchainCount, nullptr));
     assert(swapchainCount < maxImages);
@@ -1291,7 +2652,10 @@ void Swapchain::Present(VkQueue queue, VkSemaphore drawComplete) {
 
 struct VulkanGraphicsPlugin : public IGraphicsPlugin {
     VulkanGraphicsPlugin(const std::shared_ptr<Options>& options, std::shared_ptr<IPlatformPlugin> /*unused*/)
-        : m_clearColor(options->GetBackgroundClearColor()) {
+        : m_clearColor(options->GetBackgroundClearColor()),
+          m_cacheDirectory(options->CacheDirectory),
+          m_recordThreads(options->RecordThreads),
+          m_indirectDraw(options->IndirectDraw) {
         m_graphicsBinding.type = GetGraphicsBindingType();
     };
 
@@ -1457,7 +2821,62 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
         deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 #endif
 
+        // Enable VK_KHR_multiview when the device has it, to render both eyes in one render pass.
+        uint32_t deviceExtensionCount = 0;
+        CHECK_VKCMD(vkEnumerateDeviceExtensionProperties(m_vkPhysicalDevice, nullptr, &deviceExtensionCount, nullptr));
+        std::vector<VkExtensionProperties> deviceExtensionProperties(deviceExtensionCount);
+        CHECK_VKCMD(vkEnumerateDeviceExtensionProperties(m_vkPhysicalDevice, nullptr, &deviceExtensionCount,
+                                                         deviceExtensionProperties.data()));
+        const auto deviceSupports = [&deviceExtensionProperties](const char* extensionName) {
+            return std::any_of(deviceExtensionProperties.begin(), deviceExtensionProperties.end(),
+                               [extensionName](const VkExtensionProperties& properties) {
+                                   return strcmp(properties.extensionName, extensionName) == 0;
+                               });
+        };
+        m_multiviewSupported = deviceSupports(VK_KHR_MULTIVIEW_EXTENSION_NAME);
+        VkPhysicalDeviceMultiviewFeaturesKHR multiviewFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES_KHR};
+        multiviewFeatures.multiview = VK_TRUE;
+        if (m_multiviewSupported) {
+            deviceExtensions.push_back(VK_KHR_MULTIVIEW_EXTENSION_NAME);
+        }
+        Log::Write(Log::Level::Verbose, Fmt("VK_KHR_multiview %s", m_multiviewSupported ? "supported" : "not supported"));
+
+        // Enable VK_KHR_dynamic_rendering, and the extensions it builds on, when the device has them all, to render without
+        // a VkRenderPass, and without a framebuffer for each swapchain image.
+        void* deviceFeatures = m_multiviewSupported ? &multiviewFeatures : nullptr;
+#if defined(VK_KHR_dynamic_rendering)
+        const std::array<const char*, 4> dynamicRenderingExtensions{
+            VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME, VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+            VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME, VK_KHR_MAINTENANCE2_EXTENSION_NAME};
+        m_dynamicRenderingSupported = m_multiviewSupported && std::all_of(dynamicRenderingExtensions.begin(),
+                                                                          dynamicRenderingExtensions.end(), deviceSupports);
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR};
+        dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+        if (m_dynamicRenderingSupported) {
+            deviceExtensions.insert(deviceExtensions.end(), dynamicRenderingExtensions.begin(), dynamicRenderingExtensions.end());
+            multiviewFeatures.pNext = &dynamicRenderingFeatures;
+        }
+#endif
+        Log::Write(Log::Level::Verbose,
+                   Fmt("VK_KHR_dynamic_rendering %s", m_dynamicRenderingSupported ? "supported" : "not supported"));
+
+        // Enable VK_KHR_timeline_semaphore when the device has it, to track the frames in flight with one semaphore on the
+        // queue rather than a fence per command buffer.
+#if defined(VK_KHR_timeline_semaphore)
+        m_queueTimelineSupported = deviceSupports(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures{
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR};
+        timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+        if (m_queueTimelineSupported) {
+            deviceExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+            timelineSemaphoreFeatures.pNext = deviceFeatures;
+            deviceFeatures = &timelineSemaphoreFeatures;
+        }
+#endif
+
         VkDeviceCreateInfo deviceInfo{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+        deviceInfo.pNext = deviceFeatures;
         deviceInfo.queueCreateInfoCount = 1;
         deviceInfo.pQueueCreateInfos = &queueInfo;
         deviceInfo.enabledLayerCount = 0;
@@ -1477,6 +2896,25 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
 
         m_namer.Init(m_vkInstance, m_vkDevice);
 
+#if defined(VK_KHR_timeline_semaphore)
+        if (m_queueTimelineSupported) {
+            m_queueTimelineSupported = m_queueTimeline.Init(m_namer, m_vkDevice);
+        }
+#endif
+        Log::Write(Log::Level::Verbose,
+                   Fmt("VK_KHR_timeline_semaphore %s", m_queueTimelineSupported ? "supported" : "not supported"));
+
+#if defined(VK_KHR_dynamic_rendering)
+        if (m_dynamicRenderingSupported) {
+            m_dynamicRendering.vkCmdBeginRenderingKHR =
+                (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(m_vkDevice, "vkCmdBeginRenderingKHR");
+            m_dynamicRendering.vkCmdEndRenderingKHR =
+                (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(m_vkDevice, "vkCmdEndRenderingKHR");
+            m_dynamicRenderingSupported =
+                m_dynamicRendering.vkCmdBeginRenderingKHR != nullptr && m_dynamicRendering.vkCmdEndRenderingKHR != nullptr;
+        }
+#endif
+
         vkGetDeviceQueue(m_vkDevice, queueInfo.queueFamilyIndex, 0, &m_vkQueue);
 
         m_memAllocator.Init(m_vkPhysicalDevice, m_vkDevice);
@@ -1513,6 +2951,17 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
 #ifdef USE_ONLINE_VULKAN_SHADERC
         auto vertexSPIRV = CompileGlslShader("vertex", shaderc_glsl_default_vertex_shader, VertexShaderGlsl);
         auto fragmentSPIRV = CompileGlslShader("fragment", shaderc_glsl_default_fragment_shader, FragmentShaderGlsl);
+        auto multiviewVertexSPIRV =
+            m_multiviewSupported
+                ? CompileGlslShader("multiview vertex", shaderc_glsl_default_vertex_shader, MultiviewVertexShaderGlsl)
+                : std::vector<uint32_t>();
+        auto motionVectorVertexSPIRV =
+            CompileGlslShader("motion vector vertex", shaderc_glsl_default_vertex_shader, MotionVectorVertexShaderGlsl);
+        auto motionVectorFragmentSPIRV =
+            CompileGlslShader("motion vector fragment", shaderc_glsl_default_fragment_shader, MotionVectorFragmentShaderGlsl);
+        auto cullComputeSPIRV =
+            m_indirectDraw ? CompileGlslShader("cull compute", shaderc_glsl_default_compute_shader, CullComputeShaderGlsl)
+                           : std::vector<uint32_t>();
 #else
         std::vector<uint32_t> vertexSPIRV = SPV_PREFIX
 #include "vert.spv"
@@ -1520,6 +2969,18 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
         std::vector<uint32_t> fragmentSPIRV = SPV_PREFIX
 #include "frag.spv"
             SPV_SUFFIX;
+        std::vector<uint32_t> multiviewVertexSPIRV = SPV_PREFIX
+#include "multiview_vert.spv"
+            SPV_SUFFIX;
+        std::vector<uint32_t> motionVectorVertexSPIRV = SPV_PREFIX
+#include "motion_vert.spv"
+            SPV_SUFFIX;
+        std::vector<uint32_t> motionVectorFragmentSPIRV = SPV_PREFIX
+#include "motion_frag.spv"
+            SPV_SUFFIX;
+        std::vector<uint32_t> cullComputeSPIRV = SPV_PREFIX
+#include "cull_comp.spv"
+            SPV_SUFFIX;
 #endif
         if (vertexSPIRV.empty()) THROW("Failed to compile vertex shader");
         if (fragmentSPIRV.empty()) THROW("Failed to compile fragment shader");
@@ -1528,14 +2989,56 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
         m_shaderProgram.LoadVertexShader(vertexSPIRV);
         m_shaderProgram.LoadFragmentShader(fragmentSPIRV);
 
+        // The multiview vertex shader declares the MultiView capability, so only load it when the device enables it.
+        if (m_multiviewSupported) {
+            if (multiviewVertexSPIRV.empty()) THROW("Failed to compile multiview vertex shader");
+            m_multiviewShaderProgram.Init(m_vkDevice);
+            m_multiviewShaderProgram.LoadVertexShader(multiviewVertexSPIRV);
+            m_multiviewShaderProgram.LoadFragmentShader(fragmentSPIRV);
+        }
+
+        if (motionVectorVertexSPIRV.empty()) THROW("Failed to compile motion vector vertex shader");
+        if (motionVectorFragmentSPIRV.empty()) THROW("Failed to compile motion vector fragment shader");
+        m_motionVectorShaderProgram.Init(m_vkDevice);
+        m_motionVectorShaderProgram.LoadVertexShader(motionVectorVertexSPIRV);
+        m_motionVectorShaderProgram.LoadFragmentShader(motionVectorFragmentSPIRV);
+
         // Semaphore to block on draw complete
         VkSemaphoreCreateInfo semInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
         CHECK_VKCMD(vkCreateSemaphore(m_vkDevice, &semInfo, nullptr, &m_vkDrawDone));
         CHECK_VKCMD(m_namer.SetName(VK_OBJECT_TYPE_SEMAPHORE, (uint64_t)m_vkDrawDone, "hello_xr draw done semaphore"));
 
-        if (!m_cmdBuffer.Init(m_namer, m_vkDevice, m_queueFamilyIndex)) THROW("Failed to create command buffer");
+        QueueTimeline* timeline = m_queueTimelineSupported ? &m_queueTimeline : nullptr;
+        if (!m_cmdBuffer.Init(m_namer, m_vkDevice, m_queueFamilyIndex, timeline)) THROW("Failed to create command buffer");
+        for (FrameResources& frame : m_frames) {
+            if (!frame.cmdBuffer.Init(m_namer, m_vkDevice, m_queueFamilyIndex, timeline)) {
+                THROW("Failed to create command buffer");
+            }
+        }
+        if (m_recordThreads > 0) {
+            m_recordWorkers.Start(m_recordThreads);
+            for (FrameResources& frame : m_frames) {
+                for (uint32_t share = 0; share < m_recordWorkers.ShareCount(); ++share) {
+                    frame.recordPools.emplace_back();
+                    frame.recordPools.back().Init(m_namer, m_vkDevice, m_queueFamilyIndex);
+                }
+                frame.recordedShares.resize(m_recordWorkers.ShareCount());
+            }
+            Log::Write(Log::Level::Info, Fmt("Recording draws on up to %u threads", m_recordWorkers.ShareCount()));
+        }
+        m_frameTimer.Create(m_namer, m_vkPhysicalDevice, m_vkDevice, m_queueFamilyIndex);
 
         m_pipelineLayout.Create(m_vkDevice);
+        m_pipelineCache.Create(m_vkPhysicalDevice, m_vkDevice, m_cacheDirectory);
+
+        if (m_indirectDraw) {
+            if (cullComputeSPIRV.empty()) THROW("Failed to compile cull compute shader");
+            m_cullPipeline.Create(m_vkDevice, m_pipelineCache.cache, cullComputeSPIRV);
+            m_pipelineCache.Save();
+            if (m_recordThreads > 0) {
+                Log::Write(Log::Level::Warning, "Indirect draws are recorded on the rendering thread alone");
+            }
+        }
 
         static_assert(sizeof(Geometry::Vertex) == 24, "Unexpected Vertex size");
         m_drawBuffer.Init(m_vkDevice, &m_memAllocator,
@@ -1544,8 +3047,7 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
         uint32_t numCubeIdicies = sizeof(Geometry::c_cubeIndices) / sizeof(Geometry::c_cubeIndices[0]);
         uint32_t numCubeVerticies = sizeof(Geometry::c_cubeVertices) / sizeof(Geometry::c_cubeVertices[0]);
         m_drawBuffer.Create(numCubeIdicies, numCubeVerticies);
-        m_drawBuffer.UpdateIndices(Geometry::c_cubeIndices, numCubeIdicies, 0);
-        m_drawBuffer.UpdateVertices(Geometry::c_cubeVertices, numCubeVerticies, 0);
+        m_drawBuffer.Upload(&m_cmdBuffer, m_vkQueue, Geometry::c_cubeIndices, Geometry::c_cubeVertices);
 
 #if defined(USE_MIRROR_WINDOW)
         m_swapchain.Create(m_vkInstance, m_vkPhysicalDevice, m_vkDevice, m_graphicsBinding.queueFamilyIndex);
@@ -1586,31 +3088,328 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
         m_swapchainImageContexts.emplace_back(GetSwapchainImageType());
         SwapchainImageContext& swapchainImageContext = m_swapchainImageContexts.back();
 
-        std::vector<XrSwapchainImageBaseHeader*> bases =
-            swapchainImageContext.Create(m_namer, m_vkDevice, m_queueFamilyIndex, &m_memAllocator, capacity, swapchainCreateInfo,
-                                         m_pipelineLayout, m_shaderProgram, m_drawBuffer);
+        // The motion vector and depth swapchains of space warp are only rendered to by RenderMotionVectors, together.
+        if ((swapchainCreateInfo.usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0 ||
+            swapchainCreateInfo.format == MotionVectorFormat) {
+            return swapchainImageContext.Create(m_namer, m_vkDevice, &m_memAllocator, capacity, swapchainCreateInfo, nullptr,
+                                                nullptr);
+        }
+
+        // A texture array is rendered to in one multiview pass, if the device supports it, or one layer at a time.
+        const VkFormat colorFormat = (VkFormat)swapchainCreateInfo.format;
+        const uint32_t layerCount = swapchainCreateInfo.arraySize;
+        const RenderPipeline* renderPipeline =
+            layerCount == 1 || m_multiviewSupported ? &GetRenderPipeline(colorFormat, layerCount) : nullptr;
+        const RenderPipeline* layerRenderPipeline = layerCount > 1 ? &GetRenderPipeline(colorFormat, 1) : nullptr;
+        m_mirrorSwapchainImageContext = &swapchainImageContext;
+        return swapchainImageContext.Create(m_namer, m_vkDevice, &m_memAllocator, capacity, swapchainCreateInfo, renderPipeline,
+                                            layerRenderPipeline);
+    }
+
+    void ReleaseSwapchainImages() override {
+        CHECK(!m_frameInProgress);
+        CHECK_VKCMD(vkDeviceWaitIdle(m_vkDevice));
+        m_swapchainImageContexts.clear();
+        m_mirrorSwapchainImageContext = nullptr;
+    }
+
+    // The context of the swapchain the image struct belongs to.  There are only a couple of swapchains, so this is cheaper
+    // than a map lookup, and allocates nothing.
+    SwapchainImageContext* FindSwapchainImageContext(const XrSwapchainImageBaseHeader* swapchainImage) {
+        for (SwapchainImageContext& swapchainImageContext : m_swapchainImageContexts) {
+            if (swapchainImageContext.Owns(swapchainImage)) {
+                return &swapchainImageContext;
+            }
+        }
+        THROW("Unknown swapchain image");
+    }
+
+    // The commands the render passes begin and end rendering with, or null to use a VkRenderPass.
+    const DynamicRendering* GetDynamicRendering() const { return m_dynamicRenderingSupported ? &m_dynamicRendering : nullptr; }
 
-        // Map every swapchainImage base pointer to this context
-        for (auto& base : bases) {
-            m_swapchainImageContextMap[base] = &swapchainImageContext;
+    // The render pipeline to render this many layers at once to a color format, created with the first swapchain that
+    // needs it.
+    const RenderPipeline& GetRenderPipeline(VkFormat colorFormat, uint32_t layerCount) {
+        auto it = m_renderPipelines.find({colorFormat, layerCount});
+        if (it != m_renderPipelines.end()) {
+            return it->second;
         }
 
-        return bases;
+        RenderPipeline& renderPipeline = m_renderPipelines[{colorFormat, layerCount}];
+        renderPipeline.rp.Create(m_namer, m_vkDevice, colorFormat, VK_FORMAT_D32_SFLOAT, layerCount, GetDynamicRendering());
+        // A texture array swapchain is rendered in one multiview render pass, with the shader that selects each view's
+        // view-projection.
+        const ShaderProgram& shaderProgram = layerCount > 1 ? m_multiviewShaderProgram : m_shaderProgram;
+        renderPipeline.pipe.Create(m_vkDevice, m_pipelineCache.cache, m_pipelineLayout, renderPipeline.rp, shaderProgram,
+                                   m_drawBuffer);
+        m_pipelineCache.Save();
+        return renderPipeline;
     }
 
     void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                     int64_t /*swapchainFormat*/, const std::vector<Cube>& cubes) override {
-        CHECK(layerView.subImage.imageArrayIndex == 0);  // Texture arrays not supported.
+        RenderViews({layerView}, swapchainImage, cubes);
+    }
+
+    // The motion vectors are half floats, never one of the color swapchain formats, which tells their swapchain apart.
+    static constexpr VkFormat MotionVectorFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+    bool SelectSpaceWarpSwapchainFormats(const std::vector<int64_t>& runtimeFormats, int64_t* motionVectorFormat,
+                                         int64_t* depthFormat) const override {
+        constexpr int64_t SupportedDepthSwapchainFormats[] = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM};
+        auto depthFormatIt =
+            std::find_first_of(runtimeFormats.begin(), runtimeFormats.end(), std::begin(SupportedDepthSwapchainFormats),
+                               std::end(SupportedDepthSwapchainFormats));
+        if (depthFormatIt == runtimeFormats.end() ||
+            std::find(runtimeFormats.begin(), runtimeFormats.end(), (int64_t)MotionVectorFormat) == runtimeFormats.end()) {
+            return false;
+        }
+        *motionVectorFormat = MotionVectorFormat;
+        *depthFormat = *depthFormatIt;
+        return true;
+    }
+
+    // Records one layer of the motion vectors like RenderViews records a view, with the transform of each cube followed by
+    // its previous one in the instance buffer, in a render pass of its own after the views, which the frame timer leaves out.
+    void RenderMotionVectors(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* motionVectorImage,
+                             const XrSwapchainImageBaseHeader* depthImage, uint32_t arrayIndex, const std::vector<Cube>& cubes,
+                             const std::vector<Cube>& previousCubes) override {
+        CHECK(m_frameInProgress);
+        SwapchainImageContext* motionVectorContext = FindSwapchainImageContext(motionVectorImage);
+        SwapchainImageContext* depthContext = FindSwapchainImageContext(depthImage);
+        const RenderPipeline& renderPipeline = GetMotionVectorRenderPipeline(motionVectorContext->format, depthContext->format);
+
+        FrameResources& frame = m_frames[m_frameIndex];
+        CmdBuffer& cmdBuffer = frame.cmdBuffer;
+        if (frame.motionVectorViewsRendered == frame.motionVectorViews.size()) {
+            frame.motionVectorViews.emplace_back();
+            frame.motionVectorViews.back().buffer.Init(m_vkDevice, &m_memAllocator);
+        }
+        ViewInstances& view = frame.motionVectorViews[frame.motionVectorViewsRendered++];
+        view.pose = layerView.pose;
+        view.models.resize(2 * cubes.size());
+        for (size_t i = 0; i < cubes.size(); ++i) {
+            const Cube& previous = i < previousCubes.size() ? previousCubes[i] : cubes[i];
+            XrMatrix4x4f_CreateTranslationRotationScale(&view.models[2 * i], &cubes[i].Pose.position, &cubes[i].Pose.orientation,
+                                                        &cubes[i].Scale);
+            XrMatrix4x4f_CreateTranslationRotationScale(&view.models[2 * i + 1], &previous.Pose.position,
+                                                        &previous.Pose.orientation, &previous.Scale);
+        }
+        if (!cubes.empty()) {
+            view.buffer.Update(view.models.data(), (uint32_t)view.models.size());
+        }
+
+        // No motion where there is no cube, and the far plane behind them.
+        std::array<VkClearValue, 2> clearValues{};
+        clearValues[1].depthStencil.depth = 1.0f;
+        const RenderTarget& target = motionVectorContext->BindMotionVectorRenderTarget(
+            motionVectorContext->ImageIndex(motionVectorImage), arrayIndex, *depthContext, depthContext->ImageIndex(depthImage),
+            renderPipeline.rp);
+        const VkExtent2D size = motionVectorContext->size;
+
+        renderPipeline.rp.Begin(cmdBuffer.buf, target, size, clearValues);
+        vkCmdBindPipeline(cmdBuffer.buf, VK_PIPELINE_BIND_POINT_GRAPHICS, renderPipeline.pipe.pipe);
+
+        const VkRect2D scissor = {{0, 0}, size};
+#if defined(ORIGIN_BOTTOM_LEFT)
+        const VkViewport viewport = {0.0f, (float)size.height, (float)size.width, -(float)size.height, 0.0f, 1.0f};
+#else
+        const VkViewport viewport = {0.0f, 0.0f, (float)size.width, (float)size.height, 0.0f, 1.0f};
+#endif
+        vkCmdSetViewport(cmdBuffer.buf, 0, 1, &viewport);
+        vkCmdSetScissor(cmdBuffer.buf, 0, 1, &scissor);
+
+        if (!cubes.empty()) {
+            vkCmdBindIndexBuffer(cmdBuffer.buf, m_drawBuffer.idxBuf, 0, VK_INDEX_TYPE_UINT16);
+            const std::array<VkBuffer, 2> vertexBuffers{m_drawBuffer.vtxBuf, view.buffer.buf};
+            const std::array<VkDeviceSize, 2> offsets{0, 0};
+            vkCmdBindVertexBuffers(cmdBuffer.buf, 0, (uint32_t)vertexBuffers.size(), vertexBuffers.data(), offsets.data());
+
+            // Both positions of a cube are seen through the view of this frame, so the motion is that of the cube alone.
+            XrMatrix4x4f viewProjection;
+            XrMatrix4x4f_CreateViewProjectionFromPoseFov(&viewProjection, GRAPHICS_VULKAN, &layerView.pose, layerView.fov, 0.05f,
+                                                         100.0f);
+            vkCmdPushConstants(cmdBuffer.buf, m_pipelineLayout.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(XrMatrix4x4f),
+                               &viewProjection);
+            vkCmdDrawIndexed(cmdBuffer.buf, m_drawBuffer.count.idx, (uint32_t)cubes.size(), 0, 0, 0);
+        }
+
+        renderPipeline.rp.End(cmdBuffer.buf);
+    }
+
+    // The render pipeline of the motion vectors, created with the space warp swapchains.
+    const RenderPipeline& GetMotionVectorRenderPipeline(VkFormat motionVectorFormat, VkFormat depthFormat) {
+        if (m_motionVectorRenderPipeline == nullptr || m_motionVectorRenderPipeline->rp.depthFmt != depthFormat) {
+            m_motionVectorRenderPipeline = std::make_unique<RenderPipeline>();
+            m_motionVectorRenderPipeline->rp.Create(m_namer, m_vkDevice, motionVectorFormat, depthFormat, 1,
+                                                    GetDynamicRendering());
+            m_motionVectorRenderPipeline->pipe.Create(m_vkDevice, m_pipelineCache.cache, m_pipelineLayout,
+                                                      m_motionVectorRenderPipeline->rp, m_motionVectorShaderProgram, m_drawBuffer,
+                                                      2);
+            m_pipelineCache.Save();
+        }
+        return *m_motionVectorRenderPipeline;
+    }
+
+    // Start recording the frame into the command buffer of the oldest frame in flight, which is normally long done.
+    void BeginFrame() override {
+        CHECK(!m_frameInProgress);
+        m_frameIndex = (m_frameIndex + 1) % FramesInFlight;
+        FrameResources& frame = m_frames[m_frameIndex];
+        frame.cmdBuffer.Wait();
+        if (m_frameTimer.Take(m_frameIndex, &m_gpuFrameTime, &m_gpuViewTimes, &m_gpuViewTimeCount)) {
+            m_gpuFrameTimeAvailable = true;
+        }
+        frame.cmdBuffer.Reset();
+        for (SecondaryCmdPool& recordPool : frame.recordPools) {
+            recordPool.Reset();
+        }
+        frame.cmdBuffer.Begin();
+        m_frameTimer.Begin(frame.cmdBuffer.buf, m_frameIndex);
+        frame.viewsRendered = 0;
+        frame.motionVectorViewsRendered = 0;
+        frame.presentMirror = false;
+        m_frameInProgress = true;
+    }
+
+    // Submit every view of the frame at once.
+    void EndFrame() override {
+        CHECK(m_frameInProgress);
+        FrameResources& frame = m_frames[m_frameIndex];
+        m_frameTimer.End(frame.cmdBuffer.buf, m_frameIndex);
+        frame.cmdBuffer.End();
+        frame.cmdBuffer.Exec(m_vkQueue);
+        m_frameInProgress = false;
+
+#if defined(USE_MIRROR_WINDOW)
+        // Cycle the window's swapchain on the frame that rendered the last view.  With the queue timeline, frame slots are
+        // only reused once the queue is past them, so the present is ordered on the GPU instead of blocking the host.
+        if (frame.presentMirror) {
+            if (m_queueTimelineSupported) {
+                const VkSemaphore ready = m_swapchain.frameSemaphores[m_frameIndex];
+                m_swapchain.Acquire(ready);
+                m_swapchain.Present(m_vkQueue, ready);
+            } else {
+                m_swapchain.Acquire();
+                m_swapchain.Wait();
+                m_swapchain.Present(m_vkQueue);
+            }
+        }
+#endif
+    }
+
+    bool TakeGpuFrameTime(double* milliseconds) override {
+        if (!m_gpuFrameTimeAvailable) {
+            return false;
+        }
+        *milliseconds = m_gpuFrameTime;
+        m_gpuFrameTimeAvailable = false;
+        return true;
+    }
+
+    uint32_t TakeGpuViewTimes(std::array<double, MaxTimedViews>& milliseconds) override {
+        const uint32_t viewCount = m_gpuViewTimeCount;
+        milliseconds = m_gpuViewTimes;
+        m_gpuViewTimeCount = 0;
+        return viewCount;
+    }
+
+    // The view-projection transforms are push constants, recorded into the command buffer, but the model transforms of the
+    // cubes are still read from the instance buffers when the GPU runs it, so the correction of each view goes into those.
+    // With indirect draws the cull shader writes them instead, so there is nothing to correct them from.
+    bool SupportsLateLatching() const override { return !m_indirectDraw; }
+
+    void LateLatchViews(const std::vector<XrCompositionLayerProjectionView>& layerViews) override {
+        CHECK(m_frameInProgress);
+        FrameResources& frame = m_frames[m_frameIndex];
+        CHECK(frame.viewsRendered <= layerViews.size());
+        for (uint32_t i = 0; i < frame.viewsRendered; ++i) {
+            ViewInstances& view = frame.views[i];
+            if (view.models.empty()) {
+                continue;
+            }
+            XrMatrix4x4f correction;
+            XrLateLatch::CreateCorrection(&correction, view.pose, layerViews[i].pose);
+            view.buffer.Correct(correction, view.models.data(), (uint32_t)view.models.size());
+        }
+    }
+
+    bool SupportsMultiview() const override { return m_multiviewSupported; }
+
+    void RenderMultiView(const std::vector<XrCompositionLayerProjectionView>& layerViews,
+                         const XrSwapchainImageBaseHeader* swapchainImage, int64_t /*swapchainFormat*/,
+                         const std::vector<Cube>& cubes) override {
+        CHECK(m_multiviewSupported);
+        CHECK(layerViews.size() <= MaxMultiviewCount);
+        for (size_t i = 0; i < layerViews.size(); ++i) {
+            CHECK(layerViews[i].subImage.imageArrayIndex == i);  // Layer i of the render target is view i.
+        }
+
+        RenderViews(layerViews, swapchainImage, cubes);
+    }
+
+    uint32_t GetSupportedSwapchainSampleCount(const XrViewConfigurationView&) override { return VK_SAMPLE_COUNT_1_BIT; }
 
-        auto swapchainContext = m_swapchainImageContextMap[swapchainImage];
+    void UpdateOptions(const std::shared_ptr<Options>& options) override { m_clearColor = options->GetBackgroundClearColor(); }
+
+   protected:
+    // Records the cubes rendered to every layer of the swapchain image, one per view, in one render pass and with one
+    // instanced draw: one layer renders like RenderView always has, and more render with the multiview shader and render pass.
+    // One view of a texture array renders to its layer alone.  Outside of BeginFrame and EndFrame, the view is a frame of its
+    // own, submitted before returning.
+    void RenderViews(const std::vector<XrCompositionLayerProjectionView>& layerViews,
+                     const XrSwapchainImageBaseHeader* swapchainImage, const std::vector<Cube>& cubes) {
+        SwapchainImageContext* swapchainContext = FindSwapchainImageContext(swapchainImage);
         uint32_t imageIndex = swapchainContext->ImageIndex(swapchainImage);
+        const bool oneLayer = layerViews.size() == 1 && swapchainContext->layerCount > 1;
+        CHECK(oneLayer || layerViews.size() == swapchainContext->layerCount);
+        CHECK(oneLayer || layerViews[0].subImage.imageArrayIndex == 0);
 
-        // Note: this needs to be modified to avoid blocking on the CmdBuffer fence between multiple views of the same frame, if
-        // Texture arrays are supported.
-        CmdBuffer& cmdBuffer = swapchainContext->cmdBuffer;
-        cmdBuffer.Wait();
-        cmdBuffer.Reset();
-        cmdBuffer.Begin();
+        const bool ownFrame = !m_frameInProgress;
+        if (ownFrame) {
+            BeginFrame();
+        }
+        FrameResources& frame = m_frames[m_frameIndex];
+        CmdBuffer& cmdBuffer = frame.cmdBuffer;
+        if (frame.viewsRendered == frame.views.size()) {
+            frame.views.emplace_back();
+            frame.views.back().buffer.Init(m_vkDevice, &m_memAllocator);
+            if (m_indirectDraw) {
+                frame.views.back().indirect.Init(m_vkDevice, &m_memAllocator, m_cullPipeline);
+            }
+        }
+        ViewInstances& view = frame.views[frame.viewsRendered++];
+        InstanceBuffer& instanceBuffer = view.buffer;
+        frame.presentMirror = frame.presentMirror || swapchainContext == m_mirrorSwapchainImageContext;
+
+        // With record workers, and enough cubes for each share to be worth a thread, every share of the cubes computes its
+        // model transforms and records its draw into a secondary command buffer of its own, on its own thread.
+        const uint32_t shareCount =
+            m_indirectDraw
+                ? 1
+                : (uint32_t)std::min<size_t>(m_recordWorkers.ShareCount(), std::max<size_t>(cubes.size() / MinCubesPerShare, 1));
+
+        // Compute the model transform of every cube into the view's instance buffer, which the frame's previous commands
+        // are done reading, or have the cull shader compute those of the visible ones, before the render pass.
+        view.pose = layerViews[0].pose;
+        if (m_indirectDraw) {
+            view.models.clear();
+            if (!cubes.empty()) {
+                RecordCull(cmdBuffer.buf, view, layerViews, cubes);
+            }
+        } else if (shareCount == 1) {
+            view.models.resize(cubes.size());
+            for (size_t i = 0; i < cubes.size(); ++i) {
+                XrMatrix4x4f_CreateTranslationRotationScale(&view.models[i], &cubes[i].Pose.position,
+                                                            &cubes[i].Pose.orientation, &cubes[i].Scale);
+            }
+            if (!cubes.empty()) {
+                instanceBuffer.Update(view.models.data(), (uint32_t)view.models.size());
+            }
+        } else {
+            view.models.resize(cubes.size());
+            instanceBuffer.Reserve((uint32_t)cubes.size());
+        }
 
         // Ensure depth is in the right layout
         swapchainContext->depthBuffer.TransitionLayout(&cmdBuffer, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
@@ -1623,69 +3422,146 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
         clearValues[0].color.float32[3] = m_clearColor[3];
         clearValues[1].depthStencil.depth = 1.0f;
         clearValues[1].depthStencil.stencil = 0;
-        VkRenderPassBeginInfo renderPassBeginInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
-        renderPassBeginInfo.clearValueCount = (uint32_t)clearValues.size();
-        renderPassBeginInfo.pClearValues = clearValues.data();
-
-        swapchainContext->BindRenderTarget(imageIndex, &renderPassBeginInfo);
-
-        vkCmdBeginRenderPass(cmdBuffer.buf, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-        vkCmdBindPipeline(cmdBuffer.buf, VK_PIPELINE_BIND_POINT_GRAPHICS, swapchainContext->pipe.pipe);
-
-        // Bind index and vertex buffers
-        vkCmdBindIndexBuffer(cmdBuffer.buf, m_drawBuffer.idxBuf, 0, VK_INDEX_TYPE_UINT16);
-        VkDeviceSize offset = 0;
-        vkCmdBindVertexBuffers(cmdBuffer.buf, 0, 1, &m_drawBuffer.vtxBuf, &offset);
-
-        // Compute the view-projection transform.
-        // Note all matrixes (including OpenXR's) are column-major, right-handed.
-        const auto& pose = layerView.pose;
-        XrMatrix4x4f proj;
-        XrMatrix4x4f_CreateProjectionFov(&proj, GRAPHICS_VULKAN, layerView.fov, 0.05f, 100.0f);
-        XrMatrix4x4f toView;
-        XrMatrix4x4f_CreateFromRigidTransform(&toView, &pose);
-        XrMatrix4x4f view;
-        XrMatrix4x4f_InvertRigidBody(&view, &toView);
-        XrMatrix4x4f vp;
-        XrMatrix4x4f_Multiply(&vp, &proj, &view);
 
-        // Render each cube
-        for (const Cube& cube : cubes) {
-            // Compute the model-view-projection transform and push it.
-            XrMatrix4x4f model;
-            XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-            XrMatrix4x4f mvp;
-            XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-            vkCmdPushConstants(cmdBuffer.buf, m_pipelineLayout.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mvp.m), &mvp.m[0]);
-
-            // Draw the cube.
-            vkCmdDrawIndexed(cmdBuffer.buf, m_drawBuffer.count.idx, 1, 0, 0, 0);
+        const uint32_t layer = layerViews[0].subImage.imageArrayIndex;
+        const RenderTarget* target = nullptr;
+        const RenderPipeline& renderPipeline =
+            oneLayer ? swapchainContext->BindLayerRenderTarget(imageIndex, layer, &target)
+                     : swapchainContext->BindRenderTarget(imageIndex, &target);
+        const VkExtent2D size = swapchainContext->size;
+
+        if (shareCount == 1) {
+            renderPipeline.rp.Begin(cmdBuffer.buf, *target, size, clearValues);
+            RecordDraw(cmdBuffer.buf, renderPipeline, layerViews, instanceBuffer, 0, (uint32_t)cubes.size(),
+                       m_indirectDraw ? view.indirect.args.buf : VK_NULL_HANDLE);
+        } else {
+            renderPipeline.rp.Begin(cmdBuffer.buf, *target, size, clearValues, true);
+            m_recordWorkers.Run(shareCount, [&](uint32_t share) {
+                const uint32_t first = (uint32_t)(cubes.size() * share / shareCount);
+                const uint32_t end = (uint32_t)(cubes.size() * (share + 1) / shareCount);
+                for (uint32_t i = first; i < end; ++i) {
+                    XrMatrix4x4f_CreateTranslationRotationScale(&view.models[i], &cubes[i].Pose.position,
+                                                                &cubes[i].Pose.orientation, &cubes[i].Scale);
+                }
+                instanceBuffer.Write(&view.models[first], first, end - first);
+
+                const VkCommandBuffer buf = frame.recordPools[share].Next();
+                renderPipeline.rp.BeginSecondary(buf, *target);
+                RecordDraw(buf, renderPipeline, layerViews, instanceBuffer, first, end - first);
+                CHECK_VKCMD(vkEndCommandBuffer(buf));
+                frame.recordedShares[share] = buf;
+            });
+            vkCmdExecuteCommands(cmdBuffer.buf, shareCount, frame.recordedShares.data());
         }
 
-        vkCmdEndRenderPass(cmdBuffer.buf);
+        renderPipeline.rp.End(cmdBuffer.buf);
+        m_frameTimer.EndView(cmdBuffer.buf, m_frameIndex);
 
-        cmdBuffer.End();
-        cmdBuffer.Exec(m_vkQueue);
+        if (ownFrame) {
+            EndFrame();
+        }
+    }
 
-#if defined(USE_MIRROR_WINDOW)
-        // Cycle the window's swapchain on the last view rendered
-        if (swapchainContext == &m_swapchainImageContexts.back()) {
-            m_swapchain.Acquire();
-            m_swapchain.Wait();
-            m_swapchain.Present(m_vkQueue);
+    // Records the cull shader over the cubes of a view, which writes the model transforms of the visible ones to the view's
+    // instance buffer and counts them into its indirect draw arguments, and the barrier the draw waits for them behind.  The
+    // host only copies the cubes as they are; all the work for each of them is on the GPU.
+    void RecordCull(VkCommandBuffer buf, ViewInstances& view, const std::vector<XrCompositionLayerProjectionView>& layerViews,
+                    const std::vector<Cube>& cubes) const {
+        static_assert(sizeof(Cube) == 10 * sizeof(float), "The cull shader reads each cube as 10 floats");
+        const uint32_t cubeCount = (uint32_t)cubes.size();
+        IndirectDraw& indirect = view.indirect;
+        memcpy(indirect.cubes.Reserve(sizeof(Cube) * cubeCount), cubes.data(), sizeof(Cube) * cubeCount);
+        view.buffer.Reserve(cubeCount);
+        auto args = static_cast<VkDrawIndexedIndirectCommand*>(indirect.args.Reserve(sizeof(VkDrawIndexedIndirectCommand)));
+        *args = {m_drawBuffer.count.idx, 0, 0, 0, 0};
+        indirect.UpdateSet(view.buffer);
+
+        // One frustum containing every view rendered at once, or one that keeps every cube if there is none.
+        std::array<XrPosef, MaxMultiviewCount> poses;
+        std::array<XrFovf, MaxMultiviewCount> fovs;
+        for (size_t i = 0; i < layerViews.size(); ++i) {
+            poses[i] = layerViews[i].pose;
+            fovs[i] = layerViews[i].fov;
+        }
+        CullPipeline::Constants constants{};
+        if (!XrPosef_CreateCombinedFrustumPlanes(constants.planes, poses.data(), fovs.data(), (uint32_t)layerViews.size())) {
+            for (XrVector4f& plane : constants.planes) {
+                plane = {0.0f, 0.0f, 0.0f, 1.0f};
+            }
         }
+        constants.cubeCount = cubeCount;
+
+        vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipeline.pipe);
+        vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipeline.layout, 0, 1, &indirect.set, 0, nullptr);
+        vkCmdPushConstants(buf, m_cullPipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(buf, (cubeCount + CullPipeline::GroupSize - 1) / CullPipeline::GroupSize, 1, 1);
+
+        VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr,
+                             0, nullptr);
+    }
+
+    // Records the draw of instances first to first + count - 1 of the instance buffer to every view, with all the state it
+    // needs, so that it can begin a secondary command buffer as well as follow the render pass begin in the primary one.
+    // With indirectArgs, the instance count is read from there instead, of up to count instances.
+    void RecordDraw(VkCommandBuffer buf, const RenderPipeline& renderPipeline,
+                    const std::vector<XrCompositionLayerProjectionView>& layerViews, const InstanceBuffer& instanceBuffer,
+                    uint32_t first, uint32_t count, VkBuffer indirectArgs = VK_NULL_HANDLE) const {
+        vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, renderPipeline.pipe.pipe);
+
+        // The views render to their image rect, which may be less than the whole image; every view of a frame has the same.
+        const XrRect2Di& rect = layerViews[0].subImage.imageRect;
+        const VkRect2D scissor = {{rect.offset.x, rect.offset.y}, {(uint32_t)rect.extent.width, (uint32_t)rect.extent.height}};
+#if defined(ORIGIN_BOTTOM_LEFT)
+        // Flipped view so origin is bottom-left like GL (requires VK_KHR_maintenance1)
+        const VkViewport viewport = {(float)rect.offset.x, (float)(rect.offset.y + rect.extent.height), (float)rect.extent.width,
+                                     -(float)rect.extent.height, 0.0f, 1.0f};
+#else
+        // Will invert y after projection
+        const VkViewport viewport = {(float)rect.offset.x, (float)rect.offset.y, (float)rect.extent.width,
+                                     (float)rect.extent.height, 0.0f, 1.0f};
 #endif
+        vkCmdSetViewport(buf, 0, 1, &viewport);
+        vkCmdSetScissor(buf, 0, 1, &scissor);
+
+        if (count > 0) {
+            // Bind index, vertex and instance buffers
+            vkCmdBindIndexBuffer(buf, m_drawBuffer.idxBuf, 0, VK_INDEX_TYPE_UINT16);
+            const std::array<VkBuffer, 2> vertexBuffers{m_drawBuffer.vtxBuf, instanceBuffer.buf};
+            const std::array<VkDeviceSize, 2> offsets{0, 0};
+            vkCmdBindVertexBuffers(buf, 0, (uint32_t)vertexBuffers.size(), vertexBuffers.data(), offsets.data());
+
+            // Push the view-projection transform of each view.
+            // Note all matrixes (including OpenXR's) are column-major, right-handed.
+            std::array<XrMatrix4x4f, MaxMultiviewCount> viewProjections;
+            for (size_t view = 0; view < layerViews.size(); ++view) {
+                XrMatrix4x4f_CreateViewProjectionFromPoseFov(&viewProjections[view], GRAPHICS_VULKAN, &layerViews[view].pose,
+                                                             layerViews[view].fov, 0.05f, 100.0f);
+            }
+            vkCmdPushConstants(buf, m_pipelineLayout.layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                               (uint32_t)(layerViews.size() * sizeof(XrMatrix4x4f)), viewProjections.data());
+
+            // Draw the cubes, to every view.
+            if (indirectArgs != VK_NULL_HANDLE) {
+                vkCmdDrawIndexedIndirect(buf, indirectArgs, 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+            } else {
+                vkCmdDrawIndexed(buf, m_drawBuffer.count.idx, count, 0, 0, first);
+            }
+        }
     }
 
-    uint32_t GetSupportedSwapchainSampleCount(const XrViewConfigurationView&) override { return VK_SAMPLE_COUNT_1_BIT; }
-
-    void UpdateOptions(const std::shared_ptr<Options>& options) override { m_clearColor = options->GetBackgroundClearColor(); }
+    // Declared first, so they outlive the swapchain image contexts that use them.
+    MemoryAllocator m_memAllocator{};
+    PipelineCache m_pipelineCache{};
+    std::map<std::pair<VkFormat, uint32_t>, RenderPipeline> m_renderPipelines;
+    std::unique_ptr<RenderPipeline> m_motionVectorRenderPipeline;
 
-   protected:
     XrGraphicsBindingVulkan2KHR m_graphicsBinding{XR_TYPE_GRAPHICS_BINDING_VULKAN2_KHR};
     std::list<SwapchainImageContext> m_swapchainImageContexts;
-    std::map<const XrSwapchainImageBaseHeader*, SwapchainImageContext*> m_swapchainImageContextMap;
+    const SwapchainImageContext* m_mirrorSwapchainImageContext{nullptr};  // The last color swapchain's, of the last view
 
     VkInstance m_vkInstance{VK_NULL_HANDLE};
     VkPhysicalDevice m_vkPhysicalDevice{VK_NULL_HANDLE};
@@ -1695,12 +3571,37 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
     VkQueue m_vkQueue{VK_NULL_HANDLE};
     VkSemaphore m_vkDrawDone{VK_NULL_HANDLE};
 
-    MemoryAllocator m_memAllocator{};
     ShaderProgram m_shaderProgram{};
+    ShaderProgram m_multiviewShaderProgram{};
+    ShaderProgram m_motionVectorShaderProgram{};
+    bool m_multiviewSupported{false};
+    bool m_dynamicRenderingSupported{false};
+    DynamicRendering m_dynamicRendering{};
+    bool m_queueTimelineSupported{false};
+    QueueTimeline m_queueTimeline{};  // Declared before the command buffers that signal it
     CmdBuffer m_cmdBuffer{};
+    std::array<FrameResources, FramesInFlight> m_frames;
+    uint32_t m_frameIndex{0};
+    bool m_frameInProgress{false};
+    FrameTimer m_frameTimer{};
+    double m_gpuFrameTime{0};  // Milliseconds
+    bool m_gpuFrameTimeAvailable{false};
+    std::array<double, MaxTimedViews> m_gpuViewTimes{};  // Milliseconds, of the views of m_gpuFrameTime
+    uint32_t m_gpuViewTimeCount{0};
     PipelineLayout m_pipelineLayout{};
     VertexBuffer<Geometry::Vertex> m_drawBuffer{};
     std::array<float, 4> m_clearColor;
+    std::string m_cacheDirectory;
+
+    // With Options::RecordThreads, the threads that record shares of the cubes of a view alongside the rendering thread, each
+    // share at least this many cubes.
+    static constexpr size_t MinCubesPerShare = 256;
+    uint32_t m_recordThreads{0};
+    RecordWorkers m_recordWorkers;
+
+    // With Options::IndirectDraw, the cubes are culled and their transforms computed by this, and drawn indirectly.
+    bool m_indirectDraw{false};
+    CullPipeline m_cullPipeline{};
 
 #if defined(USE_MIRROR_WINDOW)
     Swapchain m_swapchain{};
@@ -1783,6 +3684,9 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
             flagNames += "PERF:";
             level = Log::Level::Warning;
         }
+        if (!Log::IsEnabled(level)) {
+            return VK_FALSE;
+        }
 
         uint64_t object = 0;
         // skip loader messages about device extensions
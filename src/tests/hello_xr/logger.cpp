@@ -14,20 +14,12 @@
 #include <sstream>
 
 namespace {
-Log::Level g_minSeverity{Log::Level::Info};
-std::mutex g_logLock;
-}  // namespace
-
-namespace Log {
-void SetLevel(Level minSeverity) { g_minSeverity = minSeverity; }
-
-void Write(Level severity, const std::string& msg) {
-    if (severity < g_minSeverity) {
-        return;
-    }
+// Format and write one line.  Only called by the log thread, or by a writer of a message too long to queue once the
+// queue is drained, so the lock is normally uncontended.
+void WriteLine(Log::Level severity, std::chrono::system_clock::time_point time, const char* msg, size_t length) {
+    static std::mutex outputLock;
 
-    const auto now = std::chrono::system_clock::now();
-    const time_t now_time = std::chrono::system_clock::to_time_t(now);
+    const time_t now_time = std::chrono::system_clock::to_time_t(time);
     tm now_tm;
 #ifdef _WIN32
     localtime_s(&now_tm, &now_time);
@@ -35,28 +27,172 @@ void Write(Level severity, const std::string& msg) {
     localtime_r(&now_time, &now_tm);
 #endif
     // time_t only has second precision. Use the rounding error to get sub-second precision.
-    const auto secondRemainder = now - std::chrono::system_clock::from_time_t(now_time);
+    const auto secondRemainder = time - std::chrono::system_clock::from_time_t(now_time);
     const int64_t milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(secondRemainder).count();
 
-    static std::map<Level, const char*> severityName = {
-        {Level::Verbose, "Verbose"}, {Level::Info, "Info   "}, {Level::Warning, "Warning"}, {Level::Error, "Error  "}};
+    static const char* const severityName[] = {"Verbose", "Info   ", "Warning", "Error  "};
 
     std::ostringstream out;
     out.fill('0');
     out << "[" << std::setw(2) << now_tm.tm_hour << ":" << std::setw(2) << now_tm.tm_min << ":" << std::setw(2) << now_tm.tm_sec
         << "." << std::setw(3) << milliseconds << "]"  // force code wrap
-        << "[" << severityName[severity] << "] " << msg << std::endl;
+        << "[" << severityName[static_cast<int>(severity)] << "] ";
+    out.write(msg, length);
+    out << std::endl;
 
-    std::lock_guard<std::mutex> lock(g_logLock);  // Ensure output is serialized
-    ((severity == Level::Error) ? std::clog : std::cout) << out.str();
+    std::lock_guard<std::mutex> lock(outputLock);  // Ensure output is serialized
+    ((severity == Log::Level::Error) ? std::clog : std::cout) << out.str();
 #if defined(_WIN32)
     OutputDebugStringA(out.str().c_str());
 #endif
 #if defined(ANDROID)
-    if (severity == Level::Error)
+    if (severity == Log::Level::Error)
         ALOGE("%s", out.str().c_str());
     else
         ALOGV("%s", out.str().c_str());
 #endif
 }
+
+// A bounded multiple-producer, single-consumer queue of messages, written out by its own thread.  A producer claims a
+// slot with a compare-and-swap on the enqueue position and publishes it through the slot's sequence number, so queuing
+// a message takes no lock and does not allocate.  Only a full queue makes a producer wait, for the log thread to catch up.
+class LogQueue {
+   public:
+    static constexpr size_t SlotCount = 256;
+    static constexpr size_t MessageCapacity = 512;
+
+    LogQueue() {
+        for (size_t i = 0; i < SlotCount; i++) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_thread = std::thread(&LogQueue::Run, this);
+    }
+
+    // Write the queued messages, then stop the log thread.
+    ~LogQueue() {
+        m_stop.store(true);
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+    LogQueue(const LogQueue&) = delete;
+    LogQueue& operator=(const LogQueue&) = delete;
+    LogQueue(LogQueue&&) = delete;
+    LogQueue& operator=(LogQueue&&) = delete;
+
+    // Queue the message and return its position, or write it right away, after every message queued before it, if it is
+    // too long for a slot.
+    uint64_t Push(Log::Level severity, const std::string& msg) {
+        const std::chrono::system_clock::time_point time = std::chrono::system_clock::now();
+        if (msg.size() > MessageCapacity) {
+            const uint64_t position = m_enqueuePosition.load(std::memory_order_acquire);
+            WaitUntilWritten(position);
+            WriteLine(severity, time, msg.data(), msg.size());
+            return position;
+        }
+
+        uint64_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &m_slots[position % SlotCount];
+            const int64_t lag = (int64_t)(slot->sequence.load(std::memory_order_acquire) - position);
+            if (lag == 0) {
+                if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                // The slot still holds the message from SlotCount positions back.
+                m_wake.notify_one();
+                std::this_thread::yield();
+                position = m_enqueuePosition.load(std::memory_order_relaxed);
+            } else {
+                position = m_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->severity = severity;
+        slot->time = time;
+        slot->length = msg.size();
+        memcpy(slot->text, msg.data(), msg.size());
+        slot->sequence.store(position + 1, std::memory_order_release);
+        m_wake.notify_one();
+        return position + 1;
+    }
+
+    // Wait for the log thread to write every message queued before the position.
+    void WaitUntilWritten(uint64_t position) {
+        while (m_dequeuePosition.load(std::memory_order_acquire) < position) {
+            m_wake.notify_one();
+            std::this_thread::yield();
+        }
+    }
+
+   private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        Log::Level severity{Log::Level::Info};
+        std::chrono::system_clock::time_point time;
+        size_t length{0};
+        char text[MessageCapacity];
+    };
+
+    // Write the next message if it has been queued.
+    bool Pop() {
+        const uint64_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[position % SlotCount];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+        WriteLine(slot.severity, slot.time, slot.text, slot.length);
+        slot.sequence.store(position + SlotCount, std::memory_order_release);
+        m_dequeuePosition.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    void Run() {
+        for (;;) {
+            while (Pop()) {
+            }
+            if (m_stop.load()) {
+                while (Pop()) {
+                }
+                return;
+            }
+            // A producer notifies without the mutex, so its wakeup can be missed; the timeout bounds the delay then.
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(100));
+        }
+    }
+
+    std::array<Slot, SlotCount> m_slots;
+    std::atomic<uint64_t> m_enqueuePosition{0};
+    std::atomic<uint64_t> m_dequeuePosition{0};
+    std::atomic<bool> m_stop{false};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::thread m_thread;
+};
+
+LogQueue& GetLogQueue() {
+    static LogQueue queue;
+    return queue;
+}
+}  // namespace
+
+namespace Log {
+std::atomic<Level> g_minSeverity{Level::Info};
+
+void SetLevel(Level minSeverity) { g_minSeverity.store(minSeverity, std::memory_order_relaxed); }
+
+void Write(Level severity, const std::string& msg) {
+    if (!IsEnabled(severity)) {
+        return;
+    }
+
+    LogQueue& queue = GetLogQueue();
+    const uint64_t position = queue.Push(severity, msg);
+    if (severity == Level::Error) {
+        queue.WaitUntilWritten(position);
+    }
+}
 }  // namespace Log
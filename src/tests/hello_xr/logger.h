@@ -4,9 +4,46 @@
 
 #pragma once
 
+// Messages below this level, as the integer value of a Log::Level, are never written, and the checks for them compile
+// to false.  By default every level can be enabled at run time.
+#ifndef HELLO_XR_MIN_LOG_LEVEL
+#define HELLO_XR_MIN_LOG_LEVEL 0
+#endif
+
 namespace Log {
 enum class Level { Verbose, Info, Warning, Error };
 
+extern std::atomic<Level> g_minSeverity;
+
+// Whether a message of this severity would be written.  Check it before formatting a message that is not always written.
+inline bool IsEnabled(Level severity) {
+    return static_cast<int>(severity) >= HELLO_XR_MIN_LOG_LEVEL && severity >= g_minSeverity.load(std::memory_order_relaxed);
+}
+
 void SetLevel(Level minSeverity);
+
+// Queue the message for the log thread, which timestamps and writes it.  Queuing takes no lock; an error message is also
+// waited for, so it is written before anything that follows it, like the program exiting.
 void Write(Level severity, const std::string& msg);
+
+// Let a message that may repeat every frame through at most once per interval.  For use by a single thread.
+class RateLimit {
+   public:
+    explicit RateLimit(std::chrono::milliseconds interval) : m_interval(interval) {}
+
+    bool Allow() {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (m_allowed && now - m_last < m_interval) {
+            return false;
+        }
+        m_allowed = true;
+        m_last = now;
+        return true;
+    }
+
+   private:
+    const std::chrono::milliseconds m_interval;
+    std::chrono::steady_clock::time_point m_last;
+    bool m_allowed{false};
+};
 }  // namespace Log
@@ -22,12 +22,46 @@ __declspec(dllexport) DWORD AmdPowerXpressRequestHighPerformance = 0x00000001;
 
 namespace {
 
+uint32_t ParseCount(const std::string& value) {
+    char* end = nullptr;
+    const unsigned long count = strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || count > UINT32_MAX) {
+        throw std::invalid_argument(Fmt("Invalid count '%s'", value.c_str()));
+    }
+    return (uint32_t)count;
+}
+
+float ParseScale(const std::string& value) {
+    char* end = nullptr;
+    const float scale = strtof(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || !(scale > 0.0f && scale <= 1.0f)) {
+        throw std::invalid_argument(Fmt("Invalid scale '%s', it must be in (0, 1]", value.c_str()));
+    }
+    return scale;
+}
+
 #ifdef XR_USE_PLATFORM_ANDROID
 void ShowHelp() {
     Log::Write(Log::Level::Info, "adb shell setprop debug.xr.graphicsPlugin OpenGLES|Vulkan");
     Log::Write(Log::Level::Info, "adb shell setprop debug.xr.formFactor Hmd|Handheld");
     Log::Write(Log::Level::Info, "adb shell setprop debug.xr.viewConfiguration Stereo|Mono");
     Log::Write(Log::Level::Info, "adb shell setprop debug.xr.blendMode Opaque|Additive|AlphaBlend");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.multiview true|false");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.textureArray true|false");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.renderThread true|false");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.benchmarkCubes <Cube count>");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.benchmarkFrames <Frame count>");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.lateLatch true|false");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.cull true|false");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.renderScale <Scale>");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.dynamicResolution true|false");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.lowBandwidth true|false");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.submitDepth true|false");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.spaceWarp true|false");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.recordThreads <Thread count>");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.indirectDraw true|false");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.hud true|false");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.performanceLevel Default|PowerSavings|SustainedLow|SustainedHigh|Boost");
 }
 
 bool UpdateOptionsFromSystemProperties(Options& options) {
@@ -54,7 +88,71 @@ bool UpdateOptionsFromSystemProperties(Options& options) {
         options.EnvironmentBlendMode = value;
     }
 
+    if (__system_property_get("debug.xr.multiview", value) != 0) {
+        options.Multiview = EqualsIgnoreCase(value, "true");
+    }
+
+    if (__system_property_get("debug.xr.textureArray", value) != 0) {
+        options.TextureArray = EqualsIgnoreCase(value, "true");
+    }
+
+    if (__system_property_get("debug.xr.renderThread", value) != 0) {
+        options.RenderThread = EqualsIgnoreCase(value, "true");
+    }
+
+    if (__system_property_get("debug.xr.lateLatch", value) != 0) {
+        options.LateLatch = EqualsIgnoreCase(value, "true");
+    }
+
+    if (__system_property_get("debug.xr.cull", value) != 0) {
+        options.Cull = EqualsIgnoreCase(value, "true");
+    }
+
+    if (__system_property_get("debug.xr.dynamicResolution", value) != 0) {
+        options.DynamicResolution = EqualsIgnoreCase(value, "true");
+    }
+
+    if (__system_property_get("debug.xr.lowBandwidth", value) != 0) {
+        options.LowBandwidth = EqualsIgnoreCase(value, "true");
+    }
+
+    if (__system_property_get("debug.xr.submitDepth", value) != 0) {
+        options.SubmitDepth = EqualsIgnoreCase(value, "true");
+    }
+
+    if (__system_property_get("debug.xr.spaceWarp", value) != 0) {
+        options.SpaceWarp = EqualsIgnoreCase(value, "true");
+    }
+
+    if (__system_property_get("debug.xr.indirectDraw", value) != 0) {
+        options.IndirectDraw = EqualsIgnoreCase(value, "true");
+    }
+
+    if (__system_property_get("debug.xr.hud", value) != 0) {
+        options.Hud = EqualsIgnoreCase(value, "true");
+    }
+
+    if (__system_property_get("debug.xr.performanceLevel", value) != 0) {
+        options.PerformanceLevel = value;
+    }
+
     try {
+        if (__system_property_get("debug.xr.benchmarkCubes", value) != 0) {
+            options.BenchmarkCubes = ParseCount(value);
+        }
+
+        if (__system_property_get("debug.xr.benchmarkFrames", value) != 0) {
+            options.BenchmarkFrames = ParseCount(value);
+        }
+
+        if (__system_property_get("debug.xr.renderScale", value) != 0) {
+            options.RenderScale = ParseScale(value);
+        }
+
+        if (__system_property_get("debug.xr.recordThreads", value) != 0) {
+            options.RecordThreads = ParseCount(value);
+        }
+
         options.ParseStrings();
     } catch (std::invalid_argument& ia) {
         Log::Write(Log::Level::Error, ia.what());
@@ -68,12 +166,33 @@ void ShowHelp() {
     // TODO: Improve/update when things are more settled.
     Log::Write(Log::Level::Info,
                "HelloXr --graphics|-g <Graphics API> [--formfactor|-ff <Form factor>] [--viewconfig|-vc <View config>] "
-               "[--blendmode|-bm <Blend mode>] [--space|-s <Space>] [--verbose|-v]");
+               "[--blendmode|-bm <Blend mode>] [--space|-s <Space>] [--multiview|-mv] [--texturearray|-ta] "
+               "[--renderthread|-rt] [--benchmark|-bench <Cube count>] [--benchmarkframes|-bf <Frame count>] [--latelatch|-ll] "
+               "[--renderscale|-rs <Scale>] [--lowbandwidth|-lb] [--submitdepth|-sd] [--spacewarp|-sw] "
+               "[--cachedir|-cd <Directory>] [--verbose|-v]");
     Log::Write(Log::Level::Info, "Graphics APIs:            D3D11, D3D12, OpenGLES, OpenGL, Vulkan2, Vulkan, Metal");
     Log::Write(Log::Level::Info, "Form factors:             Hmd, Handheld");
     Log::Write(Log::Level::Info, "View configurations:      Mono, Stereo");
     Log::Write(Log::Level::Info, "Environment blend modes:  Opaque, Additive, AlphaBlend");
+    Log::Write(Log::Level::Info, "Performance levels:       Default, PowerSavings, SustainedLow, SustainedHigh, Boost");
     Log::Write(Log::Level::Info, "Spaces:                   View, Local, Stage");
+    Log::Write(Log::Level::Info, "--multiview:              Render both stereo views in one pass (Vulkan, Vulkan2)");
+    Log::Write(Log::Level::Info, "--texturearray:           Render the views to the layers of one swapchain");
+    Log::Write(Log::Level::Info, "--renderthread:           Render and submit frames on their own thread (not OpenGL, OpenGLES)");
+    Log::Write(Log::Level::Info, "--benchmark:              Render this many cubes and log the frame times, then exit");
+    Log::Write(Log::Level::Info, "--benchmarkframes:        Frames to run with --benchmark (1000 by default)");
+    Log::Write(Log::Level::Info, "--latelatch:              Locate views again before submitting frames (D3D12, Metal, Vulkan)");
+    Log::Write(Log::Level::Info, "--cull:                   Draw only the cubes that may be inside the views");
+    Log::Write(Log::Level::Info, "--renderscale:            Scale the recommended view size by this, at most 1");
+    Log::Write(Log::Level::Info, "--dynamicres:             Render less of each view while the GPU is over budget");
+    Log::Write(Log::Level::Info, "--lowbandwidth:           Prefer the smallest color formats, and no multisampling");
+    Log::Write(Log::Level::Info, "--submitdepth:            Submit depth for reprojection, if the runtime can (D3D11, OpenGL)");
+    Log::Write(Log::Level::Info, "--spacewarp:              Submit motion vectors to synthesize frames from (Vulkan)");
+    Log::Write(Log::Level::Info, "--recordthreads:          Also record the draws on this many threads (Vulkan, Vulkan2)");
+    Log::Write(Log::Level::Info, "--indirect:               Cull the cubes and draw them from the GPU (D3D12, Vulkan, Vulkan2)");
+    Log::Write(Log::Level::Info, "--hud:                    Show the render scale on a quad layer, rendered when it changes");
+    Log::Write(Log::Level::Info, "--perflevel:              Request a CPU and GPU performance level from the runtime");
+    Log::Write(Log::Level::Info, "--cachedir:               Keep the pipeline cache in this directory (Vulkan, Vulkan2)");
 }
 
 bool UpdateOptionsFromCommandLine(Options& options, int argc, char* argv[]) {
@@ -99,6 +218,40 @@ bool UpdateOptionsFromCommandLine(Options& options, int argc, char* argv[]) {
             options.EnvironmentBlendMode = getNextArg();
         } else if (EqualsIgnoreCase(arg, "--space") || EqualsIgnoreCase(arg, "-s")) {
             options.AppSpace = getNextArg();
+        } else if (EqualsIgnoreCase(arg, "--multiview") || EqualsIgnoreCase(arg, "-mv")) {
+            options.Multiview = true;
+        } else if (EqualsIgnoreCase(arg, "--texturearray") || EqualsIgnoreCase(arg, "-ta")) {
+            options.TextureArray = true;
+        } else if (EqualsIgnoreCase(arg, "--renderthread") || EqualsIgnoreCase(arg, "-rt")) {
+            options.RenderThread = true;
+        } else if (EqualsIgnoreCase(arg, "--benchmark") || EqualsIgnoreCase(arg, "-bench")) {
+            options.BenchmarkCubes = ParseCount(getNextArg());
+        } else if (EqualsIgnoreCase(arg, "--benchmarkframes") || EqualsIgnoreCase(arg, "-bf")) {
+            options.BenchmarkFrames = ParseCount(getNextArg());
+        } else if (EqualsIgnoreCase(arg, "--latelatch") || EqualsIgnoreCase(arg, "-ll")) {
+            options.LateLatch = true;
+        } else if (EqualsIgnoreCase(arg, "--cull") || EqualsIgnoreCase(arg, "-cu")) {
+            options.Cull = true;
+        } else if (EqualsIgnoreCase(arg, "--renderscale") || EqualsIgnoreCase(arg, "-rs")) {
+            options.RenderScale = ParseScale(getNextArg());
+        } else if (EqualsIgnoreCase(arg, "--dynamicres") || EqualsIgnoreCase(arg, "-dr")) {
+            options.DynamicResolution = true;
+        } else if (EqualsIgnoreCase(arg, "--lowbandwidth") || EqualsIgnoreCase(arg, "-lb")) {
+            options.LowBandwidth = true;
+        } else if (EqualsIgnoreCase(arg, "--submitdepth") || EqualsIgnoreCase(arg, "-sd")) {
+            options.SubmitDepth = true;
+        } else if (EqualsIgnoreCase(arg, "--spacewarp") || EqualsIgnoreCase(arg, "-sw")) {
+            options.SpaceWarp = true;
+        } else if (EqualsIgnoreCase(arg, "--recordthreads") || EqualsIgnoreCase(arg, "-rth")) {
+            options.RecordThreads = ParseCount(getNextArg());
+        } else if (EqualsIgnoreCase(arg, "--indirect") || EqualsIgnoreCase(arg, "-id")) {
+            options.IndirectDraw = true;
+        } else if (EqualsIgnoreCase(arg, "--hud") || EqualsIgnoreCase(arg, "-hud")) {
+            options.Hud = true;
+        } else if (EqualsIgnoreCase(arg, "--perflevel") || EqualsIgnoreCase(arg, "-pl")) {
+            options.PerformanceLevel = getNextArg();
+        } else if (EqualsIgnoreCase(arg, "--cachedir") || EqualsIgnoreCase(arg, "-cd")) {
+            options.CacheDirectory = getNextArg();
         } else if (EqualsIgnoreCase(arg, "--verbose") || EqualsIgnoreCase(arg, "-v")) {
             Log::SetLevel(Log::Level::Verbose);
         } else if (EqualsIgnoreCase(arg, "--help") || EqualsIgnoreCase(arg, "-h")) {
@@ -207,6 +360,7 @@ void android_main(struct android_app* app) {
         if (!UpdateOptionsFromSystemProperties(*options)) {
             return;
         }
+        options->CacheDirectory = app->activity->internalDataPath;
 
         std::shared_ptr<PlatformData> data = std::make_shared<PlatformData>();
         data->applicationVM = app->activity->vm;
@@ -298,14 +452,16 @@ int main(int argc, char* argv[]) {
 
         std::shared_ptr<PlatformData> data = std::make_shared<PlatformData>();
 
-        // Spawn a thread to wait for a keypress
+        // Spawn a thread to wait for a keypress.  A benchmark ends by itself, and may run without a console.
         static bool quitKeyPressed = false;
-        auto exitPollingThread = std::thread{[] {
-            Log::Write(Log::Level::Info, "Press any key to shutdown...");
-            (void)getchar();
-            quitKeyPressed = true;
-        }};
-        exitPollingThread.detach();
+        if (options->BenchmarkCubes == 0) {
+            auto exitPollingThread = std::thread{[] {
+                Log::Write(Log::Level::Info, "Press any key to shutdown...");
+                (void)getchar();
+                quitKeyPressed = true;
+            }};
+            exitPollingThread.detach();
+        }
 
         bool requestRestart = false;
         do {
@@ -327,24 +483,28 @@ int main(int argc, char* argv[]) {
             graphicsPlugin->UpdateOptions(options);
 
             program->InitializeDevice();
-            program->InitializeSession();
-            program->CreateSwapchains();
 
-            while (!quitKeyPressed) {
-                bool exitRenderLoop = false;
-                program->PollEvents(&exitRenderLoop, &requestRestart);
-                if (exitRenderLoop) {
-                    break;
+            // A lost session is started again with the same program, unless its instance or system is lost too.
+            do {
+                program->InitializeSession();
+                program->CreateSwapchains();
+
+                while (!quitKeyPressed) {
+                    bool exitRenderLoop = false;
+                    program->PollEvents(&exitRenderLoop, &requestRestart);
+                    if (exitRenderLoop) {
+                        break;
+                    }
+
+                    if (program->IsSessionRunning()) {
+                        program->PollActions();
+                        program->RenderFrame();
+                    } else {
+                        // Throttle loop since xrWaitFrame won't be called.
+                        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+                    }
                 }
-
-                if (program->IsSessionRunning()) {
-                    program->PollActions();
-                    program->RenderFrame();
-                } else {
-                    // Throttle loop since xrWaitFrame won't be called.
-                    std::this_thread::sleep_for(std::chrono::milliseconds(250));
-                }
-            }
+            } while (!quitKeyPressed && requestRestart && program->RestartSession());
 
         } while (!quitKeyPressed && requestRestart);
 
@@ -10,7 +10,11 @@
 #include "platformplugin.h"
 #include "graphicsplugin.h"
 #include "openxr_program.h"
+#include "action_state_snapshot.h"
+#include <common/allocation_counter.h>
+#include <common/xr_late_latch.hpp>
 #include <common/xr_linear.h>
+#include <common/xr_linear_constexpr.hpp>
 #include <array>
 #include <cmath>
 #include <set>
@@ -33,61 +37,320 @@ inline std::string GetXrVersionString(XrVersion ver) {
 
 namespace Math {
 namespace Pose {
-XrPosef Identity() {
-    XrPosef t{};
-    t.orientation.w = 1;
-    return t;
-}
+constexpr XrPosef Identity() { return XrLinear::CreateIdentityPose(); }
 
-XrPosef Translation(const XrVector3f& translation) {
-    XrPosef t = Identity();
-    t.position = translation;
-    return t;
-}
+constexpr XrPosef Translation(const XrVector3f& translation) { return XrPosef{XrLinear::CreateIdentityQuaternion(), translation}; }
 
-XrPosef RotateCCWAboutYAxis(float radians, XrVector3f translation) {
-    XrPosef t = Identity();
-    t.orientation.x = 0.f;
-    t.orientation.y = std::sin(radians * 0.5f);
-    t.orientation.z = 0.f;
-    t.orientation.w = std::cos(radians * 0.5f);
-    t.position = translation;
-    return t;
+constexpr XrPosef RotateCCWAboutYAxis(float radians, XrVector3f translation) {
+    return XrPosef{XrLinear::CreateQuaternionFromAxisAngle({0.f, 1.f, 0.f}, radians), translation};
 }
 }  // namespace Pose
 }  // namespace Math
 
+// The reference spaces that can be selected by name, with their poses computed at compile time.
+struct NamedReferenceSpace {
+    const char* name;
+    XrReferenceSpaceType referenceSpaceType;
+    XrPosef poseInReferenceSpace;
+};
+
+constexpr NamedReferenceSpace c_namedReferenceSpaces[] = {
+    {"View", XR_REFERENCE_SPACE_TYPE_VIEW, Math::Pose::Identity()},
+    // Render head-locked 2m in front of device.
+    {"ViewFront", XR_REFERENCE_SPACE_TYPE_VIEW, Math::Pose::Translation({0.f, 0.f, -2.f})},
+    {"Local", XR_REFERENCE_SPACE_TYPE_LOCAL, Math::Pose::Identity()},
+    {"Stage", XR_REFERENCE_SPACE_TYPE_STAGE, Math::Pose::Identity()},
+    {"StageLeft", XR_REFERENCE_SPACE_TYPE_STAGE, Math::Pose::RotateCCWAboutYAxis(0.f, {-2.f, 0.f, -2.f})},
+    {"StageRight", XR_REFERENCE_SPACE_TYPE_STAGE, Math::Pose::RotateCCWAboutYAxis(0.f, {2.f, 0.f, -2.f})},
+    {"StageLeftRotated", XR_REFERENCE_SPACE_TYPE_STAGE, Math::Pose::RotateCCWAboutYAxis(3.14f / 3.f, {-2.f, 0.5f, -2.f})},
+    {"StageRightRotated", XR_REFERENCE_SPACE_TYPE_STAGE, Math::Pose::RotateCCWAboutYAxis(-3.14f / 3.f, {2.f, 0.5f, -2.f})},
+};
+
 inline XrReferenceSpaceCreateInfo GetXrReferenceSpaceCreateInfo(const std::string& referenceSpaceTypeStr) {
-    XrReferenceSpaceCreateInfo referenceSpaceCreateInfo{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
-    referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::Identity();
-    if (EqualsIgnoreCase(referenceSpaceTypeStr, "View")) {
-        referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
-    } else if (EqualsIgnoreCase(referenceSpaceTypeStr, "ViewFront")) {
-        // Render head-locked 2m in front of device.
-        referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::Translation({0.f, 0.f, -2.f}),
-        referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
-    } else if (EqualsIgnoreCase(referenceSpaceTypeStr, "Local")) {
-        referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
-    } else if (EqualsIgnoreCase(referenceSpaceTypeStr, "Stage")) {
-        referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
-    } else if (EqualsIgnoreCase(referenceSpaceTypeStr, "StageLeft")) {
-        referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::RotateCCWAboutYAxis(0.f, {-2.f, 0.f, -2.f});
-        referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
-    } else if (EqualsIgnoreCase(referenceSpaceTypeStr, "StageRight")) {
-        referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::RotateCCWAboutYAxis(0.f, {2.f, 0.f, -2.f});
-        referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
-    } else if (EqualsIgnoreCase(referenceSpaceTypeStr, "StageLeftRotated")) {
-        referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::RotateCCWAboutYAxis(3.14f / 3.f, {-2.f, 0.5f, -2.f});
-        referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
-    } else if (EqualsIgnoreCase(referenceSpaceTypeStr, "StageRightRotated")) {
-        referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::RotateCCWAboutYAxis(-3.14f / 3.f, {2.f, 0.5f, -2.f});
-        referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
-    } else {
-        throw std::invalid_argument(Fmt("Unknown reference space type '%s'", referenceSpaceTypeStr.c_str()));
-    }
-    return referenceSpaceCreateInfo;
+    for (const NamedReferenceSpace& namedSpace : c_namedReferenceSpaces) {
+        if (EqualsIgnoreCase(referenceSpaceTypeStr, namedSpace.name)) {
+            XrReferenceSpaceCreateInfo referenceSpaceCreateInfo{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+            referenceSpaceCreateInfo.referenceSpaceType = namedSpace.referenceSpaceType;
+            referenceSpaceCreateInfo.poseInReferenceSpace = namedSpace.poseInReferenceSpace;
+            return referenceSpaceCreateInfo;
+        }
+    }
+    throw std::invalid_argument(Fmt("Unknown reference space type '%s'", referenceSpaceTypeStr.c_str()));
+}
+
+using Clock = std::chrono::steady_clock;
+
+inline double MillisecondsBetween(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
 }
 
+// The CPU times of a frame, in milliseconds.
+struct FrameTimes {
+    double wait{0};  // Blocked in xrWaitFrame
+    double cpu{0};   // The rest of the frame, from locating the cubes to xrEndFrame returning
+};
+
+// The frame times of a benchmark, in milliseconds.  Recording a frame allocates nothing: the samples only fill the
+// storage reserved by Reset, and a frame past its end is not recorded.
+class BenchmarkStats {
+   public:
+    void Reset(size_t frameCount) {
+        for (std::vector<double>* samples : {&m_waitTimes, &m_cpuTimes, &m_gpuTimes}) {
+            samples->clear();
+            samples->reserve(frameCount);
+        }
+        for (std::vector<double>& samples : m_gpuViewTimes) {
+            samples.clear();
+            samples.reserve(frameCount);
+        }
+    }
+
+    void RecordFrame(const FrameTimes& times) {
+        Record(m_waitTimes, times.wait);
+        Record(m_cpuTimes, times.cpu);
+    }
+
+    void RecordGpuFrame(double gpuTime) { Record(m_gpuTimes, gpuTime); }
+
+    void RecordGpuViews(const std::array<double, IGraphicsPlugin::MaxTimedViews>& gpuTimes, uint32_t viewCount) {
+        for (uint32_t view = 0; view < viewCount; ++view) {
+            Record(m_gpuViewTimes[view], gpuTimes[view]);
+        }
+    }
+
+    void Report(const std::string& graphicsPlugin, uint32_t cubeCount) const {
+        Log::Write(Log::Level::Info, Fmt("Benchmark: %s, %u cubes, %u frames", graphicsPlugin.c_str(), cubeCount,
+                                         (uint32_t)m_cpuTimes.size()));
+        ReportSamples("xrWaitFrame", m_waitTimes);
+        ReportSamples("CPU frame", m_cpuTimes);
+        if (m_gpuTimes.empty()) {
+            Log::Write(Log::Level::Info, "  GPU frame:    not measured by this graphics plugin");
+        } else {
+            ReportSamples("GPU frame", m_gpuTimes);
+        }
+        for (uint32_t view = 0; view < m_gpuViewTimes.size(); ++view) {
+            ReportSamples(Fmt("GPU view %u", view).c_str(), m_gpuViewTimes[view]);
+        }
+    }
+
+   private:
+    static void Record(std::vector<double>& samples, double sample) {
+        if (samples.size() < samples.capacity()) {
+            samples.push_back(sample);
+        }
+    }
+
+    static void ReportSamples(const char* name, std::vector<double> samples) {
+        if (samples.empty()) {
+            return;
+        }
+        std::sort(samples.begin(), samples.end());
+        auto percentile = [&](double p) { return samples[(size_t)(p / 100.0 * (samples.size() - 1) + 0.5)]; };
+        const double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+        Log::Write(Log::Level::Info, Fmt("  %-13s mean %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms",
+                                         (std::string(name) + ":").c_str(), mean, percentile(50), percentile(95),
+                                         percentile(99), samples.back()));
+    }
+
+    std::vector<double> m_waitTimes;
+    std::vector<double> m_cpuTimes;
+    std::vector<double> m_gpuTimes;
+    std::array<std::vector<double>, IGraphicsPlugin::MaxTimedViews> m_gpuViewTimes;  // Of the first views of the frames
+};
+
+// How much later late latching located the views of a frame than rendering it did, and how far the views had moved by
+// then: the part of the pose prediction that the frame no longer depends on.
+class LateLatchStats {
+   public:
+    void Reset() { *this = LateLatchStats{}; }
+
+    void RecordFrame(double milliseconds, const XrLateLatch::PoseDelta& moved) {
+        m_latchedFrames++;
+        m_totalMilliseconds += milliseconds;
+        m_maxMilliseconds = std::max(m_maxMilliseconds, milliseconds);
+        m_totalDistance += moved.distance;
+        m_maxDistance = std::max(m_maxDistance, (double)moved.distance);
+        m_totalAngle += moved.angle;
+        m_maxAngle = std::max(m_maxAngle, (double)moved.angle);
+    }
+
+    // A frame whose views could not be located again, so it kept the poses it was rendered with.
+    void RecordUnlatchedFrame() { m_unlatchedFrames++; }
+
+    void Report() const {
+        Log::Write(Log::Level::Info,
+                   Fmt("Late latching: %u frames latched, %u not", (uint32_t)m_latchedFrames, (uint32_t)m_unlatchedFrames));
+        if (m_latchedFrames == 0) {
+            return;
+        }
+        constexpr double DegreesPerRadian = 180.0 / MATH_PI;
+        Log::Write(Log::Level::Info, Fmt("  Views located again mean %.3f ms, max %.3f ms after rendering",
+                                         m_totalMilliseconds / m_latchedFrames, m_maxMilliseconds));
+        Log::Write(Log::Level::Info,
+                   Fmt("  Views moved by then mean %.2f mm, %.3f degrees, max %.2f mm, %.3f degrees",
+                       m_totalDistance / m_latchedFrames * 1000.0, m_totalAngle / m_latchedFrames * DegreesPerRadian,
+                       m_maxDistance * 1000.0, m_maxAngle * DegreesPerRadian));
+    }
+
+   private:
+    uint64_t m_latchedFrames{0};
+    uint64_t m_unlatchedFrames{0};
+    double m_totalMilliseconds{0};
+    double m_maxMilliseconds{0};
+    double m_totalDistance{0};  // Meters, of the view that moved the most
+    double m_maxDistance{0};
+    double m_totalAngle{0};  // Radians, of the view that rotated the most
+    double m_maxAngle{0};
+};
+
+// Scales the image rect of every view within its swapchain image, from the GPU times of the frames against the display
+// period, so the frame rate holds as the GPU load rises, without reallocating the swapchains.  A frame's GPU time arrives
+// a few frames late, so after each change the scale holds until the frames rendered at the new scale are measured.
+class RenderScaleController {
+   public:
+    static constexpr float MinScale = 0.5f;
+
+    void Reset() { *this = RenderScaleController{}; }
+
+    // The scale of the next frame, in [MinScale, 1], of the width and height of the swapchain images.
+    float Scale() const { return m_scale; }
+
+    // A size of the swapchain images scaled to the image rect of the next frame.
+    int32_t ScaleSize(int32_t size) const { return std::max((int32_t)std::lround(size * m_scale), 1); }
+
+    // Adjust the scale for the GPU time of a frame, in milliseconds, at the predicted display period of the frame.
+    void RecordGpuFrame(double milliseconds, XrDuration displayPeriod) {
+        m_frames++;
+        m_totalScale += m_scale;
+        m_lowestScale = std::min(m_lowestScale, m_scale);
+        if (displayPeriod <= 0) {
+            return;
+        }
+        if (m_holdFrames > 0) {
+            m_holdFrames--;
+            return;
+        }
+
+        // The GPU time of a frame is about that of its pixels, which go with the square of the scale.
+        const double budget = TargetLoad * displayPeriod / 1e6;
+        if (milliseconds > budget) {
+            SetScale(m_scale * (float)std::sqrt(budget / milliseconds));
+        } else if (milliseconds < GrowLoad * budget) {
+            SetScale(m_scale + GrowStep);
+        }
+    }
+
+    void Report() const {
+        Log::Write(Log::Level::Info, Fmt("Dynamic resolution: %u frames measured, %u scale changes", (uint32_t)m_frames,
+                                         (uint32_t)m_changes));
+        if (m_frames > 0) {
+            Log::Write(Log::Level::Info,
+                       Fmt("  Scale mean %.3f, lowest %.3f", m_totalScale / m_frames, (double)m_lowestScale));
+        }
+    }
+
+   private:
+    static constexpr double TargetLoad = 0.9;  // Of the display period, leaving room for the compositor
+    static constexpr double GrowLoad = 0.75;   // Of the target, below which the scale grows back
+    static constexpr float GrowStep = 0.02f;   // Grown slowly, so a frame is rarely over budget for it
+    static constexpr uint32_t HoldFrames = 4;  // About how late the plugins measure the GPU time of a frame
+
+    void SetScale(float scale) {
+        scale = std::min(std::max(scale, MinScale), 1.0f);
+        if (scale != m_scale) {
+            m_scale = scale;
+            m_changes++;
+            m_holdFrames = HoldFrames;
+            Log::Write(Log::Level::Verbose, Fmt("Render scale %.3f", (double)m_scale));
+        }
+    }
+
+    float m_scale{1.0f};
+    uint32_t m_holdFrames{0};
+    uint64_t m_frames{0};
+    uint64_t m_changes{0};
+    double m_totalScale{0};
+    float m_lowestScale{1.0f};
+};
+
+// A frame waited for on the simulation thread, for the render thread to begin, render and end.
+struct FrameSlot {
+    XrFrameState frameState{XR_TYPE_FRAME_STATE};
+    std::vector<Cube> cubes;
+    FrameTimes times;
+    // Instead of a frame, asks the render thread to exit.
+    bool stop{false};
+};
+
+// A single-producer, single-consumer ring of frame slots.  A slot changes hands through the atomic counters alone; the
+// mutex and condition variable are only used to park a thread that finds the ring full or empty, instead of spinning.
+class FrameSlotQueue {
+   public:
+    static constexpr uint32_t Capacity = 2;
+
+    // Empty, and no longer closed.  Not while either thread is using the queue.
+    void Reset() {
+        m_written.store(0);
+        m_read.store(0);
+        m_closed.store(false);
+    }
+
+    // Wait for the next slot to be free and return it for the producer to fill, or nullptr once the queue is closed.
+    FrameSlot* BeginWrite() {
+        const uint32_t written = m_written.load(std::memory_order_relaxed);
+        Wait([&] { return written - m_read.load(std::memory_order_acquire) < Capacity; });
+        return m_closed.load() ? nullptr : &m_slots[written % Capacity];
+    }
+
+    // Hand the slot from BeginWrite to the consumer.
+    void EndWrite() {
+        m_written.fetch_add(1, std::memory_order_release);
+        Notify();
+    }
+
+    // Wait for a filled slot and return it for the consumer, or nullptr once the queue is closed and empty.
+    const FrameSlot* BeginRead() {
+        const uint32_t read = m_read.load(std::memory_order_relaxed);
+        Wait([&] { return m_written.load(std::memory_order_acquire) != read; });
+        return m_written.load(std::memory_order_acquire) != read ? &m_slots[read % Capacity] : nullptr;
+    }
+
+    // Give the slot from BeginRead back to the producer.
+    void EndRead() {
+        m_read.fetch_add(1, std::memory_order_release);
+        Notify();
+    }
+
+    // Wake the waiting thread, and make every later wait return at once.
+    void Close() {
+        m_closed.store(true);
+        Notify();
+    }
+
+   private:
+    template <typename Ready>
+    void Wait(Ready ready) {
+        if (ready() || m_closed.load()) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [&] { return ready() || m_closed.load(); });
+    }
+
+    void Notify() {
+        // Taking the mutex orders the notification after a waiter's last check of its condition, so it is not lost.
+        { std::lock_guard<std::mutex> lock(m_mutex); }
+        m_condition.notify_one();
+    }
+
+    std::array<FrameSlot, Capacity> m_slots;
+    std::atomic<uint32_t> m_written{0};
+    std::atomic<uint32_t> m_read{0};
+    std::atomic<bool> m_closed{false};
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+};
+
 struct OpenXrProgram : IOpenXrProgram {
     OpenXrProgram(const std::shared_ptr<Options>& options, const std::shared_ptr<IPlatformPlugin>& platformPlugin,
                   const std::shared_ptr<IGraphicsPlugin>& graphicsPlugin)
@@ -98,32 +361,111 @@ struct OpenXrProgram : IOpenXrProgram {
                                  XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND} {}
 
     ~OpenXrProgram() override {
+        try {
+            StopRenderThread();
+        } catch (const std::exception& ex) {
+            Log::Write(Log::Level::Error, Fmt("Render thread failed: %s", ex.what()));
+        }
+
+        DestroySession();
+
         if (m_input.actionSet != XR_NULL_HANDLE) {
-            for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            xrDestroyActionSet(m_input.actionSet);
+        }
+
+        if (m_instance != XR_NULL_HANDLE) {
+            xrDestroyInstance(m_instance);
+        }
+    }
+
+    // Destroy the session and every handle created from it, and forget its swapchains and views.  The instance, the system,
+    // the action set and the graphics device are left for the next session.
+    void DestroySession() {
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            if (m_input.handSpace[hand] != XR_NULL_HANDLE) {
                 xrDestroySpace(m_input.handSpace[hand]);
+                m_input.handSpace[hand] = XR_NULL_HANDLE;
             }
-            xrDestroyActionSet(m_input.actionSet);
         }
 
         for (Swapchain swapchain : m_swapchains) {
             xrDestroySwapchain(swapchain.handle);
         }
+        m_swapchains.clear();
+        m_swapchainImages.clear();
+        m_layerImagesAcquired = false;
+        if (m_depthSwapchain.handle != XR_NULL_HANDLE) {
+            xrDestroySwapchain(m_depthSwapchain.handle);
+            m_depthSwapchain = {XR_NULL_HANDLE, 0, 0};
+        }
+        m_depthSwapchainImages.clear();
+        m_depthInfos.clear();
+        if (m_hudSwapchain.handle != XR_NULL_HANDLE) {
+            xrDestroySwapchain(m_hudSwapchain.handle);
+            m_hudSwapchain = {XR_NULL_HANDLE, 0, 0};
+        }
+        m_hudSwapchainImages.clear();
+        if (m_hudSpace != XR_NULL_HANDLE) {
+            xrDestroySpace(m_hudSpace);
+            m_hudSpace = XR_NULL_HANDLE;
+        }
+        m_hudReading = -1;
+        for (Swapchain* swapchain : {&m_motionVectorSwapchain, &m_spaceWarpDepthSwapchain}) {
+            if (swapchain->handle != XR_NULL_HANDLE) {
+                xrDestroySwapchain(swapchain->handle);
+                *swapchain = {XR_NULL_HANDLE, 0, 0};
+            }
+        }
+        m_motionVectorSwapchainImages.clear();
+        m_spaceWarpDepthSwapchainImages.clear();
+        m_spaceWarpInfos.clear();
+        m_previousCubes.clear();
 
         for (XrSpace visualizedSpace : m_visualizedSpaces) {
             xrDestroySpace(visualizedSpace);
         }
+        m_visualizedSpaces.clear();
 
         if (m_appSpace != XR_NULL_HANDLE) {
             xrDestroySpace(m_appSpace);
+            m_appSpace = XR_NULL_HANDLE;
         }
 
         if (m_session != XR_NULL_HANDLE) {
             xrDestroySession(m_session);
+            m_session = XR_NULL_HANDLE;
         }
 
-        if (m_instance != XR_NULL_HANDLE) {
-            xrDestroyInstance(m_instance);
+        m_configViews.clear();
+        m_views.clear();
+        m_latchedViews.clear();
+        m_sessionState = XR_SESSION_STATE_UNKNOWN;
+        m_sessionRunning = false;
+    }
+
+    bool RestartSession() override {
+        if (m_instanceLost) {
+            return false;
+        }
+
+        StopRenderThread();
+        m_graphicsPlugin->ReleaseSwapchainImages();
+        DestroySession();
+
+        // The runtime may take a while to make the system available again, or may replace it, and a session of another
+        // system needs another device.
+        XrSystemGetInfo systemInfo{XR_TYPE_SYSTEM_GET_INFO};
+        systemInfo.formFactor = m_options->Parsed.FormFactor;
+        XrSystemId systemId = XR_NULL_SYSTEM_ID;
+        const XrResult result = xrGetSystem(m_instance, &systemInfo, &systemId);
+        if (XR_FAILED(result) || systemId != m_systemId) {
+            Log::Write(Log::Level::Warning, Fmt("The system changed or is not available (%s), restarting the whole program",
+                                                to_string(result)));
+            return false;
         }
+
+        Log::Write(Log::Level::Info, "Restarting the session with the same instance and graphics device");
+        return true;
     }
 
     static void LogLayersAndExtensions() {
@@ -187,6 +529,55 @@ struct OpenXrProgram : IOpenXrProgram {
         std::transform(graphicsExtensions.begin(), graphicsExtensions.end(), std::back_inserter(extensions),
                        [](const std::string& ext) { return ext.c_str(); });
 
+        // Locate all the spaces of a frame at once when the runtime can.
+        uint32_t runtimeExtensionCount;
+        CHECK_XRCMD(xrEnumerateInstanceExtensionProperties(nullptr, 0, &runtimeExtensionCount, nullptr));
+        std::vector<XrExtensionProperties> runtimeExtensions(runtimeExtensionCount, {XR_TYPE_EXTENSION_PROPERTIES});
+        CHECK_XRCMD(xrEnumerateInstanceExtensionProperties(nullptr, (uint32_t)runtimeExtensions.size(), &runtimeExtensionCount,
+                                                           runtimeExtensions.data()));
+        const auto runtimeSupports = [&runtimeExtensions](const char* extensionName) {
+            return std::any_of(runtimeExtensions.begin(), runtimeExtensions.end(),
+                               [extensionName](const XrExtensionProperties& extension) {
+                                   return strcmp(extension.extensionName, extensionName) == 0;
+                               });
+        };
+        const bool locateSpacesSupported = runtimeSupports(XR_KHR_LOCATE_SPACES_EXTENSION_NAME);
+        if (locateSpacesSupported) {
+            extensions.push_back(XR_KHR_LOCATE_SPACES_EXTENSION_NAME);
+        }
+
+        // Submit depth only when asked to, since rendering to depth swapchains is not free.
+        m_depthExtensionEnabled = m_options->SubmitDepth && runtimeSupports(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
+        if (m_depthExtensionEnabled) {
+            extensions.push_back(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
+        } else if (m_options->SubmitDepth) {
+            Log::Write(Log::Level::Warning, "The runtime does not support XR_KHR_composition_layer_depth, not submitting depth");
+        }
+
+        m_spaceWarpExtensionEnabled = m_options->SpaceWarp && runtimeSupports(XR_FB_SPACE_WARP_EXTENSION_NAME);
+        if (m_spaceWarpExtensionEnabled) {
+            extensions.push_back(XR_FB_SPACE_WARP_EXTENSION_NAME);
+        } else if (m_options->SpaceWarp) {
+            Log::Write(Log::Level::Warning, "The runtime does not support XR_FB_space_warp, not submitting motion vectors");
+        }
+
+        // Request a performance level only when asked to.
+        const bool perfSettingsEnabled = m_options->Parsed.PerformanceLevel != XR_PERF_SETTINGS_LEVEL_MAX_ENUM_EXT &&
+                                         runtimeSupports(XR_EXT_PERFORMANCE_SETTINGS_EXTENSION_NAME);
+        if (perfSettingsEnabled) {
+            extensions.push_back(XR_EXT_PERFORMANCE_SETTINGS_EXTENSION_NAME);
+        } else if (m_options->Parsed.PerformanceLevel != XR_PERF_SETTINGS_LEVEL_MAX_ENUM_EXT) {
+            Log::Write(Log::Level::Warning, "The runtime does not support XR_EXT_performance_settings, not setting the level");
+        }
+
+#if defined(XR_USE_PLATFORM_ANDROID)
+        // Tell the runtime which threads make the frames when it can.
+        const bool threadSettingsSupported = runtimeSupports(XR_KHR_ANDROID_THREAD_SETTINGS_EXTENSION_NAME);
+        if (threadSettingsSupported) {
+            extensions.push_back(XR_KHR_ANDROID_THREAD_SETTINGS_EXTENSION_NAME);
+        }
+#endif
+
         XrInstanceCreateInfo createInfo{XR_TYPE_INSTANCE_CREATE_INFO};
         createInfo.next = m_platformPlugin->GetInstanceCreateExtension();
         createInfo.enabledExtensionCount = (uint32_t)extensions.size();
@@ -198,6 +589,21 @@ struct OpenXrProgram : IOpenXrProgram {
         createInfo.applicationInfo.apiVersion = XR_API_VERSION_1_0;
 
         CHECK_XRCMD(xrCreateInstance(&createInfo, &m_instance));
+
+        if (locateSpacesSupported) {
+            CHECK_XRCMD(xrGetInstanceProcAddr(m_instance, "xrLocateSpacesKHR",
+                                              reinterpret_cast<PFN_xrVoidFunction*>(&m_xrLocateSpacesKHR)));
+        }
+        if (perfSettingsEnabled) {
+            CHECK_XRCMD(xrGetInstanceProcAddr(m_instance, "xrPerfSettingsSetPerformanceLevelEXT",
+                                              reinterpret_cast<PFN_xrVoidFunction*>(&m_xrPerfSettingsSetPerformanceLevelEXT)));
+        }
+#if defined(XR_USE_PLATFORM_ANDROID)
+        if (threadSettingsSupported) {
+            CHECK_XRCMD(xrGetInstanceProcAddr(m_instance, "xrSetAndroidApplicationThreadKHR",
+                                              reinterpret_cast<PFN_xrVoidFunction*>(&m_xrSetAndroidApplicationThreadKHR)));
+        }
+#endif
     }
 
     void CreateInstance() override {
@@ -335,11 +741,18 @@ struct OpenXrProgram : IOpenXrProgram {
         XrAction vibrateAction{XR_NULL_HANDLE};
         XrAction quitAction{XR_NULL_HANDLE};
         std::array<XrPath, Side::COUNT> handSubactionPath;
-        std::array<XrSpace, Side::COUNT> handSpace;
+        std::array<XrSpace, Side::COUNT> handSpace{};
         std::array<float, Side::COUNT> handScale = {{1.0f, 1.0f}};
         std::array<XrBool32, Side::COUNT> handActive;
+
+        // The action states of the current frame, and their slots in it.
+        ActionStateSnapshot states;
+        std::array<ActionStateSnapshot::Slot, Side::COUNT> grabState;
+        std::array<ActionStateSnapshot::Slot, Side::COUNT> poseState;
+        ActionStateSnapshot::Slot quitState{0};
     };
 
+    // The action set, its actions and their suggested bindings belong to the instance, and are created with the first session.
     void InitializeActions() {
         // Create an action set.
         {
@@ -392,6 +805,13 @@ struct OpenXrProgram : IOpenXrProgram {
             CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.quitAction));
         }
 
+        // Register the states PollActions reads each frame.
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            m_input.grabState[hand] = m_input.states.AddFloat(m_input.grabAction, m_input.handSubactionPath[hand]);
+            m_input.poseState[hand] = m_input.states.AddPose(m_input.poseAction, m_input.handSubactionPath[hand]);
+        }
+        m_input.quitState = m_input.states.AddBoolean(m_input.quitAction);
+
         std::array<XrPath, Side::COUNT> selectPath;
         std::array<XrPath, Side::COUNT> squeezeValuePath;
         std::array<XrPath, Side::COUNT> squeezeForcePath;
@@ -516,6 +936,10 @@ struct OpenXrProgram : IOpenXrProgram {
             suggestedBindings.countSuggestedBindings = (uint32_t)bindings.size();
             CHECK_XRCMD(xrSuggestInteractionProfileBindings(m_instance, &suggestedBindings));
         }
+    }
+
+    // Create the hand spaces of the session, and attach the action set to it.
+    void AttachActions() {
         XrActionSpaceCreateInfo actionSpaceInfo{XR_TYPE_ACTION_SPACE_CREATE_INFO};
         actionSpaceInfo.action = m_input.poseAction;
         actionSpaceInfo.poseInActionSpace.orientation.w = 1.f;
@@ -563,15 +987,55 @@ struct OpenXrProgram : IOpenXrProgram {
         }
 
         LogReferenceSpaces();
-        InitializeActions();
+        if (m_input.actionSet == XR_NULL_HANDLE) {
+            InitializeActions();
+        }
+        AttachActions();
         CreateVisualizedSpaces();
 
         {
             XrReferenceSpaceCreateInfo referenceSpaceCreateInfo = GetXrReferenceSpaceCreateInfo(m_options->AppSpace);
             CHECK_XRCMD(xrCreateReferenceSpace(m_session, &referenceSpaceCreateInfo, &m_appSpace));
         }
+
+        m_renderThreadEnabled = m_options->RenderThread && m_graphicsPlugin->SupportsRenderThread();
+        if (m_options->RenderThread && !m_renderThreadEnabled) {
+            Log::Write(Log::Level::Warning, "The graphics plugin cannot render on another thread, rendering on this one");
+        }
+
+        m_lateLatchEnabled = m_options->LateLatch && m_graphicsPlugin->SupportsLateLatching();
+        if (m_options->LateLatch && !m_lateLatchEnabled) {
+            Log::Write(Log::Level::Warning, "The graphics plugin cannot late latch the views, rendering without");
+        }
+
+        if (m_xrPerfSettingsSetPerformanceLevelEXT != nullptr) {
+            for (XrPerfSettingsDomainEXT domain : {XR_PERF_SETTINGS_DOMAIN_CPU_EXT, XR_PERF_SETTINGS_DOMAIN_GPU_EXT}) {
+                CHECK_XRCMD(m_xrPerfSettingsSetPerformanceLevelEXT(m_session, domain, m_options->Parsed.PerformanceLevel));
+            }
+            Log::Write(Log::Level::Info, Fmt("Performance level %s requested", m_options->PerformanceLevel.c_str()));
+        }
+
+#if defined(XR_USE_PLATFORM_ANDROID)
+        // This thread renders the frames too, unless the render thread does, which registers itself once it starts.
+        SetAndroidThreadType(m_renderThreadEnabled ? XR_ANDROID_THREAD_TYPE_APPLICATION_MAIN_KHR
+                                                   : XR_ANDROID_THREAD_TYPE_RENDERER_MAIN_KHR);
+#endif
     }
 
+#if defined(XR_USE_PLATFORM_ANDROID)
+    // Tell the runtime what the calling thread does for the session, with XR_KHR_android_thread_settings, so its CPU
+    // governor and scheduler favor the threads that make the frames.  A runtime may refuse, which is only logged.
+    void SetAndroidThreadType(XrAndroidThreadTypeKHR threadType) {
+        if (m_xrSetAndroidApplicationThreadKHR == nullptr) {
+            return;
+        }
+        const XrResult res = m_xrSetAndroidApplicationThreadKHR(m_session, threadType, (uint32_t)gettid());
+        if (XR_FAILED(res)) {
+            Log::Write(Log::Level::Warning, Fmt("xrSetAndroidApplicationThreadKHR failed: %s", to_string(res)));
+        }
+    }
+#endif
+
     void CreateSwapchains() override {
         CHECK(m_session != XR_NULL_HANDLE);
         CHECK(m_swapchains.empty());
@@ -608,6 +1072,7 @@ struct OpenXrProgram : IOpenXrProgram {
 
         // Create and cache view buffer for xrLocateViews later.
         m_views.resize(viewCount, {XR_TYPE_VIEW});
+        m_latchedViews.resize(viewCount, {XR_TYPE_VIEW});
 
         // Create the swapchain and get the images.
         if (viewCount > 0) {
@@ -637,8 +1102,37 @@ struct OpenXrProgram : IOpenXrProgram {
                 Log::Write(Log::Level::Verbose, Fmt("Swapchain Formats: %s", swapchainFormatsString.c_str()));
             }
 
-            // Create a swapchain for each view.
-            for (uint32_t i = 0; i < viewCount; i++) {
+            // A texture array swapchain has a layer for each view, so the views must be the same size.  Multiview renders
+            // to all of its layers in one pass.
+            bool sameViews = true;
+            for (uint32_t i = 1; i < viewCount; i++) {
+                const XrViewConfigurationView& first = m_configViews[0];
+                const XrViewConfigurationView& view = m_configViews[i];
+                sameViews = sameViews && view.recommendedImageRectWidth == first.recommendedImageRectWidth &&
+                            view.recommendedImageRectHeight == first.recommendedImageRectHeight &&
+                            view.recommendedSwapchainSampleCount == first.recommendedSwapchainSampleCount;
+            }
+            m_multiview = m_options->Multiview && m_graphicsPlugin->SupportsMultiview() && sameViews;
+            if (m_options->Multiview) {
+                Log::Write(Log::Level::Info, Fmt("Multiview rendering %s", m_multiview ? "enabled" : "not supported"));
+            }
+            m_textureArray = m_multiview || (m_options->TextureArray && sameViews && viewCount > 1);
+            if (m_options->TextureArray) {
+                Log::Write(Log::Level::Info,
+                           Fmt("Texture array swapchain %s", m_textureArray ? "enabled" : "not supported by the views"));
+            }
+
+            // The HUD's swapchain is created first, so the last color swapchain the graphics plugin allocates, which the
+            // Vulkan plugin cycles its mirror window with, is still that of a view.
+            if (m_options->Hud) {
+                CreateHudSwapchain();
+            }
+
+            // Create a swapchain for each view, or one with a layer for each view.
+            const uint32_t swapchainCount = m_textureArray ? 1 : viewCount;
+            constexpr double MiB = 1024.0 * 1024.0;
+            uint64_t swapchainMemorySize = 0;
+            for (uint32_t i = 0; i < swapchainCount; i++) {
                 const XrViewConfigurationView& vp = m_configViews[i];
                 Log::Write(Log::Level::Info,
                            Fmt("Creating swapchain for view %d with dimensions Width=%d Height=%d SampleCount=%d", i,
@@ -646,13 +1140,14 @@ struct OpenXrProgram : IOpenXrProgram {
 
                 // Create the swapchain.
                 XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
-                swapchainCreateInfo.arraySize = 1;
+                swapchainCreateInfo.arraySize = m_textureArray ? viewCount : 1;
                 swapchainCreateInfo.format = m_colorSwapchainFormat;
-                swapchainCreateInfo.width = vp.recommendedImageRectWidth;
-                swapchainCreateInfo.height = vp.recommendedImageRectHeight;
+                swapchainCreateInfo.width = ScaleSwapchainSize(vp.recommendedImageRectWidth, vp.maxImageRectWidth);
+                swapchainCreateInfo.height = ScaleSwapchainSize(vp.recommendedImageRectHeight, vp.maxImageRectHeight);
                 swapchainCreateInfo.mipCount = 1;
                 swapchainCreateInfo.faceCount = 1;
-                swapchainCreateInfo.sampleCount = m_graphicsPlugin->GetSupportedSwapchainSampleCount(vp);
+                swapchainCreateInfo.sampleCount =
+                    m_options->LowBandwidth ? 1 : m_graphicsPlugin->GetSupportedSwapchainSampleCount(vp);
                 swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
                 Swapchain swapchain;
                 swapchain.width = swapchainCreateInfo.width;
@@ -668,11 +1163,185 @@ struct OpenXrProgram : IOpenXrProgram {
                     m_graphicsPlugin->AllocateSwapchainImageStructs(imageCount, swapchainCreateInfo);
                 CHECK_XRCMD(xrEnumerateSwapchainImages(swapchain.handle, imageCount, &imageCount, swapchainImages[0]));
 
-                m_swapchainImages.insert(std::make_pair(swapchain.handle, std::move(swapchainImages)));
+                m_swapchainImages.push_back(std::move(swapchainImages));
+
+                const uint64_t imageMemorySize = m_graphicsPlugin->GetSwapchainImageMemorySize(swapchainCreateInfo);
+                Log::Write(Log::Level::Info,
+                           Fmt("Created swapchain with Width=%d Height=%d SampleCount=%d: %d images of about %.1f MiB with depth",
+                               swapchainCreateInfo.width, swapchainCreateInfo.height, swapchainCreateInfo.sampleCount, imageCount,
+                               imageMemorySize / MiB));
+                swapchainMemorySize += imageMemorySize * imageCount;
+            }
+            Log::Write(Log::Level::Info, Fmt("Swapchain memory: about %.1f MiB", swapchainMemorySize / MiB));
+
+            if (m_depthExtensionEnabled) {
+                CreateDepthSwapchain(swapchainFormats);
+            }
+            if (m_spaceWarpExtensionEnabled) {
+                CreateSpaceWarpSwapchains(swapchainFormats);
             }
         }
     }
 
+    // Create one depth swapchain with a layer for each view, which RenderLayer renders the depth of every view to and
+    // submits with the projection layer, instead of the graphics plugin keeping depth buffers for each color image.
+    void CreateDepthSwapchain(const std::vector<int64_t>& swapchainFormats) {
+        const int64_t depthSwapchainFormat = m_graphicsPlugin->SelectDepthSwapchainFormat(swapchainFormats);
+        bool sameSize = true;
+        for (const Swapchain& swapchain : m_swapchains) {
+            sameSize = sameSize && swapchain.width == m_swapchains[0].width && swapchain.height == m_swapchains[0].height;
+        }
+        if (depthSwapchainFormat == 0 || m_multiview || !sameSize) {
+            Log::Write(Log::Level::Warning, "Cannot render these views to a depth swapchain, not submitting depth");
+            return;
+        }
+
+        XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+        swapchainCreateInfo.arraySize = (uint32_t)m_configViews.size();
+        swapchainCreateInfo.format = depthSwapchainFormat;
+        swapchainCreateInfo.width = m_swapchains[0].width;
+        swapchainCreateInfo.height = m_swapchains[0].height;
+        swapchainCreateInfo.mipCount = 1;
+        swapchainCreateInfo.faceCount = 1;
+        // The plugins that render to depth swapchains render single-sampled.
+        swapchainCreateInfo.sampleCount = 1;
+        swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        m_depthSwapchain.width = swapchainCreateInfo.width;
+        m_depthSwapchain.height = swapchainCreateInfo.height;
+        CHECK_XRCMD(xrCreateSwapchain(m_session, &swapchainCreateInfo, &m_depthSwapchain.handle));
+
+        uint32_t imageCount;
+        CHECK_XRCMD(xrEnumerateSwapchainImages(m_depthSwapchain.handle, 0, &imageCount, nullptr));
+        m_depthSwapchainImages = m_graphicsPlugin->AllocateSwapchainImageStructs(imageCount, swapchainCreateInfo);
+        CHECK_XRCMD(xrEnumerateSwapchainImages(m_depthSwapchain.handle, imageCount, &imageCount, m_depthSwapchainImages[0]));
+
+        // The depth range and planes match the projection of every graphics plugin.
+        m_depthInfos.resize(m_configViews.size(), {XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR});
+        for (uint32_t i = 0; i < m_depthInfos.size(); i++) {
+            XrCompositionLayerDepthInfoKHR& depthInfo = m_depthInfos[i];
+            depthInfo.subImage.swapchain = m_depthSwapchain.handle;
+            depthInfo.subImage.imageRect.offset = {0, 0};
+            depthInfo.subImage.imageRect.extent = {m_depthSwapchain.width, m_depthSwapchain.height};
+            depthInfo.subImage.imageArrayIndex = i;
+            depthInfo.minDepth = 0.0f;
+            depthInfo.maxDepth = 1.0f;
+            depthInfo.nearZ = 0.05f;
+            depthInfo.farZ = 100.0f;
+        }
+        Log::Write(Log::Level::Info, Fmt("Submitting depth from a swapchain of format %lld with %d layers",
+                                         (long long)depthSwapchainFormat, swapchainCreateInfo.arraySize));
+    }
+
+    // Create the swapchain of the HUD and its quad layer, head-locked below the center of the views.  The HUD is a gauge of
+    // the render scale, which only changes with Options::DynamicResolution; without it, the swapchain has a static image,
+    // which is rendered once, and the runtime may keep in less memory.
+    void CreateHudSwapchain() {
+        m_hudStatic = !m_options->DynamicResolution;
+
+        XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+        swapchainCreateInfo.createFlags = m_hudStatic ? XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT : 0;
+        swapchainCreateInfo.arraySize = 1;
+        swapchainCreateInfo.format = m_colorSwapchainFormat;
+        swapchainCreateInfo.width = HudImageWidth;
+        swapchainCreateInfo.height = HudImageHeight;
+        swapchainCreateInfo.mipCount = 1;
+        swapchainCreateInfo.faceCount = 1;
+        swapchainCreateInfo.sampleCount = 1;
+        swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+        m_hudSwapchain.width = swapchainCreateInfo.width;
+        m_hudSwapchain.height = swapchainCreateInfo.height;
+        CHECK_XRCMD(xrCreateSwapchain(m_session, &swapchainCreateInfo, &m_hudSwapchain.handle));
+
+        uint32_t imageCount;
+        CHECK_XRCMD(xrEnumerateSwapchainImages(m_hudSwapchain.handle, 0, &imageCount, nullptr));
+        m_hudSwapchainImages = m_graphicsPlugin->AllocateSwapchainImageStructs(imageCount, swapchainCreateInfo);
+        CHECK_XRCMD(xrEnumerateSwapchainImages(m_hudSwapchain.handle, imageCount, &imageCount, m_hudSwapchainImages[0]));
+
+        XrReferenceSpaceCreateInfo referenceSpaceCreateInfo = GetXrReferenceSpaceCreateInfo("View");
+        CHECK_XRCMD(xrCreateReferenceSpace(m_session, &referenceSpaceCreateInfo, &m_hudSpace));
+
+        m_hudLayer = {XR_TYPE_COMPOSITION_LAYER_QUAD};
+        m_hudLayer.space = m_hudSpace;
+        m_hudLayer.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
+        m_hudLayer.subImage.swapchain = m_hudSwapchain.handle;
+        m_hudLayer.subImage.imageRect.offset = {0, 0};
+        m_hudLayer.subImage.imageRect.extent = {m_hudSwapchain.width, m_hudSwapchain.height};
+        m_hudLayer.subImage.imageArrayIndex = 0;
+        m_hudLayer.pose = Math::Pose::Translation({0.f, -0.3f, -1.f});
+        m_hudLayer.size = {HudWidth, HudWidth * HudImageHeight / HudImageWidth};
+        m_hudReading = -1;
+        m_hudCubes.reserve(HudCells);
+        Log::Write(Log::Level::Info, Fmt("Created the HUD swapchain with %d images%s", imageCount,
+                                         m_hudStatic ? ", a static image" : ""));
+    }
+
+    // Create the motion vector and depth swapchains of XR_FB_space_warp, each with a layer for each view, at the size the
+    // system recommends for motion vectors, which is usually well below that of the views.
+    void CreateSpaceWarpSwapchains(const std::vector<int64_t>& swapchainFormats) {
+        int64_t motionVectorFormat = 0;
+        int64_t depthFormat = 0;
+        if (!m_graphicsPlugin->SelectSpaceWarpSwapchainFormats(swapchainFormats, &motionVectorFormat, &depthFormat)) {
+            Log::Write(Log::Level::Warning, "The graphics plugin cannot render the motion vectors, not submitting them");
+            return;
+        }
+
+        XrSystemSpaceWarpPropertiesFB spaceWarpProperties{XR_TYPE_SYSTEM_SPACE_WARP_PROPERTIES_FB};
+        XrSystemProperties systemProperties{XR_TYPE_SYSTEM_PROPERTIES, &spaceWarpProperties};
+        CHECK_XRCMD(xrGetSystemProperties(m_instance, m_systemId, &systemProperties));
+
+        XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+        swapchainCreateInfo.arraySize = (uint32_t)m_configViews.size();
+        swapchainCreateInfo.width = spaceWarpProperties.recommendedMotionVectorImageRectWidth;
+        swapchainCreateInfo.height = spaceWarpProperties.recommendedMotionVectorImageRectHeight;
+        swapchainCreateInfo.mipCount = 1;
+        swapchainCreateInfo.faceCount = 1;
+        swapchainCreateInfo.sampleCount = 1;
+        const auto createSwapchain = [&](int64_t format, XrSwapchainUsageFlags usageFlags,
+                                         std::vector<XrSwapchainImageBaseHeader*>& images) {
+            swapchainCreateInfo.format = format;
+            swapchainCreateInfo.usageFlags = usageFlags;
+            Swapchain swapchain{XR_NULL_HANDLE, (int32_t)swapchainCreateInfo.width, (int32_t)swapchainCreateInfo.height};
+            CHECK_XRCMD(xrCreateSwapchain(m_session, &swapchainCreateInfo, &swapchain.handle));
+
+            uint32_t imageCount;
+            CHECK_XRCMD(xrEnumerateSwapchainImages(swapchain.handle, 0, &imageCount, nullptr));
+            images = m_graphicsPlugin->AllocateSwapchainImageStructs(imageCount, swapchainCreateInfo);
+            CHECK_XRCMD(xrEnumerateSwapchainImages(swapchain.handle, imageCount, &imageCount, images[0]));
+            return swapchain;
+        };
+        m_motionVectorSwapchain =
+            createSwapchain(motionVectorFormat, XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT, m_motionVectorSwapchainImages);
+        m_spaceWarpDepthSwapchain =
+            createSwapchain(depthFormat, XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, m_spaceWarpDepthSwapchainImages);
+
+        // The app space does not move between frames, and the depth range and planes match the projection of the plugin.
+        m_spaceWarpInfos.resize(m_configViews.size(), {XR_TYPE_COMPOSITION_LAYER_SPACE_WARP_INFO_FB});
+        for (uint32_t i = 0; i < m_spaceWarpInfos.size(); i++) {
+            XrCompositionLayerSpaceWarpInfoFB& spaceWarpInfo = m_spaceWarpInfos[i];
+            spaceWarpInfo.motionVectorSubImage.swapchain = m_motionVectorSwapchain.handle;
+            spaceWarpInfo.motionVectorSubImage.imageRect.offset = {0, 0};
+            spaceWarpInfo.motionVectorSubImage.imageRect.extent = {m_motionVectorSwapchain.width,
+                                                                   m_motionVectorSwapchain.height};
+            spaceWarpInfo.motionVectorSubImage.imageArrayIndex = i;
+            spaceWarpInfo.appSpaceDeltaPose = Math::Pose::Identity();
+            spaceWarpInfo.depthSubImage = spaceWarpInfo.motionVectorSubImage;
+            spaceWarpInfo.depthSubImage.swapchain = m_spaceWarpDepthSwapchain.handle;
+            spaceWarpInfo.minDepth = 0.0f;
+            spaceWarpInfo.maxDepth = 1.0f;
+            spaceWarpInfo.nearZ = 0.05f;
+            spaceWarpInfo.farZ = 100.0f;
+        }
+        Log::Write(Log::Level::Info, Fmt("Submitting motion vectors of format %lld and depth of format %lld at Width=%d Height=%d",
+                                         (long long)motionVectorFormat, (long long)depthFormat, swapchainCreateInfo.width,
+                                         swapchainCreateInfo.height));
+    }
+
+    // Options::RenderScale of a recommended swapchain size, at least 1 and at most the maximum.
+    uint32_t ScaleSwapchainSize(uint32_t recommended, uint32_t maximum) const {
+        const uint32_t scaled = (uint32_t)std::lround(recommended * m_options->RenderScale);
+        return std::min(std::max(scaled, 1u), maximum);
+    }
+
     // Return event if one is available, otherwise return null.
     const XrEventDataBaseHeader* TryReadNextEvent() {
         // It is sufficient to clear the just the XrEventDataBuffer header to
@@ -703,6 +1372,7 @@ struct OpenXrProgram : IOpenXrProgram {
                 case XR_TYPE_EVENT_DATA_INSTANCE_LOSS_PENDING: {
                     const auto& instanceLossPending = *reinterpret_cast<const XrEventDataInstanceLossPending*>(event);
                     Log::Write(Log::Level::Warning, Fmt("XrEventDataInstanceLossPending by %lld", instanceLossPending.lossTime));
+                    m_instanceLost = true;
                     *exitRenderLoop = true;
                     *requestRestart = true;
                     return;
@@ -747,12 +1417,29 @@ struct OpenXrProgram : IOpenXrProgram {
                 sessionBeginInfo.primaryViewConfigurationType = m_options->Parsed.ViewConfigType;
                 CHECK_XRCMD(xrBeginSession(m_session, &sessionBeginInfo));
                 m_sessionRunning = true;
+                m_benchmarkFrameCount = 0;
+                m_benchmarkStats.Reset(m_options->BenchmarkFrames);
+                m_lateLatchStats.Reset();
+                m_renderScale.Reset();
+                if (m_renderThreadEnabled) {
+                    StartRenderThread();
+                }
                 break;
             }
             case XR_SESSION_STATE_STOPPING: {
                 CHECK(m_session != XR_NULL_HANDLE);
                 m_sessionRunning = false;
+                StopRenderThread();
                 CHECK_XRCMD(xrEndSession(m_session))
+                if (m_options->BenchmarkCubes > 0) {
+                    m_benchmarkStats.Report(m_options->GraphicsPlugin, m_options->BenchmarkCubes);
+                }
+                if (m_lateLatchEnabled) {
+                    m_lateLatchStats.Report();
+                }
+                if (m_options->DynamicResolution) {
+                    m_renderScale.Report();
+                }
                 break;
             }
             case XR_SESSION_STATE_EXITING: {
@@ -822,15 +1509,11 @@ struct OpenXrProgram : IOpenXrProgram {
         syncInfo.countActiveActionSets = 1;
         syncInfo.activeActionSets = &activeActionSet;
         CHECK_XRCMD(xrSyncActions(m_session, &syncInfo));
+        m_input.states.Update(m_session);
 
         // Get pose and grab action state and start haptic vibrate when hand is 90% squeezed.
         for (auto hand : {Side::LEFT, Side::RIGHT}) {
-            XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
-            getInfo.action = m_input.grabAction;
-            getInfo.subactionPath = m_input.handSubactionPath[hand];
-
-            XrActionStateFloat grabValue{XR_TYPE_ACTION_STATE_FLOAT};
-            CHECK_XRCMD(xrGetActionStateFloat(m_session, &getInfo, &grabValue));
+            const XrActionStateFloat& grabValue = m_input.states.Float(m_input.grabState[hand]);
             if (grabValue.isActive == XR_TRUE) {
                 // Scale the rendered hand by 1.0f (open) to 0.5f (fully squeezed).
                 m_input.handScale[hand] = 1.0f - 0.5f * grabValue.currentState;
@@ -847,16 +1530,11 @@ struct OpenXrProgram : IOpenXrProgram {
                 }
             }
 
-            getInfo.action = m_input.poseAction;
-            XrActionStatePose poseState{XR_TYPE_ACTION_STATE_POSE};
-            CHECK_XRCMD(xrGetActionStatePose(m_session, &getInfo, &poseState));
-            m_input.handActive[hand] = poseState.isActive;
+            m_input.handActive[hand] = m_input.states.Pose(m_input.poseState[hand]).isActive;
         }
 
         // There were no subaction paths specified for the quit action, because we don't care which hand did it.
-        XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, m_input.quitAction, XR_NULL_PATH};
-        XrActionStateBoolean quitValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-        CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &quitValue));
+        const XrActionStateBoolean& quitValue = m_input.states.Boolean(m_input.quitState);
         if ((quitValue.isActive == XR_TRUE) && (quitValue.changedSinceLastSync == XR_TRUE) && (quitValue.currentState == XR_TRUE)) {
             CHECK_XRCMD(xrRequestExitSession(m_session));
         }
@@ -864,70 +1542,219 @@ struct OpenXrProgram : IOpenXrProgram {
 
     void RenderFrame() override {
         CHECK(m_session != XR_NULL_HANDLE);
+        const uint64_t allocationCount = AllocationCounter::Count();
+
+        if (!m_renderThread.joinable()) {
+            FrameTimes times;
+            const XrFrameState frameState = WaitFrame(m_cubes, times);
+            SubmitFrame(frameState, m_cubes, times);
+            CheckFrameAllocations(allocationCount, m_renderedFrameCount);
+            return;
+        }
+
+        // Wait for the frame on this thread and hand it to the render thread, which begins, renders and ends it.  The
+        // slot is taken before xrWaitFrame, so the frame being waited for is within the queue's capacity of the frame
+        // being rendered.
+        FrameSlot* slot = m_frameSlots.BeginWrite();
+        if (slot == nullptr) {
+            StopRenderThread();  // The render thread has failed; this rethrows its exception.
+            return;
+        }
+        slot->frameState = WaitFrame(slot->cubes, slot->times);
+        slot->stop = false;
+        m_frameSlots.EndWrite();
+        CheckFrameAllocations(allocationCount, m_simulatedFrameCount);
+    }
 
+    // Wait for the next frame and locate the cubes to render in it at its predicted display time.  Sets the frame's wait
+    // time, and its CPU time so far.  Once a benchmark has waited for its last frame, requests the end of the session.
+    XrFrameState WaitFrame(std::vector<Cube>& cubes, FrameTimes& times) {
         XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
         XrFrameState frameState{XR_TYPE_FRAME_STATE};
-        CHECK_XRCMD(xrWaitFrame(m_session, &frameWaitInfo, &frameState));
+        const Clock::time_point waitStart = Clock::now();
+        {
+            AllocationCounter::Untracked runtimeAllocations;
+            CHECK_XRCMD(xrWaitFrame(m_session, &frameWaitInfo, &frameState));
+        }
+        const Clock::time_point waitEnd = Clock::now();
+        times.wait = MillisecondsBetween(waitStart, waitEnd);
+
+        cubes.clear();
+        if (frameState.shouldRender == XR_TRUE) {
+            LocateCubes(frameState.predictedDisplayTime, cubes);
+        }
 
+        if (m_options->BenchmarkCubes > 0 && ++m_benchmarkFrameCount == m_options->BenchmarkFrames) {
+            AllocationCounter::Untracked runtimeAllocations;
+            CHECK_XRCMD(xrRequestExitSession(m_session));
+        }
+        times.cpu = MillisecondsBetween(waitEnd, Clock::now());
+        return frameState;
+    }
+
+    // Begin a frame returned by WaitFrame, render the cubes into its projection layer, and end it.  A benchmark records
+    // the frame's times, and the GPU time of an earlier frame when the graphics plugin has one, which also sets the scale
+    // of the next frames with Options::DynamicResolution.
+    void SubmitFrame(const XrFrameState& frameState, const std::vector<Cube>& cubes, const FrameTimes& times) {
+        const Clock::time_point submitStart = Clock::now();
         XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
-        CHECK_XRCMD(xrBeginFrame(m_session, &frameBeginInfo));
+        {
+            AllocationCounter::Untracked runtimeAllocations;
+            CHECK_XRCMD(xrBeginFrame(m_session, &frameBeginInfo));
+        }
 
-        std::vector<XrCompositionLayerBaseHeader*> layers;
-        XrCompositionLayerProjection layer{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
-        std::vector<XrCompositionLayerProjectionView> projectionLayerViews;
+        // The layers of the frame are kept in members, so their storage is reused from frame to frame.
+        m_layers.clear();
         if (frameState.shouldRender == XR_TRUE) {
-            if (RenderLayer(frameState.predictedDisplayTime, projectionLayerViews, layer)) {
-                layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&layer));
+            if (RenderLayer(frameState.predictedDisplayTime, cubes, m_projectionLayerViews, m_layer)) {
+                m_layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&m_layer));
+            }
+            // Once the HUD has an image, its layer is submitted every frame, whether or not the frame rendered it.
+            if (m_hudReading >= 0) {
+                m_layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&m_hudLayer));
             }
         }
 
         XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
         frameEndInfo.displayTime = frameState.predictedDisplayTime;
         frameEndInfo.environmentBlendMode = m_options->Parsed.EnvironmentBlendMode;
-        frameEndInfo.layerCount = (uint32_t)layers.size();
-        frameEndInfo.layers = layers.data();
-        CHECK_XRCMD(xrEndFrame(m_session, &frameEndInfo));
+        frameEndInfo.layerCount = (uint32_t)m_layers.size();
+        frameEndInfo.layers = m_layers.data();
+        {
+            AllocationCounter::Untracked runtimeAllocations;
+            CHECK_XRCMD(xrEndFrame(m_session, &frameEndInfo));
+            AcquireLayerImages();  // For the next frame
+        }
+
+        const bool benchmark = m_options->BenchmarkCubes > 0;
+        if (benchmark) {
+            m_benchmarkStats.RecordFrame({times.wait, times.cpu + MillisecondsBetween(submitStart, Clock::now())});
+        }
+        double gpuTime;
+        if ((benchmark || m_options->DynamicResolution) && m_graphicsPlugin->TakeGpuFrameTime(&gpuTime)) {
+            if (benchmark) {
+                m_benchmarkStats.RecordGpuFrame(gpuTime);
+                std::array<double, IGraphicsPlugin::MaxTimedViews> gpuViewTimes;
+                m_benchmarkStats.RecordGpuViews(gpuViewTimes, m_graphicsPlugin->TakeGpuViewTimes(gpuViewTimes));
+            }
+            if (m_options->DynamicResolution) {
+                m_renderScale.RecordGpuFrame(gpuTime, frameState.predictedDisplayPeriod);
+            }
+        }
     }
 
-    bool RenderLayer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerProjectionView>& projectionLayerViews,
-                     XrCompositionLayerProjection& layer) {
-        XrResult res;
+    // Debug builds check that, once the first frames have grown the per-frame storage, hello_xr itself makes no heap
+    // allocations in a frame on the calling thread.  The runtime and graphics plugin calls are not counted.
+    static void CheckFrameAllocations(uint64_t allocationCount, uint64_t& frameCount) {
+        if (AllocationCounter::Enabled() && ++frameCount > AllocationWarmupFrames) {
+            const uint64_t frameAllocations = AllocationCounter::Count() - allocationCount;
+            CHECK_MSG(frameAllocations == 0, Fmt("Frame %llu made %llu heap allocations", (unsigned long long)frameCount,
+                                                 (unsigned long long)frameAllocations));
+        }
+    }
 
-        XrViewState viewState{XR_TYPE_VIEW_STATE};
-        uint32_t viewCapacityInput = (uint32_t)m_views.size();
-        uint32_t viewCountOutput;
+    void StartRenderThread() {
+        CHECK(!m_renderThread.joinable());
+        m_frameSlots.Reset();
+        m_renderThreadException = nullptr;
+        m_renderThread = std::thread(&OpenXrProgram::RenderThread, this);
+    }
 
-        XrViewLocateInfo viewLocateInfo{XR_TYPE_VIEW_LOCATE_INFO};
-        viewLocateInfo.viewConfigurationType = m_options->Parsed.ViewConfigType;
-        viewLocateInfo.displayTime = predictedDisplayTime;
-        viewLocateInfo.space = m_appSpace;
+    // Have the render thread submit the frames already handed to it, then wait for it to exit.  Rethrows the exception the
+    // render thread failed with, if any.
+    void StopRenderThread() {
+        if (!m_renderThread.joinable()) {
+            return;
+        }
+        FrameSlot* slot = m_frameSlots.BeginWrite();
+        if (slot != nullptr) {
+            slot->stop = true;
+            m_frameSlots.EndWrite();
+        }
+        m_renderThread.join();
+        if (m_renderThreadException != nullptr) {
+            std::exception_ptr exception = m_renderThreadException;
+            m_renderThreadException = nullptr;
+            std::rethrow_exception(exception);
+        }
+    }
 
-        res = xrLocateViews(m_session, &viewLocateInfo, &viewState, viewCapacityInput, &viewCountOutput, m_views.data());
-        CHECK_XRRESULT(res, "xrLocateViews");
-        if ((viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) == 0 ||
-            (viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) == 0) {
-            return false;  // There is no valid tracking poses for the views.
+    void RenderThread() {
+#if defined(XR_USE_PLATFORM_ANDROID)
+        SetAndroidThreadType(XR_ANDROID_THREAD_TYPE_RENDERER_MAIN_KHR);
+#endif
+        try {
+            for (;;) {
+                const FrameSlot* slot = m_frameSlots.BeginRead();
+                if (slot == nullptr || slot->stop) {
+                    break;
+                }
+                const uint64_t allocationCount = AllocationCounter::Count();
+                SubmitFrame(slot->frameState, slot->cubes, slot->times);
+                m_frameSlots.EndRead();
+                CheckFrameAllocations(allocationCount, m_renderedFrameCount);
+            }
+        } catch (...) {
+            m_renderThreadException = std::current_exception();
         }
+        // Also wakes the simulation thread if it is waiting for a slot, so it notices that this thread has exited.
+        m_frameSlots.Close();
+    }
 
-        CHECK(viewCountOutput == viewCapacityInput);
-        CHECK(viewCountOutput == m_configViews.size());
-        CHECK(viewCountOutput == m_swapchains.size());
+    // Locate every one of m_locatedSpaces in app space into m_spaceLocations, with a single xrLocateSpacesKHR call when
+    // XR_KHR_locate_spaces is enabled, and an xrLocateSpace call each otherwise.  XR_SUCCESS if all of them were located,
+    // else the result that prevented it.
+    XrResult LocateSpaces(XrTime time) {
+        m_spaceLocations.assign(m_locatedSpaces.size(), {});
+        AllocationCounter::Untracked runtimeAllocations;
+        if (m_xrLocateSpacesKHR != nullptr) {
+            XrSpacesLocateInfoKHR locateInfo{XR_TYPE_SPACES_LOCATE_INFO_KHR};
+            locateInfo.baseSpace = m_appSpace;
+            locateInfo.time = time;
+            locateInfo.spaceCount = (uint32_t)m_locatedSpaces.size();
+            locateInfo.spaces = m_locatedSpaces.data();
+            XrSpaceLocationsKHR spaceLocations{XR_TYPE_SPACE_LOCATIONS_KHR};
+            spaceLocations.locationCount = (uint32_t)m_spaceLocations.size();
+            spaceLocations.locations = m_spaceLocations.data();
+            const XrResult res = m_xrLocateSpacesKHR(m_session, &locateInfo, &spaceLocations);
+            CHECK_XRRESULT(res, "xrLocateSpacesKHR");
+            return res;
+        }
 
-        projectionLayerViews.resize(viewCountOutput);
+        XrResult result = XR_SUCCESS;
+        for (size_t i = 0; i < m_locatedSpaces.size(); i++) {
+            XrSpaceLocation spaceLocation{XR_TYPE_SPACE_LOCATION};
+            const XrResult res = xrLocateSpace(m_locatedSpaces[i], m_appSpace, time, &spaceLocation);
+            CHECK_XRRESULT(res, "xrLocateSpace");
+            if (XR_UNQUALIFIED_SUCCESS(res)) {
+                m_spaceLocations[i] = {spaceLocation.locationFlags, spaceLocation.pose};
+            } else {
+                result = res;
+            }
+        }
+        return result;
+    }
+
+    // Locate the visualized spaces and the hands, and append a cube to cubes for each one that is located.
+    void LocateCubes(XrTime predictedDisplayTime, std::vector<Cube>& cubes) {
+        // Locate the visualized spaces, then the hand spaces.
+        m_locatedSpaces.assign(m_visualizedSpaces.begin(), m_visualizedSpaces.end());
+        m_locatedSpaces.push_back(m_input.handSpace[Side::LEFT]);
+        m_locatedSpaces.push_back(m_input.handSpace[Side::RIGHT]);
+        const XrResult res = LocateSpaces(predictedDisplayTime);
 
         // For each locatable space that we want to visualize, render a 25cm cube.
-        std::vector<Cube> cubes;
+        cubes.reserve(m_visualizedSpaces.size() + Side::COUNT + m_options->BenchmarkCubes);
 
-        for (XrSpace visualizedSpace : m_visualizedSpaces) {
-            XrSpaceLocation spaceLocation{XR_TYPE_SPACE_LOCATION};
-            res = xrLocateSpace(visualizedSpace, m_appSpace, predictedDisplayTime, &spaceLocation);
-            CHECK_XRRESULT(res, "xrLocateSpace");
+        for (size_t i = 0; i < m_visualizedSpaces.size(); i++) {
+            const XrSpaceLocationDataKHR& spaceLocation = m_spaceLocations[i];
             if (XR_UNQUALIFIED_SUCCESS(res)) {
                 if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
                     (spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
                     cubes.push_back(Cube{spaceLocation.pose, {0.25f, 0.25f, 0.25f}});
                 }
-            } else {
+            } else if (Log::IsEnabled(Log::Level::Verbose) && m_locateSpaceLogLimit.Allow()) {
+                AllocationCounter::Untracked logAllocations;
                 Log::Write(Log::Level::Verbose, Fmt("Unable to locate a visualized reference space in app space: %d", res));
             }
         }
@@ -935,9 +1762,7 @@ struct OpenXrProgram : IOpenXrProgram {
         // Render a 10cm cube scaled by grabAction for each hand. Note renderHand will only be
         // true when the application has focus.
         for (auto hand : {Side::LEFT, Side::RIGHT}) {
-            XrSpaceLocation spaceLocation{XR_TYPE_SPACE_LOCATION};
-            res = xrLocateSpace(m_input.handSpace[hand], m_appSpace, predictedDisplayTime, &spaceLocation);
-            CHECK_XRRESULT(res, "xrLocateSpace");
+            const XrSpaceLocationDataKHR& spaceLocation = m_spaceLocations[m_visualizedSpaces.size() + hand];
             if (XR_UNQUALIFIED_SUCCESS(res)) {
                 if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
                     (spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
@@ -947,41 +1772,172 @@ struct OpenXrProgram : IOpenXrProgram {
             } else {
                 // Tracking loss is expected when the hand is not active so only log a message
                 // if the hand is active.
-                if (m_input.handActive[hand] == XR_TRUE) {
+                if (m_input.handActive[hand] == XR_TRUE && Log::IsEnabled(Log::Level::Verbose) &&
+                    m_locateHandLogLimits[hand].Allow()) {
                     const char* handName[] = {"left", "right"};
+                    AllocationCounter::Untracked logAllocations;
                     Log::Write(Log::Level::Verbose,
                                Fmt("Unable to locate %s hand action space in app space: %d", handName[hand], res));
                 }
             }
         }
 
-        // Render view to the appropriate part of the swapchain image.
-        for (uint32_t i = 0; i < viewCountOutput; i++) {
-            // Each view has a separate swapchain which is acquired, rendered to, and released.
-            const Swapchain viewSwapchain = m_swapchains[i];
+        AppendBenchmarkCubes(cubes);
+    }
 
-            XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+    // Append the benchmark's 10cm cubes, in a grid of 20cm cells that starts 1m in front of the app space origin and
+    // recedes in layers.  Each cube turns a degree per frame about its vertical axis, so a run renders the same frames
+    // whatever its frame rate.
+    void AppendBenchmarkCubes(std::vector<Cube>& cubes) const {
+        const uint32_t count = m_options->BenchmarkCubes;
+        uint32_t side = 1;
+        while (side * side * side < count) {
+            side++;
+        }
+        constexpr float Spacing = 0.2f;
+        const float center = (side - 1) * 0.5f;
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t x = i % side;
+            const uint32_t y = (i / side) % side;
+            const uint32_t z = i / (side * side);
+            const float angle = (float)((m_benchmarkFrameCount + i) % 360) * MATH_PI / 180.0f;
+            const XrVector3f position{(x - center) * Spacing, (y - center) * Spacing, -1.0f - z * Spacing};
+            cubes.push_back(Cube{Math::Pose::RotateCCWAboutYAxis(angle, position), {0.1f, 0.1f, 0.1f}});
+        }
+    }
 
-            uint32_t swapchainImageIndex;
-            CHECK_XRCMD(xrAcquireSwapchainImage(viewSwapchain.handle, &acquireInfo, &swapchainImageIndex));
+    bool RenderLayer(XrTime predictedDisplayTime, const std::vector<Cube>& cubes,
+                     std::vector<XrCompositionLayerProjectionView>& projectionLayerViews, XrCompositionLayerProjection& layer) {
+        XrResult res;
 
-            XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
-            waitInfo.timeout = XR_INFINITE_DURATION;
-            CHECK_XRCMD(xrWaitSwapchainImage(viewSwapchain.handle, &waitInfo));
+        XrViewState viewState{XR_TYPE_VIEW_STATE};
+        uint32_t viewCapacityInput = (uint32_t)m_views.size();
+        uint32_t viewCountOutput;
+
+        XrViewLocateInfo viewLocateInfo{XR_TYPE_VIEW_LOCATE_INFO};
+        viewLocateInfo.viewConfigurationType = m_options->Parsed.ViewConfigType;
+        viewLocateInfo.displayTime = predictedDisplayTime;
+        viewLocateInfo.space = m_appSpace;
+
+        {
+            AllocationCounter::Untracked runtimeAllocations;
+            res = xrLocateViews(m_session, &viewLocateInfo, &viewState, viewCapacityInput, &viewCountOutput, m_views.data());
+        }
+        CHECK_XRRESULT(res, "xrLocateViews");
+        const Clock::time_point locateTime = Clock::now();
+        if ((viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) == 0 ||
+            (viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) == 0) {
+            return false;  // There is no valid tracking poses for the views.
+        }
+
+        CHECK(viewCountOutput == viewCapacityInput);
+        CHECK(viewCountOutput == m_configViews.size());
+        CHECK(m_swapchains.size() == (m_textureArray ? 1 : viewCountOutput));
+
+        projectionLayerViews.resize(viewCountOutput);
+
+        // Every swapchain is rendered to: one texture array with a layer for each view, or one for each view.  All are
+        // rendered to in one frame of the graphics plugin, and released, so the plugin can submit every view at once.  Their
+        // images were normally acquired when the previous frame ended, and are only waited for once the cubes are culled.
+        AllocationCounter::Untracked runtimeAllocations;
+        AcquireLayerImages();
+        std::vector<const XrSwapchainImageBaseHeader*>& viewSwapchainImages = m_viewSwapchainImages;
+        viewSwapchainImages.resize(viewCountOutput);
+        for (uint32_t i = 0; i < m_swapchains.size(); i++) {
+            const XrSwapchainImageBaseHeader* const swapchainImage = m_swapchainImages[i][m_layerImageIndices[i]];
+            if (m_textureArray) {
+                std::fill(viewSwapchainImages.begin(), viewSwapchainImages.end(), swapchainImage);
+            } else {
+                viewSwapchainImages[i] = swapchainImage;
+            }
+        }
 
+        for (uint32_t i = 0; i < viewCountOutput; i++) {
+            const Swapchain viewSwapchain = m_swapchains[m_textureArray ? 0 : i];
             projectionLayerViews[i] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
             projectionLayerViews[i].pose = m_views[i].pose;
             projectionLayerViews[i].fov = m_views[i].fov;
             projectionLayerViews[i].subImage.swapchain = viewSwapchain.handle;
             projectionLayerViews[i].subImage.imageRect.offset = {0, 0};
-            projectionLayerViews[i].subImage.imageRect.extent = {viewSwapchain.width, viewSwapchain.height};
+            projectionLayerViews[i].subImage.imageRect.extent = {m_renderScale.ScaleSize(viewSwapchain.width),
+                                                                 m_renderScale.ScaleSize(viewSwapchain.height)};
+            projectionLayerViews[i].subImage.imageArrayIndex = m_textureArray ? i : 0;
+        }
 
-            const XrSwapchainImageBaseHeader* const swapchainImage = m_swapchainImages[viewSwapchain.handle][swapchainImageIndex];
-            m_graphicsPlugin->RenderView(projectionLayerViews[i], swapchainImage, m_colorSwapchainFormat, cubes);
+        // With a depth swapchain, each view renders depth to its layer of one image, submitted with the view.
+        const XrSwapchainImageBaseHeader* depthImage = nullptr;
+        if (m_depthSwapchain.handle != XR_NULL_HANDLE) {
+            depthImage = m_depthSwapchainImages[m_depthImageIndex];
+            for (uint32_t i = 0; i < viewCountOutput; i++) {
+                m_depthInfos[i].subImage.imageRect = projectionLayerViews[i].subImage.imageRect;
+                projectionLayerViews[i].next = &m_depthInfos[i];
+            }
+        }
 
+        // With space warp, each view also renders the motion of the cubes, and their depth, to its layer of an image of each
+        // of the space warp swapchains.
+        const XrSwapchainImageBaseHeader* motionVectorImage = nullptr;
+        const XrSwapchainImageBaseHeader* spaceWarpDepthImage = nullptr;
+        if (m_motionVectorSwapchain.handle != XR_NULL_HANDLE) {
+            motionVectorImage = m_motionVectorSwapchainImages[m_motionVectorImageIndex];
+            spaceWarpDepthImage = m_spaceWarpDepthSwapchainImages[m_spaceWarpDepthImageIndex];
+            for (uint32_t i = 0; i < viewCountOutput; i++) {
+                m_spaceWarpInfos[i].next = projectionLayerViews[i].next;
+                projectionLayerViews[i].next = &m_spaceWarpInfos[i];
+            }
+        }
+
+        // The motion vectors pair each cube with the same one of the previous frame, so only the views are culled.
+        const std::vector<Cube>& visibleCubes = m_options->Cull ? CullCubes(cubes) : cubes;
+
+        WaitLayerImages();
+        m_graphicsPlugin->BeginFrame();
+        if (m_multiview) {
+            m_graphicsPlugin->RenderMultiView(projectionLayerViews, viewSwapchainImages[0], m_colorSwapchainFormat, visibleCubes);
+        } else {
+            for (uint32_t i = 0; i < viewCountOutput; i++) {
+                if (depthImage != nullptr) {
+                    m_graphicsPlugin->RenderViewWithDepth(projectionLayerViews[i], viewSwapchainImages[i], m_colorSwapchainFormat,
+                                                          depthImage, m_depthInfos[i].subImage.imageArrayIndex, visibleCubes);
+                } else {
+                    m_graphicsPlugin->RenderView(projectionLayerViews[i], viewSwapchainImages[i], m_colorSwapchainFormat,
+                                                 visibleCubes);
+                }
+            }
+        }
+        if (motionVectorImage != nullptr) {
+            for (uint32_t i = 0; i < viewCountOutput; i++) {
+                m_graphicsPlugin->RenderMotionVectors(projectionLayerViews[i], motionVectorImage, spaceWarpDepthImage,
+                                                      m_spaceWarpInfos[i].motionVectorSubImage.imageArrayIndex, cubes,
+                                                      m_previousCubes);
+            }
+            m_previousCubes.assign(cubes.begin(), cubes.end());
+        }
+        if (m_lateLatchEnabled) {
+            LateLatchViews(viewLocateInfo, locateTime, projectionLayerViews);
+        }
+        // Rendered after the views are latched, as it is head-locked by its layer instead.
+        const bool hudRendered = m_hudSwapchain.handle != XR_NULL_HANDLE && RenderHud();
+        m_graphicsPlugin->EndFrame();
+
+        for (const Swapchain& swapchain : m_swapchains) {
+            XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+            CHECK_XRCMD(xrReleaseSwapchainImage(swapchain.handle, &releaseInfo));
+        }
+        if (depthImage != nullptr) {
             XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
-            CHECK_XRCMD(xrReleaseSwapchainImage(viewSwapchain.handle, &releaseInfo));
+            CHECK_XRCMD(xrReleaseSwapchainImage(m_depthSwapchain.handle, &releaseInfo));
         }
+        if (motionVectorImage != nullptr) {
+            XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+            CHECK_XRCMD(xrReleaseSwapchainImage(m_motionVectorSwapchain.handle, &releaseInfo));
+            CHECK_XRCMD(xrReleaseSwapchainImage(m_spaceWarpDepthSwapchain.handle, &releaseInfo));
+        }
+        if (hudRendered) {
+            XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+            CHECK_XRCMD(xrReleaseSwapchainImage(m_hudSwapchain.handle, &releaseInfo));
+        }
+        m_layerImagesAcquired = false;
 
         layer.space = m_appSpace;
         layer.layerFlags =
@@ -993,6 +1949,140 @@ struct OpenXrProgram : IOpenXrProgram {
         return true;
     }
 
+    // Acquire the next image of each swapchain of the projection layer, unless the ones it has not rendered yet are still
+    // acquired.  Acquiring does not wait for the runtime to be done with an image, so this is done as soon as the images of
+    // a frame are released, and the wait overlaps with the input, xrWaitFrame and the culling of the next frame.
+    void AcquireLayerImages() {
+        if (m_layerImagesAcquired) {
+            return;
+        }
+        const auto acquireImage = [](const Swapchain& swapchain) {
+            XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+            uint32_t swapchainImageIndex;
+            CHECK_XRCMD(xrAcquireSwapchainImage(swapchain.handle, &acquireInfo, &swapchainImageIndex));
+            return swapchainImageIndex;
+        };
+        m_layerImageIndices.resize(m_swapchains.size());
+        for (size_t i = 0; i < m_swapchains.size(); i++) {
+            m_layerImageIndices[i] = acquireImage(m_swapchains[i]);
+        }
+        if (m_depthSwapchain.handle != XR_NULL_HANDLE) {
+            m_depthImageIndex = acquireImage(m_depthSwapchain);
+        }
+        if (m_motionVectorSwapchain.handle != XR_NULL_HANDLE) {
+            m_motionVectorImageIndex = acquireImage(m_motionVectorSwapchain);
+            m_spaceWarpDepthImageIndex = acquireImage(m_spaceWarpDepthSwapchain);
+        }
+        m_layerImagesAcquired = true;
+    }
+
+    // Wait for the images acquired by AcquireLayerImages, right before the graphics plugin renders to them.
+    void WaitLayerImages() {
+        const auto waitImage = [](const Swapchain& swapchain) {
+            XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+            waitInfo.timeout = XR_INFINITE_DURATION;
+            CHECK_XRCMD(xrWaitSwapchainImage(swapchain.handle, &waitInfo));
+        };
+        for (const Swapchain& swapchain : m_swapchains) {
+            waitImage(swapchain);
+        }
+        if (m_depthSwapchain.handle != XR_NULL_HANDLE) {
+            waitImage(m_depthSwapchain);
+        }
+        if (m_motionVectorSwapchain.handle != XR_NULL_HANDLE) {
+            waitImage(m_motionVectorSwapchain);
+            waitImage(m_spaceWarpDepthSwapchain);
+        }
+    }
+
+    // Within a frame of the graphics plugin, render the HUD to the next image of its swapchain if its reading changed since
+    // the image it last rendered, and return whether it did, so the image is released after the frame.  A static image is
+    // only ever rendered once.  The gauge is a row of HudCells cubes, filled up to the render scale, in front of a view
+    // whose frustum takes in the whole row.
+    bool RenderHud() {
+        const int32_t reading = (int32_t)std::lround(m_renderScale.Scale() * HudCells);
+        if (reading == m_hudReading || (m_hudStatic && m_hudReading >= 0)) {
+            return false;
+        }
+
+        XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+        uint32_t swapchainImageIndex;
+        CHECK_XRCMD(xrAcquireSwapchainImage(m_hudSwapchain.handle, &acquireInfo, &swapchainImageIndex));
+
+        XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+        waitInfo.timeout = XR_INFINITE_DURATION;
+        CHECK_XRCMD(xrWaitSwapchainImage(m_hudSwapchain.handle, &waitInfo));
+
+        constexpr float CellWidth = 1.0f / HudCells;  // Of a row one meter wide, one meter in front of the view
+        m_hudCubes.clear();
+        for (int32_t i = 0; i < reading; i++) {
+            const float x = (i + 0.5f) * CellWidth - 0.5f;
+            m_hudCubes.push_back(Cube{Math::Pose::Translation({x, 0.f, -1.f}), {0.8f * CellWidth, 0.8f * CellWidth, 0.01f}});
+        }
+        const float halfWidth = std::atan(0.5f);
+        const float halfHeight = std::atan(0.5f * HudImageHeight / HudImageWidth);
+        XrCompositionLayerProjectionView hudView{XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
+        hudView.pose = Math::Pose::Identity();
+        hudView.fov = {-halfWidth, halfWidth, halfHeight, -halfHeight};
+        hudView.subImage = m_hudLayer.subImage;
+        m_graphicsPlugin->RenderView(hudView, m_hudSwapchainImages[swapchainImageIndex], m_colorSwapchainFormat, m_hudCubes);
+        m_hudReading = reading;
+        return true;
+    }
+
+    // Locate the views of a rendered frame again, right before the graphics plugin submits it, and have the plugin render
+    // the frame from them.  The projection layer views take the new poses, which the compositor reprojects the frame from.
+    // The cubes that may be seen from any of the located views, tested against one frustum that contains them all, so
+    // each view draws only those instead of every cube.  All of them if the views have no such frustum.  With late
+    // latching, they are culled with the views located first.  Allocates nothing once the storage has grown.
+    const std::vector<Cube>& CullCubes(const std::vector<Cube>& cubes) {
+        m_cullPoses.resize(m_views.size());
+        m_cullFovs.resize(m_views.size());
+        for (size_t i = 0; i < m_views.size(); i++) {
+            m_cullPoses[i] = m_views[i].pose;
+            m_cullFovs[i] = m_views[i].fov;
+        }
+        XrVector4f planes[4];
+        if (!XrPosef_CreateCombinedFrustumPlanes(planes, m_cullPoses.data(), m_cullFovs.data(), (uint32_t)m_views.size())) {
+            return cubes;
+        }
+
+        // The bounding sphere of each cube, whose model is a unit cube around its origin.
+        m_cubeSpheres.resize(cubes.size());
+        for (size_t i = 0; i < cubes.size(); i++) {
+            const Cube& cube = cubes[i];
+            m_cubeSpheres[i] = {cube.Pose.position.x, cube.Pose.position.y, cube.Pose.position.z,
+                                0.5f * XrVector3f_Length(&cube.Scale)};
+        }
+        m_visibleCubeIndices.resize(cubes.size());
+        const uint32_t visibleCount = XrVector4f_CullSpheres(m_visibleCubeIndices.data(), planes, 4, m_cubeSpheres.data(),
+                                                             (uint32_t)cubes.size());
+        m_visibleCubes.clear();
+        for (uint32_t i = 0; i < visibleCount; i++) {
+            m_visibleCubes.push_back(cubes[m_visibleCubeIndices[i]]);
+        }
+        return m_visibleCubes;
+    }
+
+    void LateLatchViews(const XrViewLocateInfo& viewLocateInfo, Clock::time_point locateTime,
+                        std::vector<XrCompositionLayerProjectionView>& projectionLayerViews) {
+        if (!XrLateLatch::RelocateViews(m_session, viewLocateInfo, m_latchedViews)) {
+            m_lateLatchStats.RecordUnlatchedFrame();
+            return;
+        }
+        const double milliseconds = MillisecondsBetween(locateTime, Clock::now());
+
+        XrLateLatch::PoseDelta moved;
+        for (size_t i = 0; i < projectionLayerViews.size(); i++) {
+            const XrLateLatch::PoseDelta delta = XrLateLatch::Difference(projectionLayerViews[i].pose, m_latchedViews[i].pose);
+            moved.distance = std::max(moved.distance, delta.distance);
+            moved.angle = std::max(moved.angle, delta.angle);
+            projectionLayerViews[i].pose = m_latchedViews[i].pose;
+        }
+        m_graphicsPlugin->LateLatchViews(projectionLayerViews);
+        m_lateLatchStats.RecordFrame(milliseconds, moved);
+    }
+
    private:
     const std::shared_ptr<const Options> m_options;
     std::shared_ptr<IPlatformPlugin> m_platformPlugin;
@@ -1001,15 +2091,111 @@ struct OpenXrProgram : IOpenXrProgram {
     XrSession m_session{XR_NULL_HANDLE};
     XrSpace m_appSpace{XR_NULL_HANDLE};
     XrSystemId m_systemId{XR_NULL_SYSTEM_ID};
+    bool m_instanceLost{false};  // After XrEventDataInstanceLossPending, when only a new instance can restart
 
     std::vector<XrViewConfigurationView> m_configViews;
     std::vector<Swapchain> m_swapchains;
-    std::map<XrSwapchain, std::vector<XrSwapchainImageBaseHeader*>> m_swapchainImages;
+    bool m_textureArray{false};  // m_swapchains holds one texture array swapchain, with a layer for each view
+    bool m_multiview{false};     // The texture array is rendered to in one pass
+    std::vector<std::vector<XrSwapchainImageBaseHeader*>> m_swapchainImages;  // The images of each of m_swapchains
     std::vector<XrView> m_views;
+    std::vector<XrView> m_latchedViews;  // The views located again by LateLatchViews
     int64_t m_colorSwapchainFormat{-1};
 
+    // With Options::SubmitDepth, when the runtime supports XR_KHR_composition_layer_depth, and the graphics plugin can render
+    // the views to it, one depth swapchain with a layer for each view, and the depth info chained to each projection view.
+    bool m_depthExtensionEnabled{false};
+    Swapchain m_depthSwapchain{XR_NULL_HANDLE, 0, 0};
+    std::vector<XrSwapchainImageBaseHeader*> m_depthSwapchainImages;
+    std::vector<XrCompositionLayerDepthInfoKHR> m_depthInfos;
+
+    // With Options::SpaceWarp, when the runtime supports XR_FB_space_warp and the graphics plugin can render motion vectors,
+    // a motion vector and a depth swapchain with a layer for each view, and the space warp info chained to each projection
+    // view.  The motion vectors are rendered from the cubes of the previous frame to those of the frame.
+    bool m_spaceWarpExtensionEnabled{false};
+    Swapchain m_motionVectorSwapchain{XR_NULL_HANDLE, 0, 0};
+    std::vector<XrSwapchainImageBaseHeader*> m_motionVectorSwapchainImages;
+    Swapchain m_spaceWarpDepthSwapchain{XR_NULL_HANDLE, 0, 0};
+    std::vector<XrSwapchainImageBaseHeader*> m_spaceWarpDepthSwapchainImages;
+    std::vector<XrCompositionLayerSpaceWarpInfoFB> m_spaceWarpInfos;
+    std::vector<Cube> m_previousCubes;
+
+    // The images of the projection layer acquired ahead of the frame that renders them by AcquireLayerImages: one of each
+    // of m_swapchains, and of the depth and space warp swapchains when there are any.
+    bool m_layerImagesAcquired{false};
+    std::vector<uint32_t> m_layerImageIndices;
+    uint32_t m_depthImageIndex{0};
+    uint32_t m_motionVectorImageIndex{0};
+    uint32_t m_spaceWarpDepthImageIndex{0};
+
+    // With Options::Hud, its swapchain, its quad layer in a view space, and the reading of the gauge on the image last
+    // rendered, -1 before the first.  The layer is submitted with that image until the reading changes.
+    static constexpr int32_t HudCells = 10;
+    static constexpr int32_t HudImageWidth = 640;
+    static constexpr int32_t HudImageHeight = 64;
+    static constexpr float HudWidth = 0.5f;  // Meters, of the quad
+    Swapchain m_hudSwapchain{XR_NULL_HANDLE, 0, 0};
+    std::vector<XrSwapchainImageBaseHeader*> m_hudSwapchainImages;
+    bool m_hudStatic{false};
+    XrSpace m_hudSpace{XR_NULL_HANDLE};
+    XrCompositionLayerQuad m_hudLayer{XR_TYPE_COMPOSITION_LAYER_QUAD};
+    int32_t m_hudReading{-1};
+    std::vector<Cube> m_hudCubes;
+
     std::vector<XrSpace> m_visualizedSpaces;
 
+    // The spaces located each frame and their locations, kept so that locating them allocates nothing.
+    std::vector<XrSpace> m_locatedSpaces;
+    std::vector<XrSpaceLocationDataKHR> m_spaceLocations;
+    // Failures to locate them are logged at most once a second.
+    Log::RateLimit m_locateSpaceLogLimit{std::chrono::seconds(1)};
+    std::array<Log::RateLimit, Side::COUNT> m_locateHandLogLimits{
+        {Log::RateLimit{std::chrono::seconds(1)}, Log::RateLimit{std::chrono::seconds(1)}}};
+
+    // Per-frame storage, kept so that a frame reuses the previous frame's allocations.
+    std::vector<XrCompositionLayerBaseHeader*> m_layers;
+    XrCompositionLayerProjection m_layer{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
+    std::vector<XrCompositionLayerProjectionView> m_projectionLayerViews;
+    std::vector<Cube> m_cubes;
+    std::vector<const XrSwapchainImageBaseHeader*> m_viewSwapchainImages;
+    // With Options::Cull, the views and cube bounds culled each frame, and the cubes that are left.
+    std::vector<XrPosef> m_cullPoses;
+    std::vector<XrFovf> m_cullFovs;
+    std::vector<XrVector4f> m_cubeSpheres;
+    std::vector<uint32_t> m_visibleCubeIndices;
+    std::vector<Cube> m_visibleCubes;
+
+    // Frames before this many have rendered may grow the per-frame storage.
+    static constexpr uint64_t AllocationWarmupFrames = 60;
+    uint64_t m_renderedFrameCount{0};
+    uint64_t m_simulatedFrameCount{0};
+
+    // With Options::RenderThread, the frames of a running session are waited for by RenderFrame and handed through
+    // m_frameSlots to m_renderThread, which begins, renders and ends them.
+    bool m_renderThreadEnabled{false};
+    FrameSlotQueue m_frameSlots;
+    std::thread m_renderThread;
+    std::exception_ptr m_renderThreadException;
+
+    // With Options::BenchmarkCubes, the frames waited for so far in the running session, and the times of those submitted.
+    uint64_t m_benchmarkFrameCount{0};
+    BenchmarkStats m_benchmarkStats;
+
+    // With Options::DynamicResolution, the scale of the image rects of the views within their swapchain images.
+    RenderScaleController m_renderScale;
+
+    // With Options::LateLatch, when the graphics plugin supports it; the frames it latched in the running session.
+    bool m_lateLatchEnabled{false};
+    LateLatchStats m_lateLatchStats;
+
+    PFN_xrLocateSpacesKHR m_xrLocateSpacesKHR{nullptr};  // Set when XR_KHR_locate_spaces is enabled
+    // Set when XR_EXT_performance_settings is enabled, with Options::PerformanceLevel
+    PFN_xrPerfSettingsSetPerformanceLevelEXT m_xrPerfSettingsSetPerformanceLevelEXT{nullptr};
+#if defined(XR_USE_PLATFORM_ANDROID)
+    // Set when XR_KHR_android_thread_settings is enabled
+    PFN_xrSetAndroidApplicationThreadKHR m_xrSetAndroidApplicationThreadKHR{nullptr};
+#endif
+
     // Application's current lifecycle state according to the runtime
     XrSessionState m_sessionState{XR_SESSION_STATE_UNKNOWN};
     bool m_sessionRunning{false};
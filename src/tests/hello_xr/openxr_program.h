@@ -26,6 +26,11 @@ struct IOpenXrProgram {
     // Process any events in the event queue.
     virtual void PollEvents(bool* exitRenderLoop, bool* requestRestart) = 0;
 
+    // After PollEvents requested a restart, destroy the session and its swapchains, but keep the instance, the system and the
+    // graphics device with its pipelines and buffers, so that InitializeSession and CreateSwapchains can start another session
+    // quickly.  False if the instance is lost too, or the system is gone, and the whole program must be created again.
+    virtual bool RestartSession() = 0;
+
     // Manage session lifecycle to track if RenderFrame should be called.
     virtual bool IsSessionRunning() const = 0;
 
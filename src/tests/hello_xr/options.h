@@ -52,6 +52,26 @@ inline const char* GetXrEnvironmentBlendModeStr(XrEnvironmentBlendMode environme
     }
 }
 
+// "Default" leaves the performance level to the runtime.
+inline XrPerfSettingsLevelEXT GetXrPerfSettingsLevel(const std::string& performanceLevelStr) {
+    if (EqualsIgnoreCase(performanceLevelStr, "Default")) {
+        return XR_PERF_SETTINGS_LEVEL_MAX_ENUM_EXT;
+    }
+    if (EqualsIgnoreCase(performanceLevelStr, "PowerSavings")) {
+        return XR_PERF_SETTINGS_LEVEL_POWER_SAVINGS_EXT;
+    }
+    if (EqualsIgnoreCase(performanceLevelStr, "SustainedLow")) {
+        return XR_PERF_SETTINGS_LEVEL_SUSTAINED_LOW_EXT;
+    }
+    if (EqualsIgnoreCase(performanceLevelStr, "SustainedHigh")) {
+        return XR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH_EXT;
+    }
+    if (EqualsIgnoreCase(performanceLevelStr, "Boost")) {
+        return XR_PERF_SETTINGS_LEVEL_BOOST_EXT;
+    }
+    throw std::invalid_argument(Fmt("Unknown performance level '%s'", performanceLevelStr.c_str()));
+}
+
 struct Options {
     std::string GraphicsPlugin;
 
@@ -63,18 +83,86 @@ struct Options {
 
     std::string AppSpace{"Local"};
 
+    // Render both stereo views to one texture array swapchain in a single pass, if the graphics plugin supports it.
+    bool Multiview{false};
+
+    // Render the views to the layers of one texture array swapchain, one view at a time, instead of to a swapchain for each
+    // view, so each frame acquires, waits for and releases one swapchain image.  Implied by Multiview.
+    bool TextureArray{false};
+
+    // Wait for frames on the thread that polls events and actions, and render and submit them on a second thread, if the
+    // graphics plugin supports it.
+    bool RenderThread{false};
+
+    // With a cube count, render that many cubes in a fixed pattern that depends only on the frame number, end the session
+    // after BenchmarkFrames frames, and log the frame times.  0 to run normally.
+    uint32_t BenchmarkCubes{0};
+
+    uint32_t BenchmarkFrames{1000};
+
+    // Locate the views of each frame again once it is rendered, just before it is submitted, and render it from those
+    // poses, if the graphics plugin supports it.  How much later, and how far the views moved, is logged.
+    bool LateLatch{false};
+
+    // Draw only the cubes inside one frustum that contains every view, culled once a frame by their bounding spheres.
+    bool Cull{false};
+
+    // Scale the recommended swapchain size of the views by this, in (0, 1], to trade resolution for fill rate and memory
+    // bandwidth.
+    float RenderScale{1.0f};
+
+    // Render the views to less of their swapchain images, down to half their width and height, when the GPU time of the
+    // frames nears the display period, and grow them back when it falls, if the graphics plugin measures GPU time.
+    bool DynamicResolution{false};
+
+    // Prefer the color swapchain formats with the fewest bytes per pixel, and render without multisampling even when the
+    // runtime recommends it.
+    bool LowBandwidth{false};
+
+    // Render depth to a texture array swapchain shared by the views and submit it with XR_KHR_composition_layer_depth, so
+    // the runtime can reproject positionally, if the runtime and graphics plugin support it.
+    bool SubmitDepth{false};
+
+    // Render the motion vectors and depth of the cubes to their own swapchains and submit them with XR_FB_space_warp, so
+    // the runtime can synthesize every other frame from them and the app render at half the display rate, if the runtime
+    // and graphics plugin support it.
+    bool SpaceWarp{false};
+
+    // Record the draws of each view on this many worker threads as well as the rendering thread, each into a secondary
+    // command buffer, once there are enough cubes to share between them (Vulkan).  0 to record them all on one thread.
+    uint32_t RecordThreads{0};
+
+    // Upload the cubes to the GPU as they are and cull and draw them there: a compute shader tests each against the views'
+    // frustum, writes the model transforms of those inside and counts them into an indirect draw (D3D12, Vulkan).
+    bool IndirectDraw{false};
+
+    // Show a HUD, a gauge of the render scale, on a head-locked quad layer of its own swapchain.  It is rendered only when
+    // what it shows changes, and the layer is submitted again as it is otherwise; to a static image swapchain, rendered
+    // once, when it cannot change.
+    bool Hud{false};
+
+    // Directory where the graphics plugin keeps what it caches across runs, like the Vulkan pipeline cache; none if empty.
+    std::string CacheDirectory;
+
+    // The level of the CPU and GPU performance domains requested with XR_EXT_performance_settings, if the runtime supports
+    // it: PowerSavings, SustainedLow, SustainedHigh or Boost.
+    std::string PerformanceLevel{"Default"};
+
     struct {
         XrFormFactor FormFactor{XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY};
 
         XrViewConfigurationType ViewConfigType{XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO};
 
         XrEnvironmentBlendMode EnvironmentBlendMode{XR_ENVIRONMENT_BLEND_MODE_OPAQUE};
+
+        XrPerfSettingsLevelEXT PerformanceLevel{XR_PERF_SETTINGS_LEVEL_MAX_ENUM_EXT};  // Unless requested
     } Parsed;
 
     void ParseStrings() {
         Parsed.FormFactor = GetXrFormFactor(FormFactor);
         Parsed.ViewConfigType = GetXrViewConfigurationType(ViewConfiguration);
         Parsed.EnvironmentBlendMode = GetXrEnvironmentBlendMode(EnvironmentBlendMode);
+        Parsed.PerformanceLevel = GetXrPerfSettingsLevel(PerformanceLevel);
     }
 
     std::array<float, 4> GetBackgroundClearColor() const {
@@ -6,9 +6,13 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdarg>
 #include <cstdio>
+#include <deque>
 #include <exception>
 #include <functional>
 #include <future>
@@ -19,6 +23,7 @@
 #include <locale>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <set>
 #include <string>
@@ -51,6 +56,7 @@
 #include <android/native_window.h>
 #include <jni.h>
 #include <sys/system_properties.h>
+#include <unistd.h>  // For gettid
 #endif
 
 #ifdef XR_USE_PLATFORM_WAYLAND
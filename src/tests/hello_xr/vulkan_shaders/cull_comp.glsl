@@ -0,0 +1,75 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+#version 450
+
+#pragma compute
+
+// Culls the cubes of a view on the GPU: the model transform of each cube whose bounding sphere is inside the frustum planes
+// is written to the instance buffer, after those of the others inside, and counted into the draw's instance count.
+
+layout (local_size_x = 64) in;
+
+layout (std140, push_constant) uniform buf
+{
+    vec4 planes[4];  // Unit normals pointing inside, and distances
+    uint cubeCount;
+} ubuf;
+
+// Each cube as the application's Cube: orientation xyzw, position xyz, scale xyz.
+layout (std430, binding = 0) readonly buffer Cubes
+{
+    float cubes[];
+};
+
+// Per instance vertex data: the columns of the model transform of each visible cube.
+layout (std430, binding = 1) writeonly buffer Models
+{
+    vec4 models[];
+};
+
+layout (std430, binding = 2) buffer DrawIndexedIndirect
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+} draw;
+
+void main()
+{
+    uint cube = gl_GlobalInvocationID.x;
+    if (cube < ubuf.cubeCount) {
+        uint c = cube * 10u;
+        vec4 q = vec4(cubes[c], cubes[c + 1u], cubes[c + 2u], cubes[c + 3u]);
+        vec3 position = vec3(cubes[c + 4u], cubes[c + 5u], cubes[c + 6u]);
+        vec3 scale = vec3(cubes[c + 7u], cubes[c + 8u], cubes[c + 9u]);
+
+        // The cube is a unit cube around its origin.
+        float radius = 0.5 * length(scale);
+        float inside = min(min(dot(ubuf.planes[0].xyz, position) + ubuf.planes[0].w,
+                               dot(ubuf.planes[1].xyz, position) + ubuf.planes[1].w),
+                           min(dot(ubuf.planes[2].xyz, position) + ubuf.planes[2].w,
+                               dot(ubuf.planes[3].xyz, position) + ubuf.planes[3].w));
+        if (inside > -radius) {
+            uint instance = atomicAdd(draw.instanceCount, 1u);
+
+            // As XrMatrix4x4f_CreateTranslationRotationScale.
+            vec3 q2 = q.xyz + q.xyz;
+            float xx2 = q.x * q2.x;
+            float yy2 = q.y * q2.y;
+            float zz2 = q.z * q2.z;
+            float yz2 = q.y * q2.z;
+            float wx2 = q.w * q2.x;
+            float xy2 = q.x * q2.y;
+            float wz2 = q.w * q2.z;
+            float xz2 = q.x * q2.z;
+            float wy2 = q.w * q2.y;
+            models[instance * 4u] = vec4(vec3(1.0 - yy2 - zz2, xy2 + wz2, xz2 - wy2) * scale.x, 0.0);
+            models[instance * 4u + 1u] = vec4(vec3(xy2 - wz2, 1.0 - xx2 - zz2, yz2 + wx2) * scale.y, 0.0);
+            models[instance * 4u + 2u] = vec4(vec3(xz2 + wy2, yz2 - wx2, 1.0 - xx2 - yy2) * scale.z, 0.0);
+            models[instance * 4u + 3u] = vec4(position, 1.0);
+        }
+    }
+}
@@ -0,0 +1,19 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+#version 400
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+#pragma fragment
+
+layout (location = 0) in vec4 oPosition;
+layout (location = 1) in vec4 oPreviousPosition;
+
+// The motion in normalized device coordinates, from the previous position to the current one.
+layout (location = 0) out vec4 MotionVector;
+
+void main()
+{
+    MotionVector = vec4(oPosition.xyz / oPosition.w - oPreviousPosition.xyz / oPreviousPosition.w, 0.0);
+}
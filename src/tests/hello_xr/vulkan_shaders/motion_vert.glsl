@@ -0,0 +1,34 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+#version 400
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+#pragma vertex
+
+// Renders the motion vectors of XR_FB_space_warp: how far each cube moved since the previous frame, seen through the
+// current view.  The motion of the views themselves is not in them; the runtime takes it from the head pose.
+
+layout (std140, push_constant) uniform buf
+{
+    mat4 vp;
+} ubuf;
+
+layout (location = 0) in vec3 Position;
+layout (location = 2) in mat4 Model;          // Per instance: the cube's model transform
+layout (location = 6) in mat4 PreviousModel;  // Per instance: the cube's model transform in the previous frame
+
+layout (location = 0) out vec4 oPosition;
+layout (location = 1) out vec4 oPreviousPosition;
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+void main()
+{
+    oPosition = ubuf.vp * (Model * vec4(Position, 1));
+    oPreviousPosition = ubuf.vp * (PreviousModel * vec4(Position, 1));
+    gl_Position = oPosition;
+}
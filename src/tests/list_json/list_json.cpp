@@ -19,6 +19,7 @@
 #include <cstdio>
 #include <memory>
 #include <sstream>
+#include <string>
 #include <vector>
 
 #include <ctype.h>  // tolower
@@ -37,6 +38,14 @@
 #define LOGI(...) printf(__VA_ARGS__)
 #endif  // defined(XR_USE_PLATFORM_ANDROID)
 
+#if !defined(XR_USE_PLATFORM_ANDROID) && !defined(_WIN32)
+#define LIST_JSON_PROBE_RUNTIMES
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #if defined(XR_USE_PLATFORM_ANDROID)
 static struct android_app* g_app = nullptr;
 #endif
@@ -316,6 +325,138 @@ static int main_body() {
     return 0;
 }
 
+#if defined(LIST_JSON_PROBE_RUNTIMES)
+
+static std::string jsonString(const std::string& value) {
+    std::string quoted = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8]{0};
+            snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+            quoted += buf;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+// A child process reporting on one runtime manifest.
+struct RuntimeProbe {
+    std::string manifest;
+    pid_t pid{-1};
+    int output{-1};  // Read end of the pipe from the child's standard output
+    std::string report;
+    int status{0};
+};
+
+// Report on each runtime manifest in a child process of its own, with XR_RUNTIME_JSON naming it, all at once, and
+// print the reports as one document.  A runtime that crashes or hangs on load cannot affect the others' reports; the
+// whole takes as long as the slowest runtime.
+static int probe_runtimes(int manifestCount, char** manifests) {
+    // Nothing has loaded a runtime yet, so each child starts with only the loader, and the parent stays single-threaded.
+    fflush(stdout);
+    std::vector<RuntimeProbe> probes(manifestCount);
+    for (int i = 0; i < manifestCount; ++i) {
+        RuntimeProbe& probe = probes[i];
+        probe.manifest = manifests[i];
+        int fds[2];
+        if (pipe(fds) != 0) {
+            LOGE("Failed to create a pipe for %s.\n", manifests[i]);
+            continue;
+        }
+        probe.pid = fork();
+        if (probe.pid == 0) {
+            close(fds[0]);
+            if (dup2(fds[1], STDOUT_FILENO) < 0) {
+                _exit(1);
+            }
+            close(fds[1]);
+            setenv("XR_RUNTIME_JSON", manifests[i], 1);
+            int result = main_body();
+            fflush(stdout);
+            _exit(result);
+        }
+        close(fds[1]);
+        if (probe.pid < 0) {
+            LOGE("Failed to start a process for %s.\n", manifests[i]);
+            close(fds[0]);
+            continue;
+        }
+        probe.output = fds[0];
+    }
+
+    // Read every child's output as it comes, so none of them blocks on a full pipe.
+    for (;;) {
+        std::vector<pollfd> fds;
+        std::vector<RuntimeProbe*> readers;
+        for (RuntimeProbe& probe : probes) {
+            if (probe.output >= 0) {
+                fds.push_back({probe.output, POLLIN, 0});
+                readers.push_back(&probe);
+            }
+        }
+        if (fds.empty()) {
+            break;
+        }
+        if (poll(fds.data(), (nfds_t)fds.size(), -1) < 0) {
+            continue;  // Interrupted
+        }
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            char buf[4096];
+            ssize_t count = read(fds[i].fd, buf, sizeof(buf));
+            if (count > 0) {
+                readers[i]->report.append(buf, (size_t)count);
+            } else {
+                close(fds[i].fd);
+                readers[i]->output = -1;
+            }
+        }
+    }
+
+    int result = 0;
+    LOGI("{\n");
+    LOGI("    \"runtimes\": [\n");
+    for (RuntimeProbe& probe : probes) {
+        bool succeeded = false;
+        if (probe.pid > 0 && waitpid(probe.pid, &probe.status, 0) == probe.pid) {
+            succeeded = WIFEXITED(probe.status) && WEXITSTATUS(probe.status) == 0;
+        }
+        LOGI("        {\n");
+        LOGI("            \"manifest\": %s,\n", jsonString(probe.manifest).c_str());
+        if (succeeded) {
+            // Indent the child's document to its place in this one.
+            std::string report;
+            for (char c : probe.report) {
+                report += c;
+                if (c == '\n') {
+                    report += "            ";
+                }
+            }
+            while (!report.empty() && (report.back() == ' ' || report.back() == '\n')) {
+                report.pop_back();
+            }
+            LOGI("            \"report\": %s\n", report.c_str());
+        } else {
+            LOGE("Failed to report on the runtime of %s.\n", probe.manifest.c_str());
+            LOGI("            \"report\": null\n");
+            result = 1;
+        }
+        LOGI("        },\n");
+    }
+    LOGI("    ]\n");
+    LOGI("}\n");
+    return result;
+}
+
+#endif  // defined(LIST_JSON_PROBE_RUNTIMES)
+
 #if defined(XR_USE_PLATFORM_ANDROID)
 
 static void app_handle_cmd(struct android_app*, int32_t) {}
@@ -347,6 +488,17 @@ void android_main(struct android_app* app) {
 
 #else  // !defined(XR_USE_PLATFORM_ANDROID)
 
-int main() { return main_body(); }
+int main(int argc, char** argv) {
+    if (argc > 1) {
+#if defined(LIST_JSON_PROBE_RUNTIMES)
+        return probe_runtimes(argc - 1, argv + 1);
+#else
+        (void)argv;
+        LOGE("Listing runtime manifests is not supported on this platform.\n");
+        return 1;
+#endif
+    }
+    return main_body();
+}
 
 #endif  // defined(XR_USE_PLATFORM_ANDROID)
@@ -0,0 +1,393 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Benchmarks for the loader's cold start, discovery, instance lifetime and dispatch paths, run against the test runtime and the
+// synthetic trees of explicit API layer manifests from src/scripts/generate_manifest_tree.py.  Use a Catch2 reporter
+// for machine-readable results, e.g.
+//     loader_bench -r JSON::out=loader_bench.json
+
+#include "filesystem_utils.hpp"
+#include "loader_test_utils.hpp"
+
+#include <openxr/openxr.h>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(LOADER_COLD_START_PATH)
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+// Set by CMake: the directory holding the trees generated by src/scripts/generate_manifest_tree.py.
+#ifndef LOADER_TEST_MANIFEST_TREES_DIR
+#error "LOADER_TEST_MANIFEST_TREES_DIR must be defined"
+#endif
+
+namespace {
+
+std::string TreeLayerName(uint32_t index) { return "XR_APILAYER_tree_" + std::to_string(index); }
+
+// Point the loader at the test runtime and at the generated manifest tree named tree_name.
+void UseManifestTree(const std::string& tree_name) {
+    std::string tree_dir;
+    FileSysUtilsCombinePaths(LOADER_TEST_MANIFEST_TREES_DIR, tree_name, tree_dir);
+    REQUIRE(LoaderTestUseManifestTree(tree_dir, "XDG_DATA_DIRS"));
+}
+
+// Point the loader at the test runtime and at the generated manifest tree with layer_count layers.
+void UseLayerManifestTree(uint32_t layer_count) { UseManifestTree("layers_" + std::to_string(layer_count)); }
+
+XrInstance CreateBenchInstance(uint32_t enabled_layer_count = 0, const char* const* enabled_layer_names = nullptr) {
+    XrInstanceCreateInfo create_info{XR_TYPE_INSTANCE_CREATE_INFO};
+    strcpy(create_info.applicationInfo.applicationName, "Loader Bench");
+    create_info.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+    create_info.enabledApiLayerCount = enabled_layer_count;
+    create_info.enabledApiLayerNames = enabled_layer_names;
+
+    XrInstance instance = XR_NULL_HANDLE;
+    REQUIRE(XR_SUCCESS == xrCreateInstance(&create_info, &instance));
+    return instance;
+}
+
+}  // namespace
+
+TEST_CASE("xrEnumerateApiLayerProperties", "[discovery]") {
+    const uint32_t layer_count = GENERATE(1u, 10u, 100u);
+    UseLayerManifestTree(layer_count);
+
+    std::vector<XrApiLayerProperties> properties(layer_count, {XR_TYPE_API_LAYER_PROPERTIES});
+    BENCHMARK("xrEnumerateApiLayerProperties/layers=" + std::to_string(layer_count)) {
+        uint32_t count = 0;
+        xrEnumerateApiLayerProperties(0, &count, nullptr);
+        xrEnumerateApiLayerProperties(static_cast<uint32_t>(properties.size()), &count, properties.data());
+        return count;
+    };
+}
+
+TEST_CASE("xrCreateInstance and xrDestroyInstance", "[instance]") {
+    const uint32_t layer_count = GENERATE(1u, 10u, 100u);
+    UseLayerManifestTree(layer_count);
+
+    BENCHMARK("create_destroy/layers=" + std::to_string(layer_count) + "/enabled=0") {
+        xrDestroyInstance(CreateBenchInstance());
+    };
+
+    const std::string layer_name = TreeLayerName(0);
+    const char* const enabled_layer_names[1] = {layer_name.c_str()};
+    BENCHMARK("create_destroy/layers=" + std::to_string(layer_count) + "/enabled=1") {
+        xrDestroyInstance(CreateBenchInstance(1, enabled_layer_names));
+    };
+}
+
+TEST_CASE("xrGetInstanceProcAddr", "[dispatch]") {
+    UseLayerManifestTree(1);
+    XrInstance instance = CreateBenchInstance();
+
+    const char* const command_names[] = {"xrGetSystem",     "xrCreateSession", "xrPollEvent",
+                                         "xrStringToPath",  "xrSyncActions",   "xrLocateSpace",
+                                         "xrWaitFrame",     "xrEndFrame",      "xrCreateDebugUtilsMessengerEXT"};
+    BENCHMARK("xrGetInstanceProcAddr/commands=" + std::to_string(sizeof(command_names) / sizeof(command_names[0]))) {
+        PFN_xrVoidFunction function = nullptr;
+        for (const char* command_name : command_names) {
+            xrGetInstanceProcAddr(instance, command_name, &function);
+        }
+        return function;
+    };
+
+    REQUIRE(XR_SUCCESS == xrDestroyInstance(instance));
+}
+
+// With no layers enabled, xrGetInstanceProcAddr returns the runtime's own functions, so each exported/proc_addr pair
+// measures the loader's per-call overhead: the exported trampoline should add no more than a few nanoseconds.
+TEST_CASE("Trampoline overhead", "[dispatch]") {
+    UseLayerManifestTree(1);
+    const std::string layer_name = TreeLayerName(0);
+    const char* const enabled_layer_names[1] = {layer_name.c_str()};
+    const uint32_t enabled_layer_count = GENERATE(0u, 1u);
+    XrInstance instance = CreateBenchInstance(enabled_layer_count, enabled_layer_names);
+    const std::string suffix = "/enabled_layers=" + std::to_string(enabled_layer_count);
+
+    PFN_xrGetInstanceProperties get_instance_properties = nullptr;
+    REQUIRE(XR_SUCCESS ==
+            xrGetInstanceProcAddr(instance, "xrGetInstanceProperties", reinterpret_cast<PFN_xrVoidFunction*>(&get_instance_properties)));
+    PFN_xrPollEvent poll_event = nullptr;
+    REQUIRE(XR_SUCCESS == xrGetInstanceProcAddr(instance, "xrPollEvent", reinterpret_cast<PFN_xrVoidFunction*>(&poll_event)));
+    PFN_xrStringToPath string_to_path = nullptr;
+    REQUIRE(XR_SUCCESS ==
+            xrGetInstanceProcAddr(instance, "xrStringToPath", reinterpret_cast<PFN_xrVoidFunction*>(&string_to_path)));
+    XrInstanceProperties instance_properties{XR_TYPE_INSTANCE_PROPERTIES};
+
+    BENCHMARK("xrGetInstanceProperties/exported" + suffix) { return xrGetInstanceProperties(instance, &instance_properties); };
+    BENCHMARK("xrGetInstanceProperties/proc_addr" + suffix) { return get_instance_properties(instance, &instance_properties); };
+
+    XrEventDataBuffer event_data{XR_TYPE_EVENT_DATA_BUFFER};
+    BENCHMARK("xrPollEvent/exported" + suffix) {
+        event_data.type = XR_TYPE_EVENT_DATA_BUFFER;
+        return xrPollEvent(instance, &event_data);
+    };
+    BENCHMARK("xrPollEvent/proc_addr" + suffix) {
+        event_data.type = XR_TYPE_EVENT_DATA_BUFFER;
+        return poll_event(instance, &event_data);
+    };
+
+    XrPath path = XR_NULL_PATH;
+    BENCHMARK("xrStringToPath/exported" + suffix) { return xrStringToPath(instance, "/user/hand/left", &path); };
+    BENCHMARK("xrStringToPath/proc_addr" + suffix) { return string_to_path(instance, "/user/hand/left", &path); };
+
+    REQUIRE(XR_SUCCESS == xrDestroyInstance(instance));
+}
+
+// The label trampolines are noexcept and, with no recorder showing labels, do not allocate.  The test runtime does not
+// provide these commands, so the session handle is never dereferenced, but each call also asks the runtime for them.
+TEST_CASE("Label trampoline overhead", "[dispatch]") {
+    UseLayerManifestTree(1);
+    const char* const enabled_extension_names[1] = {XR_EXT_DEBUG_UTILS_EXTENSION_NAME};
+    XrInstanceCreateInfo create_info{XR_TYPE_INSTANCE_CREATE_INFO};
+    strcpy(create_info.applicationInfo.applicationName, "Loader Bench");
+    create_info.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+    create_info.enabledExtensionCount = 1;
+    create_info.enabledExtensionNames = enabled_extension_names;
+    XrInstance instance = XR_NULL_HANDLE;
+    REQUIRE(XR_SUCCESS == xrCreateInstance(&create_info, &instance));
+
+    PFN_xrSessionInsertDebugUtilsLabelEXT insert_label = nullptr;
+    REQUIRE(XR_SUCCESS ==
+            xrGetInstanceProcAddr(instance, "xrSessionInsertDebugUtilsLabelEXT", reinterpret_cast<PFN_xrVoidFunction*>(&insert_label)));
+    PFN_xrSessionBeginDebugUtilsLabelRegionEXT begin_region = nullptr;
+    REQUIRE(XR_SUCCESS == xrGetInstanceProcAddr(instance, "xrSessionBeginDebugUtilsLabelRegionEXT",
+                                                reinterpret_cast<PFN_xrVoidFunction*>(&begin_region)));
+    PFN_xrSessionEndDebugUtilsLabelRegionEXT end_region = nullptr;
+    REQUIRE(XR_SUCCESS == xrGetInstanceProcAddr(instance, "xrSessionEndDebugUtilsLabelRegionEXT",
+                                                reinterpret_cast<PFN_xrVoidFunction*>(&end_region)));
+
+    const XrSession session = (XrSession)1;  // A pointer or an integer, depending on the platform.
+    XrDebugUtilsLabelEXT label{XR_TYPE_DEBUG_UTILS_LABEL_EXT};
+    label.labelName = "frame";
+    BENCHMARK("xrSessionInsertDebugUtilsLabelEXT") { return insert_label(session, &label); };
+    BENCHMARK("xrSessionBeginDebugUtilsLabelRegionEXT/xrSessionEndDebugUtilsLabelRegionEXT") {
+        begin_region(session, &label);
+        return end_region(session);
+    };
+
+    REQUIRE(XR_SUCCESS == xrDestroyInstance(instance));
+}
+
+#if defined(LOADER_COLD_START_PATH)
+namespace {
+
+// Run loader_cold_start in a new process with its output discarded, and wait for it to exit.
+int RunColdStart(bool skip_load) {
+    const char* argv[] = {LOADER_COLD_START_PATH, skip_load ? "--skip-load" : nullptr, nullptr};
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    pid_t pid = 0;
+    int status = -1;
+    if (posix_spawn(&pid, LOADER_COLD_START_PATH, &actions, nullptr, const_cast<char* const*>(argv), environ) == 0) {
+        waitpid(pid, &status, 0);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    return status;
+}
+
+}  // namespace
+
+// What loading the loader costs a short-lived process: launching loader_cold_start alone, and launching it to dlopen
+// the loader and make the first call.  The difference is the loader's mapping, relocations, static constructors and
+// first-call setup; run loader_cold_start directly for the split between them.
+TEST_CASE("Cold start", "[startup]") {
+    UseLayerManifestTree(1);
+    REQUIRE(RunColdStart(false) == 0);
+
+    BENCHMARK("process") { return RunColdStart(true); };
+    BENCHMARK("process+dlopen+xrEnumerateInstanceExtensionProperties") { return RunColdStart(false); };
+}
+#endif  // defined(LOADER_COLD_START_PATH)
+
+namespace {
+
+// A headless session of the test runtime, begun, with the spaces a frame loop locates.
+struct BenchSession {
+    XrInstance instance{XR_NULL_HANDLE};
+    XrSession session{XR_NULL_HANDLE};
+    XrSpace view_space{XR_NULL_HANDLE};
+    XrSpace local_space{XR_NULL_HANDLE};
+};
+
+BenchSession CreateBenchSession(const std::vector<std::string>& layer_names) {
+    std::vector<const char*> enabled_layer_names;
+    for (const std::string& layer_name : layer_names) {
+        enabled_layer_names.push_back(layer_name.c_str());
+    }
+    const char* const enabled_extension_names[1] = {XR_MND_HEADLESS_EXTENSION_NAME};
+    XrInstanceCreateInfo create_info{XR_TYPE_INSTANCE_CREATE_INFO};
+    strcpy(create_info.applicationInfo.applicationName, "Loader Bench");
+    create_info.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+    create_info.enabledApiLayerCount = static_cast<uint32_t>(enabled_layer_names.size());
+    create_info.enabledApiLayerNames = enabled_layer_names.data();
+    create_info.enabledExtensionCount = 1;
+    create_info.enabledExtensionNames = enabled_extension_names;
+
+    BenchSession bench;
+    REQUIRE(XR_SUCCESS == xrCreateInstance(&create_info, &bench.instance));
+
+    XrSystemGetInfo system_info{XR_TYPE_SYSTEM_GET_INFO};
+    system_info.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
+    XrSystemId system_id = XR_NULL_SYSTEM_ID;
+    REQUIRE(XR_SUCCESS == xrGetSystem(bench.instance, &system_info, &system_id));
+
+    XrSessionCreateInfo session_info{XR_TYPE_SESSION_CREATE_INFO};
+    session_info.systemId = system_id;
+    REQUIRE(XR_SUCCESS == xrCreateSession(bench.instance, &session_info, &bench.session));
+
+    XrReferenceSpaceCreateInfo space_info{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+    space_info.poseInReferenceSpace.orientation.w = 1.0f;
+    space_info.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
+    REQUIRE(XR_SUCCESS == xrCreateReferenceSpace(bench.session, &space_info, &bench.view_space));
+    space_info.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+    REQUIRE(XR_SUCCESS == xrCreateReferenceSpace(bench.session, &space_info, &bench.local_space));
+
+    XrSessionBeginInfo begin_info{XR_TYPE_SESSION_BEGIN_INFO};
+    begin_info.primaryViewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+    REQUIRE(XR_SUCCESS == xrBeginSession(bench.session, &begin_info));
+    return bench;
+}
+
+void DestroyBenchSession(BenchSession& bench) {
+    REQUIRE(XR_SUCCESS == xrDestroySpace(bench.local_space));
+    REQUIRE(XR_SUCCESS == xrDestroySpace(bench.view_space));
+    REQUIRE(XR_SUCCESS == xrDestroySession(bench.session));
+    REQUIRE(XR_SUCCESS == xrDestroyInstance(bench.instance));
+}
+
+// The median over several batches of the nanoseconds per call of function, so a preempted batch does not count.
+template <typename Function>
+double MedianNanosecondsPerCall(Function&& function) {
+    constexpr size_t batch_count = 21;
+    constexpr size_t calls_per_batch = 2000;
+    std::vector<double> batches;
+    for (size_t batch = 0; batch < batch_count; ++batch) {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t call = 0; call < calls_per_batch; ++call) {
+            function();
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        batches.push_back(elapsed.count() / calls_per_batch);
+    }
+    std::nth_element(batches.begin(), batches.begin() + batch_count / 2, batches.end());
+    return batches[batch_count / 2];
+}
+
+// Per-call latency of the frame loop commands through one layer chain.
+struct FrameLoopTimes {
+    double frame{0};  // xrWaitFrame, xrBeginFrame and xrEndFrame
+    double locate_space{0};
+    double poll_event{0};
+};
+
+FrameLoopTimes MeasureFrameLoop(const std::vector<std::string>& layer_names) {
+    BenchSession bench = CreateBenchSession(layer_names);
+    FrameLoopTimes times;
+
+    XrFrameState frame_state{XR_TYPE_FRAME_STATE};
+    XrFrameEndInfo end_info{XR_TYPE_FRAME_END_INFO};
+    end_info.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+    times.frame = MedianNanosecondsPerCall([&] {
+        frame_state.type = XR_TYPE_FRAME_STATE;
+        xrWaitFrame(bench.session, nullptr, &frame_state);
+        xrBeginFrame(bench.session, nullptr);
+        end_info.displayTime = frame_state.predictedDisplayTime;
+        xrEndFrame(bench.session, &end_info);
+    });
+    REQUIRE(frame_state.predictedDisplayTime > 0);
+
+    XrSpaceLocation location{XR_TYPE_SPACE_LOCATION};
+    const XrTime time = frame_state.predictedDisplayTime;
+    times.locate_space = MedianNanosecondsPerCall([&] {
+        location.type = XR_TYPE_SPACE_LOCATION;
+        xrLocateSpace(bench.view_space, bench.local_space, time, &location);
+    });
+
+    XrEventDataBuffer event_data{XR_TYPE_EVENT_DATA_BUFFER};
+    times.poll_event = MedianNanosecondsPerCall([&] {
+        event_data.type = XR_TYPE_EVENT_DATA_BUFFER;
+        xrPollEvent(bench.instance, &event_data);
+    });
+
+    DestroyBenchSession(bench);
+    return times;
+}
+
+void PrintFrameLoopCost(const char* chain, size_t layer_count, const FrameLoopTimes& times, const FrameLoopTimes& baseline) {
+    const double per_layer = layer_count == 0 ? 1.0 : static_cast<double>(layer_count);
+    std::printf("%-46s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", chain, times.frame, times.locate_space, times.poll_event,
+                (times.frame - baseline.frame) / per_layer, (times.locate_space - baseline.locate_space) / per_layer,
+                (times.poll_event - baseline.poll_event) / per_layer);
+}
+
+}  // namespace
+
+// The per-layer overhead budget: the frame loop commands through stacks of 1 to 8 copies of the passthrough test layer,
+// each a separate module, and through each SDK layer, over the test runtime.  The table gives the nanoseconds per call
+// and, against no layers, the marginal cost of each layer.  api_dump is measured filtered, excluding the commands
+// timed, as it would be left enabled; core_validation and best_practices intercept everything.
+TEST_CASE("Layer chain overhead", "[layers]") {
+    UseManifestTree("layer_chain");
+
+    std::string dump_file;
+    FileSysUtilsCombinePaths(LOADER_TEST_MANIFEST_TREES_DIR, "layer_chain", dump_file);
+    FileSysUtilsCombinePaths(dump_file, "api_dump.txt", dump_file);
+    REQUIRE(LoaderTestSetEnvironmentVariable("XR_API_DUMP_FILE_NAME", dump_file));
+    REQUIRE(LoaderTestSetEnvironmentVariable("XR_API_DUMP_EXCLUDE", "xrWaitFrame,xrBeginFrame,xrEndFrame,xrLocateSpace,xrPollEvent"));
+
+    const FrameLoopTimes baseline = MeasureFrameLoop({});
+    std::printf("\n%-46s %10s %10s %10s %10s %10s %10s\n", "ns per call", "frame", "locate", "poll",
+                "frame/lyr", "locate/lyr", "poll/lyr");
+    PrintFrameLoopCost("no layers", 0, baseline, baseline);
+
+    for (const size_t copy_count : {1, 2, 4, 8}) {
+        std::vector<std::string> layer_names;
+        for (uint32_t copy = 0; copy < copy_count; ++copy) {
+            layer_names.push_back(TreeLayerName(copy));
+        }
+        const std::string chain = "test layer x" + std::to_string(copy_count);
+        PrintFrameLoopCost(chain.c_str(), copy_count, MeasureFrameLoop(layer_names), baseline);
+    }
+
+    const char* const sdk_layer_names[] = {"XR_APILAYER_LUNARG_core_validation", "XR_APILAYER_LUNARG_api_dump",
+                                           "XR_APILAYER_KHRONOS_best_practices_validation"};
+    for (const char* layer_name : sdk_layer_names) {
+        PrintFrameLoopCost(layer_name, 1, MeasureFrameLoop({layer_name}), baseline);
+    }
+    std::fflush(stdout);
+
+    LoaderTestUnsetEnvironmentVariable("XR_API_DUMP_EXCLUDE");
+    LoaderTestUnsetEnvironmentVariable("XR_API_DUMP_FILE_NAME");
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// The loader's cold start as a short-lived tool such as openxr_runtime_list sees it: in a fresh process, the time from
+// dlopen of the loader (mapping, relocation and static constructors) to the return of its first call,
+// xrEnumerateInstanceExtensionProperties.  It deliberately does not link the loader.  loader_bench runs it in a loop
+// for the [startup] benchmark, with --skip-load for the cost of the process launch alone.
+
+#include <openxr/openxr.h>
+
+#include <dlfcn.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Set by CMake: the path of the loader library built alongside.
+#ifndef OPENXR_LOADER_PATH
+#error "OPENXR_LOADER_PATH must be defined"
+#endif
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--skip-load") == 0) {
+        return 0;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    void* loader = dlopen(OPENXR_LOADER_PATH, RTLD_NOW | RTLD_LOCAL);
+    if (loader == nullptr) {
+        std::fprintf(stderr, "dlopen failed: %s\n", dlerror());
+        return 1;
+    }
+    const auto loaded = std::chrono::steady_clock::now();
+
+    auto enumerate_extensions =
+        reinterpret_cast<PFN_xrEnumerateInstanceExtensionProperties>(dlsym(loader, "xrEnumerateInstanceExtensionProperties"));
+    if (enumerate_extensions == nullptr) {
+        std::fprintf(stderr, "dlsym failed: %s\n", dlerror());
+        return 1;
+    }
+    uint32_t extension_count = 0;
+    const XrResult result = enumerate_extensions(nullptr, 0, &extension_count, nullptr);
+    const auto called = std::chrono::steady_clock::now();
+
+    using Microseconds = std::chrono::duration<double, std::micro>;
+    std::printf("dlopen %.1f us, first call %.1f us, total %.1f us (result %d, %u extensions)\n",
+                Microseconds(loaded - start).count(), Microseconds(called - loaded).count(), Microseconds(called - start).count(),
+                static_cast<int>(result), extension_count);
+    return 0;
+}
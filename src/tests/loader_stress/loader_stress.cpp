@@ -0,0 +1,318 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Stress test of the loader and the SDK layers under calls from many threads at once, against the test runtime.  Each
+// thread calls the commands an application makes from its render and input threads, on one shared session, and the
+// table printed gives the throughput from 1 to N threads and how often a call stalled, which is what serialization on
+// a lock looks like from outside.  Set XR_LOADER_STRESS_MS to the milliseconds each step runs, longer for stable
+// numbers.  Built with -DSANITIZE_THREAD=ON, the short run that CTest does checks the same paths for data races.
+
+#include "filesystem_utils.hpp"
+#include "loader_test_utils.hpp"
+
+#include <openxr/openxr.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Set by CMake: the directory holding the trees generated by src/scripts/generate_manifest_tree.py.
+#ifndef LOADER_TEST_MANIFEST_TREES_DIR
+#error "LOADER_TEST_MANIFEST_TREES_DIR must be defined"
+#endif
+
+namespace {
+
+// A call taking longer than this is counted as a stall: far more than any of these commands takes uncontended.
+constexpr std::chrono::microseconds kStallThreshold{50};
+
+std::atomic<uint32_t> g_error_messages{0};
+
+XRAPI_ATTR XrBool32 XRAPI_CALL CountErrorMessages(XrDebugUtilsMessageSeverityFlagsEXT messageSeverity,
+                                                  XrDebugUtilsMessageTypeFlagsEXT /*messageTypes*/,
+                                                  const XrDebugUtilsMessengerCallbackDataEXT* callbackData, void* /*userData*/) {
+    if ((messageSeverity & XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) != 0) {
+        std::fprintf(stderr, "%s: %s\n", callbackData->functionName, callbackData->message);
+        ++g_error_messages;
+    }
+    return XR_FALSE;
+}
+
+// A headless session of the test runtime, begun, with the spaces and actions the threads query.
+struct StressSession {
+    XrInstance instance{XR_NULL_HANDLE};
+    XrDebugUtilsMessengerEXT messenger{XR_NULL_HANDLE};
+    XrSession session{XR_NULL_HANDLE};
+    XrSpace view_space{XR_NULL_HANDLE};
+    XrSpace local_space{XR_NULL_HANDLE};
+    XrActionSet action_set{XR_NULL_HANDLE};
+    XrAction select_action{XR_NULL_HANDLE};
+    XrAction squeeze_action{XR_NULL_HANDLE};
+    PFN_xrSessionInsertDebugUtilsLabelEXT insert_label{nullptr};
+};
+
+XrAction CreateStressAction(XrActionSet action_set, XrActionType action_type, const char* name) {
+    XrActionCreateInfo action_info{XR_TYPE_ACTION_CREATE_INFO};
+    action_info.actionType = action_type;
+    strcpy(action_info.actionName, name);
+    strcpy(action_info.localizedActionName, name);
+    XrAction action = XR_NULL_HANDLE;
+    REQUIRE(XR_SUCCESS == xrCreateAction(action_set, &action_info, &action));
+    return action;
+}
+
+// With a debug messenger, the loader also records the labels of the session, as it does for an application that
+// shows them in its messages.
+StressSession CreateStressSession(const char* layer_name, bool with_messenger) {
+    const char* const enabled_extension_names[2] = {XR_MND_HEADLESS_EXTENSION_NAME, XR_EXT_DEBUG_UTILS_EXTENSION_NAME};
+    XrInstanceCreateInfo create_info{XR_TYPE_INSTANCE_CREATE_INFO};
+    strcpy(create_info.applicationInfo.applicationName, "Loader Stress");
+    create_info.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+    create_info.enabledApiLayerCount = layer_name == nullptr ? 0 : 1;
+    create_info.enabledApiLayerNames = &layer_name;
+    create_info.enabledExtensionCount = 2;
+    create_info.enabledExtensionNames = enabled_extension_names;
+
+    StressSession stress;
+    REQUIRE(XR_SUCCESS == xrCreateInstance(&create_info, &stress.instance));
+
+    if (with_messenger) {
+        PFN_xrCreateDebugUtilsMessengerEXT create_messenger = nullptr;
+        REQUIRE(XR_SUCCESS == xrGetInstanceProcAddr(stress.instance, "xrCreateDebugUtilsMessengerEXT",
+                                                    reinterpret_cast<PFN_xrVoidFunction*>(&create_messenger)));
+        XrDebugUtilsMessengerCreateInfoEXT messenger_info{XR_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT};
+        messenger_info.messageSeverities = XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+        messenger_info.messageTypes = XR_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | XR_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+                                      XR_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+        messenger_info.userCallback = CountErrorMessages;
+        REQUIRE(XR_SUCCESS == create_messenger(stress.instance, &messenger_info, &stress.messenger));
+    }
+    REQUIRE(XR_SUCCESS == xrGetInstanceProcAddr(stress.instance, "xrSessionInsertDebugUtilsLabelEXT",
+                                                reinterpret_cast<PFN_xrVoidFunction*>(&stress.insert_label)));
+
+    XrSystemGetInfo system_info{XR_TYPE_SYSTEM_GET_INFO};
+    system_info.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
+    XrSystemId system_id = XR_NULL_SYSTEM_ID;
+    REQUIRE(XR_SUCCESS == xrGetSystem(stress.instance, &system_info, &system_id));
+
+    XrSessionCreateInfo session_info{XR_TYPE_SESSION_CREATE_INFO};
+    session_info.systemId = system_id;
+    REQUIRE(XR_SUCCESS == xrCreateSession(stress.instance, &session_info, &stress.session));
+
+    XrReferenceSpaceCreateInfo space_info{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+    space_info.poseInReferenceSpace.orientation.w = 1.0f;
+    space_info.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
+    REQUIRE(XR_SUCCESS == xrCreateReferenceSpace(stress.session, &space_info, &stress.view_space));
+    space_info.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+    REQUIRE(XR_SUCCESS == xrCreateReferenceSpace(stress.session, &space_info, &stress.local_space));
+
+    XrActionSetCreateInfo action_set_info{XR_TYPE_ACTION_SET_CREATE_INFO};
+    strcpy(action_set_info.actionSetName, "stress");
+    strcpy(action_set_info.localizedActionSetName, "Stress");
+    REQUIRE(XR_SUCCESS == xrCreateActionSet(stress.instance, &action_set_info, &stress.action_set));
+    stress.select_action = CreateStressAction(stress.action_set, XR_ACTION_TYPE_BOOLEAN_INPUT, "select");
+    stress.squeeze_action = CreateStressAction(stress.action_set, XR_ACTION_TYPE_FLOAT_INPUT, "squeeze");
+    XrSessionActionSetsAttachInfo attach_info{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
+    attach_info.countActionSets = 1;
+    attach_info.actionSets = &stress.action_set;
+    REQUIRE(XR_SUCCESS == xrAttachSessionActionSets(stress.session, &attach_info));
+
+    XrSessionBeginInfo begin_info{XR_TYPE_SESSION_BEGIN_INFO};
+    begin_info.primaryViewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+    REQUIRE(XR_SUCCESS == xrBeginSession(stress.session, &begin_info));
+    return stress;
+}
+
+void DestroyStressSession(StressSession& stress) {
+    REQUIRE(XR_SUCCESS == xrDestroyActionSet(stress.action_set));
+    REQUIRE(XR_SUCCESS == xrDestroySpace(stress.local_space));
+    REQUIRE(XR_SUCCESS == xrDestroySpace(stress.view_space));
+    REQUIRE(XR_SUCCESS == xrDestroySession(stress.session));
+    if (stress.messenger != XR_NULL_HANDLE) {
+        PFN_xrDestroyDebugUtilsMessengerEXT destroy_messenger = nullptr;
+        REQUIRE(XR_SUCCESS == xrGetInstanceProcAddr(stress.instance, "xrDestroyDebugUtilsMessengerEXT",
+                                                    reinterpret_cast<PFN_xrVoidFunction*>(&destroy_messenger)));
+        REQUIRE(XR_SUCCESS == destroy_messenger(stress.messenger));
+    }
+    REQUIRE(XR_SUCCESS == xrDestroyInstance(stress.instance));
+}
+
+// What one thread did during a step.  Kept per thread and summed afterwards, so counting is not itself contended.
+struct ThreadCounts {
+    uint64_t calls{0};
+    uint64_t failures{0};
+    uint64_t stalls{0};
+    std::chrono::nanoseconds max_latency{0};
+};
+
+// Call each command in turn until stop is set, timing every call.
+void StressThread(const StressSession& stress, const std::atomic<bool>& start, const std::atomic<bool>& stop,
+                  ThreadCounts& counts) {
+    XrSpaceLocation location{XR_TYPE_SPACE_LOCATION};
+    XrActionStateGetInfo select_info{XR_TYPE_ACTION_STATE_GET_INFO};
+    select_info.action = stress.select_action;
+    XrActionStateGetInfo squeeze_info{XR_TYPE_ACTION_STATE_GET_INFO};
+    squeeze_info.action = stress.squeeze_action;
+    XrActionStateBoolean boolean_state{XR_TYPE_ACTION_STATE_BOOLEAN};
+    XrActionStateFloat float_state{XR_TYPE_ACTION_STATE_FLOAT};
+    XrDebugUtilsLabelEXT label{XR_TYPE_DEBUG_UTILS_LABEL_EXT};
+    label.labelName = "stress";
+    PFN_xrVoidFunction function = nullptr;
+
+    auto timed = [&counts](XrResult result, std::chrono::steady_clock::time_point call_start) {
+        const std::chrono::nanoseconds latency = std::chrono::steady_clock::now() - call_start;
+        ++counts.calls;
+        if (XR_FAILED(result)) {
+            ++counts.failures;
+        }
+        if (latency > kStallThreshold) {
+            ++counts.stalls;
+        }
+        counts.max_latency = std::max(counts.max_latency, latency);
+    };
+
+    while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    while (!stop.load(std::memory_order_relaxed)) {
+        auto call_start = std::chrono::steady_clock::now();
+        location.type = XR_TYPE_SPACE_LOCATION;
+        timed(xrLocateSpace(stress.view_space, stress.local_space, 1, &location), call_start);
+
+        call_start = std::chrono::steady_clock::now();
+        timed(xrGetActionStateBoolean(stress.session, &select_info, &boolean_state), call_start);
+
+        call_start = std::chrono::steady_clock::now();
+        timed(xrGetActionStateFloat(stress.session, &squeeze_info, &float_state), call_start);
+
+        call_start = std::chrono::steady_clock::now();
+        timed(xrGetInstanceProcAddr(stress.instance, "xrLocateSpace", &function), call_start);
+
+        call_start = std::chrono::steady_clock::now();
+        timed(stress.insert_label(stress.session, &label), call_start);
+    }
+}
+
+ThreadCounts RunStep(const StressSession& stress, size_t thread_count, std::chrono::milliseconds duration,
+                     std::chrono::duration<double>& elapsed) {
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+    std::vector<ThreadCounts> counts(thread_count);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back(StressThread, std::cref(stress), std::cref(start), std::cref(stop), std::ref(counts[i]));
+    }
+
+    const auto step_start = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(duration);
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    elapsed = std::chrono::steady_clock::now() - step_start;
+
+    ThreadCounts total;
+    for (const ThreadCounts& thread_counts : counts) {
+        total.calls += thread_counts.calls;
+        total.failures += thread_counts.failures;
+        total.stalls += thread_counts.stalls;
+        total.max_latency = std::max(total.max_latency, thread_counts.max_latency);
+    }
+    return total;
+}
+
+std::chrono::milliseconds StepDuration() {
+    std::string value;
+    if (LoaderTestGetEnvironmentVariable("XR_LOADER_STRESS_MS", value) && !value.empty()) {
+        return std::chrono::milliseconds(std::max(1L, std::strtol(value.c_str(), nullptr, 10)));
+    }
+    return std::chrono::milliseconds(50);
+}
+
+}  // namespace
+
+// Scaling is the throughput against that of one thread times the thread count, so 1.0 is perfect scaling and
+// 1/threads is full serialization; it cannot exceed the share of the hardware threads that are free.  api_dump is run
+// filtered, excluding the commands called, as it would be left enabled.
+TEST_CASE("Concurrent calls", "[stress]") {
+    std::string tree_dir;
+    FileSysUtilsCombinePaths(LOADER_TEST_MANIFEST_TREES_DIR, "layer_chain", tree_dir);
+    REQUIRE(LoaderTestUseManifestTree(tree_dir, "XDG_DATA_DIRS"));
+    std::string dump_file;
+    FileSysUtilsCombinePaths(tree_dir, "api_dump_stress.txt", dump_file);
+    REQUIRE(LoaderTestSetEnvironmentVariable("XR_API_DUMP_FILE_NAME", dump_file));
+    REQUIRE(LoaderTestSetEnvironmentVariable(
+        "XR_API_DUMP_EXCLUDE",
+        "xrLocateSpace,xrGetActionStateBoolean,xrGetActionStateFloat,xrGetInstanceProcAddr,xrSessionInsertDebugUtilsLabelEXT"));
+
+    struct Chain {
+        const char* description;
+        const char* layer_name;
+        bool with_messenger;
+    };
+    const Chain chains[] = {
+        {"no layers", nullptr, false},
+        {"no layers, messenger", nullptr, true},
+        {"XR_APILAYER_LUNARG_core_validation", "XR_APILAYER_LUNARG_core_validation", true},
+        {"XR_APILAYER_LUNARG_api_dump", "XR_APILAYER_LUNARG_api_dump", true},
+        {"XR_APILAYER_KHRONOS_best_practices_validation", "XR_APILAYER_KHRONOS_best_practices_validation", true},
+    };
+
+    const size_t max_threads = std::min<size_t>(16, std::max<size_t>(2, std::thread::hardware_concurrency()));
+    const std::chrono::milliseconds duration = StepDuration();
+    std::printf("\nhardware threads: %u, %lld ms per step, stall: over %lld us\n", std::thread::hardware_concurrency(),
+                static_cast<long long>(duration.count()), static_cast<long long>(kStallThreshold.count()));
+    std::printf("%-46s %8s %10s %8s %10s %10s\n", "chain", "threads", "Mcalls/s", "scaling", "stalls", "max us");
+
+    for (const Chain& chain : chains) {
+        g_error_messages = 0;
+        StressSession stress = CreateStressSession(chain.layer_name, chain.with_messenger);
+        double single_thread_rate = 0;
+        for (size_t thread_count = 1;; thread_count = std::min(thread_count * 2, max_threads)) {
+            std::chrono::duration<double> elapsed{};
+            const ThreadCounts counts = RunStep(stress, thread_count, duration, elapsed);
+            const double rate = static_cast<double>(counts.calls) / elapsed.count();
+            if (thread_count == 1) {
+                single_thread_rate = rate;
+            }
+            std::printf("%-46s %8zu %10.2f %8.2f %10llu %10.1f\n", chain.description, thread_count, rate / 1e6,
+                        rate / (single_thread_rate * static_cast<double>(thread_count)),
+                        static_cast<unsigned long long>(counts.stalls),
+                        std::chrono::duration<double, std::micro>(counts.max_latency).count());
+            CHECK(counts.calls > 0);
+            CHECK(counts.failures == 0);
+            if (thread_count == max_threads) {
+                break;
+            }
+        }
+        std::fflush(stdout);
+        DestroyStressSession(stress);
+        CHECK(g_error_messages == 0);
+    }
+
+    LoaderTestUnsetEnvironmentVariable("XR_API_DUMP_EXCLUDE");
+    LoaderTestUnsetEnvironmentVariable("XR_API_DUMP_FILE_NAME");
+}
@@ -403,6 +403,45 @@ TEST_CASE("TestEnumLayers", "") {
     CleanupEnvironmentVariables();
 }
 
+#if defined(LOADER_TEST_MANIFEST_TREES_DIR)
+// Test layer discovery over the synthetic manifest trees from generate_manifest_tree.py.
+TEST_CASE("TestEnumLayersManifestTree", "") {
+    struct ManifestTree {
+        const char* name;
+        uint32_t layer_count;
+    };
+    const ManifestTree trees[] = {{"layers_100", 100}, {"malformed", 10}};
+    for (const ManifestTree& tree : trees) {
+        INFO("Manifest tree " << tree.name);
+        std::string tree_dir;
+        FileSysUtilsCombinePaths(LOADER_TEST_MANIFEST_TREES_DIR, tree.name, tree_dir);
+        REQUIRE(LoaderTestUseManifestTree(tree_dir, "XDG_DATA_DIRS"));
+
+        uint32_t layer_count = 0;
+        REQUIRE(XR_SUCCESS == xrEnumerateApiLayerProperties(0, &layer_count, nullptr));
+        std::vector<XrApiLayerProperties> layer_props(layer_count, {XR_TYPE_API_LAYER_PROPERTIES});
+        REQUIRE(XR_SUCCESS == xrEnumerateApiLayerProperties(layer_count, &layer_count, layer_props.data()));
+
+        // Every generated layer is found exactly once, whichever search directory it lives in.
+        for (uint32_t layer = 0; layer < tree.layer_count; ++layer) {
+            const std::string layer_name = "XR_APILAYER_tree_" + std::to_string(layer);
+            INFO("Looking for " << layer_name);
+            CHECK(1 == std::count_if(layer_props.begin(), layer_props.end(), [&](const XrApiLayerProperties& prop) {
+                      return layer_name == prop.layerName;
+                  }));
+        }
+        CHECK_THAT(layer_props, !VectorContainsPredicate<XrApiLayerProperties>(
+                                    [](const XrApiLayerProperties& prop) {
+                                        return std::string::npos != std::string(prop.layerName).find("_badjson");
+                                    },
+                                    "layer name mentions _badjson"));
+    }
+
+    // Cleanup
+    CleanupEnvironmentVariables();
+}
+#endif  // defined(LOADER_TEST_MANIFEST_TREES_DIR)
+
 // Test the xrEnumerateInstanceExtensionProperties function through the loader.
 TEST_CASE("TestEnumInstanceExtensions", "") {
     XrResult test_result = XR_SUCCESS;
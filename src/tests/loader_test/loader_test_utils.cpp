@@ -25,6 +25,7 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <fstream>
 
 #if defined(XR_OS_WINDOWS)
 
@@ -102,3 +103,22 @@ bool LoaderTestUnsetEnvironmentVariable(const std::string& /*variable*/) { retur
 #error "Unsupported platform"
 
 #endif
+
+bool LoaderTestUseManifestTree(const std::string& tree_dir, const std::string& skip_variable) {
+    std::ifstream env_file(tree_dir + TEST_DIRECTORY_SYMBOL + "manifest_tree.env");
+    if (!env_file) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(env_file, line)) {
+        const std::string::size_type equals = line.find('=');
+        if (equals == std::string::npos) {
+            continue;
+        }
+        const std::string variable = line.substr(0, equals);
+        if (variable != skip_variable && !LoaderTestSetEnvironmentVariable(variable, line.substr(equals + 1))) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -39,3 +39,7 @@
 bool LoaderTestSetEnvironmentVariable(const std::string& variable, const std::string& value);
 bool LoaderTestGetEnvironmentVariable(const std::string& variable, std::string& value);
 bool LoaderTestUnsetEnvironmentVariable(const std::string& variable);
+
+// Set the environment variables listed in <tree_dir>/manifest_tree.env, written by
+// src/scripts/generate_manifest_tree.py.  skip_variable, if given, is left alone.
+bool LoaderTestUseManifestTree(const std::string& tree_dir, const std::string& skip_variable = {});
@@ -0,0 +1,1042 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Replays a binary capture of the api_dump layer (XR_API_DUMP_EXPORT_TYPE=binary) through the loader, against whichever
+// runtime and API layers are active, and reports the latency of each command.  A captured session becomes a
+// repeatable benchmark for runtimes, layers and the loader, without the application that made it.
+//
+// The capture holds what each call was given, and, since version 3, the handles, system ids, paths and predicted
+// display times calls returned.  The replay maps those to the ones its own calls return, so later calls refer to the
+// replay's objects, and it shifts captured times by the difference between the captured and replayed xrWaitFrame.
+//
+// Only what replays without the application's renderer is replayed: the instance, system, session, spaces, actions and
+// the frame loop.  The session is created headless, with XR_MND_headless, so xrEndFrame is replayed without its
+// composition layers, and swapchain and graphics commands are skipped, along with every command not listed in
+// kReplayedCommands and every call referring to an object the replay does not have.  Calls of all threads are replayed
+// on one thread, in the order of the capture.
+
+#include "api_dump_format.h"
+#include "hex_and_handles.h"
+
+#if defined(XR_LAYER_RECORD_GZIP)
+#include "layer_record_gzip.h"
+#endif
+
+#include <openxr/openxr.h>
+#include <openxr/openxr_reflection.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// How long a session waits for the state the application saw before xrBeginSession or xrEndSession.
+constexpr std::chrono::seconds kSessionStateTimeout{5};
+
+#define REPLAY_ENUM_VALUE(name, value) {#name, value},
+
+// The enums the replayed commands take, by the names api_dump writes for them.
+const std::unordered_map<std::string, int64_t> kEnumValues = {
+    XR_LIST_ENUM_XrFormFactor(REPLAY_ENUM_VALUE)             //
+    XR_LIST_ENUM_XrViewConfigurationType(REPLAY_ENUM_VALUE)  //
+    XR_LIST_ENUM_XrEnvironmentBlendMode(REPLAY_ENUM_VALUE)   //
+    XR_LIST_ENUM_XrReferenceSpaceType(REPLAY_ENUM_VALUE)     //
+    XR_LIST_ENUM_XrActionType(REPLAY_ENUM_VALUE)             //
+};
+
+#undef REPLAY_ENUM_VALUE
+
+// The parameters and members of one captured call by name, with "->" written as ".", like "createInfo.systemId".
+class CapturedCall {
+   public:
+    explicit CapturedCall(const ApiDumpContents &contents) {
+        for (size_t entry = 1; entry < contents.size(); ++entry) {
+            std::string name = std::get<1>(contents[entry]);
+            for (size_t arrow = name.find("->"); arrow != std::string::npos; arrow = name.find("->", arrow)) {
+                name.replace(arrow, 2, ".");
+            }
+            values_[name] = std::get<2>(contents[entry]);
+        }
+    }
+
+    const std::string &String(const std::string &name) const {
+        static const std::string empty;
+        auto found = values_.find(name);
+        return found != values_.end() ? found->second : empty;
+    }
+
+    // Integers, handles and atoms: written in hexadecimal with "0x", or in decimal.
+    uint64_t Integer(const std::string &name) const { return std::strtoull(String(name).c_str(), nullptr, 0); }
+
+    int64_t Time(const std::string &name) const { return std::strtoll(String(name).c_str(), nullptr, 10); }
+
+    float Float(const std::string &name) const { return std::strtof(String(name).c_str(), nullptr); }
+
+    // Enums: written by name, or as a number when api_dump does not know the value.
+    int64_t Enum(const std::string &name) const {
+        const std::string &value = String(name);
+        auto found = kEnumValues.find(value);
+        return found != kEnumValues.end() ? found->second : std::strtoll(value.c_str(), nullptr, 0);
+    }
+
+    XrPosef Pose(const std::string &name) const {
+        XrPosef pose;
+        pose.orientation = {Float(name + ".orientation.x"), Float(name + ".orientation.y"), Float(name + ".orientation.z"),
+                            Float(name + ".orientation.w")};
+        pose.position = {Float(name + ".position.x"), Float(name + ".position.y"), Float(name + ".position.z")};
+        return pose;
+    }
+
+    // Copy a captured string into a fixed size array of a structure.
+    template <size_t size>
+    void CopyString(const std::string &name, char (&destination)[size]) const {
+        const std::string &value = String(name);
+        const size_t length = std::min(value.size(), size - 1);
+        memcpy(destination, value.data(), length);
+        destination[length] = '\0';
+    }
+
+   private:
+    std::unordered_map<std::string, std::string> values_;
+};
+
+// The replay's own handles and atoms, by the captured ones, per type: "XrSession", "XrSystemId", "XrPath" and so on.
+class HandleMap {
+   public:
+    void Add(const std::string &type, uint64_t captured, uint64_t live) { live_[type][captured] = live; }
+
+    void Remove(const std::string &type, uint64_t captured) { live_[type].erase(captured); }
+
+    // A null handle or atom maps to itself.
+    bool Find(const std::string &type, uint64_t captured, uint64_t &live) const {
+        if (captured == 0) {
+            live = 0;
+            return true;
+        }
+        auto of_type = live_.find(type);
+        if (of_type == live_.end()) {
+            return false;
+        }
+        auto found = of_type->second.find(captured);
+        if (found == of_type->second.end()) {
+            return false;
+        }
+        live = found->second;
+        return true;
+    }
+
+   private:
+    std::unordered_map<std::string, std::unordered_map<uint64_t, uint64_t>> live_;
+};
+
+struct CommandLatency {
+    std::vector<uint64_t> nanoseconds;
+    uint64_t failed = 0;
+};
+
+class Replayer {
+   public:
+    explicit Replayer(bool original_timing) : original_timing_(original_timing) {}
+
+    Replayer(const Replayer &) = delete;
+    Replayer &operator=(const Replayer &) = delete;
+
+    ~Replayer() {
+        // A capture cut short leaves its instances behind.
+        for (XrInstance instance : instances_) {
+            xrDestroyInstance(instance);
+        }
+    }
+
+    // Returns false when the replay cannot go on, with the reason in Error().
+    bool Call(const ApiDumpContents &contents, const ApiDumpCallStamp &stamp, bool stamped);
+
+    // Map what the last call of a thread returned to what its replay returned.
+    void Outputs(const ApiDumpContents &contents, const ApiDumpCallStamp &stamp);
+
+    void Report(std::ostream &out) const;
+
+    const std::string &Error() const { return error_; }
+
+   private:
+    using Handler = bool (Replayer::*)(const CapturedCall &);
+    static const std::map<std::string, Handler> kReplayedCommands;
+
+    // Time one call of the runtime, for the report.
+    template <typename Call>
+    XrResult Timed(Call &&call) {
+        const auto start = std::chrono::steady_clock::now();
+        const XrResult result = call();
+        const auto end = std::chrono::steady_clock::now();
+        CommandLatency &latency = latencies_[command_];
+        latency.nanoseconds.push_back(
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        if (XR_FAILED(result)) {
+            ++latency.failed;
+        }
+        return result;
+    }
+
+    template <typename T>
+    bool Live(const CapturedCall &call, const char *type, const std::string &name, T &live) const {
+        uint64_t value = 0;
+        if (!handles_.Find(type, call.Integer(name), value)) {
+            return false;
+        }
+        live = TreatIntegerAsHandle<T>(value);
+        return true;
+    }
+
+    bool LivePath(const CapturedCall &call, const std::string &name, XrPath &live) const {
+        return handles_.Find("XrPath", call.Integer(name), live);
+    }
+
+    XrTime LiveTime(const CapturedCall &call, const std::string &name) const { return call.Time(name) + time_offset_; }
+
+    void Output(uint64_t live) { outputs_.push_back(live); }
+
+    void SetSessionState(const XrEventDataBuffer &event);
+    bool WaitForSessionState(XrSession session, XrSessionState state);
+
+    bool CreateInstance(const CapturedCall &call);
+    bool DestroyInstance(const CapturedCall &call);
+    bool GetInstanceProcAddr(const CapturedCall &call);
+    bool GetSystem(const CapturedCall &call);
+    bool GetSystemProperties(const CapturedCall &call);
+    bool GetInstanceProperties(const CapturedCall &call);
+    bool PollEvent(const CapturedCall &call);
+    bool EnumerateViewConfigurations(const CapturedCall &call);
+    bool EnumerateViewConfigurationViews(const CapturedCall &call);
+    bool EnumerateEnvironmentBlendModes(const CapturedCall &call);
+    bool StringToPath(const CapturedCall &call);
+    bool CreateSession(const CapturedCall &call);
+    bool DestroySession(const CapturedCall &call);
+    bool BeginSession(const CapturedCall &call);
+    bool EndSession(const CapturedCall &call);
+    bool RequestExitSession(const CapturedCall &call);
+    bool EnumerateReferenceSpaces(const CapturedCall &call);
+    bool CreateReferenceSpace(const CapturedCall &call);
+    bool CreateActionSpace(const CapturedCall &call);
+    bool DestroySpace(const CapturedCall &call);
+    bool LocateSpace(const CapturedCall &call);
+    bool LocateViews(const CapturedCall &call);
+    bool WaitFrame(const CapturedCall &call);
+    bool BeginFrame(const CapturedCall &call);
+    bool EndFrame(const CapturedCall &call);
+    bool CreateActionSet(const CapturedCall &call);
+    bool DestroyActionSet(const CapturedCall &call);
+    bool CreateAction(const CapturedCall &call);
+    bool DestroyAction(const CapturedCall &call);
+    bool SuggestInteractionProfileBindings(const CapturedCall &call);
+    bool AttachSessionActionSets(const CapturedCall &call);
+    bool SyncActions(const CapturedCall &call);
+    bool GetActionStateBoolean(const CapturedCall &call);
+    bool GetActionStateFloat(const CapturedCall &call);
+    bool GetActionStateVector2f(const CapturedCall &call);
+    bool GetActionStatePose(const CapturedCall &call);
+
+    const bool original_timing_;
+    std::chrono::steady_clock::time_point replay_start_;
+    uint64_t capture_start_ns_ = 0;
+    bool started_ = false;
+
+    // The command being replayed, and the handles and times it returned, in the order of its outputs in the capture.
+    std::string command_;
+    std::vector<uint64_t> outputs_;
+    // The last call replayed on each captured thread, for its outputs record.
+    struct LastCall {
+        std::string command;
+        std::vector<uint64_t> outputs;
+    };
+    std::unordered_map<uint32_t, LastCall> last_calls_;
+
+    HandleMap handles_;
+    // Added to captured times: the replayed predicted display time of the last xrWaitFrame, less the captured one.
+    int64_t time_offset_ = 0;
+    std::vector<XrInstance> instances_;
+    std::unordered_map<XrSession, XrSessionState> session_states_;
+
+    std::map<std::string, CommandLatency> latencies_;
+    std::map<std::string, uint64_t> skipped_;
+    uint64_t outputs_records_ = 0;
+    std::string error_;
+};
+
+const std::map<std::string, Replayer::Handler> Replayer::kReplayedCommands = {
+    {"xrCreateInstance", &Replayer::CreateInstance},
+    {"xrDestroyInstance", &Replayer::DestroyInstance},
+    {"xrGetInstanceProcAddr", &Replayer::GetInstanceProcAddr},
+    {"xrGetSystem", &Replayer::GetSystem},
+    {"xrGetSystemProperties", &Replayer::GetSystemProperties},
+    {"xrGetInstanceProperties", &Replayer::GetInstanceProperties},
+    {"xrPollEvent", &Replayer::PollEvent},
+    {"xrEnumerateViewConfigurations", &Replayer::EnumerateViewConfigurations},
+    {"xrEnumerateViewConfigurationViews", &Replayer::EnumerateViewConfigurationViews},
+    {"xrEnumerateEnvironmentBlendModes", &Replayer::EnumerateEnvironmentBlendModes},
+    {"xrStringToPath", &Replayer::StringToPath},
+    {"xrCreateSession", &Replayer::CreateSession},
+    {"xrDestroySession", &Replayer::DestroySession},
+    {"xrBeginSession", &Replayer::BeginSession},
+    {"xrEndSession", &Replayer::EndSession},
+    {"xrRequestExitSession", &Replayer::RequestExitSession},
+    {"xrEnumerateReferenceSpaces", &Replayer::EnumerateReferenceSpaces},
+    {"xrCreateReferenceSpace", &Replayer::CreateReferenceSpace},
+    {"xrCreateActionSpace", &Replayer::CreateActionSpace},
+    {"xrDestroySpace", &Replayer::DestroySpace},
+    {"xrLocateSpace", &Replayer::LocateSpace},
+    {"xrLocateViews", &Replayer::LocateViews},
+    {"xrWaitFrame", &Replayer::WaitFrame},
+    {"xrBeginFrame", &Replayer::BeginFrame},
+    {"xrEndFrame", &Replayer::EndFrame},
+    {"xrCreateActionSet", &Replayer::CreateActionSet},
+    {"xrDestroyActionSet", &Replayer::DestroyActionSet},
+    {"xrCreateAction", &Replayer::CreateAction},
+    {"xrDestroyAction", &Replayer::DestroyAction},
+    {"xrSuggestInteractionProfileBindings", &Replayer::SuggestInteractionProfileBindings},
+    {"xrAttachSessionActionSets", &Replayer::AttachSessionActionSets},
+    {"xrSyncActions", &Replayer::SyncActions},
+    {"xrGetActionStateBoolean", &Replayer::GetActionStateBoolean},
+    {"xrGetActionStateFloat", &Replayer::GetActionStateFloat},
+    {"xrGetActionStateVector2f", &Replayer::GetActionStateVector2f},
+    {"xrGetActionStatePose", &Replayer::GetActionStatePose},
+};
+
+bool Replayer::Call(const ApiDumpContents &contents, const ApiDumpCallStamp &stamp, bool stamped) {
+    // Markers the layer writes, like the start of the flight recorder's calls, are not calls.
+    if (contents.empty() || std::get<0>(contents[0]) == "api_dump") {
+        return true;
+    }
+    command_ = std::get<1>(contents[0]);
+    LastCall &last_call = last_calls_[stamped ? stamp.thread : 0];
+    last_call.command.clear();
+
+    auto handler = kReplayedCommands.find(command_);
+    if (handler == kReplayedCommands.end()) {
+        ++skipped_[command_];
+        return true;
+    }
+
+    if (original_timing_) {
+        if (!stamped) {
+            error_ = "the capture has no call times to replay with --timing original";
+            return false;
+        }
+        if (!started_) {
+            started_ = true;
+            replay_start_ = std::chrono::steady_clock::now();
+            capture_start_ns_ = stamp.time_ns;
+        }
+        std::this_thread::sleep_until(replay_start_ + std::chrono::nanoseconds(stamp.time_ns - capture_start_ns_));
+    }
+
+    outputs_.clear();
+    if (!(this->*handler->second)(CapturedCall(contents))) {
+        ++skipped_[command_];
+        return error_.empty();
+    }
+    last_call.command = command_;
+    last_call.outputs = outputs_;
+    return true;
+}
+
+void Replayer::Outputs(const ApiDumpContents &contents, const ApiDumpCallStamp &stamp) {
+    ++outputs_records_;
+    const LastCall &last_call = last_calls_[stamp.thread];
+    // Outputs of a call that was skipped, or that failed in the replay, have nothing to map to.
+    if (contents.empty() || std::get<1>(contents[0]) != last_call.command) {
+        return;
+    }
+    for (size_t entry = 1; entry < contents.size() && entry - 1 < last_call.outputs.size(); ++entry) {
+        const std::string &type = std::get<0>(contents[entry]);
+        const std::string &value = std::get<2>(contents[entry]);
+        const uint64_t live = last_call.outputs[entry - 1];
+        if (type == "XrTime") {
+            time_offset_ = static_cast<int64_t>(live) - std::strtoll(value.c_str(), nullptr, 10);
+        } else {
+            handles_.Add(type, std::strtoull(value.c_str(), nullptr, 0), live);
+        }
+    }
+}
+
+void Replayer::Report(std::ostream &out) const {
+    uint64_t replayed = 0;
+    for (const auto &latency : latencies_) {
+        replayed += latency.second.nanoseconds.size();
+    }
+    uint64_t skipped = 0;
+    for (const auto &command : skipped_) {
+        skipped += command.second;
+    }
+
+    char line[256];
+    snprintf(line, sizeof(line), "# openxr_replay: %" PRIu64 " calls replayed, %" PRIu64 " skipped\n", replayed, skipped);
+    out << line;
+    snprintf(line, sizeof(line), "%-40s %10s %8s %12s %12s %12s %12s\n", "command", "calls", "failed", "mean_us", "p50_us",
+             "p99_us", "max_us");
+    out << line;
+    for (const auto &command : latencies_) {
+        std::vector<uint64_t> sorted = command.second.nanoseconds;
+        std::sort(sorted.begin(), sorted.end());
+        uint64_t total = 0;
+        for (uint64_t nanoseconds : sorted) {
+            total += nanoseconds;
+        }
+        auto percentile = [&sorted](size_t percent) {
+            return static_cast<double>(sorted[(sorted.size() - 1) * percent / 100]) / 1000.0;
+        };
+        snprintf(line, sizeof(line), "%-40s %10zu %8" PRIu64 " %12.2f %12.2f %12.2f %12.2f\n", command.first.c_str(),
+                 sorted.size(), command.second.failed, static_cast<double>(total) / static_cast<double>(sorted.size()) / 1000.0,
+                 percentile(50), percentile(99), static_cast<double>(sorted.back()) / 1000.0);
+        out << line;
+    }
+    if (!skipped_.empty()) {
+        out << "# skipped:";
+        for (const auto &command : skipped_) {
+            out << " " << command.first << " (" << command.second << ")";
+        }
+        out << "\n";
+    }
+    if (outputs_records_ == 0 && skipped != 0) {
+        out << "# the capture records no outputs: capture it again with an api_dump layer writing version 3 captures\n";
+    }
+}
+
+void Replayer::SetSessionState(const XrEventDataBuffer &event) {
+    if (event.type == XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED) {
+        const auto &changed = reinterpret_cast<const XrEventDataSessionStateChanged &>(event);
+        session_states_[changed.session] = changed.state;
+    }
+}
+
+// The application began and ended its session once the runtime told it to: wait for the same before replaying those.
+bool Replayer::WaitForSessionState(XrSession session, XrSessionState state) {
+    const auto timeout = std::chrono::steady_clock::now() + kSessionStateTimeout;
+    while (session_states_[session] != state) {
+        if (std::chrono::steady_clock::now() > timeout) {
+            return false;
+        }
+        bool polled = false;
+        for (XrInstance instance : instances_) {
+            XrEventDataBuffer event{XR_TYPE_EVENT_DATA_BUFFER};
+            if (xrPollEvent(instance, &event) == XR_SUCCESS) {
+                SetSessionState(event);
+                polled = true;
+            }
+        }
+        if (!polled) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return true;
+}
+
+bool Replayer::CreateInstance(const CapturedCall &call) {
+    const uint32_t layer_count = static_cast<uint32_t>(call.Integer("info.enabledApiLayerCount"));
+    std::vector<std::string> layers;
+    for (uint32_t layer = 0; layer < layer_count; ++layer) {
+        layers.push_back(call.String("info.enabledApiLayerNames[" + std::to_string(layer) + "]"));
+    }
+
+    // The extensions the runtime and the enabled layers offer: the others the application enabled are left out.
+    std::vector<std::string> available;
+    auto add_available = [&available](const char *layer) {
+        uint32_t count = 0;
+        if (XR_FAILED(xrEnumerateInstanceExtensionProperties(layer, 0, &count, nullptr))) {
+            return;
+        }
+        std::vector<XrExtensionProperties> properties(count, {XR_TYPE_EXTENSION_PROPERTIES});
+        if (XR_SUCCEEDED(xrEnumerateInstanceExtensionProperties(layer, count, &count, properties.data()))) {
+            for (uint32_t extension = 0; extension < count; ++extension) {
+                available.push_back(properties[extension].extensionName);
+            }
+        }
+    };
+    add_available(nullptr);
+    for (const std::string &layer : layers) {
+        add_available(layer.c_str());
+    }
+    if (std::find(available.begin(), available.end(), XR_MND_HEADLESS_EXTENSION_NAME) == available.end()) {
+        error_ = "the runtime does not offer " XR_MND_HEADLESS_EXTENSION_NAME ", which the replay's sessions need";
+        return false;
+    }
+
+    std::vector<std::string> extensions{XR_MND_HEADLESS_EXTENSION_NAME};
+    const uint32_t extension_count = static_cast<uint32_t>(call.Integer("info.enabledExtensionCount"));
+    for (uint32_t extension = 0; extension < extension_count; ++extension) {
+        std::string name = call.String("info.enabledExtensionNames[" + std::to_string(extension) + "]");
+        if (std::find(available.begin(), available.end(), name) == available.end()) {
+            std::cerr << "openxr_replay: leaving out " << name << ", which is not offered\n";
+        } else if (std::find(extensions.begin(), extensions.end(), name) == extensions.end()) {
+            extensions.push_back(std::move(name));
+        }
+    }
+
+    std::vector<const char *> layer_names;
+    for (const std::string &layer : layers) {
+        layer_names.push_back(layer.c_str());
+    }
+    std::vector<const char *> extension_names;
+    for (const std::string &extension : extensions) {
+        extension_names.push_back(extension.c_str());
+    }
+
+    XrInstanceCreateInfo create_info{XR_TYPE_INSTANCE_CREATE_INFO};
+    call.CopyString("info.applicationInfo.applicationName", create_info.applicationInfo.applicationName);
+    create_info.applicationInfo.applicationVersion = static_cast<uint32_t>(call.Integer("info.applicationInfo.applicationVersion"));
+    call.CopyString("info.applicationInfo.engineName", create_info.applicationInfo.engineName);
+    create_info.applicationInfo.engineVersion = static_cast<uint32_t>(call.Integer("info.applicationInfo.engineVersion"));
+    create_info.applicationInfo.apiVersion = call.Integer("info.applicationInfo.apiVersion");
+    create_info.enabledApiLayerCount = static_cast<uint32_t>(layer_names.size());
+    create_info.enabledApiLayerNames = layer_names.data();
+    create_info.enabledExtensionCount = static_cast<uint32_t>(extension_names.size());
+    create_info.enabledExtensionNames = extension_names.data();
+    XrInstance instance = XR_NULL_HANDLE;
+    if (XR_SUCCEEDED(Timed([&] { return xrCreateInstance(&create_info, &instance); }))) {
+        instances_.push_back(instance);
+        Output(MakeHandleGeneric(instance));
+    }
+    return true;
+}
+
+bool Replayer::DestroyInstance(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    if (!Live(call, "XrInstance", "instance", instance)) {
+        return false;
+    }
+    Timed([&] { return xrDestroyInstance(instance); });
+    instances_.erase(std::remove(instances_.begin(), instances_.end(), instance), instances_.end());
+    handles_.Remove("XrInstance", call.Integer("instance"));
+    return true;
+}
+
+bool Replayer::GetInstanceProcAddr(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    if (!Live(call, "XrInstance", "instance", instance)) {
+        return false;
+    }
+    const std::string &name = call.String("name");
+    PFN_xrVoidFunction function = nullptr;
+    Timed([&] { return xrGetInstanceProcAddr(instance, name.c_str(), &function); });
+    return true;
+}
+
+bool Replayer::GetSystem(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    if (!Live(call, "XrInstance", "instance", instance)) {
+        return false;
+    }
+    XrSystemGetInfo get_info{XR_TYPE_SYSTEM_GET_INFO};
+    get_info.formFactor = static_cast<XrFormFactor>(call.Enum("getInfo.formFactor"));
+    XrSystemId system_id = XR_NULL_SYSTEM_ID;
+    if (XR_SUCCEEDED(Timed([&] { return xrGetSystem(instance, &get_info, &system_id); }))) {
+        Output(system_id);
+    }
+    return true;
+}
+
+bool Replayer::GetSystemProperties(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    XrSystemId system_id = XR_NULL_SYSTEM_ID;
+    if (!Live(call, "XrInstance", "instance", instance) || !handles_.Find("XrSystemId", call.Integer("systemId"), system_id)) {
+        return false;
+    }
+    XrSystemProperties properties{XR_TYPE_SYSTEM_PROPERTIES};
+    Timed([&] { return xrGetSystemProperties(instance, system_id, &properties); });
+    return true;
+}
+
+bool Replayer::GetInstanceProperties(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    if (!Live(call, "XrInstance", "instance", instance)) {
+        return false;
+    }
+    XrInstanceProperties properties{XR_TYPE_INSTANCE_PROPERTIES};
+    Timed([&] { return xrGetInstanceProperties(instance, &properties); });
+    return true;
+}
+
+bool Replayer::PollEvent(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    if (!Live(call, "XrInstance", "instance", instance)) {
+        return false;
+    }
+    XrEventDataBuffer event{XR_TYPE_EVENT_DATA_BUFFER};
+    if (Timed([&] { return xrPollEvent(instance, &event); }) == XR_SUCCESS) {
+        SetSessionState(event);
+    }
+    return true;
+}
+
+bool Replayer::EnumerateViewConfigurations(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    XrSystemId system_id = XR_NULL_SYSTEM_ID;
+    if (!Live(call, "XrInstance", "instance", instance) || !handles_.Find("XrSystemId", call.Integer("systemId"), system_id)) {
+        return false;
+    }
+    const uint32_t capacity = static_cast<uint32_t>(call.Integer("viewConfigurationTypeCapacityInput"));
+    std::vector<XrViewConfigurationType> types(capacity);
+    uint32_t count = 0;
+    Timed([&] { return xrEnumerateViewConfigurations(instance, system_id, capacity, &count, capacity ? types.data() : nullptr); });
+    return true;
+}
+
+bool Replayer::EnumerateViewConfigurationViews(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    XrSystemId system_id = XR_NULL_SYSTEM_ID;
+    if (!Live(call, "XrInstance", "instance", instance) || !handles_.Find("XrSystemId", call.Integer("systemId"), system_id)) {
+        return false;
+    }
+    const auto type = static_cast<XrViewConfigurationType>(call.Enum("viewConfigurationType"));
+    const uint32_t capacity = static_cast<uint32_t>(call.Integer("viewCapacityInput"));
+    std::vector<XrViewConfigurationView> views(capacity, {XR_TYPE_VIEW_CONFIGURATION_VIEW});
+    uint32_t count = 0;
+    Timed([&] {
+        return xrEnumerateViewConfigurationViews(instance, system_id, type, capacity, &count, capacity ? views.data() : nullptr);
+    });
+    return true;
+}
+
+bool Replayer::EnumerateEnvironmentBlendModes(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    XrSystemId system_id = XR_NULL_SYSTEM_ID;
+    if (!Live(call, "XrInstance", "instance", instance) || !handles_.Find("XrSystemId", call.Integer("systemId"), system_id)) {
+        return false;
+    }
+    const auto type = static_cast<XrViewConfigurationType>(call.Enum("viewConfigurationType"));
+    const uint32_t capacity = static_cast<uint32_t>(call.Integer("environmentBlendModeCapacityInput"));
+    std::vector<XrEnvironmentBlendMode> modes(capacity);
+    uint32_t count = 0;
+    Timed([&] {
+        return xrEnumerateEnvironmentBlendModes(instance, system_id, type, capacity, &count, capacity ? modes.data() : nullptr);
+    });
+    return true;
+}
+
+bool Replayer::StringToPath(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    if (!Live(call, "XrInstance", "instance", instance)) {
+        return false;
+    }
+    const std::string &path_string = call.String("pathString");
+    XrPath path = XR_NULL_PATH;
+    if (XR_SUCCEEDED(Timed([&] { return xrStringToPath(instance, path_string.c_str(), &path); }))) {
+        Output(path);
+    }
+    return true;
+}
+
+bool Replayer::CreateSession(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    XrSystemId system_id = XR_NULL_SYSTEM_ID;
+    if (!Live(call, "XrInstance", "instance", instance) ||
+        !handles_.Find("XrSystemId", call.Integer("createInfo.systemId"), system_id)) {
+        return false;
+    }
+    // Without a graphics binding, which XR_MND_headless allows.
+    XrSessionCreateInfo create_info{XR_TYPE_SESSION_CREATE_INFO};
+    create_info.systemId = system_id;
+    XrSession session = XR_NULL_HANDLE;
+    if (XR_SUCCEEDED(Timed([&] { return xrCreateSession(instance, &create_info, &session); }))) {
+        session_states_[session] = XR_SESSION_STATE_UNKNOWN;
+        Output(MakeHandleGeneric(session));
+    }
+    return true;
+}
+
+bool Replayer::DestroySession(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    if (!Live(call, "XrSession", "session", session)) {
+        return false;
+    }
+    Timed([&] { return xrDestroySession(session); });
+    session_states_.erase(session);
+    handles_.Remove("XrSession", call.Integer("session"));
+    return true;
+}
+
+bool Replayer::BeginSession(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    if (!Live(call, "XrSession", "session", session)) {
+        return false;
+    }
+    if (!WaitForSessionState(session, XR_SESSION_STATE_READY)) {
+        std::cerr << "openxr_replay: the session did not become ready to begin\n";
+    }
+    XrSessionBeginInfo begin_info{XR_TYPE_SESSION_BEGIN_INFO};
+    begin_info.primaryViewConfigurationType = static_cast<XrViewConfigurationType>(call.Enum("beginInfo.primaryViewConfigurationType"));
+    Timed([&] { return xrBeginSession(session, &begin_info); });
+    return true;
+}
+
+bool Replayer::EndSession(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    if (!Live(call, "XrSession", "session", session)) {
+        return false;
+    }
+    if (!WaitForSessionState(session, XR_SESSION_STATE_STOPPING)) {
+        std::cerr << "openxr_replay: the session did not start stopping to end\n";
+    }
+    Timed([&] { return xrEndSession(session); });
+    return true;
+}
+
+bool Replayer::RequestExitSession(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    if (!Live(call, "XrSession", "session", session)) {
+        return false;
+    }
+    Timed([&] { return xrRequestExitSession(session); });
+    return true;
+}
+
+bool Replayer::EnumerateReferenceSpaces(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    if (!Live(call, "XrSession", "session", session)) {
+        return false;
+    }
+    const uint32_t capacity = static_cast<uint32_t>(call.Integer("spaceCapacityInput"));
+    std::vector<XrReferenceSpaceType> spaces(capacity);
+    uint32_t count = 0;
+    Timed([&] { return xrEnumerateReferenceSpaces(session, capacity, &count, capacity ? spaces.data() : nullptr); });
+    return true;
+}
+
+bool Replayer::CreateReferenceSpace(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    if (!Live(call, "XrSession", "session", session)) {
+        return false;
+    }
+    XrReferenceSpaceCreateInfo create_info{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+    create_info.referenceSpaceType = static_cast<XrReferenceSpaceType>(call.Enum("createInfo.referenceSpaceType"));
+    create_info.poseInReferenceSpace = call.Pose("createInfo.poseInReferenceSpace");
+    XrSpace space = XR_NULL_HANDLE;
+    if (XR_SUCCEEDED(Timed([&] { return xrCreateReferenceSpace(session, &create_info, &space); }))) {
+        Output(MakeHandleGeneric(space));
+    }
+    return true;
+}
+
+bool Replayer::CreateActionSpace(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    XrActionSpaceCreateInfo create_info{XR_TYPE_ACTION_SPACE_CREATE_INFO};
+    if (!Live(call, "XrSession", "session", session) || !Live(call, "XrAction", "createInfo.action", create_info.action) ||
+        !LivePath(call, "createInfo.subactionPath", create_info.subactionPath)) {
+        return false;
+    }
+    create_info.poseInActionSpace = call.Pose("createInfo.poseInActionSpace");
+    XrSpace space = XR_NULL_HANDLE;
+    if (XR_SUCCEEDED(Timed([&] { return xrCreateActionSpace(session, &create_info, &space); }))) {
+        Output(MakeHandleGeneric(space));
+    }
+    return true;
+}
+
+bool Replayer::DestroySpace(const CapturedCall &call) {
+    XrSpace space = XR_NULL_HANDLE;
+    if (!Live(call, "XrSpace", "space", space)) {
+        return false;
+    }
+    Timed([&] { return xrDestroySpace(space); });
+    handles_.Remove("XrSpace", call.Integer("space"));
+    return true;
+}
+
+bool Replayer::LocateSpace(const CapturedCall &call) {
+    XrSpace space = XR_NULL_HANDLE;
+    XrSpace base_space = XR_NULL_HANDLE;
+    if (!Live(call, "XrSpace", "space", space) || !Live(call, "XrSpace", "baseSpace", base_space)) {
+        return false;
+    }
+    const XrTime time = LiveTime(call, "time");
+    XrSpaceLocation location{XR_TYPE_SPACE_LOCATION};
+    Timed([&] { return xrLocateSpace(space, base_space, time, &location); });
+    return true;
+}
+
+bool Replayer::LocateViews(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    XrViewLocateInfo locate_info{XR_TYPE_VIEW_LOCATE_INFO};
+    if (!Live(call, "XrSession", "session", session) || !Live(call, "XrSpace", "viewLocateInfo.space", locate_info.space)) {
+        return false;
+    }
+    locate_info.viewConfigurationType = static_cast<XrViewConfigurationType>(call.Enum("viewLocateInfo.viewConfigurationType"));
+    locate_info.displayTime = LiveTime(call, "viewLocateInfo.displayTime");
+    const uint32_t capacity = static_cast<uint32_t>(call.Integer("viewCapacityInput"));
+    std::vector<XrView> views(capacity, {XR_TYPE_VIEW});
+    XrViewState view_state{XR_TYPE_VIEW_STATE};
+    uint32_t count = 0;
+    Timed([&] { return xrLocateViews(session, &locate_info, &view_state, capacity, &count, capacity ? views.data() : nullptr); });
+    return true;
+}
+
+bool Replayer::WaitFrame(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    if (!Live(call, "XrSession", "session", session)) {
+        return false;
+    }
+    XrFrameWaitInfo wait_info{XR_TYPE_FRAME_WAIT_INFO};
+    XrFrameState frame_state{XR_TYPE_FRAME_STATE};
+    if (XR_SUCCEEDED(Timed([&] { return xrWaitFrame(session, &wait_info, &frame_state); }))) {
+        Output(static_cast<uint64_t>(frame_state.predictedDisplayTime));
+    }
+    return true;
+}
+
+bool Replayer::BeginFrame(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    if (!Live(call, "XrSession", "session", session)) {
+        return false;
+    }
+    XrFrameBeginInfo begin_info{XR_TYPE_FRAME_BEGIN_INFO};
+    Timed([&] { return xrBeginFrame(session, &begin_info); });
+    return true;
+}
+
+bool Replayer::EndFrame(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    if (!Live(call, "XrSession", "session", session)) {
+        return false;
+    }
+    // A headless session has no swapchains for the captured composition layers to show.
+    XrFrameEndInfo end_info{XR_TYPE_FRAME_END_INFO};
+    end_info.displayTime = LiveTime(call, "frameEndInfo.displayTime");
+    end_info.environmentBlendMode = static_cast<XrEnvironmentBlendMode>(call.Enum("frameEndInfo.environmentBlendMode"));
+    Timed([&] { return xrEndFrame(session, &end_info); });
+    return true;
+}
+
+bool Replayer::CreateActionSet(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    if (!Live(call, "XrInstance", "instance", instance)) {
+        return false;
+    }
+    XrActionSetCreateInfo create_info{XR_TYPE_ACTION_SET_CREATE_INFO};
+    call.CopyString("createInfo.actionSetName", create_info.actionSetName);
+    call.CopyString("createInfo.localizedActionSetName", create_info.localizedActionSetName);
+    create_info.priority = static_cast<uint32_t>(call.Integer("createInfo.priority"));
+    XrActionSet action_set = XR_NULL_HANDLE;
+    if (XR_SUCCEEDED(Timed([&] { return xrCreateActionSet(instance, &create_info, &action_set); }))) {
+        Output(MakeHandleGeneric(action_set));
+    }
+    return true;
+}
+
+bool Replayer::DestroyActionSet(const CapturedCall &call) {
+    XrActionSet action_set = XR_NULL_HANDLE;
+    if (!Live(call, "XrActionSet", "actionSet", action_set)) {
+        return false;
+    }
+    Timed([&] { return xrDestroyActionSet(action_set); });
+    handles_.Remove("XrActionSet", call.Integer("actionSet"));
+    return true;
+}
+
+bool Replayer::CreateAction(const CapturedCall &call) {
+    XrActionSet action_set = XR_NULL_HANDLE;
+    if (!Live(call, "XrActionSet", "actionSet", action_set)) {
+        return false;
+    }
+    XrActionCreateInfo create_info{XR_TYPE_ACTION_CREATE_INFO};
+    call.CopyString("createInfo.actionName", create_info.actionName);
+    call.CopyString("createInfo.localizedActionName", create_info.localizedActionName);
+    create_info.actionType = static_cast<XrActionType>(call.Enum("createInfo.actionType"));
+    std::vector<XrPath> subaction_paths(static_cast<size_t>(call.Integer("createInfo.countSubactionPaths")));
+    for (size_t path = 0; path < subaction_paths.size(); ++path) {
+        if (!LivePath(call, "createInfo.subactionPaths[" + std::to_string(path) + "]", subaction_paths[path])) {
+            return false;
+        }
+    }
+    create_info.countSubactionPaths = static_cast<uint32_t>(subaction_paths.size());
+    create_info.subactionPaths = subaction_paths.data();
+    XrAction action = XR_NULL_HANDLE;
+    if (XR_SUCCEEDED(Timed([&] { return xrCreateAction(action_set, &create_info, &action); }))) {
+        Output(MakeHandleGeneric(action));
+    }
+    return true;
+}
+
+bool Replayer::DestroyAction(const CapturedCall &call) {
+    XrAction action = XR_NULL_HANDLE;
+    if (!Live(call, "XrAction", "action", action)) {
+        return false;
+    }
+    Timed([&] { return xrDestroyAction(action); });
+    handles_.Remove("XrAction", call.Integer("action"));
+    return true;
+}
+
+bool Replayer::SuggestInteractionProfileBindings(const CapturedCall &call) {
+    XrInstance instance = XR_NULL_HANDLE;
+    XrInteractionProfileSuggestedBinding suggested{XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING};
+    if (!Live(call, "XrInstance", "instance", instance) ||
+        !LivePath(call, "suggestedBindings.interactionProfile", suggested.interactionProfile)) {
+        return false;
+    }
+    std::vector<XrActionSuggestedBinding> bindings(static_cast<size_t>(call.Integer("suggestedBindings.countSuggestedBindings")));
+    for (size_t binding = 0; binding < bindings.size(); ++binding) {
+        const std::string name = "suggestedBindings.suggestedBindings[" + std::to_string(binding) + "]";
+        if (!Live(call, "XrAction", name + ".action", bindings[binding].action) ||
+            !LivePath(call, name + ".binding", bindings[binding].binding)) {
+            return false;
+        }
+    }
+    suggested.countSuggestedBindings = static_cast<uint32_t>(bindings.size());
+    suggested.suggestedBindings = bindings.data();
+    Timed([&] { return xrSuggestInteractionProfileBindings(instance, &suggested); });
+    return true;
+}
+
+bool Replayer::AttachSessionActionSets(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    if (!Live(call, "XrSession", "session", session)) {
+        return false;
+    }
+    std::vector<XrActionSet> action_sets(static_cast<size_t>(call.Integer("attachInfo.countActionSets")));
+    for (size_t action_set = 0; action_set < action_sets.size(); ++action_set) {
+        if (!Live(call, "XrActionSet", "attachInfo.actionSets[" + std::to_string(action_set) + "]", action_sets[action_set])) {
+            return false;
+        }
+    }
+    XrSessionActionSetsAttachInfo attach_info{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
+    attach_info.countActionSets = static_cast<uint32_t>(action_sets.size());
+    attach_info.actionSets = action_sets.data();
+    Timed([&] { return xrAttachSessionActionSets(session, &attach_info); });
+    return true;
+}
+
+bool Replayer::SyncActions(const CapturedCall &call) {
+    XrSession session = XR_NULL_HANDLE;
+    if (!Live(call, "XrSession", "session", session)) {
+        return false;
+    }
+    std::vector<XrActiveActionSet> active(static_cast<size_t>(call.Integer("syncInfo.countActiveActionSets")));
+    for (size_t action_set = 0; action_set < active.size(); ++action_set) {
+        const std::string name = "syncInfo.activeActionSets[" + std::to_string(action_set) + "]";
+        if (!Live(call, "XrActionSet", name + ".actionSet", active[action_set].actionSet) ||
+            !LivePath(call, name + ".subactionPath", active[action_set].subactionPath)) {
+            return false;
+        }
+    }
+    XrActionsSyncInfo sync_info{XR_TYPE_ACTIONS_SYNC_INFO};
+    sync_info.countActiveActionSets = static_cast<uint32_t>(active.size());
+    sync_info.activeActionSets = active.data();
+    Timed([&] { return xrSyncActions(session, &sync_info); });
+    return true;
+}
+
+// The action state commands take the same parameters.
+#define REPLAY_GET_ACTION_STATE(command, state_type, state_structure_type)                                       \
+    bool Replayer::GetActionState##command(const CapturedCall &call) {                                            \
+        XrSession session = XR_NULL_HANDLE;                                                                       \
+        XrActionStateGetInfo get_info{XR_TYPE_ACTION_STATE_GET_INFO};                                             \
+        if (!Live(call, "XrSession", "session", session) || !Live(call, "XrAction", "getInfo.action", get_info.action) || \
+            !LivePath(call, "getInfo.subactionPath", get_info.subactionPath)) {                                   \
+            return false;                                                                                         \
+        }                                                                                                         \
+        state_type state{state_structure_type};                                                                   \
+        Timed([&] { return xrGetActionState##command(session, &get_info, &state); });                            \
+        return true;                                                                                              \
+    }
+
+REPLAY_GET_ACTION_STATE(Boolean, XrActionStateBoolean, XR_TYPE_ACTION_STATE_BOOLEAN)
+REPLAY_GET_ACTION_STATE(Float, XrActionStateFloat, XR_TYPE_ACTION_STATE_FLOAT)
+REPLAY_GET_ACTION_STATE(Vector2f, XrActionStateVector2f, XR_TYPE_ACTION_STATE_VECTOR2F)
+REPLAY_GET_ACTION_STATE(Pose, XrActionStatePose, XR_TYPE_ACTION_STATE_POSE)
+
+#undef REPLAY_GET_ACTION_STATE
+
+int Usage() {
+    std::cerr << "usage: openxr_replay [--timing fast|original] <capture file>\n";
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    bool original_timing = false;
+    const char *capture_name = nullptr;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (0 == strcmp(argv[arg], "--timing") && arg + 1 < argc) {
+            const char *timing = argv[++arg];
+            if (0 == strcmp(timing, "original")) {
+                original_timing = true;
+            } else if (0 != strcmp(timing, "fast")) {
+                return Usage();
+            }
+        } else if (nullptr == capture_name && argv[arg][0] != '-') {
+            capture_name = argv[arg];
+        } else {
+            return Usage();
+        }
+    }
+    if (nullptr == capture_name) {
+        return Usage();
+    }
+
+#if defined(XR_LAYER_RECORD_GZIP)
+    // Reads captures written to a .gz file name, and ones that are not compressed.
+    LayerGzipReadBuf capture_buf;
+    if (!capture_buf.Open(capture_name)) {
+        std::cerr << "openxr_replay: cannot open " << capture_name << "\n";
+        return 1;
+    }
+    std::istream capture(&capture_buf);
+#else
+    std::ifstream capture(capture_name, std::ios::in | std::ios::binary);
+    if (!capture.is_open()) {
+        std::cerr << "openxr_replay: cannot open " << capture_name << "\n";
+        return 1;
+    }
+#endif
+
+    ApiDumpBinaryReader reader(capture);
+    if (!reader.ReadHeader()) {
+        std::cerr << "openxr_replay: " << capture_name << ": " << reader.Error() << "\n";
+        return 1;
+    }
+    Replayer replayer(original_timing);
+    ApiDumpContents contents;
+    ApiDumpCallStamp stamp;
+    bool stamped = false;
+    bool outputs = false;
+    while (reader.ReadCall(contents, stamp, stamped, &outputs)) {
+        if (outputs) {
+            replayer.Outputs(contents, stamp);
+        } else if (!replayer.Call(contents, stamp, stamped)) {
+            std::cerr << "openxr_replay: " << replayer.Error() << "\n";
+            return 1;
+        }
+    }
+    replayer.Report(std::cout);
+    // A capture cut short, e.g. by a crash, still replays up to the last complete call.
+    if (!reader.Error().empty()) {
+        std::cerr << "openxr_replay: " << capture_name << ": " << reader.Error() << "\n";
+        return 1;
+    }
+    return 0;
+}
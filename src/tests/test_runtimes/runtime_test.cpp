@@ -22,18 +22,24 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cstring>
-#include <deque>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <math.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "xr_dependencies.h"
+#include "platform_utils.hpp"
 #include <openxr/openxr.h>
+#include <openxr/openxr_platform.h>
 #include <openxr/openxr_reflection.h>
 #include <openxr/openxr_loader_negotiation.h>
 
@@ -47,9 +53,309 @@
 #define RUNTIME_EXPORT
 #endif
 
+// For routing platform_utils.hpp messages.
+void LogPlatformUtilsError(const std::string& message) {
+    (void)message;  // maybe unused
+#if !defined(NDEBUG)
+    std::cerr << message << std::endl;
+#endif
+}
+
 namespace {
 
 constexpr XrSystemId VALID_SYSTEM_ID = 1;
+constexpr uint32_t MAX_SWAPCHAIN_IMAGE_SIZE = 4096;
+
+#if XR_PTR_SIZE == 8
+template <typename H, typename T>
+H promoteToHandle(T* p) {
+    return reinterpret_cast<H>(p);
+}
+template <typename H, typename T>
+T* demoteFromHandle(H h) {
+    return reinterpret_cast<T*>(h);
+}
+template <typename H>
+H intToHandle(uint64_t u) {
+    return reinterpret_cast<H>(u);
+}
+template <typename H>
+uint64_t intFromHandle(H h) {
+    return reinterpret_cast<uint64_t>(h);
+}
+#else
+template <typename H, typename T>
+H promoteToHandle(T* p) {
+    return static_cast<H>(reinterpret_cast<uintptr_t>(p));
+}
+template <typename H, typename T>
+T* demoteFromHandle(H h) {
+    return reinterpret_cast<T*>(h);
+}
+template <typename H>
+H intToHandle(uint64_t u) {
+    return u;
+}
+template <typename H>
+uint64_t intFromHandle(H h) {
+    return h;
+}
+#endif
+
+// The interned path strings of an instance.  Path n is the n-th string interned.  A string is found by a hash map under the
+// mutex, and a path without a lock: the strings are kept in fixed-size blocks that never move, and each is published by
+// the release store of the count after it is written, so path to string lookups from any number of threads never wait.
+class PathTable {
+   public:
+    PathTable() = default;
+    ~PathTable() {
+        for (std::atomic<Block*>& block : m_blocks) {
+            delete block.load(std::memory_order_relaxed);
+        }
+    }
+
+    PathTable(const PathTable&) = delete;
+    PathTable& operator=(const PathTable&) = delete;
+
+    // The path of a valid path string, interned if it is new.
+    XrResult Intern(const char* pathString, XrPath* path) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const std::string key(pathString);
+        const auto it = m_ids.find(key);
+        if (it != m_ids.end()) {
+            *path = it->second;
+            return XR_SUCCESS;
+        }
+
+        const uint64_t index = m_count.load(std::memory_order_relaxed);
+        if (index == BlockSize * BlockCount) {
+            return XR_ERROR_PATH_COUNT_EXCEEDED;
+        }
+        std::atomic<Block*>& blockSlot = m_blocks[index / BlockSize];
+        Block* block = blockSlot.load(std::memory_order_relaxed);
+        if (block == nullptr) {
+            block = new Block();
+            blockSlot.store(block, std::memory_order_release);
+        }
+        (*block)[index % BlockSize] = key;
+        m_count.store(index + 1, std::memory_order_release);
+
+        *path = index + 1;
+        m_ids.emplace(key, *path);
+        return XR_SUCCESS;
+    }
+
+    // The string of a path, or null if it was never interned.  Takes no lock.
+    const std::string* Find(XrPath path) const {
+        if (path == XR_NULL_PATH || path > m_count.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        const uint64_t index = path - 1;
+        const Block* block = m_blocks[index / BlockSize].load(std::memory_order_acquire);
+        return &(*block)[index % BlockSize];
+    }
+
+   private:
+    static constexpr uint64_t BlockSize = 1024;
+    static constexpr uint64_t BlockCount = 1024;
+    using Block = std::array<std::string, BlockSize>;
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, XrPath> m_ids;
+    std::array<std::atomic<Block*>, BlockCount> m_blocks{};
+    std::atomic<uint64_t> m_count{0};
+};
+
+// The objects of a handle type for every instance, in slots that never move.  A handle holds its slot and the slot's
+// generation, which is advanced when the object is destroyed, so a handle resolves without a lock, and a handle to a
+// destroyed object is told apart from one to the object that reuses its slot.  T has the slot and handle members.
+template <typename H, typename T>
+class HandleTable {
+   public:
+    HandleTable() = default;
+    ~HandleTable() {
+        for (std::atomic<Block*>& blockSlot : m_blocks) {
+            Block* block = blockSlot.load(std::memory_order_relaxed);
+            if (block != nullptr) {
+                for (Slot& slot : *block) {
+                    delete slot.object.load(std::memory_order_relaxed);
+                }
+                delete block;
+            }
+        }
+    }
+
+    HandleTable(const HandleTable&) = delete;
+    HandleTable& operator=(const HandleTable&) = delete;
+
+    // Take ownership of the object, in a free slot.
+    XrResult Add(std::unique_ptr<T> object, H* handle) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        uint32_t index;
+        if (!m_freeSlots.empty()) {
+            index = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        } else {
+            index = m_count.load(std::memory_order_relaxed);
+            if (index == BlockSize * BlockCount) {
+                return XR_ERROR_LIMIT_REACHED;
+            }
+            std::atomic<Block*>& blockSlot = m_blocks[index / BlockSize];
+            if (blockSlot.load(std::memory_order_relaxed) == nullptr) {
+                blockSlot.store(new Block(), std::memory_order_release);
+            }
+            m_count.store(index + 1, std::memory_order_release);
+        }
+
+        Slot& slot = GetSlot(index);
+        object->slot = index;
+        object->handle = intToHandle<H>(((uint64_t)slot.generation.load(std::memory_order_relaxed) << 32) | (index + 1));
+        *handle = object->handle;
+        slot.object.store(object.release(), std::memory_order_release);
+        return XR_SUCCESS;
+    }
+
+    // Destroy the object and free its slot.
+    void Remove(const T* object) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const uint32_t index = object->slot;  // object is deleted below
+        Slot& slot = GetSlot(index);
+        delete slot.object.exchange(nullptr, std::memory_order_acq_rel);
+        slot.generation.fetch_add(1, std::memory_order_release);
+        m_freeSlots.push_back(index);
+    }
+
+    // The object of a handle, or null if it was destroyed or never created.  Takes no lock.
+    T* Find(H handle) const {
+        const uint64_t value = intFromHandle(handle);
+        const uint32_t index = (uint32_t)value - 1;
+        if ((uint32_t)value == 0 || index >= m_count.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        Slot& slot = GetSlot(index);
+        T* object = slot.object.load(std::memory_order_acquire);
+        if (object == nullptr || slot.generation.load(std::memory_order_acquire) != (uint32_t)(value >> 32)) {
+            return nullptr;
+        }
+        return object;
+    }
+
+   private:
+    static constexpr uint32_t BlockSize = 1024;
+    static constexpr uint32_t BlockCount = 1024;
+
+    struct Slot {
+        std::atomic<uint32_t> generation{0};
+        std::atomic<T*> object{nullptr};
+    };
+    using Block = std::array<Slot, BlockSize>;
+
+    Slot& GetSlot(uint32_t index) const {
+        return (*m_blocks[index / BlockSize].load(std::memory_order_acquire))[index % BlockSize];
+    }
+
+    std::mutex m_mutex;
+    std::vector<uint32_t> m_freeSlots;
+    std::array<std::atomic<Block*>, BlockCount> m_blocks{};
+    std::atomic<uint32_t> m_count{0};
+};
+
+// Whether the handle an event is about has been destroyed.  Each queued event shares the flag of its handle, which the
+// handle sets when it is destroyed, so its events are skipped when they are polled rather than searched for and erased.
+using EventTombstone = std::shared_ptr<std::atomic<bool>>;
+
+inline EventTombstone MakeEventTombstone() { return std::make_shared<std::atomic<bool>>(false); }
+
+// The event queue of an instance: a bounded ring, which threads push to and poll from without a lock.  Each claims a
+// slot with a compare-and-swap on its position, and publishes it through the slot's sequence number.  An event pushed to
+// a full queue is dropped, and reported as lost by XrEventDataEventsLost once the queue is drained.
+class EventQueue {
+   public:
+    static constexpr uint64_t SlotCount = 256;
+
+    EventQueue() {
+        for (uint64_t i = 0; i < SlotCount; i++) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    template <typename T>
+    void Push(const EventTombstone& tombstone, const T* event) {
+        static_assert(sizeof(T) <= sizeof(XrEventDataBuffer), "event bigger than buffer");
+        uint64_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &m_slots[position % SlotCount];
+            const int64_t lag = (int64_t)(slot->sequence.load(std::memory_order_acquire) - position);
+            if (lag == 0) {
+                if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                // The slot still holds the event from SlotCount positions back.
+                m_lostCount.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                position = m_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->tombstone = tombstone;
+        memcpy(&slot->buffer, event, sizeof(T));
+        slot->sequence.store(position + 1, std::memory_order_release);
+    }
+
+    // Take the oldest event whose handle is not destroyed.  False if there is none.
+    bool Pop(XrEventDataBuffer* eventData) {
+        uint64_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_slots[position % SlotCount];
+            const int64_t lag = (int64_t)(slot.sequence.load(std::memory_order_acquire) - (position + 1));
+            if (lag == 0) {
+                if (m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    const EventTombstone tombstone = std::move(slot.tombstone);
+                    const bool discarded = tombstone->load(std::memory_order_acquire);
+                    if (!discarded) {
+                        *eventData = slot.buffer;
+                    }
+                    slot.sequence.store(position + SlotCount, std::memory_order_release);
+                    if (!discarded) {
+                        return true;
+                    }
+                    position = m_dequeuePosition.load(std::memory_order_relaxed);
+                }
+            } else if (lag < 0) {
+                break;
+            } else {
+                position = m_dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        const uint64_t lostCount = m_lostCount.exchange(0, std::memory_order_relaxed);
+        if (lostCount == 0) {
+            return false;
+        }
+        XrEventDataEventsLost eventsLost{XR_TYPE_EVENT_DATA_EVENTS_LOST};
+        eventsLost.lostEventCount = (uint32_t)lostCount;
+        memcpy(eventData, &eventsLost, sizeof(eventsLost));
+        return true;
+    }
+
+   private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        EventTombstone tombstone;
+        XrEventDataBuffer buffer;
+    };
+
+    std::array<Slot, SlotCount> m_slots;
+    std::atomic<uint64_t> m_enqueuePosition{0};
+    std::atomic<uint64_t> m_dequeuePosition{0};
+    std::atomic<uint64_t> m_lostCount{0};
+};
 
 struct XrSpace_T {
     enum class SpaceType {
@@ -67,26 +373,117 @@ struct XrSpace_T {
     XrReferenceSpaceType referenceSpaceType{XR_REFERENCE_SPACE_TYPE_MAX_ENUM};
     XrPosef poseInReferenceSpace{};
 
-    ~XrSpace_T();
+    // events about the space
+    EventTombstone eventTombstone{MakeEventTombstone()};
+
+    XrSpace handle{XR_NULL_HANDLE};
+    uint32_t slot{0};            // in g.spaces
+    uint32_t indexInSession{0};  // in the session's spaces
+
+    ~XrSpace_T() { eventTombstone->store(true, std::memory_order_release); }
+};
+
+// The state of an action in a session, as a whole or for one of its subaction paths.
+struct ActionState {
+    XrPath subactionPath{XR_NULL_PATH};  // XR_NULL_PATH for the action as a whole
+    XrBool32 isActive{XR_FALSE};
+    XrBool32 changedSinceLastSync{XR_FALSE};
+    XrTime lastChangeTime{0};
+    XrVector2f value{};  // x is the state of a boolean or float action
+};
+
+// Where the states of an attached action start in the session's action states: the state of the action as a whole, then
+// one for each of its subaction paths.
+struct ActionStateRange {
+    XrAction action{XR_NULL_HANDLE};  // the action the range is for, or XR_NULL_HANDLE
+    uint32_t offset{0};
+};
+
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+// The Vulkan device of a session created with an XR_KHR_vulkan_enable2 graphics binding, and the commands its swapchains
+// use.  They are loaded through the vkGetInstanceProcAddr the application gave xrCreateVulkanInstanceKHR, so the runtime
+// does not link Vulkan itself.
+struct VulkanBinding {
+    VkInstance instance{VK_NULL_HANDLE};
+    VkPhysicalDevice physicalDevice{VK_NULL_HANDLE};
+    VkDevice device{VK_NULL_HANDLE};
+
+    PFN_vkGetPhysicalDeviceMemoryProperties vkGetPhysicalDeviceMemoryProperties{nullptr};
+    PFN_vkCreateImage vkCreateImage{nullptr};
+    PFN_vkDestroyImage vkDestroyImage{nullptr};
+    PFN_vkGetImageMemoryRequirements vkGetImageMemoryRequirements{nullptr};
+    PFN_vkAllocateMemory vkAllocateMemory{nullptr};
+    PFN_vkFreeMemory vkFreeMemory{nullptr};
+    PFN_vkBindImageMemory vkBindImageMemory{nullptr};
+};
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+
+// A swapchain of images on the graphics device of its session, which nothing composites: a released image is never read,
+// so an acquired one is ready as soon as it is waited for.  The images are acquired in turn, and waited for and released
+// oldest first.
+struct XrSwapchain_T {
+    // parent
+    XrSession session{XR_NULL_HANDLE};
+
+    uint32_t imageCount{0};
+    bool staticImage{false};    // XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT: one image, acquired once
+    uint32_t acquireCount{0};   // images acquired over the life of the swapchain
+    uint32_t acquiredCount{0};  // images acquired and not yet released
+    bool oldestWaited{false};   // the oldest acquired image was waited for
+
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+    const VulkanBinding* vulkan{nullptr};
+    std::vector<VkImage> vulkanImages;
+    std::vector<VkDeviceMemory> vulkanMemory;
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+
+    ~XrSwapchain_T();
 };
 
 struct XrSession_T {
     // parent
     XrInstance instance{XR_NULL_HANDLE};
 
-    // session state
+    // session state, changed and queued as an event together under the mutex, so the events are in order
+    std::mutex sessionStateMutex;
     XrSessionState sessionState{XR_SESSION_STATE_UNKNOWN};
     XrTime beginTime = 0;
     XrTime endTime = 0;
+    XrTime lastFrameTime = 0;  // the frame boundary the last paced xrWaitFrame returned at
 
-    // spaces
+    // spaces, owned by g.spaces
     std::mutex spacesMutex;
-    std::vector<std::unique_ptr<XrSpace_T>> spaces;
+    std::vector<XrSpace_T*> spaces;
 
     // attached action sets
     bool actionsetsAttached = false;
     std::vector<XrActionSet> attachedActionSets;
 
+    // the state of the actions of the attached action sets, by the slot of the action
+    std::vector<ActionStateRange> actionStateRanges;
+    std::vector<ActionState> actionStates;
+
+    // events about the session
+    EventTombstone eventTombstone{MakeEventTombstone()};
+
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+    // the graphics binding, whose device is VK_NULL_HANDLE for a headless session
+    VulkanBinding vulkan;
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+
+    // swapchains, destroyed before the graphics binding they were created on
+    std::mutex swapchainsMutex;
+    std::vector<std::unique_ptr<XrSwapchain_T>> swapchains;
+
+    // whether the session renders to swapchains, so its frames should be rendered once it is visible
+    bool HasGraphicsBinding() const {
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+        return vulkan.device != VK_NULL_HANDLE;
+#else
+        return false;
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+    }
+
     ~XrSession_T();
 };
 
@@ -98,6 +495,10 @@ struct XrAction_T {
     std::string localizedActionName;
     XrActionType actionType{XR_ACTION_TYPE_MAX_ENUM};
     std::vector<XrPath> subactionPaths;
+
+    XrAction handle{XR_NULL_HANDLE};
+    uint32_t slot{0};        // in g.actions
+    uint32_t indexInSet{0};  // in the action set's actions
 };
 
 struct XrActionSet_T {
@@ -110,9 +511,55 @@ struct XrActionSet_T {
     // attached
     bool hasBeenAttached = false;
 
-    // actions
+    // actions, owned by g.actions
     std::mutex actionsMutex;
-    std::vector<std::unique_ptr<XrAction_T>> actions;
+    std::vector<XrAction_T*> actions;
+
+    ~XrActionSet_T();
+};
+
+// Synthetic load, so the runtime can stand in for a real one when benchmarking the loader and layers end to end.  Each
+// part is off unless its environment variable is set when the instance is created:
+//   XR_TEST_RUNTIME_FRAME_PERIOD_US - xrWaitFrame blocks until the next frame boundary of this period, counted from
+//                                     xrBeginSession, and predicts display at the boundary after it.
+//   XR_TEST_RUNTIME_LOCATE_SPACE_US - xrLocateSpace, and each space of xrLocateSpaces, spins for this long.
+//   XR_TEST_RUNTIME_EVENT_RATE_HZ   - xrPollEvent returns this many XrEventDataEventsLost a second, counted from instance
+//                                     creation, once the events the runtime queued are drained.
+struct SyntheticLoad {
+    XrDuration framePeriod{0};
+    XrDuration locateSpaceCost{0};
+    uint64_t eventRate{0};
+
+    static SyntheticLoad FromEnvironment() {
+        SyntheticLoad load;
+        load.framePeriod = (XrDuration)ReadUnsigned("XR_TEST_RUNTIME_FRAME_PERIOD_US") * 1000;
+        load.locateSpaceCost = (XrDuration)ReadUnsigned("XR_TEST_RUNTIME_LOCATE_SPACE_US") * 1000;
+        load.eventRate = ReadUnsigned("XR_TEST_RUNTIME_EVENT_RATE_HZ");
+        return load;
+    }
+
+   private:
+    // The value of the variable, or 0 if it is unset or not a number.
+    static uint64_t ReadUnsigned(const char* name) {
+        const std::string value = PlatformUtilsGetEnv(name);
+        char* end = nullptr;
+        const unsigned long long result = strtoull(value.c_str(), &end, 10);
+        return value.empty() || *end != '\0' ? 0 : result;
+    }
+};
+
+// Spin for the duration, so the cost is spent on the calling thread like real work, rather than given up to the scheduler.
+void SpinFor(XrDuration duration) {
+    const auto end = std::chrono::steady_clock::now() + std::chrono::nanoseconds(duration);
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+// The interaction profiles of an instance's API version and extensions, indexed by path: the binding paths each profile
+// supports, and the top level paths of every profile.
+struct InteractionProfileIndex {
+    std::unordered_map<XrPath, std::unordered_set<XrPath>> bindingPaths;
+    std::unordered_set<XrPath> topLevelPaths;
 };
 
 struct XrInstance_T {
@@ -122,9 +569,7 @@ struct XrInstance_T {
     std::vector<std::string> enabledExtensions;
 
     // events
-    // (note: order in class: events needs to be destructed after all other types)
-    std::mutex instanceEventsMutex;
-    std::deque<std::pair<uint64_t, XrEventDataBuffer>> instanceEvents;
+    EventQueue events;
 
     // sessions
     std::mutex sessionsMutex;
@@ -134,15 +579,34 @@ struct XrInstance_T {
     std::mutex actionSetsMutex;
     std::vector<std::unique_ptr<XrActionSet_T>> actionSets;
 
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+    // the Vulkan instance created by xrCreateVulkanInstanceKHR, and the loader entry point it was created with
+    VkInstance vulkanInstance{VK_NULL_HANDLE};
+    PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr{nullptr};
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+
+    // synthetic load, read from the environment when the instance is created
+    SyntheticLoad syntheticLoad;
+    XrTime createTime = 0;
+    std::atomic<uint64_t> syntheticEventCount{0};
+
     // paths
-    std::mutex pathsMutex;
-    std::map<XrPath, std::string> paths;
-    XrPath lastPath = 1;
+    PathTable paths;
+
+    // interaction profiles, indexed the first time an action or suggested binding is validated
+    std::once_flag interactionProfileIndexOnce;
+    XrResult interactionProfileIndexResult{XR_SUCCESS};
+    InteractionProfileIndex interactionProfileIndex;
 };
 
 struct GlobalImpl {
     // no parent
 
+    // (note: order in class: these need to be destructed after the instances, whose action sets and sessions destroy
+    // their actions and spaces)
+    HandleTable<XrAction, XrAction_T> actions;
+    HandleTable<XrSpace, XrSpace_T> spaces;
+
     std::mutex instancesMutex;
     std::vector<std::unique_ptr<XrInstance_T>> instances;
 
@@ -800,42 +1264,6 @@ const std::vector<InteractionProfileMetadata> cInteractionProfileDefinitions_1_1
     {"/interaction_profiles/samsung/odyssey_controller", {"/user/hand/left", "/user/hand/right"}, cSamsungOdysseyIPData_1_1},
 };
 
-#if XR_PTR_SIZE == 8
-template <typename H, typename T>
-H promoteToHandle(T* p) {
-    return reinterpret_cast<H>(p);
-}
-template <typename H, typename T>
-T* demoteFromHandle(H h) {
-    return reinterpret_cast<T*>(h);
-}
-template <typename H>
-H intToHandle(uint64_t u) {
-    return reinterpret_cast<H>(u);
-}
-template <typename H>
-uint64_t intFromHandle(H h) {
-    return reinterpret_cast<uint64_t>(h);
-}
-#else
-template <typename H, typename T>
-H promoteToHandle(T* p) {
-    return static_cast<H>(reinterpret_cast<uintptr_t>(p));
-}
-template <typename H, typename T>
-T* demoteFromHandle(H h) {
-    return reinterpret_cast<T*>(h);
-}
-template <typename H>
-H intToHandle(uint64_t u) {
-    return u;
-}
-template <typename H>
-uint64_t intFromHandle(H h) {
-    return h;
-}
-#endif
-
 template <typename T, typename U>
 XrResult ElementCapacityWrite(uint32_t elementCapacityInput, uint32_t* elementCountOutput, T* elementsOutput,
                               const U* elementsSource, size_t elementsSize) {
@@ -922,36 +1350,28 @@ bool validateQuat(const XrQuaternionf& quat) {
     return fabsf(norm - 1.f) <= 0.1f;
 }
 
-template <typename T>
-void addSessionEventToQueueLocked(std::deque<std::pair<uint64_t, XrEventDataBuffer>>& instanceQueue, XrSession session,
-                                  T* eventToAdd) {
-    static_assert(sizeof(T) <= sizeof(XrEventDataBuffer), "event bigger than buffer");
-    XrEventDataBuffer buffer;
-    memcpy(&buffer, eventToAdd, sizeof(T));
-    instanceQueue.emplace_back(intFromHandle(session), buffer);
+XrSession_T::~XrSession_T() {
+    for (const XrSpace_T* spacePtr : spaces) {
+        g.spaces.Remove(spacePtr);
+    }
+    eventTombstone->store(true, std::memory_order_release);
 }
 
-// https://registry.khronos.org/OpenXR/specs/1.1/html/xrspec.html#_xrpollevent
-// The runtime must discard queued events which contain destroyed or otherwise invalid handles.
-template <typename T>
-void purgeEvents(XrInstance instance, T eventParent) {
-    XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(instance);
-    std::unique_lock<std::mutex> lock(instancePtr->instanceEventsMutex);
-
-    for (auto it = instancePtr->instanceEvents.begin(); it != instancePtr->instanceEvents.end();) {
-        if (intToHandle<T>(it->first) == eventParent) {
-            it = instancePtr->instanceEvents.erase(it);
-        } else {
-            ++it;
-        }
+XrSwapchain_T::~XrSwapchain_T() {
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+    for (VkImage image : vulkanImages) {
+        vulkan->vkDestroyImage(vulkan->device, image, nullptr);
     }
+    for (VkDeviceMemory memory : vulkanMemory) {
+        vulkan->vkFreeMemory(vulkan->device, memory, nullptr);
+    }
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
 }
 
-XrSession_T::~XrSession_T() { purgeEvents<XrSession>(instance, promoteToHandle<XrSession, XrSession_T>(this)); }
-
-XrSpace_T::~XrSpace_T() {
-    XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
-    purgeEvents<XrSpace>(sessionPtr->instance, promoteToHandle<XrSpace, XrSpace_T>(this));
+XrActionSet_T::~XrActionSet_T() {
+    for (const XrAction_T* actionPtr : actions) {
+        g.actions.Remove(actionPtr);
+    }
 }
 
 void switchSessionState(XrSession session, XrSessionState newSessionState) {
@@ -960,7 +1380,7 @@ void switchSessionState(XrSession session, XrSessionState newSessionState) {
     {
         XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(sessionPtr->instance);
 
-        std::unique_lock<std::mutex> lock(instancePtr->instanceEventsMutex);
+        std::unique_lock<std::mutex> lock(sessionPtr->sessionStateMutex);
 
         sessionPtr->sessionState = newSessionState;
 
@@ -969,7 +1389,7 @@ void switchSessionState(XrSession session, XrSessionState newSessionState) {
         sessionState.state = newSessionState;
         sessionState.time = currentXrTime();
 
-        addSessionEventToQueueLocked(instancePtr->instanceEvents, session, &sessionState);
+        instancePtr->events.Push(sessionPtr->eventTombstone, &sessionState);
     }
 }
 
@@ -993,6 +1413,8 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateInstance(const XrInstanceCreat
     auto instancePtr = std::make_unique<XrInstance_T>();
     instancePtr->apiVersion = createInfo->applicationInfo.apiVersion;
     instancePtr->enabledExtensions = enabledExtensions;
+    instancePtr->syntheticLoad = SyntheticLoad::FromEnvironment();
+    instancePtr->createTime = currentXrTime();
 
     *instance = promoteToHandle<XrInstance, XrInstance_T>(instancePtr.get());
 
@@ -1036,7 +1458,7 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrEnumerateInstanceExtensionProperties
         return XR_ERROR_API_LAYER_NOT_PRESENT;
     }
 
-    static constexpr std::array<XrExtensionProperties, 3> runtimeExtensions = {{
+    static const std::vector<XrExtensionProperties> runtimeExtensions = {
         XrExtensionProperties{
             /*.type =*/XR_TYPE_EXTENSION_PROPERTIES,
             /*.next =*/nullptr,
@@ -1055,7 +1477,15 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrEnumerateInstanceExtensionProperties
             /*.extensionName =*/"XR_KHR_fake_ext2",
             /*.extensionVersion =*/3,
         },
-    }};
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+        XrExtensionProperties{
+            /*.type =*/XR_TYPE_EXTENSION_PROPERTIES,
+            /*.next =*/nullptr,
+            /*.extensionName =*/XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME,
+            /*.extensionVersion =*/XR_KHR_vulkan_enable2_SPEC_VERSION,
+        },
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+    };
 
     return XrElementCapacityWrite(propertyCapacityInput, propertyCountOutput, properties, runtimeExtensions.data(),
                                   runtimeExtensions.size());
@@ -1080,8 +1510,8 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetSystemProperties(XrInstance insta
     }
 
     properties->graphicsProperties.maxLayerCount = 16;
-    properties->graphicsProperties.maxSwapchainImageHeight = 1;
-    properties->graphicsProperties.maxSwapchainImageWidth = 1;
+    properties->graphicsProperties.maxSwapchainImageHeight = MAX_SWAPCHAIN_IMAGE_SIZE;
+    properties->graphicsProperties.maxSwapchainImageWidth = MAX_SWAPCHAIN_IMAGE_SIZE;
     properties->systemId = systemId;
     strcpy(properties->systemName, "Test system");
     properties->vendorId = 0x0;
@@ -1118,15 +1548,25 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetInstanceProperties(XrInstance /*i
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrPollEvent(XrInstance instance, XrEventDataBuffer* eventData) {
     XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(instance);
 
-    std::unique_lock<std::mutex> lock(instancePtr->instanceEventsMutex);
-    if (instancePtr->instanceEvents.empty()) {
-        return XR_EVENT_UNAVAILABLE;
+    if (instancePtr->events.Pop(eventData)) {
+        return XR_SUCCESS;
     }
 
-    auto eventDataPair = instancePtr->instanceEvents.front();
-    *eventData = eventDataPair.second;
-    instancePtr->instanceEvents.pop_front();
-    return XR_SUCCESS;
+    const uint64_t eventRate = instancePtr->syntheticLoad.eventRate;
+    if (eventRate != 0) {
+        const uint64_t elapsed = (uint64_t)(currentXrTime() - instancePtr->createTime);
+        const uint64_t eventsDue = elapsed / 1000000000 * eventRate + elapsed % 1000000000 * eventRate / 1000000000;
+        uint64_t eventCount = instancePtr->syntheticEventCount.load(std::memory_order_relaxed);
+        while (eventCount < eventsDue) {
+            if (instancePtr->syntheticEventCount.compare_exchange_weak(eventCount, eventCount + 1, std::memory_order_relaxed)) {
+                XrEventDataEventsLost eventsLost{XR_TYPE_EVENT_DATA_EVENTS_LOST};
+                eventsLost.lostEventCount = 0;
+                memcpy(eventData, &eventsLost, sizeof(eventsLost));
+                return XR_SUCCESS;
+            }
+        }
+    }
+    return XR_EVENT_UNAVAILABLE;
 }
 
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrEnumerateEnvironmentBlendModes(XrInstance instance, XrSystemId systemId,
@@ -1210,55 +1650,200 @@ RuntimeTestXrStructureTypeToString(XrInstance /*instance*/, XrStructureType valu
     return XR_SUCCESS;
 }
 
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
 //
-// Session
+// XR_KHR_vulkan_enable2
 //
 
-XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateSession(XrInstance instance, const XrSessionCreateInfo* createInfo,
-                                                          XrSession* session) {
-    if (createInfo->systemId != VALID_SYSTEM_ID) {
-        return XR_ERROR_SYSTEM_INVALID;
-    }
-
-    auto sessionPtr = std::make_unique<XrSession_T>();
-    sessionPtr->instance = instance;
-
-    *session = promoteToHandle<XrSession, XrSession_T>(sessionPtr.get());
+// A Vulkan command of an instance, or a global command for VK_NULL_HANDLE, through the loader entry point the application
+// gave the runtime.
+template <typename PFN>
+PFN GetVulkanInstanceProc(PFN_vkGetInstanceProcAddr getInstanceProcAddr, VkInstance vulkanInstance, const char* name) {
+    return reinterpret_cast<PFN>(getInstanceProcAddr(vulkanInstance, name));
+}
 
-    {
-        XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(instance);
-        std::unique_lock<std::mutex> lock(instancePtr->sessionsMutex);
-        instancePtr->sessions.push_back(std::move(sessionPtr));
+XrResult LoadVulkanBinding(const XrInstance_T* instancePtr, const XrGraphicsBindingVulkanKHR& binding, VulkanBinding* vulkan) {
+    if (binding.instance == VK_NULL_HANDLE || binding.physicalDevice == VK_NULL_HANDLE || binding.device == VK_NULL_HANDLE) {
+        return XR_ERROR_VALIDATION_FAILURE;
     }
-
-    switchSessionState(*session, XR_SESSION_STATE_IDLE);
-    switchSessionState(*session, XR_SESSION_STATE_READY);
-
+    // The runtime can only call into a Vulkan instance it created with xrCreateVulkanInstanceKHR.
+    if (instancePtr->vkGetInstanceProcAddr == nullptr || binding.instance != instancePtr->vulkanInstance) {
+        return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+    }
+
+    const PFN_vkGetInstanceProcAddr getInstanceProcAddr = instancePtr->vkGetInstanceProcAddr;
+    const auto getDeviceProcAddr =
+        GetVulkanInstanceProc<PFN_vkGetDeviceProcAddr>(getInstanceProcAddr, binding.instance, "vkGetDeviceProcAddr");
+    vulkan->vkGetPhysicalDeviceMemoryProperties = GetVulkanInstanceProc<PFN_vkGetPhysicalDeviceMemoryProperties>(
+        getInstanceProcAddr, binding.instance, "vkGetPhysicalDeviceMemoryProperties");
+    if (getDeviceProcAddr == nullptr || vulkan->vkGetPhysicalDeviceMemoryProperties == nullptr) {
+        return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+    }
+#define LOAD_DEVICE_PROC(name)                                                             \
+    vulkan->name = reinterpret_cast<PFN_##name>(getDeviceProcAddr(binding.device, #name)); \
+    if (vulkan->name == nullptr) {                                                         \
+        return XR_ERROR_GRAPHICS_DEVICE_INVALID;                                           \
+    }
+    LOAD_DEVICE_PROC(vkCreateImage)
+    LOAD_DEVICE_PROC(vkDestroyImage)
+    LOAD_DEVICE_PROC(vkGetImageMemoryRequirements)
+    LOAD_DEVICE_PROC(vkAllocateMemory)
+    LOAD_DEVICE_PROC(vkFreeMemory)
+    LOAD_DEVICE_PROC(vkBindImageMemory)
+#undef LOAD_DEVICE_PROC
+
+    vulkan->instance = binding.instance;
+    vulkan->physicalDevice = binding.physicalDevice;
+    vulkan->device = binding.device;
     return XR_SUCCESS;
 }
 
-XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrDestroySession(XrSession session) {
-    {
-        XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
-        XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(sessionPtr->instance);
-        std::unique_lock<std::mutex> lock(instancePtr->sessionsMutex);
-        const auto& it = std::find_if(instancePtr->sessions.begin(), instancePtr->sessions.end(),
-                                      [sessionPtr](const auto& i) { return sessionPtr == i.get(); });
-        instancePtr->sessions.erase(it);
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetVulkanGraphicsRequirements2KHR(XrInstance /*instance*/, XrSystemId systemId,
+                                                                             XrGraphicsRequirementsVulkanKHR* graphicsRequirements) {
+    if (systemId != VALID_SYSTEM_ID) {
+        return XR_ERROR_SYSTEM_INVALID;
     }
-
+    graphicsRequirements->minApiVersionSupported = XR_MAKE_VERSION(1, 0, 0);
+    graphicsRequirements->maxApiVersionSupported = XR_MAKE_VERSION(1, 4, 0);
     return XR_SUCCESS;
 }
 
-XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo) {
-    XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateVulkanInstanceKHR(XrInstance instance,
+                                                                   const XrVulkanInstanceCreateInfoKHR* createInfo,
+                                                                   VkInstance* vulkanInstance, VkResult* vulkanResult) {
+    if (createInfo->systemId != VALID_SYSTEM_ID) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    if (createInfo->pfnGetInstanceProcAddr == nullptr || createInfo->vulkanCreateInfo == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
 
-    if (beginInfo->primaryViewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
-        return viewConfigurationError(sessionPtr->instance, beginInfo->primaryViewConfigurationType);
+    // The runtime needs no instance extensions of its own.
+    const auto createVulkanInstance =
+        GetVulkanInstanceProc<PFN_vkCreateInstance>(createInfo->pfnGetInstanceProcAddr, VK_NULL_HANDLE, "vkCreateInstance");
+    if (createVulkanInstance == nullptr) {
+        return XR_ERROR_RUNTIME_FAILURE;
     }
+    *vulkanResult = createVulkanInstance(createInfo->vulkanCreateInfo, createInfo->vulkanAllocator, vulkanInstance);
+    if (*vulkanResult == VK_SUCCESS) {
+        XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(instance);
+        instancePtr->vulkanInstance = *vulkanInstance;
+        instancePtr->vkGetInstanceProcAddr = createInfo->pfnGetInstanceProcAddr;
+    }
+    return XR_SUCCESS;
+}
 
-    if (sessionPtr->beginTime != 0) {
-        return XR_ERROR_SESSION_RUNNING;
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetVulkanGraphicsDevice2KHR(XrInstance instance,
+                                                                       const XrVulkanGraphicsDeviceGetInfoKHR* getInfo,
+                                                                       VkPhysicalDevice* vulkanPhysicalDevice) {
+    if (getInfo->systemId != VALID_SYSTEM_ID) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    const XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(instance);
+    if (instancePtr->vkGetInstanceProcAddr == nullptr || getInfo->vulkanInstance != instancePtr->vulkanInstance) {
+        return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+    }
+
+    // There is no display to drive, so any device will do: the first one the Vulkan loader enumerates.
+    const auto enumeratePhysicalDevices = GetVulkanInstanceProc<PFN_vkEnumeratePhysicalDevices>(
+        instancePtr->vkGetInstanceProcAddr, getInfo->vulkanInstance, "vkEnumeratePhysicalDevices");
+    if (enumeratePhysicalDevices == nullptr) {
+        return XR_ERROR_RUNTIME_FAILURE;
+    }
+    uint32_t deviceCount = 1;
+    const VkResult result = enumeratePhysicalDevices(getInfo->vulkanInstance, &deviceCount, vulkanPhysicalDevice);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || deviceCount == 0) {
+        return XR_ERROR_RUNTIME_FAILURE;
+    }
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateVulkanDeviceKHR(XrInstance instance, const XrVulkanDeviceCreateInfoKHR* createInfo,
+                                                                 VkDevice* vulkanDevice, VkResult* vulkanResult) {
+    if (createInfo->systemId != VALID_SYSTEM_ID) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    if (createInfo->pfnGetInstanceProcAddr == nullptr || createInfo->vulkanCreateInfo == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(instance);
+    if (instancePtr->vulkanInstance == VK_NULL_HANDLE) {
+        return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+    }
+
+    // The runtime needs no device extensions or features of its own.
+    const auto createDevice =
+        GetVulkanInstanceProc<PFN_vkCreateDevice>(createInfo->pfnGetInstanceProcAddr, instancePtr->vulkanInstance, "vkCreateDevice");
+    if (createDevice == nullptr) {
+        return XR_ERROR_RUNTIME_FAILURE;
+    }
+    *vulkanResult = createDevice(createInfo->vulkanPhysicalDevice, createInfo->vulkanCreateInfo, createInfo->vulkanAllocator,
+                                 vulkanDevice);
+    return XR_SUCCESS;
+}
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+
+//
+// Session
+//
+
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateSession(XrInstance instance, const XrSessionCreateInfo* createInfo,
+                                                          XrSession* session) {
+    if (createInfo->systemId != VALID_SYSTEM_ID) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+
+    auto sessionPtr = std::make_unique<XrSession_T>();
+    sessionPtr->instance = instance;
+
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+    const auto* vulkanBinding =
+        findInNextChain<XrGraphicsBindingVulkanKHR, XR_TYPE_GRAPHICS_BINDING_VULKAN_KHR>(createInfo->next);
+    if (vulkanBinding != nullptr) {
+        const XrResult result =
+            LoadVulkanBinding(demoteFromHandle<XrInstance, XrInstance_T>(instance), *vulkanBinding, &sessionPtr->vulkan);
+        if (XR_FAILED(result)) {
+            return result;
+        }
+    }
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+
+    *session = promoteToHandle<XrSession, XrSession_T>(sessionPtr.get());
+
+    {
+        XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(instance);
+        std::unique_lock<std::mutex> lock(instancePtr->sessionsMutex);
+        instancePtr->sessions.push_back(std::move(sessionPtr));
+    }
+
+    switchSessionState(*session, XR_SESSION_STATE_IDLE);
+    switchSessionState(*session, XR_SESSION_STATE_READY);
+
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrDestroySession(XrSession session) {
+    {
+        XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
+        XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(sessionPtr->instance);
+        std::unique_lock<std::mutex> lock(instancePtr->sessionsMutex);
+        const auto& it = std::find_if(instancePtr->sessions.begin(), instancePtr->sessions.end(),
+                                      [sessionPtr](const auto& i) { return sessionPtr == i.get(); });
+        instancePtr->sessions.erase(it);
+    }
+
+    return XR_SUCCESS;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo) {
+    XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
+
+    if (beginInfo->primaryViewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return viewConfigurationError(sessionPtr->instance, beginInfo->primaryViewConfigurationType);
+    }
+
+    if (sessionPtr->beginTime != 0) {
+        return XR_ERROR_SESSION_RUNNING;
     }
 
     sessionPtr->beginTime = currentXrTime();
@@ -1333,6 +1918,44 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrEnumerateReferenceSpaces(XrSession s
     }
 }
 
+// Give a space a handle, and add it to the spaces of its session.
+XrResult AddSpace(XrSession_T* sessionPtr, std::unique_ptr<XrSpace_T> spacePtr, XrSpace* space) {
+    std::unique_lock<std::mutex> lock(sessionPtr->spacesMutex);
+    XrSpace_T* added = spacePtr.get();
+    added->indexInSession = (uint32_t)sessionPtr->spaces.size();
+    XrResult res = g.spaces.Add(std::move(spacePtr), space);
+    if (res != XR_SUCCESS) {
+        return res;
+    }
+    sessionPtr->spaces.push_back(added);
+    return XR_SUCCESS;
+}
+
+// The location flags of a reference space located in another.
+XrSpaceLocationFlags ReferenceSpaceLocationFlags(XrReferenceSpaceType referenceSpaceType,
+                                                 XrReferenceSpaceType baseReferenceSpaceType) {
+    static constexpr XrSpaceLocationFlags validAndTracked =
+        XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT |
+        XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+
+    static constexpr XrSpaceLocationFlags validOnly =
+        XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+
+    if (referenceSpaceType == baseReferenceSpaceType) {
+        // same referenceSpaceType
+        return validAndTracked;
+    } else if ((referenceSpaceType == XR_REFERENCE_SPACE_TYPE_LOCAL &&
+                baseReferenceSpaceType == XR_REFERENCE_SPACE_TYPE_LOCAL_FLOOR) ||
+               (referenceSpaceType == XR_REFERENCE_SPACE_TYPE_LOCAL_FLOOR &&
+                baseReferenceSpaceType == XR_REFERENCE_SPACE_TYPE_LOCAL)) {
+        // same referenceSpaceType
+        return validAndTracked;
+    } else {
+        // different referenceSpaceType
+        return validOnly;
+    }
+}
+
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo* createInfo,
                                                                  XrSpace* space) {
     if (!validateQuat(createInfo->poseInReferenceSpace.orientation)) {
@@ -1363,18 +1986,12 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateReferenceSpace(XrSession sessi
     }
 
     auto spacePtr = std::make_unique<XrSpace_T>();
-    *space = promoteToHandle<XrSpace, XrSpace_T>(spacePtr.get());
     spacePtr->session = session;
     spacePtr->spaceType = XrSpace_T::SpaceType::ReferenceSpace;
     spacePtr->referenceSpaceType = createInfo->referenceSpaceType;
     spacePtr->poseInReferenceSpace = createInfo->poseInReferenceSpace;
 
-    {
-        std::unique_lock<std::mutex> lock(sessionPtr->spacesMutex);
-        sessionPtr->spaces.push_back(std::move(spacePtr));
-    }
-
-    return XR_SUCCESS;
+    return AddSpace(sessionPtr, std::move(spacePtr), space);
 }
 
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetReferenceSpaceBoundsRect(XrSession session, XrReferenceSpaceType referenceSpaceType,
@@ -1411,18 +2028,20 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrLocateSpace(XrSpace space, XrSpace b
 
     auto* spaceVelocity = findInNextChain<XrSpaceVelocity, XR_TYPE_SPACE_VELOCITY>(location->next);
 
-    static constexpr XrSpaceLocationFlags validAndTracked =
-        XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT |
-        XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
-
-    static constexpr XrSpaceLocationFlags validOnly =
-        XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT;
-
     static constexpr XrSpaceVelocityFlags velocityTracked =
         XR_SPACE_VELOCITY_LINEAR_VALID_BIT | XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
 
-    XrSpace_T* spacePtr = demoteFromHandle<XrSpace, XrSpace_T>(space);
-    XrSpace_T* baseSpacePtr = demoteFromHandle<XrSpace, XrSpace_T>(baseSpace);
+    XrSpace_T* spacePtr = g.spaces.Find(space);
+    XrSpace_T* baseSpacePtr = g.spaces.Find(baseSpace);
+    if (spacePtr == nullptr || baseSpacePtr == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(spacePtr->session);
+    const SyntheticLoad& syntheticLoad = demoteFromHandle<XrInstance, XrInstance_T>(sessionPtr->instance)->syntheticLoad;
+    if (syntheticLoad.locateSpaceCost != 0) {
+        SpinFor(syntheticLoad.locateSpaceCost);
+    }
 
     if (spacePtr->spaceType == XrSpace_T::SpaceType::ActionSpace &&
         baseSpacePtr->spaceType == XrSpace_T::SpaceType::ReferenceSpace) {
@@ -1438,19 +2057,7 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrLocateSpace(XrSpace space, XrSpace b
         return XR_SUCCESS;
     } else {
         // both reference spaces
-        if (spacePtr->referenceSpaceType == baseSpacePtr->referenceSpaceType) {
-            // same referenceSpaceType
-            location->locationFlags = validAndTracked;
-        } else if ((spacePtr->referenceSpaceType == XR_REFERENCE_SPACE_TYPE_LOCAL &&
-                    baseSpacePtr->referenceSpaceType == XR_REFERENCE_SPACE_TYPE_LOCAL_FLOOR) ||
-                   (spacePtr->referenceSpaceType == XR_REFERENCE_SPACE_TYPE_LOCAL_FLOOR &&
-                    baseSpacePtr->referenceSpaceType == XR_REFERENCE_SPACE_TYPE_LOCAL)) {
-            // same referenceSpaceType
-            location->locationFlags = validAndTracked;
-        } else {
-            // different referenceSpaceType
-            location->locationFlags = validOnly;
-        }
+        location->locationFlags = ReferenceSpaceLocationFlags(spacePtr->referenceSpaceType, baseSpacePtr->referenceSpaceType);
 
         XrPosef xfTargetOffsetFromTargetSpace = spacePtr->poseInReferenceSpace;
         XrPosef xfBaseOffsetFromBaseSpace = baseSpacePtr->poseInReferenceSpace;
@@ -1473,7 +2080,7 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrLocateSpace(XrSpace space, XrSpace b
     }
 }
 
-XRAPI_ATTR XrResult XRAPI_CALL TestRuntimeXrLocateSpaces(XrSession /*session*/, const XrSpacesLocateInfo* locateInfo,
+XRAPI_ATTR XrResult XRAPI_CALL TestRuntimeXrLocateSpaces(XrSession session, const XrSpacesLocateInfo* locateInfo,
                                                          XrSpaceLocations* spaceLocations) {
     if (locateInfo->time <= 0) {
         return XR_ERROR_TIME_INVALID;
@@ -1489,33 +2096,85 @@ XRAPI_ATTR XrResult XRAPI_CALL TestRuntimeXrLocateSpaces(XrSession /*session*/,
         }
     }
 
+    static constexpr XrSpaceVelocityFlags velocityTracked =
+        XR_SPACE_VELOCITY_LINEAR_VALID_BIT | XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
+
+    const XrSpace_T* baseSpacePtr = g.spaces.Find(locateInfo->baseSpace);
+    if (baseSpacePtr == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
+    const SyntheticLoad& syntheticLoad = demoteFromHandle<XrInstance, XrInstance_T>(sessionPtr->instance)->syntheticLoad;
+    if (syntheticLoad.locateSpaceCost != 0) {
+        SpinFor(syntheticLoad.locateSpaceCost * locateInfo->spaceCount);
+    }
+
+    // The reference spaces located in a reference space are gathered by component and transformed in one pass.  Kept
+    // for the thread, so locating spaces does not allocate once it has seen the largest batch.
+    struct Batch {
+        std::vector<uint32_t> indices;
+        std::vector<XrQuaternionf> orientations;
+        std::vector<XrVector3f> positions;
+        std::vector<XrPosef> poses;
+    };
+    thread_local Batch batch;
+    batch.indices.clear();
+    batch.orientations.clear();
+    batch.positions.clear();
+
     for (uint32_t i = 0; i < locateInfo->spaceCount; ++i) {
-        XrSpaceVelocity vel{XR_TYPE_SPACE_VELOCITY};
-        XrSpaceLocation loc{XR_TYPE_SPACE_LOCATION, &vel};
-        XrResult res = RuntimeTestXrLocateSpace(locateInfo->spaces[i], locateInfo->baseSpace, locateInfo->time, &loc);
-        if (res != XR_SUCCESS) {
-            return res;
+        const XrSpace_T* spacePtr = g.spaces.Find(locateInfo->spaces[i]);
+        if (spacePtr == nullptr) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+
+        XrSpaceLocationData& location = spaceLocations->locations[i];
+        const bool located = spacePtr->spaceType == XrSpace_T::SpaceType::ReferenceSpace &&
+                             baseSpacePtr->spaceType == XrSpace_T::SpaceType::ReferenceSpace;
+        if (located) {
+            location.locationFlags = ReferenceSpaceLocationFlags(spacePtr->referenceSpaceType, baseSpacePtr->referenceSpaceType);
+            batch.indices.push_back(i);
+            batch.orientations.push_back(spacePtr->poseInReferenceSpace.orientation);
+            batch.positions.push_back(spacePtr->poseInReferenceSpace.position);
+        } else {
+            location.locationFlags = 0;
+            location.pose = {};
         }
-        spaceLocations->locations[i].locationFlags = loc.locationFlags;
-        spaceLocations->locations[i].pose = loc.pose;
         if (spaceVelocities != nullptr) {
-            spaceVelocities->velocities[i].velocityFlags = vel.velocityFlags;
-            spaceVelocities->velocities[i].linearVelocity = vel.linearVelocity;
-            spaceVelocities->velocities[i].angularVelocity = vel.angularVelocity;
+            spaceVelocities->velocities[i].velocityFlags = located ? velocityTracked : 0;
+            spaceVelocities->velocities[i].linearVelocity = {0, 0, 0};
+            spaceVelocities->velocities[i].angularVelocity = {0, 0, 0};
         }
     }
 
+    XrPosef xfBaseSpaceFromBaseOffset;
+    XrPosef_Invert(&xfBaseSpaceFromBaseOffset, &baseSpacePtr->poseInReferenceSpace);
+
+    const uint32_t batchCount = (uint32_t)batch.indices.size();
+    batch.poses.resize(batchCount);
+    XrPosef_MultiplyArray(batch.poses.data(), &xfBaseSpaceFromBaseOffset, batch.orientations.data(), batch.positions.data(),
+                          batchCount);
+    for (uint32_t k = 0; k < batchCount; ++k) {
+        spaceLocations->locations[batch.indices[k]].pose = batch.poses[k];
+    }
+
     return XR_SUCCESS;
 }
 
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrDestroySpace(XrSpace space) {
     {
-        XrSpace_T* spacePtr = demoteFromHandle<XrSpace, XrSpace_T>(space);
+        XrSpace_T* spacePtr = g.spaces.Find(space);
+        if (spacePtr == nullptr) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
         XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(spacePtr->session);
         std::unique_lock<std::mutex> lock(sessionPtr->spacesMutex);
-        const auto& it = std::find_if(sessionPtr->spaces.begin(), sessionPtr->spaces.end(),
-                                      [space](const auto& i) { return demoteFromHandle<XrSpace, XrSpace_T>(space) == i.get(); });
-        sessionPtr->spaces.erase(it);
+        XrSpace_T* last = sessionPtr->spaces.back();
+        last->indexInSession = spacePtr->indexInSession;
+        sessionPtr->spaces[spacePtr->indexInSession] = last;
+        sessionPtr->spaces.pop_back();
+        g.spaces.Remove(spacePtr);
     }
 
     return XR_SUCCESS;
@@ -1593,43 +2252,22 @@ bool validatePath(const char* path) {
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrStringToPath(XrInstance instance, const char* pathString, XrPath* path) {
     XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(instance);
 
-    {
-        std::unique_lock<std::mutex> lock(instancePtr->pathsMutex);
-        const auto& it = std::find_if(instancePtr->paths.begin(), instancePtr->paths.end(),
-                                      [pathString](const auto& i) { return strcmp(i.second.c_str(), pathString) == 0; });
-        if (it != instancePtr->paths.end()) {
-            *path = it->first;
-            return XR_SUCCESS;
-        }
-
-        if (!validatePath(pathString)) {
-            return XR_ERROR_PATH_FORMAT_INVALID;
-        }
-
-        XrPath currentPath = instancePtr->lastPath;
-        instancePtr->lastPath++;
-        instancePtr->paths[currentPath] = pathString;
-        *path = currentPath;
-        return XR_SUCCESS;
+    // Every interned string is valid, so validating before the lookup changes no result.
+    if (!validatePath(pathString)) {
+        return XR_ERROR_PATH_FORMAT_INVALID;
     }
+    return instancePtr->paths.Intern(pathString, path);
 }
 
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrPathToString(XrInstance instance, XrPath path, uint32_t bufferCapacityInput,
                                                          uint32_t* bufferCountOutput, char* buffer) {
     XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(instance);
 
-    {
-        std::unique_lock<std::mutex> lock(instancePtr->pathsMutex);
-        const auto& it =
-            std::find_if(instancePtr->paths.begin(), instancePtr->paths.end(), [path](const auto& i) { return i.first == path; });
-
-        if (it != instancePtr->paths.end()) {
-            std::string str = it->second;
-            return ElementCapacityWrite(bufferCapacityInput, bufferCountOutput, buffer, str.data(), str.size() + 1);
-        }
-
+    const std::string* str = instancePtr->paths.Find(path);
+    if (str == nullptr) {
         return XR_ERROR_PATH_INVALID;
     }
+    return ElementCapacityWrite(bufferCapacityInput, bufferCountOutput, buffer, str->data(), str->size() + 1);
 }
 
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateActionSet(XrInstance instance, const XrActionSetCreateInfo* createInfo,
@@ -1689,6 +2327,83 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrDestroyActionSet(XrActionSet actionS
     return XR_SUCCESS;
 }
 
+// The interaction profile definitions of the instance's API version and extensions.
+const std::vector<InteractionProfileMetadata>& GetInteractionProfileDefinitions(const XrInstance_T* instancePtr) {
+    if (instancePtr->apiVersion < XR_MAKE_VERSION(1, 1, 0)) {
+        if (std::find(instancePtr->enabledExtensions.begin(), instancePtr->enabledExtensions.end(),
+                      XR_KHR_MAINTENANCE1_EXTENSION_NAME) != instancePtr->enabledExtensions.end()) {
+            return cInteractionProfileDefinitions_1_0_khr_maintenance1;
+        }
+        return cInteractionProfileDefinitions_1_0;
+    }
+    // This is not strictly correct - but OpenXR 1.1 is a superset of maintenance1
+    // so we are ok if OpenXR 1.1 and maintenance1 are both enabled.
+    // https://gitlab.khronos.org/openxr/openxr/-/issues/2599
+    return cInteractionProfileDefinitions_1_1;
+}
+
+// Intern every path of the instance's interaction profiles.  A binding may be an input source path, or one that ends in
+// /click, /value or /pose without that suffix.
+XrResult BuildInteractionProfileIndex(XrInstance_T* instancePtr, InteractionProfileIndex* index) {
+    constexpr std::array<const char*, 3> supportedSuffixes = {{
+        "/click",
+        "/value",
+        "/pose",
+    }};
+
+    for (const auto& def : GetInteractionProfileDefinitions(instancePtr)) {
+        XrPath profilePath{XR_NULL_PATH};
+        XrResult res = instancePtr->paths.Intern(def.InteractionProfilePathString.c_str(), &profilePath);
+        if (res != XR_SUCCESS) {
+            return res;
+        }
+        std::unordered_set<XrPath>& bindingPaths = index->bindingPaths[profilePath];
+
+        for (const auto& tlp : def.TopLevelPaths) {
+            XrPath path{XR_NULL_PATH};
+            res = instancePtr->paths.Intern(tlp.c_str(), &path);
+            if (res != XR_SUCCESS) {
+                return res;
+            }
+            index->topLevelPaths.insert(path);
+        }
+
+        for (const char* supportedPath : def.InputSourcePaths) {
+            XrPath path{XR_NULL_PATH};
+            res = instancePtr->paths.Intern(supportedPath, &path);
+            if (res != XR_SUCCESS) {
+                return res;
+            }
+            bindingPaths.insert(path);
+
+            const size_t supportedPathLen = strlen(supportedPath);
+            for (const char* suffix : supportedSuffixes) {
+                const size_t suffixLen = strlen(suffix);
+                if (supportedPathLen > suffixLen && strcmp(supportedPath + supportedPathLen - suffixLen, suffix) == 0) {
+                    const std::string withoutSuffix(supportedPath, supportedPathLen - suffixLen);
+                    res = instancePtr->paths.Intern(withoutSuffix.c_str(), &path);
+                    if (res != XR_SUCCESS) {
+                        return res;
+                    }
+                    bindingPaths.insert(path);
+                }
+            }
+        }
+    }
+    return XR_SUCCESS;
+}
+
+// The instance's interaction profile index, built on first use.  Its paths are all valid, so building it fails only if the
+// instance runs out of paths.
+XrResult GetInteractionProfileIndex(XrInstance_T* instancePtr, const InteractionProfileIndex** index) {
+    std::call_once(instancePtr->interactionProfileIndexOnce, [instancePtr] {
+        instancePtr->interactionProfileIndexResult =
+            BuildInteractionProfileIndex(instancePtr, &instancePtr->interactionProfileIndex);
+    });
+    *index = &instancePtr->interactionProfileIndex;
+    return instancePtr->interactionProfileIndexResult;
+}
+
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateAction(XrActionSet actionSet, const XrActionCreateInfo* createInfo,
                                                          XrAction* action) {
     if (createInfo->actionName[0] == '\0') {
@@ -1738,47 +2453,30 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateAction(XrActionSet actionSet,
 
         XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(actionSetPtr->instance);
 
-        std::vector<InteractionProfileMetadata> definitions;
-        if (instancePtr->apiVersion < XR_MAKE_VERSION(1, 1, 0)) {
-            definitions = cInteractionProfileDefinitions_1_0;
-            if (std::find(instancePtr->enabledExtensions.begin(), instancePtr->enabledExtensions.end(),
-                          XR_KHR_MAINTENANCE1_EXTENSION_NAME) != instancePtr->enabledExtensions.end()) {
-                definitions = cInteractionProfileDefinitions_1_0_khr_maintenance1;
-            }
-        } else {
-            // This is not strictly correct - but OpenXR 1.1 is a superset of maintenance1
-            // so we are ok if OpenXR 1.1 and maintenance1 are both enabled.
-            // https://gitlab.khronos.org/openxr/openxr/-/issues/2599
-            definitions = cInteractionProfileDefinitions_1_1;
+        const InteractionProfileIndex* index = nullptr;
+        XrResult res = GetInteractionProfileIndex(instancePtr, &index);
+        if (res != XR_SUCCESS) {
+            return res;
         }
 
         // CTS requires valid top level path from known IPs
         // This seems like something valuable to check but is not strictly required by the spec.
-        bool validTLP = false;
-        for (const auto& def : definitions) {
-            for (const auto& tlp : def.TopLevelPaths) {
-                XrPath path{XR_NULL_PATH};
-                XrResult res = RuntimeTestXrStringToPath(actionSetPtr->instance, tlp.c_str(), &path);
-                if (res != XR_SUCCESS) {
-                    return res;
-                }
-                if (createInfo->subactionPaths[i] == path) {
-                    validTLP = true;
-                }
-            }
-        }
-        if (!validTLP) {
+        if (index->topLevelPaths.count(createInfo->subactionPaths[i]) == 0) {
             return XR_ERROR_PATH_UNSUPPORTED;
         }
 
         actionPtr->subactionPaths.push_back(createInfo->subactionPaths[i]);
     }
 
-    *action = promoteToHandle<XrAction, XrAction_T>(actionPtr.get());
-
     {
         std::unique_lock<std::mutex> lock(actionSetPtr->actionsMutex);
-        actionSetPtr->actions.push_back(std::move(actionPtr));
+        XrAction_T* added = actionPtr.get();
+        added->indexInSet = (uint32_t)actionSetPtr->actions.size();
+        XrResult res = g.actions.Add(std::move(actionPtr), action);
+        if (res != XR_SUCCESS) {
+            return res;
+        }
+        actionSetPtr->actions.push_back(added);
     }
 
     return XR_SUCCESS;
@@ -1786,98 +2484,54 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateAction(XrActionSet actionSet,
 
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrDestroyAction(XrAction action) {
     {
-        XrAction_T* actionPtr = demoteFromHandle<XrAction, XrAction_T>(action);
+        XrAction_T* actionPtr = g.actions.Find(action);
+        if (actionPtr == nullptr) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
         XrActionSet_T* actionSetPtr = demoteFromHandle<XrActionSet, XrActionSet_T>(actionPtr->actionSet);
         std::unique_lock<std::mutex> lock(actionSetPtr->actionsMutex);
-        const auto& it = std::find_if(actionSetPtr->actions.begin(), actionSetPtr->actions.end(),
-                                      [actionPtr](const auto& i) { return actionPtr == i.get(); });
-        actionSetPtr->actions.erase(it);
+        XrAction_T* last = actionSetPtr->actions.back();
+        last->indexInSet = actionPtr->indexInSet;
+        actionSetPtr->actions[actionPtr->indexInSet] = last;
+        actionSetPtr->actions.pop_back();
+        g.actions.Remove(actionPtr);
     }
 
     return XR_SUCCESS;
 }
 
-std::string pathToStdString(XrInstance instance, XrPath path) {
-    std::array<char, XR_MAX_PATH_LENGTH> buffer{};
-    auto count = static_cast<uint32_t>(buffer.size());
-    // if we get a failure here we will return an empty string
-    (void)RuntimeTestXrPathToString(instance, path, count, &count, buffer.data());
-    return {buffer.data()};
-}
-
 XRAPI_ATTR XrResult XRAPI_CALL
 RuntimeTestXrSuggestInteractionProfileBindings(XrInstance instance, const XrInteractionProfileSuggestedBinding* suggestedBindings) {
     if (suggestedBindings->countSuggestedBindings == 0) {
         return XR_ERROR_VALIDATION_FAILURE;
     }
 
-    std::string pathStr = pathToStdString(instance, suggestedBindings->interactionProfile);
-
     XrInstance_T* instancePtr = demoteFromHandle<XrInstance, XrInstance_T>(instance);
 
-    std::vector<InteractionProfileMetadata> definitions;
-    if (instancePtr->apiVersion < XR_MAKE_VERSION(1, 1, 0)) {
-        definitions = cInteractionProfileDefinitions_1_0;
-        if (std::find(instancePtr->enabledExtensions.begin(), instancePtr->enabledExtensions.end(),
-                      XR_KHR_MAINTENANCE1_EXTENSION_NAME) != instancePtr->enabledExtensions.end()) {
-            definitions = cInteractionProfileDefinitions_1_0_khr_maintenance1;
-        }
-    } else {
-        definitions = cInteractionProfileDefinitions_1_1;
+    const InteractionProfileIndex* index = nullptr;
+    XrResult res = GetInteractionProfileIndex(instancePtr, &index);
+    if (res != XR_SUCCESS) {
+        return res;
     }
 
-    const auto& it = std::find_if(definitions.begin(), definitions.end(), [pathStr](const auto& i) {
-        return strcmp(i.InteractionProfilePathString.c_str(), pathStr.c_str()) == 0;
-    });
-
-    if (it == definitions.end()) {
+    const auto& it = index->bindingPaths.find(suggestedBindings->interactionProfile);
+    if (it == index->bindingPaths.end()) {
         return XR_ERROR_PATH_UNSUPPORTED;
     }
 
     for (uint32_t i = 0; i < suggestedBindings->countSuggestedBindings; ++i) {
         // is this supported for this IP?
-        {
-            XrPath bindingPath = suggestedBindings->suggestedBindings[i].binding;
-            auto bindingStr = pathToStdString(instance, bindingPath);
-
-            bool supportedForIP = false;
-            for (const auto& supportedPath : it->InputSourcePaths) {
-                constexpr std::array<const char*, 3> supportedSuffixes = {{
-                    "/click",
-                    "/value",
-                    "/pose",
-                }};
-
-                for (const char* suffix : supportedSuffixes) {
-                    size_t suffixLen = strlen(suffix);
-                    size_t supportedPathLen = strlen(supportedPath);
-
-                    // if (supportedPath.ends_with(suffix)) {...}
-                    if (strcmp(supportedPath + supportedPathLen - suffixLen, suffix) == 0) {
-                        // if (std::string_view(supportedPath, supportedPathLen - suffixLen) == bindingStr) {...}
-                        if (strncmp(supportedPath, bindingStr.c_str(), supportedPathLen - suffixLen) == 0 &&
-                            bindingStr.c_str()[supportedPathLen - suffixLen] == '\0') {
-                            supportedForIP = true;
-                            break;
-                        }
-                    }
-                }
-
-                if (strcmp(supportedPath, bindingStr.c_str()) == 0) {
-                    supportedForIP = true;
-                    break;
-                }
-            }
-
-            if (!supportedForIP) {
-                return XR_ERROR_PATH_UNSUPPORTED;
-            }
+        if (it->second.count(suggestedBindings->suggestedBindings[i].binding) == 0) {
+            return XR_ERROR_PATH_UNSUPPORTED;
         }
 
         // is actionset attached for any of the actions?
         {
             XrAction bindingAction = suggestedBindings->suggestedBindings[i].action;
-            XrAction_T* actionPtr = demoteFromHandle<XrAction, XrAction_T>(bindingAction);
+            XrAction_T* actionPtr = g.actions.Find(bindingAction);
+            if (actionPtr == nullptr) {
+                return XR_ERROR_HANDLE_INVALID;
+            }
 
             XrActionSet_T* actionSetPtr = demoteFromHandle<XrActionSet, XrActionSet_T>(actionPtr->actionSet);
             if (actionSetPtr->hasBeenAttached) {
@@ -1911,6 +2565,23 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrAttachSessionActionSets(XrSession se
 
         XrActionSet_T* actionSetPtr = demoteFromHandle<XrActionSet, XrActionSet_T>(attachInfo->actionSets[i]);
         actionSetPtr->hasBeenAttached = true;
+
+        // No action can be created in an attached set, so the states of its actions can be laid out once.
+        std::unique_lock<std::mutex> lock(actionSetPtr->actionsMutex);
+        for (const XrAction_T* actionPtr : actionSetPtr->actions) {
+            if (actionPtr->slot >= sessionPtr->actionStateRanges.size()) {
+                sessionPtr->actionStateRanges.resize(actionPtr->slot + 1);
+            }
+            ActionStateRange& range = sessionPtr->actionStateRanges[actionPtr->slot];
+            range.action = actionPtr->handle;
+            range.offset = (uint32_t)sessionPtr->actionStates.size();
+
+            sessionPtr->actionStates.emplace_back();
+            for (XrPath subactionPath : actionPtr->subactionPaths) {
+                sessionPtr->actionStates.emplace_back();
+                sessionPtr->actionStates.back().subactionPath = subactionPath;
+            }
+        }
     }
 
     return XR_SUCCESS;
@@ -1928,26 +2599,55 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetCurrentInteractionProfile(XrSessi
     return XR_SUCCESS;
 }
 
-XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetActionStateBoolean(XrSession session, const XrActionStateGetInfo* getInfo,
-                                                                  XrActionStateBoolean* state) {
-    XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
-
+// Validate the action and subaction path of an action state get info or haptic action info, and find the state of the
+// action in the session, as a whole or for the subaction path.
+XrResult FindActionState(XrSession_T* sessionPtr, XrAction action, XrActionType actionType, XrPath subactionPath,
+                         ActionState** state) {
     if (!sessionPtr->actionsetsAttached) {
         return XR_ERROR_ACTIONSET_NOT_ATTACHED;
     }
 
-    XrAction_T* actionPtr = demoteFromHandle<XrAction, XrAction_T>(getInfo->action);
-    if (actionPtr->actionType != XR_ACTION_TYPE_BOOLEAN_INPUT) {
+    const XrAction_T* actionPtr = g.actions.Find(action);
+    if (actionPtr == nullptr) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (actionPtr->slot >= sessionPtr->actionStateRanges.size() ||
+        sessionPtr->actionStateRanges[actionPtr->slot].action != action) {
+        return XR_ERROR_ACTIONSET_NOT_ATTACHED;
+    }
+    if (actionPtr->actionType != actionType) {
         return XR_ERROR_ACTION_TYPE_MISMATCH;
     }
-    if (getInfo->subactionPath != XR_NULL_PATH) {
-        if (std::find(actionPtr->subactionPaths.begin(), actionPtr->subactionPaths.end(), getInfo->subactionPath) ==
-            actionPtr->subactionPaths.end()) {
-            return XR_ERROR_PATH_UNSUPPORTED;
+
+    ActionState* states = &sessionPtr->actionStates[sessionPtr->actionStateRanges[actionPtr->slot].offset];
+    if (subactionPath == XR_NULL_PATH) {
+        *state = states;
+        return XR_SUCCESS;
+    }
+    // An action has at most one subaction path for each top level path, so there are only a few, next to each other.
+    for (size_t i = 1; i <= actionPtr->subactionPaths.size(); ++i) {
+        if (states[i].subactionPath == subactionPath) {
+            *state = &states[i];
+            return XR_SUCCESS;
         }
     }
+    return XR_ERROR_PATH_UNSUPPORTED;
+}
 
-    state->isActive = XR_FALSE;
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetActionStateBoolean(XrSession session, const XrActionStateGetInfo* getInfo,
+                                                                  XrActionStateBoolean* state) {
+    XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
+
+    ActionState* actionState = nullptr;
+    XrResult res = FindActionState(sessionPtr, getInfo->action, XR_ACTION_TYPE_BOOLEAN_INPUT, getInfo->subactionPath, &actionState);
+    if (res != XR_SUCCESS) {
+        return res;
+    }
+
+    state->isActive = actionState->isActive;
+    state->currentState = actionState->value.x != 0.0f ? XR_TRUE : XR_FALSE;
+    state->changedSinceLastSync = actionState->changedSinceLastSync;
+    state->lastChangeTime = actionState->lastChangeTime;
     return XR_SUCCESS;
 }
 
@@ -1955,22 +2655,16 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetActionStateFloat(XrSession sessio
                                                                 XrActionStateFloat* state) {
     XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
 
-    if (!sessionPtr->actionsetsAttached) {
-        return XR_ERROR_ACTIONSET_NOT_ATTACHED;
+    ActionState* actionState = nullptr;
+    XrResult res = FindActionState(sessionPtr, getInfo->action, XR_ACTION_TYPE_FLOAT_INPUT, getInfo->subactionPath, &actionState);
+    if (res != XR_SUCCESS) {
+        return res;
     }
 
-    XrAction_T* actionPtr = demoteFromHandle<XrAction, XrAction_T>(getInfo->action);
-    if (actionPtr->actionType != XR_ACTION_TYPE_FLOAT_INPUT) {
-        return XR_ERROR_ACTION_TYPE_MISMATCH;
-    }
-    if (getInfo->subactionPath != XR_NULL_PATH) {
-        if (std::find(actionPtr->subactionPaths.begin(), actionPtr->subactionPaths.end(), getInfo->subactionPath) ==
-            actionPtr->subactionPaths.end()) {
-            return XR_ERROR_PATH_UNSUPPORTED;
-        }
-    }
-
-    state->isActive = XR_FALSE;
+    state->isActive = actionState->isActive;
+    state->currentState = actionState->value.x;
+    state->changedSinceLastSync = actionState->changedSinceLastSync;
+    state->lastChangeTime = actionState->lastChangeTime;
     return XR_SUCCESS;
 }
 
@@ -1978,22 +2672,17 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetActionStateVector2f(XrSession ses
                                                                    XrActionStateVector2f* state) {
     XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
 
-    if (!sessionPtr->actionsetsAttached) {
-        return XR_ERROR_ACTIONSET_NOT_ATTACHED;
-    }
-
-    XrAction_T* actionPtr = demoteFromHandle<XrAction, XrAction_T>(getInfo->action);
-    if (actionPtr->actionType != XR_ACTION_TYPE_VECTOR2F_INPUT) {
-        return XR_ERROR_ACTION_TYPE_MISMATCH;
-    }
-    if (getInfo->subactionPath != XR_NULL_PATH) {
-        if (std::find(actionPtr->subactionPaths.begin(), actionPtr->subactionPaths.end(), getInfo->subactionPath) ==
-            actionPtr->subactionPaths.end()) {
-            return XR_ERROR_PATH_UNSUPPORTED;
-        }
+    ActionState* actionState = nullptr;
+    XrResult res =
+        FindActionState(sessionPtr, getInfo->action, XR_ACTION_TYPE_VECTOR2F_INPUT, getInfo->subactionPath, &actionState);
+    if (res != XR_SUCCESS) {
+        return res;
     }
 
-    state->isActive = XR_FALSE;
+    state->isActive = actionState->isActive;
+    state->currentState = actionState->value;
+    state->changedSinceLastSync = actionState->changedSinceLastSync;
+    state->lastChangeTime = actionState->lastChangeTime;
     return XR_SUCCESS;
 }
 
@@ -2001,22 +2690,13 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetActionStatePose(XrSession session
                                                                XrActionStatePose* state) {
     XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
 
-    if (!sessionPtr->actionsetsAttached) {
-        return XR_ERROR_ACTIONSET_NOT_ATTACHED;
+    ActionState* actionState = nullptr;
+    XrResult res = FindActionState(sessionPtr, getInfo->action, XR_ACTION_TYPE_POSE_INPUT, getInfo->subactionPath, &actionState);
+    if (res != XR_SUCCESS) {
+        return res;
     }
 
-    XrAction_T* actionPtr = demoteFromHandle<XrAction, XrAction_T>(getInfo->action);
-    if (actionPtr->actionType != XR_ACTION_TYPE_POSE_INPUT) {
-        return XR_ERROR_ACTION_TYPE_MISMATCH;
-    }
-    if (getInfo->subactionPath != XR_NULL_PATH) {
-        if (std::find(actionPtr->subactionPaths.begin(), actionPtr->subactionPaths.end(), getInfo->subactionPath) ==
-            actionPtr->subactionPaths.end()) {
-            return XR_ERROR_PATH_UNSUPPORTED;
-        }
-    }
-
-    state->isActive = XR_FALSE;
+    state->isActive = actionState->isActive;
     return XR_SUCCESS;
 }
 
@@ -2066,18 +2746,9 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrApplyHapticFeedback(XrSession sessio
         return XR_SESSION_NOT_FOCUSED;
     }
 
-    XrAction_T* actionPtr = demoteFromHandle<XrAction, XrAction_T>(hapticActionInfo->action);
-    if (actionPtr->actionType != XR_ACTION_TYPE_VIBRATION_OUTPUT) {
-        return XR_ERROR_ACTION_TYPE_MISMATCH;
-    }
-    if (hapticActionInfo->subactionPath != XR_NULL_PATH) {
-        if (std::find(actionPtr->subactionPaths.begin(), actionPtr->subactionPaths.end(), hapticActionInfo->subactionPath) ==
-            actionPtr->subactionPaths.end()) {
-            return XR_ERROR_PATH_UNSUPPORTED;
-        }
-    }
-
-    return XR_SUCCESS;
+    ActionState* actionState = nullptr;
+    return FindActionState(sessionPtr, hapticActionInfo->action, XR_ACTION_TYPE_VIBRATION_OUTPUT, hapticActionInfo->subactionPath,
+                           &actionState);
 }
 
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrStopHapticFeedback(XrSession session, const XrHapticActionInfo* hapticActionInfo) {
@@ -2091,18 +2762,9 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrStopHapticFeedback(XrSession session
         return XR_SESSION_NOT_FOCUSED;
     }
 
-    XrAction_T* actionPtr = demoteFromHandle<XrAction, XrAction_T>(hapticActionInfo->action);
-    if (actionPtr->actionType != XR_ACTION_TYPE_VIBRATION_OUTPUT) {
-        return XR_ERROR_ACTION_TYPE_MISMATCH;
-    }
-    if (hapticActionInfo->subactionPath != XR_NULL_PATH) {
-        if (std::find(actionPtr->subactionPaths.begin(), actionPtr->subactionPaths.end(), hapticActionInfo->subactionPath) ==
-            actionPtr->subactionPaths.end()) {
-            return XR_ERROR_PATH_UNSUPPORTED;
-        }
-    }
-
-    return XR_SUCCESS;
+    ActionState* actionState = nullptr;
+    return FindActionState(sessionPtr, hapticActionInfo->action, XR_ACTION_TYPE_VIBRATION_OUTPUT, hapticActionInfo->subactionPath,
+                           &actionState);
 }
 
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateActionSpace(XrSession session, const XrActionSpaceCreateInfo* /*createInfo*/,
@@ -2115,20 +2777,14 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateActionSpace(XrSession session,
     XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
 
     auto spacePtr = std::make_unique<XrSpace_T>();
-    *space = promoteToHandle<XrSpace, XrSpace_T>(spacePtr.get());
     spacePtr->session = session;
     spacePtr->spaceType = XrSpace_T::SpaceType::ActionSpace;
 
-    {
-        std::unique_lock<std::mutex> lock(sessionPtr->spacesMutex);
-        sessionPtr->spaces.push_back(std::move(spacePtr));
-    }
-
-    return XR_SUCCESS;
+    return AddSpace(sessionPtr, std::move(spacePtr), space);
 }
 
 //
-// Unimplemented graphics bindings functions
+// Frames and views
 //
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrWaitFrame(XrSession session, const XrFrameWaitInfo* /*frameWaitInfo*/,
                                                       XrFrameState* frameState) {
@@ -2137,7 +2793,31 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrWaitFrame(XrSession session, const X
         return XR_ERROR_SESSION_NOT_RUNNING;
     }
 
-    frameState->shouldRender = XR_FALSE;
+    // Only a session with a graphics binding has swapchains to render to.
+    const XrSessionState sessionState = sessionPtr->sessionState;
+    frameState->shouldRender = sessionPtr->HasGraphicsBinding() && (sessionState == XR_SESSION_STATE_VISIBLE ||
+                                                                     sessionState == XR_SESSION_STATE_FOCUSED)
+                                   ? XR_TRUE
+                                   : XR_FALSE;
+
+    const XrDuration framePeriod = demoteFromHandle<XrInstance, XrInstance_T>(sessionPtr->instance)->syntheticLoad.framePeriod;
+    if (framePeriod != 0) {
+        // Wait for the first frame boundary after the last one returned, or after now if that one is already past.
+        const XrTime now = currentXrTime();
+        XrTime frameTime = sessionPtr->lastFrameTime + framePeriod;
+        if (frameTime < now) {
+            const XrDuration sinceBegin = now - sessionPtr->beginTime;
+            frameTime = sessionPtr->beginTime + (sinceBegin + framePeriod - 1) / framePeriod * framePeriod;
+        }
+        if (frameTime > now) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(frameTime - now));
+        }
+        sessionPtr->lastFrameTime = frameTime;
+        frameState->predictedDisplayTime = frameTime + framePeriod;
+        frameState->predictedDisplayPeriod = framePeriod;
+        return XR_SUCCESS;
+    }
+
     frameState->predictedDisplayTime = currentXrTime();
     frameState->predictedDisplayPeriod = (1.f / 60.f) * 1e9;  // 60 Hz
     return XR_SUCCESS;
@@ -2158,7 +2838,7 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrEndFrame(XrSession session, const Xr
 }
 
 XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrLocateViews(XrSession session, const XrViewLocateInfo* viewLocateInfo,
-                                                        XrViewState* /*viewState*/, uint32_t viewCapacityInput,
+                                                        XrViewState* viewState, uint32_t viewCapacityInput,
                                                         uint32_t* viewCountOutput, XrView* views) {
     XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
 
@@ -2169,6 +2849,9 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrLocateViews(XrSession session, const
         return XR_ERROR_TIME_INVALID;
     }
 
+    viewState->viewStateFlags = XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT |
+                                XR_VIEW_STATE_ORIENTATION_TRACKED_BIT | XR_VIEW_STATE_POSITION_TRACKED_BIT;
+
     std::array<XrView, 2> locatedViews{{XrView{XR_TYPE_VIEW}, XrView{XR_TYPE_VIEW}}};
     for (auto& locatedView : locatedViews) {
         locatedView.pose.orientation.w = 1.f;
@@ -2227,39 +2910,214 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetViewConfigurationProperties(XrIns
     return XR_SUCCESS;
 }
 
-XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrEnumerateSwapchainFormats(XrSession /*session*/, uint32_t formatCapacityInput,
+//
+// Swapchains
+//
+
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+// The formats of Vulkan swapchains, color then depth, in the order of preference of a runtime that composites in sRGB.
+constexpr std::array<int64_t, 7> VulkanSwapchainFormats{{
+    VK_FORMAT_R8G8B8A8_SRGB,
+    VK_FORMAT_B8G8R8A8_SRGB,
+    VK_FORMAT_R8G8B8A8_UNORM,
+    VK_FORMAT_B8G8R8A8_UNORM,
+    VK_FORMAT_D32_SFLOAT,
+    VK_FORMAT_D24_UNORM_S8_UINT,
+    VK_FORMAT_D16_UNORM,
+}};
+
+// Create the images of a Vulkan swapchain, each in device local memory of its own, with the usage the application asked for
+// and the sampling a compositor would need.
+XrResult CreateVulkanSwapchainImages(const VulkanBinding& vulkan, const XrSwapchainCreateInfo& createInfo,
+                                     XrSwapchain_T* swapchainPtr) {
+    VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    imageInfo.flags = createInfo.faceCount == 6 ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+    if ((createInfo.usageFlags & XR_SWAPCHAIN_USAGE_MUTABLE_FORMAT_BIT) != 0) {
+        imageInfo.flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+    }
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = (VkFormat)createInfo.format;
+    imageInfo.extent = {createInfo.width, createInfo.height, 1};
+    imageInfo.mipLevels = createInfo.mipCount;
+    imageInfo.arrayLayers = createInfo.arraySize * createInfo.faceCount;
+    imageInfo.samples = (VkSampleCountFlagBits)createInfo.sampleCount;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+    const std::array<std::pair<XrSwapchainUsageFlags, VkImageUsageFlags>, 6> usages{{
+        {XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT},
+        {XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT},
+        {XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT, VK_IMAGE_USAGE_STORAGE_BIT},
+        {XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT},
+        {XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT, VK_IMAGE_USAGE_TRANSFER_DST_BIT},
+        {XR_SWAPCHAIN_USAGE_INPUT_ATTACHMENT_BIT_KHR, VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT},
+    }};
+    for (const auto& usage : usages) {
+        if ((createInfo.usageFlags & usage.first) != 0) {
+            imageInfo.usage |= usage.second;
+        }
+    }
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vulkan.vkGetPhysicalDeviceMemoryProperties(vulkan.physicalDevice, &memoryProperties);
+
+    swapchainPtr->vulkan = &vulkan;
+    for (uint32_t i = 0; i < swapchainPtr->imageCount; i++) {
+        VkImage image;
+        if (vulkan.vkCreateImage(vulkan.device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        swapchainPtr->vulkanImages.push_back(image);
+
+        VkMemoryRequirements requirements;
+        vulkan.vkGetImageMemoryRequirements(vulkan.device, image, &requirements);
+        VkMemoryAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = memoryProperties.memoryTypeCount;
+        for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++) {
+            if ((requirements.memoryTypeBits & (1u << type)) != 0 &&
+                (memoryProperties.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0) {
+                allocateInfo.memoryTypeIndex = type;
+                break;
+            }
+        }
+        if (allocateInfo.memoryTypeIndex == memoryProperties.memoryTypeCount) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+        VkDeviceMemory memory;
+        const VkResult result = vulkan.vkAllocateMemory(vulkan.device, &allocateInfo, nullptr, &memory);
+        if (result != VK_SUCCESS) {
+            return result == VK_ERROR_OUT_OF_DEVICE_MEMORY ? XR_ERROR_OUT_OF_MEMORY : XR_ERROR_RUNTIME_FAILURE;
+        }
+        swapchainPtr->vulkanMemory.push_back(memory);
+        if (vulkan.vkBindImageMemory(vulkan.device, image, memory, 0) != VK_SUCCESS) {
+            return XR_ERROR_RUNTIME_FAILURE;
+        }
+    }
+    return XR_SUCCESS;
+}
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrEnumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInput,
                                                                       uint32_t* formatCountOutput, int64_t* formats) {
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+    if (demoteFromHandle<XrSession, XrSession_T>(session)->vulkan.device != VK_NULL_HANDLE) {
+        return ElementCapacityWrite(formatCapacityInput, formatCountOutput, formats, VulkanSwapchainFormats.data(),
+                                    VulkanSwapchainFormats.size());
+    }
+#else
+    (void)session;
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
     std::array<int64_t, 0> knownFormats{};
     return ElementCapacityWrite(formatCapacityInput, formatCountOutput, formats, knownFormats.data(), knownFormats.size());
 }
 
-XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateSwapchain(XrSession /*session*/, const XrSwapchainCreateInfo* /*createInfo*/,
-                                                            XrSwapchain* /*swapchain*/) {
-    return XR_ERROR_FUNCTION_UNSUPPORTED;
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo,
+                                                            XrSwapchain* swapchain) {
+    XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(session);
+    if (!sessionPtr->HasGraphicsBinding()) {
+        return XR_ERROR_FUNCTION_UNSUPPORTED;  // A headless session has no swapchains.
+    }
+    if (createInfo->width == 0 || createInfo->height == 0 || createInfo->width > MAX_SWAPCHAIN_IMAGE_SIZE ||
+        createInfo->height > MAX_SWAPCHAIN_IMAGE_SIZE || createInfo->arraySize == 0 || createInfo->mipCount == 0 ||
+        (createInfo->faceCount != 1 && createInfo->faceCount != 6) || createInfo->sampleCount == 0) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    auto swapchainPtr = std::make_unique<XrSwapchain_T>();
+    swapchainPtr->session = session;
+    swapchainPtr->staticImage = (createInfo->createFlags & XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT) != 0;
+    swapchainPtr->imageCount = swapchainPtr->staticImage ? 1 : 3;
+
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+    if (std::find(VulkanSwapchainFormats.begin(), VulkanSwapchainFormats.end(), createInfo->format) ==
+        VulkanSwapchainFormats.end()) {
+        return XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+    }
+    const XrResult result = CreateVulkanSwapchainImages(sessionPtr->vulkan, *createInfo, swapchainPtr.get());
+    if (XR_FAILED(result)) {
+        return result;
+    }
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+
+    *swapchain = promoteToHandle<XrSwapchain, XrSwapchain_T>(swapchainPtr.get());
+
+    {
+        std::unique_lock<std::mutex> lock(sessionPtr->swapchainsMutex);
+        sessionPtr->swapchains.push_back(std::move(swapchainPtr));
+    }
+
+    return XR_SUCCESS;
 }
 
-XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrDestroySwapchain(XrSwapchain /*swapchain*/) { return XR_ERROR_FUNCTION_UNSUPPORTED; }
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrDestroySwapchain(XrSwapchain swapchain) {
+    XrSwapchain_T* swapchainPtr = demoteFromHandle<XrSwapchain, XrSwapchain_T>(swapchain);
+    XrSession_T* sessionPtr = demoteFromHandle<XrSession, XrSession_T>(swapchainPtr->session);
+    std::unique_lock<std::mutex> lock(sessionPtr->swapchainsMutex);
+    const auto& it = std::find_if(sessionPtr->swapchains.begin(), sessionPtr->swapchains.end(),
+                                  [swapchainPtr](const auto& s) { return swapchainPtr == s.get(); });
+    sessionPtr->swapchains.erase(it);
+    return XR_SUCCESS;
+}
 
-XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrEnumerateSwapchainImages(XrSwapchain /*swapchain*/, uint32_t /*imageCapacityInput*/,
-                                                                     uint32_t* /*imageCountOutput*/,
-                                                                     XrSwapchainImageBaseHeader* /*images*/) {
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrEnumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput,
+                                                                     uint32_t* imageCountOutput,
+                                                                     XrSwapchainImageBaseHeader* images) {
+    XrSwapchain_T* swapchainPtr = demoteFromHandle<XrSwapchain, XrSwapchain_T>(swapchain);
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+    if (imageCapacityInput != 0 && images[0].type != XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    std::vector<XrSwapchainImageVulkanKHR> vulkanImages(swapchainPtr->imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR});
+    for (uint32_t i = 0; i < swapchainPtr->imageCount; i++) {
+        vulkanImages[i].image = swapchainPtr->vulkanImages[i];
+    }
+    return XrElementCapacityWrite(imageCapacityInput, imageCountOutput, reinterpret_cast<XrSwapchainImageVulkanKHR*>(images),
+                                  vulkanImages.data(), vulkanImages.size());
+#else
+    (void)swapchainPtr;
+    (void)imageCapacityInput;
+    (void)imageCountOutput;
+    (void)images;
     return XR_ERROR_FUNCTION_UNSUPPORTED;
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
 }
 
-XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrAcquireSwapchainImage(XrSwapchain /*swapchain*/,
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrAcquireSwapchainImage(XrSwapchain swapchain,
                                                                   const XrSwapchainImageAcquireInfo* /*acquireInfo*/,
-                                                                  uint32_t* /*index*/) {
-    return XR_ERROR_FUNCTION_UNSUPPORTED;
+                                                                  uint32_t* index) {
+    XrSwapchain_T* swapchainPtr = demoteFromHandle<XrSwapchain, XrSwapchain_T>(swapchain);
+    if (swapchainPtr->acquiredCount == swapchainPtr->imageCount ||
+        (swapchainPtr->staticImage && swapchainPtr->acquireCount != 0)) {
+        return XR_ERROR_CALL_ORDER_INVALID;
+    }
+    *index = swapchainPtr->acquireCount % swapchainPtr->imageCount;
+    swapchainPtr->acquireCount++;
+    swapchainPtr->acquiredCount++;
+    return XR_SUCCESS;
 }
 
-XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrWaitSwapchainImage(XrSwapchain /*swapchain*/,
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrWaitSwapchainImage(XrSwapchain swapchain,
                                                                const XrSwapchainImageWaitInfo* /*waitInfo*/) {
-    return XR_ERROR_FUNCTION_UNSUPPORTED;
+    // Nothing reads a released image, so the wait never blocks.
+    XrSwapchain_T* swapchainPtr = demoteFromHandle<XrSwapchain, XrSwapchain_T>(swapchain);
+    if (swapchainPtr->acquiredCount == 0 || swapchainPtr->oldestWaited) {
+        return XR_ERROR_CALL_ORDER_INVALID;
+    }
+    swapchainPtr->oldestWaited = true;
+    return XR_SUCCESS;
 }
 
-XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrReleaseSwapchainImage(XrSwapchain /*swapchain*/,
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrReleaseSwapchainImage(XrSwapchain swapchain,
                                                                   const XrSwapchainImageReleaseInfo* /*releaseInfo*/) {
-    return XR_ERROR_FUNCTION_UNSUPPORTED;
+    XrSwapchain_T* swapchainPtr = demoteFromHandle<XrSwapchain, XrSwapchain_T>(swapchain);
+    if (!swapchainPtr->oldestWaited) {
+        return XR_ERROR_CALL_ORDER_INVALID;
+    }
+    swapchainPtr->acquiredCount--;
+    swapchainPtr->oldestWaited = false;
+    return XR_SUCCESS;
 }
 
 //
@@ -2303,6 +3161,20 @@ XRAPI_ATTR XrResult XRAPI_CALL RuntimeTestXrGetInstanceProcAddr(XrInstance insta
     XR_LIST_FUNCTIONS_XR_VERSION_1_1(FUNCTIONINFO)
 #undef FUNCTIONINFO
 
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+    const std::vector<std::string>& enabledExtensions = demoteFromHandle<XrInstance, XrInstance_T>(instance)->enabledExtensions;
+    if (std::find(enabledExtensions.begin(), enabledExtensions.end(), XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME) !=
+        enabledExtensions.end()) {
+#define FUNCTIONINFO(functionName, _)                                                      \
+    if (strcmp(name, "xr" #functionName) == 0) {                                           \
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXr##functionName);     \
+        return XR_SUCCESS;                                                                 \
+    }
+        XR_LIST_FUNCTIONS_XR_KHR_vulkan_enable2(FUNCTIONINFO)
+#undef FUNCTIONINFO
+    }
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+
     *function = nullptr;
     return XR_ERROR_FUNCTION_UNSUPPORTED;
 }
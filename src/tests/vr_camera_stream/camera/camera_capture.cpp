@@ -1,17 +1,46 @@
 #include "camera_capture.h"
+#include "utils/timer.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 CameraCapture::CameraCapture() 
     : capture_(nullptr), width_(0), height_(0), fps_(0), initialized_(false) {
 }
 
 CameraCapture::~CameraCapture() {
     Shutdown();
+    StopRecording();
 }
 
-bool CameraCapture::Initialize(const std::string& devicePath, int width, int height, int fps) {
+bool CameraCapture::Initialize(const std::string& devicePath, int width, int height, int fps, Backend backend,
+                               Decoder decoder) {
+    devicePath_ = devicePath;
     std::cout << "Initializing camera: " << devicePath << " @ " << width << "x" << height << " " << fps << "fps" << std::endl;
     
+    if (backend == Backend::Replay) {
+        initialized_ = InitializeReplay(devicePath, decoder);
+        return initialized_;
+    }
+    if (backend != Backend::OpenCV && InitializeV4L2(devicePath, width, height, fps, decoder)) {
+        initialized_ = true;
+        return true;
+    }
+    if (backend == Backend::V4L2 || decoder == Decoder::V4L2M2M) {
+        return false;
+    }
+    
     // Create VideoCapture object
     capture_ = std::make_unique<cv::VideoCapture>();
     
@@ -53,15 +82,437 @@ bool CameraCapture::Initialize(const std::string& devicePath, int width, int hei
     return true;
 }
 
-bool CameraCapture::CaptureFrame(cv::Mat& frame) {
-    if (!initialized_ || !capture_) {
+// Current CLOCK_MONOTONIC time, the clock of V4L2 timestamps and of XR_KHR_convert_timespec_time
+static void GetMonotonicTime(timespec* time) {
+#if defined(__linux__)
+    clock_gettime(CLOCK_MONOTONIC, time);
+#else
+    timespec_get(time, TIME_UTC);
+#endif
+}
+
+bool CameraCapture::CaptureFrame(cv::Mat& frame, FrameInfo* info) {
+    if (!initialized_) {
+        return false;
+    }
+    FrameInfo frameInfo;
+    cv::Mat& decoded = colorConversion_ >= 0 ? decodedFrame_ : frame;
+    const bool captured = v4l2Fd_ >= 0       ? CaptureFrameV4L2(decoded, &frameInfo)
+                          : replay_.IsOpen() ? CaptureFrameReplay(decoded, &frameInfo)
+                                             : CaptureFrameOpenCV(decoded, &frameInfo);
+    if (!captured) {
+        return false;
+    }
+    if (colorConversion_ >= 0) {
+        Timer timer;
+        timer.Start();
+        cv::cvtColor(decodedFrame_, frame, colorConversion_);  // Into frame's existing pixels when the size matches
+        frameInfo.convertMilliseconds = timer.GetElapsedMilliseconds();
+    }
+    frameInfo.sequence = ++sequence_;
+    if (info != nullptr) {
+        *info = frameInfo;
+    }
+    return true;
+}
+
+bool CameraCapture::CaptureFrameOpenCV(cv::Mat& frame, FrameInfo* info) {
+    if (!capture_) {
+        return false;
+    }
+    
+    // Same as read(), split to time the wait and the decode apart
+    Timer timer;
+    timer.Start();
+    if (!capture_->grab()) {
+        return false;
+    }
+    const double waitMilliseconds = timer.GetElapsedMilliseconds();
+    // OpenCV does not expose the driver timestamp, so the frame was captured at least this long ago
+    timespec captureTime;
+    GetMonotonicTime(&captureTime);
+    
+    timer.Start();
+    if (!capture_->retrieve(frame)) {
+        return false;
+    }
+    if (info != nullptr) {
+        info->captureTime = captureTime;
+        info->waitMilliseconds = waitMilliseconds;
+        info->decodeMilliseconds = timer.GetElapsedMilliseconds();
+    }
+    return true;
+}
+
+bool CameraCapture::DecodeFrame(const void* jpeg, size_t size, cv::Mat& frame) {
+    // A hardware decoder that fails is not tried again, the rest of the frames are decoded on the CPU
+    if (jpegDecoder_.IsInitialized()) {
+        if (jpegDecoder_.Decode(jpeg, size, frame)) {
+            return true;
+        }
+        std::cerr << "V4L2 M2M: decode failed on " << jpegDecoder_.GetDevicePath() << ", decoding on the CPU"
+                  << std::endl;
+        jpegDecoder_.Shutdown();
+    }
+    const cv::Mat encoded(1, static_cast<int>(size), CV_8UC1, const_cast<void*>(jpeg));
+    cv::imdecode(encoded, cv::IMREAD_COLOR, &frame);
+    return !frame.empty();
+}
+
+bool CameraCapture::StartRecording(const std::string& path) {
+    if (captureThreadRunning_ || !recorder_.Open(path)) {
+        return false;
+    }
+    std::cout << "Recording camera frames to " << path << std::endl;
+    return true;
+}
+
+void CameraCapture::StopRecording() {
+    if (recorder_.IsOpen()) {
+        std::cout << "Recorded " << recorder_.GetFrameCount() << " camera frames" << std::endl;
+        recorder_.Close();
+    }
+}
+
+bool CameraCapture::InitializeReplay(const std::string& path, Decoder decoder) {
+    if (!replay_.Open(path)) {
+        std::cerr << "Failed to open camera recording: " << path << std::endl;
+        return false;
+    }
+    const FrameRecording::Frame& first = replay_.GetFrame(0);
+    width_ = first.width;
+    height_ = first.height;
+    fps_ = static_cast<int>(lround(replay_.GetRate()));
+    replayIndex_ = 0;
+    
+    if (decoder != Decoder::Software && !jpegDecoder_.Initialize(width_, height_)) {
+        if (decoder == Decoder::V4L2M2M) {
+            std::cerr << "V4L2 M2M: no JPEG decoder for " << width_ << "x" << height_ << std::endl;
+            replay_.Close();
+            return false;
+        }
+        std::cout << "V4L2 M2M: no JPEG decoder, decoding on the CPU" << std::endl;
+    }
+    
+    std::cout << "Camera initialized: " << width_ << "x" << height_ << " @ " << fps_ << "fps" << std::endl;
+    std::cout << "Format: MJPG, replaying " << replay_.GetFrameCount() << " recorded frames"
+              << (replayRealtime_ ? "" : " as fast as possible") << std::endl;
+    return true;
+}
+
+bool CameraCapture::CaptureFrameReplay(cv::Mat& frame, FrameInfo* info) {
+    // Each frame is due as long after the first as it was recorded; the next loop starts a frame after the last
+    const FrameRecording::Frame& replayed = replay_.GetFrame(replayIndex_);
+    Timer timer;
+    timer.Start();
+    if (replayRealtime_) {
+        if (replayIndex_ == 0 && replayStart_ == std::chrono::steady_clock::time_point()) {
+            replayStart_ = std::chrono::steady_clock::now();
+        }
+        const int64_t sinceFirst = replayed.captureNanoseconds - replay_.GetFrame(0).captureNanoseconds;
+        std::this_thread::sleep_until(replayStart_ + std::chrono::nanoseconds(sinceFirst));
+    }
+    if (info != nullptr) {
+        info->waitMilliseconds = timer.GetElapsedMilliseconds();
+        GetMonotonicTime(&info->captureTime);
+    }
+    
+    if (++replayIndex_ == replay_.GetFrameCount()) {
+        const int64_t duration = replayed.captureNanoseconds - replay_.GetFrame(0).captureNanoseconds;
+        const int64_t period = fps_ > 0 ? 1000000000 / fps_ : 0;
+        replayStart_ += std::chrono::nanoseconds(duration + period);
+        replayIndex_ = 0;
+    }
+    
+    timer.Start();
+    const bool decoded = DecodeFrame(replayed.jpeg, replayed.size, frame);
+    if (info != nullptr) {
+        info->decodeMilliseconds = timer.GetElapsedMilliseconds();
+    }
+    return decoded;
+}
+
+#if defined(__linux__)
+static int XIoctl(int fd, unsigned long request, void* arg) {
+    int result;
+    do {
+        result = ioctl(fd, request, arg);
+    } while (result == -1 && errno == EINTR);
+    return result;
+}
+
+bool CameraCapture::InitializeV4L2(const std::string& devicePath, int width, int height, int fps, Decoder decoder) {
+    v4l2Fd_ = open(devicePath.c_str(), O_RDWR);
+    if (v4l2Fd_ < 0) {
+        return false;
+    }
+    
+    v4l2_format format{};
+    format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    format.fmt.pix.width = static_cast<__u32>(width);
+    format.fmt.pix.height = static_cast<__u32>(height);
+    format.fmt.pix.pixelformat = V4L2_PIX_FMT_MJPEG;
+    format.fmt.pix.field = V4L2_FIELD_ANY;
+    if (XIoctl(v4l2Fd_, VIDIOC_S_FMT, &format) == -1 || format.fmt.pix.pixelformat != V4L2_PIX_FMT_MJPEG) {
+        std::cerr << "V4L2: MJPEG not available, using OpenCV capture" << std::endl;
+        ShutdownV4L2();
+        return false;
+    }
+    
+    v4l2_streamparm parm{};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = static_cast<__u32>(fps);
+    XIoctl(v4l2Fd_, VIDIOC_S_PARM, &parm);  // Best effort, the driver picks the nearest rate
+    
+    // A few buffers, so the driver can fill one while the newest is decoded
+    v4l2_requestbuffers request{};
+    request.count = 4;
+    request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    request.memory = V4L2_MEMORY_MMAP;
+    if (XIoctl(v4l2Fd_, VIDIOC_REQBUFS, &request) == -1 || request.count < 2) {
+        std::cerr << "V4L2: mmap streaming not supported, using OpenCV capture" << std::endl;
+        ShutdownV4L2();
+        return false;
+    }
+    
+    for (__u32 index = 0; index < request.count; index++) {
+        v4l2_buffer buffer{};
+        buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buffer.memory = V4L2_MEMORY_MMAP;
+        buffer.index = index;
+        if (XIoctl(v4l2Fd_, VIDIOC_QUERYBUF, &buffer) == -1) {
+            ShutdownV4L2();
+            return false;
+        }
+        void* start = mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, v4l2Fd_, buffer.m.offset);
+        if (start == MAP_FAILED) {
+            ShutdownV4L2();
+            return false;
+        }
+        v4l2Buffers_.push_back({start, buffer.length});
+        if (XIoctl(v4l2Fd_, VIDIOC_QBUF, &buffer) == -1) {
+            ShutdownV4L2();
+            return false;
+        }
+    }
+    
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (XIoctl(v4l2Fd_, VIDIOC_STREAMON, &type) == -1) {
+        std::cerr << "V4L2: VIDIOC_STREAMON failed: " << strerror(errno) << std::endl;
+        ShutdownV4L2();
+        return false;
+    }
+    
+    width_ = static_cast<int>(format.fmt.pix.width);
+    height_ = static_cast<int>(format.fmt.pix.height);
+    fps_ = parm.parm.capture.timeperframe.numerator != 0
+               ? static_cast<int>(parm.parm.capture.timeperframe.denominator / parm.parm.capture.timeperframe.numerator)
+               : fps;
+    
+    if (decoder != Decoder::Software && !jpegDecoder_.Initialize(width_, height_, "", devicePath)) {
+        if (decoder == Decoder::V4L2M2M) {
+            std::cerr << "V4L2 M2M: no JPEG decoder for " << width_ << "x" << height_ << std::endl;
+            ShutdownV4L2();
+            return false;
+        }
+        std::cout << "V4L2 M2M: no JPEG decoder, decoding on the CPU" << std::endl;
+    }
+    
+    std::cout << "Camera initialized: " << width_ << "x" << height_ << " @ " << fps_ << "fps" << std::endl;
+    std::cout << "Format: MJPG, V4L2 mmap buffers: " << v4l2Buffers_.size() << std::endl;
+    return true;
+}
+
+bool CameraCapture::CaptureFrameV4L2(cv::Mat& frame, FrameInfo* info) {
+    v4l2_buffer buffer{};
+    buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    Timer timer;
+    timer.Start();
+    if (XIoctl(v4l2Fd_, VIDIOC_DQBUF, &buffer) == -1) {
         return false;
     }
     
-    return capture_->read(frame);
+    // The driver stamps the buffer when it starts receiving the frame; older drivers may use another clock, so fall
+    // back to the dequeue time
+    const double waitMilliseconds = timer.GetElapsedMilliseconds();
+    timespec captureTime;
+    if ((buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+        captureTime.tv_sec = buffer.timestamp.tv_sec;
+        captureTime.tv_nsec = buffer.timestamp.tv_usec * 1000;
+    } else {
+        GetMonotonicTime(&captureTime);
+    }
+    if (info != nullptr) {
+        info->waitMilliseconds = waitMilliseconds;
+        info->captureTime = captureTime;
+    }
+    
+    const void* start = v4l2Buffers_[buffer.index].start;
+    if (recorder_.IsOpen()) {
+        recorder_.Write(start, buffer.bytesused, width_, height_, captureTime);
+    }
+    
+    // Decode from the driver's buffer
+    timer.Start();
+    const bool decoded = DecodeFrame(start, buffer.bytesused, frame);
+    if (info != nullptr) {
+        info->decodeMilliseconds = timer.GetElapsedMilliseconds();
+    }
+    
+    if (XIoctl(v4l2Fd_, VIDIOC_QBUF, &buffer) == -1) {
+        return false;
+    }
+    return decoded;
+}
+
+void CameraCapture::ShutdownV4L2() {
+    if (v4l2Fd_ < 0) {
+        return;
+    }
+    jpegDecoder_.Shutdown();
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    XIoctl(v4l2Fd_, VIDIOC_STREAMOFF, &type);
+    for (const MappedBuffer& buffer : v4l2Buffers_) {
+        munmap(buffer.start, buffer.length);
+    }
+    v4l2Buffers_.clear();
+    close(v4l2Fd_);
+    v4l2Fd_ = -1;
+}
+
+std::vector<CameraCapture::Mode> CameraCapture::EnumerateModes(const std::string& devicePath) {
+    std::vector<Mode> modes;
+    const int fd = open(devicePath.c_str(), O_RDWR);
+    if (fd < 0) {
+        return modes;
+    }
+    
+    v4l2_frmsizeenum size{};
+    size.pixel_format = V4L2_PIX_FMT_MJPEG;
+    for (size.index = 0; XIoctl(fd, VIDIOC_ENUM_FRAMESIZES, &size) == 0 && size.type == V4L2_FRMSIZE_TYPE_DISCRETE;
+         size.index++) {
+        v4l2_frmivalenum interval{};
+        interval.pixel_format = V4L2_PIX_FMT_MJPEG;
+        interval.width = size.discrete.width;
+        interval.height = size.discrete.height;
+        for (interval.index = 0; XIoctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &interval) == 0 &&
+                                 interval.type == V4L2_FRMIVAL_TYPE_DISCRETE;
+             interval.index++) {
+            if (interval.discrete.numerator != 0) {
+                modes.push_back({static_cast<int>(size.discrete.width), static_cast<int>(size.discrete.height),
+                                 static_cast<int>(lround(static_cast<double>(interval.discrete.denominator) /
+                                                         interval.discrete.numerator))});
+            }
+        }
+    }
+    close(fd);
+    
+    std::sort(modes.begin(), modes.end(), [](const Mode& a, const Mode& b) {
+        if (a.width * a.height != b.width * b.height) {
+            return a.width * a.height > b.width * b.height;
+        }
+        return a.fps > b.fps;
+    });
+    return modes;
+}
+#else
+std::vector<CameraCapture::Mode> CameraCapture::EnumerateModes(const std::string&) { return {}; }
+bool CameraCapture::InitializeV4L2(const std::string&, int, int, int, Decoder) { return false; }
+bool CameraCapture::CaptureFrameV4L2(cv::Mat&, FrameInfo*) { return false; }
+void CameraCapture::ShutdownV4L2() {}
+#endif
+
+bool CameraCapture::SelectMode(const std::vector<Mode>& modes, int maxWidth, int maxHeight, double displayRate,
+                               Mode& mode) {
+    // modes is largest first, so the first mode that fits has the size; then pick its rate
+    const Mode* selected = nullptr;
+    for (const Mode& candidate : modes) {
+        if (candidate.width > maxWidth || candidate.height > maxHeight || candidate.fps <= 0) {
+            continue;
+        }
+        if (selected != nullptr && (candidate.width != selected->width || candidate.height != selected->height)) {
+            break;
+        }
+        // Within 1%, as 90 Hz displays often run at 89.9 Hz and cameras at 29.97 Hz
+        const double framesPerCameraFrame = displayRate / candidate.fps;
+        const bool divides = displayRate > 0 && framesPerCameraFrame >= 0.99 &&
+                             std::fabs(framesPerCameraFrame - std::round(framesPerCameraFrame)) < 0.01 * framesPerCameraFrame;
+        if (divides) {
+            selected = &candidate;  // The fastest dividing rate, as modes is fastest first within a size
+            break;
+        }
+        if (selected == nullptr) {
+            selected = &candidate;  // The fastest rate, unless a dividing one follows
+        }
+    }
+    if (selected == nullptr) {
+        return false;
+    }
+    mode = *selected;
+    return true;
+}
+
+bool CameraCapture::StartCaptureThread() {
+    if (!initialized_ || captureThreadRunning_) {
+        return false;
+    }
+    
+    writeSlot_ = 0;
+    readSlot_ = 1;
+    latestSlot_ = 2;
+    captureThreadRunning_ = true;
+    captureThread_ = std::thread(&CameraCapture::CaptureThread, this);
+    return true;
+}
+
+void CameraCapture::StopCaptureThread() {
+    captureThreadRunning_ = false;
+    if (captureThread_.joinable()) {
+        captureThread_.join();
+    }
+}
+
+void CameraCapture::CaptureThread() {
+    threadPolicy_.Apply("capture " + devicePath_);
+    
+    int failedReads = 0;
+    while (captureThreadRunning_) {
+        // Blocks on V4L2 and the MJPEG decode, off the render thread
+        if (!CaptureFrame(slots_[writeSlot_], &slotInfos_[writeSlot_])) {
+            if (failedReads++ % 60 == 0) { // Log every 60 failures to avoid spam
+                std::cerr << "Failed to capture camera frame" << std::endl;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        failedReads = 0;
+        
+        // Publish the completed frame and take back whichever slot was published before
+        writeSlot_ = latestSlot_.exchange(writeSlot_ | kNewFrameBit, std::memory_order_acq_rel) & ~kNewFrameBit;
+    }
+}
+
+bool CameraCapture::AcquireLatestFrame(cv::Mat& frame, FrameInfo* info) {
+    if ((latestSlot_.load(std::memory_order_relaxed) & kNewFrameBit) == 0) {
+        return false;
+    }
+    
+    readSlot_ = latestSlot_.exchange(readSlot_, std::memory_order_acq_rel) & ~kNewFrameBit;
+    frame = slots_[readSlot_];
+    if (info != nullptr) {
+        *info = slotInfos_[readSlot_];
+    }
+    return true;
 }
 
 void CameraCapture::Shutdown() {
+    StopCaptureThread();
+    ShutdownV4L2();
+    replay_.Close();
+    jpegDecoder_.Shutdown();
+    replayStart_ = {};
     if (capture_) {
         capture_->release();
         capture_.reset();
@@ -1,30 +1,155 @@
 #pragma once
 
+#include "frame_recording.h"
+#include "utils/thread_policy.h"
+#include "v4l2_jpeg_decoder.h"
 #include <opencv2/opencv.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
+#include <thread>
+#include <ctime>
+#include <vector>
 
 class CameraCapture {
 public:
+    // When and how fast a frame was captured
+    struct FrameInfo {
+        timespec captureTime{};          // CLOCK_MONOTONIC time the frame was captured
+        double waitMilliseconds = 0;     // Time waiting for the driver to deliver the frame
+        double decodeMilliseconds = 0;   // Time decoding it
+        double convertMilliseconds = 0;  // Time converting it with SetColorConversion, 0 without
+        uint64_t sequence = 0;           // Counts the frames this CameraCapture captured, from 1; gaps are dropped frames
+    };
+    
+    // A capture mode: the size of the whole side-by-side frame and its rate
+    struct Mode {
+        int width = 0;
+        int height = 0;
+        int fps = 0;
+    };
+    
+    // How frames are captured: native V4L2 mmap streaming of MJPEG, or cv::VideoCapture; or replayed from a
+    // recording made with StartRecording, whose path is then the device path
+    enum class Backend { Any, V4L2, OpenCV, Replay };
+    
+    // How the V4L2 backend decodes MJPEG: on a V4L2 mem2mem hardware decoder, or on the CPU.  cv::VideoCapture
+    // always decodes on the CPU.
+    enum class Decoder { Any, Software, V4L2M2M };
+    
     CameraCapture();
     ~CameraCapture();
     
-    // Initialize camera with device path
+    // The discrete MJPEG modes of the device, largest first and fastest first within a size.
+    // Empty without V4L2 or when the device only reports stepwise sizes.
+    static std::vector<Mode> EnumerateModes(const std::string& devicePath);
+    
+    // Pick the mode for a display running at displayRate Hz, or 0 if unknown: the largest one no bigger than
+    // maxWidth x maxHeight, at the highest rate that divides the display rate, so every camera frame is shown for the
+    // same number of display frames, or else at the highest rate.  Returns false if no mode fits.
+    static bool SelectMode(const std::vector<Mode>& modes, int maxWidth, int maxHeight, double displayRate, Mode& mode);
+    
+    // Initialize camera with device path.  Backend::Any tries V4L2 first and falls back to OpenCV; Decoder::Any
+    // decodes on the first mem2mem JPEG decoder found and falls back to the CPU, also if the decoder fails later.
+    // Backend::Replay takes the size and rate of the recording, and loops it.
     bool Initialize(const std::string& devicePath = "/dev/video0", 
-                   int width = 1280, int height = 480, int fps = 60);
+                   int width = 1280, int height = 480, int fps = 60, Backend backend = Backend::Any,
+                   Decoder decoder = Decoder::Any);
+    
+    // Capture a frame (returns OpenCV Mat), blocking until the camera delivers it.
+    // info, if given, receives the capture time, stage durations and sequence number of the frame.
+    // Do not call while the capture thread is running.
+    bool CaptureFrame(cv::Mat& frame, FrameInfo* info = nullptr);
+    
+    // Capture and decode frames on a separate thread into a triple buffer, so the caller never waits for the camera
+    bool StartCaptureThread();
+    void StopCaptureThread();
+    
+    // How the capture thread, which also decodes, is scheduled from the next StartCaptureThread on
+    void SetThreadPolicy(const ThreadPolicy& policy) { threadPolicy_ = policy; }
+    
+    // Replay at the recorded cadence, the default, or each frame as soon as it is asked for, to measure how fast the
+    // rest of the pipeline can go.  Replayed frames get the time they are delivered as their capture time.
+    void SetReplayRealtime(bool realtime) { replayRealtime_ = realtime; }
     
-    // Capture a frame (returns OpenCV Mat)
-    bool CaptureFrame(cv::Mat& frame);
+    // Convert each frame with cv::cvtColor and code, e.g. cv::COLOR_BGR2BGRA, right after decoding it, so a capture
+    // thread hands out frames ready to stage; -1, the default, keeps the decoded BGR.
+    // Do not call while the capture thread is running.
+    void SetColorConversion(int code) { colorConversion_ = code; }
+    
+    // Append each frame the V4L2 backend captures from now on, undecoded, with its capture time, to the file at path.
+    // Recording goes on across Shutdown and Initialize, e.g. camera mode changes, until StopRecording.
+    // Do not call while the capture thread is running.
+    bool StartRecording(const std::string& path);
+    void StopRecording();
+    
+    // Get the newest frame completed by the capture thread, without blocking.
+    // Returns false if no frame was completed since the last call. The frame stays valid until the next call.
+    bool AcquireLatestFrame(cv::Mat& frame, FrameInfo* info = nullptr);
     
     // Get camera properties
     int GetWidth() const { return width_; }
     int GetHeight() const { return height_; }
     int GetFPS() const { return fps_; }
+    const std::string& GetDevicePath() const { return devicePath_; }
+    Backend GetBackend() const {
+        return replay_.IsOpen() ? Backend::Replay : v4l2Fd_ >= 0 ? Backend::V4L2 : Backend::OpenCV;
+    }
+    Decoder GetDecoder() const { return jpegDecoder_.IsInitialized() ? Decoder::V4L2M2M : Decoder::Software; }
     
     void Shutdown();
     
 private:
+    void CaptureThread();
+    bool CaptureFrameOpenCV(cv::Mat& frame, FrameInfo* info);
+    
+    // Native V4L2 capture into mmap'd driver buffers, decoded straight from the buffer the driver filled.
+    // Initialize falls back to cv::VideoCapture when the device cannot stream MJPEG this way.
+    bool InitializeV4L2(const std::string& devicePath, int width, int height, int fps, Decoder decoder);
+    bool CaptureFrameV4L2(cv::Mat& frame, FrameInfo* info);
+    void ShutdownV4L2();
+    
+    bool InitializeReplay(const std::string& path, Decoder decoder);
+    bool CaptureFrameReplay(cv::Mat& frame, FrameInfo* info);
+    
+    // Decode an MJPEG frame of the V4L2 or replay backend, into frame's existing pixels when the size matches
+    bool DecodeFrame(const void* jpeg, size_t size, cv::Mat& frame);
+    
     std::unique_ptr<cv::VideoCapture> capture_;
     int width_, height_, fps_;
+    std::string devicePath_;
     bool initialized_;
+    int colorConversion_ = -1;
+    cv::Mat decodedFrame_;  // The frame before its color conversion
+    uint64_t sequence_ = 0;  // Of the last frame captured, across Initialize calls
+    
+    struct MappedBuffer {
+        void* start;
+        size_t length;
+    };
+    int v4l2Fd_ = -1;
+    std::vector<MappedBuffer> v4l2Buffers_;
+    V4L2JpegDecoder jpegDecoder_;  // Decodes the V4L2 and replay frames unless it is not initialized
+    
+    FrameRecorder recorder_;
+    FrameRecording replay_;
+    bool replayRealtime_ = true;
+    size_t replayIndex_ = 0;  // The next frame to replay
+    std::chrono::steady_clock::time_point replayStart_;  // When the recording's first frame is due in this loop
+    
+    // Triple buffer: the capture thread writes slots_[writeSlot_], the caller reads slots_[readSlot_], and latestSlot_
+    // holds the index of the third slot, with kNewFrameBit set when it holds a frame the caller has not seen yet.
+    // Each side swaps its slot with latestSlot_, so neither ever waits for the other.
+    static constexpr unsigned kNewFrameBit = 4;
+    std::array<cv::Mat, 3> slots_;
+    std::array<FrameInfo, 3> slotInfos_;  // Capture time and durations of the frame in each slot
+    unsigned writeSlot_ = 0;
+    unsigned readSlot_ = 1;
+    std::atomic<unsigned> latestSlot_{2};
+    
+    std::thread captureThread_;
+    ThreadPolicy threadPolicy_;
+    std::atomic<bool> captureThreadRunning_{false};
 };
\ No newline at end of file
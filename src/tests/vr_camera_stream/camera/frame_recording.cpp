@@ -0,0 +1,148 @@
+#include "frame_recording.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using frame_recording::FileHeader;
+using frame_recording::FrameHeader;
+
+static const char kMagic[8] = {'V', 'R', 'C', 'A', 'M', 'R', 'E', 'C'};
+static const uint32_t kVersion = 1;
+
+static size_t PaddedSize(size_t size) { return (size + 7) & ~static_cast<size_t>(7); }
+
+FrameRecorder::~FrameRecorder() {
+    Close();
+}
+
+bool FrameRecorder::Open(const std::string& path) {
+    Close();
+    file_ = fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        std::cerr << "Recording: cannot create " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    FileHeader header{};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    if (fwrite(&header, sizeof(header), 1, file_) != 1) {
+        Close();
+        return false;
+    }
+    frameCount_ = 0;
+    return true;
+}
+
+bool FrameRecorder::Write(const void* jpeg, size_t size, int width, int height, const timespec& captureTime) {
+    if (file_ == nullptr) {
+        return false;
+    }
+    FrameHeader header{};
+    header.captureNanoseconds = static_cast<int64_t>(captureTime.tv_sec) * 1000000000 + captureTime.tv_nsec;
+    header.size = static_cast<uint32_t>(size);
+    header.width = static_cast<uint16_t>(width);
+    header.height = static_cast<uint16_t>(height);
+    static const uint8_t padding[8] = {};
+    if (fwrite(&header, sizeof(header), 1, file_) != 1 || fwrite(jpeg, 1, size, file_) != size ||
+        fwrite(padding, 1, PaddedSize(size) - size, file_) != PaddedSize(size) - size) {
+        std::cerr << "Recording: write failed after " << frameCount_ << " frames, stopping" << std::endl;
+        Close();
+        return false;
+    }
+    frameCount_++;
+    return true;
+}
+
+void FrameRecorder::Close() {
+    if (file_ != nullptr) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+FrameRecording::~FrameRecording() {
+    Close();
+}
+
+#if defined(__linux__)
+bool FrameRecording::Open(const std::string& path) {
+    Close();
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) == -1 || static_cast<size_t>(status.st_size) < sizeof(FileHeader)) {
+        close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping keeps the file
+    if (data_ == MAP_FAILED) {
+        data_ = nullptr;
+        return false;
+    }
+    madvise(data_, size_, MADV_SEQUENTIAL);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data_);
+    FileHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+        std::cerr << "Recording: " << path << " is not a camera recording" << std::endl;
+        Close();
+        return false;
+    }
+
+    // Frames start 8-byte aligned, so their headers can be read in place
+    size_t offset = sizeof(FileHeader);
+    while (offset + sizeof(FrameHeader) <= size_) {
+        const FrameHeader* frameHeader = reinterpret_cast<const FrameHeader*>(bytes + offset);
+        offset += sizeof(FrameHeader);
+        if (frameHeader->size > size_ - offset) {
+            break;
+        }
+        Frame frame;
+        frame.jpeg = bytes + offset;
+        frame.size = frameHeader->size;
+        frame.width = frameHeader->width;
+        frame.height = frameHeader->height;
+        frame.captureNanoseconds = frameHeader->captureNanoseconds;
+        frames_.push_back(frame);
+        offset += PaddedSize(frameHeader->size);
+    }
+    if (frames_.empty()) {
+        std::cerr << "Recording: " << path << " holds no frames" << std::endl;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void FrameRecording::Close() {
+    frames_.clear();
+    if (data_ != nullptr) {
+        munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+#else
+bool FrameRecording::Open(const std::string&) { return false; }
+void FrameRecording::Close() { frames_.clear(); }
+#endif
+
+double FrameRecording::GetRate() const {
+    if (frames_.size() < 2) {
+        return 0;
+    }
+    const int64_t duration = frames_.back().captureNanoseconds - frames_.front().captureNanoseconds;
+    return duration > 0 ? (frames_.size() - 1) * 1e9 / static_cast<double>(duration) : 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// A camera recording: the MJPEG frames the camera delivered, as it delivered them, each with its capture time and
+// size, in one file.  FrameRecorder appends to it while capturing, and FrameRecording maps it into memory for a
+// replay, which decodes the frames straight from the mapping like from the driver's buffers.
+//
+// The file is a 16-byte header, "VRCAMREC" and a version, then for each frame a FrameHeader followed by its JPEG,
+// padded to 8 bytes.  Native byte order, as recordings are replayed on the machine that made them or its like.
+namespace frame_recording {
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+struct FrameHeader {
+    int64_t captureNanoseconds;  // CLOCK_MONOTONIC of the recording machine
+    uint32_t size;               // Of the JPEG that follows
+    uint16_t width;
+    uint16_t height;
+};
+}  // namespace frame_recording
+
+class FrameRecorder {
+public:
+    FrameRecorder() = default;
+    ~FrameRecorder();
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    // Create or truncate the file at path
+    bool Open(const std::string& path);
+
+    // Append one frame.  Buffered, so a frame is only certain to be in the file after Close.
+    bool Write(const void* jpeg, size_t size, int width, int height, const timespec& captureTime);
+
+    bool IsOpen() const { return file_ != nullptr; }
+    size_t GetFrameCount() const { return frameCount_; }
+
+    void Close();
+
+private:
+    FILE* file_ = nullptr;
+    size_t frameCount_ = 0;
+};
+
+class FrameRecording {
+public:
+    struct Frame {
+        const void* jpeg = nullptr;  // Into the mapping, valid until Close
+        size_t size = 0;
+        int width = 0;
+        int height = 0;
+        int64_t captureNanoseconds = 0;
+    };
+
+    FrameRecording() = default;
+    ~FrameRecording();
+    FrameRecording(const FrameRecording&) = delete;
+    FrameRecording& operator=(const FrameRecording&) = delete;
+
+    // Map the recording at path and index its frames.  A frame cut off at the end, as by a recorder that did not
+    // close, is left out.  False if the file is not a recording or holds no frame.
+    bool Open(const std::string& path);
+
+    bool IsOpen() const { return !frames_.empty(); }
+    size_t GetFrameCount() const { return frames_.size(); }
+    const Frame& GetFrame(size_t index) const { return frames_[index]; }
+
+    // The recorded rate, from the first and last capture times; 0 with a single frame
+    double GetRate() const;
+
+    void Close();
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<Frame> frames_;
+};
@@ -0,0 +1,74 @@
+#include "stereo_calibration.h"
+#include <iostream>
+
+bool StereoCalibration::Load(const std::string& path) {
+    cv::FileStorage file;
+    try {
+        if (!file.open(path, cv::FileStorage::READ)) {
+            std::cerr << "Calibration: cannot open " << path << std::endl;
+            return false;
+        }
+    } catch (const cv::Exception& e) {
+        std::cerr << "Calibration: cannot parse " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    
+    int width = 0;
+    int height = 0;
+    file["image_width"] >> width;
+    file["image_height"] >> height;
+    imageSize_ = cv::Size(width, height);
+    for (int eye = 0; eye < 2; eye++) {
+        const std::string n = std::to_string(eye + 1);
+        file["K" + n] >> cameraMatrices_[eye];
+        if (cameraMatrices_[eye].empty()) {
+            file["M" + n] >> cameraMatrices_[eye];
+        }
+        file["D" + n] >> distortions_[eye];
+        file["R" + n] >> rectifications_[eye];
+        file["P" + n] >> projections_[eye];
+        if (cameraMatrices_[eye].size() != cv::Size(3, 3)) {
+            std::cerr << "Calibration: " << path << " has no 3x3 K" << n << std::endl;
+            return false;
+        }
+        if (projections_[eye].empty()) {
+            projections_[eye] = cameraMatrices_[eye];
+        }
+    }
+    if (width <= 0 || height <= 0) {
+        std::cerr << "Calibration: " << path << " has no image_width and image_height" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+cv::Mat StereoCalibration::ComputeRemapOffsets(int eye, int width, int height) const {
+    // The camera modes keep the aspect ratio, so scale the focal lengths and principal points with the eye size
+    const double scaleX = static_cast<double>(width) / imageSize_.width;
+    const double scaleY = static_cast<double>(height) / imageSize_.height;
+    cv::Mat cameraMatrix;
+    cv::Mat projection;
+    cameraMatrices_[eye].convertTo(cameraMatrix, CV_64F);
+    projections_[eye].convertTo(projection, CV_64F);
+    for (int column = 0; column < projection.cols; column++) {
+        if (column < cameraMatrix.cols) {
+            cameraMatrix.at<double>(0, column) *= scaleX;
+            cameraMatrix.at<double>(1, column) *= scaleY;
+        }
+        projection.at<double>(0, column) *= scaleX;
+        projection.at<double>(1, column) *= scaleY;
+    }
+    
+    cv::Mat map;
+    cv::initUndistortRectifyMap(cameraMatrix, distortions_[eye], rectifications_[eye], projection, cv::Size(width, height),
+                                CV_32FC2, map, cv::noArray());
+    for (int y = 0; y < height; y++) {
+        cv::Vec2f* row = map.ptr<cv::Vec2f>(y);
+        for (int x = 0; x < width; x++) {
+            row[x] = cv::Vec2f((row[x][0] - x) / width, (row[x][1] - y) / height);
+        }
+    }
+    cv::Mat offsets;
+    map.convertTo(offsets, CV_16F);
+    return offsets;
+}
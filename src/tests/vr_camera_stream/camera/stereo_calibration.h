@@ -0,0 +1,31 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <string>
+
+// The intrinsics, distortion and rectification of the two cameras of the side-by-side frame, in the OpenCV file
+// storage format cv::stereoCalibrate and cv::stereoRectify results are usually saved in, e.g.:
+//
+//     image_width: 1600   image_height: 1200      the size of one eye the cameras were calibrated at
+//     K1, D1, K2, D2                              camera matrices and distortion coefficients (M1 and M2 also work)
+//     R1, P1, R2, P2                              rectification rotations and new projection matrices, optional
+//
+// Without R1, P1, R2 and P2 each eye is only undistorted, keeping its camera matrix.
+class StereoCalibration {
+public:
+    bool Load(const std::string& path);
+    
+    // For each pixel of a rectified width x height eye, the offset from its texture coordinates to those of the
+    // camera pixel it shows, as cv::initUndistortRectifyMap computes, scaled from the calibrated size.  The offsets
+    // are small, so they keep their precision as half floats, where the coordinates themselves would lose a pixel at
+    // the far side of the eye.  CV_16FC2.
+    cv::Mat ComputeRemapOffsets(int eye, int width, int height) const;
+    
+private:
+    cv::Size imageSize_;
+    std::array<cv::Mat, 2> cameraMatrices_;
+    std::array<cv::Mat, 2> distortions_;
+    std::array<cv::Mat, 2> rectifications_;
+    std::array<cv::Mat, 2> projections_;
+};
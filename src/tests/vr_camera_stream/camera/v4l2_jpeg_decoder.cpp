@@ -0,0 +1,295 @@
+#include "v4l2_jpeg_decoder.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+V4L2JpegDecoder::~V4L2JpegDecoder() {
+    Shutdown();
+}
+
+#if defined(__linux__)
+static int XIoctl(int fd, unsigned long request, void* arg) {
+    int result;
+    do {
+        result = ioctl(fd, request, arg);
+    } while (result == -1 && errno == EINTR);
+    return result;
+}
+
+static bool HasFormat(int fd, uint32_t type, uint32_t pixelFormat) {
+    v4l2_fmtdesc description{};
+    description.type = type;
+    for (description.index = 0; XIoctl(fd, VIDIOC_ENUM_FMT, &description) == 0; description.index++) {
+        if (description.pixelformat == pixelFormat) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool V4L2JpegDecoder::Initialize(int width, int height, const std::string& devicePath,
+                                 const std::string& skipDevicePath) {
+    Shutdown();
+    if (!devicePath.empty()) {
+        return Open(devicePath, width, height);
+    }
+    for (int index = 0; index < 64; index++) {
+        const std::string candidate = "/dev/video" + std::to_string(index);
+        if (candidate != skipDevicePath && Open(candidate, width, height)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool V4L2JpegDecoder::Open(const std::string& devicePath, int width, int height) {
+    fd_ = open(devicePath.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd_ < 0) {
+        return false;
+    }
+
+    v4l2_capability capability{};
+    if (XIoctl(fd_, VIDIOC_QUERYCAP, &capability) == -1) {
+        Shutdown();
+        return false;
+    }
+    const uint32_t caps =
+        (capability.capabilities & V4L2_CAP_DEVICE_CAPS) != 0 ? capability.device_caps : capability.capabilities;
+    if ((caps & V4L2_CAP_STREAMING) == 0 || (caps & (V4L2_CAP_VIDEO_M2M_MPLANE | V4L2_CAP_VIDEO_M2M)) == 0) {
+        Shutdown();
+        return false;
+    }
+    multiplanar_ = (caps & V4L2_CAP_VIDEO_M2M_MPLANE) != 0;
+    outputType_ = multiplanar_ ? V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE : V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    captureType_ = multiplanar_ ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE : V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    // Camera MJPEG usually leaves out the Huffman tables, which decoders that take V4L2_PIX_FMT_MJPEG fill in
+    const uint32_t jpegFormat = HasFormat(fd_, outputType_, V4L2_PIX_FMT_MJPEG)  ? V4L2_PIX_FMT_MJPEG
+                                : HasFormat(fd_, outputType_, V4L2_PIX_FMT_JPEG) ? V4L2_PIX_FMT_JPEG
+                                                                                 : 0;
+    // BGR24 is the frame format, so needs no conversion; NV12 is what most decoders write
+    captureFormat_ = HasFormat(fd_, captureType_, V4L2_PIX_FMT_BGR24)  ? V4L2_PIX_FMT_BGR24
+                     : HasFormat(fd_, captureType_, V4L2_PIX_FMT_NV12) ? V4L2_PIX_FMT_NV12
+                                                                       : 0;
+    if (jpegFormat == 0 || captureFormat_ == 0) {
+        Shutdown();
+        return false;
+    }
+
+    // A compressed frame is far smaller than its pixels
+    v4l2_format output{};
+    output.type = outputType_;
+    const uint32_t outputSize = static_cast<uint32_t>(width) * static_cast<uint32_t>(height);
+    if (multiplanar_) {
+        output.fmt.pix_mp.width = static_cast<__u32>(width);
+        output.fmt.pix_mp.height = static_cast<__u32>(height);
+        output.fmt.pix_mp.pixelformat = jpegFormat;
+        output.fmt.pix_mp.field = V4L2_FIELD_NONE;
+        output.fmt.pix_mp.num_planes = 1;
+        output.fmt.pix_mp.plane_fmt[0].sizeimage = outputSize;
+    } else {
+        output.fmt.pix.width = static_cast<__u32>(width);
+        output.fmt.pix.height = static_cast<__u32>(height);
+        output.fmt.pix.pixelformat = jpegFormat;
+        output.fmt.pix.field = V4L2_FIELD_NONE;
+        output.fmt.pix.sizeimage = outputSize;
+    }
+    if (XIoctl(fd_, VIDIOC_S_FMT, &output) == -1) {
+        Shutdown();
+        return false;
+    }
+
+    v4l2_format capture{};
+    capture.type = captureType_;
+    if (multiplanar_) {
+        capture.fmt.pix_mp.width = static_cast<__u32>(width);
+        capture.fmt.pix_mp.height = static_cast<__u32>(height);
+        capture.fmt.pix_mp.pixelformat = captureFormat_;
+        capture.fmt.pix_mp.field = V4L2_FIELD_NONE;
+        capture.fmt.pix_mp.num_planes = 1;
+    } else {
+        capture.fmt.pix.width = static_cast<__u32>(width);
+        capture.fmt.pix.height = static_cast<__u32>(height);
+        capture.fmt.pix.pixelformat = captureFormat_;
+        capture.fmt.pix.field = V4L2_FIELD_NONE;
+    }
+    if (XIoctl(fd_, VIDIOC_S_FMT, &capture) == -1) {
+        Shutdown();
+        return false;
+    }
+    // Both NV12 planes in one buffer, as the frame is converted from one mapping
+    const bool captureFits =
+        multiplanar_ ? capture.fmt.pix_mp.pixelformat == captureFormat_ && capture.fmt.pix_mp.num_planes == 1 &&
+                           capture.fmt.pix_mp.width >= static_cast<__u32>(width) &&
+                           capture.fmt.pix_mp.height >= static_cast<__u32>(height)
+                     : capture.fmt.pix.pixelformat == captureFormat_ && capture.fmt.pix.width >= static_cast<__u32>(width) &&
+                           capture.fmt.pix.height >= static_cast<__u32>(height);
+    if (!captureFits) {
+        Shutdown();
+        return false;
+    }
+    bytesPerLine_ = multiplanar_ ? capture.fmt.pix_mp.plane_fmt[0].bytesperline : capture.fmt.pix.bytesperline;
+    captureHeight_ = multiplanar_ ? capture.fmt.pix_mp.height : capture.fmt.pix.height;
+
+    if (!MapBuffer(outputType_, output_) || !MapBuffer(captureType_, capture_)) {
+        Shutdown();
+        return false;
+    }
+    v4l2_buf_type type = static_cast<v4l2_buf_type>(outputType_);
+    v4l2_buf_type captureStreamType = static_cast<v4l2_buf_type>(captureType_);
+    if (XIoctl(fd_, VIDIOC_STREAMON, &type) == -1 || XIoctl(fd_, VIDIOC_STREAMON, &captureStreamType) == -1) {
+        std::cerr << "V4L2 M2M: VIDIOC_STREAMON failed on " << devicePath << ": " << strerror(errno) << std::endl;
+        Shutdown();
+        return false;
+    }
+
+    devicePath_ = devicePath;
+    width_ = width;
+    height_ = height;
+    std::cout << "JPEG decoder: " << reinterpret_cast<const char*>(capability.card) << " (" << devicePath << "), "
+              << (captureFormat_ == V4L2_PIX_FMT_NV12 ? "NV12" : "BGR24") << " output" << std::endl;
+    return true;
+}
+
+// One mmap'd buffer per queue, as frames are decoded one at a time
+bool V4L2JpegDecoder::MapBuffer(uint32_t type, MappedBuffer& mapped) {
+    v4l2_requestbuffers request{};
+    request.count = 1;
+    request.type = type;
+    request.memory = V4L2_MEMORY_MMAP;
+    if (XIoctl(fd_, VIDIOC_REQBUFS, &request) == -1 || request.count < 1) {
+        return false;
+    }
+
+    v4l2_plane planes[VIDEO_MAX_PLANES]{};
+    v4l2_buffer buffer{};
+    buffer.type = type;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    buffer.index = 0;
+    if (multiplanar_) {
+        buffer.m.planes = planes;
+        buffer.length = VIDEO_MAX_PLANES;
+    }
+    if (XIoctl(fd_, VIDIOC_QUERYBUF, &buffer) == -1) {
+        return false;
+    }
+    const size_t length = multiplanar_ ? planes[0].length : buffer.length;
+    const off_t offset = multiplanar_ ? planes[0].m.mem_offset : buffer.m.offset;
+    void* start = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, offset);
+    if (start == MAP_FAILED) {
+        return false;
+    }
+    mapped.start = start;
+    mapped.length = length;
+    return true;
+}
+
+bool V4L2JpegDecoder::QueueBuffer(uint32_t type, size_t bytesUsed) {
+    v4l2_plane plane{};
+    v4l2_buffer buffer{};
+    buffer.type = type;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    buffer.index = 0;
+    if (multiplanar_) {
+        plane.bytesused = static_cast<__u32>(bytesUsed);
+        buffer.m.planes = &plane;
+        buffer.length = 1;
+    } else {
+        buffer.bytesused = static_cast<__u32>(bytesUsed);
+    }
+    return XIoctl(fd_, VIDIOC_QBUF, &buffer) == 0;
+}
+
+// Wait for the decoder to return the buffer of a queue, for at most a second; false if it flagged an error
+bool V4L2JpegDecoder::DequeueBuffer(uint32_t type, short event) {
+    v4l2_plane planes[VIDEO_MAX_PLANES]{};
+    v4l2_buffer buffer{};
+    buffer.type = type;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    if (multiplanar_) {
+        buffer.m.planes = planes;
+        buffer.length = VIDEO_MAX_PLANES;
+    }
+    for (;;) {
+        if (XIoctl(fd_, VIDIOC_DQBUF, &buffer) == 0) {
+            return (buffer.flags & V4L2_BUF_FLAG_ERROR) == 0;
+        }
+        if (errno != EAGAIN) {
+            return false;
+        }
+        pollfd descriptor{fd_, event, 0};
+        int ready;
+        do {
+            ready = poll(&descriptor, 1, 1000);
+        } while (ready == -1 && errno == EINTR);
+        if (ready <= 0 || (descriptor.revents & POLLERR) != 0) {
+            return false;
+        }
+    }
+}
+
+bool V4L2JpegDecoder::Decode(const void* jpeg, size_t size, cv::Mat& frame) {
+    if (fd_ < 0 || size > output_.length) {
+        return false;
+    }
+
+    memcpy(output_.start, jpeg, size);
+    if (!QueueBuffer(captureType_, capture_.length) || !QueueBuffer(outputType_, size)) {
+        return false;
+    }
+    // Dequeue both even if the decode failed, so both buffers can be queued again for the next frame
+    const bool decoded = DequeueBuffer(captureType_, POLLIN);
+    const bool consumed = DequeueBuffer(outputType_, POLLOUT);
+    if (!decoded || !consumed) {
+        return false;
+    }
+
+    uint8_t* pixels = static_cast<uint8_t*>(capture_.start);
+    if (captureFormat_ == V4L2_PIX_FMT_NV12) {
+        // The interleaved chroma plane follows the luma plane at the aligned height
+        const cv::Mat luma(height_, width_, CV_8UC1, pixels, bytesPerLine_);
+        const cv::Mat chroma(height_ / 2, width_ / 2, CV_8UC2, pixels + static_cast<size_t>(bytesPerLine_) * captureHeight_,
+                             bytesPerLine_);
+        cv::cvtColorTwoPlane(luma, chroma, frame, cv::COLOR_YUV2BGR_NV12);
+    } else {
+        cv::Mat(height_, width_, CV_8UC3, pixels, bytesPerLine_).copyTo(frame);
+    }
+    return true;
+}
+
+void V4L2JpegDecoder::Shutdown() {
+    if (fd_ < 0) {
+        return;
+    }
+    if (outputType_ != 0) {
+        v4l2_buf_type type = static_cast<v4l2_buf_type>(outputType_);
+        XIoctl(fd_, VIDIOC_STREAMOFF, &type);
+        type = static_cast<v4l2_buf_type>(captureType_);
+        XIoctl(fd_, VIDIOC_STREAMOFF, &type);
+    }
+    for (MappedBuffer* mapped : {&output_, &capture_}) {
+        if (mapped->start != nullptr) {
+            munmap(mapped->start, mapped->length);
+        }
+        *mapped = MappedBuffer{};
+    }
+    close(fd_);
+    fd_ = -1;
+    outputType_ = 0;
+    captureType_ = 0;
+    devicePath_.clear();
+}
+#else
+bool V4L2JpegDecoder::Initialize(int, int, const std::string&, const std::string&) { return false; }
+bool V4L2JpegDecoder::Decode(const void*, size_t, cv::Mat&) { return false; }
+void V4L2JpegDecoder::Shutdown() {}
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Hardware JPEG decode through a V4L2 memory-to-memory decoder, as ARM SoCs have: the compressed frame is copied to
+// the decoder's output queue, and the NV12 or BGR picture it writes to its capture queue is converted to BGR for the
+// uploads of VRCameraApp.  One frame is in flight at a time, decoded synchronously.
+//
+// The formats are set once for the camera mode, so decoders that change them on a source change event are not
+// supported.
+class V4L2JpegDecoder {
+public:
+    V4L2JpegDecoder() = default;
+    ~V4L2JpegDecoder();
+    V4L2JpegDecoder(const V4L2JpegDecoder&) = delete;
+    V4L2JpegDecoder& operator=(const V4L2JpegDecoder&) = delete;
+
+    // Open devicePath, or the first /dev/videoN other than skipDevicePath that can decode JPEG to NV12 or BGR24, for
+    // frames of width x height.
+    bool Initialize(int width, int height, const std::string& devicePath = "", const std::string& skipDevicePath = "");
+
+    // Decode one JPEG into a BGR frame, into its existing pixels when the size matches.  False if the decoder failed,
+    // e.g. on a corrupt frame.
+    bool Decode(const void* jpeg, size_t size, cv::Mat& frame);
+
+    bool IsInitialized() const { return fd_ >= 0; }
+    const std::string& GetDevicePath() const { return devicePath_; }
+
+    void Shutdown();
+
+private:
+    bool Open(const std::string& devicePath, int width, int height);
+
+    struct MappedBuffer {
+        void* start = nullptr;
+        size_t length = 0;
+    };
+    bool MapBuffer(uint32_t type, MappedBuffer& mapped);
+    bool QueueBuffer(uint32_t type, size_t bytesUsed);
+    bool DequeueBuffer(uint32_t type, short event);
+
+    int fd_ = -1;
+    std::string devicePath_;
+    bool multiplanar_ = false;  // Whether the device has the multi-planar API, as most recent decoders do
+    uint32_t outputType_ = 0;   // The queue of compressed frames
+    uint32_t captureType_ = 0;  // The queue of decoded pictures
+    uint32_t captureFormat_ = 0;
+    uint32_t bytesPerLine_ = 0;
+    uint32_t captureHeight_ = 0;  // The height of the luma plane, which may be aligned up from the frame's
+    int width_ = 0;
+    int height_ = 0;
+    MappedBuffer output_;
+    MappedBuffer capture_;
+};
@@ -0,0 +1,31 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+#version 400
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+#pragma fragment
+
+// Where the camera eye is drawn in the layer, in pixels, and its layer of the textures.
+layout (push_constant) uniform Image
+{
+    vec2 offset;
+    vec2 size;
+    float eye;
+} image;
+
+layout (set = 0, binding = 0) uniform sampler2DArray cameraTexture;
+// For each pixel of the rectified eye, the offset to the camera pixel it shows, in texture coordinates.
+layout (set = 0, binding = 1) uniform sampler2DArray remapTexture;
+
+layout (location = 0) out vec4 FragColor;
+
+void main()
+{
+    vec2 uv = (gl_FragCoord.xy - image.offset) / image.size;
+    vec2 source = uv + texture(remapTexture, vec3(uv, image.eye)).rg;
+    // Black outside the eye, and where the rectified eye shows no part of the camera image
+    vec2 inside = step(vec2(0.0), source) * step(source, vec2(1.0)) * step(vec2(0.0), uv) * step(uv, vec2(1.0));
+    FragColor = vec4(texture(cameraTexture, vec3(source, image.eye)).rgb * (inside.x * inside.y), 1.0);
+}
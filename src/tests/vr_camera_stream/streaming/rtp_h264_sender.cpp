@@ -0,0 +1,162 @@
+#include "rtp_h264_sender.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static const size_t kRtpHeaderSize = 12;
+static const size_t kMaxPayloadSize = 1200;  // Under the MTU of any network between the headset PC and a laptop
+static const uint8_t kPayloadType = 96;      // The first dynamic one, which the SDP maps to H.264
+
+RtpH264Sender::~RtpH264Sender() {
+    Close();
+}
+
+// The next NAL unit at or after offset, without its start code; size 0 past the last one
+static void FindNalUnit(const uint8_t* data, size_t size, size_t& offset, size_t& nalStart, size_t& nalSize) {
+    size_t start = offset;
+    while (start + 3 <= size && !(data[start] == 0 && data[start + 1] == 0 && data[start + 2] == 1)) {
+        start++;
+    }
+    if (start + 3 > size) {
+        offset = size;
+        nalSize = 0;
+        return;
+    }
+    start += 3;
+    size_t end = start;
+    while (end + 3 <= size && !(data[end] == 0 && data[end + 1] == 0 && (data[end + 2] == 1 || data[end + 2] == 0))) {
+        end++;
+    }
+    end = end + 3 > size ? size : end;
+    nalStart = start;
+    nalSize = end - start;
+    offset = end;
+}
+
+#if defined(__linux__)
+bool RtpH264Sender::Open(const std::string& address) {
+    Close();
+    const size_t colon = address.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == address.size()) {
+        std::cerr << "RTP: " << address << " is not host:port" << std::endl;
+        return false;
+    }
+    host_ = address.substr(0, colon);
+    port_ = address.substr(colon + 1);
+    if (host_.size() > 2 && host_.front() == '[' && host_.back() == ']') {
+        host_ = host_.substr(1, host_.size() - 2);  // [IPv6 address]:port
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host_.c_str(), port_.c_str(), &hints, &addresses) != 0) {
+        std::cerr << "RTP: cannot resolve " << address << std::endl;
+        return false;
+    }
+    for (addrinfo* candidate = addresses; candidate != nullptr && socket_ < 0; candidate = candidate->ai_next) {
+        socket_ = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+        // Connected, so each packet is a plain send and ICMP errors come back
+        if (socket_ >= 0 && connect(socket_, candidate->ai_addr, candidate->ai_addrlen) == -1) {
+            close(socket_);
+            socket_ = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (socket_ < 0) {
+        std::cerr << "RTP: cannot send to " << address << std::endl;
+        return false;
+    }
+
+    sequence_ = 0;
+    ssrc_ = static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    return true;
+}
+
+void RtpH264Sender::Close() {
+    if (socket_ >= 0) {
+        close(socket_);
+        socket_ = -1;
+    }
+}
+
+bool RtpH264Sender::SendPacket(const uint8_t* payloadHeader, size_t headerSize, const uint8_t* payload, size_t size,
+                               bool marker, uint32_t timestamp) {
+    uint8_t packet[kRtpHeaderSize + kMaxPayloadSize];
+    packet[0] = 0x80;  // Version 2
+    packet[1] = static_cast<uint8_t>((marker ? 0x80 : 0) | kPayloadType);
+    packet[2] = static_cast<uint8_t>(sequence_ >> 8);
+    packet[3] = static_cast<uint8_t>(sequence_);
+    for (int i = 0; i < 4; i++) {
+        packet[4 + i] = static_cast<uint8_t>(timestamp >> (24 - 8 * i));
+        packet[8 + i] = static_cast<uint8_t>(ssrc_ >> (24 - 8 * i));
+    }
+    if (headerSize > 0) {
+        memcpy(packet + kRtpHeaderSize, payloadHeader, headerSize);
+    }
+    memcpy(packet + kRtpHeaderSize + headerSize, payload, size);
+    sequence_++;
+    // A spectator that is not listening yet is no error
+    const size_t packetSize = kRtpHeaderSize + headerSize + size;
+    return send(socket_, packet, packetSize, 0) == static_cast<ssize_t>(packetSize) || errno == ECONNREFUSED;
+}
+#else
+bool RtpH264Sender::Open(const std::string&) { return false; }
+void RtpH264Sender::Close() {}
+bool RtpH264Sender::SendPacket(const uint8_t*, size_t, const uint8_t*, size_t, bool, uint32_t) { return false; }
+#endif
+
+bool RtpH264Sender::Send(const uint8_t* accessUnit, size_t size, uint32_t timestamp) {
+    if (socket_ < 0) {
+        return false;
+    }
+    size_t offset = 0;
+    size_t nalStart = 0;
+    size_t nalSize = 0;
+    FindNalUnit(accessUnit, size, offset, nalStart, nalSize);
+    bool sent = true;
+    while (nalSize != 0) {
+        const uint8_t* nal = accessUnit + nalStart;
+        const size_t currentSize = nalSize;
+        FindNalUnit(accessUnit, size, offset, nalStart, nalSize);
+        const bool last = nalSize == 0;  // The marker bit ends the access unit
+
+        if (currentSize <= kMaxPayloadSize) {
+            sent = SendPacket(nullptr, 0, nal, currentSize, last, timestamp) && sent;
+            continue;
+        }
+        // FU-A: the NAL header's NRI and type move to the FU indicator and header, and the rest is split up
+        uint8_t header[2] = {static_cast<uint8_t>((nal[0] & 0xE0) | 28), static_cast<uint8_t>(nal[0] & 0x1F)};
+        for (size_t fragment = 1; fragment < currentSize;) {
+            const size_t fragmentSize = std::min(kMaxPayloadSize - sizeof(header), currentSize - fragment);
+            header[1] = static_cast<uint8_t>((nal[0] & 0x1F) | (fragment == 1 ? 0x80 : 0) |
+                                             (fragment + fragmentSize == currentSize ? 0x40 : 0));
+            sent = SendPacket(header, sizeof(header), nal + fragment, fragmentSize,
+                              last && fragment + fragmentSize == currentSize, timestamp) &&
+                   sent;
+            fragment += fragmentSize;
+        }
+    }
+    return sent;
+}
+
+std::string RtpH264Sender::GetSdp() const {
+    const bool ipv6 = host_.find(':') != std::string::npos;
+    return "v=0\n"
+           "o=- 0 0 IN " + std::string(ipv6 ? "IP6 " : "IP4 ") + host_ + "\n"
+           "s=vr_camera_stream spectator\n"
+           "c=IN " + std::string(ipv6 ? "IP6 " : "IP4 ") + host_ + "\n"
+           "t=0 0\n"
+           "m=video " + port_ + " RTP/AVP " + std::to_string(kPayloadType) + "\n"
+           "a=rtpmap:" + std::to_string(kPayloadType) + " H264/90000\n"
+           "a=fmtp:" + std::to_string(kPayloadType) + " packetization-mode=1\n";
+}
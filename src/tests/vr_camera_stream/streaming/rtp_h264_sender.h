@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Sends an H.264 stream over RTP on UDP, packetized as RFC 6184 describes: a NAL unit that fits in a packet is sent
+// as it is, a bigger one in fragmentation units.  The SDP from GetSdp is all a player needs, e.g.
+// "ffplay -protocol_whitelist file,udp,rtp spectator.sdp" on the receiving machine.
+class RtpH264Sender {
+public:
+    RtpH264Sender() = default;
+    ~RtpH264Sender();
+    RtpH264Sender(const RtpH264Sender&) = delete;
+    RtpH264Sender& operator=(const RtpH264Sender&) = delete;
+
+    // Send to address, "host:port"
+    bool Open(const std::string& address);
+
+    // Send one access unit, the stream of a frame with start codes, stamped with timestamp on the 90 kHz clock
+    bool Send(const uint8_t* accessUnit, size_t size, uint32_t timestamp);
+
+    std::string GetSdp() const;
+    bool IsOpen() const { return socket_ >= 0; }
+
+    void Close();
+
+private:
+    bool SendPacket(const uint8_t* payloadHeader, size_t headerSize, const uint8_t* payload, size_t size, bool marker,
+                    uint32_t timestamp);
+
+    int socket_ = -1;
+    std::string host_;
+    std::string port_;
+    uint16_t sequence_ = 0;
+    uint32_t ssrc_ = 0;
+};
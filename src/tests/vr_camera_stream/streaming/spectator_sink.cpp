@@ -0,0 +1,116 @@
+#include "spectator_sink.h"
+#include <iostream>
+
+SpectatorSink::~SpectatorSink() {
+    Stop();
+}
+
+bool SpectatorSink::Initialize(int width, int height, V4L2H264Encoder::InputFormat format, int fps, int bitrate,
+                               const std::string& encoderPath) {
+    Stop();
+    return encoder_.Initialize(width, height, format, fps, bitrate, kBufferCount, encoderPath);
+}
+
+bool SpectatorSink::Start(const std::string& address, const std::array<int, kBufferCount>& dmabufFds) {
+    if (!encoder_.IsInitialized() || running_ || !sender_.Open(address)) {
+        return false;
+    }
+    dmabufFds_ = dmabufFds;
+    for (std::atomic<unsigned>& state : states_) {
+        state = Free;
+    }
+    encodedCount_ = 0;
+    droppedCount_ = 0;
+    sdp_ = sender_.GetSdp();
+
+    running_ = true;
+    thread_ = std::thread(&SpectatorSink::EncodeThread, this);
+    return true;
+}
+
+int SpectatorSink::AcquireBuffer() {
+    if (!running_) {
+        return -1;
+    }
+    for (unsigned index = 0; index < kBufferCount; index++) {
+        unsigned expected = Free;
+        if (states_[index].compare_exchange_strong(expected, Writing, std::memory_order_acquire)) {
+            return static_cast<int>(index);
+        }
+    }
+    return -1;
+}
+
+void SpectatorSink::Submit(int index, int64_t timestamp) {
+    timestamps_[index] = timestamp;
+    states_[index].store(Submitted, std::memory_order_release);
+    // Lock so the thread cannot miss the wake-up between checking the states and waiting
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    submitted_.notify_one();
+}
+
+void SpectatorSink::Release(int index) {
+    states_[index].store(Free, std::memory_order_release);
+}
+
+void SpectatorSink::EncodeThread() {
+    int failedEncodes = 0;
+    while (running_) {
+        // The newest submitted buffer; older ones are dropped, the encoder being behind
+        int newest = -1;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            submitted_.wait(lock, [this, &newest] {
+                for (unsigned index = 0; index < kBufferCount; index++) {
+                    if (states_[index].load(std::memory_order_acquire) == Submitted &&
+                        (newest < 0 || timestamps_[index] > timestamps_[newest])) {
+                        newest = static_cast<int>(index);
+                    }
+                }
+                return newest >= 0 || !running_;
+            });
+        }
+        if (newest < 0) {
+            break;
+        }
+        for (unsigned index = 0; index < kBufferCount; index++) {
+            if (static_cast<int>(index) != newest && states_[index].load(std::memory_order_acquire) == Submitted &&
+                timestamps_[index] < timestamps_[newest]) {
+                states_[index].store(Free, std::memory_order_release);
+                droppedCount_++;
+            }
+        }
+
+        states_[newest].store(Encoding, std::memory_order_relaxed);
+        bitstream_.clear();
+        const bool encoded = encoder_.Encode(static_cast<unsigned>(newest), dmabufFds_[newest], bitstream_);
+        const int64_t timestamp = timestamps_[newest];
+        states_[newest].store(Free, std::memory_order_release);
+        if (!encoded) {
+            if (failedEncodes++ % 60 == 0) {  // Log every 60 failures to avoid spam
+                std::cerr << "Spectator: encoding failed on " << encoder_.GetDevicePath() << std::endl;
+            }
+            continue;
+        }
+        failedEncodes = 0;
+        if (!bitstream_.empty()) {
+            // RTP stamps H.264 on a 90 kHz clock, which wraps
+            sender_.Send(bitstream_.data(), bitstream_.size(), static_cast<uint32_t>(timestamp / 100000 * 9));
+        }
+        encodedCount_++;
+    }
+}
+
+void SpectatorSink::Stop() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        submitted_.notify_one();
+        thread_.join();
+    }
+    running_ = false;
+    sender_.Close();
+    encoder_.Shutdown();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "rtp_h264_sender.h"
+#include "v4l2_h264_encoder.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Streams rendered frames to a spectator: H.264 on a V4L2 encoder, sent over RTP, all on a thread of its own.  It
+// knows nothing of OpenXR or the renderer, so any app rendering with Vulkan can feed it.  The app owns kBufferCount
+// frame buffers shared with the encoder as DMA-BUFs, and for each frame takes a free one, has the GPU write to it, and
+// submits it once the GPU is done.  The thread encodes the newest buffer submitted and hands the older ones back, so
+// a slow encoder drops spectator frames instead of holding up the frame loop.
+class SpectatorSink {
+public:
+    static constexpr unsigned kBufferCount = 3;
+
+    SpectatorSink() = default;
+    ~SpectatorSink();
+    SpectatorSink(const SpectatorSink&) = delete;
+    SpectatorSink& operator=(const SpectatorSink&) = delete;
+
+    // Open an encoder, encoderPath or the first found, for width x height frames at fps.  The app's buffers then
+    // need the encoder's layout.
+    bool Initialize(int width, int height, V4L2H264Encoder::InputFormat format, int fps, int bitrate,
+                    const std::string& encoderPath = "");
+    uint32_t GetBytesPerLine() const { return encoder_.GetBytesPerLine(); }
+    size_t GetFrameSize() const { return encoder_.GetFrameSize(); }
+
+    // Stream to address, "host:port", from the DMA-BUFs of the buffers, which stay the app's to close after Stop
+    bool Start(const std::string& address, const std::array<int, kBufferCount>& dmabufFds);
+    const std::string& GetSdp() const { return sdp_; }
+    bool IsRunning() const { return running_; }
+
+    // Frame loop: take a free buffer to write the next frame into, or -1 if they are all submitted or encoding.  Then
+    // Submit it once the GPU wrote it, timestamp in nanoseconds on any clock, or Release it unwritten.
+    int AcquireBuffer();
+    void Submit(int index, int64_t timestamp);
+    void Release(int index);
+
+    uint64_t GetEncodedCount() const { return encodedCount_; }
+    uint64_t GetDroppedCount() const { return droppedCount_; }  // Submitted and superseded before their encode
+
+    void Stop();
+
+private:
+    enum BufferState : unsigned { Free, Writing, Submitted, Encoding };
+
+    void EncodeThread();
+
+    V4L2H264Encoder encoder_;
+    RtpH264Sender sender_;
+    std::string sdp_;
+    std::array<int, kBufferCount> dmabufFds_{};
+    std::array<std::atomic<unsigned>, kBufferCount> states_{};
+    std::array<int64_t, kBufferCount> timestamps_{};  // Written by the frame loop before the buffer is Submitted
+    std::vector<uint8_t> bitstream_;                  // Of the frame encoding, reused
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex mutex_;  // Only for the wake-up of the thread
+    std::condition_variable submitted_;
+    std::atomic<uint64_t> encodedCount_{0};
+    std::atomic<uint64_t> droppedCount_{0};
+};
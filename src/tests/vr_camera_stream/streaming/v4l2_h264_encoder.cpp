@@ -0,0 +1,348 @@
+#include "v4l2_h264_encoder.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Enough for the encoder to write a frame while the last one is read
+static const unsigned kCaptureBufferCount = 2;
+
+V4L2H264Encoder::~V4L2H264Encoder() {
+    Shutdown();
+}
+
+#if defined(__linux__)
+static int XIoctl(int fd, unsigned long request, void* arg) {
+    int result;
+    do {
+        result = ioctl(fd, request, arg);
+    } while (result == -1 && errno == EINTR);
+    return result;
+}
+
+static bool HasFormat(int fd, uint32_t type, uint32_t pixelFormat) {
+    v4l2_fmtdesc description{};
+    description.type = type;
+    for (description.index = 0; XIoctl(fd, VIDIOC_ENUM_FMT, &description) == 0; description.index++) {
+        if (description.pixelformat == pixelFormat) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool V4L2H264Encoder::Initialize(int width, int height, InputFormat format, int fps, int bitrate, unsigned bufferCount,
+                                 const std::string& devicePath) {
+    Shutdown();
+    if (!devicePath.empty()) {
+        return Open(devicePath, width, height, format, fps, bitrate, bufferCount);
+    }
+    for (int index = 0; index < 64; index++) {
+        if (Open("/dev/video" + std::to_string(index), width, height, format, fps, bitrate, bufferCount)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool V4L2H264Encoder::Open(const std::string& devicePath, int width, int height, InputFormat format, int fps, int bitrate,
+                           unsigned bufferCount) {
+    fd_ = open(devicePath.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd_ < 0) {
+        return false;
+    }
+
+    v4l2_capability capability{};
+    if (XIoctl(fd_, VIDIOC_QUERYCAP, &capability) == -1) {
+        Shutdown();
+        return false;
+    }
+    const uint32_t caps =
+        (capability.capabilities & V4L2_CAP_DEVICE_CAPS) != 0 ? capability.device_caps : capability.capabilities;
+    if ((caps & V4L2_CAP_STREAMING) == 0 || (caps & (V4L2_CAP_VIDEO_M2M_MPLANE | V4L2_CAP_VIDEO_M2M)) == 0) {
+        Shutdown();
+        return false;
+    }
+    multiplanar_ = (caps & V4L2_CAP_VIDEO_M2M_MPLANE) != 0;
+    outputType_ = multiplanar_ ? V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE : V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    captureType_ = multiplanar_ ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE : V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    // The same bytes either with or without alpha, which the encoder ignores
+    const uint32_t rawFormats[2] = {format == InputFormat::BGRX ? V4L2_PIX_FMT_XBGR32 : V4L2_PIX_FMT_RGBX32,
+                                    format == InputFormat::BGRX ? V4L2_PIX_FMT_ABGR32 : V4L2_PIX_FMT_RGBA32};
+    const uint32_t rawFormat = HasFormat(fd_, outputType_, rawFormats[0])   ? rawFormats[0]
+                               : HasFormat(fd_, outputType_, rawFormats[1]) ? rawFormats[1]
+                                                                            : 0;
+    if (rawFormat == 0 || !HasFormat(fd_, captureType_, V4L2_PIX_FMT_H264)) {
+        Shutdown();
+        return false;
+    }
+
+    // Encoders take the coded format first, and size the raw frames from it
+    v4l2_format capture{};
+    capture.type = captureType_;
+    const uint32_t captureSize = static_cast<uint32_t>(width) * static_cast<uint32_t>(height) / 2;
+    if (multiplanar_) {
+        capture.fmt.pix_mp.width = static_cast<__u32>(width);
+        capture.fmt.pix_mp.height = static_cast<__u32>(height);
+        capture.fmt.pix_mp.pixelformat = V4L2_PIX_FMT_H264;
+        capture.fmt.pix_mp.field = V4L2_FIELD_NONE;
+        capture.fmt.pix_mp.num_planes = 1;
+        capture.fmt.pix_mp.plane_fmt[0].sizeimage = captureSize;
+    } else {
+        capture.fmt.pix.width = static_cast<__u32>(width);
+        capture.fmt.pix.height = static_cast<__u32>(height);
+        capture.fmt.pix.pixelformat = V4L2_PIX_FMT_H264;
+        capture.fmt.pix.field = V4L2_FIELD_NONE;
+        capture.fmt.pix.sizeimage = captureSize;
+    }
+    if (XIoctl(fd_, VIDIOC_S_FMT, &capture) == -1) {
+        Shutdown();
+        return false;
+    }
+
+    v4l2_format output{};
+    output.type = outputType_;
+    if (multiplanar_) {
+        output.fmt.pix_mp.width = static_cast<__u32>(width);
+        output.fmt.pix_mp.height = static_cast<__u32>(height);
+        output.fmt.pix_mp.pixelformat = rawFormat;
+        output.fmt.pix_mp.field = V4L2_FIELD_NONE;
+        output.fmt.pix_mp.num_planes = 1;
+    } else {
+        output.fmt.pix.width = static_cast<__u32>(width);
+        output.fmt.pix.height = static_cast<__u32>(height);
+        output.fmt.pix.pixelformat = rawFormat;
+        output.fmt.pix.field = V4L2_FIELD_NONE;
+    }
+    if (XIoctl(fd_, VIDIOC_S_FMT, &output) == -1) {
+        Shutdown();
+        return false;
+    }
+    // Each frame is one DMA-BUF, so one plane
+    const bool outputFits = multiplanar_ ? output.fmt.pix_mp.pixelformat == rawFormat && output.fmt.pix_mp.num_planes == 1 &&
+                                               output.fmt.pix_mp.width == static_cast<__u32>(width) &&
+                                               output.fmt.pix_mp.height >= static_cast<__u32>(height)
+                                         : output.fmt.pix.pixelformat == rawFormat &&
+                                               output.fmt.pix.width == static_cast<__u32>(width) &&
+                                               output.fmt.pix.height >= static_cast<__u32>(height);
+    if (!outputFits) {
+        Shutdown();
+        return false;
+    }
+    bytesPerLine_ = multiplanar_ ? output.fmt.pix_mp.plane_fmt[0].bytesperline : output.fmt.pix.bytesperline;
+    frameSize_ = multiplanar_ ? output.fmt.pix_mp.plane_fmt[0].sizeimage : output.fmt.pix.sizeimage;
+
+    v4l2_streamparm parameters{};
+    parameters.type = outputType_;
+    parameters.parm.output.timeperframe.numerator = 1;
+    parameters.parm.output.timeperframe.denominator = static_cast<__u32>(fps);
+    XIoctl(fd_, VIDIOC_S_PARM, &parameters);
+
+    // A spectator may join at any time and every frame shows as soon as it is encoded: key frames each second, each
+    // with the SPS and PPS, and no B-frames, which would hold frames back
+    SetControl(V4L2_CID_MPEG_VIDEO_BITRATE, bitrate);
+    SetControl(V4L2_CID_MPEG_VIDEO_B_FRAMES, 0);
+    SetControl(V4L2_CID_MPEG_VIDEO_GOP_SIZE, fps);
+    SetControl(V4L2_CID_MPEG_VIDEO_H264_I_PERIOD, fps);
+    SetControl(V4L2_CID_MPEG_VIDEO_REPEAT_SEQ_HEADER, 1);
+
+    v4l2_requestbuffers request{};
+    request.count = bufferCount;
+    request.type = outputType_;
+    request.memory = V4L2_MEMORY_DMABUF;
+    if (XIoctl(fd_, VIDIOC_REQBUFS, &request) == -1 || request.count < bufferCount) {
+        std::cerr << "V4L2 M2M: " << devicePath << " cannot import DMA-BUF frames" << std::endl;
+        Shutdown();
+        return false;
+    }
+
+    request = {};
+    request.count = kCaptureBufferCount;
+    request.type = captureType_;
+    request.memory = V4L2_MEMORY_MMAP;
+    if (XIoctl(fd_, VIDIOC_REQBUFS, &request) == -1 || request.count < 1) {
+        Shutdown();
+        return false;
+    }
+    capture_.resize(request.count);
+    for (unsigned index = 0; index < capture_.size(); index++) {
+        v4l2_plane planes[VIDEO_MAX_PLANES]{};
+        v4l2_buffer buffer{};
+        buffer.type = captureType_;
+        buffer.memory = V4L2_MEMORY_MMAP;
+        buffer.index = index;
+        if (multiplanar_) {
+            buffer.m.planes = planes;
+            buffer.length = VIDEO_MAX_PLANES;
+        }
+        if (XIoctl(fd_, VIDIOC_QUERYBUF, &buffer) == -1) {
+            Shutdown();
+            return false;
+        }
+        const size_t length = multiplanar_ ? planes[0].length : buffer.length;
+        const off_t offset = multiplanar_ ? planes[0].m.mem_offset : buffer.m.offset;
+        void* start = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, offset);
+        if (start == MAP_FAILED) {
+            Shutdown();
+            return false;
+        }
+        capture_[index].start = start;
+        capture_[index].length = length;
+        if (!QueueCaptureBuffer(index)) {
+            Shutdown();
+            return false;
+        }
+    }
+
+    v4l2_buf_type type = static_cast<v4l2_buf_type>(outputType_);
+    v4l2_buf_type captureStreamType = static_cast<v4l2_buf_type>(captureType_);
+    if (XIoctl(fd_, VIDIOC_STREAMON, &type) == -1 || XIoctl(fd_, VIDIOC_STREAMON, &captureStreamType) == -1) {
+        std::cerr << "V4L2 M2M: VIDIOC_STREAMON failed on " << devicePath << ": " << strerror(errno) << std::endl;
+        Shutdown();
+        return false;
+    }
+
+    devicePath_ = devicePath;
+    std::cout << "H.264 encoder: " << reinterpret_cast<const char*>(capability.card) << " (" << devicePath << "), "
+              << width << "x" << height << " at " << fps << " fps, " << bitrate / 1000 << " kbit/s" << std::endl;
+    return true;
+}
+
+void V4L2H264Encoder::SetControl(uint32_t id, int value) {
+    v4l2_control control{};
+    control.id = id;
+    control.value = value;
+    XIoctl(fd_, VIDIOC_S_CTRL, &control);
+}
+
+bool V4L2H264Encoder::QueueCaptureBuffer(unsigned index) {
+    v4l2_plane plane{};
+    v4l2_buffer buffer{};
+    buffer.type = captureType_;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    buffer.index = index;
+    if (multiplanar_) {
+        plane.length = static_cast<__u32>(capture_[index].length);
+        buffer.m.planes = &plane;
+        buffer.length = 1;
+    }
+    return XIoctl(fd_, VIDIOC_QBUF, &buffer) == 0;
+}
+
+bool V4L2H264Encoder::Encode(unsigned index, int dmabufFd, std::vector<uint8_t>& bitstream) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    v4l2_plane plane{};
+    v4l2_buffer frame{};
+    frame.type = outputType_;
+    frame.memory = V4L2_MEMORY_DMABUF;
+    frame.index = index;
+    if (multiplanar_) {
+        plane.m.fd = dmabufFd;
+        plane.length = static_cast<__u32>(frameSize_);
+        plane.bytesused = static_cast<__u32>(frameSize_);
+        frame.m.planes = &plane;
+        frame.length = 1;
+    } else {
+        frame.m.fd = dmabufFd;
+        frame.length = static_cast<__u32>(frameSize_);
+        frame.bytesused = static_cast<__u32>(frameSize_);
+    }
+    if (XIoctl(fd_, VIDIOC_QBUF, &frame) == -1) {
+        return false;
+    }
+
+    // Wait, for at most a second at a time, until the encoder gives the frame back and has written some stream.  An
+    // encoder that writes the SPS and PPS to a buffer of their own first leaves the first frame's for the next call.
+    bool consumed = false;
+    bool encoded = false;
+    bool failed = false;
+    while (!consumed || !encoded) {
+        pollfd descriptor{fd_, static_cast<short>(POLLIN | POLLOUT), 0};
+        int ready;
+        do {
+            ready = poll(&descriptor, 1, 1000);
+        } while (ready == -1 && errno == EINTR);
+        if (ready <= 0 || (descriptor.revents & POLLERR) != 0) {
+            return false;
+        }
+
+        v4l2_plane planes[VIDEO_MAX_PLANES]{};
+        v4l2_buffer buffer{};
+        buffer.type = outputType_;
+        buffer.memory = V4L2_MEMORY_DMABUF;
+        if (multiplanar_) {
+            buffer.m.planes = planes;
+            buffer.length = VIDEO_MAX_PLANES;
+        }
+        if (!consumed && XIoctl(fd_, VIDIOC_DQBUF, &buffer) == 0) {
+            consumed = true;
+            failed = failed || (buffer.flags & V4L2_BUF_FLAG_ERROR) != 0;
+        }
+
+        for (;;) {
+            buffer = {};
+            buffer.type = captureType_;
+            buffer.memory = V4L2_MEMORY_MMAP;
+            if (multiplanar_) {
+                buffer.m.planes = planes;
+                buffer.length = VIDEO_MAX_PLANES;
+            }
+            if (XIoctl(fd_, VIDIOC_DQBUF, &buffer) == -1) {
+                break;
+            }
+            const size_t size = multiplanar_ ? planes[0].bytesused - planes[0].data_offset : buffer.bytesused;
+            const uint8_t* data = static_cast<const uint8_t*>(capture_[buffer.index].start) +
+                                  (multiplanar_ ? planes[0].data_offset : 0);
+            if ((buffer.flags & V4L2_BUF_FLAG_ERROR) == 0 && size <= capture_[buffer.index].length) {
+                bitstream.insert(bitstream.end(), data, data + size);
+            }
+            encoded = true;
+            if (!QueueCaptureBuffer(buffer.index)) {
+                return false;
+            }
+        }
+    }
+    return !failed;
+}
+
+void V4L2H264Encoder::Shutdown() {
+    if (fd_ < 0) {
+        return;
+    }
+    if (outputType_ != 0) {
+        v4l2_buf_type type = static_cast<v4l2_buf_type>(outputType_);
+        XIoctl(fd_, VIDIOC_STREAMOFF, &type);
+        type = static_cast<v4l2_buf_type>(captureType_);
+        XIoctl(fd_, VIDIOC_STREAMOFF, &type);
+    }
+    for (MappedBuffer& mapped : capture_) {
+        if (mapped.start != nullptr) {
+            munmap(mapped.start, mapped.length);
+        }
+    }
+    capture_.clear();
+    close(fd_);
+    fd_ = -1;
+    outputType_ = 0;
+    captureType_ = 0;
+    bytesPerLine_ = 0;
+    frameSize_ = 0;
+    devicePath_.clear();
+}
+#else
+bool V4L2H264Encoder::Initialize(int, int, InputFormat, int, int, unsigned, const std::string&) { return false; }
+bool V4L2H264Encoder::Encode(unsigned, int, std::vector<uint8_t>&) { return false; }
+void V4L2H264Encoder::Shutdown() {}
+#endif
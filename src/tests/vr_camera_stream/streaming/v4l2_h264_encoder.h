@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hardware H.264 encode through a V4L2 memory-to-memory encoder, as ARM SoCs have.  The frames are not copied in:
+// each is a DMA-BUF the caller exported, e.g. Vulkan memory the GPU copied the rendered view to, imported into the
+// encoder's output queue, so the CPU never touches the pixels.  The encoder writes the H.264 stream, with start
+// codes and the SPS and PPS before every key frame, to its mmap'd capture queue.  One frame is in flight at a time.
+//
+// Only encoders taking 32-bit RGB are supported; most take only YUV, which would need a GPU color conversion first.
+class V4L2H264Encoder {
+public:
+    // The byte order of the frames' pixels, the fourth byte ignored
+    enum class InputFormat { BGRX, RGBX };
+
+    V4L2H264Encoder() = default;
+    ~V4L2H264Encoder();
+    V4L2H264Encoder(const V4L2H264Encoder&) = delete;
+    V4L2H264Encoder& operator=(const V4L2H264Encoder&) = delete;
+
+    // Open devicePath, or the first /dev/videoN that can encode width x height frames of format to H.264, at fps
+    // frames per second and bitrate bits per second, taking frames from up to bufferCount distinct DMA-BUFs.
+    bool Initialize(int width, int height, InputFormat format, int fps, int bitrate, unsigned bufferCount,
+                    const std::string& devicePath = "");
+
+    // The layout the frames' DMA-BUFs need: the encoder may pad the rows and the height
+    uint32_t GetBytesPerLine() const { return bytesPerLine_; }
+    size_t GetFrameSize() const { return frameSize_; }
+
+    // Encode the frame in dmabufFd, buffer index of the bufferCount, appending the H.264 the encoder wrote to
+    // bitstream.  Blocks until the encoder is done with the frame.  The first frame's stream may come with the next.
+    bool Encode(unsigned index, int dmabufFd, std::vector<uint8_t>& bitstream);
+
+    bool IsInitialized() const { return fd_ >= 0; }
+    const std::string& GetDevicePath() const { return devicePath_; }
+
+    void Shutdown();
+
+private:
+    bool Open(const std::string& devicePath, int width, int height, InputFormat format, int fps, int bitrate,
+              unsigned bufferCount);
+    bool QueueCaptureBuffer(unsigned index);
+    void SetControl(uint32_t id, int value);  // Best effort: encoders leave out controls they have no use for
+
+    struct MappedBuffer {
+        void* start = nullptr;
+        size_t length = 0;
+    };
+
+    int fd_ = -1;
+    std::string devicePath_;
+    bool multiplanar_ = false;  // Whether the device has the multi-planar API, as most recent encoders do
+    uint32_t outputType_ = 0;   // The queue of raw frames
+    uint32_t captureType_ = 0;  // The queue of H.264
+    uint32_t bytesPerLine_ = 0;
+    size_t frameSize_ = 0;
+    std::vector<MappedBuffer> capture_;
+};
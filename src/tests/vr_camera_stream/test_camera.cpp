@@ -1,77 +1,246 @@
 #include "camera/camera_capture.h"
+#include "utils/latency_stats.h"
 #include "utils/timer.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <opencv2/opencv.hpp>
 
-int main() {
-    std::cout << "=== USB Camera Capture Test ===" << std::endl;
-    
-    CameraCapture camera;
-    Timer timer;
-    
-    // Initialize camera with optimal settings for VR (low latency)
-    // Try 120 FPS first, fall back to 60 if needed
-    if (!camera.Initialize("/dev/video0", 3200, 1200, 120)) {
-        std::cout << "120 FPS failed, trying 60 FPS..." << std::endl;
-        if (!camera.Initialize("/dev/video0", 3200, 1200, 60)) {
-            std::cerr << "Failed to initialize camera!" << std::endl;
-            return -1;
+// Camera pipeline throughput benchmark: sustained capture rate and per-frame capture wait, decode, conversion and
+// staging copy times, for each CameraCapture backend and decoder, over a fixed time.  The conversion and copy are the CPU work of
+// VRCameraApp::UploadCameraTextures; the GPU upload itself is in vr_camera_stream's own latency breakdown.
+// Without a camera, or with --synthetic, MJPEG frames encoded in memory are decoded instead, so the decode and the
+// CPU stages can be compared on any machine, on the CPU and on a V4L2 mem2mem JPEG decoder if there is one.
+// --record saves the frames of the V4L2 run, and --replay benchmarks such a recording instead of the camera, at the
+// recorded rate or, with --fast, as fast as it decodes, so runs without the camera can be compared like for like.
+//
+//     test_camera [--device /dev/video0] [--size 3200x1200] [--fps 60] [--seconds 10] [--synthetic]
+//                 [--record <file>] [--replay <file> [--fast]]
+
+namespace {
+
+struct BenchOptions {
+    std::string device = "/dev/video0";
+    int width = 3200;
+    int height = 1200;
+    int fps = 60;
+    double seconds = 10.0;
+    bool synthetic = false;
+    std::string record;  // Recording to write from the V4L2 run
+    std::string replay;  // Recording to replay instead of capturing
+    bool fast = false;   // Replay without keeping the recorded rate
+};
+
+struct BenchResult {
+    std::string name;
+    int width = 0;
+    int height = 0;
+    size_t frames = 0;
+    double seconds = 0;
+    LatencyStats stats{1000000};  // Keeps every frame of the run
+};
+
+void ShowHelp() {
+    std::cout << "test_camera [--device <path>] [--size <width>x<height>] [--fps <rate>] [--seconds <duration>] "
+                 "[--synthetic] [--record <file>] [--replay <file> [--fast]]" << std::endl;
+}
+
+bool ParseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--device" && hasValue) {
+            options.device = argv[++i];
+        } else if (arg == "--size" && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2) {
+                return false;
+            }
+        } else if (arg == "--fps" && hasValue) {
+            options.fps = atoi(argv[++i]);
+        } else if (arg == "--seconds" && hasValue) {
+            options.seconds = atof(argv[++i]);
+        } else if (arg == "--synthetic") {
+            options.synthetic = true;
+        } else if (arg == "--record" && hasValue) {
+            options.record = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            options.replay = argv[++i];
+        } else if (arg == "--fast") {
+            options.fast = true;
+        } else {
+            return false;
         }
     }
-    
-    std::cout << "Camera ready: " << camera.GetWidth() << "x" << camera.GetHeight() 
-              << " @ " << camera.GetFPS() << "fps" << std::endl;
-    
-    cv::Mat frame;
-    int frameCount = 0;
-    
-    std::cout << "Starting capture test (press ESC to stop)..." << std::endl;
-    
+    return options.width > 0 && options.height > 0 && options.fps > 0 && options.seconds > 0;
+}
+
+// The CPU work of VRCameraApp::UploadCameraTextures for both eye texture formats: padding BGR to BGRA for a BGRA eye
+// texture, and a plain row copy for a BGR one
+void StageFrame(const cv::Mat& frame, std::vector<uint8_t>& staging, LatencyStats& stats) {
+    staging.resize(static_cast<size_t>(frame.cols) * frame.rows * 4);
+
+    Timer timer;
     timer.Start();
-    
-    while (true) {
-        Timer frameTimer;
-        frameTimer.Start();
-        
-        // Capture frame
-        if (!camera.CaptureFrame(frame)) {
-            std::cerr << "Failed to capture frame!" << std::endl;
+    cv::Mat stagingFrame(frame.rows, frame.cols, CV_8UC4, staging.data());
+    cv::cvtColor(frame, stagingFrame, cv::COLOR_BGR2BGRA);
+    stats.Record(LatencyStage::ColorConvert, timer.GetElapsedMilliseconds());
+
+    timer.Start();
+    const size_t rowSize = static_cast<size_t>(frame.cols) * 3;
+    for (int row = 0; row < frame.rows; row++) {
+        memcpy(staging.data() + row * rowSize, frame.ptr(row), rowSize);
+    }
+    stats.Record(LatencyStage::StagingCopy, timer.GetElapsedMilliseconds());
+}
+
+// Capture from the camera, or the replayed recording, with one backend and decoder, saving the frames to
+// options.record if record is set; false if they cannot open the device
+bool BenchCamera(const BenchOptions& options, CameraCapture::Backend backend, CameraCapture::Decoder decoder,
+                 const char* name, bool record, std::vector<BenchResult>& results) {
+    const std::string& device = backend == CameraCapture::Backend::Replay ? options.replay : options.device;
+    CameraCapture camera;
+    camera.SetReplayRealtime(!options.fast);
+    if (!camera.Initialize(device, options.width, options.height, options.fps, backend, decoder)) {
+        std::cout << name << ": cannot open " << device << ", skipped" << std::endl;
+        return false;
+    }
+    if (record && !camera.StartRecording(options.record)) {
+        std::cerr << name << ": cannot record to " << options.record << std::endl;
+    }
+
+    results.emplace_back();
+    BenchResult& result = results.back();
+    result.name = name;
+    result.width = camera.GetWidth();
+    result.height = camera.GetHeight();
+
+    cv::Mat frame;
+    std::vector<uint8_t> staging;
+    Timer runTimer;
+    runTimer.Start();
+    while (runTimer.GetElapsedMilliseconds() < options.seconds * 1000.0) {
+        CameraCapture::FrameInfo info;
+        if (!camera.CaptureFrame(frame, &info)) {
+            std::cerr << name << ": failed to capture a frame" << std::endl;
             break;
         }
-        
-        frameTimer.Stop();
-        frameCount++;
-        
-        // Display frame (this will open a window)
-        cv::imshow("USB Camera Feed", frame);
-        
-        // Print timing info every 60 frames
-        if (frameCount % 60 == 0) {
-            timer.Stop();
-            double avgFPS = frameCount / timer.GetElapsedMilliseconds() * 1000.0;
-            std::cout << "Frame " << frameCount << " - Capture time: " 
-                      << frameTimer.GetElapsedMilliseconds() << "ms, Avg FPS: " 
-                      << avgFPS << std::endl;
+        result.stats.Record(LatencyStage::CaptureWait, info.waitMilliseconds);
+        result.stats.Record(LatencyStage::Decode, info.decodeMilliseconds);
+        StageFrame(frame, staging, result.stats);
+        result.stats.EndFrame();
+        result.frames++;
+    }
+    result.seconds = runTimer.GetElapsedMilliseconds() / 1000.0;
+    camera.Shutdown();
+    camera.StopRecording();
+    return true;
+}
+
+// Decode MJPEG frames encoded in memory as fast as possible, with the same staging work as a camera frame; on the
+// hardware decoder if given one
+void BenchSynthetic(const BenchOptions& options, V4L2JpegDecoder* decoder, std::vector<BenchResult>& results) {
+    // Blurred noise, which compresses about like a camera image; a few different frames, so caches do not flatter
+    // the decode
+    std::vector<std::vector<uint8_t>> jpegs(8);
+    for (size_t i = 0; i < jpegs.size(); i++) {
+        cv::Mat image(options.height, options.width, CV_8UC3);
+        cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+        cv::GaussianBlur(image, image, cv::Size(0, 0), 2.0 + static_cast<double>(i));
+        cv::imencode(".jpg", image, jpegs[i], {cv::IMWRITE_JPEG_QUALITY, 85});
+    }
+
+    results.emplace_back();
+    BenchResult& result = results.back();
+    result.name = decoder != nullptr ? "synth-m2m" : "synthetic";
+    result.width = options.width;
+    result.height = options.height;
+
+    cv::Mat frame;
+    std::vector<uint8_t> staging;
+    Timer runTimer;
+    runTimer.Start();
+    while (runTimer.GetElapsedMilliseconds() < options.seconds * 1000.0) {
+        const std::vector<uint8_t>& jpeg = jpegs[result.frames % jpegs.size()];
+        const cv::Mat encoded(1, static_cast<int>(jpeg.size()), CV_8UC1, const_cast<uint8_t*>(jpeg.data()));
+        Timer timer;
+        timer.Start();
+        if (decoder != nullptr) {
+            if (!decoder->Decode(jpeg.data(), jpeg.size(), frame)) {
+                std::cerr << result.name << ": failed to decode a frame" << std::endl;
+                break;
+            }
+        } else {
+            cv::imdecode(encoded, cv::IMREAD_COLOR, &frame);
         }
-        
-        // Check for ESC key
-        char key = cv::waitKey(1) & 0xFF;
-        if (key == 27) { // ESC key
-            break;
+        result.stats.Record(LatencyStage::Decode, timer.GetElapsedMilliseconds());
+        StageFrame(frame, staging, result.stats);
+        result.stats.EndFrame();
+        result.frames++;
+    }
+    result.seconds = runTimer.GetElapsedMilliseconds() / 1000.0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        ShowHelp();
+        return -1;
+    }
+
+    std::cout << "=== Camera Pipeline Benchmark ===" << std::endl;
+    std::vector<BenchResult> results;
+    using Backend = CameraCapture::Backend;
+    using Decoder = CameraCapture::Decoder;
+    if (!options.replay.empty()) {
+        if (!BenchCamera(options, Backend::Replay, Decoder::Software, "replay", false, results)) {
+            return -1;
+        }
+        BenchCamera(options, Backend::Replay, Decoder::V4L2M2M, "replay-m2m", false, results);
+    } else if (!options.synthetic) {
+        const bool record = !options.record.empty();
+        bool opened = BenchCamera(options, Backend::V4L2, Decoder::Software, "v4l2", record, results);
+        opened = BenchCamera(options, Backend::V4L2, Decoder::V4L2M2M, "v4l2-m2m", false, results) || opened;
+        if (!BenchCamera(options, Backend::OpenCV, Decoder::Software, "opencv", false, results) && !opened) {
+            std::cout << "No camera, benchmarking synthetic frames instead" << std::endl;
+            options.synthetic = true;
         }
     }
-    
-    timer.Stop();
-    double totalTime = timer.GetElapsedMilliseconds() / 1000.0;
-    double avgFPS = frameCount / totalTime;
-    
-    std::cout << "\n=== Test Results ===" << std::endl;
-    std::cout << "Frames captured: " << frameCount << std::endl;
-    std::cout << "Total time: " << totalTime << "s" << std::endl;
-    std::cout << "Average FPS: " << avgFPS << std::endl;
-    
-    cv::destroyAllWindows();
-    camera.Shutdown();
-    
+    if (options.synthetic) {
+        BenchSynthetic(options, nullptr, results);
+        V4L2JpegDecoder decoder;
+        if (decoder.Initialize(options.width, options.height)) {
+            BenchSynthetic(options, &decoder, results);
+        }
+    }
+
+    // One row per backend: the sustained rate, then p50/p95 per stage in milliseconds
+    std::cout << std::endl << "backend     size         frames     fps";
+    const LatencyStage stages[] = {LatencyStage::CaptureWait, LatencyStage::Decode, LatencyStage::ColorConvert,
+                                   LatencyStage::StagingCopy};
+    for (LatencyStage stage : stages) {
+        printf("  %13s", LatencyStats::GetStageName(stage));
+    }
+    std::cout << std::endl;
+    for (const BenchResult& result : results) {
+        const std::string size = std::to_string(result.width) + "x" + std::to_string(result.height);
+        printf("%-10s  %-11s  %6zu  %6.1f", result.name.c_str(), size.c_str(), result.frames,
+               result.seconds > 0 ? result.frames / result.seconds : 0.0);
+        for (LatencyStage stage : stages) {
+            const double p50 = result.stats.Percentile(stage, 50);
+            if (p50 < 0) {
+                printf("  %13s", "-");
+            } else {
+                printf("  %6.2f/%6.2f", p50, result.stats.Percentile(stage, 95));
+            }
+        }
+        printf("\n");
+    }
+
     return 0;
-}
\ No newline at end of file
+}
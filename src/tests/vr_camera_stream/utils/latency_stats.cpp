@@ -0,0 +1,98 @@
+#include "latency_stats.h"
+#include <algorithm>
+#include <cstdio>
+
+LatencyStats::LatencyStats(size_t window) : window_(window) {
+    current_.fill(-1.0);
+    for (Ring& ring : rings_) {
+        ring.samples.reserve(window_);
+    }
+}
+
+const char* LatencyStats::GetStageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::CaptureWait: return "capture_wait";
+        case LatencyStage::Decode: return "decode";
+        case LatencyStage::ColorConvert: return "color_convert";
+        case LatencyStage::StagingCopy: return "staging_copy";
+        case LatencyStage::GpuUpload: return "gpu_upload";
+        case LatencyStage::Render: return "render";
+        case LatencyStage::GpuRender: return "gpu_render";
+        case LatencyStage::EndFrame: return "end_frame";
+        case LatencyStage::FrameAge: return "frame_age";
+        default: return "unknown";
+    }
+}
+
+void LatencyStats::Record(LatencyStage stage, double milliseconds) {
+    current_[static_cast<size_t>(stage)] = milliseconds;
+}
+
+void LatencyStats::EndFrame() {
+    for (size_t stage = 0; stage < kStageCount; stage++) {
+        if (current_[stage] < 0.0) {
+            continue;
+        }
+        Ring& ring = rings_[stage];
+        if (ring.samples.size() < window_) {
+            ring.samples.push_back(current_[stage]);
+        } else {
+            ring.samples[ring.next] = current_[stage];
+            ring.next = (ring.next + 1) % window_;
+        }
+    }
+    
+    if (csv_.is_open()) {
+        csv_ << frameCount_;
+        for (double milliseconds : current_) {
+            csv_ << ',';
+            if (milliseconds >= 0.0) {
+                csv_ << milliseconds;
+            }
+        }
+        csv_ << '\n';
+    }
+    
+    current_.fill(-1.0);
+    frameCount_++;
+}
+
+bool LatencyStats::OpenCsv(const std::string& path) {
+    csv_.open(path);
+    if (!csv_.is_open()) {
+        return false;
+    }
+    csv_ << "frame";
+    for (size_t stage = 0; stage < kStageCount; stage++) {
+        csv_ << ',' << GetStageName(static_cast<LatencyStage>(stage)) << "_ms";
+    }
+    csv_ << '\n';
+    return true;
+}
+
+double LatencyStats::Percentile(LatencyStage stage, double percentile) const {
+    std::vector<double> sorted = rings_[static_cast<size_t>(stage)].samples;
+    if (sorted.empty()) {
+        return -1.0;
+    }
+    // Nearest rank
+    size_t rank = static_cast<size_t>(percentile / 100.0 * static_cast<double>(sorted.size()));
+    rank = std::min(rank, sorted.size() - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(rank), sorted.end());
+    return sorted[rank];
+}
+
+std::string LatencyStats::Summary() const {
+    std::string summary;
+    char line[128];
+    for (size_t stage = 0; stage < kStageCount; stage++) {
+        const LatencyStage latencyStage = static_cast<LatencyStage>(stage);
+        if (rings_[stage].samples.empty()) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "  %-13s p50=%6.2fms p95=%6.2fms p99=%6.2fms\n", GetStageName(latencyStage),
+                 Percentile(latencyStage, 50.0), Percentile(latencyStage, 95.0), Percentile(latencyStage, 99.0));
+        summary += line;
+    }
+    return summary;
+}
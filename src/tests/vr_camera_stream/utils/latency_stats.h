@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Stages of the camera-to-display pipeline, each measured once per rendered frame
+enum class LatencyStage {
+    CaptureWait,   // Waiting for the camera driver to deliver the frame (capture thread)
+    Decode,        // MJPEG decode (capture thread)
+    ColorConvert,  // BGR to BGRA padding into the staging buffer, when the eye texture needs it
+    StagingCopy,   // memcpy into the staging buffer, when the eye texture is BGR
+    GpuUpload,     // Buffer-to-image copy on the GPU (timestamp queries)
+    Render,        // CPU time to locate views and render both eyes
+    GpuRender,     // Both eye blits on the GPU (timestamp queries)
+    EndFrame,      // xrEndFrame
+    FrameAge,      // Camera capture time to predicted display time, when the capture time is known
+    Count
+};
+
+// Rolling per-stage latency statistics over the last frames, with an optional CSV row per frame.
+// A stage that did not run in a frame (e.g. no new camera frame) is left out of its statistics.
+class LatencyStats {
+public:
+    explicit LatencyStats(size_t window = 600);
+    
+    // Record a stage duration for the current frame
+    void Record(LatencyStage stage, double milliseconds);
+    // Complete the current frame: add its stages to the statistics and write its CSV row
+    void EndFrame();
+    
+    // Write a row per frame from now on, with an empty field for each stage that did not run
+    bool OpenCsv(const std::string& path);
+    
+    // Percentile (0-100) of a stage over the window, or a negative value when it has no samples
+    double Percentile(LatencyStage stage, double percentile) const;
+    // One line per stage with its p50/p95/p99 in milliseconds
+    std::string Summary() const;
+    
+    size_t GetFrameCount() const { return frameCount_; }
+    static const char* GetStageName(LatencyStage stage);
+    
+private:
+    static constexpr size_t kStageCount = static_cast<size_t>(LatencyStage::Count);
+    
+    struct Ring {
+        std::vector<double> samples;
+        size_t next = 0;  // Where the next sample goes once samples is full
+    };
+    
+    size_t window_;
+    size_t frameCount_ = 0;
+    std::array<Ring, kStageCount> rings_;
+    std::array<double, kStageCount> current_;  // Negative for the stages not recorded this frame
+    std::ofstream csv_;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// The last poses of the head, pushed by one thread, the frame loop, and read by another, the telemetry thread,
+// without locks: neither side ever waits for the other.  Every field is a relaxed atomic, which is a plain load or
+// store on the CPUs this runs on, and the count of poses pushed publishes them.
+//
+// A reader that falls more than kCapacity poses behind a pose finds it overwritten and gets false back.
+class PoseHistory {
+public:
+    static constexpr size_t kCapacity = 64;
+
+    struct Sample {
+        XrPosef pose{{0, 0, 0, 1}, {0, 0, 0}};
+        XrTime time = 0;
+    };
+
+    // Writer only
+    void Push(const XrPosef& pose, XrTime time) {
+        const uint64_t index = count_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[index % kCapacity];
+        slot.index.store(index, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);  // Orders the index before the pose, for ReadLatest
+        const float values[kPoseFloats] = {pose.orientation.x, pose.orientation.y, pose.orientation.z,
+                                           pose.orientation.w, pose.position.x,    pose.position.y,
+                                           pose.position.z};
+        for (size_t i = 0; i < kPoseFloats; i++) {
+            slot.pose[i].store(values[i], std::memory_order_relaxed);
+        }
+        slot.time.store(time, std::memory_order_relaxed);
+        count_.store(index + 1, std::memory_order_release);
+    }
+
+    // The number of poses pushed so far
+    uint64_t GetCount() const { return count_.load(std::memory_order_acquire); }
+
+    // Read the newest pose; false if none was pushed, or if it was overwritten while being read
+    bool ReadLatest(Sample& sample) const {
+        const uint64_t count = GetCount();
+        if (count == 0) {
+            return false;
+        }
+        const Slot& slot = slots_[(count - 1) % kCapacity];
+        float values[kPoseFloats];
+        for (size_t i = 0; i < kPoseFloats; i++) {
+            values[i] = slot.pose[i].load(std::memory_order_relaxed);
+        }
+        sample.time = slot.time.load(std::memory_order_relaxed);
+        // The writer's next lap through this slot changes its index first; loads after the fence see that if it did
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.index.load(std::memory_order_relaxed) != count - 1 || GetCount() - (count - 1) >= kCapacity) {
+            return false;
+        }
+        sample.pose.orientation = {values[0], values[1], values[2], values[3]};
+        sample.pose.position = {values[4], values[5], values[6]};
+        return true;
+    }
+
+private:
+    static constexpr size_t kPoseFloats = 7;
+
+    struct Slot {
+        std::atomic<uint64_t> index{0};  // Of the pose in the slot
+        std::array<std::atomic<float>, kPoseFloats> pose{};
+        std::atomic<XrTime> time{0};
+    };
+
+    std::array<Slot, kCapacity> slots_{};
+    std::atomic<uint64_t> count_{0};
+};
@@ -0,0 +1,131 @@
+#include "thread_policy.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+bool ThreadPolicy::Parse(const std::string& text, ThreadPolicy& policy) {
+    ThreadPolicy parsed;
+    const size_t at = text.find('@');
+    const std::string scheduling = text.substr(0, at);
+    if (!scheduling.empty()) {
+        const size_t colon = scheduling.find(':');
+        if (colon == std::string::npos) {
+            return false;
+        }
+        const std::string name = scheduling.substr(0, colon);
+        if (name == "fifo") {
+            parsed.scheduler = Scheduler::Fifo;
+        } else if (name == "rr") {
+            parsed.scheduler = Scheduler::RoundRobin;
+        } else {
+            return false;
+        }
+        char* end = nullptr;
+        const long priority = strtol(scheduling.c_str() + colon + 1, &end, 10);
+        if (end == scheduling.c_str() + colon + 1 || *end != '\0' || priority < 1 || priority > 99) {
+            return false;
+        }
+        parsed.priority = static_cast<int>(priority);
+    }
+    
+    if (at != std::string::npos) {
+        const std::string list = text.substr(at + 1);
+        for (size_t begin = 0; begin <= list.size();) {
+            size_t end = list.find(',', begin);
+            end = end == std::string::npos ? list.size() : end;
+            const std::string range = list.substr(begin, end - begin);
+            begin = end + 1;
+            
+            char* rangeEnd = nullptr;
+            const long first = strtol(range.c_str(), &rangeEnd, 10);
+            long last = first;
+            if (rangeEnd != range.c_str() && *rangeEnd == '-') {
+                const char* lastBegin = rangeEnd + 1;
+                last = strtol(lastBegin, &rangeEnd, 10);
+                if (rangeEnd == lastBegin) {
+                    return false;
+                }
+            }
+            if (rangeEnd == range.c_str() || *rangeEnd != '\0' || first < 0 || last < first || last >= CPU_SETSIZE) {
+                return false;
+            }
+            for (long cpu = first; cpu <= last; cpu++) {
+                parsed.cpus.push_back(static_cast<int>(cpu));
+            }
+        }
+    }
+    policy = parsed;
+    return true;
+}
+
+std::string ThreadPolicy::ToString() const {
+    std::string text;
+    switch (scheduler) {
+        case Scheduler::Inherit:
+            text = "inherited scheduling";
+            break;
+        case Scheduler::Fifo:
+            text = "SCHED_FIFO " + std::to_string(priority);
+            break;
+        case Scheduler::RoundRobin:
+            text = "SCHED_RR " + std::to_string(priority);
+            break;
+    }
+    if (!cpus.empty()) {
+        text += " on CPU";
+        for (size_t i = 0; i < cpus.size(); i++) {
+            text += (i == 0 ? " " : ",") + std::to_string(cpus[i]);
+        }
+    }
+    return text;
+}
+
+ThreadPolicy::Result ThreadPolicy::Apply(const std::string& threadName) const {
+    Result result;
+    if (scheduler != Scheduler::Inherit) {
+        sched_param param{};
+        param.sched_priority = priority;
+        const int error = pthread_setschedparam(pthread_self(), scheduler == Scheduler::Fifo ? SCHED_FIFO : SCHED_RR, &param);
+        result.scheduled = error == 0;
+        if (!result.scheduled) {
+            std::cerr << "Cannot schedule the " << threadName << " thread " << (scheduler == Scheduler::Fifo ? "SCHED_FIFO " : "SCHED_RR ")
+                      << priority << ": " << strerror(error) << std::endl;
+        }
+    }
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            CPU_SET(cpu, &set);
+        }
+        const int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        result.pinned = error == 0;
+        if (!result.pinned) {
+            std::cerr << "Cannot pin the " << threadName << " thread: " << strerror(error) << std::endl;
+        }
+    }
+    if (!IsDefault()) {
+        std::cout << "The " << threadName << " thread runs " << ToString() << ": scheduling "
+                  << (result.scheduled ? "applied" : "NOT applied") << ", affinity " << (result.pinned ? "applied" : "NOT applied")
+                  << std::endl;
+    }
+    return result;
+}
+
+bool LockProcessMemory() {
+    rlimit limit{};
+    const bool unlimited = (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY) || geteuid() == 0;
+    if (mlockall(unlimited ? MCL_CURRENT | MCL_FUTURE : MCL_CURRENT) != 0) {
+        std::cerr << "Cannot lock the process memory, raise RLIMIT_MEMLOCK: " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::cout << "Locked the process memory" << (unlimited ? ", and what it allocates from now on" : ", but not later allocations")
+              << std::endl;
+    return true;
+}
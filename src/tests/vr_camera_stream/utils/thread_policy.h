@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// How a thread is scheduled: a real-time scheduling policy and priority, and the CPUs it may run on.  The default
+// leaves both as the thread inherited them.
+struct ThreadPolicy {
+    enum class Scheduler { Inherit, Fifo, RoundRobin };
+    Scheduler scheduler = Scheduler::Inherit;
+    int priority = 0;       // 1 to 99 for Fifo and RoundRobin
+    std::vector<int> cpus;  // Empty leaves the affinity alone
+    
+    // What Apply managed to set; a part the policy leaves alone counts as applied
+    struct Result {
+        bool scheduled = true;
+        bool pinned = true;
+    };
+    
+    // Parse "<fifo|rr>:<priority>@<cpu>,<cpu>-<cpu>...", where either part may be left out, e.g. "fifo:80",
+    // "@2,3" or "rr:60@4-7".  Returns false, leaving policy as it was, on anything else.
+    static bool Parse(const std::string& text, ThreadPolicy& policy);
+    
+    bool IsDefault() const { return scheduler == Scheduler::Inherit && cpus.empty(); }
+    std::string ToString() const;
+    
+    // Apply to the calling thread, logging what was and was not applied for threadName.  Real-time scheduling needs
+    // CAP_SYS_NICE or an RLIMIT_RTPRIO at least priority; without it the thread keeps running as it did.
+    Result Apply(const std::string& threadName) const;
+};
+
+// Lock the pages of the process into memory, so that the capture buffers and the rest of the frame path never page
+// fault on a swapped-out or reclaimed page.  Later allocations are locked too when RLIMIT_MEMLOCK is unlimited or the
+// process may ignore it, as with a finite limit they would fail once it is reached.  Logs and returns whether the
+// current pages were locked.
+bool LockProcessMemory();
@@ -1,4 +1,6 @@
 #include "vr_camera_app.h"
+#include <common/allocation_counter.h>
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 #include <cassert>
@@ -6,12 +8,43 @@
 #include <chrono>
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 // Vulkan validation layers for debugging
 const std::vector<const char*> validationLayers = {
     "VK_LAYER_KHRONOS_validation"
 };
 
+// glslangValidator doesn't wrap its output in brackets if you don't have it define the whole array.
+#if defined(USE_GLSLANGVALIDATOR)
+#define SPV_PREFIX {
+#define SPV_SUFFIX }
+#else
+#define SPV_PREFIX
+#define SPV_SUFFIX
+#endif
+
+// Whether all of names are among extensions
+static bool HasExtensions(const std::vector<VkExtensionProperties>& extensions, const std::vector<const char*>& names) {
+    for (const char* name : names) {
+        if (std::none_of(extensions.begin(), extensions.end(),
+                         [name](const VkExtensionProperties& extension) { return strcmp(extension.extensionName, name) == 0; })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The push constants of undistort_frag.glsl
+struct UndistortPushConstants {
+    float offset[2];  // Of the camera eye in the layer, in pixels
+    float size[2];
+    float eye;        // The layer of the camera and remap textures
+};
+
 VRCameraApp::VRCameraApp() {
     camera_ = std::make_unique<CameraCapture>();
     
@@ -32,12 +65,30 @@ bool VRCameraApp::Initialize() {
     LogMessage("=== Initializing VR Camera Application ===");
     
     // Step 1: Initialize camera first (we know this works)
+    // VR_CAMERA_REPLAY replays a recording made with VR_CAMERA_RECORD instead, at its rate unless VR_CAMERA_REPLAY_FAST=1,
+    // so runs can be compared without the camera.  A replay keeps the recorded mode.
     LogMessage("Step 1: Initializing camera...");
-    if (!camera_->Initialize("/dev/video0", 3200, 1200, 60)) {
+    const char* replayPath = getenv("VR_CAMERA_REPLAY");
+    const bool replay = replayPath != nullptr && replayPath[0] != '\0';
+    if (replay) {
+        const char* replayFast = getenv("VR_CAMERA_REPLAY_FAST");
+        camera_->SetReplayRealtime(replayFast == nullptr || strcmp(replayFast, "1") != 0);
+    }
+    if (!camera_->Initialize(replay ? replayPath : "/dev/video0", 3200, 1200, 60,
+                             replay ? CameraCapture::Backend::Replay : CameraCapture::Backend::Any)) {
         LogMessage("ERROR: Failed to initialize camera!");
         return false;
     }
     LogMessage("✓ Camera initialized successfully");
+    if (!replay) {
+        cameraModes_ = CameraCapture::EnumerateModes(camera_->GetDevicePath());
+        LogMessage("Camera reports " + std::to_string(cameraModes_.size()) + " MJPEG modes");
+    }
+    const char* recordPath = getenv("VR_CAMERA_RECORD");
+    if (recordPath != nullptr && recordPath[0] != '\0' && !replay && !camera_->StartRecording(recordPath)) {
+        LogMessage("WARNING: Failed to start recording the camera to " + std::string(recordPath));
+    }
+    InitializeExtraCameras();
     
     // Step 2: Create OpenXR instance with Vulkan support
     LogMessage("Step 2: Creating OpenXR instance...");
@@ -121,13 +172,34 @@ bool VRCameraApp::CreateInstance() {
         return false;
     }
     
+    if (timespecConversionSupported_) {
+        xrGetInstanceProcAddr(instance_, "xrConvertTimespecTimeToTimeKHR",
+                              reinterpret_cast<PFN_xrVoidFunction*>(&xrConvertTimespecTimeToTimeKHR_));
+    }
+    if (xrConvertTimespecTimeToTimeKHR_ == nullptr) {
+        LogMessage("WARNING: XR_KHR_convert_timespec_time unavailable, camera frames are not pose compensated");
+    }
+    
     return true;
 }
 
 std::vector<const char*> VRCameraApp::GetRequiredExtensions() {
-    return {
+    std::vector<const char*> extensions = {
         XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME  // This is what hello_xr uses successfully
     };
+    
+    // Optional: convert camera capture timestamps to XrTime, for pose compensation
+    uint32_t extensionCount = 0;
+    xrEnumerateInstanceExtensionProperties(nullptr, 0, &extensionCount, nullptr);
+    std::vector<XrExtensionProperties> properties(extensionCount, {XR_TYPE_EXTENSION_PROPERTIES});
+    xrEnumerateInstanceExtensionProperties(nullptr, extensionCount, &extensionCount, properties.data());
+    for (const XrExtensionProperties& property : properties) {
+        if (strcmp(property.extensionName, XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME) == 0) {
+            extensions.push_back(XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME);
+            timespecConversionSupported_ = true;
+        }
+    }
+    return extensions;
 }
 
 bool VRCameraApp::CreateSystem() {
@@ -185,9 +257,29 @@ bool VRCameraApp::InitializeVulkan() {
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.apiVersion = VK_API_VERSION_1_0;
 
+    // A spectator stream exports memory as DMA-BUFs, which Vulkan 1.0 has in extensions
+    const char* spectator = getenv("VR_CAMERA_SPECTATOR");
+    spectatorAddress_ = spectator != nullptr ? spectator : "";
+    std::vector<const char*> instanceExtensions;
+    if (!spectatorAddress_.empty()) {
+        instanceExtensions = {VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
+                              VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME};
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+        if (!HasExtensions(extensions, instanceExtensions)) {
+            LogMessage("WARNING: Vulkan cannot export memory, ignoring VR_CAMERA_SPECTATOR");
+            spectatorAddress_.clear();
+            instanceExtensions.clear();
+        }
+    }
+    
     VkInstanceCreateInfo instInfo{};
     instInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     instInfo.pApplicationInfo = &appInfo;
+    instInfo.enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size());
+    instInfo.ppEnabledExtensionNames = instanceExtensions.empty() ? nullptr : instanceExtensions.data();
     
     XrVulkanInstanceCreateInfoKHR createInfo{XR_TYPE_VULKAN_INSTANCE_CREATE_INFO_KHR};
     createInfo.systemId = systemId_;
@@ -260,6 +352,19 @@ bool VRCameraApp::InitializeVulkan() {
     queueInfo.pQueuePriorities = &queuePriorities;
     
     std::vector<const char*> deviceExtensions;
+    if (!spectatorAddress_.empty()) {
+        deviceExtensions = {VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME, VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME,
+                            VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME};
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(vkPhysicalDevice_, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(vkPhysicalDevice_, nullptr, &extensionCount, extensions.data());
+        if (!HasExtensions(extensions, deviceExtensions)) {
+            LogMessage("WARNING: The Vulkan device cannot export DMA-BUFs, ignoring VR_CAMERA_SPECTATOR");
+            spectatorAddress_.clear();
+            deviceExtensions.clear();
+        }
+    }
     VkPhysicalDeviceFeatures features{};
     
     VkDeviceCreateInfo deviceInfo{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
@@ -281,6 +386,10 @@ bool VRCameraApp::InitializeVulkan() {
     }
     LogMessage("✓ Vulkan logical device created via OpenXR");
     
+    if (!spectatorAddress_.empty()) {
+        vkGetMemoryFdKHR_ = reinterpret_cast<PFN_vkGetMemoryFdKHR>(vkGetDeviceProcAddr(vkDevice_, "vkGetMemoryFdKHR"));
+    }
+    
     // Get the queue
     vkGetDeviceQueue(vkDevice_, queueFamilyIndex, 0, &vkQueue_);
     queueFamilyIndex_ = queueFamilyIndex;
@@ -371,50 +480,86 @@ bool VRCameraApp::CreateSwapchains() {
     }
     LogMessage("✓ Selected swapchain format: " + std::to_string(colorSwapchainFormat));
     
-    // Create swapchains for each eye
-    swapchains_.resize(viewCount);
+    // Create one swapchain with a layer per eye, so a frame acquires, waits on and releases one image for both eyes.
+    // The layers share a size, the largest the views recommend, or the camera eye size with VR_CAMERA_NATIVE_SWAPCHAIN.
+    XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+    swapchainCreateInfo.arraySize = viewCount;
+    swapchainCreateInfo.format = colorSwapchainFormat;
+    swapchainCreateInfo.mipCount = 1;
+    swapchainCreateInfo.faceCount = 1;
+    swapchainCreateInfo.sampleCount = configViews_[0].recommendedSwapchainSampleCount;
+    // The camera eyes are blitted or copied into the images
+    swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT |
+                                     XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
     for (uint32_t i = 0; i < viewCount; i++) {
-        XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
-        swapchainCreateInfo.arraySize = 1;
-        swapchainCreateInfo.format = colorSwapchainFormat;
-        swapchainCreateInfo.width = configViews_[i].recommendedImageRectWidth;
-        swapchainCreateInfo.height = configViews_[i].recommendedImageRectHeight;
-        swapchainCreateInfo.mipCount = 1;
-        swapchainCreateInfo.faceCount = 1;
-        swapchainCreateInfo.sampleCount = configViews_[i].recommendedSwapchainSampleCount;
-        swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
-        
-        result = xrCreateSwapchain(session_, &swapchainCreateInfo, &swapchains_[i].handle);
-        if (XR_FAILED(result)) {
-            LogMessage("ERROR: Failed to create swapchain " + std::to_string(i));
-            return false;
-        }
-        
-        swapchains_[i].width = swapchainCreateInfo.width;
-        swapchains_[i].height = swapchainCreateInfo.height;
-        
-        // Get swapchain images
-        uint32_t imageCount;
-        result = xrEnumerateSwapchainImages(swapchains_[i].handle, 0, &imageCount, nullptr);
-        if (XR_FAILED(result)) {
-            LogMessage("ERROR: Failed to enumerate swapchain images!");
-            return false;
-        }
-        
-        swapchains_[i].images.resize(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_VULKAN2_KHR});
-        result = xrEnumerateSwapchainImages(swapchains_[i].handle, imageCount, &imageCount,
-                                          reinterpret_cast<XrSwapchainImageBaseHeader*>(swapchains_[i].images.data()));
-        if (XR_FAILED(result)) {
-            LogMessage("ERROR: Failed to get swapchain images!");
-            return false;
-        }
-        
-        LogMessage("✓ Swapchain " + std::to_string(i) + " created: " + 
-                   std::to_string(swapchains_[i].width) + "x" + std::to_string(swapchains_[i].height) +
-                   " with " + std::to_string(imageCount) + " images");
+        swapchainCreateInfo.width = std::max(swapchainCreateInfo.width, configViews_[i].recommendedImageRectWidth);
+        swapchainCreateInfo.height = std::max(swapchainCreateInfo.height, configViews_[i].recommendedImageRectHeight);
+    }
+    
+    const char* nativeSwapchain = getenv("VR_CAMERA_NATIVE_SWAPCHAIN");
+    nativeSwapchain_ = nativeSwapchain != nullptr && strcmp(nativeSwapchain, "1") == 0;
+    const char* quadLayer = getenv("VR_CAMERA_QUAD_LAYER");
+    quadLayerMode_ = quadLayer != nullptr && strcmp(quadLayer, "1") == 0;
+    const uint32_t cameraEyeWidth = static_cast<uint32_t>(camera_->GetWidth() / 2);
+    const uint32_t cameraEyeHeight = static_cast<uint32_t>(camera_->GetHeight());
+    if (quadLayerMode_ && cameraEyeWidth > 0 && cameraEyeHeight > 0) {
+        // The compositor scales the quads, so they can be any size, but they keep the angular size of the projection
+        layerFovScaleX_ = static_cast<float>(cameraEyeWidth) / static_cast<float>(swapchainCreateInfo.width);
+        layerFovScaleY_ = static_cast<float>(cameraEyeHeight) / static_cast<float>(swapchainCreateInfo.height);
+        swapchainCreateInfo.width = cameraEyeWidth;
+        swapchainCreateInfo.height = cameraEyeHeight;
+        LogMessage("Showing the camera on quad layers instead of a projection layer");
+    } else if (nativeSwapchain_ && cameraEyeWidth > 0 && cameraEyeHeight > 0 && cameraEyeWidth <= swapchainCreateInfo.width &&
+               cameraEyeHeight <= swapchainCreateInfo.height) {
+        layerFovScaleX_ = static_cast<float>(cameraEyeWidth) / static_cast<float>(swapchainCreateInfo.width);
+        layerFovScaleY_ = static_cast<float>(cameraEyeHeight) / static_cast<float>(swapchainCreateInfo.height);
+        swapchainCreateInfo.width = cameraEyeWidth;
+        swapchainCreateInfo.height = cameraEyeHeight;
+        LogMessage("Sizing the swapchain to the camera eye resolution");
+    } else if (nativeSwapchain_) {
+        LogMessage("WARNING: The camera eye is larger than the recommended view, keeping the recommended swapchain size");
+        nativeSwapchain_ = false;
+    }
+    quadLayerMode_ = quadLayerMode_ && swapchainCreateInfo.width == cameraEyeWidth;  // Not without a camera size
+    
+    // Copying the staging buffer straight into the swapchain needs an image the size of a camera eye
+    const char* directUpload = getenv("VR_CAMERA_DIRECT_UPLOAD");
+    directUpload_ = directUpload != nullptr && strcmp(directUpload, "1") == 0;
+    if (directUpload_ && (swapchainCreateInfo.width != cameraEyeWidth || swapchainCreateInfo.height != cameraEyeHeight)) {
+        LogMessage("WARNING: VR_CAMERA_DIRECT_UPLOAD needs VR_CAMERA_NATIVE_SWAPCHAIN or VR_CAMERA_QUAD_LAYER, ignoring it");
+        directUpload_ = false;
+    }
+    swapchainFormat_ = static_cast<VkFormat>(colorSwapchainFormat);
+    
+    result = xrCreateSwapchain(session_, &swapchainCreateInfo, &swapchain_.handle);
+    if (XR_FAILED(result)) {
+        LogMessage("ERROR: Failed to create swapchain");
+        return false;
     }
     
-    return true;
+    swapchain_.width = swapchainCreateInfo.width;
+    swapchain_.height = swapchainCreateInfo.height;
+    
+    // Get swapchain images
+    uint32_t imageCount;
+    result = xrEnumerateSwapchainImages(swapchain_.handle, 0, &imageCount, nullptr);
+    if (XR_FAILED(result)) {
+        LogMessage("ERROR: Failed to enumerate swapchain images!");
+        return false;
+    }
+    
+    swapchain_.images.resize(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_VULKAN2_KHR});
+    result = xrEnumerateSwapchainImages(swapchain_.handle, imageCount, &imageCount,
+                                      reinterpret_cast<XrSwapchainImageBaseHeader*>(swapchain_.images.data()));
+    if (XR_FAILED(result)) {
+        LogMessage("ERROR: Failed to get swapchain images!");
+        return false;
+    }
+    
+    LogMessage("✓ Swapchain created: " + std::to_string(swapchain_.width) + "x" + std::to_string(swapchain_.height) +
+               " with " + std::to_string(viewCount) + " layers and " + std::to_string(imageCount) + " images");
+    
+    return CreateExtraCameraSwapchains();
 }
 
 bool VRCameraApp::CreateSpaces() {
@@ -429,11 +574,19 @@ bool VRCameraApp::CreateSpaces() {
         return false;
     }
     
+    // Create head space, located in app space to get the head orientation at any time
+    createInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
+    result = xrCreateReferenceSpace(session_, &createInfo, &headSpace_);
+    if (XR_FAILED(result)) {
+        LogMessage("ERROR: Failed to create view reference space!");
+        return false;
+    }
+    
     return true;
 }
 
 bool VRCameraApp::CreateVulkanResources() {
-    // Create command pool and command buffer
+    // Create command pool
     VkCommandPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
@@ -444,48 +597,138 @@ bool VRCameraApp::CreateVulkanResources() {
         return false;
     }
     
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool_;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = 1;
+    // Create command buffers and fences for the frames in flight
+    if (!CreateFrameSlots()) {
+        return false;
+    }
     
-    if (vkAllocateCommandBuffers(vkDevice_, &allocInfo, &commandBuffer_) != VK_SUCCESS) {
-        LogMessage("ERROR: Failed to allocate command buffer!");
+    // Each eye is half of the side-by-side camera frame
+    eyeWidth_ = static_cast<uint32_t>(camera_->GetWidth() / 2);
+    eyeHeight_ = static_cast<uint32_t>(camera_->GetHeight());
+    
+    // Pick the eye texture format the staging buffer is laid out in.  Direct uploads lay it out like the swapchain,
+    // which all the selectable formats can be: 4 bytes per pixel, RGBA or BGRA.
+    const char* mappedTexture = getenv("VR_CAMERA_MAPPED_TEXTURE");
+    mappedTexture_ = mappedTexture != nullptr && strcmp(mappedTexture, "1") == 0;
+    if (mappedTexture_ && directUpload_) {
+        LogMessage("WARNING: VR_CAMERA_MAPPED_TEXTURE does not apply to VR_CAMERA_DIRECT_UPLOAD, ignoring it");
+        mappedTexture_ = false;
+    }
+    if (directUpload_) {
+        eyeTextureFormat_ = swapchainFormat_;
+        eyeTextureBytesPerPixel_ = 4;
+        LogMessage("Copying camera frames straight into the swapchain images");
+    } else if (!SelectEyeTextureFormat()) {
+        return false;
+    }
+    
+    // Undistort and rectify in a fragment shader with a calibration; direct uploads have no texture to sample, and the
+    // shader samples one texture for every frame, not one per upload slot
+    const char* calibrationPath = getenv("VR_CAMERA_CALIBRATION");
+    if (calibrationPath != nullptr && calibrationPath[0] != '\0') {
+        if (directUpload_ || mappedTexture_) {
+            LogMessage(std::string("WARNING: VR_CAMERA_CALIBRATION does not apply to ") +
+                       (directUpload_ ? "VR_CAMERA_DIRECT_UPLOAD" : "VR_CAMERA_MAPPED_TEXTURE") + ", ignoring it");
+        } else if (calibration_.Load(calibrationPath)) {
+            undistort_ = true;
+            LogMessage("Undistorting the camera with the calibration in " + std::string(calibrationPath));
+        } else {
+            LogMessage("WARNING: Failed to load the camera calibration, showing the camera as captured");
+        }
+    }
+    
+    // Create staging buffers, command buffers and fences for camera texture uploads
+    if (!CreateUploadRing() || !CreateExtraCameraStaging()) {
         return false;
     }
     
-    // Create staging buffer for camera texture uploads
-    if (!CreateStagingBuffer()) {
+    // Create textures for camera frames, unless they are copied straight into the swapchain or blitted from the slots
+    if (!directUpload_ && !mappedTexture_ && !CreateEyeTextures()) {
+        return false;
+    }
+    if (undistort_ && (!CreateRemapTexture() || !CreateRenderPipeline() || !CreateDescriptorSets())) {
         return false;
     }
     
-    // Create textures for camera frames
-    if (!CreateEyeTextures()) {
+    // Create timestamp queries for the GPU stages of the latency breakdown
+    if (!CreateTimestampQueries()) {
         return false;
     }
     
+    // Stream the view to a spectator, unless the encoder or the memory export is missing
+    if (!spectatorAddress_.empty() && !CreateSpectatorStream()) {
+        DestroySpectatorStream();
+        spectatorAddress_.clear();
+    }
+    
     LogMessage("✓ Vulkan resources created successfully");
     return true;
 }
 
-bool VRCameraApp::CreateStagingBuffer() {
-    // Create staging buffer large enough for one eye frame (1600x1200x4 bytes for RGBA)
-    VkDeviceSize bufferSize = 1600 * 1200 * 4;
+bool VRCameraApp::SelectEyeTextureFormat() {
+    // Prefer a 3-byte BGR format, so the decoded frame is uploaded without any conversion on the CPU. Few devices can
+    // copy to and blit from it, so fall back to BGRA.
+    const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_TRANSFER_DST_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+                                          VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    VkFormatProperties properties{};
+    vkGetPhysicalDeviceFormatProperties(vkPhysicalDevice_, VK_FORMAT_B8G8R8_SRGB, &properties);
+    if ((properties.optimalTilingFeatures & required) == required) {
+        eyeTextureFormat_ = VK_FORMAT_B8G8R8_SRGB;
+        eyeTextureBytesPerPixel_ = 3;
+    } else {
+        eyeTextureFormat_ = VK_FORMAT_B8G8R8A8_SRGB;
+        eyeTextureBytesPerPixel_ = 4;
+    }
+    
+    // A mapped texture is blitted from with linear tiling, which fewer formats support
+    if (mappedTexture_) {
+        const VkFormat formats[] = {VK_FORMAT_B8G8R8_SRGB, VK_FORMAT_B8G8R8A8_SRGB};
+        mappedTexture_ = false;
+        for (VkFormat format : formats) {
+            vkGetPhysicalDeviceFormatProperties(vkPhysicalDevice_, format, &properties);
+            VkImageFormatProperties imageProperties{};
+            if ((properties.linearTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) != 0 &&
+                vkGetPhysicalDeviceImageFormatProperties(vkPhysicalDevice_, format, VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_LINEAR,
+                                                         VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 0, &imageProperties) == VK_SUCCESS &&
+                imageProperties.maxExtent.width >= eyeWidth_ * 2 && imageProperties.maxExtent.height >= eyeHeight_) {
+                eyeTextureFormat_ = format;
+                eyeTextureBytesPerPixel_ = format == VK_FORMAT_B8G8R8_SRGB ? 3 : 4;
+                mappedTexture_ = true;
+                break;
+            }
+        }
+        if (!mappedTexture_) {
+            LogMessage("WARNING: No eye texture format can be blitted from with linear tiling, ignoring VR_CAMERA_MAPPED_TEXTURE");
+        }
+    }
+    LogMessage("Eye texture format: " + std::string(eyeTextureBytesPerPixel_ == 3 ? "B8G8R8_SRGB" : "B8G8R8A8_SRGB"));
+    return true;
+}
+
+bool VRCameraApp::CreateStagingBuffer(UploadSlot& slot) {
+    if (mappedTexture_) {
+        return CreateMappedTexture(slot);
+    }
     
+    // Create staging buffer large enough for the whole side-by-side stereo frame in the eye texture format
+    slot.rowPitch = static_cast<VkDeviceSize>(eyeWidth_) * 2 * eyeTextureBytesPerPixel_;
+    return AllocateStagingBuffer(slot, slot.rowPitch * eyeHeight_);
+}
+
+bool VRCameraApp::AllocateStagingBuffer(UploadSlot& slot, VkDeviceSize bufferSize) {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = bufferSize;
     bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     
-    if (vkCreateBuffer(vkDevice_, &bufferInfo, nullptr, &stagingBuffer_) != VK_SUCCESS) {
+    if (vkCreateBuffer(vkDevice_, &bufferInfo, nullptr, &slot.stagingBuffer) != VK_SUCCESS) {
         LogMessage("ERROR: Failed to create staging buffer!");
         return false;
     }
     
     VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(vkDevice_, stagingBuffer_, &memRequirements);
+    vkGetBufferMemoryRequirements(vkDevice_, slot.stagingBuffer, &memRequirements);
     
     uint32_t memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, 
                                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
@@ -497,20 +740,189 @@ bool VRCameraApp::CreateStagingBuffer() {
     VkMemoryAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = memoryTypeIndex;    if (vkAllocateMemory(vkDevice_, &allocInfo, nullptr, &stagingBufferMemory_) != VK_SUCCESS) {
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+    if (vkAllocateMemory(vkDevice_, &allocInfo, nullptr, &slot.stagingMemory) != VK_SUCCESS) {
         LogMessage("ERROR: Failed to allocate staging buffer memory!");
         return false;
     }
     
-    vkBindBufferMemory(vkDevice_, stagingBuffer_, stagingBufferMemory_, 0);
+    vkBindBufferMemory(vkDevice_, slot.stagingBuffer, slot.stagingMemory, 0);
     
     // Map staging buffer memory
-    vkMapMemory(vkDevice_, stagingBufferMemory_, 0, bufferSize, 0, &stagingBufferMapped_);
+    vkMapMemory(vkDevice_, slot.stagingMemory, 0, bufferSize, 0, &slot.stagingMapped);
+    
+    return true;
+}
+
+bool VRCameraApp::CreateMappedTexture(UploadSlot& slot) {
+    // Both eyes side by side in one layer, as linear images may have only one
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = eyeWidth_ * 2;
+    imageInfo.extent.height = eyeHeight_;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = eyeTextureFormat_;
+    imageInfo.tiling = VK_IMAGE_TILING_LINEAR;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(vkDevice_, &imageInfo, nullptr, &slot.mappedImage) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to create mapped camera texture");
+        return false;
+    }
+    
+    // Coherent, so the frame loop's submit makes the CPU's writes visible without a flush
+    const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(vkDevice_, slot.mappedImage, &memRequirements);
+    const uint32_t memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(vkPhysicalDevice_, &memProperties);
+    if (memoryTypeIndex == UINT32_MAX ||
+        (memProperties.memoryTypes[memoryTypeIndex].propertyFlags & properties) != properties) {
+        LogMessage("ERROR: No device local, host visible memory for VR_CAMERA_MAPPED_TEXTURE");
+        return false;
+    }
+    
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+    if (vkAllocateMemory(vkDevice_, &allocInfo, nullptr, &slot.stagingMemory) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to allocate mapped camera texture memory!");
+        return false;
+    }
+    vkBindImageMemory(vkDevice_, slot.mappedImage, slot.stagingMemory, 0);
+    
+    // The rows may be padded
+    VkImageSubresource subresource{VK_IMAGE_ASPECT_COLOR_BIT, 0, 0};
+    VkSubresourceLayout layout{};
+    vkGetImageSubresourceLayout(vkDevice_, slot.mappedImage, &subresource, &layout);
+    void* mapped = nullptr;
+    if (vkMapMemory(vkDevice_, slot.stagingMemory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to map camera texture memory!");
+        return false;
+    }
+    slot.stagingMapped = static_cast<uint8_t*>(mapped) + layout.offset;
+    slot.rowPitch = layout.rowPitch;
+    
+    // The general layout, which the CPU may write in, for good; the blit reads it in that layout too
+    VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = slot.mappedImage;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        0, 0, nullptr, 0, nullptr, 1, &barrier);
+    EndSingleTimeCommands(commandBuffer);
+    return true;
+}
+
+bool VRCameraApp::CreateUploadRing() {
+    // Each slot is reused only after its fence shows the GPU finished the upload that last used it
+    for (UploadSlot& slot : uploadSlots_) {
+        if (!CreateStagingBuffer(slot)) {
+            return false;
+        }
+        
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = commandPool_;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(vkDevice_, &allocInfo, &slot.commandBuffer) != VK_SUCCESS) {
+            LogMessage("ERROR: Failed to allocate upload command buffer!");
+            return false;
+        }
+        
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;  // Nothing to wait for before the first upload
+        if (vkCreateFence(vkDevice_, &fenceInfo, nullptr, &slot.fence) != VK_SUCCESS) {
+            LogMessage("ERROR: Failed to create upload fence!");
+            return false;
+        }
+    }
     
-    LogMessage("✓ Staging buffer created and mapped");
+    LogMessage("✓ Upload ring of " + std::to_string(uploadSlots_.size()) +
+               (mappedTexture_ ? " linear device local textures" : " staging buffers") + " created and mapped");
+    return true;
+}
+
+bool VRCameraApp::CreateFrameSlots() {
+    for (FrameSlot& frame : frameSlots_) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = commandPool_;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(vkDevice_, &allocInfo, &frame.commandBuffer) != VK_SUCCESS) {
+            LogMessage("ERROR: Failed to allocate command buffer!");
+            return false;
+        }
+        
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;  // Nothing to wait for before the first frame
+        if (vkCreateFence(vkDevice_, &fenceInfo, nullptr, &frame.fence) != VK_SUCCESS) {
+            LogMessage("ERROR: Failed to create frame fence!");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VRCameraApp::CreateTimestampQueries() {
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(vkPhysicalDevice_, &properties);
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(vkPhysicalDevice_, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(vkPhysicalDevice_, &queueFamilyCount, queueFamilies.data());
+    
+    // Not an error: the latency breakdown just has no GPU stages
+    const uint32_t validBits = queueFamilyIndex_ < queueFamilyCount ? queueFamilies[queueFamilyIndex_].timestampValidBits : 0;
+    if (validBits == 0 || properties.limits.timestampPeriod == 0.0f) {
+        LogMessage("WARNING: Queue has no timestamps, GPU latency is not measured");
+        return true;
+    }
+    timestampPeriodNs_ = properties.limits.timestampPeriod;
+    timestampMask_ = validBits >= 64 ? UINT64_MAX : (uint64_t{1} << validBits) - 1;
+    
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = GetRenderQueryIndex(kFramesInFlight);
+    if (vkCreateQueryPool(vkDevice_, &poolInfo, nullptr, &timestampQueryPool_) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to create timestamp query pool!");
+        return false;
+    }
     return true;
 }
 
+double VRCameraApp::ReadTimestampMilliseconds(uint32_t firstQuery) {
+    if (timestampQueryPool_ == VK_NULL_HANDLE) {
+        return -1.0;
+    }
+    std::array<uint64_t, 2> timestamps{};
+    if (vkGetQueryPoolResults(vkDevice_, timestampQueryPool_, firstQuery, 2, sizeof(timestamps), timestamps.data(),
+                              sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+        return -1.0;
+    }
+    return static_cast<double>((timestamps[1] - timestamps[0]) & timestampMask_) * timestampPeriodNs_ / 1e6;
+}
+
 VkCommandBuffer VRCameraApp::BeginSingleTimeCommands() {
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -545,61 +957,449 @@ void VRCameraApp::EndSingleTimeCommands(VkCommandBuffer commandBuffer) {
 }
 
 bool VRCameraApp::CreateEyeTextures() {
-    // Create textures for left and right eye (1600x1200 each)
+    // Create one texture array for both eyes, each half of the camera frame: layer 0 is the left eye, layer 1 the right
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = eyeWidth_;  // Half of camera width
+    imageInfo.extent.height = eyeHeight_;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 2;
+    imageInfo.format = eyeTextureFormat_;  // BGR like the decoded frame; the blit converts to the swapchain format
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    
+    if (vkCreateImage(vkDevice_, &imageInfo, nullptr, &cameraTexture_.image) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to create camera texture");
+        return false;
+    }
+    
+    VkMemoryRequirements imgMemRequirements;
+    vkGetImageMemoryRequirements(vkDevice_, cameraTexture_.image, &imgMemRequirements);
+    
+    LogMessage("Image memory requirements: size=" + std::to_string(imgMemRequirements.size) + 
+              ", alignment=" + std::to_string(imgMemRequirements.alignment) +
+              ", memoryTypeBits=" + std::to_string(imgMemRequirements.memoryTypeBits));
+    
+    uint32_t imgMemoryTypeIndex = FindMemoryType(imgMemRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (imgMemoryTypeIndex == UINT32_MAX) {
+        LogMessage("ERROR: Failed to find suitable memory type for camera texture");
+        return false;
+    }
+    
+    VkMemoryAllocateInfo imgAllocInfo{};
+    imgAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    imgAllocInfo.allocationSize = imgMemRequirements.size;
+    imgAllocInfo.memoryTypeIndex = imgMemoryTypeIndex;
+    
+    LogMessage("Attempting allocation: size=" + std::to_string(imgAllocInfo.allocationSize) + 
+              ", memoryTypeIndex=" + std::to_string(imgAllocInfo.memoryTypeIndex));
+    
+    VkResult allocResult = vkAllocateMemory(vkDevice_, &imgAllocInfo, nullptr, &cameraTexture_.memory);
+    if (allocResult != VK_SUCCESS) {
+        LogMessage("ERROR: vkAllocateMemory failed with result: " + std::to_string(allocResult));
+        LogMessage("ERROR: Failed to allocate camera texture memory");
+        return false;
+    }
+    
+    vkBindImageMemory(vkDevice_, cameraTexture_.image, cameraTexture_.memory, 0);
+    
+    // The undistortion shader samples it; the blit does not need a view
+    if (undistort_ && !CreateTextureView(cameraTexture_, eyeTextureFormat_)) {
+        return false;
+    }
+    
+    LogMessage("✓ Camera texture " + std::to_string(eyeWidth_) + "x" + std::to_string(eyeHeight_) + "x2 created");
+    
+    return true;
+}
+
+bool VRCameraApp::CreateTextureView(EyeTexture& texture, VkFormat format) {
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = texture.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    viewInfo.format = format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 2;
+    if (vkCreateImageView(vkDevice_, &viewInfo, nullptr, &texture.imageView) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to create texture image view!");
+        return false;
+    }
+    
+    // The shader masks out what falls outside the texture, so the edge mode does not matter
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+    if (vkCreateSampler(vkDevice_, &samplerInfo, nullptr, &texture.sampler) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to create texture sampler!");
+        return false;
+    }
+    return true;
+}
+
+bool VRCameraApp::CreateRemapTexture() {
+    // Layer 0 is the left eye's offsets and layer 1 the right eye's, like the camera texture
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = eyeWidth_;
+    imageInfo.extent.height = eyeHeight_;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 2;
+    imageInfo.format = VK_FORMAT_R16G16_SFLOAT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(vkDevice_, &imageInfo, nullptr, &remapTexture_.image) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to create remap texture");
+        return false;
+    }
+    
+    VkMemoryRequirements imageRequirements;
+    vkGetImageMemoryRequirements(vkDevice_, remapTexture_.image, &imageRequirements);
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = imageRequirements.size;
+    allocInfo.memoryTypeIndex = FindMemoryType(imageRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (allocInfo.memoryTypeIndex == UINT32_MAX ||
+        vkAllocateMemory(vkDevice_, &allocInfo, nullptr, &remapTexture_.memory) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to allocate remap texture memory");
+        return false;
+    }
+    vkBindImageMemory(vkDevice_, remapTexture_.image, remapTexture_.memory, 0);
+    
+    // Uploaded once, through a staging buffer of its own that is freed right after
+    const VkDeviceSize eyeSize = static_cast<VkDeviceSize>(eyeWidth_) * eyeHeight_ * 2 * sizeof(uint16_t);
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = eyeSize * 2;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+    if (vkCreateBuffer(vkDevice_, &bufferInfo, nullptr, &stagingBuffer) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to create remap staging buffer!");
+        return false;
+    }
+    VkMemoryRequirements bufferRequirements;
+    vkGetBufferMemoryRequirements(vkDevice_, stagingBuffer, &bufferRequirements);
+    allocInfo.allocationSize = bufferRequirements.size;
+    allocInfo.memoryTypeIndex = FindMemoryType(bufferRequirements.memoryTypeBits,
+                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    void* mapped = nullptr;
+    if (allocInfo.memoryTypeIndex == UINT32_MAX ||
+        vkAllocateMemory(vkDevice_, &allocInfo, nullptr, &stagingMemory) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to allocate remap staging buffer memory!");
+        vkDestroyBuffer(vkDevice_, stagingBuffer, nullptr);
+        return false;
+    }
+    vkBindBufferMemory(vkDevice_, stagingBuffer, stagingMemory, 0);
+    vkMapMemory(vkDevice_, stagingMemory, 0, bufferInfo.size, 0, &mapped);
+    
+    Timer timer;
+    timer.Start();
     for (int eye = 0; eye < 2; eye++) {
-        VkImageCreateInfo imageInfo{};
-        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        imageInfo.imageType = VK_IMAGE_TYPE_2D;
-        imageInfo.extent.width = 1600;  // Half of camera width
-        imageInfo.extent.height = 1200;
-        imageInfo.extent.depth = 1;
-        imageInfo.mipLevels = 1;
-        imageInfo.arrayLayers = 1;
-        imageInfo.format = VK_FORMAT_R8G8B8A8_SRGB;  // Use same format as swapchain
-        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        
-        if (vkCreateImage(vkDevice_, &imageInfo, nullptr, &eyeTextures_[eye].image) != VK_SUCCESS) {
-            LogMessage("ERROR: Failed to create eye texture " + std::to_string(eye));
+        const cv::Mat offsets = calibration_.ComputeRemapOffsets(eye, static_cast<int>(eyeWidth_), static_cast<int>(eyeHeight_));
+        memcpy(static_cast<uint8_t*>(mapped) + eye * eyeSize, offsets.data, static_cast<size_t>(eyeSize));
+    }
+    vkUnmapMemory(vkDevice_, stagingMemory);
+    LogMessage("Computed the remap of both eyes in " + std::to_string(timer.GetElapsedMilliseconds()) + " ms");
+    
+    VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = remapTexture_.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 2;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        0, 0, nullptr, 0, nullptr, 1, &barrier);
+    
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 2;
+    region.imageExtent = {eyeWidth_, eyeHeight_, 1};
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, remapTexture_.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                           &region);
+    
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                        0, 0, nullptr, 0, nullptr, 1, &barrier);
+    EndSingleTimeCommands(commandBuffer);  // Waits for the copy
+    
+    vkDestroyBuffer(vkDevice_, stagingBuffer, nullptr);
+    vkFreeMemory(vkDevice_, stagingMemory, nullptr);
+    
+    if (!CreateTextureView(remapTexture_, VK_FORMAT_R16G16_SFLOAT)) {
+        return false;
+    }
+    LogMessage("✓ Remap texture " + std::to_string(eyeWidth_) + "x" + std::to_string(eyeHeight_) + "x2 created");
+    return true;
+}
+
+bool VRCameraApp::CreateRenderPipeline() {
+    // The draw covers every pixel of the eye's layer, and leaves it in the layout the blit leaves it in
+    VkAttachmentDescription attachment{};
+    attachment.format = swapchainFormat_;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    
+    VkAttachmentReference colorReference{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorReference;
+    
+    // After the runtime is done reading the image, which it signals before xrWaitSwapchainImage returns
+    VkSubpassDependency dependency{};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = 0;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &attachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies = &dependency;
+    if (vkCreateRenderPass(vkDevice_, &renderPassInfo, nullptr, &renderPass_) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to create render pass!");
+        return false;
+    }
+    
+    // The camera texture at binding 0 and the remap texture at binding 1, as in undistort_frag.glsl
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    for (uint32_t binding = 0; binding < bindings.size(); binding++) {
+        bindings[binding].binding = binding;
+        bindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[binding].descriptorCount = 1;
+        bindings[binding].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    setLayoutInfo.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(vkDevice_, &setLayoutInfo, nullptr, &descriptorSetLayout_) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to create descriptor set layout!");
+        return false;
+    }
+    
+    VkPushConstantRange pushConstantRange{VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(UndistortPushConstants)};
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout_;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(vkDevice_, &pipelineLayoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to create pipeline layout!");
+        return false;
+    }
+    
+    const std::vector<uint32_t> vertexSpirv = SPV_PREFIX
+#include "undistort_vert.spv"
+        SPV_SUFFIX;
+    const std::vector<uint32_t> fragmentSpirv = SPV_PREFIX
+#include "undistort_frag.spv"
+        SPV_SUFFIX;
+    std::array<VkShaderModule, 2> modules{};
+    std::array<VkPipelineShaderStageCreateInfo, 2> stages{};
+    const std::array<const std::vector<uint32_t>*, 2> spirv = {&vertexSpirv, &fragmentSpirv};
+    for (size_t i = 0; i < stages.size(); i++) {
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = spirv[i]->size() * sizeof(uint32_t);
+        moduleInfo.pCode = spirv[i]->data();
+        if (vkCreateShaderModule(vkDevice_, &moduleInfo, nullptr, &modules[i]) != VK_SUCCESS) {
+            LogMessage("ERROR: Failed to create shader module!");
+            for (VkShaderModule module : modules) {
+                vkDestroyShaderModule(vkDevice_, module, nullptr);
+            }
             return false;
         }
-        
-        VkMemoryRequirements imgMemRequirements;
-        vkGetImageMemoryRequirements(vkDevice_, eyeTextures_[eye].image, &imgMemRequirements);
-        
-        LogMessage("Image memory requirements: size=" + std::to_string(imgMemRequirements.size) + 
-                  ", alignment=" + std::to_string(imgMemRequirements.alignment) +
-                  ", memoryTypeBits=" + std::to_string(imgMemRequirements.memoryTypeBits));
-        
-        uint32_t imgMemoryTypeIndex = FindMemoryType(imgMemRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        if (imgMemoryTypeIndex == UINT32_MAX) {
-            LogMessage("ERROR: Failed to find suitable memory type for eye texture " + std::to_string(eye));
+        stages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[i].stage = i == 0 ? VK_SHADER_STAGE_VERTEX_BIT : VK_SHADER_STAGE_FRAGMENT_BIT;
+        stages[i].module = modules[i];
+        stages[i].pName = "main";
+    }
+    
+    // No vertex buffer: undistort_vert.glsl makes one triangle over the whole layer from the vertex index
+    VkPipelineVertexInputStateCreateInfo vertexInput{};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    
+    const VkViewport viewport{0.0f, 0.0f, static_cast<float>(swapchain_.width), static_cast<float>(swapchain_.height),
+                              0.0f, 1.0f};
+    const VkRect2D scissor{{0, 0}, {static_cast<uint32_t>(swapchain_.width), static_cast<uint32_t>(swapchain_.height)}};
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.pViewports = &viewport;
+    viewportState.scissorCount = 1;
+    viewportState.pScissors = &scissor;
+    
+    VkPipelineRasterizationStateCreateInfo rasterization{};
+    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = VK_CULL_MODE_NONE;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+    
+    VkPipelineMultisampleStateCreateInfo multisample{};
+    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    
+    VkPipelineColorBlendAttachmentState blendAttachment{};
+    blendAttachment.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo colorBlend{};
+    colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlend.attachmentCount = 1;
+    colorBlend.pAttachments = &blendAttachment;
+    
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = static_cast<uint32_t>(stages.size());
+    pipelineInfo.pStages = stages.data();
+    pipelineInfo.pVertexInputState = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterization;
+    pipelineInfo.pMultisampleState = &multisample;
+    pipelineInfo.pColorBlendState = &colorBlend;
+    pipelineInfo.layout = pipelineLayout_;
+    pipelineInfo.renderPass = renderPass_;
+    pipelineInfo.subpass = 0;
+    const VkResult pipelineResult =
+        vkCreateGraphicsPipelines(vkDevice_, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline_);
+    for (VkShaderModule module : modules) {
+        vkDestroyShaderModule(vkDevice_, module, nullptr);
+    }
+    if (pipelineResult != VK_SUCCESS) {
+        LogMessage("ERROR: Failed to create undistortion pipeline!");
+        return false;
+    }
+    
+    // A framebuffer for each eye's layer of each swapchain image
+    framebuffers_.resize(swapchain_.images.size());
+    for (size_t image = 0; image < swapchain_.images.size(); image++) {
+        for (uint32_t eye = 0; eye < 2; eye++) {
+            LayerFramebuffer& layer = framebuffers_[image][eye];
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = swapchain_.images[image].image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = swapchainFormat_;
+            viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            viewInfo.subresourceRange.baseMipLevel = 0;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.baseArrayLayer = eye;
+            viewInfo.subresourceRange.layerCount = 1;
+            if (vkCreateImageView(vkDevice_, &viewInfo, nullptr, &layer.imageView) != VK_SUCCESS) {
+                LogMessage("ERROR: Failed to create swapchain image view!");
+                return false;
+            }
+            
+            VkFramebufferCreateInfo framebufferInfo{};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = renderPass_;
+            framebufferInfo.attachmentCount = 1;
+            framebufferInfo.pAttachments = &layer.imageView;
+            framebufferInfo.width = static_cast<uint32_t>(swapchain_.width);
+            framebufferInfo.height = static_cast<uint32_t>(swapchain_.height);
+            framebufferInfo.layers = 1;
+            if (vkCreateFramebuffer(vkDevice_, &framebufferInfo, nullptr, &layer.framebuffer) != VK_SUCCESS) {
+                LogMessage("ERROR: Failed to create framebuffer!");
+                return false;
+            }
+        }
+    }
+    
+    LogMessage("✓ Undistortion pipeline created");
+    return true;
+}
+
+bool VRCameraApp::CreateDescriptorSets() {
+    if (descriptorPool_ == VK_NULL_HANDLE) {
+        VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2};
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = 1;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        if (vkCreateDescriptorPool(vkDevice_, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS) {
+            LogMessage("ERROR: Failed to create descriptor pool!");
             return false;
         }
         
-        VkMemoryAllocateInfo imgAllocInfo{};
-        imgAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        imgAllocInfo.allocationSize = imgMemRequirements.size;
-        imgAllocInfo.memoryTypeIndex = imgMemoryTypeIndex;
-        
-        LogMessage("Attempting allocation: size=" + std::to_string(imgAllocInfo.allocationSize) + 
-                  ", memoryTypeIndex=" + std::to_string(imgAllocInfo.memoryTypeIndex));
-        
-        VkResult allocResult = vkAllocateMemory(vkDevice_, &imgAllocInfo, nullptr, &eyeTextures_[eye].memory);
-        if (allocResult != VK_SUCCESS) {
-            LogMessage("ERROR: vkAllocateMemory failed with result: " + std::to_string(allocResult));
-            LogMessage("ERROR: Failed to allocate eye texture memory " + std::to_string(eye));
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool_;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &descriptorSetLayout_;
+        if (vkAllocateDescriptorSets(vkDevice_, &allocInfo, &descriptorSet_) != VK_SUCCESS) {
+            LogMessage("ERROR: Failed to allocate descriptor set!");
             return false;
         }
-        
-        vkBindImageMemory(vkDevice_, eyeTextures_[eye].image, eyeTextures_[eye].memory, 0);
-        
-        LogMessage("✓ Eye texture " + std::to_string(eye) + " created");
     }
     
+    // Point the set at the current textures; the GPU is idle whenever they are recreated
+    const std::array<VkDescriptorImageInfo, 2> imageInfos = {{
+        {cameraTexture_.sampler, cameraTexture_.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+        {remapTexture_.sampler, remapTexture_.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+    }};
+    std::array<VkWriteDescriptorSet, 2> writes{};
+    for (uint32_t binding = 0; binding < writes.size(); binding++) {
+        writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].dstSet = descriptorSet_;
+        writes[binding].dstBinding = binding;
+        writes[binding].descriptorCount = 1;
+        writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[binding].pImageInfo = &imageInfos[binding];
+    }
+    vkUpdateDescriptorSets(vkDevice_, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
     return true;
 }
 
@@ -659,14 +1459,25 @@ void VRCameraApp::QuaternionToRPY(const XrQuaternionf& q, float& roll, float& pi
     yaw = atan2f(siny_cosp, cosy_cosp);
 }
 
-void VRCameraApp::LogHeadsetRPY() {
-    if (views_.empty()) return;
-    
-    // Use the center eye view (average of left and right)
-    // For simplicity, we'll just use the left eye view
-    const XrPosef& headPose = views_[0].pose;
-    
-    float roll, pitch, yaw;
+void VRCameraApp::TelemetryThread() {
+    // Below the frame loop and the capture thread, which must not wait behind the formatting and the console
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+    
+    uint64_t loggedCount = 0;
+    while (telemetryRunning_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kTelemetryPeriodMs));
+        PoseHistory::Sample sample;
+        const uint64_t count = poseHistory_.GetCount();
+        if (count != loggedCount && poseHistory_.ReadLatest(sample)) {
+            LogHeadsetRPY(sample.pose);
+            loggedCount = count;
+        }
+    }
+}
+
+void VRCameraApp::LogHeadsetRPY(const XrPosef& headPose) {
+    // The left eye view, for simplicity, rather than the center of the eyes
+    float roll, pitch, yaw;
     QuaternionToRPY(headPose.orientation, roll, pitch, yaw);
     
     // Convert radians to degrees for display
@@ -676,113 +1487,651 @@ void VRCameraApp::LogHeadsetRPY() {
     
     // Compact format with 1 decimal precision for faster reading
     char buffer[256];
-    sprintf(buffer, "RPY: R=%.1f° P=%.1f° Y=%.1f°", rollDeg, pitchDeg, yawDeg);
-    LogMessage(buffer);
+    snprintf(buffer, sizeof(buffer), "RPY: R=%.1f° P=%.1f° Y=%.1f°", rollDeg, pitchDeg, yawDeg);
+    // Straight to the stream rather than through LogMessage, which would allocate a string every few frames
+    std::cout << "[VRCameraApp] " << buffer << std::endl;
+}
+
+bool VRCameraApp::LocateHeadOrientation(XrTime time, XrQuaternionf& orientation) {
+    XrSpaceLocation location{XR_TYPE_SPACE_LOCATION};
+    if (XR_FAILED(xrLocateSpace(headSpace_, appSpace_, time, &location)) ||
+        (location.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) == 0) {
+        return false;
+    }
+    orientation = location.pose.orientation;
+    return true;
+}
+
+bool VRCameraApp::SelectCameraMode(int maxWidth, int maxHeight) {
+    CameraCapture::Mode mode;
+    if (!CameraCapture::SelectMode(cameraModes_, maxWidth, maxHeight, displayRate_, mode)) {
+        return true;  // Nothing smaller, or the device does not list its modes: keep the current one
+    }
+    const bool resized = mode.width != camera_->GetWidth() || mode.height != camera_->GetHeight();
+    if (resized && (nativeSwapchain_ || quadLayerMode_)) {
+        return true;  // The swapchain is sized by the camera and would have to be recreated too
+    }
+    if (!resized && mode.fps == camera_->GetFPS()) {
+        return true;
+    }
+    return ReconfigureCamera(mode);
 }
 
-void VRCameraApp::UpdateCamera() {
-    if (!camera_->CaptureFrame(cameraFrame_)) {
-        if (frameCount_ % 60 == 0) { // Log every 60 frames to avoid spam
-            LogMessage("WARNING: Failed to capture camera frame");
+bool VRCameraApp::ReconfigureCamera(const CameraCapture::Mode& mode) {
+    LogMessage("Switching the camera to " + std::to_string(mode.width) + "x" + std::to_string(mode.height) + " @ " +
+               std::to_string(mode.fps) + "fps for a " + std::to_string(displayRate_) + " Hz display");
+    const CameraCapture::Mode previous{camera_->GetWidth(), camera_->GetHeight(), camera_->GetFPS()};
+    const std::string devicePath = camera_->GetDevicePath();
+    camera_->Shutdown();
+    if (!camera_->Initialize(devicePath, mode.width, mode.height, mode.fps)) {
+        LogMessage("WARNING: Failed to switch the camera mode, restoring the previous one");
+        if (!camera_->Initialize(devicePath, previous.width, previous.height, previous.fps)) {
+            LogMessage("ERROR: Failed to restore the camera!");
+            return false;
         }
-        return;
     }
     
-    // Split stereo frame: left half and right half
-    int width = cameraFrame_.cols / 2;  // 1600 pixels
-    int height = cameraFrame_.rows;     // 1200 pixels
+    // Recreate the upload ring and eye texture at the new size, once the GPU is done with the old ones
+    const uint32_t eyeWidth = static_cast<uint32_t>(camera_->GetWidth() / 2);
+    const uint32_t eyeHeight = static_cast<uint32_t>(camera_->GetHeight());
+    if (eyeWidth != eyeWidth_ || eyeHeight != eyeHeight_) {
+        vkDeviceWaitIdle(vkDevice_);
+        DestroyCameraResources();
+        eyeWidth_ = eyeWidth;
+        eyeHeight_ = eyeHeight;
+        if (!CreateUploadRing() || (!directUpload_ && !mappedTexture_ && !CreateEyeTextures())) {
+            return false;
+        }
+        if (undistort_ && (!CreateRemapTexture() || !CreateDescriptorSets())) {
+            return false;
+        }
+    }
     
-    leftEyeFrame_ = cameraFrame_(cv::Rect(0, 0, width, height));        // Left 1600x1200
-    rightEyeFrame_ = cameraFrame_(cv::Rect(width, 0, width, height));   // Right 1600x1200
+    modeChangeCameraFrame_ = frameCount_;
+    if (!camera_->StartCaptureThread()) {
+        LogMessage("ERROR: Failed to restart camera capture thread!");
+        return false;
+    }
+    return true;
+}
+
+bool VRCameraApp::UpdateCamera() {
+    // Take the newest frame from the capture thread; keep showing the previous one if none is ready yet
+    CameraCapture::FrameInfo info;
+    if (!camera_->AcquireLatestFrame(cameraFrame_, &info)) {
+        return false;
+    }
     
     frameCount_++;
+    if (cameraSequence_ != 0 && info.sequence > cameraSequence_ + 1) {
+        frameCounters_.dropped += info.sequence - cameraSequence_ - 1;
+    }
+    cameraSequence_ = info.sequence;
+    latencyStats_.Record(LatencyStage::CaptureWait, info.waitMilliseconds);
+    latencyStats_.Record(LatencyStage::Decode, info.decodeMilliseconds);
+    
+    // Locate the head when the frame was captured, while the runtime still has the pose history for that time
+    if (xrConvertTimespecTimeToTimeKHR_ == nullptr ||
+        XR_FAILED(xrConvertTimespecTimeToTimeKHR_(instance_, &info.captureTime, &cameraTime_))) {
+        cameraTime_ = 0;
+    }
+    cameraOrientationValid_ = cameraTime_ != 0 && LocateHeadOrientation(cameraTime_, cameraOrientation_);
     
     // Debug log every 60 frames for camera info
     if (frameCount_ % 60 == 0) {
         // LogMessage("Camera frame " + std::to_string(frameCount_) + ": " + 
         //           std::to_string(cameraFrame_.cols) + "x" + std::to_string(cameraFrame_.rows));
     }
+    return true;
+}
+
+bool VRCameraApp::UploadCameraTextures() {
+    // The staging buffer holds the whole side-by-side stereo frame in the eye texture format, and each eye is copied
+    // from its half to its layer.  The GPU converts from BGR to the swapchain format in the blit.
+    // A frame already uploaded is still in the eye texture, or in the newest staging buffer, so it is not copied again.
+    if (cameraSequence_ == uploadedSequence_) {
+        return false;
+    }
+    if (cameraFrame_.cols != static_cast<int>(eyeWidth_ * 2) || cameraFrame_.rows != static_cast<int>(eyeHeight_) ||
+        cameraFrame_.type() != CV_8UC3) {
+        return false;
+    }
+    
+    // Wait until the GPU is done with the oldest slot, normally long ago, instead of for the whole queue
+    const uint32_t queryIndex = static_cast<uint32_t>(uploadSlotIndex_) * 2;
+    UploadSlot& slot = uploadSlots_[uploadSlotIndex_];
+    uploadSlotIndex_ = (uploadSlotIndex_ + 1) % uploadSlots_.size();
+    vkWaitForFences(vkDevice_, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+    if (slot.readerFence != VK_NULL_HANDLE) {
+        // Also for the last frame that copied from the slot to the swapchain
+        vkWaitForFences(vkDevice_, 1, &slot.readerFence, VK_TRUE, UINT64_MAX);
+        slot.readerFence = VK_NULL_HANDLE;
+    }
+    
+    // The slot's last upload is done, so its GPU time is known; it is counted in this frame's breakdown
+    if (slot.timestampsWritten) {
+        const double uploadMilliseconds = ReadTimestampMilliseconds(queryIndex);
+        if (uploadMilliseconds >= 0.0) {
+            latencyStats_.Record(LatencyStage::GpuUpload, uploadMilliseconds);
+        }
+        slot.timestampsWritten = false;
+    }
     
-    // Log headset orientation every 5 frames for very fast updates
-    if (frameCount_ % 5 == 0) {
-        LogHeadsetRPY();
+    Timer stageTimer;
+    stageTimer.Start();
+    if (eyeTextureBytesPerPixel_ == 3) {
+        // Same layout as the decoded frame: a plain copy, no conversion on the CPU
+        const size_t rowSize = static_cast<size_t>(cameraFrame_.cols) * 3;
+        for (int row = 0; row < cameraFrame_.rows; row++) {
+            memcpy(static_cast<uint8_t*>(slot.stagingMapped) + row * slot.rowPitch, cameraFrame_.ptr(row), rowSize);
+        }
+        latencyStats_.Record(LatencyStage::StagingCopy, stageTimer.GetElapsedMilliseconds());
+    } else {
+        // Pads BGR to BGRA, or for a direct upload to an RGBA swapchain also swaps red and blue
+        const bool rgba = eyeTextureFormat_ == VK_FORMAT_R8G8B8A8_SRGB || eyeTextureFormat_ == VK_FORMAT_R8G8B8A8_UNORM;
+        cv::Mat stagingFrame(cameraFrame_.rows, cameraFrame_.cols, CV_8UC4, slot.stagingMapped,
+                             static_cast<size_t>(slot.rowPitch));
+        cv::cvtColor(cameraFrame_, stagingFrame, rgba ? cv::COLOR_BGR2RGBA : cv::COLOR_BGR2BGRA);
+        latencyStats_.Record(LatencyStage::ColorConvert, stageTimer.GetElapsedMilliseconds());
+    }
+    
+    // Each frame's render copies or blits the newest slot into its swapchain image itself, so there is nothing to submit
+    if (directUpload_ || mappedTexture_) {
+        latestUploadSlot_ = static_cast<size_t>(&slot - uploadSlots_.data());
+        uploadedSequence_ = cameraSequence_;
+        return true;
+    }
+    
+    // Upload both eyes with one submission
+    vkResetFences(vkDevice_, 1, &slot.fence);
+    VkCommandBuffer commandBuffer = slot.commandBuffer;
+    vkResetCommandBuffer(commandBuffer, 0);
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    
+    if (timestampQueryPool_ != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(commandBuffer, timestampQueryPool_, queryIndex, 2);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool_, queryIndex);
     }
+    
+    // Transition both layers to transfer destination, after the blit or draw of the previous frame that read them.
+    // The blit ends with a barrier to the fragment shader stage, and the draw reads them in it, which this one waits for.
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = cameraTexture_.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 2;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        0, 0, nullptr, 0, nullptr, 1, &barrier);
+    
+    // One copy for both eyes: bufferRowLength is the full frame width, so each region picks its half of every row
+    std::array<VkBufferImageCopy, 2> regions{};
+    for (uint32_t eye = 0; eye < 2; eye++) {
+        VkBufferImageCopy& region = regions[eye];
+        region.bufferOffset = static_cast<VkDeviceSize>(eye) * eyeWidth_ * eyeTextureBytesPerPixel_;
+        region.bufferRowLength = eyeWidth_ * 2;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = eye;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {eyeWidth_, eyeHeight_, 1};
+    }
+    
+    vkCmdCopyBufferToImage(commandBuffer, slot.stagingBuffer, cameraTexture_.image,
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+    
+    // Transition both layers to shader read optimal
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                        0, 0, nullptr, 0, nullptr, 1, &barrier);
+    
+    if (timestampQueryPool_ != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, timestampQueryPool_, queryIndex + 1);
+        slot.timestampsWritten = true;
+    }
+    
+    vkEndCommandBuffer(commandBuffer);
+    
+    // No wait: the eye renders are submitted later to the same queue, so they run after this upload
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    vkQueueSubmit(vkQueue_, 1, &submitInfo, slot.fence);
+    uploadedSequence_ = cameraSequence_;
+    return true;
 }
 
-void VRCameraApp::UploadCameraTextures() {
-    // Upload camera textures to GPU for both eyes
-    std::array<cv::Mat*, 2> eyeFrames = {{&leftEyeFrame_, &rightEyeFrame_}};
-    
-    for (int eye = 0; eye < 2; eye++) {
-        cv::Mat* frame = eyeFrames[eye];
-        if (frame->empty()) {
+void VRCameraApp::ApplyThreadPolicies() {
+    // VR_CAMERA_CAPTURE_THREAD and VR_CAMERA_RENDER_THREAD take a ThreadPolicy, e.g. "fifo:80@2" for the capture
+    // threads, which also decode, and "rr:70@3" for the frame loop, the thread calling Run, so that background load
+    // does not preempt them.  VR_CAMERA_MLOCK=1 locks the memory, the capture buffers included.
+    const char* capturePolicy = getenv("VR_CAMERA_CAPTURE_THREAD");
+    if (capturePolicy != nullptr && capturePolicy[0] != '\0') {
+        ThreadPolicy policy;
+        if (ThreadPolicy::Parse(capturePolicy, policy)) {
+            camera_->SetThreadPolicy(policy);
+            for (ExtraCamera& camera : extraCameras_) {
+                camera.capture->SetThreadPolicy(policy);
+            }
+        } else {
+            LogMessage("WARNING: Ignoring the invalid VR_CAMERA_CAPTURE_THREAD " + std::string(capturePolicy));
+        }
+    }
+    const char* renderPolicy = getenv("VR_CAMERA_RENDER_THREAD");
+    if (renderPolicy != nullptr && renderPolicy[0] != '\0') {
+        ThreadPolicy policy;
+        if (ThreadPolicy::Parse(renderPolicy, policy)) {
+            policy.Apply("render");
+        } else {
+            LogMessage("WARNING: Ignoring the invalid VR_CAMERA_RENDER_THREAD " + std::string(renderPolicy));
+        }
+    }
+    const char* lockMemory = getenv("VR_CAMERA_MLOCK");
+    if (lockMemory != nullptr && strcmp(lockMemory, "1") == 0) {
+        LockProcessMemory();
+    }
+}
+
+void VRCameraApp::InitializeExtraCameras() {
+    const char* devices = getenv("VR_CAMERA_EXTRA_DEVICES");
+    if (devices == nullptr) {
+        return;
+    }
+    extraCameras_.reserve(kMaxExtraCameras);
+    const std::string list = devices;
+    for (size_t begin = 0; begin < list.size();) {
+        size_t end = list.find(',', begin);
+        end = end == std::string::npos ? list.size() : end;
+        const std::string devicePath = list.substr(begin, end - begin);
+        begin = end + 1;
+        if (devicePath.empty()) {
+            continue;
+        }
+        if (extraCameras_.size() == kMaxExtraCameras) {
+            LogMessage("WARNING: Only " + std::to_string(kMaxExtraCameras) + " extra cameras are shown, ignoring " +
+                       devicePath);
             continue;
         }
         
-        // Convert BGR to RGBA format
-        cv::Mat rgbaFrame;
-        cv::cvtColor(*frame, rgbaFrame, cv::COLOR_BGR2RGBA);
+        // Any mode; the swapchain takes the size the camera delivers
+        ExtraCamera camera;
+        camera.capture = std::make_unique<CameraCapture>();
+        if (!camera.capture->Initialize(devicePath, 1920, 1080, 60)) {
+            LogMessage("WARNING: Failed to initialize the extra camera " + devicePath + ", leaving it out");
+            continue;
+        }
+        LogMessage("✓ Extra camera " + devicePath + " initialized: " + std::to_string(camera.capture->GetWidth()) + "x" +
+                   std::to_string(camera.capture->GetHeight()));
+        extraCameras_.push_back(std::move(camera));
+    }
+}
+
+bool VRCameraApp::CreateExtraCameraSwapchains() {
+    // The capture threads convert to the swapchain format, so that a frame is copied into its image as it is
+    const bool rgba = swapchainFormat_ == VK_FORMAT_R8G8B8A8_SRGB || swapchainFormat_ == VK_FORMAT_R8G8B8A8_UNORM;
+    for (ExtraCamera& camera : extraCameras_) {
+        camera.capture->SetColorConversion(rgba ? cv::COLOR_BGR2RGBA : cv::COLOR_BGR2BGRA);
         
-        // Copy data to staging buffer
-        size_t imageSize = rgbaFrame.rows * rgbaFrame.cols * 4; // RGBA = 4 bytes per pixel
-        memcpy(stagingBufferMapped_, rgbaFrame.data, imageSize);
+        XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+        swapchainCreateInfo.arraySize = 1;
+        swapchainCreateInfo.format = swapchainFormat_;
+        swapchainCreateInfo.width = static_cast<uint32_t>(camera.capture->GetWidth());
+        swapchainCreateInfo.height = static_cast<uint32_t>(camera.capture->GetHeight());
+        swapchainCreateInfo.mipCount = 1;
+        swapchainCreateInfo.faceCount = 1;
+        swapchainCreateInfo.sampleCount = 1;
+        swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT |
+                                         XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
+        if (XR_FAILED(xrCreateSwapchain(session_, &swapchainCreateInfo, &camera.swapchain.handle))) {
+            LogMessage("ERROR: Failed to create the swapchain of extra camera " + camera.capture->GetDevicePath());
+            return false;
+        }
+        camera.swapchain.width = static_cast<int32_t>(swapchainCreateInfo.width);
+        camera.swapchain.height = static_cast<int32_t>(swapchainCreateInfo.height);
         
-        // Begin command buffer for texture upload
-        VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+        uint32_t imageCount;
+        if (XR_FAILED(xrEnumerateSwapchainImages(camera.swapchain.handle, 0, &imageCount, nullptr))) {
+            LogMessage("ERROR: Failed to enumerate extra camera swapchain images!");
+            return false;
+        }
+        camera.swapchain.images.resize(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_VULKAN2_KHR});
+        if (XR_FAILED(xrEnumerateSwapchainImages(camera.swapchain.handle, imageCount, &imageCount,
+                                                 reinterpret_cast<XrSwapchainImageBaseHeader*>(camera.swapchain.images.data())))) {
+            LogMessage("ERROR: Failed to get extra camera swapchain images!");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VRCameraApp::CreateExtraCameraStaging() {
+    for (ExtraCamera& camera : extraCameras_) {
+        for (UploadSlot& slot : camera.uploadSlots) {
+            slot.rowPitch = static_cast<VkDeviceSize>(camera.swapchain.width) * 4;
+            if (!AllocateStagingBuffer(slot, slot.rowPitch * camera.swapchain.height)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void VRCameraApp::RecordExtraCameras(VkCommandBuffer commandBuffer, VkFence frameFence) {
+    for (ExtraCamera& camera : extraCameras_) {
+        // Keep showing the image released last until the capture thread completes a frame of the swapchain size
+        CameraCapture::FrameInfo info;
+        if (camera.capture->AcquireLatestFrame(camera.frame, &info)) {
+            camera.sequence = info.sequence;
+        }
+        if (camera.sequence == camera.uploadedSequence || camera.frame.cols != camera.swapchain.width ||
+            camera.frame.rows != camera.swapchain.height || camera.frame.type() != CV_8UC4) {
+            continue;
+        }
         
-        // Transition image layout to transfer destination
+        XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+        uint32_t imageIndex;
+        if (XR_FAILED(xrAcquireSwapchainImage(camera.swapchain.handle, &acquireInfo, &imageIndex))) {
+            LogMessage("ERROR: xrAcquireSwapchainImage failed for an extra camera");
+            continue;
+        }
+        camera.acquired = true;
+        XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+        waitInfo.timeout = XR_INFINITE_DURATION;
+        if (XR_FAILED(xrWaitSwapchainImage(camera.swapchain.handle, &waitInfo))) {
+            LogMessage("ERROR: xrWaitSwapchainImage failed for an extra camera");
+            continue;
+        }
+        
+        // The oldest slot was last copied from by the frame kFramesInFlight ago, normally done long ago
+        UploadSlot& slot = camera.uploadSlots[camera.uploadSlotIndex];
+        camera.uploadSlotIndex = (camera.uploadSlotIndex + 1) % camera.uploadSlots.size();
+        if (slot.readerFence != VK_NULL_HANDLE) {
+            vkWaitForFences(vkDevice_, 1, &slot.readerFence, VK_TRUE, UINT64_MAX);
+        }
+        const size_t rowSize = static_cast<size_t>(camera.frame.cols) * 4;
+        for (int row = 0; row < camera.frame.rows; row++) {
+            memcpy(static_cast<uint8_t*>(slot.stagingMapped) + row * slot.rowPitch, camera.frame.ptr(row), rowSize);
+        }
+        slot.readerFence = frameFence;
+        
+        // Copy the whole frame into the image, and leave it as a color attachment like the eyes
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
         barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image = eyeTextures_[eye].image;
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = 1;
-        barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
+        barrier.image = camera.swapchain.images[imageIndex].image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
         barrier.srcAccessMask = 0;
         barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        
         vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
         
-        // Copy buffer to image
         VkBufferImageCopy region{};
-        region.bufferOffset = 0;
-        region.bufferRowLength = 0;
-        region.bufferImageHeight = 0;
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = 1;
-        region.imageOffset = {0, 0, 0};
-        region.imageExtent = {1600, 1200, 1};
-        
-        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer_, eyeTextures_[eye].image,
-                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.imageExtent = {static_cast<uint32_t>(camera.swapchain.width), static_cast<uint32_t>(camera.swapchain.height), 1};
+        vkCmdCopyBufferToImage(commandBuffer, slot.stagingBuffer, barrier.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                               &region);
         
-        // Transition image layout to shader read optimal
         barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+        camera.uploadedSequence = camera.sequence;
+    }
+}
+
+void VRCameraApp::ReleaseExtraCameras() {
+    for (ExtraCamera& camera : extraCameras_) {
+        if (camera.acquired) {
+            XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+            if (XR_FAILED(xrReleaseSwapchainImage(camera.swapchain.handle, &releaseInfo))) {
+                LogMessage("ERROR: xrReleaseSwapchainImage failed for an extra camera");
+            }
+            camera.acquired = false;
+        }
+    }
+}
+
+XrCompositionLayerQuad VRCameraApp::GetExtraCameraQuad(size_t index) const {
+    const ExtraCamera& camera = extraCameras_[index];
+    XrCompositionLayerQuad quad{XR_TYPE_COMPOSITION_LAYER_QUAD};
+    quad.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
+    quad.subImage.swapchain = camera.swapchain.handle;
+    quad.subImage.imageRect.offset = {0, 0};
+    quad.subImage.imageRect.extent = {camera.swapchain.width, camera.swapchain.height};
+    quad.subImage.imageArrayIndex = 0;
+    
+    // Head-locked side by side in a row below the center of the view, each kExtraQuadWidth wide at its aspect ratio,
+    // so they stay in view whichever way the head turns
+    constexpr float kExtraQuadWidth = 0.3f;
+    constexpr float kExtraQuadSpacing = 0.32f;
+    constexpr float kExtraQuadDistance = 1.0f;
+    const float center = (static_cast<float>(extraCameras_.size()) - 1.0f) / 2.0f;
+    quad.size = {kExtraQuadWidth, kExtraQuadWidth * camera.swapchain.height / camera.swapchain.width};
+    quad.space = headSpace_;
+    quad.pose = {{0, 0, 0, 1}, {(static_cast<float>(index) - center) * kExtraQuadSpacing, -0.3f, -kExtraQuadDistance}};
+    return quad;
+}
+
+bool VRCameraApp::CreateSpectatorStream() {
+    if (vkGetMemoryFdKHR_ == nullptr) {
+        LogMessage("WARNING: vkGetMemoryFdKHR is missing, ignoring VR_CAMERA_SPECTATOR");
+        return false;
+    }
+    
+    // Encoders take whole macroblocks across.  The rate only guides the encoder's rate control, as the display rate is
+    // not known before the first frame.
+    spectatorWidth_ = std::min(static_cast<uint32_t>(swapchain_.width), kSpectatorMaxWidth) & ~15u;
+    spectatorHeight_ = std::min(static_cast<uint32_t>(swapchain_.height), kSpectatorMaxHeight) & ~1u;
+    const bool rgba = swapchainFormat_ == VK_FORMAT_R8G8B8A8_SRGB || swapchainFormat_ == VK_FORMAT_R8G8B8A8_UNORM;
+    const char* encoderPath = getenv("VR_CAMERA_SPECTATOR_ENCODER");
+    if (!spectator_.Initialize(static_cast<int>(spectatorWidth_), static_cast<int>(spectatorHeight_),
+                               rgba ? V4L2H264Encoder::InputFormat::RGBX : V4L2H264Encoder::InputFormat::BGRX, 90,
+                               kSpectatorBitrate, encoderPath != nullptr ? encoderPath : "")) {
+        LogMessage("WARNING: No V4L2 encoder takes " + std::to_string(spectatorWidth_) + "x" +
+                   std::to_string(spectatorHeight_) + " RGB frames from DMA-BUFs, ignoring VR_CAMERA_SPECTATOR");
+        return false;
+    }
+    if (spectator_.GetBytesPerLine() % 4 != 0 || spectator_.GetBytesPerLine() < spectatorWidth_ * 4) {
+        LogMessage("WARNING: The spectator encoder's row pitch is not whole pixels, ignoring VR_CAMERA_SPECTATOR");
+        return false;
+    }
+    
+    // Buffers in the encoder's layout, in memory it imports
+    std::array<int, SpectatorSink::kBufferCount> fds{};
+    for (size_t i = 0; i < spectatorBuffers_.size(); i++) {
+        SpectatorBuffer& spectatorBuffer = spectatorBuffers_[i];
+        VkExternalMemoryBufferCreateInfo externalInfo{};
+        externalInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+        externalInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.pNext = &externalInfo;
+        bufferInfo.size = spectator_.GetFrameSize();
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateBuffer(vkDevice_, &bufferInfo, nullptr, &spectatorBuffer.buffer) != VK_SUCCESS) {
+            LogMessage("WARNING: Failed to create an exportable spectator buffer, ignoring VR_CAMERA_SPECTATOR");
+            return false;
+        }
         
-        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+        VkMemoryRequirements memRequirements;
+        vkGetBufferMemoryRequirements(vkDevice_, spectatorBuffer.buffer, &memRequirements);
+        VkExportMemoryAllocateInfo exportInfo{};
+        exportInfo.sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO;
+        exportInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.pNext = &exportInfo;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (allocInfo.memoryTypeIndex == UINT32_MAX ||
+            vkAllocateMemory(vkDevice_, &allocInfo, nullptr, &spectatorBuffer.memory) != VK_SUCCESS) {
+            LogMessage("WARNING: Failed to allocate exportable spectator memory, ignoring VR_CAMERA_SPECTATOR");
+            return false;
+        }
+        vkBindBufferMemory(vkDevice_, spectatorBuffer.buffer, spectatorBuffer.memory, 0);
         
-        EndSingleTimeCommands(commandBuffer);
+        VkMemoryGetFdInfoKHR fdInfo{};
+        fdInfo.sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR;
+        fdInfo.memory = spectatorBuffer.memory;
+        fdInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+        if (vkGetMemoryFdKHR_(vkDevice_, &fdInfo, &spectatorBuffer.fd) != VK_SUCCESS) {
+            spectatorBuffer.fd = -1;
+            LogMessage("WARNING: Failed to export spectator memory as a DMA-BUF, ignoring VR_CAMERA_SPECTATOR");
+            return false;
+        }
+        fds[i] = spectatorBuffer.fd;
+    }
+    
+    if (!spectator_.Start(spectatorAddress_, fds)) {
+        LogMessage("WARNING: Cannot stream to " + spectatorAddress_ + ", ignoring VR_CAMERA_SPECTATOR");
+        return false;
+    }
+    LogMessage("✓ Streaming the left eye, " + std::to_string(spectatorWidth_) + "x" + std::to_string(spectatorHeight_) +
+               ", to " + spectatorAddress_ + ", playable with this SDP:\n" + spectator_.GetSdp());
+    return true;
+}
+
+void VRCameraApp::DestroySpectatorStream() {
+    spectator_.Stop();
+    for (SpectatorBuffer& spectatorBuffer : spectatorBuffers_) {
+        if (spectatorBuffer.fd >= 0) {
+            close(spectatorBuffer.fd);
+            spectatorBuffer.fd = -1;
+        }
+        if (spectatorBuffer.buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(vkDevice_, spectatorBuffer.buffer, nullptr);
+            spectatorBuffer.buffer = VK_NULL_HANDLE;
+        }
+        if (spectatorBuffer.memory != VK_NULL_HANDLE) {
+            vkFreeMemory(vkDevice_, spectatorBuffer.memory, nullptr);
+            spectatorBuffer.memory = VK_NULL_HANDLE;
+        }
+    }
+    for (FrameSlot& frame : frameSlots_) {
+        frame.spectatorBuffer = -1;
+    }
+}
+
+void VRCameraApp::RecordSpectatorCopy(VkCommandBuffer commandBuffer, uint32_t swapchainImageIndex, FrameSlot& frame) {
+    const int index = spectatorAddress_.empty() ? -1 : spectator_.AcquireBuffer();
+    if (index < 0) {
+        return;  // No spectator, or its encoder is behind and this frame is not streamed
+    }
+    const VkBuffer buffer = spectatorBuffers_[index].buffer;
+    
+    // The encoder hands the buffer back through the external queue family; the left eye's layer is a color attachment
+    // after its render, like the right eye's
+    VkBufferMemoryBarrier bufferBarrier{};
+    bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferBarrier.srcAccessMask = 0;
+    bufferBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL_KHR;
+    bufferBarrier.dstQueueFamilyIndex = queueFamilyIndex_;
+    bufferBarrier.buffer = buffer;
+    bufferBarrier.offset = 0;
+    bufferBarrier.size = VK_WHOLE_SIZE;
+    VkImageMemoryBarrier imageBarrier{};
+    imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image = swapchain_.images[swapchainImageIndex].image;
+    imageBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &bufferBarrier, 1, &imageBarrier);
+    
+    // The middle of the left eye, in the encoder's row pitch
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = spectator_.GetBytesPerLine() / 4;
+    region.bufferImageHeight = 0;
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageOffset = {(swapchain_.width - static_cast<int32_t>(spectatorWidth_)) / 2,
+                          (swapchain_.height - static_cast<int32_t>(spectatorHeight_)) / 2, 0};
+    region.imageExtent = {spectatorWidth_, spectatorHeight_, 1};
+    vkCmdCopyImageToBuffer(commandBuffer, imageBarrier.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+    
+    // Hand the buffer to the encoder, and the layer back as a color attachment for the runtime
+    bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferBarrier.dstAccessMask = 0;
+    bufferBarrier.srcQueueFamilyIndex = queueFamilyIndex_;
+    bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL_KHR;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    imageBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0,
+                         nullptr, 1, &bufferBarrier, 1, &imageBarrier);
+    frame.spectatorBuffer = index;
+}
+
+void VRCameraApp::SubmitSpectatorFrames() {
+    for (FrameSlot& frame : frameSlots_) {
+        if (frame.spectatorBuffer >= 0 && vkGetFenceStatus(vkDevice_, frame.fence) == VK_SUCCESS) {
+            spectator_.Submit(frame.spectatorBuffer, frame.displayTime);
+            frame.spectatorBuffer = -1;
+        }
     }
 }
 
 void VRCameraApp::Run() {
     LogMessage("=== Starting VR Camera Main Loop ===");
+    ApplyThreadPolicies();
+    if (!camera_->StartCaptureThread()) {
+        LogMessage("ERROR: Failed to start camera capture thread!");
+        return;
+    }
+    for (ExtraCamera& camera : extraCameras_) {
+        if (!camera.capture->StartCaptureThread()) {
+            LogMessage("WARNING: Failed to start the capture thread of extra camera " + camera.capture->GetDevicePath());
+        }
+    }
+    // An extra camera may deliver its first frame after the allocation warm-up, so its layer is not the one to grow layers_
+    layers_.reserve(quadLayers_.size() + extraCameras_.size());
     frameTimer_.Start();
+    telemetryRunning_ = true;
+    telemetryThread_ = std::thread(&VRCameraApp::TelemetryThread, this);
+    
+    const char* latencyCsvPath = getenv("VR_CAMERA_LATENCY_CSV");
+    if (latencyCsvPath != nullptr && *latencyCsvPath != '\0') {
+        if (latencyStats_.OpenCsv(latencyCsvPath)) {
+            LogMessage("Writing per-frame latency to " + std::string(latencyCsvPath));
+        } else {
+            LogMessage("WARNING: Cannot write latency CSV " + std::string(latencyCsvPath));
+        }
+    }
     
     // Keep running until we get an explicit exit signal
     bool shouldExit = false;
+    size_t nextLatencyLogFrame = 600;
     
     while (!shouldExit) {
         PollEvents();
@@ -793,36 +2142,77 @@ void VRCameraApp::Run() {
             break;
         }
         
-        // Render if session is ready or focused (like Hello_XR does)
-        if (sessionState_ == XR_SESSION_STATE_READY || sessionState_ == XR_SESSION_STATE_FOCUSED) {
+        // Run the frame loop whenever the session is running (READY through FOCUSED), like hello_xr does.
+        // xrWaitFrame paces it, so there is no sleep here.
+        if (IsSessionRunning()) {
             static bool loggedRendering = false;
             if (!loggedRendering) {
                 LogMessage("=== STARTING RENDERING - Session State: " + std::to_string(sessionState_) + " ===");
                 loggedRendering = true;
             }
             
-            UpdateCamera();
-            UploadCameraTextures();
             RenderFrame();
             
+            // Once the display rate is known, pick the camera rate that divides it
+            if (!cameraRateNegotiated_ && displayRate_ > 0) {
+                cameraRateNegotiated_ = true;
+                if (!SelectCameraMode(camera_->GetWidth(), camera_->GetHeight())) {
+                    shouldExit = true;
+                    break;
+                }
+            }
+            
             // Log performance every 120 frames (2 seconds at 60fps)
             if (frameCount_ % 120 == 0) {
                 frameTimer_.Stop();
                 double avgFPS = frameCount_ / frameTimer_.GetElapsedMilliseconds() * 1000.0;
                 // LogMessage("Frame " + std::to_string(frameCount_) + " - Average FPS: " + std::to_string(avgFPS));
             }
+            
+            // Log the latency breakdown every 600 frames (10 seconds at 60fps), the window of its statistics
+            if (latencyStats_.GetFrameCount() >= nextLatencyLogFrame) {
+                LogMessage("Latency over the last 600 frames:\n" + latencyStats_.Summary());
+                LogMessage("Camera frames so far: " + std::to_string(frameCounters_.fresh) + " fresh, " +
+                           std::to_string(frameCounters_.repeated) + " repeated, " +
+                           std::to_string(frameCounters_.dropped) + " dropped");
+                if (spectator_.IsRunning()) {
+                    LogMessage("Spectator frames so far: " + std::to_string(spectator_.GetEncodedCount()) + " streamed, " +
+                               std::to_string(spectator_.GetDroppedCount()) + " dropped behind the encoder");
+                }
+                nextLatencyLogFrame = latencyStats_.GetFrameCount() + 600;
+                
+                // Decoding slower than the camera delivers drops frames, so step down to a smaller mode.  Judge only
+                // once the window holds no decode times from the previous mode.
+                const double decodeMilliseconds = latencyStats_.Percentile(LatencyStage::Decode, 90);
+                if (frameCount_ - modeChangeCameraFrame_ >= 600 && camera_->GetFPS() > 0 &&
+                    decodeMilliseconds > 1000.0 / camera_->GetFPS()) {
+                    LogMessage("Decoding takes " + std::to_string(decodeMilliseconds) + " ms at p90, stepping down");
+                    if (!SelectCameraMode(camera_->GetWidth() - 1, camera_->GetHeight())) {
+                        shouldExit = true;
+                        break;
+                    }
+                }
+            }
         } else {
             // Log current state periodically when not rendering
             static int stateLogCounter = 0;
-            if (++stateLogCounter % 300 == 0) { // Every ~5 seconds
-                LogMessage("Waiting for READY/FOCUSED state. Current state: " + std::to_string(sessionState_));
+            if (++stateLogCounter % 50 == 0) { // Every ~5 seconds
+                LogMessage("Waiting for READY state. Current state: " + std::to_string(sessionState_));
             }
+            
+            // OpenXR has no blocking wait for events, so poll at a low rate until the session runs
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
-        
-        // Small sleep to prevent busy waiting
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
     
+    camera_->StopCaptureThread();
+    for (ExtraCamera& camera : extraCameras_) {
+        camera.capture->StopCaptureThread();
+    }
+    telemetryRunning_ = false;
+    if (telemetryThread_.joinable()) {
+        telemetryThread_.join();
+    }
     LogMessage("=== VR Camera Main Loop Ended ===");
 }
 
@@ -879,30 +2269,74 @@ void VRCameraApp::RenderFrame() {
         // LogMessage("RenderFrame called - count: " + std::to_string(renderFrameCount));
     }
     
+    const uint64_t allocationCount = AllocationCounter::Count();
+    
     // Begin frame
     XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
     XrFrameState frameState{XR_TYPE_FRAME_STATE};
     
-    XrResult result = xrWaitFrame(session_, &frameWaitInfo, &frameState);
+    XrResult result;
+    {
+        AllocationCounter::Untracked runtimeAllocations;
+        AcquireEyeImage();  // Normally acquired when the last frame ended already
+        result = xrWaitFrame(session_, &frameWaitInfo, &frameState);
+    }
     if (XR_FAILED(result)) {
         LogMessage("ERROR: xrWaitFrame failed");
         return;
     }
+    if (frameState.predictedDisplayPeriod > 0) {
+        displayRate_ = 1e9 / static_cast<double>(frameState.predictedDisplayPeriod);
+    }
 
     XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
-    result = xrBeginFrame(session_, &frameBeginInfo);
+    {
+        AllocationCounter::Untracked runtimeAllocations;
+        result = xrBeginFrame(session_, &frameBeginInfo);
+    }
     if (XR_FAILED(result)) {
         LogMessage("ERROR: xrBeginFrame failed");
         return;
     }
 
-    std::vector<XrCompositionLayerBaseHeader*> layers;
-    XrCompositionLayerProjection layer{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
-    std::vector<XrCompositionLayerProjectionView> projectionLayerViews;
+    std::vector<XrCompositionLayerBaseHeader*>& layers = layers_;
+    XrCompositionLayerProjection& layer = projectionLayer_;
+    std::vector<XrCompositionLayerProjectionView>& projectionLayerViews = projectionLayerViews_;
+    std::array<XrCompositionLayerQuad, 2>& quadLayers = quadLayers_;
+    layers.clear();
 
     if (frameState.shouldRender == XR_TRUE) {
+        // Take the newest camera frame now that xrWaitFrame has returned, so it is as fresh as possible.  OpenCV,
+        // Vulkan and the runtime allocate as they see fit, so they are left out of the allocation count.
+        {
+            AllocationCounter::Untracked cameraAllocations;
+            UpdateCamera();
+            if (UploadCameraTextures()) {
+                frameCounters_.fresh++;
+            } else if (uploadedSequence_ != 0) {
+                frameCounters_.repeated++;
+            }
+        }
+        
         // Render only if we should render
-        if (RenderEyeTextures(frameState.predictedDisplayTime)) {
+        Timer renderTimer;
+        renderTimer.Start();
+        bool rendered;
+        {
+            AllocationCounter::Untracked renderAllocations;
+            rendered = RenderEyeTextures(frameState.predictedDisplayTime);
+        }
+        latencyStats_.Record(LatencyStage::Render, renderTimer.GetElapsedMilliseconds());
+        if (cameraTime_ != 0) {
+            latencyStats_.Record(LatencyStage::FrameAge, (frameState.predictedDisplayTime - cameraTime_) / 1e6);
+        }
+        if (rendered && quadLayerMode_) {
+            // One quad per eye, each showing only that eye's camera layer
+            for (uint32_t i = 0; i < configViews_.size() && i < quadLayers.size(); i++) {
+                quadLayers[i] = GetEyeQuad(i);
+                layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&quadLayers[i]));
+            }
+        } else if (rendered) {
             // Set up projection layer
             projectionLayerViews.resize(configViews_.size());
             layer.space = appSpace_;
@@ -911,17 +2345,25 @@ void VRCameraApp::RenderFrame() {
             layer.views = projectionLayerViews.data();
 
             for (uint32_t i = 0; i < configViews_.size(); i++) {
-                const Swapchain& viewSwapchain = swapchains_[i];
                 projectionLayerViews[i] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
                 projectionLayerViews[i].pose = views_[i].pose;
-                projectionLayerViews[i].fov = views_[i].fov;
-                projectionLayerViews[i].subImage.swapchain = viewSwapchain.handle;
+                projectionLayerViews[i].fov = GetLayerFov(i);
+                projectionLayerViews[i].subImage.swapchain = swapchain_.handle;
                 projectionLayerViews[i].subImage.imageRect.offset = {0, 0};
-                projectionLayerViews[i].subImage.imageRect.extent = {(int32_t)viewSwapchain.width, (int32_t)viewSwapchain.height};
+                projectionLayerViews[i].subImage.imageRect.extent = {swapchain_.width, swapchain_.height};
+                projectionLayerViews[i].subImage.imageArrayIndex = i;  // Each eye has its own layer
             }
 
             layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&layer));
         }
+        // The extra cameras over the stereo camera, once each has released an image.  The runtime shows the image
+        // released last, so a camera without a new frame keeps its old one.
+        for (size_t i = 0; rendered && i < extraCameras_.size(); i++) {
+            if (extraCameras_[i].uploadedSequence != 0) {
+                extraCameras_[i].quad = GetExtraCameraQuad(i);
+                layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&extraCameras_[i].quad));
+            }
+        }
     }
 
     // End frame
@@ -931,13 +2373,32 @@ void VRCameraApp::RenderFrame() {
     frameEndInfo.layerCount = (uint32_t)layers.size();
     frameEndInfo.layers = layers.data();
 
-    result = xrEndFrame(session_, &frameEndInfo);
+    Timer endFrameTimer;
+    endFrameTimer.Start();
+    {
+        AllocationCounter::Untracked runtimeAllocations;
+        result = xrEndFrame(session_, &frameEndInfo);
+        // The image of the next frame, so the runtime can finish with it while the camera frame is taken and uploaded
+        AcquireEyeImage();
+    }
     if (XR_FAILED(result)) {
         LogMessage("ERROR: xrEndFrame failed");
     }
+    latencyStats_.Record(LatencyStage::EndFrame, endFrameTimer.GetElapsedMilliseconds());
+    latencyStats_.EndFrame();
+    
+    // Once the first frames have sized the layer storage, a frame must not allocate on its own
+    if (AllocationCounter::Enabled() && ++renderedFrameCount_ > kAllocationWarmupFrames) {
+        assert(AllocationCounter::Count() == allocationCount && "RenderFrame made a heap allocation");
+    }
+    (void)allocationCount;
 }
 
 bool VRCameraApp::RenderEyeTextures(XrTime displayTime) {
+    if ((directUpload_ || mappedTexture_) && latestUploadSlot_ >= uploadSlots_.size()) {
+        return false;  // No camera frame to copy yet
+    }
+    
     // Locate views (head tracking)
     XrViewState viewState{XR_TYPE_VIEW_STATE};
     uint32_t viewCapacityInput = (uint32_t)views_.size();
@@ -953,48 +2414,121 @@ bool VRCameraApp::RenderEyeTextures(XrTime displayTime) {
         LogMessage("ERROR: xrLocateViews failed");
         return false;
     }
+    if ((viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) != 0) {
+        poseHistory_.Push(views_[0].pose, displayTime);
+    }
+    
+    // Rotation from the predicted head orientation to the one the camera frame was captured at, or none if unknown
+    XrQuaternionf reprojection{0, 0, 0, 1};
+    // The quad layers are placed where the head was at capture time, so the runtime reprojects them instead
+    XrQuaternionf displayOrientation;
+    if (!quadLayerMode_ && cameraOrientationValid_ && LocateHeadOrientation(displayTime, displayOrientation)) {
+        const XrQuaternionf& d = displayOrientation;
+        const XrQuaternionf& c = cameraOrientation_;
+        // conj(d) * c
+        reprojection.x = d.w * c.x - d.x * c.w - d.y * c.z + d.z * c.y;
+        reprojection.y = d.w * c.y + d.x * c.z - d.y * c.w - d.z * c.x;
+        reprojection.z = d.w * c.z - d.x * c.y + d.y * c.x - d.z * c.w;
+        reprojection.w = d.w * c.w + d.x * c.x + d.y * c.y + d.z * c.z;
+    }
+    
+    // Wait until the GPU is done with the oldest frame, normally long ago, and take its render time
+    const size_t frameSlot = frameSlotIndex_;
+    FrameSlot& frame = frameSlots_[frameSlot];
+    frameSlotIndex_ = (frameSlotIndex_ + 1) % frameSlots_.size();
+    vkWaitForFences(vkDevice_, 1, &frame.fence, VK_TRUE, UINT64_MAX);
+    if (frame.timestampsWritten) {
+        const double gpuRenderMilliseconds = ReadTimestampMilliseconds(GetRenderQueryIndex(frameSlot));
+        if (gpuRenderMilliseconds >= 0.0) {
+            latencyStats_.Record(LatencyStage::GpuRender, gpuRenderMilliseconds);
+        }
+        frame.timestampsWritten = false;
+    }
+    SubmitSpectatorFrames();
+    
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(frame.commandBuffer, &beginInfo);
+    const uint32_t queryIndex = GetRenderQueryIndex(frameSlot);
+    if (timestampQueryPool_ != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(frame.commandBuffer, timestampQueryPool_, queryIndex, 2);
+        vkCmdWriteTimestamp(frame.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool_, queryIndex);
+    }
+    
+    // The swapchain image both eyes render to, acquired ahead of the frame.  Recording only needs its index; the image
+    // is waited for right before the submission that writes it.
+    if (!AcquireEyeImage()) {
+        vkEndCommandBuffer(frame.commandBuffer);
+        return false;
+    }
+    const uint32_t swapchainImageIndex = static_cast<uint32_t>(swapchain_.acquiredImage);
     
-    // Render each eye
+    // Record each eye to its layer of the swapchain image
     for (uint32_t eyeIndex = 0; eyeIndex < viewCountOutput; eyeIndex++) {
-        // Acquire swapchain image
-        XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
-        uint32_t swapchainImageIndex;
-        result = xrAcquireSwapchainImage(swapchains_[eyeIndex].handle, &acquireInfo, &swapchainImageIndex);
-        if (XR_FAILED(result)) {
-            LogMessage("ERROR: xrAcquireSwapchainImage failed for eye " + std::to_string(eyeIndex));
-            return false;
-        }
-        
-        // Wait for swapchain image to be ready
-        XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
-        waitInfo.timeout = XR_INFINITE_DURATION;
-        result = xrWaitSwapchainImage(swapchains_[eyeIndex].handle, &waitInfo);
-        if (XR_FAILED(result)) {
-            LogMessage("ERROR: xrWaitSwapchainImage failed for eye " + std::to_string(eyeIndex));
-            return false;
-        }
-        
-        // Get the swapchain image
-        const XrSwapchainImageVulkan2KHR& swapchainImage = swapchains_[eyeIndex].images[swapchainImageIndex];
-        
-        // Render to this eye's swapchain image
-        RenderEye(eyeIndex, swapchainImage);
-        
-        // Release swapchain image
-        XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
-        result = xrReleaseSwapchainImage(swapchains_[eyeIndex].handle, &releaseInfo);
-        if (XR_FAILED(result)) {
-            LogMessage("ERROR: xrReleaseSwapchainImage failed for eye " + std::to_string(eyeIndex));
-            return false;
-        }
+        RenderEye(frame.commandBuffer, eyeIndex, swapchainImageIndex, reprojection);
+    }
+    if (directUpload_ || mappedTexture_) {
+        uploadSlots_[latestUploadSlot_].readerFence = frame.fence;  // The slot is not rewritten before this frame is done
+    }
+    RecordSpectatorCopy(frame.commandBuffer, swapchainImageIndex, frame);
+    frame.displayTime = displayTime;
+    RecordExtraCameras(frame.commandBuffer, frame.fence);
+    
+    if (timestampQueryPool_ != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(frame.commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool_, queryIndex + 1);
+        frame.timestampsWritten = true;
+    }
+    vkEndCommandBuffer(frame.commandBuffer);
+    
+    // Normally long done, as the image was acquired when the last frame ended
+    XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+    waitInfo.timeout = XR_INFINITE_DURATION;
+    result = xrWaitSwapchainImage(swapchain_.handle, &waitInfo);
+    if (XR_FAILED(result)) {
+        LogMessage("ERROR: xrWaitSwapchainImage failed");
+        return false;
+    }
+    
+    // One submission for both eyes, without waiting for it: the runtime only needs the work submitted before the
+    // images are released, and the fence guards the command buffer's reuse
+    vkResetFences(vkDevice_, 1, &frame.fence);
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &frame.commandBuffer;
+    vkQueueSubmit(vkQueue_, 1, &submitInfo, frame.fence);
+    ReleaseExtraCameras();
+    
+    // Release the swapchain image
+    XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+    result = xrReleaseSwapchainImage(swapchain_.handle, &releaseInfo);
+    swapchain_.acquiredImage = -1;
+    if (XR_FAILED(result)) {
+        LogMessage("ERROR: xrReleaseSwapchainImage failed");
+        return false;
     }
     
     return true;
 }
 
-void VRCameraApp::RenderEye(int eyeIndex, const XrSwapchainImageVulkan2KHR& swapchainImage) {
-    // Create a command buffer for this eye's rendering
-    VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+bool VRCameraApp::AcquireEyeImage() {
+    if (swapchain_.acquiredImage >= 0) {
+        return true;
+    }
+    XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+    uint32_t swapchainImageIndex;
+    if (XR_FAILED(xrAcquireSwapchainImage(swapchain_.handle, &acquireInfo, &swapchainImageIndex))) {
+        LogMessage("ERROR: xrAcquireSwapchainImage failed");
+        return false;
+    }
+    swapchain_.acquiredImage = static_cast<int32_t>(swapchainImageIndex);
+    return true;
+}
+
+void VRCameraApp::RenderEye(VkCommandBuffer commandBuffer, int eyeIndex, uint32_t swapchainImageIndex,
+                            const XrQuaternionf& reprojection) {
+    const XrSwapchainImageVulkan2KHR& swapchainImage = swapchain_.images[swapchainImageIndex];
     
     // Clear the swapchain image to a dark blue color (for now)
     VkImageSubresourceRange subresourceRange{};
@@ -1004,7 +2538,7 @@ void VRCameraApp::RenderEye(int eyeIndex, const XrSwapchainImageVulkan2KHR& swap
     subresourceRange.baseArrayLayer = 0;
     subresourceRange.layerCount = 1;
     
-    // Transition swapchain image to transfer destination
+    // Transition this eye's layer of the swapchain image to transfer destination
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -1013,24 +2547,112 @@ void VRCameraApp::RenderEye(int eyeIndex, const XrSwapchainImageVulkan2KHR& swap
     barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.image = swapchainImage.image;
     barrier.subresourceRange = subresourceRange;
+    barrier.subresourceRange.baseArrayLayer = static_cast<uint32_t>(eyeIndex);
     barrier.srcAccessMask = 0;
     barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     
-    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                        0, 0, nullptr, 0, nullptr, 1, &barrier);
-    
     // Scale the camera image to fill more of the swapchain
-    uint32_t swapchainWidth = swapchains_[eyeIndex].width;   // 2468
-    uint32_t swapchainHeight = swapchains_[eyeIndex].height; // 2740
+    int32_t swapchainWidth = swapchain_.width;   // 2468
+    int32_t swapchainHeight = swapchain_.height; // 2740
     
     // Scale down the high-res camera image to fit in VR display
     // Camera: 1600x1200 -> Scaled: 1600x1200 (fits well in 2468x2740 display)
-    uint32_t scaledWidth = 1600;   // Use original camera resolution
-    uint32_t scaledHeight = 1200;  // Use original camera resolution
+    int32_t scaledWidth = static_cast<int32_t>(eyeWidth_);    // Use original camera resolution
+    int32_t scaledHeight = static_cast<int32_t>(eyeHeight_);  // Use original camera resolution
     
     // Center the scaled image in the swapchain
-    uint32_t offsetX = (swapchainWidth - scaledWidth) / 2;   // (2468-1600)/2 = 434
-    uint32_t offsetY = (swapchainHeight - scaledHeight) / 2; // (2740-1200)/2 = 770
+    int32_t offsetX = (swapchainWidth - scaledWidth) / 2;   // (2468-1600)/2 = 434
+    int32_t offsetY = (swapchainHeight - scaledHeight) / 2; // (2740-1200)/2 = 770
+    
+    // Rotational reprojection: the view direction at capture time, (0, 0, -1) rotated by reprojection, is where the
+    // image center belongs in this eye's view now.  The blit can only shift the image, so roll is ignored.
+    const XrQuaternionf& q = reprojection;
+    const float forwardX = -2.0f * (q.x * q.z + q.w * q.y);
+    const float forwardY = -2.0f * (q.y * q.z - q.w * q.x);
+    const float forwardZ = -(1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+    const XrFovf fov = GetLayerFov(static_cast<uint32_t>(eyeIndex));
+    if (forwardZ < 0.0f) {
+        const float pixelsPerTanX = static_cast<float>(swapchainWidth) / (tanf(fov.angleRight) - tanf(fov.angleLeft));
+        const float pixelsPerTanY = static_cast<float>(swapchainHeight) / (tanf(fov.angleUp) - tanf(fov.angleDown));
+        offsetX += static_cast<int32_t>(lroundf(pixelsPerTanX * forwardX / -forwardZ));
+        offsetY -= static_cast<int32_t>(lroundf(pixelsPerTanY * forwardY / -forwardZ));  // Image rows go down
+    }
+    
+    // Clip the shifted image to the swapchain, keeping the 1:1 scale
+    int32_t srcX0 = 0, srcY0 = 0;
+    int32_t srcX1 = scaledWidth, srcY1 = scaledHeight;
+    int32_t dstX0 = offsetX, dstY0 = offsetY;
+    int32_t dstX1 = offsetX + scaledWidth, dstY1 = offsetY + scaledHeight;
+    if (dstX0 < 0) { srcX0 -= dstX0; dstX0 = 0; }
+    if (dstY0 < 0) { srcY0 -= dstY0; dstY0 = 0; }
+    if (dstX1 > swapchainWidth) { srcX1 -= dstX1 - swapchainWidth; dstX1 = swapchainWidth; }
+    if (dstY1 > swapchainHeight) { srcY1 -= dstY1 - swapchainHeight; dstY1 = swapchainHeight; }
+    const bool visible = dstX0 < dstX1 && dstY0 < dstY1;
+    
+    if (undistort_) {
+        // One draw over the whole layer places, clips, undistorts and rectifies the eye, and leaves the layer as a color
+        // attachment like the blit does
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPass_;
+        renderPassInfo.framebuffer = framebuffers_[swapchainImageIndex][eyeIndex].framebuffer;
+        renderPassInfo.renderArea = {{0, 0}, {static_cast<uint32_t>(swapchainWidth), static_cast<uint32_t>(swapchainHeight)}};
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &descriptorSet_, 0,
+                                nullptr);
+        const UndistortPushConstants constants{{static_cast<float>(offsetX), static_cast<float>(offsetY)},
+                                               {static_cast<float>(scaledWidth), static_cast<float>(scaledHeight)},
+                                               static_cast<float>(eyeIndex)};
+        vkCmdPushConstants(commandBuffer, pipelineLayout_, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), &constants);
+        vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+        vkCmdEndRenderPass(commandBuffer);
+        return;
+    }
+    
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        0, 0, nullptr, 0, nullptr, 1, &barrier);
+    
+    if (directUpload_) {
+        // Copy the visible part of this eye's half of the newest staging buffer straight to its layer, at 1:1 scale
+        if (visible) {
+            VkBufferImageCopy region{};
+            region.bufferOffset = (static_cast<VkDeviceSize>(srcY0) * eyeWidth_ * 2 + eyeIndex * eyeWidth_ + srcX0) *
+                                  eyeTextureBytesPerPixel_;
+            region.bufferRowLength = eyeWidth_ * 2;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = 0;
+            region.imageSubresource.baseArrayLayer = static_cast<uint32_t>(eyeIndex);
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = {dstX0, dstY0, 0};
+            region.imageExtent = {static_cast<uint32_t>(dstX1 - dstX0), static_cast<uint32_t>(dstY1 - dstY0), 1};
+            vkCmdCopyBufferToImage(commandBuffer, uploadSlots_[latestUploadSlot_].stagingBuffer, swapchainImage.image,
+                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        }
+        
+        // Transition swapchain image to color attachment optimal
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+        return;
+    }
+    
+    // A mapped texture holds both eyes side by side in its one layer, and stays in the general layout, in which the CPU
+    // wrote it before this frame's submit
+    VkImage sourceImage = cameraTexture_.image;
+    VkImageLayout sourceLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    uint32_t sourceLayer = static_cast<uint32_t>(eyeIndex);
+    int32_t sourceX = 0;
+    if (mappedTexture_) {
+        sourceImage = uploadSlots_[latestUploadSlot_].mappedImage;
+        sourceLayout = VK_IMAGE_LAYOUT_GENERAL;
+        sourceLayer = 0;
+        sourceX = eyeIndex * static_cast<int32_t>(eyeWidth_);
+    }
     
     // Transition eye texture to transfer source
     VkImageMemoryBarrier srcBarrier{};
@@ -1039,35 +2661,40 @@ void VRCameraApp::RenderEye(int eyeIndex, const XrSwapchainImageVulkan2KHR& swap
     srcBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
     srcBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     srcBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    srcBarrier.image = eyeTextures_[eyeIndex].image;
+    srcBarrier.image = cameraTexture_.image;
     srcBarrier.subresourceRange = subresourceRange;
+    srcBarrier.subresourceRange.baseArrayLayer = static_cast<uint32_t>(eyeIndex);  // This eye's layer
     srcBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
     srcBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
     
-    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                        0, 0, nullptr, 0, nullptr, 1, &srcBarrier);
+    if (!mappedTexture_) {
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                            0, 0, nullptr, 0, nullptr, 1, &srcBarrier);
+    }
     
     // Use blit to scale the image instead of copy
     VkImageBlit blitRegion{};
     blitRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     blitRegion.srcSubresource.mipLevel = 0;
-    blitRegion.srcSubresource.baseArrayLayer = 0;
+    blitRegion.srcSubresource.baseArrayLayer = sourceLayer;
     blitRegion.srcSubresource.layerCount = 1;
-    blitRegion.srcOffsets[0] = {0, 0, 0};
-    blitRegion.srcOffsets[1] = {1600, 1200, 1};  // Source: full 1600x1200 camera image
+    blitRegion.srcOffsets[0] = {sourceX + srcX0, srcY0, 0};
+    blitRegion.srcOffsets[1] = {sourceX + srcX1, srcY1, 1};  // The part of the eye left after clipping
     
     blitRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     blitRegion.dstSubresource.mipLevel = 0;
-    blitRegion.dstSubresource.baseArrayLayer = 0;
+    blitRegion.dstSubresource.baseArrayLayer = static_cast<uint32_t>(eyeIndex);  // This eye's layer
     blitRegion.dstSubresource.layerCount = 1;
-    blitRegion.dstOffsets[0] = {(int32_t)offsetX, (int32_t)offsetY, 0};
-    blitRegion.dstOffsets[1] = {(int32_t)(offsetX + scaledWidth), (int32_t)(offsetY + scaledHeight), 1};
+    blitRegion.dstOffsets[0] = {dstX0, dstY0, 0};
+    blitRegion.dstOffsets[1] = {dstX1, dstY1, 1};
     
-    // Blit (scale) the eye texture to the swapchain image
-    vkCmdBlitImage(commandBuffer,
-                   eyeTextures_[eyeIndex].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                   swapchainImage.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                   1, &blitRegion, VK_FILTER_LINEAR);
+    // Blit (scale) the eye texture to the swapchain image, unless the head turned it out of view
+    if (visible) {
+        vkCmdBlitImage(commandBuffer,
+                       sourceImage, sourceLayout,
+                       swapchainImage.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       1, &blitRegion, VK_FILTER_LINEAR);
+    }
     
     // Transition swapchain image to color attachment optimal
     barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
@@ -1079,45 +2706,200 @@ void VRCameraApp::RenderEye(int eyeIndex, const XrSwapchainImageVulkan2KHR& swap
                         0, 0, nullptr, 0, nullptr, 1, &barrier);
     
     // Transition eye texture back to shader read optimal
-    srcBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-    srcBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    srcBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-    srcBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    if (!mappedTexture_) {
+        srcBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        srcBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        srcBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        srcBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                            0, 0, nullptr, 0, nullptr, 1, &srcBarrier);
+    }
+}
+
+XrFovf VRCameraApp::GetLayerFov(uint32_t eyeIndex) const {
+    const XrFovf& fov = views_[eyeIndex].fov;
+    if (!nativeSwapchain_ && !quadLayerMode_) {
+        return fov;
+    }
+    
+    // Narrow the tangent range around its center, where the full-size swapchain centered the camera image
+    const float tanLeft = tanf(fov.angleLeft), tanRight = tanf(fov.angleRight);
+    const float tanUp = tanf(fov.angleUp), tanDown = tanf(fov.angleDown);
+    const float centerX = (tanLeft + tanRight) / 2.0f, halfWidth = (tanRight - tanLeft) / 2.0f * layerFovScaleX_;
+    const float centerY = (tanUp + tanDown) / 2.0f, halfHeight = (tanUp - tanDown) / 2.0f * layerFovScaleY_;
+    XrFovf layerFov;
+    layerFov.angleLeft = atanf(centerX - halfWidth);
+    layerFov.angleRight = atanf(centerX + halfWidth);
+    layerFov.angleUp = atanf(centerY + halfHeight);
+    layerFov.angleDown = atanf(centerY - halfHeight);
+    return layerFov;
+}
+
+XrCompositionLayerQuad VRCameraApp::GetEyeQuad(uint32_t eyeIndex) const {
+    XrCompositionLayerQuad quad{XR_TYPE_COMPOSITION_LAYER_QUAD};
+    quad.eyeVisibility = eyeIndex == 0 ? XR_EYE_VISIBILITY_LEFT : XR_EYE_VISIBILITY_RIGHT;
+    quad.subImage.swapchain = swapchain_.handle;
+    quad.subImage.imageRect.offset = {0, 0};
+    quad.subImage.imageRect.extent = {swapchain_.width, swapchain_.height};
+    quad.subImage.imageArrayIndex = eyeIndex;
+    
+    // Span the eye's layer FOV at kQuadDistance, centered on it, in the head's frame at capture time
+    const XrFovf fov = GetLayerFov(eyeIndex);
+    const float tanLeft = tanf(fov.angleLeft), tanRight = tanf(fov.angleRight);
+    const float tanUp = tanf(fov.angleUp), tanDown = tanf(fov.angleDown);
+    constexpr float kQuadDistance = 1.0f;
+    quad.size = {(tanRight - tanLeft) * kQuadDistance, (tanUp - tanDown) * kQuadDistance};
+    const XrVector3f offset{(tanLeft + tanRight) / 2.0f * kQuadDistance, (tanUp + tanDown) / 2.0f * kQuadDistance,
+                            -kQuadDistance};
+    if (!cameraOrientationValid_) {
+        // Without the capture pose, keep the quad head-locked
+        quad.space = headSpace_;
+        quad.pose = {{0, 0, 0, 1}, offset};
+        return quad;
+    }
+    
+    // The head position at display time, between the eyes, plus the offset rotated by the capture orientation
+    const XrQuaternionf& q = cameraOrientation_;
+    const XrVector3f& eye = views_[eyeIndex].pose.position;
+    const XrVector3f& otherEye = views_[views_.size() - 1 - eyeIndex].pose.position;
+    // t = 2 * cross(q.xyz, offset); rotated = offset + q.w * t + cross(q.xyz, t)
+    const XrVector3f t{2.0f * (q.y * offset.z - q.z * offset.y), 2.0f * (q.z * offset.x - q.x * offset.z),
+                       2.0f * (q.x * offset.y - q.y * offset.x)};
+    quad.space = appSpace_;
+    quad.pose.orientation = q;
+    quad.pose.position.x = (eye.x + otherEye.x) / 2.0f + offset.x + q.w * t.x + (q.y * t.z - q.z * t.y);
+    quad.pose.position.y = (eye.y + otherEye.y) / 2.0f + offset.y + q.w * t.y + (q.z * t.x - q.x * t.z);
+    quad.pose.position.z = (eye.z + otherEye.z) / 2.0f + offset.z + q.w * t.z + (q.x * t.y - q.y * t.x);
+    return quad;
+}
+
+void VRCameraApp::DestroyUploadSlot(UploadSlot& slot) {
+    if (slot.stagingMapped) {
+        vkUnmapMemory(vkDevice_, slot.stagingMemory);
+        slot.stagingMapped = nullptr;
+    }
+    if (slot.stagingBuffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(vkDevice_, slot.stagingBuffer, nullptr);
+        slot.stagingBuffer = VK_NULL_HANDLE;
+    }
+    if (slot.mappedImage != VK_NULL_HANDLE) {
+        vkDestroyImage(vkDevice_, slot.mappedImage, nullptr);
+        slot.mappedImage = VK_NULL_HANDLE;
+    }
+    if (slot.stagingMemory != VK_NULL_HANDLE) {
+        vkFreeMemory(vkDevice_, slot.stagingMemory, nullptr);
+        slot.stagingMemory = VK_NULL_HANDLE;
+    }
+    if (slot.fence != VK_NULL_HANDLE) {
+        vkDestroyFence(vkDevice_, slot.fence, nullptr);
+        slot.fence = VK_NULL_HANDLE;
+    }
+    if (slot.commandBuffer != VK_NULL_HANDLE) {
+        vkFreeCommandBuffers(vkDevice_, commandPool_, 1, &slot.commandBuffer);
+        slot.commandBuffer = VK_NULL_HANDLE;
+    }
+    slot.timestampsWritten = false;
+    slot.readerFence = VK_NULL_HANDLE;
+}
+
+void VRCameraApp::DestroyCameraResources() {
+    for (auto& slot : uploadSlots_) {
+        DestroyUploadSlot(slot);
+    }
+    uploadSlotIndex_ = 0;
+    latestUploadSlot_ = kFramesInFlight;
     
-    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                        0, 0, nullptr, 0, nullptr, 1, &srcBarrier);
+    for (EyeTexture* texture : {&cameraTexture_, &remapTexture_}) {
+        if (texture->sampler != VK_NULL_HANDLE) {
+            vkDestroySampler(vkDevice_, texture->sampler, nullptr);
+            texture->sampler = VK_NULL_HANDLE;
+        }
+        if (texture->imageView != VK_NULL_HANDLE) {
+            vkDestroyImageView(vkDevice_, texture->imageView, nullptr);
+            texture->imageView = VK_NULL_HANDLE;
+        }
+        if (texture->image != VK_NULL_HANDLE) {
+            vkDestroyImage(vkDevice_, texture->image, nullptr);
+            texture->image = VK_NULL_HANDLE;
+        }
+        if (texture->memory != VK_NULL_HANDLE) {
+            vkFreeMemory(vkDevice_, texture->memory, nullptr);
+            texture->memory = VK_NULL_HANDLE;
+        }
+    }
+}
+
+void VRCameraApp::DestroyRenderPipeline() {
+    for (auto& layers : framebuffers_) {
+        for (LayerFramebuffer& layer : layers) {
+            if (layer.framebuffer != VK_NULL_HANDLE) {
+                vkDestroyFramebuffer(vkDevice_, layer.framebuffer, nullptr);
+            }
+            if (layer.imageView != VK_NULL_HANDLE) {
+                vkDestroyImageView(vkDevice_, layer.imageView, nullptr);
+            }
+        }
+    }
+    framebuffers_.clear();
     
-    EndSingleTimeCommands(commandBuffer);
+    if (descriptorPool_ != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(vkDevice_, descriptorPool_, nullptr);  // Frees descriptorSet_
+        descriptorPool_ = VK_NULL_HANDLE;
+        descriptorSet_ = VK_NULL_HANDLE;
+    }
+    if (graphicsPipeline_ != VK_NULL_HANDLE) {
+        vkDestroyPipeline(vkDevice_, graphicsPipeline_, nullptr);
+        graphicsPipeline_ = VK_NULL_HANDLE;
+    }
+    if (pipelineLayout_ != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(vkDevice_, pipelineLayout_, nullptr);
+        pipelineLayout_ = VK_NULL_HANDLE;
+    }
+    if (descriptorSetLayout_ != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(vkDevice_, descriptorSetLayout_, nullptr);
+        descriptorSetLayout_ = VK_NULL_HANDLE;
+    }
+    if (renderPass_ != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(vkDevice_, renderPass_, nullptr);
+        renderPass_ = VK_NULL_HANDLE;
+    }
 }
 
 void VRCameraApp::Shutdown() {
     LogMessage("=== Shutting down VR Camera Application ===");
     
-    // Clean up Vulkan resources
-    if (stagingBufferMapped_) {
-        vkUnmapMemory(vkDevice_, stagingBufferMemory_);
-        stagingBufferMapped_ = nullptr;
+    // Run stops it, unless it threw
+    telemetryRunning_ = false;
+    if (telemetryThread_.joinable()) {
+        telemetryThread_.join();
     }
     
-    if (stagingBuffer_ != VK_NULL_HANDLE) {
-        vkDestroyBuffer(vkDevice_, stagingBuffer_, nullptr);
-        stagingBuffer_ = VK_NULL_HANDLE;
+    // Clean up Vulkan resources, once the GPU is done with the uploads still in flight
+    if (vkDevice_ != VK_NULL_HANDLE) {
+        vkDeviceWaitIdle(vkDevice_);
     }
     
-    if (stagingBufferMemory_ != VK_NULL_HANDLE) {
-        vkFreeMemory(vkDevice_, stagingBufferMemory_, nullptr);
-        stagingBufferMemory_ = VK_NULL_HANDLE;
+    DestroySpectatorStream();
+    DestroyCameraResources();
+    DestroyRenderPipeline();
+    for (ExtraCamera& camera : extraCameras_) {
+        for (UploadSlot& slot : camera.uploadSlots) {
+            DestroyUploadSlot(slot);
+        }
     }
     
-    for (auto& eyeTexture : eyeTextures_) {
-        if (eyeTexture.image != VK_NULL_HANDLE) {
-            vkDestroyImage(vkDevice_, eyeTexture.image, nullptr);
-            eyeTexture.image = VK_NULL_HANDLE;
-        }
-        if (eyeTexture.memory != VK_NULL_HANDLE) {
-            vkFreeMemory(vkDevice_, eyeTexture.memory, nullptr);
-            eyeTexture.memory = VK_NULL_HANDLE;
+    for (auto& frame : frameSlots_) {
+        if (frame.fence != VK_NULL_HANDLE) {
+            vkDestroyFence(vkDevice_, frame.fence, nullptr);
+            frame.fence = VK_NULL_HANDLE;
         }
+        frame.commandBuffer = VK_NULL_HANDLE;  // Freed with the command pool
+    }
+    
+    if (timestampQueryPool_ != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(vkDevice_, timestampQueryPool_, nullptr);
+        timestampQueryPool_ = VK_NULL_HANDLE;
     }
     
     if (commandPool_ != VK_NULL_HANDLE) {
@@ -1126,12 +2908,23 @@ void VRCameraApp::Shutdown() {
     }
     
     // Clean up OpenXR
-    for (auto& swapchain : swapchains_) {
-        if (swapchain.handle != XR_NULL_HANDLE) {
-            xrDestroySwapchain(swapchain.handle);
+    if (swapchain_.handle != XR_NULL_HANDLE) {
+        xrDestroySwapchain(swapchain_.handle);
+        swapchain_.handle = XR_NULL_HANDLE;
+        swapchain_.acquiredImage = -1;
+    }
+    for (ExtraCamera& camera : extraCameras_) {
+        if (camera.swapchain.handle != XR_NULL_HANDLE) {
+            xrDestroySwapchain(camera.swapchain.handle);
+            camera.swapchain.handle = XR_NULL_HANDLE;
         }
     }
     
+    if (headSpace_ != XR_NULL_HANDLE) {
+        xrDestroySpace(headSpace_);
+        headSpace_ = XR_NULL_HANDLE;
+    }
+    
     if (appSpace_ != XR_NULL_HANDLE) {
         xrDestroySpace(appSpace_);
         appSpace_ = XR_NULL_HANDLE;
@@ -1160,6 +2953,10 @@ void VRCameraApp::Shutdown() {
     // Shutdown camera
     if (camera_) {
         camera_->Shutdown();
+        camera_->StopRecording();
+    }
+    for (ExtraCamera& camera : extraCameras_) {
+        camera.capture->Shutdown();
     }
     
     LogMessage("=== Shutdown complete ===");
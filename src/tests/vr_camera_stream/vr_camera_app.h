@@ -1,7 +1,11 @@
 #pragma once
 
 #include "camera/camera_capture.h"
+#include "camera/stereo_calibration.h"
+#include "streaming/spectator_sink.h"
 #include "utils/timer.h"
+#include "utils/latency_stats.h"
+#include "utils/pose_history.h"
 
 // IMPORTANT: Include platform headers FIRST, then Vulkan, then OpenXR
 #include <X11/Xlib.h>
@@ -20,6 +24,8 @@
 #include <memory>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <thread>
 
 class VRCameraApp {
 public:
@@ -29,6 +35,15 @@ public:
     bool Initialize();
     void Run();
     void Shutdown();
+    
+    // How many rendered frames showed a camera frame for the first time, or again because the camera is slower than
+    // the display, and how many camera frames were never shown because a newer one came before the next frame
+    struct FrameCounters {
+        uint64_t fresh = 0;
+        uint64_t repeated = 0;
+        uint64_t dropped = 0;
+    };
+    const FrameCounters& GetFrameCounters() const { return frameCounters_; }
 
 private:
     // =============================================================================
@@ -38,9 +53,14 @@ private:
     XrSystemId systemId_ = XR_NULL_SYSTEM_ID;
     XrSession session_ = XR_NULL_HANDLE;
     XrSpace appSpace_ = XR_NULL_HANDLE;
+    XrSpace headSpace_ = XR_NULL_HANDLE;  // VIEW space, to locate the head at camera capture and display times
     XrSessionState sessionState_ = XR_SESSION_STATE_UNKNOWN;
     bool sessionRunning_ = false;
     
+    // XR_KHR_convert_timespec_time, to turn camera capture timestamps into XrTime; null if the runtime lacks it
+    PFN_xrConvertTimespecTimeToTimeKHR xrConvertTimespecTimeToTimeKHR_ = nullptr;
+    bool timespecConversionSupported_ = false;
+    
     // =============================================================================
     // Vulkan Objects (created via OpenXR)
     // =============================================================================
@@ -52,7 +72,19 @@ private:
     
     // Vulkan command objects
     VkCommandPool commandPool_ = VK_NULL_HANDLE;
-    VkCommandBuffer commandBuffer_ = VK_NULL_HANDLE;
+    
+    // Frames the GPU may still be rendering while the CPU records the next one.  The runtime's swapchains have at least
+    // as many images, and each frame's fence is waited for before its command buffer is recorded again.
+    static constexpr size_t kFramesInFlight = 2;
+    struct FrameSlot {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;  // Both eyes' rendering
+        VkFence fence = VK_NULL_HANDLE;                  // Signaled when the GPU is done with this frame
+        bool timestampsWritten = false;                  // The frame's render timestamp queries hold results not read yet
+        int spectatorBuffer = -1;                        // The spectator_ buffer the frame copies its view to, or -1
+        XrTime displayTime = 0;
+    };
+    std::array<FrameSlot, kFramesInFlight> frameSlots_;
+    size_t frameSlotIndex_ = 0;
     
     // =============================================================================
     // OpenXR View Configuration & Swapchains
@@ -66,16 +98,37 @@ private:
         int32_t width = 0;
         int32_t height = 0;
         std::vector<XrSwapchainImageVulkan2KHR> images;
+        int32_t acquiredImage = -1;  // Acquired ahead of the frame that renders to it, -1 if none
     };
-    std::vector<Swapchain> swapchains_;  // One per eye
+    Swapchain swapchain_;  // One layer per eye
+    
+    // With VR_CAMERA_NATIVE_SWAPCHAIN=1 the swapchain is the camera eye size instead of the recommended view size, and
+    // the layer views narrow their FOV to the part of the view the camera covered, so the image keeps its angular size
+    // and the compositor, not a full-size swapchain, scales it.  The scales are the layer's share of each view's FOV.
+    bool nativeSwapchain_ = false;
+    // With VR_CAMERA_QUAD_LAYER=1 the swapchain is also the camera eye size, and each eye's layer is shown on its own
+    // quad layer, placed where the head was at capture time.  The runtime then reprojects the camera image itself.
+    bool quadLayerMode_ = false;
+    float layerFovScaleX_ = 1.0f;
+    float layerFovScaleY_ = 1.0f;
     
     // =============================================================================
     // Camera System
     // =============================================================================
     std::unique_ptr<CameraCapture> camera_;
-    cv::Mat cameraFrame_;           // Full 1280x480 stereo frame
-    cv::Mat leftEyeFrame_;          // Left 640x480
-    cv::Mat rightEyeFrame_;         // Right 640x480
+    // The camera's modes, to pick a rate dividing the display rate once it is known, and to step the size down when
+    // decoding cannot keep up with the camera.  Sizes only change when the swapchain does not follow the camera size.
+    std::vector<CameraCapture::Mode> cameraModes_;
+    double displayRate_ = 0;            // From predictedDisplayPeriod, 0 until the first xrWaitFrame
+    bool cameraRateNegotiated_ = false;
+    int modeChangeCameraFrame_ = 0;     // frameCount_ when the camera mode last changed
+    cv::Mat cameraFrame_;           // Full BGR stereo frame, 3200x1200 unless stepped down, left eye in the left half
+    XrQuaternionf cameraOrientation_{0, 0, 0, 1};  // Head orientation when cameraFrame_ was captured
+    bool cameraOrientationValid_ = false;          // False if the capture time or pose is unknown
+    XrTime cameraTime_ = 0;                        // Capture time of cameraFrame_, 0 if unknown
+    uint64_t cameraSequence_ = 0;    // CameraCapture's sequence number of cameraFrame_, 0 before the first
+    uint64_t uploadedSequence_ = 0;  // Of the frame in the eye texture, or the newest staging buffer for direct uploads
+    FrameCounters frameCounters_;
     
     // =============================================================================
     // Vulkan Texture Resources for Camera Upload
@@ -86,22 +139,102 @@ private:
         VkImageView imageView = VK_NULL_HANDLE;
         VkSampler sampler = VK_NULL_HANDLE;
     };
-    std::array<EyeTexture, 2> eyeTextures_;  // Left and right eye textures
+    EyeTexture cameraTexture_;  // 2-layer array: layer 0 is the left eye, layer 1 the right eye
+    EyeTexture remapTexture_;   // With undistort_, calibration_'s RG16F remap offsets of each eye, in the same layers
+    uint32_t eyeWidth_ = 0;     // Half the camera frame width
+    uint32_t eyeHeight_ = 0;
+    VkFormat eyeTextureFormat_ = VK_FORMAT_B8G8R8A8_SRGB;
+    uint32_t eyeTextureBytesPerPixel_ = 4;
     
-    // Staging buffer for CPU→GPU uploads
-    VkBuffer stagingBuffer_ = VK_NULL_HANDLE;
-    VkDeviceMemory stagingBufferMemory_ = VK_NULL_HANDLE;
-    void* stagingBufferMapped_ = nullptr;
+    // Ring of staging buffers for CPU→GPU uploads, so a new frame is written while the GPU still copies the last one
+    struct UploadSlot {
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+        void* stagingMapped = nullptr;
+        VkDeviceSize rowPitch = 0;             // Of the frame rows at stagingMapped
+        VkImage mappedImage = VK_NULL_HANDLE;  // With mappedTexture_, the linear image stagingMemory backs, in place of
+                                               // stagingBuffer
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;  // Signaled when the GPU is done with this slot
+        bool timestampsWritten = false;  // The slot's upload timestamp queries hold results not read yet
+        VkFence readerFence = VK_NULL_HANDLE;  // With directUpload_, the fence of the last frame that copied from it
+    };
+    std::array<UploadSlot, kFramesInFlight> uploadSlots_;
+    size_t uploadSlotIndex_ = 0;
+    
+    // With VR_CAMERA_DIRECT_UPLOAD=1 and a camera-sized swapchain, each frame copies the newest staging buffer, laid
+    // out in the swapchain format, straight into its swapchain image: there is no eye texture and no upload submit.
+    bool directUpload_ = false;
+    VkFormat swapchainFormat_ = VK_FORMAT_UNDEFINED;
+    size_t latestUploadSlot_ = kFramesInFlight;  // The slot the newest frame was staged in, kFramesInFlight if none
+    
+    // With VR_CAMERA_MAPPED_TEXTURE=1, on a GPU with memory both device local and host visible (resizable BAR, or the
+    // unified memory of integrated GPUs), each upload slot is a linear image of the whole frame in that memory, written
+    // by the CPU and blitted from like the eye texture: there is no eye texture and no upload submit either.
+    bool mappedTexture_ = false;
+    
+    // =============================================================================
+    // Extra Cameras
+    // =============================================================================
+    // With VR_CAMERA_EXTRA_DEVICES set to a comma-separated list of up to kMaxExtraCameras devices, e.g. a wide-angle
+    // camera next to the stereo pair, each is captured by a CameraCapture of its own, whose thread also converts its
+    // frames to the swapchain format, and shown whole to both eyes on a quad layer of its own over the stereo camera.
+    // The render thread only copies a new frame into a staging buffer and records its copy to the camera's swapchain
+    // with the frame's commands, so each camera adds its capture, decode and conversion on its own thread.
+    static constexpr size_t kMaxExtraCameras = 3;
+    struct ExtraCamera {
+        std::unique_ptr<CameraCapture> capture;
+        cv::Mat frame;                  // The newest frame, in the swapchain format
+        uint64_t sequence = 0;          // Of frame, 0 before the first
+        uint64_t uploadedSequence = 0;  // Of the frame in the swapchain image released last
+        Swapchain swapchain;            // The camera size, one layer
+        std::array<UploadSlot, kFramesInFlight> uploadSlots;  // Only the staging buffers and reader fences
+        size_t uploadSlotIndex = 0;
+        bool acquired = false;  // A swapchain image is acquired for this frame's copy, to release after its submit
+        XrCompositionLayerQuad quad{XR_TYPE_COMPOSITION_LAYER_QUAD};
+    };
+    std::vector<ExtraCamera> extraCameras_;
+    
+    // =============================================================================
+    // Spectator Stream
+    // =============================================================================
+    // With VR_CAMERA_SPECTATOR=host:port, the middle of the left eye, at most kSpectatorMaxWidth x kSpectatorMaxHeight,
+    // is encoded to H.264 on a V4L2 encoder, VR_CAMERA_SPECTATOR_ENCODER or the first found, and streamed over RTP to
+    // host:port.  Each frame's commands copy it into a buffer the encoder imports as a DMA-BUF, so the CPU never reads
+    // the view back; the frame loop hands the buffer over once the frame's fence is signaled.
+    static constexpr uint32_t kSpectatorMaxWidth = 1920;
+    static constexpr uint32_t kSpectatorMaxHeight = 1080;
+    static constexpr int kSpectatorBitrate = 8000000;
+    std::string spectatorAddress_;  // Empty without a spectator, or when the device cannot export DMA-BUFs
+    SpectatorSink spectator_;
+    struct SpectatorBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        int fd = -1;  // The DMA-BUF of memory
+    };
+    std::array<SpectatorBuffer, SpectatorSink::kBufferCount> spectatorBuffers_;
+    uint32_t spectatorWidth_ = 0;
+    uint32_t spectatorHeight_ = 0;
+    PFN_vkGetMemoryFdKHR vkGetMemoryFdKHR_ = nullptr;
     
     // =============================================================================
     // Vulkan Rendering Pipeline
     // =============================================================================
+    // With VR_CAMERA_CALIBRATION set to a calibration file, each eye is drawn by a fragment shader that undistorts and
+    // rectifies it through remapTexture_, instead of blitted.  The remap is computed on the CPU once per camera size.
+    StereoCalibration calibration_;
+    bool undistort_ = false;
     VkRenderPass renderPass_ = VK_NULL_HANDLE;
     VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
     VkPipeline graphicsPipeline_ = VK_NULL_HANDLE;
     VkDescriptorSetLayout descriptorSetLayout_ = VK_NULL_HANDLE;
     VkDescriptorPool descriptorPool_ = VK_NULL_HANDLE;
-    std::array<VkDescriptorSet, 2> descriptorSets_;  // One per eye
+    VkDescriptorSet descriptorSet_ = VK_NULL_HANDLE;  // Both eyes' textures; the shader picks the eye's layer
+    struct LayerFramebuffer {
+        VkImageView imageView = VK_NULL_HANDLE;  // One layer of a swapchain image
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    };
+    std::vector<std::array<LayerFramebuffer, 2>> framebuffers_;  // Per swapchain image, one per eye
     
     // =============================================================================
     // Performance Monitoring
@@ -109,6 +242,33 @@ private:
     Timer frameTimer_;
     int frameCount_ = 0;
     
+    // The head pose of each rendered frame, for the low-priority telemetry thread, which logs the newest one as roll,
+    // pitch and yaw every kTelemetryPeriodMs.  The frame loop only pushes the pose it already located.
+    static constexpr int kTelemetryPeriodMs = 50;
+    PoseHistory poseHistory_;
+    std::thread telemetryThread_;
+    std::atomic<bool> telemetryRunning_{false};
+    
+    // Per-stage latency of each rendered frame, CPU timed or from GPU timestamps.  Set VR_CAMERA_LATENCY_CSV to a
+    // file path to also get a CSV row per frame.
+    LatencyStats latencyStats_;
+    
+    // The composition layers of a frame, kept so that each frame reuses the storage of the last.  Debug builds assert
+    // that, after kAllocationWarmupFrames, RenderFrame makes no heap allocations outside of the runtime, Vulkan and
+    // camera calls.
+    std::vector<XrCompositionLayerBaseHeader*> layers_;
+    XrCompositionLayerProjection projectionLayer_{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
+    std::vector<XrCompositionLayerProjectionView> projectionLayerViews_;
+    std::array<XrCompositionLayerQuad, 2> quadLayers_{};
+    static constexpr uint64_t kAllocationWarmupFrames = 60;
+    uint64_t renderedFrameCount_ = 0;
+    
+    // Timestamp queries: a begin/end pair per upload slot, then a pair per frame slot.  Null if unsupported.
+    VkQueryPool timestampQueryPool_ = VK_NULL_HANDLE;
+    double timestampPeriodNs_ = 0;  // Nanoseconds per timestamp tick
+    uint64_t timestampMask_ = 0;    // The timestampValidBits of the queue family
+    uint32_t GetRenderQueryIndex(size_t frameSlot) const { return static_cast<uint32_t>(kFramesInFlight + frameSlot) * 2; }
+    
     // =============================================================================
     // OpenXR Initialization Methods
     // =============================================================================
@@ -123,19 +283,49 @@ private:
     // Vulkan Resource Creation
     // =============================================================================
     bool CreateVulkanResources();
+    bool SelectEyeTextureFormat();
     bool CreateEyeTextures();
-    bool CreateStagingBuffer();
+    bool CreateStagingBuffer(UploadSlot& slot);
+    bool AllocateStagingBuffer(UploadSlot& slot, VkDeviceSize size);  // Host visible, mapped to slot.stagingMapped
+    bool CreateMappedTexture(UploadSlot& slot);
+    bool CreateUploadRing();
+    bool CreateFrameSlots();
+    bool CreateTextureView(EyeTexture& texture, VkFormat format);  // A 2-layer array view and a linear sampler
+    bool CreateRemapTexture();
     bool CreateRenderPipeline();
-    bool CreateDescriptorSets();
+    bool CreateDescriptorSets();  // Also updates the set when the textures are recreated
+    bool CreateTimestampQueries();
+    bool CreateSpectatorStream();  // False if there is no encoder or no exportable memory; the app goes on without it
+    void DestroySpectatorStream();
+    void InitializeExtraCameras();  // Those that fail are left out with a warning
+    bool CreateExtraCameraSwapchains();
+    bool CreateExtraCameraStaging();
+    void DestroyUploadSlot(UploadSlot& slot);
+    void DestroyCameraResources();  // The upload ring, eye texture and remap texture, which are sized by the camera
+    void DestroyRenderPipeline();
     
     // =============================================================================
     // Camera & Rendering Methods
     // =============================================================================
-    void UpdateCamera();
-    void UploadCameraTextures();
+    bool UpdateCamera();  // Returns true if a new camera frame arrived
+    // Switch to the best mode no bigger than maxWidth x maxHeight for displayRate_; false if the camera was lost
+    bool SelectCameraMode(int maxWidth, int maxHeight);
+    bool ReconfigureCamera(const CameraCapture::Mode& mode);
+    bool UploadCameraTextures();  // Returns false if cameraFrame_ was already uploaded, or does not fit the textures
     void RenderFrame();
     bool RenderEyeTextures(XrTime displayTime);
-    void RenderEye(int eyeIndex, const XrSwapchainImageVulkan2KHR& swapchainImage);
+    // Acquire the next image of swapchain_ unless one is still acquired, without waiting for it
+    bool AcquireEyeImage();
+    // Records into commandBuffer; reprojection rotates the head orientation at display time to the one at capture time
+    void RenderEye(VkCommandBuffer commandBuffer, int eyeIndex, uint32_t swapchainImageIndex,
+                   const XrQuaternionf& reprojection);
+    // Take the extra cameras' new frames, and record their copies into commandBuffer, which frameFence guards
+    void RecordExtraCameras(VkCommandBuffer commandBuffer, VkFence frameFence);
+    void ReleaseExtraCameras();  // Once the frame's commands are submitted
+    XrCompositionLayerQuad GetExtraCameraQuad(size_t index) const;
+    // Record the copy of the left eye of the swapchain image to a free spectator buffer, after the eyes are rendered
+    void RecordSpectatorCopy(VkCommandBuffer commandBuffer, uint32_t swapchainImageIndex, FrameSlot& frame);
+    void SubmitSpectatorFrames();  // Hand the buffers of the frames the GPU finished to spectator_
     
     // =============================================================================
     // Main Loop Methods
@@ -148,6 +338,7 @@ private:
     // =============================================================================
     VkCommandBuffer BeginSingleTimeCommands();
     void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
+    double ReadTimestampMilliseconds(uint32_t firstQuery);  // Between a query pair, or negative if not available
     
     // =============================================================================
     // Helper Methods
@@ -155,6 +346,15 @@ private:
     std::vector<const char*> GetRequiredExtensions();
     uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
     void LogMessage(const std::string& message);
-    void LogHeadsetRPY();  // Log Roll, Pitch, Yaw from headset
+    void TelemetryThread();
+    
+    // Real-time scheduling and CPU affinity of the capture threads and the frame loop, and memory locking, from the
+    // environment.  Each one logs whether it was applied.
+    void ApplyThreadPolicies();
+    
+    void LogHeadsetRPY(const XrPosef& headPose);  // Log Roll, Pitch, Yaw from headset
     void QuaternionToRPY(const XrQuaternionf& q, float& roll, float& pitch, float& yaw);
+    bool LocateHeadOrientation(XrTime time, XrQuaternionf& orientation);
+    XrFovf GetLayerFov(uint32_t eyeIndex) const;  // The FOV swapchain_ covers for the eye, narrowed by layerFovScale
+    XrCompositionLayerQuad GetEyeQuad(uint32_t eyeIndex) const;  // For quadLayerMode_, after xrLocateViews
 };
\ No newline at end of file
@@ -0,0 +1,183 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Benchmarks for the functions of xr_linear.h, each called on kXrLinearBenchCount elements, with the default SIMD
+// selection and, for the functions with SIMD versions, with XR_LINEAR_NO_SIMD.  The batched functions are benchmarked
+// next to the loops they replace.  Before benchmarking, every kernel is checked against its scalar build and its
+// reference kernel.  Use a Catch2 reporter for machine-readable results, e.g.
+//     xr_linear_bench -r JSON::out=xr_linear_bench.json
+
+#include "xr_linear_bench_kernels.hpp"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+
+XrLinearBenchData::XrLinearBenchData() {
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+    std::uniform_real_distribution<float> angle(0.6f, 0.9f);
+
+    auto random_rotation = [&] {
+        XrQuaternionf q{unit(generator), unit(generator), unit(generator), unit(generator)};
+        XrQuaternionf_Normalize(&q);
+        return q;
+    };
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        translations.push_back({unit(generator) * 2.0f, unit(generator) * 2.0f, unit(generator) * 2.0f});
+        rotations.push_back(random_rotation());
+        scales.push_back({scale(generator), scale(generator), scale(generator)});
+        vectors.push_back({unit(generator), unit(generator), unit(generator)});
+        vectors4.push_back({unit(generator), unit(generator), unit(generator), 1.0f});
+        poses.push_back({random_rotation(), {unit(generator), unit(generator), unit(generator)}});
+        fovs.push_back({-angle(generator), angle(generator), angle(generator), -angle(generator)});
+
+        XrMatrix4x4f matrix;
+        XrMatrix4x4f_CreateTranslationRotationScale(&matrix, &translations[i], &rotations[i], &scales[i]);
+        matrices.push_back(matrix);
+        XrMatrix4x4f_CreateFromRigidTransform(&matrix, &poses[i]);
+        rigidMatrices.push_back(matrix);
+    }
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        orientations.push_back(poses[i].orientation);
+        otherPoses.push_back({random_rotation(), {unit(generator), unit(generator), unit(generator)}});
+    }
+    XrMatrix4x4f_CreateViewProjectionFromPoseFov(&viewProjection, GRAPHICS_OPENGL, &poses[0], fovs[0], 0.05f, 100.0f);
+    ClearResults();
+}
+
+void XrLinearBenchData::ClearResults() {
+    floatResults.assign(kXrLinearBenchCount, 0.0f);
+    boolResults.assign(kXrLinearBenchCount, 0);
+    vectorResults.assign(kXrLinearBenchCount, XrVector3f{});
+    otherVectorResults.assign(kXrLinearBenchCount, XrVector3f{});
+    vector4Results.assign(kXrLinearBenchCount, XrVector4f{});
+    quaternionResults.assign(kXrLinearBenchCount, XrQuaternionf{});
+    poseResults.assign(kXrLinearBenchCount, XrPosef{});
+    matrixResults.assign(kXrLinearBenchCount, XrMatrix4x4f{});
+}
+
+namespace {
+
+// The results are compared with a relative tolerance, not exactly: the compiler may contract the scalar code into
+// fused multiply-adds, and the batched functions may round differently from the functions they replace.
+template <typename T>
+void CompareFloats(const std::vector<T>& a, const std::vector<T>& b, const char* buffer, std::string& mismatch) {
+    const size_t count = a.size() * sizeof(T) / sizeof(float);
+    std::vector<float> fa(count);
+    std::vector<float> fb(count);
+    memcpy(fa.data(), a.data(), count * sizeof(float));
+    memcpy(fb.data(), b.data(), count * sizeof(float));
+    for (size_t i = 0; i < count && mismatch.empty(); i++) {
+        const float tolerance = 1e-5f * std::max(1.0f, std::max(std::fabs(fa[i]), std::fabs(fb[i])));
+        if (!(std::fabs(fa[i] - fb[i]) <= tolerance)) {
+            std::ostringstream oss;
+            oss << buffer << " float " << i << ": " << fa[i] << " vs " << fb[i];
+            mismatch = oss.str();
+        }
+    }
+}
+
+// A description of the first difference between the results, or an empty string.
+std::string FirstMismatch(const XrLinearBenchData& a, const XrLinearBenchData& b) {
+    std::string mismatch;
+    CompareFloats(a.floatResults, b.floatResults, "floatResults", mismatch);
+    CompareFloats(a.vectorResults, b.vectorResults, "vectorResults", mismatch);
+    CompareFloats(a.otherVectorResults, b.otherVectorResults, "otherVectorResults", mismatch);
+    CompareFloats(a.vector4Results, b.vector4Results, "vector4Results", mismatch);
+    CompareFloats(a.quaternionResults, b.quaternionResults, "quaternionResults", mismatch);
+    CompareFloats(a.poseResults, b.poseResults, "poseResults", mismatch);
+    CompareFloats(a.matrixResults, b.matrixResults, "matrixResults", mismatch);
+    if (mismatch.empty() && a.boolResults != b.boolResults) {
+        mismatch = "boolResults";
+    }
+    return mismatch;
+}
+
+const XrLinearBenchKernel* FindKernel(const std::vector<XrLinearBenchKernel>& kernels, const char* name) {
+    for (const XrLinearBenchKernel& kernel : kernels) {
+        if (strcmp(kernel.name, name) == 0) {
+            return &kernel;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+TEST_CASE("Cross-check against the scalar build", "[check]") {
+    const std::vector<XrLinearBenchKernel>& kernels = XrLinearBenchKernels();
+    const std::vector<XrLinearBenchKernel>& scalar_kernels = XrLinearBenchScalarKernels();
+    REQUIRE(kernels.size() == scalar_kernels.size());
+
+    XrLinearBenchData data;
+    XrLinearBenchData scalar_data;
+    for (size_t i = 0; i < kernels.size(); i++) {
+        INFO(kernels[i].name);
+        REQUIRE(strcmp(kernels[i].name, scalar_kernels[i].name) == 0);
+        data.ClearResults();
+        kernels[i].run(data);
+        scalar_data.ClearResults();
+        scalar_kernels[i].run(scalar_data);
+        CHECK(FirstMismatch(data, scalar_data) == "");
+    }
+}
+
+TEST_CASE("Cross-check against the reference kernels", "[check]") {
+    const std::vector<XrLinearBenchKernel>& kernels = XrLinearBenchKernels();
+
+    XrLinearBenchData data;
+    XrLinearBenchData reference_data;
+    for (const XrLinearBenchKernel& kernel : kernels) {
+        if (kernel.reference == nullptr) {
+            continue;
+        }
+        INFO(kernel.name << " vs " << kernel.reference);
+        const XrLinearBenchKernel* reference = FindKernel(kernels, kernel.reference);
+        REQUIRE(reference != nullptr);
+        data.ClearResults();
+        kernel.run(data);
+        reference_data.ClearResults();
+        reference->run(reference_data);
+        CHECK(FirstMismatch(data, reference_data) == "");
+    }
+}
+
+TEST_CASE("xr_linear.h", "[bench]") {
+    XrLinearBenchData data;
+    const std::vector<XrLinearBenchKernel>& scalar_kernels = XrLinearBenchScalarKernels();
+    for (const XrLinearBenchKernel& kernel : XrLinearBenchKernels()) {
+        BENCHMARK(kernel.name) {
+            kernel.run(data);
+            return data.matrixResults[0].m[0];
+        };
+        if (kernel.simd) {
+            const XrLinearBenchKernel* scalar_kernel = FindKernel(scalar_kernels, kernel.name);
+            BENCHMARK(std::string(kernel.name) + "/scalar") {
+                scalar_kernel->run(data);
+                return data.matrixResults[0].m[0];
+            };
+        }
+    }
+}
@@ -0,0 +1,383 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Built twice: once as is, and once with XR_LINEAR_NO_SIMD for the scalar reference.  The functions of xr_linear.h
+// are static, so each build gets its own copy.
+
+#include "xr_linear_bench_kernels.hpp"
+
+namespace {
+
+const float kEpsilon = 1e-4f;
+const float kNearZ = 0.05f;
+const float kFarZ = 100.0f;
+
+void Vector3fAdd(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrVector3f_Add(&d.vectorResults[i], &d.vectors[i], &d.translations[i]);
+    }
+}
+
+void Vector3fLerp(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrVector3f_Lerp(&d.vectorResults[i], &d.vectors[i], &d.translations[i], 0.25f);
+    }
+}
+
+void Vector3fCross(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrVector3f_Cross(&d.vectorResults[i], &d.vectors[i], &d.translations[i]);
+    }
+}
+
+void Vector3fNormalize(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        d.vectorResults[i] = d.vectors[i];
+        XrVector3f_Normalize(&d.vectorResults[i]);
+    }
+}
+
+void Vector3fNormalizeFast(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        d.vectorResults[i] = d.vectors[i];
+        XrVector3f_NormalizeFast(&d.vectorResults[i]);
+    }
+}
+
+void Vector3fLength(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        d.floatResults[i] = XrVector3f_Length(&d.vectors[i]);
+    }
+}
+
+void QuaternionfCreateFromAxisAngle(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrQuaternionf_CreateFromAxisAngle(&d.quaternionResults[i], &d.vectors[i], d.translations[i].x);
+    }
+}
+
+void QuaternionfLerp(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrQuaternionf_Lerp(&d.quaternionResults[i], &d.rotations[i], &d.poses[i].orientation, 0.25f);
+    }
+}
+
+void QuaternionfLerpFast(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrQuaternionf_LerpFast(&d.quaternionResults[i], &d.rotations[i], &d.poses[i].orientation, 0.25f);
+    }
+}
+
+void QuaternionfLerpArray(XrLinearBenchData& d) {
+    XrQuaternionf_LerpArray(d.quaternionResults.data(), d.rotations.data(), d.orientations.data(), 0.25f, kXrLinearBenchCount);
+}
+
+void QuaternionfMultiply(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrQuaternionf_Multiply(&d.quaternionResults[i], &d.rotations[i], &d.poses[i].orientation);
+    }
+}
+
+void QuaternionfInvert(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrQuaternionf_Invert(&d.quaternionResults[i], &d.rotations[i]);
+    }
+}
+
+void QuaternionfNormalize(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        d.quaternionResults[i] = d.rotations[i];
+        XrQuaternionf_Normalize(&d.quaternionResults[i]);
+    }
+}
+
+void QuaternionfNormalizeFast(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        d.quaternionResults[i] = d.rotations[i];
+        XrQuaternionf_NormalizeFast(&d.quaternionResults[i]);
+    }
+}
+
+void QuaternionfNormalizeArray(XrLinearBenchData& d) {
+    XrQuaternionf_NormalizeArray(d.quaternionResults.data(), d.rotations.data(), kXrLinearBenchCount);
+}
+
+void QuaternionfRotateVector3f(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrQuaternionf_RotateVector3f(&d.vectorResults[i], &d.rotations[i], &d.vectors[i]);
+    }
+}
+
+void PosefTransformVector3f(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrPosef_TransformVector3f(&d.vectorResults[i], &d.poses[0], &d.vectors[i]);
+    }
+}
+
+void PosefTransformVector3fArray(XrLinearBenchData& d) {
+    XrPosef_TransformVector3fArray(d.vectorResults.data(), &d.poses[0], d.vectors.data(), kXrLinearBenchCount);
+}
+
+void PosefMultiply(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrPosef_Multiply(&d.poseResults[i], &d.poses[0], &d.poses[i]);
+    }
+}
+
+void PosefMultiplyComponents(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        const XrPosef pose{d.rotations[i], d.translations[i]};
+        XrPosef_Multiply(&d.poseResults[i], &d.poses[0], &pose);
+    }
+}
+
+void PosefMultiplyArray(XrLinearBenchData& d) {
+    XrPosef_MultiplyArray(d.poseResults.data(), &d.poses[0], d.rotations.data(), d.translations.data(), kXrLinearBenchCount);
+}
+
+void PosefInvert(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrPosef_Invert(&d.poseResults[i], &d.poses[i]);
+    }
+}
+
+// What XrPosef_LerpArray replaces.
+void PosefLerp(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrVector3f_Lerp(&d.poseResults[i].position, &d.poses[i].position, &d.otherPoses[i].position, 0.25f);
+        XrQuaternionf_Lerp(&d.poseResults[i].orientation, &d.poses[i].orientation, &d.otherPoses[i].orientation, 0.25f);
+    }
+}
+
+void PosefLerpArray(XrLinearBenchData& d) {
+    XrPosef_LerpArray(d.poseResults.data(), d.poses.data(), d.otherPoses.data(), 0.25f, kXrLinearBenchCount);
+}
+
+void Matrix4x4fCreateTranslation(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_CreateTranslation(&d.matrixResults[i], d.translations[i].x, d.translations[i].y, d.translations[i].z);
+    }
+}
+
+void Matrix4x4fCreateRotation(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_CreateRotation(&d.matrixResults[i], d.vectors[i].x * 90.0f, d.vectors[i].y * 90.0f, d.vectors[i].z * 90.0f);
+    }
+}
+
+void Matrix4x4fCreateScale(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_CreateScale(&d.matrixResults[i], d.scales[i].x, d.scales[i].y, d.scales[i].z);
+    }
+}
+
+void Matrix4x4fCreateTranslationRotationScale(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_CreateTranslationRotationScale(&d.matrixResults[i], &d.translations[i], &d.rotations[i], &d.scales[i]);
+    }
+}
+
+void Matrix4x4fCreateTranslationRotationScaleArray(XrLinearBenchData& d) {
+    XrMatrix4x4f_CreateTranslationRotationScaleArray(d.matrixResults.data(), d.translations.data(), d.rotations.data(),
+                                                     d.scales.data(), kXrLinearBenchCount);
+}
+
+void Matrix4x4fCreateFromRigidTransform(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_CreateFromRigidTransform(&d.matrixResults[i], &d.poses[i]);
+    }
+}
+
+void Matrix4x4fCreateProjectionFov(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_CreateProjectionFov(&d.matrixResults[i], GRAPHICS_OPENGL, d.fovs[i], kNearZ, kFarZ);
+    }
+}
+
+void Matrix4x4fCreateViewProjectionFromPoseFov(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_CreateViewProjectionFromPoseFov(&d.matrixResults[i], GRAPHICS_OPENGL, &d.poses[i], d.fovs[i], kNearZ, kFarZ);
+    }
+}
+
+// What XrMatrix4x4f_CreateViewProjectionFromPoseFov replaces.
+void Matrix4x4fViewProjection(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f projection;
+        XrMatrix4x4f_CreateProjectionFov(&projection, GRAPHICS_OPENGL, d.fovs[i], kNearZ, kFarZ);
+        XrMatrix4x4f toView;
+        XrMatrix4x4f_CreateFromRigidTransform(&toView, &d.poses[i]);
+        XrMatrix4x4f view;
+        XrMatrix4x4f_InvertRigidBody(&view, &toView);
+        XrMatrix4x4f_Multiply(&d.matrixResults[i], &projection, &view);
+    }
+}
+
+void Matrix4x4fCreateFromQuaternion(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_CreateFromQuaternion(&d.matrixResults[i], &d.rotations[i]);
+    }
+}
+
+void Matrix4x4fCreateOffsetScaleForBounds(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_CreateOffsetScaleForBounds(&d.matrixResults[i], &d.matrices[i], &d.vectors[i], &d.translations[i]);
+    }
+}
+
+void Matrix4x4fIsRigidBody(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        d.boolResults[i] = XrMatrix4x4f_IsRigidBody(i % 2 == 0 ? &d.rigidMatrices[i] : &d.matrices[i], kEpsilon) ? 1 : 0;
+    }
+}
+
+void Matrix4x4fGetTranslation(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_GetTranslation(&d.vectorResults[i], &d.rigidMatrices[i]);
+    }
+}
+
+void Matrix4x4fGetRotation(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_GetRotation(&d.quaternionResults[i], &d.rigidMatrices[i]);
+    }
+}
+
+void Matrix4x4fGetScale(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_GetScale(&d.vectorResults[i], &d.rigidMatrices[i]);
+    }
+}
+
+void Matrix4x4fMultiply(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_Multiply(&d.matrixResults[i], &d.viewProjection, &d.matrices[i]);
+    }
+}
+
+void Matrix4x4fMultiplyArray(XrLinearBenchData& d) {
+    XrMatrix4x4f_MultiplyArray(d.matrixResults.data(), &d.viewProjection, d.matrices.data(), kXrLinearBenchCount);
+}
+
+void Matrix4x4fTranspose(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_Transpose(&d.matrixResults[i], &d.matrices[i]);
+    }
+}
+
+void Matrix4x4fInvert(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_Invert(&d.matrixResults[i], &d.matrices[i]);
+    }
+}
+
+void Matrix4x4fInvertRigidBody(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_InvertRigidBody(&d.matrixResults[i], &d.rigidMatrices[i]);
+    }
+}
+
+void Matrix4x4fTransformVector3f(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_TransformVector3f(&d.vectorResults[i], &d.matrices[i], &d.vectors[i]);
+    }
+}
+
+void Matrix4x4fTransformVector4f(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_TransformVector4f(&d.vector4Results[i], &d.matrices[i], &d.vectors4[i]);
+    }
+}
+
+void Matrix4x4fTransformBounds(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        XrMatrix4x4f_TransformBounds(&d.vectorResults[i], &d.otherVectorResults[i], &d.matrices[i], &d.vectors[i],
+                                     &d.translations[i]);
+    }
+}
+
+void Matrix4x4fCullBounds(XrLinearBenchData& d) {
+    for (uint32_t i = 0; i < kXrLinearBenchCount; i++) {
+        d.boolResults[i] = XrMatrix4x4f_CullBounds(&d.viewProjection, &d.vectors[i], &d.translations[i]) ? 1 : 0;
+    }
+}
+
+std::vector<XrLinearBenchKernel> CreateKernels() {
+    return {
+        {"XrVector3f_Add", Vector3fAdd, false, nullptr},
+        {"XrVector3f_Lerp", Vector3fLerp, false, nullptr},
+        {"XrVector3f_Cross", Vector3fCross, false, nullptr},
+        {"XrVector3f_Normalize", Vector3fNormalize, false, nullptr},
+        {"XrVector3f_NormalizeFast", Vector3fNormalizeFast, true, "XrVector3f_Normalize"},
+        {"XrVector3f_Length", Vector3fLength, false, nullptr},
+        {"XrQuaternionf_CreateFromAxisAngle", QuaternionfCreateFromAxisAngle, false, nullptr},
+        {"XrQuaternionf_Lerp", QuaternionfLerp, false, nullptr},
+        {"XrQuaternionf_LerpFast", QuaternionfLerpFast, true, "XrQuaternionf_Lerp"},
+        {"XrQuaternionf_LerpArray", QuaternionfLerpArray, true, "XrQuaternionf_Lerp"},
+        {"XrQuaternionf_Multiply", QuaternionfMultiply, true, nullptr},
+        {"XrQuaternionf_Invert", QuaternionfInvert, false, nullptr},
+        {"XrQuaternionf_Normalize", QuaternionfNormalize, false, nullptr},
+        {"XrQuaternionf_NormalizeFast", QuaternionfNormalizeFast, true, "XrQuaternionf_Normalize"},
+        {"XrQuaternionf_NormalizeArray", QuaternionfNormalizeArray, true, "XrQuaternionf_Normalize"},
+        {"XrQuaternionf_RotateVector3f", QuaternionfRotateVector3f, false, nullptr},
+        {"XrPosef_TransformVector3f", PosefTransformVector3f, false, nullptr},
+        {"XrPosef_TransformVector3fArray", PosefTransformVector3fArray, false, "XrPosef_TransformVector3f"},
+        {"XrPosef_Multiply", PosefMultiply, true, nullptr},
+        {"XrPosef_Multiply(orientation, position)", PosefMultiplyComponents, true, nullptr},
+        {"XrPosef_MultiplyArray", PosefMultiplyArray, true, "XrPosef_Multiply(orientation, position)"},
+        {"XrPosef_Invert", PosefInvert, false, nullptr},
+        {"XrPosef_Lerp(position, orientation)", PosefLerp, false, nullptr},
+        {"XrPosef_LerpArray", PosefLerpArray, true, "XrPosef_Lerp(position, orientation)"},
+        {"XrMatrix4x4f_CreateTranslation", Matrix4x4fCreateTranslation, false, nullptr},
+        {"XrMatrix4x4f_CreateRotation", Matrix4x4fCreateRotation, true, nullptr},
+        {"XrMatrix4x4f_CreateScale", Matrix4x4fCreateScale, false, nullptr},
+        {"XrMatrix4x4f_CreateTranslationRotationScale", Matrix4x4fCreateTranslationRotationScale, true, nullptr},
+        {"XrMatrix4x4f_CreateTranslationRotationScaleArray", Matrix4x4fCreateTranslationRotationScaleArray, false,
+         "XrMatrix4x4f_CreateTranslationRotationScale"},
+        {"XrMatrix4x4f_CreateFromRigidTransform", Matrix4x4fCreateFromRigidTransform, true, nullptr},
+        {"XrMatrix4x4f_CreateProjectionFov", Matrix4x4fCreateProjectionFov, false, nullptr},
+        {"XrMatrix4x4f_CreateViewProjectionFromPoseFov", Matrix4x4fCreateViewProjectionFromPoseFov, false,
+         "XrMatrix4x4f_Multiply(projection, inverted pose)"},
+        {"XrMatrix4x4f_Multiply(projection, inverted pose)", Matrix4x4fViewProjection, true, nullptr},
+        {"XrMatrix4x4f_CreateFromQuaternion", Matrix4x4fCreateFromQuaternion, false, nullptr},
+        {"XrMatrix4x4f_CreateOffsetScaleForBounds", Matrix4x4fCreateOffsetScaleForBounds, false, nullptr},
+        {"XrMatrix4x4f_IsRigidBody", Matrix4x4fIsRigidBody, false, nullptr},
+        {"XrMatrix4x4f_GetTranslation", Matrix4x4fGetTranslation, false, nullptr},
+        {"XrMatrix4x4f_GetRotation", Matrix4x4fGetRotation, false, nullptr},
+        {"XrMatrix4x4f_GetScale", Matrix4x4fGetScale, false, nullptr},
+        {"XrMatrix4x4f_Multiply", Matrix4x4fMultiply, true, nullptr},
+        {"XrMatrix4x4f_MultiplyArray", Matrix4x4fMultiplyArray, true, "XrMatrix4x4f_Multiply"},
+        {"XrMatrix4x4f_Transpose", Matrix4x4fTranspose, false, nullptr},
+        {"XrMatrix4x4f_Invert", Matrix4x4fInvert, false, nullptr},
+        {"XrMatrix4x4f_InvertRigidBody", Matrix4x4fInvertRigidBody, false, nullptr},
+        {"XrMatrix4x4f_TransformVector3f", Matrix4x4fTransformVector3f, false, nullptr},
+        {"XrMatrix4x4f_TransformVector4f", Matrix4x4fTransformVector4f, true, nullptr},
+        {"XrMatrix4x4f_TransformBounds", Matrix4x4fTransformBounds, false, nullptr},
+        {"XrMatrix4x4f_CullBounds", Matrix4x4fCullBounds, true, nullptr},
+    };
+}
+
+}  // namespace
+
+#if defined(XR_LINEAR_NO_SIMD)
+const std::vector<XrLinearBenchKernel>& XrLinearBenchScalarKernels() {
+#else
+const std::vector<XrLinearBenchKernel>& XrLinearBenchKernels() {
+#endif
+    static const std::vector<XrLinearBenchKernel> kernels = CreateKernels();
+    return kernels;
+}
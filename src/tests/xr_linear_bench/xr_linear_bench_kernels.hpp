@@ -0,0 +1,71 @@
+// Copyright (c) 2017-2025 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include "xr_linear.h"
+
+#include <cstdint>
+#include <vector>
+
+// Each kernel calls one xr_linear.h function on every element of these arrays.
+const uint32_t kXrLinearBenchCount = 256;
+
+struct XrLinearBenchData {
+    XrLinearBenchData();
+
+    // Inputs.  The matrices are translation-rotation-scale matrices and the rigid matrices come from the poses.
+    std::vector<XrVector3f> translations;
+    std::vector<XrQuaternionf> rotations;
+    std::vector<XrVector3f> scales;
+    std::vector<XrVector3f> vectors;
+    std::vector<XrVector4f> vectors4;
+    std::vector<XrPosef> poses;
+    // The orientations of the poses on their own, and other poses to interpolate the poses towards.
+    std::vector<XrQuaternionf> orientations;
+    std::vector<XrPosef> otherPoses;
+    std::vector<XrMatrix4x4f> matrices;
+    std::vector<XrMatrix4x4f> rigidMatrices;
+    std::vector<XrFovf> fovs;
+    XrMatrix4x4f viewProjection;
+
+    // Outputs, cleared before each cross-check.
+    std::vector<float> floatResults;
+    std::vector<int> boolResults;
+    std::vector<XrVector3f> vectorResults;
+    std::vector<XrVector3f> otherVectorResults;
+    std::vector<XrVector4f> vector4Results;
+    std::vector<XrQuaternionf> quaternionResults;
+    std::vector<XrPosef> poseResults;
+    std::vector<XrMatrix4x4f> matrixResults;
+
+    void ClearResults();
+};
+
+struct XrLinearBenchKernel {
+    const char* name;
+    void (*run)(XrLinearBenchData& data);
+    // Whether the function, or one it calls, has SSE2 and NEON versions.
+    bool simd;
+    // A kernel that computes the same results another way, e.g. one element at a time instead of batched, or nullptr.
+    const char* reference;
+};
+
+// The kernels built with the default SIMD selection, and the same kernels built with XR_LINEAR_NO_SIMD, in the same
+// order.
+const std::vector<XrLinearBenchKernel>& XrLinearBenchKernels();
+const std::vector<XrLinearBenchKernel>& XrLinearBenchScalarKernels();